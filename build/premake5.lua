@@ -152,3 +152,65 @@ project "Corona"
       defines { "NDEBUG" }
       optimize "On"
 
+
+
+-- tests and benchmarks of the platform independent modules, tests/CMakeLists.txt builds the same on linux.
+PORTABLE_SOURCES = {
+      "../src/AsyncCompute.cpp",
+      "../src/BatchMath.cpp",
+      "../src/Benchmark.cpp",
+      "../src/BindlessMaterials.cpp",
+      "../src/BloomCPU.cpp",
+      "../src/BlueNoise.cpp",
+      "../src/DDGICascades.cpp",
+      "../src/DrawQueue.cpp",
+      "../src/FramePacing.cpp",
+      "../src/FrameTiming.cpp",
+      "../src/GIDenoiserCPU.cpp",
+      "../src/GPUDrivenScene.cpp",
+      "../src/HistogramCPU.cpp",
+      "../src/InstanceStore.cpp",
+      "../src/MaterialLibrary.cpp",
+      "../src/PipelineCache.cpp",
+      "../src/ProbePlacementCPU.cpp",
+      "../src/ProbeScheduler.cpp",
+      "../src/Profiler.cpp",
+      "../src/RayBudget.cpp",
+      "../src/RootSignatureLayout.cpp",
+      "../src/SceneCulling.cpp",
+      "../src/TemporalAACPU.cpp",
+      "../src/TextureStreaming.cpp",
+      "../src/external/enkiTS/*.cpp",
+   }
+
+function portable_project(name, testFiles)
+   filter {}
+   project(name)
+   kind "ConsoleApp"
+   language "C++"
+   cppdialect "C++17"
+   includedirs { "../src/external", "../src/" }
+   files(PORTABLE_SOURCES)
+   files { "../tests/TestFramework.h", "../tests/TestMain.cpp" }
+   files(testFiles)
+   defines { "CORONA_TEST_DATA_DIR=\"../src\"", "CORONA_TEST_GOLDEN_DIR=\"../tests/golden\"" }
+   systemversion(WIN_SDK_VERSION)
+   staticruntime("off")
+   flags { "NoPCH" }
+   debugdir("../build/")
+   targetdir "../build/bin/%{cfg.buildcfg}"
+
+   filter "configurations:Debug"
+      defines { "DEBUG" }
+      symbols "On"
+
+   filter "configurations:Release"
+      defines { "NDEBUG" }
+      optimize "On"
+
+   filter {}
+end
+
+-- no zlib here, the tests on the deflated fbx scenes skip.
+portable_project("CoronaTests", { "../tests/*Tests.cpp", "../tests/TestScenes.*" })
+portable_project("CoronaBenchmarks", { "../tests/*Bench.cpp" })
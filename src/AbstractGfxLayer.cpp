@@ -116,6 +116,48 @@ GfxTexture* AbstractGfxLayer::CreateTextureFromFile(std::wstring fileName, bool
 	return nullptr;
 }
 
+GfxTexture* AbstractGfxLayer::CreateStreamingTexture(std::wstring fileName, bool nonSRGB, GfxTexture* placeholder, UINT& width, UINT& height, std::vector<UINT64>& mipBytes)
+{
+	if (g_dx12_rhi)
+	{
+		Texture* texture = g_dx12_rhi->CreateStreamingTexture(fileName, nonSRGB, static_cast<Texture*>(placeholder), width, height, mipBytes);
+
+		return texture;
+	}
+
+	return nullptr;
+}
+
+GfxTextureMipData* AbstractGfxLayer::LoadStreamingTextureMips(GfxTexture* texture, UINT FirstMip)
+{
+	if (g_dx12_rhi)
+	{
+		return g_dx12_rhi->LoadStreamingTextureMips(static_cast<Texture*>(texture), FirstMip);
+	}
+
+	return nullptr;
+}
+
+bool AbstractGfxLayer::UpdateStreamingTexture(GfxTexture* texture, GfxTextureMipData* data, UINT FirstMip)
+{
+	if (g_dx12_rhi)
+	{
+		return g_dx12_rhi->UpdateStreamingTexture(static_cast<Texture*>(texture), data, FirstMip);
+	}
+
+	return false;
+}
+
+bool AbstractGfxLayer::TrimStreamingTexture(GfxTexture* texture, UINT FirstMip)
+{
+	if (g_dx12_rhi)
+	{
+		return g_dx12_rhi->TrimStreamingTexture(static_cast<Texture*>(texture), FirstMip);
+	}
+
+	return false;
+}
+
 GfxTexture* AbstractGfxLayer::CreateTexture2D(FORMAT format, RESOURCE_FLAGS resFlags, RESOURCE_STATES initResState, int width, int height, int mipLevels, std::optional<glm::vec4> clearColor)
 {
 	if (g_dx12_rhi)
@@ -162,6 +204,16 @@ GfxVertexBuffer* AbstractGfxLayer::CreateVertexBuffer(UINT Size, UINT Stride, vo
 		VertexBuffer* VB = g_dx12_rhi->CreateVertexBuffer(Size, Stride, SrcData);
 		return VB;
 	}
+	else if (g_vulkanImpl)
+	{
+		// host visible and left mapped, Create points pData at the mapping.
+		VKVertexBuffer* VB = new VKVertexBuffer;
+		VertexBufferInfo info = { Size, nullptr };
+		VB->Create(&info);
+		if (SrcData)
+			memcpy(info.pData, SrcData, Size);
+		return VB;
+	}
 
 	return nullptr;
 }
@@ -196,6 +248,16 @@ GfxBuffer* AbstractGfxLayer::CreateByteAddressBuffer(UINT InNumElements, UINT In
 	return nullptr;
 }
 
+GfxBuffer* AbstractGfxLayer::CreateReadbackBuffer(UINT Size)
+{
+	if (g_dx12_rhi)
+	{
+		return g_dx12_rhi->CreateBuffer(Size, 1, D3D12_HEAP_TYPE_READBACK, D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_FLAG_NONE);
+	}
+
+	return nullptr;
+}
+
 GfxRTAS* AbstractGfxLayer::CreateBLAS(GfxMesh* mesh)
 {
 	if (g_dx12_rhi)
@@ -225,6 +287,97 @@ void AbstractGfxLayer::UnmapBuffer(GfxBuffer* buffer)
 	}
 }
 
+void AbstractGfxLayer::CopyBuffer(GfxCommandList* CL, GfxBuffer* Dst, GfxBuffer* Src)
+{
+	if (g_dx12_rhi)
+	{
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		Buffer* dx12Dst = static_cast<Buffer*>(Dst);
+		Buffer* dx12Src = static_cast<Buffer*>(Src);
+
+		dx12CL->CmdList->CopyBufferRegion(dx12Dst->resource.Get(), 0, dx12Src->resource.Get(), 0, dx12Src->NumElements * dx12Src->ElementSize);
+	}
+}
+
+void AbstractGfxLayer::CopyBufferRegion(GfxCommandList* CL, GfxBuffer* Dst, UINT64 DstOffset, GfxBuffer* Src, UINT64 SrcOffset, UINT64 Size)
+{
+	if (g_dx12_rhi)
+	{
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		Buffer* dx12Dst = static_cast<Buffer*>(Dst);
+		Buffer* dx12Src = static_cast<Buffer*>(Src);
+
+		dx12CL->CmdList->CopyBufferRegion(dx12Dst->resource.Get(), DstOffset, dx12Src->resource.Get(), SrcOffset, Size);
+	}
+}
+
+GfxCommandSignature* AbstractGfxLayer::CreateDrawIndexedCommandSignature(GfxPipelineStateObject* PSO, std::string rootConstantName)
+{
+	if (g_dx12_rhi)
+	{
+		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
+
+		D3D12_INDIRECT_ARGUMENT_DESC Args[2] = {};
+		Args[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+		Args[0].Constant.RootParameterIndex = dx12PSO->rootBinding[rootConstantName].rootParamIndex;
+		Args[0].Constant.DestOffsetIn32BitValues = 0;
+		Args[0].Constant.Num32BitValuesToSet = 1;
+		Args[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+		CommandSignature* Signature = new CommandSignature;
+		Signature->Stride = sizeof(UINT) + sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+
+		D3D12_COMMAND_SIGNATURE_DESC Desc = {};
+		Desc.ByteStride = Signature->Stride;
+		Desc.NumArgumentDescs = _countof(Args);
+		Desc.pArgumentDescs = Args;
+
+		HRESULT hr = g_dx12_rhi->Device->CreateCommandSignature(&Desc, dx12PSO->RS.Get(), IID_PPV_ARGS(&Signature->Signature));
+		if (FAILED(hr))
+		{
+			delete Signature;
+			return nullptr;
+		}
+		return Signature;
+	}
+
+	return nullptr;
+}
+
+void AbstractGfxLayer::ExecuteIndirect(GfxCommandList* CL, GfxCommandSignature* Signature, UINT MaxCommandCount, GfxBuffer* ArgumentBuffer, GfxBuffer* CountBuffer)
+{
+	if (g_dx12_rhi)
+	{
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		CommandSignature* dx12Signature = static_cast<CommandSignature*>(Signature);
+		Buffer* dx12Args = static_cast<Buffer*>(ArgumentBuffer);
+		Buffer* dx12Count = static_cast<Buffer*>(CountBuffer);
+
+		dx12CL->CmdList->ExecuteIndirect(dx12Signature->Signature.Get(), MaxCommandCount, dx12Args->resource.Get(), 0,
+			dx12Count ? dx12Count->resource.Get() : nullptr, 0);
+	}
+}
+
+GfxTextureTable* AbstractGfxLayer::CreateTextureTable(UINT NumDescriptors)
+{
+	if (g_dx12_rhi)
+	{
+		return g_dx12_rhi->CreateTextureTable(NumDescriptors);
+	}
+
+	return nullptr;
+}
+
+void AbstractGfxLayer::SetTextureTableEntry(GfxTextureTable* Table, UINT Index, GfxTexture* texture)
+{
+	if (g_dx12_rhi)
+	{
+		TextureTable* dx12Table = static_cast<TextureTable*>(Table);
+		assert(Index < dx12Table->NumDescriptors);
+		dx12Table->Textures[Index] = static_cast<Texture*>(texture);
+	}
+}
+
 
 GfxRTAS* AbstractGfxLayer::CreateTLAS(std::vector<std::shared_ptr<GfxRTAS>>& VecBLAS)
 {
@@ -241,6 +394,21 @@ GfxRTAS* AbstractGfxLayer::CreateTLAS(std::vector<std::shared_ptr<GfxRTAS>>& Vec
 	}
 }
 
+GfxRTAS* AbstractGfxLayer::CreateTLAS(std::vector<std::shared_ptr<GfxRTAS>>& VecBLAS, const std::vector<GfxRTInstance>& Instances)
+{
+	if (g_dx12_rhi)
+	{
+		std::vector <RTAS*> vecBLAS;
+		for (auto& blas : VecBLAS)
+		{
+			RTAS* dx12BLAS = static_cast<RTAS*>(blas.get());
+			vecBLAS.push_back(dx12BLAS);
+		}
+		RTAS* as = g_dx12_rhi->CreateTLAS(vecBLAS, Instances);
+		return as;
+	}
+}
+
 
 void AbstractGfxLayer::SetReadTexture(GfxPipelineStateObject* PSO, std::string name, GfxTexture* texture, GfxCommandList* CL)
 {
@@ -268,6 +436,23 @@ void AbstractGfxLayer::SetWriteTexture(GfxPipelineStateObject* PSO, std::string
 	}
 }
 
+void AbstractGfxLayer::SetWriteTextureMips(GfxPipelineStateObject* PSO, std::string name, GfxTexture* texture, UINT FirstMip, GfxCommandList* CL)
+{
+	if (!texture) return;
+
+	if (g_dx12_rhi)
+	{
+		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
+		Texture* dx12Texture = static_cast<Texture*>(texture);
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		assert(FirstMip < dx12Texture->NumMipUAVs);
+
+		D3D12_GPU_DESCRIPTOR_HANDLE GpuHandle = dx12Texture->MipUAVs.GpuHandle;
+		GpuHandle.ptr += FirstMip * g_dx12_rhi->TextureDHRing->DescriptorSize;
+		dx12PSO->SetUAV(name, GpuHandle, dx12CL->CmdList.Get());
+	}
+}
+
 void AbstractGfxLayer::SetReadBuffer(GfxPipelineStateObject* PSO, std::string name, GfxBuffer* buffer, GfxCommandList* CL)
 {
 	if (g_dx12_rhi)
@@ -286,7 +471,30 @@ void AbstractGfxLayer::SetWriteBuffer(GfxPipelineStateObject* PSO, std::string n
 		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
 		Buffer* dx12Buffer = static_cast<Buffer*>(buffer);
 		CommandList* dx12CL = static_cast<CommandList*>(CL);
-		dx12PSO->SetUAV(name, dx12Buffer->SRV.GpuHandle, dx12CL->CmdList.Get());
+		dx12PSO->SetUAV(name, dx12Buffer->UAV.GpuHandle, dx12CL->CmdList.Get());
+	}
+}
+
+void AbstractGfxLayer::SetReadTextureTable(GfxPipelineStateObject* PSO, std::string name, GfxTextureTable* Table, GfxCommandList* CL)
+{
+	if (g_dx12_rhi)
+	{
+		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
+		TextureTable* dx12Table = static_cast<TextureTable*>(Table);
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+
+		Descriptor& FrameTable = dx12Table->UpdateFrameTable(g_dx12_rhi->CurrentFrameIndex);
+		dx12PSO->SetSRV(name, FrameTable.GpuHandle, dx12CL->CmdList.Get());
+	}
+}
+
+void AbstractGfxLayer::SetRootConstant(GfxPipelineStateObject* PSO, std::string name, UINT value, GfxCommandList* CL)
+{
+	if (g_dx12_rhi)
+	{
+		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		dx12PSO->SetRootConstant(name, value, dx12CL->CmdList.Get());
 	}
 }
 
@@ -298,6 +506,11 @@ void AbstractGfxLayer::SetUniformValue(GfxPipelineStateObject* PSO, std::string
 		CommandList* dx12CL = static_cast<CommandList*>(CL);
 		dx12PSO->SetCBVValue(name, pData, dx12CL->CmdList.Get());
 	}
+	else if (g_vulkanImpl)
+	{
+		VKPipelineStateObject* vkPSO = static_cast<VKPipelineStateObject*>(PSO);
+		vkPSO->SetUniformValue(name, pData);
+	}
 }
 
 void AbstractGfxLayer::SetUniformBuffer(GfxPipelineStateObject* PSO, std::string name, GfxBuffer* buffer, int offset, GfxCommandList* CL)
@@ -321,7 +534,11 @@ void AbstractGfxLayer::SetPSO(GfxPipelineStateObject* PSO, GfxCommandList* CL)
 		CommandList* dx12CL = static_cast<CommandList*>(CL);
 		dx12PSO->Apply(dx12CL->CmdList.Get());
 	}
-
+	else if (g_vulkanImpl)
+	{
+		VKPipelineStateObject* vkPSO = static_cast<VKPipelineStateObject*>(PSO);
+		vkPSO->Apply(g_vulkanImpl->cmd);
+	}
 }
 
 void AbstractGfxLayer::DrawInstanced(GfxCommandList* CL, int VertexCountPerInstance, int InstanceCount, int StartVertexLocation, int StartInstanceLocation)
@@ -331,6 +548,11 @@ void AbstractGfxLayer::DrawInstanced(GfxCommandList* CL, int VertexCountPerInsta
 		CommandList* dx12CL = static_cast<CommandList*>(CL);
 		dx12CL->CmdList->DrawInstanced(VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
 	}
+	else if (g_vulkanImpl)
+	{
+		g_vulkanImpl->boundPSO->BindDescriptorSets(g_vulkanImpl->cmd);
+		vkCmdDraw(g_vulkanImpl->cmd, VertexCountPerInstance, InstanceCount, StartVertexLocation, StartInstanceLocation);
+	}
 }
 
 void AbstractGfxLayer::DrawIndexedInstanced(GfxCommandList* CL, int IndexCountPerInstance, int InstanceCount, int StartIndexLocation, int BaseVertexLocation, int StartInstanceLocation)
@@ -340,6 +562,11 @@ void AbstractGfxLayer::DrawIndexedInstanced(GfxCommandList* CL, int IndexCountPe
 		CommandList* dx12CL = static_cast<CommandList*>(CL);
 		dx12CL->CmdList->DrawIndexedInstanced(IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
 	}
+	else if (g_vulkanImpl)
+	{
+		g_vulkanImpl->boundPSO->BindDescriptorSets(g_vulkanImpl->cmd);
+		vkCmdDrawIndexed(g_vulkanImpl->cmd, IndexCountPerInstance, InstanceCount, StartIndexLocation, BaseVertexLocation, StartInstanceLocation);
+	}
 
 }
 
@@ -352,6 +579,12 @@ void AbstractGfxLayer::SetVertexBuffer(GfxCommandList* CL, int StartSlot, int Nu
 
 		dx12CL->CmdList->IASetVertexBuffers(0, 1, &dx12Buffer->view);
 	}
+	else if (g_vulkanImpl)
+	{
+		VKVertexBuffer* vkBuffer = static_cast<VKVertexBuffer*>(buffer);
+		VkDeviceSize offset = 0;
+		vkCmdBindVertexBuffers(g_vulkanImpl->cmd, 0, 1, &vkBuffer->buffer, &offset);
+	}
 }
 
 void AbstractGfxLayer::SetIndexBuffer(GfxCommandList* CL, GfxIndexBuffer* buffer)
@@ -390,6 +623,17 @@ void AbstractGfxLayer::SetScissorRects(GfxCommandList* CL, int NumRects, Rect* r
 
 		dx12CL->CmdList->RSSetScissorRects(1, rectVec.data());
 	}
+	else if (g_vulkanImpl)
+	{
+		std::vector<VkRect2D> rectVec;
+		for (int i = 0; i < NumRects; i++)
+		{
+			VkRect2D vkRect = { { int32_t(rects[i].left), int32_t(rects[i].top) }, { uint32_t(rects[i].right - rects[i].left), uint32_t(rects[i].bottom - rects[i].top) } };
+			rectVec.push_back(vkRect);
+		}
+
+		vkCmdSetScissor(g_vulkanImpl->cmd, 0, 1, rectVec.data());
+	}
 }
 
 void AbstractGfxLayer::SetViewports(GfxCommandList* CL, int NumViewPorts, ViewPort* viewPort)
@@ -407,6 +651,17 @@ void AbstractGfxLayer::SetViewports(GfxCommandList* CL, int NumViewPorts, ViewPo
 
 		dx12CL->CmdList->RSSetViewports(1, vewPortVec.data());
 	}
+	else if (g_vulkanImpl)
+	{
+		std::vector<VkViewport> viewPortVec;
+		for (int i = 0; i < NumViewPorts; i++)
+		{
+			VkViewport vkViewPort = { viewPort[i].TopLeftX, viewPort[i].TopLeftY, viewPort[i].Width, viewPort[i].Height, viewPort[i].MinDepth, viewPort[i].MaxDepth };
+			viewPortVec.push_back(vkViewPort);
+		}
+
+		vkCmdSetViewport(g_vulkanImpl->cmd, 0, 1, viewPortVec.data());
+	}
 }
 
 void AbstractGfxLayer::ClearRenderTarget(GfxCommandList* CL, GfxTexture* texture, float ColorRGBA[4], int NumRects, Rect* rects)
@@ -754,7 +1009,7 @@ void AbstractGfxLayer::BindCBV(GfxPipelineStateObject* PSO, string name, int bas
 	else if (g_vulkanImpl)
 	{
 		VKPipelineStateObject* vkPSO = static_cast<VKPipelineStateObject*>(PSO);
-		vkPSO->BindUniform(name, baseRegister);
+		vkPSO->BindUniform(name, baseRegister, size);
 	}
 }
 
@@ -786,12 +1041,21 @@ void AbstractGfxLayer::BindSRV(GfxPipelineStateObject* PSO, std::string name, in
 	}
 }
 
-void AbstractGfxLayer::BindUAV(GfxPipelineStateObject* PSO, std::string name, int baseRegister)
+void AbstractGfxLayer::BindUAV(GfxPipelineStateObject* PSO, std::string name, int baseRegister, int num)
 {
 	if (g_dx12_rhi)
 	{
 		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
-		dx12PSO->BindUAV(name, baseRegister);
+		dx12PSO->BindUAV(name, baseRegister, num);
+	}
+}
+
+void AbstractGfxLayer::BindRootConstant(GfxPipelineStateObject* PSO, std::string name, int baseRegister)
+{
+	if (g_dx12_rhi)
+	{
+		PipelineStateObject* dx12PSO = static_cast<PipelineStateObject*>(PSO);
+		dx12PSO->BindRootConstant(name, baseRegister);
 	}
 }
 
@@ -1144,6 +1408,48 @@ void AbstractGfxLayer::TransitionResource(GfxCommandList* CL, int NumTransition,
 
 		dx12CL->CmdList->ResourceBarrier(barriers.size(), barriers.data());
 	}
+	else if (g_vulkanImpl)
+	{
+		// the render pass does the layout transitions of its attachments, a barrier ends it.
+		g_vulkanImpl->EndRenderPass();
+	}
+}
+
+void AbstractGfxLayer::UAVBarrier(GfxCommandList* CL, GfxTexture* texture)
+{
+	if (g_dx12_rhi)
+	{
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		Texture* dx12Texture = static_cast<Texture*>(texture);
+
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		barrier.UAV.pResource = dx12Texture->resource.Get();
+		dx12CL->CmdList->ResourceBarrier(1, &barrier);
+	}
+}
+
+void AbstractGfxLayer::UAVBarrier(GfxCommandList* CL, GfxBuffer* buffer)
+{
+	if (g_dx12_rhi)
+	{
+		CommandList* dx12CL = static_cast<CommandList*>(CL);
+		Buffer* dx12Buffer = static_cast<Buffer*>(buffer);
+
+		D3D12_RESOURCE_BARRIER barrier = {};
+		barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+		barrier.UAV.pResource = dx12Buffer->resource.Get();
+		dx12CL->CmdList->ResourceBarrier(1, &barrier);
+	}
+}
+
+void AbstractGfxLayer::MakeMipUAVs(GfxTexture* texture, UINT NumDescriptors)
+{
+	if (g_dx12_rhi)
+	{
+		Texture* dx12Texture = static_cast<Texture*>(texture);
+		dx12Texture->MakeStaticMipUAVs(NumDescriptors);
+	}
 }
 
 void AbstractGfxLayer::GetFrameBuffers(std::vector<std::shared_ptr<GfxTexture>>& FrameFuffers)
@@ -1164,6 +1470,31 @@ void AbstractGfxLayer::GetFrameBuffers(std::vector<std::shared_ptr<GfxTexture>>&
 	}
 }
 
+void AbstractGfxLayer::WaitForFrameSlot()
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->WaitForFrameSlot();
+}
+
+void AbstractGfxLayer::MarkInputSampled()
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->Pacer.MarkInputSampled(ProfilerNowNs());
+}
+
+void AbstractGfxLayer::SetMaxFramesInFlight(UINT Num)
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->Pacer.SetMaxFramesInFlight(Num);
+}
+
+const FramePacer* AbstractGfxLayer::GetFramePacer()
+{
+	if (g_dx12_rhi)
+		return &g_dx12_rhi->Pacer;
+	return nullptr;
+}
+
 void AbstractGfxLayer::BeginFrame(std::list<GfxTexture*>& DynamicTexture)
 {
 	if (g_dx12_rhi)
@@ -1173,12 +1504,65 @@ void AbstractGfxLayer::BeginFrame(std::list<GfxTexture*>& DynamicTexture)
 			dx12DynamicTexture.push_back(static_cast<Texture*>(dt));
 		g_dx12_rhi->BeginFrame(dx12DynamicTexture);
 	}
+	else if (g_vulkanImpl)
+		g_vulkanImpl->BeginFrame();
 }
 
 void AbstractGfxLayer::EndFrame()
 {
 	if (g_dx12_rhi)
 		g_dx12_rhi->EndFrame();
+	else if (g_vulkanImpl)
+		g_vulkanImpl->EndFrame();
+}
+
+UINT AbstractGfxLayer::BeginGPUZone(GfxCommandList* CL, const char* Name)
+{
+	if (g_dx12_rhi)
+		return g_dx12_rhi->BeginGPUZone(static_cast<CommandList*>(CL), Name);
+	return GPUTimestampRing::InvalidZone;
+}
+
+void AbstractGfxLayer::EndGPUZone(GfxCommandList* CL, UINT Zone)
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->EndGPUZone(static_cast<CommandList*>(CL), Zone);
+}
+
+void AbstractGfxLayer::ResolveGPUZones(GfxCommandList* CL)
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->ResolveGPUZones(static_cast<CommandList*>(CL));
+}
+
+const std::vector<GPUZoneTiming>& AbstractGfxLayer::GetGPUZoneTimings()
+{
+	static const std::vector<GPUZoneTiming> Empty;
+	if (g_dx12_rhi)
+		return g_dx12_rhi->GPUZoneTimings;
+	return Empty;
+}
+
+UINT64 AbstractGfxLayer::GetGPUMemoryUsage()
+{
+	if (g_dx12_rhi)
+		return g_dx12_rhi->GetGPUMemoryUsage();
+	return 0;
+}
+
+AbstractGfxLayerScopeGPUProfile::AbstractGfxLayerScopeGPUProfile(GfxCommandList* cl, const char* name)
+	: CPUZone(name), CL(cl)
+{
+	if (g_dx12_rhi)
+		PIXBeginEvent(static_cast<CommandList*>(CL)->CmdList.Get(), ProfileColorFromName(name), name);
+	Zone = AbstractGfxLayer::BeginGPUZone(CL, name);
+}
+
+AbstractGfxLayerScopeGPUProfile::~AbstractGfxLayerScopeGPUProfile()
+{
+	AbstractGfxLayer::EndGPUZone(CL, Zone);
+	if (g_dx12_rhi)
+		PIXEndEvent(static_cast<CommandList*>(CL)->CmdList.Get());
 }
 
 
@@ -1193,12 +1577,11 @@ void AbstractGfxLayer::OnSizeChanged(std::vector<std::shared_ptr<GfxTexture>>& F
 		AbstractGfxLayer::WaitGPUFlush();
 
 		// Release the resources holding references to the swap chain (requirement of
-		// IDXGISwapChain::ResizeBuffers) and reset the frame fence values to the
-		// current fence value.
+		// IDXGISwapChain::ResizeBuffers). the flush retired every frame in flight.
+		g_dx12_rhi->Pacer.Retire(g_dx12_rhi->CmdQSync->m_fence->GetCompletedValue(), ProfilerNowNs());
 		for (UINT n = 0; n < g_dx12_rhi->NumFrame; n++)
 		{
 			dx12Framebuffers[n]->resource.Reset();
-			g_dx12_rhi->FrameFenceValueVec[n] = g_dx12_rhi->FrameFenceValueVec[g_dx12_rhi->CurrentFrameIndex];
 
 			//m_renderTargets[n].Reset();
 			//m_fenceValues[n] = m_fenceValues[m_frameIndex];
@@ -1272,17 +1655,62 @@ GfxCommandList* AbstractGfxLayer::GetGlobalCommandList()
 	}
 }
 
+bool AbstractGfxLayer::HasAsyncCompute()
+{
+	return g_dx12_rhi != nullptr;
+}
+
+void AbstractGfxLayer::BeginAsyncCompute()
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->BeginAsyncCompute();
+}
+
+void AbstractGfxLayer::EndAsyncCompute()
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->EndAsyncCompute();
+}
+
+UINT64 AbstractGfxLayer::SignalQueue(GPUQueue Queue)
+{
+	if (g_dx12_rhi)
+		return g_dx12_rhi->SignalQueue(Queue);
+	return 0;
+}
+
+void AbstractGfxLayer::WaitQueue(GPUQueue Queue, UINT64 FenceValue)
+{
+	if (g_dx12_rhi)
+		g_dx12_rhi->WaitQueue(Queue, FenceValue);
+}
+
+UINT64 AbstractGfxLayer::GetPreviousFrameFenceValue()
+{
+	if (g_dx12_rhi)
+		return g_dx12_rhi->PreviousFrameFenceValue;
+	return 0;
+}
+
 int AbstractGfxLayer::GetCurrentFrameIndex()
 {
 	if (g_dx12_rhi)
 		return g_dx12_rhi->CurrentFrameIndex;
+	else if (g_vulkanImpl)
+		return g_vulkanImpl->CurrentImageIndex;
+	return 0;
 }
 
 
 void AbstractGfxLayer::WaitGPUFlush()
 {
 	if (g_dx12_rhi)
+	{
 		g_dx12_rhi->CmdQSync->WaitGPU();
+		g_dx12_rhi->CmdQAsync->WaitGPU();
+	}
+	else if (g_vulkanImpl)
+		vkDeviceWaitIdle(g_vulkanImpl->Device);
 }
 
 
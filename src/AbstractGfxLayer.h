@@ -10,6 +10,10 @@
 
 #define PROFILE
 #include "pix3.h"
+#include "InstanceStore.h"
+#include "Profiler.h"
+#include "FramePacing.h"
+#include "AsyncCompute.h"
 
 
 typedef unsigned int UINT;
@@ -633,6 +637,14 @@ public:
     virtual ~GfxTexture() {}
 };
 
+// cpu side mip chain produced on the streaming thread.
+class GfxTextureMipData
+{
+public:
+    GfxTextureMipData() {}
+    virtual ~GfxTextureMipData() {}
+};
+
 class GfxBuffer
 {
 public:
@@ -668,6 +680,30 @@ class GfxDescriptor
 
 };
 
+// one tlas instance. several can point at the same blas.
+struct GfxRTInstance
+{
+    UINT BLASIndex;     // into the blas vector, also the hit group record
+    UINT InstanceID;    // InstanceID() in the shaders
+    glm::mat4x4 Transform;
+};
+
+// layout of the indirect commands consumed by ExecuteIndirect.
+class GfxCommandSignature
+{
+public:
+    GfxCommandSignature() {}
+    virtual ~GfxCommandSignature() {}
+};
+
+// srvs of a set of textures in consecutive descriptors, bound as one array.
+class GfxTextureTable
+{
+public:
+    GfxTextureTable() {}
+    virtual ~GfxTextureTable() {}
+};
+
 struct Rect
 {
     long    left;
@@ -731,6 +767,8 @@ class GfxMaterial
 {
 public:
     bool bHasAlpha = false;
+    UINT SortID = 0; // material field of the draw sort key, see DrawQueue.h
+    UINT BindlessIndex = ~0u; // index in the bindless material buffer, see BindlessMaterials.h
 
     std::shared_ptr<GfxTexture> Diffuse;
     std::shared_ptr<GfxTexture> Normal;
@@ -755,10 +793,16 @@ public:
         UINT IndexCount;
         UINT VertexBase;
         UINT VertexCount;
+        float UVDensity = 0.f; // uv units per object space unit
+        glm::vec3 AABBMin = glm::vec3(0, 0, 0); // object space, of the vertices the draw references
+        glm::vec3 AABBMax = glm::vec3(0, 0, 0);
+        UINT CullIndex = 0; // box of the draw in the culling bounds, see SceneCulling.h
     };
 public:
     bool bTransparent = false;
     glm::mat4x4 transform;
+    glm::vec3 AABBMin = glm::vec3(0, 0, 0);
+    glm::vec3 AABBMax = glm::vec3(0, 0, 0);
     UINT NumIndices;
     UINT NumVertices;
 
@@ -773,6 +817,15 @@ public:
     std::shared_ptr<GfxMaterial> Mat;
 
     std::vector<DrawCall> Draws;
+
+    // object space copy of the geometry for cpu ray casting, see ProbePlacementCPU.h.
+    std::vector<glm::vec3> CPUPositions;
+    std::vector<glm::vec3> CPUNormals;
+    std::vector<UINT16> CPUIndices;
+
+    // range of the geometry in the merged buffers of the gpu driven gbuffer, see GPUDrivenScene.h.
+    UINT MergedBaseVertex = 0;
+    UINT MergedStartIndex = 0;
 };
 
 class Scene
@@ -782,7 +835,15 @@ public:
     glm::vec3 AABBMax = glm::vec3(0, 0, 0);
     float BoundingRadius = 0.f;
 
+    // sets instance 0 and the transform of every mesh.
     void SetTransform(glm::mat4x4 inTransform);
+    // draws the scene once more with inTransform. the meshes, their buffers and blases are shared.
+    UINT AddInstance(glm::mat4x4 inTransform);
+
+    // world transforms the scene is drawn with, the meshes share them.
+    InstanceStore Instances;
+    // slot of instance 0 in the instance transform buffer, also the InstanceID of its tlas instances.
+    UINT InstanceBase = 0;
 
 public:
     std::vector<std::shared_ptr<GfxMesh>> meshes;
@@ -797,18 +858,36 @@ public:
     static void SetSampler(std::string bindName, GfxCommandList* cl, GfxPipelineStateObject* PSO, GfxSampler* sampler);
 
     static GfxTexture* CreateTextureFromFile(std::wstring fileName, bool nonSRGB);
+    static GfxTexture* CreateStreamingTexture(std::wstring fileName, bool nonSRGB, GfxTexture* placeholder, UINT& width, UINT& height, std::vector<UINT64>& mipBytes);
+    static GfxTextureMipData* LoadStreamingTextureMips(GfxTexture* texture, UINT FirstMip);
+    static bool UpdateStreamingTexture(GfxTexture* texture, GfxTextureMipData* data, UINT FirstMip);
+    static bool TrimStreamingTexture(GfxTexture* texture, UINT FirstMip);
     static GfxTexture* CreateTexture2D(FORMAT format, RESOURCE_FLAGS resFlags, RESOURCE_STATES initResState, int width, int height, int mipLevels, std::optional<glm::vec4> clearColor = std::nullopt);
     static GfxTexture* CreateTexture3D(FORMAT format, RESOURCE_FLAGS resFlags, RESOURCE_STATES initResState, int width, int height, int depth, int mipLevels);
 
     static GfxVertexBuffer* CreateVertexBuffer(UINT Size, UINT Stride, void* SrcData);
     static GfxIndexBuffer* CreateIndexBuffer(FORMAT Format, UINT Size, void* SrcData);
     static GfxBuffer* CreateByteAddressBuffer(UINT InNumElements, UINT InElementSize, HEAP_TYPE InType, RESOURCE_STATES initResState, RESOURCE_FLAGS InFlags, void* SrcData = nullptr);
+    // cpu readable copy destination, see CopyBuffer. map it once the gpu is done with the frame that copied into it.
+    static GfxBuffer* CreateReadbackBuffer(UINT Size);
 
     static GfxRTAS* CreateTLAS(std::vector<std::shared_ptr<GfxRTAS>>& VecBLAS);
+    static GfxRTAS* CreateTLAS(std::vector<std::shared_ptr<GfxRTAS>>& VecBLAS, const std::vector<GfxRTInstance>& Instances);
     static GfxRTAS* CreateBLAS(GfxMesh* mesh);
 
     static void MapBuffer(GfxBuffer* buffer, void** pData);
     static void UnmapBuffer(GfxBuffer* buffer);
+    static void CopyBuffer(GfxCommandList* CL, GfxBuffer* Dst, GfxBuffer* Src);
+    static void CopyBufferRegion(GfxCommandList* CL, GfxBuffer* Dst, UINT64 DstOffset, GfxBuffer* Src, UINT64 SrcOffset, UINT64 Size);
+
+    // the command is the root constant rootConstantName of PSO followed by the DrawIndexedInstanced arguments.
+    static GfxCommandSignature* CreateDrawIndexedCommandSignature(GfxPipelineStateObject* PSO, std::string rootConstantName);
+    // CountBuffer holds the number of commands as a uint at offset 0, capped by MaxCommandCount.
+    static void ExecuteIndirect(GfxCommandList* CL, GfxCommandSignature* Signature, UINT MaxCommandCount, GfxBuffer* ArgumentBuffer, GfxBuffer* CountBuffer);
+
+    // entries start out null. textures can be streamed, the table follows their current resource.
+    static GfxTextureTable* CreateTextureTable(UINT NumDescriptors);
+    static void SetTextureTableEntry(GfxTextureTable* Table, UINT Index, GfxTexture* texture);
 
 
     static GfxPipelineStateObject* CreatePSO();
@@ -820,11 +899,17 @@ public:
 
     static void SetReadTexture(GfxPipelineStateObject* PSO, std::string name, GfxTexture* texture, GfxCommandList* CL);
     static void SetWriteTexture(GfxPipelineStateObject* PSO, std::string name, GfxTexture* texture, GfxCommandList* CL);
+    // binds the static per mip uavs starting at FirstMip. see MakeMipUAVs.
+    static void SetWriteTextureMips(GfxPipelineStateObject* PSO, std::string name, GfxTexture* texture, UINT FirstMip, GfxCommandList* CL);
 
     static void SetReadBuffer(GfxPipelineStateObject* PSO, std::string name, GfxBuffer* buffer, GfxCommandList* CL);
     static void SetWriteBuffer(GfxPipelineStateObject* PSO, std::string name, GfxBuffer* buffer, GfxCommandList* CL);
 
+    static void SetReadTextureTable(GfxPipelineStateObject* PSO, std::string name, GfxTextureTable* Table, GfxCommandList* CL);
+
     static void SetUniformValue(GfxPipelineStateObject* PSO, std::string name, void* pData, GfxCommandList* CL);
+    // a 32 bit constant bound with BindRootConstant.
+    static void SetRootConstant(GfxPipelineStateObject* PSO, std::string name, UINT value, GfxCommandList* CL);
     static void SetUniformBuffer(GfxPipelineStateObject* PSO, std::string name, GfxBuffer* buffer, int offset, GfxCommandList* CL);
 
     static void SetPSO(GfxPipelineStateObject* PSO, GfxCommandList* CL);
@@ -852,7 +937,8 @@ public:
     static void BindSRV(GfxPipelineStateObject* PSO, std::string name, int baseRegister, int num);
     static void BindSampler(GfxPipelineStateObject* PSO, std::string name, int baseRegister);
     static void BindCBV(GfxPipelineStateObject* PSO, std::string name, int baseRegister, int size);
-    static void BindUAV(GfxPipelineStateObject* PSO, std::string name, int baseRegister);
+    static void BindUAV(GfxPipelineStateObject* PSO, std::string name, int baseRegister, int num = 1);
+    static void BindRootConstant(GfxPipelineStateObject* PSO, std::string name, int baseRegister);
 
     // rt pso
     static void AddHitGroup(GfxRTPipelineStateObject* PSO, std::string name, std::string chs, std::string ahs);
@@ -894,9 +980,22 @@ public:
     static bool InitRTPSO(GfxRTPipelineStateObject* PSO, RTPSO_DESC* desc);
 
     static void TransitionResource(GfxCommandList* CL, int NumTransition, ResourceTransition* transitions);
+    static void UAVBarrier(GfxCommandList* CL, GfxTexture* texture);
+    static void UAVBarrier(GfxCommandList* CL, GfxBuffer* buffer);
+
+    // allocates NumDescriptors contiguous uavs, one per mip. slots past the last mip get null uavs
+    // so a shader can declare a fixed size array.
+    static void MakeMipUAVs(GfxTexture* texture, UINT NumDescriptors);
 
     static void GetFrameBuffers(std::vector<std::shared_ptr<GfxTexture>>& FrameFuffers);
     
+    // blocks until the frame may begin under the frames in flight limit. BeginFrame waits as well,
+    // waiting first lets the app sample its input after the block rather than before it.
+    static void WaitForFrameSlot();
+    static void MarkInputSampled();
+    static void SetMaxFramesInFlight(UINT Num);
+    static const FramePacer* GetFramePacer();
+
     static void BeginFrame(std::list<GfxTexture*>& DynamicTexture);
     static void EndFrame();
     static void OnSizeChanged(std::vector<std::shared_ptr<GfxTexture>>& FrameFuffers, int width, int height, bool minimized);
@@ -910,8 +1009,29 @@ public:
 
     static GfxCommandList* GetGlobalCommandList();
 
+    // async compute, see AsyncCompute.h. between BeginAsyncCompute and EndAsyncCompute GetGlobalCommandList
+    // records to the compute queue, EndAsyncCompute submits it. SignalQueue and WaitQueue are the sync points
+    // between the queues, a wait on the graphics queue submits the graphics list recorded before it.
+    static bool HasAsyncCompute();
+    static void BeginAsyncCompute();
+    static void EndAsyncCompute();
+    static UINT64 SignalQueue(GPUQueue Queue);
+    static void WaitQueue(GPUQueue Queue, UINT64 FenceValue);
+    // the graphics fence value signaled at the end of the last frame.
+    static UINT64 GetPreviousFrameFenceValue();
+
     static int GetCurrentFrameIndex();
 
+    // gpu zones of the profiler, timestamp pairs around the commands recorded in between. ResolveGPUZones
+    // goes after the frame's last zone, the timings come back with GetGPUZoneTimings once the frame retired.
+    static UINT BeginGPUZone(GfxCommandList* CL, const char* Name);
+    static void EndGPUZone(GfxCommandList* CL, UINT Zone);
+    static void ResolveGPUZones(GfxCommandList* CL);
+    static const std::vector<GPUZoneTiming>& GetGPUZoneTimings();
+
+    // bytes of local video memory the process uses, 0 when the adapter can't tell.
+    static UINT64 GetGPUMemoryUsage();
+
     static void WaitGPUFlush();
 
     static bool IsDX12();
@@ -930,28 +1050,18 @@ public:
 
 
 
+// pix event, gpu timestamp zone and cpu zone of one pass. the pix color comes from the name so a pass
+// keeps its color between captures.
 class AbstractGfxLayerScopeGPUProfile
 {
 public:
+    AbstractGfxLayerScopeGPUProfile(GfxCommandList* cl, const char* name);
+    ~AbstractGfxLayerScopeGPUProfile();
 
-    template<typename... ARGS>
-    AbstractGfxLayerScopeGPUProfile(GfxCommandList* cl, UINT64 color, PCSTR formatString, ARGS... args)
-    {
-        //if (AbstractGfxLayer::IsDX12())
-        {
-            CommandList* dx12CL = static_cast<CommandList*>(cl);
-            PIXBeginEvent(dx12CL->CmdList.Get(), color, formatString, args...);
-        }
-    }
-
-    ~AbstractGfxLayerScopeGPUProfile()
-    {
-        //if (AbstractGfxLayer::IsDX12())
-            PIXEndEvent();
-
-    }
+private:
+    ProfileCPUZone CPUZone;
+    GfxCommandList* CL;
+    UINT Zone;
 };
 
-//#define ProfileGPUScope(...) PIXScopedRetailEventObject p(__VA_ARGS__);
-#define ProfileGPUScope(cl, ...) CommandList* dx12CL = static_cast<CommandList*>(cl);\
-                                 PIXScopedEvent(dx12CL->CmdList.Get(), __VA_ARGS__);
+#define ProfileGPUScope(cl, name) AbstractGfxLayerScopeGPUProfile PROFILER_CONCAT(GPUProfileScope_, __LINE__)(cl, name)
@@ -0,0 +1,245 @@
+#include "AsyncCompute.h"
+
+#include <algorithm>
+#include <iomanip>
+
+void AsyncComputeScheduler::Clear()
+{
+	Passes.clear();
+	Dependencies.clear();
+	Schedule.clear();
+	NumOverlapped.clear();
+	FrameEndWaitForPass = -1;
+}
+
+uint32_t AsyncComputeScheduler::AddPass(const AsyncPassDesc& Desc)
+{
+	Passes.push_back(Desc);
+	return uint32_t(Passes.size() - 1);
+}
+
+bool AsyncComputeScheduler::Conflicts(uint32_t A, uint32_t B) const
+{
+	auto Contains = [](const std::vector<const void*>& Set, const void* Resource)
+	{
+		return std::find(Set.begin(), Set.end(), Resource) != Set.end();
+	};
+
+	// any write to a resource the other pass touches. two reads don't order the passes.
+	for (const void* Resource : Passes[A].Writes)
+	{
+		if (Contains(Passes[B].Reads, Resource) || Contains(Passes[B].Writes, Resource))
+			return true;
+	}
+	for (const void* Resource : Passes[A].Reads)
+	{
+		if (Contains(Passes[B].Writes, Resource))
+			return true;
+	}
+	return false;
+}
+
+void AsyncComputeScheduler::FindDependencies()
+{
+	Dependencies.clear();
+	for (uint32_t To = 0; To < Passes.size(); To++)
+	{
+		for (uint32_t From = 0; From < To; From++)
+		{
+			if (Conflicts(From, To))
+				Dependencies.push_back({ From, To });
+		}
+	}
+}
+
+void AsyncComputeScheduler::PlaceSyncPoints()
+{
+	for (AsyncScheduledPass& Pass : Schedule)
+	{
+		Pass.WaitForPass = -1;
+		Pass.bWaitPreviousFrame = false;
+		Pass.bSignal = false;
+	}
+	FrameEndWaitForPass = -1;
+
+	// queues run in order, a wait covers every earlier pass of the other queue. LastWaited is the latest
+	// pass of the other queue each queue already waited for.
+	int LastWaited[2] = { -1, -1 };
+	bool bComputeAfterPreviousFrame = false;
+	int LastCompute = -1;
+
+	for (uint32_t To = 0; To < Passes.size(); To++)
+	{
+		AsyncScheduledPass& Pass = Schedule[To];
+		const int Queue = int(Pass.Queue);
+
+		int Needed = -1;
+		for (const Dependency& Dep : Dependencies)
+		{
+			if (Dep.To == To && Schedule[Dep.From].Queue != Pass.Queue)
+				Needed = std::max(Needed, int(Dep.From));
+		}
+
+		if (Needed > LastWaited[Queue])
+		{
+			Pass.WaitForPass = Needed;
+			Schedule[Needed].bSignal = true;
+			LastWaited[Queue] = Needed;
+		}
+
+		if (Pass.Queue != GPUQueue::Compute)
+			continue;
+
+		LastCompute = int(To);
+
+		// waiting for a graphics pass of this frame implies the previous frame's graphics work is done.
+		if (LastWaited[Queue] >= 0)
+			bComputeAfterPreviousFrame = true;
+
+		if (!bComputeAfterPreviousFrame)
+		{
+			for (uint32_t Other = 0; Other < Passes.size(); Other++)
+			{
+				if (Schedule[Other].Queue == GPUQueue::Graphics && (Conflicts(Other, To) || Conflicts(To, Other)))
+				{
+					Pass.bWaitPreviousFrame = true;
+					bComputeAfterPreviousFrame = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// join at the end of the frame so the next frame's graphics work can't overtake this frame's compute work.
+	if (LastCompute > LastWaited[int(GPUQueue::Graphics)])
+	{
+		FrameEndWaitForPass = LastCompute;
+		Schedule[LastCompute].bSignal = true;
+	}
+}
+
+void AsyncComputeScheduler::MeasureOverlap()
+{
+	NumOverlapped.assign(Passes.size(), 0);
+
+	int WindowStart = -1;
+	for (uint32_t Index = 0; Index < Passes.size(); Index++)
+	{
+		AsyncScheduledPass& Pass = Schedule[Index];
+		Pass.OverlapMs = 0.0;
+		if (Pass.Queue != GPUQueue::Compute)
+			continue;
+
+		// graphics passes after the latest one the compute queue waited for, up to the first one that
+		// waits for this pass or a later compute pass.
+		WindowStart = std::max(WindowStart, Pass.WaitForPass);
+
+		uint32_t WindowEnd = uint32_t(Passes.size());
+		for (uint32_t Other = Index + 1; Other < Passes.size(); Other++)
+		{
+			if (Schedule[Other].Queue == GPUQueue::Graphics && Schedule[Other].WaitForPass >= int(Index))
+			{
+				WindowEnd = Other;
+				break;
+			}
+		}
+
+		for (uint32_t Other = uint32_t(WindowStart + 1); Other < WindowEnd; Other++)
+		{
+			if (Schedule[Other].Queue == GPUQueue::Graphics)
+			{
+				Pass.OverlapMs += Passes[Other].EstimatedMs;
+				NumOverlapped[Index]++;
+			}
+		}
+
+		Pass.Reason = NumOverlapped[Index] ? "overlaps graphics work" : "no independent graphics work";
+	}
+}
+
+void AsyncComputeScheduler::Solve()
+{
+	FindDependencies();
+
+	Schedule.assign(Passes.size(), AsyncScheduledPass());
+	for (uint32_t Index = 0; Index < Passes.size(); Index++)
+	{
+		AsyncScheduledPass& Pass = Schedule[Index];
+		if (!Passes[Index].bComputeCapable)
+			Pass.Reason = "graphics only";
+		else if (!bAsyncEnabled)
+			Pass.Reason = "async disabled";
+		else
+			Pass.Queue = GPUQueue::Compute;
+	}
+
+	// a compute pass the graphics queue has to wait for right away only adds fences. moving one back
+	// changes the sync points of the others, repeat until every compute pass overlaps something.
+	for (;;)
+	{
+		PlaceSyncPoints();
+		MeasureOverlap();
+
+		bool bChanged = false;
+		for (uint32_t Index = 0; Index < Schedule.size(); Index++)
+		{
+			if (Schedule[Index].Queue == GPUQueue::Compute && NumOverlapped[Index] == 0)
+			{
+				Schedule[Index].Queue = GPUQueue::Graphics;
+				bChanged = true;
+			}
+		}
+
+		if (!bChanged)
+			break;
+	}
+}
+
+std::vector<const char*> AsyncComputeScheduler::GetAsyncPassNames() const
+{
+	std::vector<const char*> Names;
+	for (uint32_t Index = 0; Index < Schedule.size(); Index++)
+	{
+		if (Schedule[Index].Queue == GPUQueue::Compute)
+			Names.push_back(Passes[Index].Name);
+	}
+	return Names;
+}
+
+double AsyncComputeScheduler::GetTotalOverlapMs() const
+{
+	// compute passes share the queue, their windows overlap each other. the widest one bounds the gain.
+	double Overlap = 0.0;
+	for (const AsyncScheduledPass& Pass : Schedule)
+		Overlap = std::max(Overlap, Pass.OverlapMs);
+	return Overlap;
+}
+
+void AsyncComputeScheduler::WriteReport(std::ostream& Out) const
+{
+	const std::vector<const char*> Async = GetAsyncPassNames();
+	Out << "async compute: " << Async.size() << " of " << Passes.size() << " passes, overlap "
+		<< std::fixed << std::setprecision(2) << GetTotalOverlapMs() << " ms\n";
+
+	for (uint32_t Index = 0; Index < Passes.size(); Index++)
+	{
+		const AsyncScheduledPass& Pass = Schedule[Index];
+		Out << "  " << std::left << std::setw(28) << Passes[Index].Name
+			<< (Pass.Queue == GPUQueue::Compute ? "compute   " : "graphics  ");
+
+		if (Pass.bWaitPreviousFrame)
+			Out << "waits previous frame, ";
+		if (Pass.WaitForPass >= 0)
+			Out << "waits " << Passes[Pass.WaitForPass].Name << ", ";
+		if (Pass.bSignal)
+			Out << "signals, ";
+		if (Pass.Queue == GPUQueue::Compute)
+			Out << "overlaps " << Pass.OverlapMs << " ms";
+		else
+			Out << Pass.Reason;
+		Out << "\n";
+	}
+
+	if (FrameEndWaitForPass >= 0)
+		Out << "  frame end waits " << Passes[FrameEndWaitForPass].Name << "\n";
+}
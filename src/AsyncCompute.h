@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <vector>
+
+// splits the passes of a frame between the graphics queue and an async compute queue. passes are added in
+// graphics submission order with the resources they read and write, any pointer identifies a resource. the
+// scheduler derives read after write, write after read and write after write dependencies, moves compute
+// capable passes with independent graphics work next to them onto the compute queue and places the fence
+// signals and waits of the dependencies that cross queues.
+
+enum class GPUQueue : uint8_t
+{
+	Graphics,
+	Compute,
+};
+
+struct AsyncPassDesc
+{
+	const char* Name = "";
+	// records nothing but dispatches and transitions a compute queue allows.
+	bool bComputeCapable = false;
+	std::vector<const void*> Reads;
+	std::vector<const void*> Writes;
+	double EstimatedMs = 0.0;	// gpu time of the pass, for the overlap estimate
+};
+
+struct AsyncScheduledPass
+{
+	GPUQueue Queue = GPUQueue::Graphics;
+	// the pass waits on its queue for the signal after pass WaitForPass of the other queue, -1 for none.
+	int WaitForPass = -1;
+	// a compute pass waits for the graphics queue of the previous frame, it touches resources the graphics
+	// queue used after it in frame order.
+	bool bWaitPreviousFrame = false;
+	// its queue signals after the pass.
+	bool bSignal = false;
+	// graphics work between the compute pass's wait and the graphics wait that joins it.
+	double OverlapMs = 0.0;
+	const char* Reason = "";
+};
+
+class AsyncComputeScheduler
+{
+public:
+	void Clear();
+
+	// returns the index of the pass.
+	uint32_t AddPass(const AsyncPassDesc& Desc);
+
+	// off keeps every pass on the graphics queue.
+	void SetAsyncEnabled(bool bInEnabled) { bAsyncEnabled = bInEnabled; }
+	bool IsAsyncEnabled() const { return bAsyncEnabled; }
+
+	void Solve();
+
+	uint32_t GetNumPasses() const { return uint32_t(Passes.size()); }
+	const AsyncPassDesc& GetPass(uint32_t Index) const { return Passes[Index]; }
+	const std::vector<AsyncScheduledPass>& GetSchedule() const { return Schedule; }
+
+	// the graphics queue waits for the signal after this compute pass before the frame ends, -1 for none.
+	// the frame's graphics fence then covers its compute work as well.
+	int GetFrameEndWaitForPass() const { return FrameEndWaitForPass; }
+
+	std::vector<const char*> GetAsyncPassNames() const;
+	double GetTotalOverlapMs() const;
+
+	// one line per pass with its queue, sync points and reason.
+	void WriteReport(std::ostream& Out) const;
+
+private:
+	struct Dependency
+	{
+		uint32_t From;
+		uint32_t To;
+	};
+
+	void FindDependencies();
+	void PlaceSyncPoints();
+	void MeasureOverlap();
+	bool Conflicts(uint32_t A, uint32_t B) const;
+
+	bool bAsyncEnabled = true;
+	std::vector<AsyncPassDesc> Passes;
+	std::vector<Dependency> Dependencies;
+	std::vector<AsyncScheduledPass> Schedule;
+	std::vector<uint32_t> NumOverlapped;	// graphics passes in each compute pass's window
+	int FrameEndWaitForPass = -1;
+};
@@ -0,0 +1,175 @@
+#include "BatchMath.h"
+
+#include <cfloat>
+#include <cmath>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#define BATCH_MATH_SSE 1
+#include <xmmintrin.h>
+#else
+#define BATCH_MATH_SSE 0
+#endif
+
+#if BATCH_MATH_SSE
+
+static inline __m128 Splat(__m128 V, int Lane)
+{
+	switch (Lane)
+	{
+	case 0: return _mm_shuffle_ps(V, V, _MM_SHUFFLE(0, 0, 0, 0));
+	case 1: return _mm_shuffle_ps(V, V, _MM_SHUFFLE(1, 1, 1, 1));
+	case 2: return _mm_shuffle_ps(V, V, _MM_SHUFFLE(2, 2, 2, 2));
+	default: return _mm_shuffle_ps(V, V, _MM_SHUFFLE(3, 3, 3, 3));
+	}
+}
+
+// w is a.w * b.w - a.w * b.w, 0.
+static inline __m128 Cross(__m128 A, __m128 B)
+{
+	const __m128 AYZX = _mm_shuffle_ps(A, A, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 BYZX = _mm_shuffle_ps(B, B, _MM_SHUFFLE(3, 0, 2, 1));
+	const __m128 C = _mm_sub_ps(_mm_mul_ps(A, BYZX), _mm_mul_ps(AYZX, B));
+	return _mm_shuffle_ps(C, C, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// the dot product in every lane.
+static inline __m128 Dot4(__m128 A, __m128 B)
+{
+	__m128 Sum = _mm_mul_ps(A, B);
+	Sum = _mm_add_ps(Sum, _mm_shuffle_ps(Sum, Sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	return _mm_add_ps(Sum, _mm_shuffle_ps(Sum, Sum, _MM_SHUFFLE(1, 0, 3, 2)));
+}
+
+#endif
+
+void BatchTranspose(const glm::mat4x4* In, glm::mat4x4* Out, size_t Count)
+{
+	for (size_t i = 0; i < Count; i++)
+	{
+#if BATCH_MATH_SSE
+		const float* PI = &In[i][0][0];
+		__m128 C0 = _mm_loadu_ps(PI + 0);
+		__m128 C1 = _mm_loadu_ps(PI + 4);
+		__m128 C2 = _mm_loadu_ps(PI + 8);
+		__m128 C3 = _mm_loadu_ps(PI + 12);
+		_MM_TRANSPOSE4_PS(C0, C1, C2, C3);
+
+		float* PO = &Out[i][0][0];
+		_mm_storeu_ps(PO + 0, C0);
+		_mm_storeu_ps(PO + 4, C1);
+		_mm_storeu_ps(PO + 8, C2);
+		_mm_storeu_ps(PO + 12, C3);
+#else
+		Out[i] = glm::transpose(In[i]);
+#endif
+	}
+}
+
+void BatchAffineInverse(const glm::mat4x4* In, glm::mat4x4* Out, size_t Count)
+{
+	for (size_t i = 0; i < Count; i++)
+	{
+#if BATCH_MATH_SSE
+		const float* PI = &In[i][0][0];
+		const __m128 C0 = _mm_loadu_ps(PI + 0);
+		const __m128 C1 = _mm_loadu_ps(PI + 4);
+		const __m128 C2 = _mm_loadu_ps(PI + 8);
+		const __m128 T = _mm_loadu_ps(PI + 12);
+
+		// the rows of the inverse 3x3 are the cross products of the columns over the determinant.
+		const __m128 R0 = Cross(C1, C2);
+		const __m128 R1 = Cross(C2, C0);
+		const __m128 R2 = Cross(C0, C1);
+		const __m128 InvDet = _mm_div_ps(_mm_set1_ps(1.f), Dot4(C0, R0));
+
+		__m128 O0 = _mm_mul_ps(R0, InvDet);
+		__m128 O1 = _mm_mul_ps(R1, InvDet);
+		__m128 O2 = _mm_mul_ps(R2, InvDet);
+		__m128 O3 = _mm_setzero_ps();
+		_MM_TRANSPOSE4_PS(O0, O1, O2, O3);
+
+		// -inverse(3x3) * t, w of the columns is 0.
+		__m128 Translation = _mm_mul_ps(O0, Splat(T, 0));
+		Translation = _mm_add_ps(Translation, _mm_mul_ps(O1, Splat(T, 1)));
+		Translation = _mm_add_ps(Translation, _mm_mul_ps(O2, Splat(T, 2)));
+		Translation = _mm_sub_ps(_mm_set_ps(1.f, 0.f, 0.f, 0.f), Translation);
+
+		float* PO = &Out[i][0][0];
+		_mm_storeu_ps(PO + 0, O0);
+		_mm_storeu_ps(PO + 4, O1);
+		_mm_storeu_ps(PO + 8, O2);
+		_mm_storeu_ps(PO + 12, Translation);
+#else
+		const glm::mat3x3 Inverse = glm::inverse(glm::mat3x3(In[i]));
+		const glm::vec3 Translation = -(Inverse * glm::vec3(In[i][3]));
+		Out[i] = glm::mat4x4(Inverse);
+		Out[i][3] = glm::vec4(Translation, 1.f);
+#endif
+	}
+}
+
+void BatchTransformBoundsUnion(const float* const Rows[3][4], uint32_t Count, const glm::vec3& Min, const glm::vec3& Max,
+	glm::vec3& OutMin, glm::vec3& OutMax)
+{
+	const glm::vec3 Center = (Min + Max) * 0.5f;
+	const glm::vec3 Extent = (Max - Min) * 0.5f;
+
+	for (int Row = 0; Row < 3; Row++)
+	{
+		const float* M0 = Rows[Row][0];
+		const float* M1 = Rows[Row][1];
+		const float* M2 = Rows[Row][2];
+		const float* M3 = Rows[Row][3];
+
+		float RowMin = FLT_MAX;
+		float RowMax = -FLT_MAX;
+		uint32_t i = 0;
+
+#if BATCH_MATH_SSE
+		const __m128 SignMask = _mm_set1_ps(-0.f);
+		const __m128 CX = _mm_set1_ps(Center.x), CY = _mm_set1_ps(Center.y), CZ = _mm_set1_ps(Center.z);
+		const __m128 EX = _mm_set1_ps(Extent.x), EY = _mm_set1_ps(Extent.y), EZ = _mm_set1_ps(Extent.z);
+		__m128 VMin = _mm_set1_ps(FLT_MAX);
+		__m128 VMax = _mm_set1_ps(-FLT_MAX);
+
+		for (; i + 4 <= Count; i += 4)
+		{
+			const __m128 V0 = _mm_loadu_ps(M0 + i);
+			const __m128 V1 = _mm_loadu_ps(M1 + i);
+			const __m128 V2 = _mm_loadu_ps(M2 + i);
+
+			__m128 WorldCenter = _mm_add_ps(_mm_mul_ps(V0, CX), _mm_loadu_ps(M3 + i));
+			WorldCenter = _mm_add_ps(WorldCenter, _mm_mul_ps(V1, CY));
+			WorldCenter = _mm_add_ps(WorldCenter, _mm_mul_ps(V2, CZ));
+
+			__m128 WorldExtent = _mm_mul_ps(_mm_andnot_ps(SignMask, V0), EX);
+			WorldExtent = _mm_add_ps(WorldExtent, _mm_mul_ps(_mm_andnot_ps(SignMask, V1), EY));
+			WorldExtent = _mm_add_ps(WorldExtent, _mm_mul_ps(_mm_andnot_ps(SignMask, V2), EZ));
+
+			VMin = _mm_min_ps(VMin, _mm_sub_ps(WorldCenter, WorldExtent));
+			VMax = _mm_max_ps(VMax, _mm_add_ps(WorldCenter, WorldExtent));
+		}
+
+		alignas(16) float LaneMin[4], LaneMax[4];
+		_mm_store_ps(LaneMin, VMin);
+		_mm_store_ps(LaneMax, VMax);
+		for (int Lane = 0; Lane < 4; Lane++)
+		{
+			RowMin = std::min(RowMin, LaneMin[Lane]);
+			RowMax = std::max(RowMax, LaneMax[Lane]);
+		}
+#endif
+
+		for (; i < Count; i++)
+		{
+			const float WorldCenter = M0[i] * Center.x + M1[i] * Center.y + M2[i] * Center.z + M3[i];
+			const float WorldExtent = fabsf(M0[i]) * Extent.x + fabsf(M1[i]) * Extent.y + fabsf(M2[i]) * Extent.z;
+			RowMin = std::min(RowMin, WorldCenter - WorldExtent);
+			RowMax = std::max(RowMax, WorldCenter + WorldExtent);
+		}
+
+		OutMin[Row] = RowMin;
+		OutMax[Row] = RowMax;
+	}
+}
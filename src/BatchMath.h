@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "glm/glm.hpp"
+
+// batched matrix kernels for the per frame camera math and the instance bounds. glm::mat4x4 is column major,
+// the sse path keeps one column in a register. other targets use the scalar path.
+
+// Out may alias In.
+void BatchTranspose(const glm::mat4x4* In, glm::mat4x4* Out, size_t Count);
+
+// inverse of matrices whose last row is 0 0 0 1, view and object transforms. the 3x3 part is inverted with
+// its cofactors, it doesn't have to be orthonormal. Out may alias In.
+void BatchAffineInverse(const glm::mat4x4* In, glm::mat4x4* Out, size_t Count);
+
+// union of the box Min, Max transformed by Count affine transforms in structure of arrays form, Rows[Row][Column]
+// holds element (Row, Column) of every transform. Arvo's method per transform, the same as TransformBounds
+// of SceneCulling.h.
+void BatchTransformBoundsUnion(const float* const Rows[3][4], uint32_t Count, const glm::vec3& Min, const glm::vec3& Max,
+	glm::vec3& OutMin, glm::vec3& OutMax);
@@ -0,0 +1,422 @@
+#include "Benchmark.h"
+#include "FrameTiming.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+bool CameraPath::Parse(const std::string& Text, std::string& Error)
+{
+	// a file that fails halfway leaves no path behind.
+	Keys.clear();
+	std::vector<CameraPathKey> Parsed;
+
+	std::istringstream Stream(Text);
+	std::string Line;
+	for (int LineNumber = 1; std::getline(Stream, Line); LineNumber++)
+	{
+		const size_t First = Line.find_first_not_of(" \t\r");
+		if (First == std::string::npos || Line[First] == '#')
+			continue;
+
+		CameraPathKey Key;
+		std::istringstream Fields(Line);
+		Fields >> Key.Time >> Key.Position.x >> Key.Position.y >> Key.Position.z >> Key.Yaw >> Key.Pitch
+			>> Key.LightDir.x >> Key.LightDir.y >> Key.LightDir.z >> Key.LightIntensity;
+
+		std::string Rest;
+		if (!Fields || (Fields >> Rest))
+		{
+			Error = "line " + std::to_string(LineNumber) + ": expected time px py pz yaw pitch lx ly lz intensity";
+			return false;
+		}
+		if (!Parsed.empty() && Key.Time < Parsed.back().Time)
+		{
+			Error = "line " + std::to_string(LineNumber) + ": time goes backwards";
+			return false;
+		}
+		if (glm::length(Key.LightDir) <= 0.f)
+		{
+			Error = "line " + std::to_string(LineNumber) + ": zero light direction";
+			return false;
+		}
+
+		Key.LightDir = glm::normalize(Key.LightDir);
+		Parsed.push_back(Key);
+	}
+
+	if (Parsed.empty())
+	{
+		Error = "no keys";
+		return false;
+	}
+	Keys = std::move(Parsed);
+	return true;
+}
+
+bool CameraPath::LoadFile(const std::string& Path, std::string& Error)
+{
+	std::ifstream File(Path, std::ios::binary);
+	if (!File)
+	{
+		Error = "can't open " + Path;
+		return false;
+	}
+
+	std::stringstream Text;
+	Text << File.rdbuf();
+	if (!Parse(Text.str(), Error))
+	{
+		Error = Path + " " + Error;
+		return false;
+	}
+	return true;
+}
+
+void CameraPath::Write(std::ostream& Out) const
+{
+	Out << "# time px py pz yaw pitch lx ly lz intensity\n";
+	Out << std::setprecision(9);
+	for (const CameraPathKey& Key : Keys)
+	{
+		Out << Key.Time << ' ' << Key.Position.x << ' ' << Key.Position.y << ' ' << Key.Position.z << ' '
+			<< Key.Yaw << ' ' << Key.Pitch << ' '
+			<< Key.LightDir.x << ' ' << Key.LightDir.y << ' ' << Key.LightDir.z << ' ' << Key.LightIntensity << '\n';
+	}
+}
+
+bool CameraPath::WriteFile(const std::string& Path, std::string& Error) const
+{
+	std::ofstream File(Path, std::ios::binary);
+	if (!File)
+	{
+		Error = "can't open " + Path;
+		return false;
+	}
+
+	Write(File);
+	if (!File)
+	{
+		Error = "can't write " + Path;
+		return false;
+	}
+	return true;
+}
+
+void CameraPath::AddKey(const CameraPathKey& Key)
+{
+	if (!Keys.empty() && Key.Time < Keys.back().Time)
+		return;
+	Keys.push_back(Key);
+}
+
+CameraPathKey CameraPath::Sample(float Time) const
+{
+	if (Keys.empty())
+		return CameraPathKey();
+	if (Time <= Keys.front().Time)
+		return Keys.front();
+	if (Time >= Keys.back().Time)
+		return Keys.back();
+
+	// first key after Time, the segment is [i - 1, i].
+	const size_t i = std::upper_bound(Keys.begin(), Keys.end(), Time,
+		[](float T, const CameraPathKey& Key) { return T < Key.Time; }) - Keys.begin();
+
+	const CameraPathKey& K1 = Keys[i - 1];
+	const CameraPathKey& K2 = Keys[i];
+	const CameraPathKey& K0 = Keys[i > 1 ? i - 2 : i - 1];
+	const CameraPathKey& K3 = Keys[std::min(i + 1, Keys.size() - 1)];
+
+	const float Span = K2.Time - K1.Time;
+	const float t = Span > 0.f ? (Time - K1.Time) / Span : 1.f;
+	const float t2 = t * t;
+	const float t3 = t2 * t;
+
+	CameraPathKey Out;
+	Out.Time = Time;
+	Out.Position = 0.5f * ((2.f * K1.Position) + (K2.Position - K0.Position) * t
+		+ (2.f * K0.Position - 5.f * K1.Position + 4.f * K2.Position - K3.Position) * t2
+		+ (3.f * K1.Position - K0.Position - 3.f * K2.Position + K3.Position) * t3);
+	Out.Yaw = glm::mix(K1.Yaw, K2.Yaw, t);
+	Out.Pitch = glm::mix(K1.Pitch, K2.Pitch, t);
+	Out.LightIntensity = glm::mix(K1.LightIntensity, K2.LightIntensity, t);
+
+	const glm::vec3 LightDir = glm::mix(K1.LightDir, K2.LightDir, t);
+	Out.LightDir = glm::length(LightDir) > 0.f ? glm::normalize(LightDir) : K2.LightDir;
+	return Out;
+}
+
+namespace
+{
+	bool ParseUInt(const std::string& Text, uint32_t& Out)
+	{
+		char* End = nullptr;
+		const unsigned long long Value = strtoull(Text.c_str(), &End, 10);
+		if (Text.empty() || *End != 0 || Text[0] == '-' || Value > UINT32_MAX)
+			return false;
+		Out = uint32_t(Value);
+		return true;
+	}
+
+	bool ParseDouble(const std::string& Text, double& Out)
+	{
+		char* End = nullptr;
+		const double Value = strtod(Text.c_str(), &End);
+		if (Text.empty() || *End != 0 || !std::isfinite(Value))
+			return false;
+		Out = Value;
+		return true;
+	}
+}
+
+bool ParseBenchmarkArgs(const std::vector<std::string>& Args, BenchmarkSettings& Out, std::string& Error)
+{
+	for (size_t i = 0; i < Args.size(); i++)
+	{
+		const std::string& Arg = Args[i];
+		if (Arg.compare(0, 10, "-benchmark") != 0)
+			continue;
+
+		if (i + 1 >= Args.size())
+		{
+			Error = Arg + " needs a value";
+			return false;
+		}
+		const std::string& Value = Args[++i];
+
+		bool bValid = true;
+		if (Arg == "-benchmark")
+		{
+			Out.bEnabled = true;
+			Out.PathFile = Value;
+		}
+		else if (Arg == "-benchmark_frames")
+			bValid = ParseUInt(Value, Out.NumFrames) && Out.NumFrames > 0;
+		else if (Arg == "-benchmark_warmup")
+			bValid = ParseUInt(Value, Out.NumWarmupFrames);
+		else if (Arg == "-benchmark_dt")
+			bValid = ParseDouble(Value, Out.TimeStep) && Out.TimeStep > 0.0;
+		else if (Arg == "-benchmark_out")
+			Out.OutputPrefix = Value;
+		else
+		{
+			Error = "unknown option " + Arg;
+			return false;
+		}
+
+		if (!bValid)
+		{
+			Error = "bad value " + Value + " for " + Arg;
+			return false;
+		}
+	}
+	return true;
+}
+
+void BenchmarkRecorder::Clear()
+{
+	Columns.clear();
+	Frames.clear();
+}
+
+void BenchmarkRecorder::AddFrame(const BenchmarkFrame& Frame)
+{
+	Row R;
+	R.Frame = Frame;
+	R.Frame.Zones.clear();
+	R.ZoneMs.assign(Columns.size(), -1.0);
+
+	for (const BenchmarkZone& Zone : Frame.Zones)
+	{
+		size_t c = 0;
+		while (c < Columns.size() && (Columns[c].bGPU != Zone.bGPU || strcmp(Columns[c].Name, Zone.Name) != 0))
+			c++;
+
+		if (c == Columns.size())
+		{
+			Columns.push_back({ Zone.Name, Zone.bGPU, std::string(Zone.bGPU ? "gpu/" : "cpu/") + Zone.Name });
+			R.ZoneMs.push_back(-1.0);
+		}
+
+		// a zone entered several times in one frame counts with the sum.
+		R.ZoneMs[c] = std::max(R.ZoneMs[c], 0.0) + Zone.Ms;
+	}
+
+	Frames.push_back(std::move(R));
+}
+
+namespace
+{
+	const double kBytesToMB = 1.0 / (1024.0 * 1024.0);
+
+	BenchmarkRecorder::Stat MakeStat(const std::string& Name, std::vector<double> Samples)
+	{
+		const TimingStats Timing = ComputeTimingStats(Samples);
+
+		BenchmarkRecorder::Stat S;
+		S.Name = Name;
+		S.NumSamples = Timing.NumSamples;
+		S.AvgMs = Timing.AvgMs;
+		S.MinMs = Timing.MinMs;
+		S.P50Ms = Timing.P50Ms;
+		S.P95Ms = Timing.P95Ms;
+		S.P99Ms = Timing.P99Ms;
+		S.MaxMs = Timing.MaxMs;
+		return S;
+	}
+
+	// names are zone literals and file paths, only quotes and backslashes need escaping.
+	void WriteQuoted(std::ostream& Out, const std::string& Value)
+	{
+		Out << '"';
+		for (char c : Value)
+		{
+			if (c == '"' || c == '\\')
+				Out << '\\';
+			Out << c;
+		}
+		Out << '"';
+	}
+}
+
+std::vector<BenchmarkRecorder::Stat> BenchmarkRecorder::GetSummary() const
+{
+	std::vector<double> FrameMs, CPUMs, GPUMs, LatencyMs;
+	for (const Row& R : Frames)
+	{
+		FrameMs.push_back(R.Frame.FrameMs);
+		CPUMs.push_back(R.Frame.CPUMs);
+		GPUMs.push_back(R.Frame.GPUMs);
+		LatencyMs.push_back(R.Frame.LatencyMs);
+	}
+
+	std::vector<Stat> Summary;
+	Summary.push_back(MakeStat("frame", FrameMs));
+	Summary.push_back(MakeStat("cpu", CPUMs));
+	Summary.push_back(MakeStat("gpu", GPUMs));
+	Summary.push_back(MakeStat("latency", LatencyMs));
+
+	for (size_t c = 0; c < Columns.size(); c++)
+	{
+		std::vector<double> ZoneMs;
+		for (const Row& R : Frames)
+		{
+			if (c < R.ZoneMs.size() && R.ZoneMs[c] >= 0.0)
+				ZoneMs.push_back(R.ZoneMs[c]);
+		}
+		Summary.push_back(MakeStat(Columns[c].Label, ZoneMs));
+	}
+	return Summary;
+}
+
+void BenchmarkRecorder::WriteCSV(std::ostream& Out) const
+{
+	Out << "frame,frame_ms,cpu_ms,gpu_ms,latency_ms,process_mb,gpu_mb,streaming_mb";
+	for (const Column& C : Columns)
+		Out << ',' << C.Label;
+	Out << '\n';
+
+	Out << std::fixed << std::setprecision(3);
+	for (const Row& R : Frames)
+	{
+		const BenchmarkFrame& F = R.Frame;
+		Out << F.Frame << ',' << F.FrameMs << ',' << F.CPUMs << ',' << F.GPUMs << ',' << F.LatencyMs << ','
+			<< F.ProcessBytes * kBytesToMB << ',' << F.GPUBytes * kBytesToMB << ',' << F.StreamingBytes * kBytesToMB;
+		for (size_t c = 0; c < Columns.size(); c++)
+		{
+			Out << ',';
+			if (c < R.ZoneMs.size() && R.ZoneMs[c] >= 0.0)
+				Out << R.ZoneMs[c];
+		}
+		Out << '\n';
+	}
+	Out << std::defaultfloat;
+}
+
+void BenchmarkRecorder::WriteJSON(std::ostream& Out) const
+{
+	Out << std::fixed << std::setprecision(3);
+
+	Out << "{\n\"summary\":[";
+	bool bFirst = true;
+	for (const Stat& S : GetSummary())
+	{
+		Out << (bFirst ? "\n" : ",\n") << "{\"name\":";
+		WriteQuoted(Out, S.Name);
+		Out << ",\"samples\":" << S.NumSamples << ",\"avg_ms\":" << S.AvgMs << ",\"min_ms\":" << S.MinMs
+			<< ",\"p50_ms\":" << S.P50Ms << ",\"p95_ms\":" << S.P95Ms << ",\"p99_ms\":" << S.P99Ms << ",\"max_ms\":" << S.MaxMs << '}';
+		bFirst = false;
+	}
+
+	Out << "\n],\n\"frames\":[";
+	bFirst = true;
+	for (const Row& R : Frames)
+	{
+		const BenchmarkFrame& F = R.Frame;
+		Out << (bFirst ? "\n" : ",\n") << "{\"frame\":" << F.Frame << ",\"frame_ms\":" << F.FrameMs << ",\"cpu_ms\":" << F.CPUMs
+			<< ",\"gpu_ms\":" << F.GPUMs << ",\"latency_ms\":" << F.LatencyMs << ",\"process_mb\":" << F.ProcessBytes * kBytesToMB << ",\"gpu_mb\":" << F.GPUBytes * kBytesToMB
+			<< ",\"streaming_mb\":" << F.StreamingBytes * kBytesToMB << ",\"zones\":{";
+		bool bFirstZone = true;
+		for (size_t c = 0; c < Columns.size(); c++)
+		{
+			if (c >= R.ZoneMs.size() || R.ZoneMs[c] < 0.0)
+				continue;
+			Out << (bFirstZone ? "" : ",");
+			WriteQuoted(Out, Columns[c].Label);
+			Out << ':' << R.ZoneMs[c];
+			bFirstZone = false;
+		}
+		Out << "}}";
+		bFirst = false;
+	}
+	Out << "\n]\n}\n";
+
+	Out << std::defaultfloat;
+}
+
+bool BenchmarkRecorder::WriteFiles(const std::string& Prefix, std::string& Error) const
+{
+	const std::string Paths[] = { Prefix + ".csv", Prefix + ".json" };
+	for (int i = 0; i < 2; i++)
+	{
+		std::ofstream File(Paths[i], std::ios::binary);
+		if (!File)
+		{
+			Error = "can't open " + Paths[i];
+			return false;
+		}
+
+		if (i == 0)
+			WriteCSV(File);
+		else
+			WriteJSON(File);
+
+		if (!File)
+		{
+			Error = "can't write " + Paths[i];
+			return false;
+		}
+	}
+	return true;
+}
+
+void BenchmarkRecorder::WriteSummary(std::ostream& Out) const
+{
+	Out << std::fixed << std::setprecision(3);
+	Out << Frames.size() << " frames\n";
+	Out << std::left << std::setw(32) << "zone" << std::right
+		<< std::setw(10) << "avg" << std::setw(10) << "min" << std::setw(10) << "p50"
+		<< std::setw(10) << "p95" << std::setw(10) << "p99" << std::setw(10) << "max" << '\n';
+	for (const Stat& S : GetSummary())
+	{
+		Out << std::left << std::setw(32) << S.Name << std::right
+			<< std::setw(10) << S.AvgMs << std::setw(10) << S.MinMs << std::setw(10) << S.P50Ms
+			<< std::setw(10) << S.P95Ms << std::setw(10) << S.P99Ms << std::setw(10) << S.MaxMs << '\n';
+	}
+	Out << std::defaultfloat;
+}
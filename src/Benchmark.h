@@ -0,0 +1,134 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// deterministic benchmark runs. a recorded camera path drives the camera and the light with a fixed time
+// step for a fixed number of frames, the recorder keeps each frame's timings and memory and writes them
+// to csv and json for regression tracking.
+
+// one key of a camera path, Yaw and Pitch are the angles of SimpleCamera.
+struct CameraPathKey
+{
+	float Time = 0.f;
+	glm::vec3 Position = glm::vec3(0.f);
+	float Yaw = 0.f;
+	float Pitch = 0.f;
+	glm::vec3 LightDir = glm::vec3(0.f, 1.f, 0.f);
+	float LightIntensity = 1.f;
+};
+
+// keys in increasing time. the file has one key per line,
+//   time px py pz yaw pitch lx ly lz intensity
+// empty lines and lines starting with # are skipped.
+class CameraPath
+{
+public:
+	bool Parse(const std::string& Text, std::string& Error);
+	bool LoadFile(const std::string& Path, std::string& Error);
+
+	void Write(std::ostream& Out) const;
+	bool WriteFile(const std::string& Path, std::string& Error) const;
+
+	// a key earlier than the last one is dropped.
+	void AddKey(const CameraPathKey& Key);
+	void Clear() { Keys.clear(); }
+
+	const std::vector<CameraPathKey>& GetKeys() const { return Keys; }
+	float GetDuration() const { return Keys.empty() ? 0.f : Keys.back().Time - Keys.front().Time; }
+
+	// catmull-rom through the positions, linear angles and intensity, normalized lerp of the light
+	// direction. Time is clamped to the first and last key.
+	CameraPathKey Sample(float Time) const;
+
+private:
+	std::vector<CameraPathKey> Keys;
+};
+
+struct BenchmarkSettings
+{
+	bool bEnabled = false;
+	std::string PathFile;
+	std::string OutputPrefix = "Benchmark";
+	uint32_t NumFrames = 1000;
+	uint32_t NumWarmupFrames = 60;	// rendered at the first key, not recorded
+	double TimeStep = 1.0 / 60.0;
+};
+
+// -benchmark <path file> enables the mode, -benchmark_frames <n>, -benchmark_warmup <n>,
+// -benchmark_dt <seconds> and -benchmark_out <prefix> override the defaults. other arguments are ignored.
+bool ParseBenchmarkArgs(const std::vector<std::string>& Args, BenchmarkSettings& Out, std::string& Error);
+
+// a timed zone of one frame. Name has to outlive the recorder, zones are named with string literals.
+struct BenchmarkZone
+{
+	const char* Name;
+	bool bGPU;
+	double Ms;
+};
+
+struct BenchmarkFrame
+{
+	uint32_t Frame = 0;
+	double FrameMs = 0.0;	// wall time since the previous frame
+	double CPUMs = 0.0;		// main thread work
+	double GPUMs = 0.0;		// gpu zones lag the cpu by the frames in flight
+	double LatencyMs = 0.0;	// input sampled to present
+	uint64_t ProcessBytes = 0;
+	uint64_t GPUBytes = 0;
+	uint64_t StreamingBytes = 0;
+	std::vector<BenchmarkZone> Zones;
+};
+
+class BenchmarkRecorder
+{
+public:
+	struct Stat
+	{
+		std::string Name;
+		uint32_t NumSamples = 0;
+		double AvgMs = 0.0;
+		double MinMs = 0.0;
+		double P50Ms = 0.0;
+		double P95Ms = 0.0;
+		double P99Ms = 0.0;
+		double MaxMs = 0.0;
+	};
+
+	void Clear();
+	void AddFrame(const BenchmarkFrame& Frame);
+	size_t GetNumFrames() const { return Frames.size(); }
+
+	// frame, cpu, gpu time and latency first, then one column per zone in order of first appearance. a zone a
+	// frame didn't have stays empty.
+	void WriteCSV(std::ostream& Out) const;
+	// the summary and every frame.
+	void WriteJSON(std::ostream& Out) const;
+	// Prefix.csv and Prefix.json.
+	bool WriteFiles(const std::string& Prefix, std::string& Error) const;
+
+	// frame, cpu, gpu, latency, then the zones in column order.
+	std::vector<Stat> GetSummary() const;
+	void WriteSummary(std::ostream& Out) const;
+
+private:
+	struct Column
+	{
+		const char* Name;
+		bool bGPU;
+		std::string Label;
+	};
+
+	struct Row
+	{
+		BenchmarkFrame Frame;
+		std::vector<double> ZoneMs;		// per column, negative when missing
+	};
+
+	std::vector<Column> Columns;
+	std::vector<Row> Frames;
+};
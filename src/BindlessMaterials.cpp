@@ -0,0 +1,192 @@
+#include "BindlessMaterials.h"
+
+#include <algorithm>
+#include <cassert>
+
+void BindlessSlotAllocator::Init(uint32_t InCapacity, uint32_t InNumFramesInFlight)
+{
+	assert(InNumFramesInFlight > 0);
+	Capacity = InCapacity;
+	NumFramesInFlight = InNumFramesInFlight;
+	NumAllocated = 0;
+	Frame = 0;
+	NextUnused = 0;
+	Free.clear();
+	Retiring.clear();
+}
+
+uint32_t BindlessSlotAllocator::Allocate()
+{
+	uint32_t Slot;
+	if (!Free.empty())
+	{
+		// sorted descending, the lowest slot is at the back.
+		Slot = Free.back();
+		Free.pop_back();
+	}
+	else if (NextUnused < Capacity)
+	{
+		Slot = NextUnused++;
+	}
+	else
+	{
+		return kInvalidBindlessIndex;
+	}
+
+	NumAllocated++;
+	return Slot;
+}
+
+void BindlessSlotAllocator::Release(uint32_t Slot)
+{
+	assert(Slot < NextUnused && NumAllocated > 0);
+	NumAllocated--;
+	Retiring.push_back({ Slot, Frame + NumFramesInFlight });
+}
+
+void BindlessSlotAllocator::NewFrame(std::vector<uint32_t>* OutRecycled)
+{
+	Frame++;
+
+	// released in order, the slots that are due are at the front.
+	size_t NumDue = 0;
+	while (NumDue < Retiring.size() && Retiring[NumDue].FreeFrame <= Frame)
+	{
+		Free.push_back(Retiring[NumDue].Slot);
+		if (OutRecycled)
+			OutRecycled->push_back(Retiring[NumDue].Slot);
+		NumDue++;
+	}
+
+	if (NumDue == 0)
+		return;
+
+	Retiring.erase(Retiring.begin(), Retiring.begin() + NumDue);
+	std::sort(Free.begin(), Free.end(), [](uint32_t A, uint32_t B) { return A > B; });
+}
+
+void BindlessTextureRegistry::Init(uint32_t Capacity, uint32_t NumFramesInFlight)
+{
+	Slots.Init(Capacity, NumFramesInFlight);
+	Textures.assign(Capacity, nullptr);
+	RefCounts.assign(Capacity, 0);
+	SlotOfTexture.clear();
+	DirtySlots.clear();
+	bDirty.assign(Capacity, false);
+}
+
+uint32_t BindlessTextureRegistry::Register(void* Texture)
+{
+	if (!Texture)
+		return kInvalidBindlessIndex;
+
+	auto it = SlotOfTexture.find(Texture);
+	if (it != SlotOfTexture.end())
+	{
+		RefCounts[it->second]++;
+		return it->second;
+	}
+
+	const uint32_t Slot = Slots.Allocate();
+	if (Slot == kInvalidBindlessIndex)
+		return kInvalidBindlessIndex;
+
+	Textures[Slot] = Texture;
+	RefCounts[Slot] = 1;
+	SlotOfTexture[Texture] = Slot;
+	MarkDirty(Slot);
+	return Slot;
+}
+
+void BindlessTextureRegistry::Release(uint32_t Slot)
+{
+	assert(Slot < RefCounts.size() && RefCounts[Slot] > 0);
+	if (--RefCounts[Slot] > 0)
+		return;
+
+	// the entry keeps the texture until the slot is recycled, frames in flight may still sample it.
+	SlotOfTexture.erase(Textures[Slot]);
+	Slots.Release(Slot);
+}
+
+void BindlessTextureRegistry::NewFrame()
+{
+	Recycled.clear();
+	Slots.NewFrame(&Recycled);
+
+	for (uint32_t Slot : Recycled)
+	{
+		Textures[Slot] = nullptr;
+		MarkDirty(Slot);
+	}
+}
+
+void BindlessTextureRegistry::TakeDirtySlots(std::vector<uint32_t>& OutSlots)
+{
+	OutSlots.clear();
+	OutSlots.swap(DirtySlots);
+	for (uint32_t Slot : OutSlots)
+		bDirty[Slot] = false;
+}
+
+void BindlessTextureRegistry::MarkDirty(uint32_t Slot)
+{
+	if (bDirty[Slot])
+		return;
+
+	bDirty[Slot] = true;
+	DirtySlots.push_back(Slot);
+}
+
+void BindlessMaterialTable::Init(uint32_t MaxMaterials, uint32_t MaxTextures, uint32_t NumFramesInFlight)
+{
+	Materials.Init(MaxMaterials, NumFramesInFlight);
+	Textures.Init(MaxTextures, NumFramesInFlight);
+	MaterialData.clear();
+	Version++;
+}
+
+uint32_t BindlessMaterialTable::AddMaterial(void* const InTextures[4])
+{
+	const uint32_t Index = Materials.Allocate();
+	if (Index == kInvalidBindlessIndex)
+		return kInvalidBindlessIndex;
+
+	uint32_t TextureSlots[4];
+	for (int i = 0; i < 4; i++)
+	{
+		TextureSlots[i] = Textures.Register(InTextures[i]);
+		if (TextureSlots[i] == kInvalidBindlessIndex)
+		{
+			while (i-- > 0)
+				Textures.Release(TextureSlots[i]);
+			Materials.Release(Index);
+			return kInvalidBindlessIndex;
+		}
+	}
+
+	if (Index >= MaterialData.size())
+		MaterialData.resize(Index + 1, { kInvalidBindlessIndex, kInvalidBindlessIndex, kInvalidBindlessIndex, kInvalidBindlessIndex });
+	MaterialData[Index] = { TextureSlots[0], TextureSlots[1], TextureSlots[2], TextureSlots[3] };
+	Version++;
+	return Index;
+}
+
+void BindlessMaterialTable::RemoveMaterial(uint32_t Index)
+{
+	assert(Index < MaterialData.size() && MaterialData[Index].Albedo != kInvalidBindlessIndex);
+
+	BindlessMaterialData& Data = MaterialData[Index];
+	for (uint32_t Slot : { Data.Albedo, Data.Normal, Data.Roughness, Data.Metallic })
+		Textures.Release(Slot);
+
+	Data = { kInvalidBindlessIndex, kInvalidBindlessIndex, kInvalidBindlessIndex, kInvalidBindlessIndex };
+	Materials.Release(Index);
+	Version++;
+}
+
+void BindlessMaterialTable::NewFrame()
+{
+	Materials.NewFrame();
+	Textures.NewFrame();
+}
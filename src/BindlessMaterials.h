@@ -0,0 +1,124 @@
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// bindless gbuffer materials. every material texture has one slot in a shader visible table, registered
+// once, and a material is the slots of its four textures in a buffer of BindlessMaterialData. a draw only
+// passes the material index, GBuffer.hlsl with BINDLESS reads the slots and indexes the table.
+// textures are the backend's objects, opaque here.
+const uint32_t kMaxBindlessTextures = 1024;
+const uint32_t kMaxBindlessMaterials = 1024;
+const uint32_t kInvalidBindlessIndex = ~0u;
+
+// one per material, loaded as a uint4 by GBuffer.hlsl.
+struct BindlessMaterialData
+{
+	uint32_t Albedo;
+	uint32_t Normal;
+	uint32_t Roughness;
+	uint32_t Metallic;
+};
+
+static_assert(sizeof(BindlessMaterialData) == 16, "BindlessMaterialData is loaded as a uint4 by GBuffer.hlsl");
+
+// a released slot can still be read by the frames in flight, it's reused NumFramesInFlight NewFrame calls
+// later. free slots are handed out lowest first so the table stays compact.
+class BindlessSlotAllocator
+{
+public:
+	void Init(uint32_t InCapacity, uint32_t InNumFramesInFlight);
+
+	// kInvalidBindlessIndex when every slot is used or waits to be recycled.
+	uint32_t Allocate();
+	void Release(uint32_t Slot);
+
+	// appends the slots recycled this frame to OutRecycled if it isn't null.
+	void NewFrame(std::vector<uint32_t>* OutRecycled = nullptr);
+
+	uint32_t GetCapacity() const { return Capacity; }
+	uint32_t GetNumAllocated() const { return NumAllocated; }
+	uint32_t GetNumRetiring() const { return uint32_t(Retiring.size()); }
+
+private:
+	struct RetiringSlot
+	{
+		uint32_t Slot;
+		uint64_t FreeFrame;
+	};
+
+	uint32_t Capacity = 0;
+	uint32_t NumFramesInFlight = 0;
+	uint32_t NumAllocated = 0;
+	uint64_t Frame = 0;
+	// slots never handed out start at NextUnused, Free holds the recycled ones.
+	uint32_t NextUnused = 0;
+	std::vector<uint32_t> Free;
+	std::vector<RetiringSlot> Retiring;
+};
+
+// the texture table. a texture shared by several materials has one slot and a reference count. a texture
+// has to live until its slot is recycled.
+class BindlessTextureRegistry
+{
+public:
+	void Init(uint32_t Capacity, uint32_t NumFramesInFlight);
+
+	// the slot of Texture, kInvalidBindlessIndex when the table is full or Texture is null.
+	uint32_t Register(void* Texture);
+	void Release(uint32_t Slot);
+
+	void NewFrame();
+
+	void* GetTexture(uint32_t Slot) const { return Slot < Textures.size() ? Textures[Slot] : nullptr; }
+	uint32_t GetNumTextures() const { return uint32_t(SlotOfTexture.size()); }
+
+	// the slots whose texture changed since the last call, for the backend's table. a recycled slot reports
+	// a null texture.
+	void TakeDirtySlots(std::vector<uint32_t>& OutSlots);
+
+private:
+	void MarkDirty(uint32_t Slot);
+
+	BindlessSlotAllocator Slots;
+	std::vector<void*> Textures;
+	std::vector<uint32_t> RefCounts;
+	std::unordered_map<void*, uint32_t> SlotOfTexture;
+	std::vector<uint32_t> DirtySlots;
+	std::vector<bool> bDirty;
+	std::vector<uint32_t> Recycled;
+};
+
+// materials of the bindless gbuffer and the BindlessMaterialData the shader reads.
+class BindlessMaterialTable
+{
+public:
+	void Init(uint32_t MaxMaterials, uint32_t MaxTextures, uint32_t NumFramesInFlight);
+
+	// Textures are albedo, normal, roughness, metallic. returns the material index, kInvalidBindlessIndex
+	// when the material or the texture table is full. nothing stays registered on failure.
+	uint32_t AddMaterial(void* const Textures[4]);
+	void RemoveMaterial(uint32_t Index);
+
+	// once per frame, recycles the slots of what was removed NumFramesInFlight frames ago.
+	void NewFrame();
+
+	BindlessTextureRegistry& GetTextures() { return Textures; }
+	const BindlessTextureRegistry& GetTextures() const { return Textures; }
+
+	uint32_t GetNumMaterials() const { return Materials.GetNumAllocated(); }
+
+	// every index up to the highest one handed out, removed materials hold invalid slots.
+	const std::vector<BindlessMaterialData>& GetMaterialData() const { return MaterialData; }
+
+	// changes with every add and remove. a copy of the material buffer is current if it was written at
+	// this version.
+	uint64_t GetVersion() const { return Version; }
+
+private:
+	BindlessSlotAllocator Materials;
+	BindlessTextureRegistry Textures;
+	std::vector<BindlessMaterialData> MaterialData;
+	uint64_t Version = 0;
+};
@@ -0,0 +1,116 @@
+#include "BloomCPU.h"
+
+#include <algorithm>
+#include <cmath>
+
+// mips built in groupshared memory, the rest are built by the last group.
+static const uint32_t kSPDGroupMips = 7;
+
+uint32_t GetBloomMipCount(uint32_t Width, uint32_t Height, uint32_t MaxMips)
+{
+	uint32_t MinSize = std::max(std::min(Width, Height), 1u);
+	uint32_t NumMips = 1;
+	while ((MinSize >> NumMips) > 0)
+		NumMips++;
+	return std::min(std::min(NumMips, MaxMips), kSPDMaxMips);
+}
+
+static glm::vec4 Reduce(const glm::vec4& v0, const glm::vec4& v1, const glm::vec4& v2, const glm::vec4& v3)
+{
+	return (v0 + v1 + v2 + v3) * 0.25f;
+}
+
+static void DownsampleMip(const std::vector<glm::vec4>& Src, uint32_t SrcWidth, std::vector<glm::vec4>& Dst, uint32_t DstWidth, uint32_t DstHeight)
+{
+	Dst.resize(size_t(DstWidth) * DstHeight);
+	for (uint32_t y = 0; y < DstHeight; y++)
+	{
+		const glm::vec4* Row0 = &Src[size_t(y * 2) * SrcWidth];
+		const glm::vec4* Row1 = Row0 + SrcWidth;
+		for (uint32_t x = 0; x < DstWidth; x++)
+			Dst[size_t(y) * DstWidth + x] = Reduce(Row0[x * 2], Row0[x * 2 + 1], Row1[x * 2], Row1[x * 2 + 1]);
+	}
+}
+
+void SinglePassDownsampleCPU(std::vector<DenoiserImage>& Mips, uint32_t NumMips)
+{
+	if (Mips.empty())
+		return;
+
+	const DenoiserImage& Mip0 = Mips[0];
+	NumMips = std::min(NumMips, GetBloomMipCount(Mip0.Width, Mip0.Height, kSPDMaxMips));
+	Mips.resize(NumMips);
+
+	// full precision values of the previous mip, as kept in groupshared memory.
+	std::vector<glm::vec4> Prev = Mips[0].Texels;
+	std::vector<glm::vec4> Cur;
+
+	for (uint32_t Mip = 1; Mip < NumMips; Mip++)
+	{
+		const DenoiserImage& Upper = Mips[Mip - 1];
+		DenoiserImage& Dst = Mips[Mip];
+		Dst.Init(Upper.Width / 2, Upper.Height / 2, Mips[0].bHalf);
+
+		// past the groupshared mips the shader reads back the stored upper mip.
+		const std::vector<glm::vec4>& Src = Mip < kSPDGroupMips ? Prev : Upper.Texels;
+		DownsampleMip(Src, Upper.Width, Cur, Dst.Width, Dst.Height);
+
+		for (uint32_t y = 0; y < Dst.Height; y++)
+			for (uint32_t x = 0; x < Dst.Width; x++)
+				Dst.Store(x, y, Cur[size_t(y) * Dst.Width + x]);
+
+		std::swap(Prev, Cur);
+	}
+}
+
+void BloomUpsampleCPU(std::vector<DenoiserImage>& Mips, float BloomScatter)
+{
+	for (int Mip = int(Mips.size()) - 2; Mip >= 0; Mip--)
+	{
+		DenoiserImage& Dst = Mips[Mip];
+		const DenoiserImage& Src = Mips[Mip + 1];
+
+		auto LoadCoarse = [&Src](int x, int y)
+		{
+			x = std::min(std::max(x, 0), int(Src.Width) - 1);
+			y = std::min(std::max(y, 0), int(Src.Height) - 1);
+			return Src.Texels[size_t(y) * Src.Width + x];
+		};
+
+		const float ScaleX = float(Src.Width) / float(Dst.Width);
+		const float ScaleY = float(Src.Height) / float(Dst.Height);
+
+		for (uint32_t y = 0; y < Dst.Height; y++)
+		{
+			for (uint32_t x = 0; x < Dst.Width; x++)
+			{
+				const float CoordX = (x + 0.5f) * ScaleX - 0.5f;
+				const float CoordY = (y + 0.5f) * ScaleY - 0.5f;
+				const int BaseX = int(std::floor(CoordX));
+				const int BaseY = int(std::floor(CoordY));
+				const float FracX = CoordX - BaseX;
+				const float FracY = CoordY - BaseY;
+
+				glm::vec4 Block[4][4];
+				for (int by = 0; by < 4; by++)
+					for (int bx = 0; bx < 4; bx++)
+						Block[by][bx] = LoadCoarse(BaseX + bx - 1, BaseY + by - 1);
+
+				glm::vec4 Tent[2][2];
+				for (int ty = 0; ty < 2; ty++)
+				{
+					for (int tx = 0; tx < 2; tx++)
+					{
+						glm::vec4 Row0 = Block[ty][tx] + 2.f * Block[ty][tx + 1] + Block[ty][tx + 2];
+						glm::vec4 Row1 = Block[ty + 1][tx] + 2.f * Block[ty + 1][tx + 1] + Block[ty + 1][tx + 2];
+						glm::vec4 Row2 = Block[ty + 2][tx] + 2.f * Block[ty + 2][tx + 1] + Block[ty + 2][tx + 2];
+						Tent[ty][tx] = (Row0 + 2.f * Row1 + Row2) / 16.f;
+					}
+				}
+
+				glm::vec4 Upsampled = glm::mix(glm::mix(Tent[0][0], Tent[0][1], FracX), glm::mix(Tent[1][0], Tent[1][1], FracX), FracY);
+				Dst.Store(x, y, glm::mix(Dst.Load(x, y), Upsampled, BloomScatter));
+			}
+		}
+	}
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "GIDenoiserCPU.h"
+
+// most mips SinglePassDownsampleCS.hlsl can write in one dispatch. (4096 texels)
+const uint32_t kSPDMaxMips = 13;
+// SinglePassDownsampleCS.hlsl reduces a 64x64 tile of mip 0 per group.
+const uint32_t kSPDTileSize = 64;
+
+// number of mips of a bloom chain. the chain stops while the smaller side is still >= 1 texel
+// so every texel of a mip has its 4 sources inside the upper mip.
+uint32_t GetBloomMipCount(uint32_t Width, uint32_t Height, uint32_t MaxMips);
+
+// cpu reference of the bloom chain kernels, for checking gpu captures offline.
+// Mips[0] is the input, the other mips are resized to floor halved sizes.
+// mips 1..6 are reduced from full precision values like the groupshared path of the shader,
+// the mips after that from the stored mip 6. stores are rounded to fp16 when Mips[0].bHalf is set.
+void SinglePassDownsampleCPU(std::vector<DenoiserImage>& Mips, uint32_t NumMips);
+
+// BloomUpsampleCS.hlsl from the smallest mip up to mip 0. the bloom ends up in Mips[0].
+void BloomUpsampleCPU(std::vector<DenoiserImage>& Mips, float BloomScatter);
@@ -0,0 +1,156 @@
+#include "BlueNoise.h"
+
+#include <fstream>
+#include <cmath>
+#include <algorithm>
+
+static const uint32_t kBlueNoiseRawVersion = 1;
+static const uint32_t kMaxBlueNoiseDim = 4096;
+
+uint32_t GetBlueNoiseTexelSize(BlueNoiseFormat Format)
+{
+	return Format == BlueNoiseFormat::RGBA16_UNORM ? 8 : 4;
+}
+
+bool LoadBlueNoiseRaw(const std::string& Path, BlueNoiseFormat Format, BlueNoiseVolume& Volume, std::string& Error)
+{
+	std::ifstream file(Path.data(), std::ios::in | std::ios::binary);
+	if (!file.is_open())
+	{
+		Error = Path + " : can't open file";
+		return false;
+	}
+
+	file.seekg(0, file.end);
+	const uint64_t FileSize = uint64_t(file.tellg());
+	file.seekg(0, file.beg);
+
+	uint32_t Header[3] = {};
+	file.read(reinterpret_cast<char*>(Header), sizeof(Header));
+
+	const uint32_t Version = Header[0];
+	const uint32_t nChannel = Header[1];
+	const uint32_t nDimension = Header[2];
+
+	if (!file || Version != kBlueNoiseRawVersion)
+	{
+		Error = Path + " : unsupported version";
+		return false;
+	}
+	if (nChannel < 1 || nChannel > 4)
+	{
+		Error = Path + " : channel count must be between 1 and 4";
+		return false;
+	}
+	if (nDimension < 2 || nDimension > 3)
+	{
+		Error = Path + " : only 2d and 3d arrays are supported";
+		return false;
+	}
+
+	uint32_t Shape[3] = { 1, 1, 1 };
+	file.read(reinterpret_cast<char*>(Shape + (3 - nDimension)), sizeof(uint32_t) * nDimension);
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		if (!file || Shape[i] == 0 || Shape[i] > kMaxBlueNoiseDim)
+		{
+			Error = Path + " : invalid shape";
+			return false;
+		}
+	}
+
+	// channels are stored first, then the dimensions in reverse order. the last dimension is x.
+	const uint32_t Depth = Shape[0];
+	const uint32_t Height = Shape[1];
+	const uint32_t Width = Shape[2];
+	const uint64_t NumTexels = uint64_t(Width) * Height * Depth;
+
+	const uint64_t HeaderSize = sizeof(uint32_t) * (3 + nDimension);
+	if (FileSize != HeaderSize + NumTexels * nChannel * sizeof(uint32_t))
+	{
+		Error = Path + " : file size doesn't match the header";
+		return false;
+	}
+
+	const uint32_t TexelSize = GetBlueNoiseTexelSize(Format);
+	const double UnormMax = Format == BlueNoiseFormat::RGBA16_UNORM ? 65535.0 : 255.0;
+	const double MaxValue = double(std::max<uint64_t>(NumTexels - 1, 1));
+	const double Scale = UnormMax / MaxValue;
+
+	Volume.Format = Format;
+	Volume.Width = Width;
+	Volume.Height = Height;
+	Volume.Depth = Depth;
+	Volume.NumSourceChannels = nChannel;
+	Volume.RowPitch = Width * TexelSize;
+	Volume.SlicePitch = Volume.RowPitch * Height;
+	Volume.Data.assign(size_t(Volume.SlicePitch) * Depth, 0);
+
+	double MaxError = 0;
+
+	// one row at a time, quantized in place.
+	std::vector<uint32_t> Row(size_t(Width) * nChannel);
+	for (uint64_t y = 0; y < uint64_t(Height) * Depth; y++)
+	{
+		file.read(reinterpret_cast<char*>(Row.data()), Row.size() * sizeof(uint32_t));
+		if (!file)
+		{
+			Error = Path + " : unexpected end of file";
+			return false;
+		}
+
+		uint8_t* Dst = Volume.Data.data() + y * Volume.RowPitch;
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			for (uint32_t c = 0; c < nChannel; c++)
+			{
+				const uint32_t Value = Row[x * nChannel + c];
+				if (Value > MaxValue)
+				{
+					Error = Path + " : value out of range";
+					return false;
+				}
+
+				const uint32_t Quantized = uint32_t(Value * Scale + 0.5);
+				MaxError = std::max(MaxError, std::abs(Quantized / UnormMax - Value / MaxValue));
+
+				if (Format == BlueNoiseFormat::RGBA16_UNORM)
+					reinterpret_cast<uint16_t*>(Dst)[x * 4 + c] = uint16_t(Quantized);
+				else
+					Dst[x * 4 + c] = uint8_t(Quantized);
+			}
+		}
+	}
+
+	Volume.MaxQuantizationError = float(MaxError);
+
+	return true;
+}
+
+void MakeWhiteNoiseVolume(uint32_t Dim, BlueNoiseFormat Format, BlueNoiseVolume& Volume)
+{
+	const uint32_t TexelSize = GetBlueNoiseTexelSize(Format);
+
+	Volume.Format = Format;
+	Volume.Width = Dim;
+	Volume.Height = Dim;
+	Volume.Depth = Dim;
+	Volume.NumSourceChannels = 4;
+	Volume.RowPitch = Dim * TexelSize;
+	Volume.SlicePitch = Volume.RowPitch * Dim;
+	Volume.MaxQuantizationError = 0.f;
+	Volume.Data.resize(size_t(Volume.SlicePitch) * Dim);
+
+	// pcg hash of the texel and channel index.
+	for (uint32_t i = 0; i < Dim * Dim * Dim * 4; i++)
+	{
+		uint32_t State = i * 747796405u + 2891336453u;
+		uint32_t Word = ((State >> ((State >> 28u) + 4u)) ^ State) * 277803737u;
+		Word = (Word >> 22u) ^ Word;
+
+		if (Format == BlueNoiseFormat::RGBA16_UNORM)
+			reinterpret_cast<uint16_t*>(Volume.Data.data())[i] = uint16_t(Word >> 16);
+		else
+			Volume.Data[i] = uint8_t(Word >> 24);
+	}
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Loader for the *.raw blue noise volumes described in assets/bluenoise/RAWFileFormat.txt.
+// Values are quantized straight into a 4 channel unorm volume while the file is read, so the
+// full uint32 payload is never held in memory.
+enum class BlueNoiseFormat
+{
+	RGBA8_UNORM,
+	RGBA16_UNORM,
+};
+
+struct BlueNoiseVolume
+{
+	BlueNoiseFormat Format = BlueNoiseFormat::RGBA8_UNORM;
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	uint32_t Depth = 0;
+	uint32_t NumSourceChannels = 0;
+	uint32_t RowPitch = 0;
+	uint32_t SlicePitch = 0;
+
+	// largest |quantized - exact| in normalized units.
+	float MaxQuantizationError = 0.f;
+
+	std::vector<uint8_t> Data;
+};
+
+uint32_t GetBlueNoiseTexelSize(BlueNoiseFormat Format);
+
+// returns false and fills Error if the header is malformed or the file is truncated.
+bool LoadBlueNoiseRaw(const std::string& Path, BlueNoiseFormat Format, BlueNoiseVolume& Volume, std::string& Error);
+
+// a Dim^3 volume of hashed white noise for when no blue noise file is available.
+void MakeWhiteNoiseVolume(uint32_t Dim, BlueNoiseFormat Format, BlueNoiseVolume& Volume);
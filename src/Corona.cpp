@@ -12,6 +12,7 @@
 #include "stdafx.h"
 #include "Corona.h"
 #include "Utils.h"
+#include "BlueNoise.h"
 #include <iostream>
 #include <algorithm>
 #include <array>
@@ -19,7 +20,12 @@
 #include <fstream>
 #include <variant>
 #include <codecvt>
+#include <chrono>
+#include <functional>
 #include <dxgidebug.h>
+#include <psapi.h>
+#include "glm/gtc/matrix_access.hpp"
+#include "glm/gtc/packing.hpp"
 #include "assimp/include/Importer.hpp"
 #include "assimp/include/scene.h"
 #include "assimp/include/postprocess.h"
@@ -102,10 +108,22 @@ void Corona::SimpleDrawPass()
 	std::vector<GfxTexture*> Rendertargets = { backbuffer };
 	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), SimpleDrawPSO.get(), Rendertargets.size(), Rendertargets.data(), DepthBuffer.get());
 
+	ViewPort viewPort = { 0.0f, 0.0f, static_cast<float>(DisplayWidth), static_cast<float>(DisplayHeight), 0.0f, 1.0f };
+	AbstractGfxLayer::SetViewports(AbstractGfxLayer::GetGlobalCommandList(), 1, &viewPort);
 
+	Rect scissorRect = { 0, 0, static_cast<LONG>(DisplayWidth), static_cast<LONG>(DisplayHeight) };
+	AbstractGfxLayer::SetScissorRects(AbstractGfxLayer::GetGlobalCommandList(), 1, &scissorRect);
 
+	AbstractGfxLayer::SetPSO(SimpleDrawPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
 
+	SimpleDrawCB cb;
+	cb.ViewProjectionMatrix = glm::transpose(ViewProjMat);
+	cb.WorldMatrix = glm::mat4x4(1.0f);
+	AbstractGfxLayer::SetUniformValue(SimpleDrawPSO.get(), "SimpleDrawCB", &cb, AbstractGfxLayer::GetGlobalCommandList());
 
+	AbstractGfxLayer::SetPrimitiveTopology(AbstractGfxLayer::GetGlobalCommandList(), PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, SimpleDrawVB.get());
+	AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 3, 1, 0, 0);
 
 	{
 		std::array<ResourceTransition, 1> Transition = { {
@@ -130,6 +148,9 @@ void Corona::OnInit()
 {
 	//_CrtSetBreakAlloc(219);
 
+	CPUProfiler::Get().SetThreadName("Main");
+
+	InitBenchmark();
 
 	g_TS.Initialize(8);
 
@@ -177,6 +198,10 @@ void Corona::LoadAssets()
 	InitTemporalDenoisingPass();
 	InitBloomPass();
 	InitResolvePixelVelocityPass();
+	InitRayReconstructPass();
+	InitRayBudgetClassifyPass();
+	InitHiZReducePass();
+	InitGPUDrivenCullPass();
 
 #if USE_RTXGI
 	InitRTXGI();
@@ -297,6 +322,23 @@ void Corona::LoadAssets()
 		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RenderWidth, RenderHeight, 1));
 
 	NAME_TEXTURE(SpeculaGIMoments[1]);
+
+	// adaptive ray budget per tile
+	TileRayBudget = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture2D(FORMAT_R8_UINT,
+		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
+		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+		(RenderWidth + kRayBudgetTileSize - 1) / kRayBudgetTileSize, (RenderHeight + kRayBudgetTileSize - 1) / kRayBudgetTileSize, 1));
+
+	NAME_TEXTURE(TileRayBudget);
+
+	// hi-z occlusion culling
+	HiZReduceBuffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(kHiZWidth * kHiZHeight, sizeof(float), HEAP_TYPE_DEFAULT, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+	NAME_BUFFER(HiZReduceBuffer);
+
+	HiZReadbacks.resize(framebuffers.size());
+	for (HiZReadback& Readback : HiZReadbacks)
+		Readback.Buffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateReadbackBuffer(kHiZWidth * kHiZHeight * sizeof(float)));
+
 	// diffuse gi
 
 	DiffuseGISHRaw = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture2D(FORMAT_R16G16B16A16_FLOAT,
@@ -415,6 +457,8 @@ void Corona::LoadAssets()
 	DefaultNormalTex = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(L"assets/default/default_normal.png", true));
 	DefaultRougnessTex = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(L"assets/default/default_roughness.png", true));
 
+	InitTextureStreaming();
+
 	Sponza = LoadModel("assets/Sponza/Sponza.fbx");
 
 	ShaderBall = LoadModel("assets/shaderball/shaderBall.fbx");
@@ -422,6 +466,13 @@ void Corona::LoadAssets()
 	glm::mat4x4 scaleMat = glm::scale(glm::vec3(2.5, 2.5, 2.5));
 	glm::mat4x4 translatemat = glm::translate(glm::vec3(-150, 20, 0));
 	ShaderBall->SetTransform(scaleMat* translatemat );
+
+	// a row of shader balls along z sharing one mesh, drawn instanced.
+	for (UINT i = 1; i < NumShaderBallInstances; i++)
+	{
+		glm::mat4x4 offsetMat = glm::translate(glm::vec3(0, 0, 60.f * i));
+		ShaderBall->AddInstance(scaleMat * offsetMat * translatemat);
+	}
 	
 	//Buddha = LoadModel("buddha/buddha.obj");
 
@@ -477,39 +528,23 @@ void Corona::LoadAssets()
 
 	}
 
+	InitSceneBounds();
+
+	InitInstanceBuffers();
+
+	InitGPUDrivenScene();
+
+	InitBindlessMaterials();
+
 	InitRaytracingData();
 
+#if USE_RTXGI
+	PlaceRTXGIProbes();
+#endif
 }
 
 shared_ptr<Scene> Corona::LoadModel(string fileName)
 {
-	map<wstring, wstring> SponzaRoughnessMap = {
-	{L"Background_Albedo", L"Background_Roughness"},
-	{L"ChainTexture_Albedo", L"ChainTexture_Roughness"},
-	{L"Lion_Albedo", L"Lion_Roughness"},
-	{L"Sponza_Arch_diffuse", L"Sponza_Arch_roughness"},
-	{L"Sponza_Bricks_a_Albedo", L"Sponza_Bricks_a_Roughness"},
-	{L"Sponza_Ceiling_diffuse", L"Sponza_Ceiling_roughness"},
-	{L"Sponza_Column_a_diffuse", L"Sponza_Column_a_roughness"},
-	{L"Sponza_Column_b_diffuse", L"Sponza_Column_b_roughness"},
-	{L"Sponza_Column_c_diffuse", L"Sponza_Column_c_roughness"},
-	{L"Sponza_Curtain_Blue_diffuse", L"Sponza_Curtain_roughness"},
-	{L"Sponza_Curtain_Green_diffuse", L"Sponza_Curtain_roughness"},
-	{L"Sponza_Curtain_Red_diffuse", L"Sponza_Curtain_roughness"},
-	{L"Sponza_Details_diffuse", L"Sponza_Details_roughness"},
-	{L"Sponza_Fabric_Blue_diffuse", L"Sponza_Fabric_roughness"},
-	{L"Sponza_Fabric_Green_diffuse", L"Sponza_Fabric_roughness"},
-	{L"Sponza_Fabric_Red_diffuse", L"Sponza_Fabric_roughness"},
-	{L"Sponza_FlagPole_diffuse", L"Sponza_FlagPole_roughness"},
-	{L"Sponza_Floor_diffuse", L"Sponza_Floor_roughness"},
-	{L"Sponza_Roof_diffuse", L"Sponza_Roof_roughness"},
-	{L"Sponza_Thorn_diffuse", L"Sponza_Thorn_roughness"},
-	{L"Vase_diffuse", L"Vase_roughness"},
-	{L"VaseHanging_diffuse", L"VaseHanging_roughness"},
-	{L"VasePlant_diffuse", L"VasePlant_roughness"},
-	{L"VaseRound_diffuse", L"VaseRound_roughness"}
-	};
-
 	Scene* scene = new Scene;
 
 	Assimp::Importer importer;
@@ -521,6 +556,27 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 	wstring dir = GetDirectoryFromFilePath(wide.c_str());
 	//wstring dir = L"Sponza/";
 
+	// optional material table next to the model, Sponza.fbx -> Sponza.material.
+	MaterialLibrary Library;
+	{
+		string MaterialFile = fileName.substr(0, fileName.find_last_of('.')) + ".material";
+		string Error;
+		if (std::ifstream(MaterialFile).good() && !Library.LoadFile(MaterialFile, Error))
+			OutputDebugStringA((Error + "\n").c_str());
+	}
+
+	auto LoadTableTexture = [&](const string& Map, bool nonSRGB, shared_ptr<GfxTexture> placeholder) -> shared_ptr<GfxTexture>
+	{
+		if (Map.empty())
+			return nullptr;
+
+		wstring Path = dir + converter.from_bytes(Map);
+		if (!std::ifstream(Path).good())
+			return nullptr;
+
+		return LoadMaterialTexture(Path, nonSRGB, placeholder);
+	};
+
 	UINT flags = aiProcess_CalcTangentSpace |
 		aiProcess_Triangulate |
 		aiProcess_JoinIdenticalVertices |
@@ -539,23 +595,38 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 	{
 		const aiMaterial& aiMat = *assimpScene->mMaterials[i];
 		GfxMaterial* mat = new GfxMaterial;
+		mat->SortID = NumLoadedMaterials++;
 		wstring wDiffuseTex;
 		wstring wNormalTex;
-		wstring wRoughnessTex;
 		wstring wMetallicTex;
 
 
 		aiString diffuseTexPath;
 		aiString normalMapPath;
-		aiString rougnessMapPath;
 		aiString metallicMapPath;
 
 
 		if (aiMat.GetTexture(aiTextureType_DIFFUSE, 0, &diffuseTexPath) == aiReturn_SUCCESS)
 			wDiffuseTex = GetFileName(AnsiToWString(diffuseTexPath.C_Str()).c_str());
-		if (wDiffuseTex.length() != 0)
+
+		aiString matName;
+		aiMat.Get(AI_MATKEY_NAME, matName);
+		const MaterialDesc* desc = Library.Find(matName.C_Str());
+		if (!desc && wDiffuseTex.length() != 0)
+			desc = Library.FindByAlbedo(converter.to_bytes(wDiffuseTex));
+
+		if (desc)
 		{
-			mat->Diffuse = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(dir + wDiffuseTex, false));
+			mat->Diffuse = LoadTableTexture(desc->AlbedoMap, false, DefaultWhiteTex);
+			mat->Normal = LoadTableTexture(desc->NormalMap, true, DefaultNormalTex);
+			mat->Roughness = LoadTableTexture(desc->RoughnessMap, true, DefaultRougnessTex);
+			mat->Metallic = LoadTableTexture(desc->MetallicMap, true, DefaultBlackTex);
+			mat->bHasAlpha = desc->bAlphaTest;
+		}
+
+		if (!mat->Diffuse && wDiffuseTex.length() != 0)
+		{
+			mat->Diffuse = LoadMaterialTexture(dir + wDiffuseTex, false, DefaultWhiteTex);
 		}
 
 		if (!mat->Diffuse)
@@ -565,9 +636,9 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 			|| aiMat.GetTexture(aiTextureType_HEIGHT, 0, &normalMapPath) == aiReturn_SUCCESS)
 			wNormalTex = GetFileName(AnsiToWString(normalMapPath.C_Str()).c_str());
 
-		if (wNormalTex.length() != 0)
+		if (!mat->Normal && wNormalTex.length() != 0)
 		{
-			mat->Normal = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(dir + wNormalTex, true));
+			mat->Normal = LoadMaterialTexture(dir + wNormalTex, true, DefaultNormalTex);
 		}
 
 		if (!mat->Normal)
@@ -575,34 +646,19 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 
 		if (aiMat.GetTexture(aiTextureType_AMBIENT, 0, &metallicMapPath) == aiReturn_SUCCESS)
 			wMetallicTex = GetFileName(AnsiToWString(metallicMapPath.C_Str()).c_str());
-		if (wMetallicTex.length() != 0)
+		if (!mat->Metallic && wMetallicTex.length() != 0)
 		{
-			mat->Metallic = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(dir + wMetallicTex, true));
+			mat->Metallic = LoadMaterialTexture(dir + wMetallicTex, true, DefaultBlackTex);
 		}
 
 		if (!mat->Metallic)
 			mat->Metallic = DefaultBlackTex;
 		
-		if (wDiffuseTex.length() != 0)
-		{
-			wstring wNameStr = wstring(wDiffuseTex.substr(0, wDiffuseTex.length() - 4));
-			map<wstring, wstring> ::iterator it = SponzaRoughnessMap.find(wNameStr);
-			if (it != SponzaRoughnessMap.end())
-			{
-				wRoughnessTex = SponzaRoughnessMap[wNameStr] + L".png";
-				mat->Roughness = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(dir + wRoughnessTex, true));
-			}
-		}
-
 		if (!mat->Roughness)
 		{
 			mat->Roughness = DefaultRougnessTex;
 		}
 
-		// HACK!
-		if (wDiffuseTex == L"Sponza_Thorn_diffuse.png" || wDiffuseTex == L"VasePlant_diffuse.png" || wDiffuseTex == L"ChainTexture_Albedo.png")
-			mat->bHasAlpha = true;
-
 		scene->Materials.push_back(shared_ptr<GfxMaterial>(mat));
 	}
 
@@ -644,6 +700,11 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 				scene->AABBMax = glm::max(scene->AABBMax, vertices[i].Position);
 				scene->BoundingRadius = glm::max(scene->BoundingRadius, glm::length(scene->AABBMin));
 				scene->BoundingRadius = glm::max(scene->BoundingRadius, glm::length(scene->AABBMax));
+
+				if (i == 0)
+					mesh->AABBMin = mesh->AABBMax = vertices[i].Position;
+				mesh->AABBMin = glm::min(mesh->AABBMin, vertices[i].Position);
+				mesh->AABBMax = glm::max(mesh->AABBMax, vertices[i].Position);
 			}
 		}
 
@@ -684,6 +745,30 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 			indices[triIdx * 3 + 2] = UINT16(asMesh->mFaces[triIdx].mIndices[2]);
 		}
 
+		// average uv density, used to pick the mip a texture needs at a given distance.
+		double WorldArea = 0;
+		double UVArea = 0;
+		for (int triIdx = 0; triIdx < numTriangles; ++triIdx)
+		{
+			const MeshVertex& v0 = vertices[indices[triIdx * 3 + 0]];
+			const MeshVertex& v1 = vertices[indices[triIdx * 3 + 1]];
+			const MeshVertex& v2 = vertices[indices[triIdx * 3 + 2]];
+
+			WorldArea += glm::length(glm::cross(v1.Position - v0.Position, v2.Position - v0.Position)) * 0.5;
+			glm::vec2 uv1 = v1.UV - v0.UV;
+			glm::vec2 uv2 = v2.UV - v0.UV;
+			UVArea += glm::abs(uv1.x * uv2.y - uv1.y * uv2.x) * 0.5;
+		}
+
+		mesh->CPUPositions.resize(vertices.size());
+		mesh->CPUNormals.resize(vertices.size());
+		for (size_t v = 0; v < vertices.size(); v++)
+		{
+			mesh->CPUPositions[v] = vertices[v].Position;
+			mesh->CPUNormals[v] = vertices[v].Normal;
+		}
+		mesh->CPUIndices = indices;
+
 		mesh->Vb = shared_ptr<GfxVertexBuffer>(AbstractGfxLayer::CreateVertexBuffer(sizeof(MeshVertex) * mesh->NumVertices, sizeof(MeshVertex), vertices.data()));
 
 		mesh->VertexStride = sizeof(MeshVertex);
@@ -691,12 +776,25 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 
 		mesh->Ib = shared_ptr<GfxIndexBuffer>(AbstractGfxLayer::CreateIndexBuffer(mesh->IndexFormat, sizeof(UINT16)*3*numTriangles, indices.data()));
 
+		GPUScene.AddGeometry(mesh->NumVertices, mesh->NumIndices, mesh->MergedBaseVertex, mesh->MergedStartIndex);
+		MergedVertices.insert(MergedVertices.end(), vertices.begin(), vertices.end());
+		MergedIndices.insert(MergedIndices.end(), indices.begin(), indices.end());
+
 
 		GfxMesh::DrawCall dc;
 		dc.IndexCount = numTriangles * 3;
 		dc.IndexStart = 0;
 		dc.VertexBase = 0;
 		dc.VertexCount = vertices.size();
+		dc.UVDensity = WorldArea > 0 ? float(glm::sqrt(UVArea / WorldArea)) : 0.f;
+		for (UINT idx = dc.IndexStart; idx < dc.IndexStart + dc.IndexCount; idx++)
+		{
+			const glm::vec3& Position = vertices[dc.VertexBase + indices[idx]].Position;
+			if (idx == dc.IndexStart)
+				dc.AABBMin = dc.AABBMax = Position;
+			dc.AABBMin = glm::min(dc.AABBMin, Position);
+			dc.AABBMax = glm::max(dc.AABBMax, Position);
+		}
 		dc.mat = scene->Materials[asMesh->mMaterialIndex];
 		if (dc.mat->bHasAlpha) mesh->bTransparent = true;
 		
@@ -705,11 +803,429 @@ shared_ptr<Scene> Corona::LoadModel(string fileName)
 		scene->meshes.push_back(shared_ptr<GfxMesh>(mesh));
 	}
 
+	// the vertices are already in world space.
+	scene->Instances.Add(glm::mat4x4(1.f));
+
 	shared_ptr<Scene> scenePtr = shared_ptr<Scene>(scene);
 
 	return scenePtr;
 }
 
+void Corona::InitTextureStreaming()
+{
+	TexStreamer.BudgetBytes = UINT64(TextureStreamingBudgetMB) * 1024 * 1024;
+
+	TexStreamer.Init(
+		[](const TextureStreamer::Request& Req) -> shared_ptr<void>
+		{
+			return shared_ptr<GfxTextureMipData>(AbstractGfxLayer::LoadStreamingTextureMips(static_cast<GfxTexture*>(Req.UserData), Req.FirstMip));
+		},
+		[](const TextureStreamer::Request& Req, shared_ptr<void> Data)
+		{
+			return AbstractGfxLayer::UpdateStreamingTexture(static_cast<GfxTexture*>(Req.UserData), static_cast<GfxTextureMipData*>(Data.get()), Req.FirstMip);
+		},
+		[](const TextureStreamer::Request& Req)
+		{
+			return AbstractGfxLayer::TrimStreamingTexture(static_cast<GfxTexture*>(Req.UserData), Req.FirstMip);
+		});
+}
+
+shared_ptr<GfxTexture> Corona::LoadMaterialTexture(wstring fileName, bool nonSRGB, shared_ptr<GfxTexture> placeholder)
+{
+	if (bTextureStreaming)
+	{
+		UINT Width;
+		UINT Height;
+		vector<UINT64> MipBytes;
+		GfxTexture* tex = AbstractGfxLayer::CreateStreamingTexture(fileName, nonSRGB, placeholder.get(), Width, Height, MipBytes);
+		if (tex)
+		{
+			StreamingTextureInfo& Info = StreamingTextureInfos[tex];
+			Info.ID = TexStreamer.Register(Width, Height, MipBytes, tex);
+			Info.Log2Dim = glm::log2(float(glm::max(Width, Height)));
+			return shared_ptr<GfxTexture>(tex);
+		}
+	}
+
+	return shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTextureFromFile(fileName, nonSRGB));
+}
+
+void Corona::UpdateTextureStreaming()
+{
+	ProfileCPUScope("UpdateTextureStreaming");
+
+	TexStreamer.BudgetBytes = UINT64(TextureStreamingBudgetMB) * 1024 * 1024;
+
+	// side planes of the unjittered frustum.
+	glm::vec4 Planes[4];
+	for (int i = 0; i < 4; i++)
+	{
+		glm::vec4 Row = glm::row(UnjitteredViewProjMat, i / 2);
+		glm::vec4 W = glm::row(UnjitteredViewProjMat, 3);
+		Planes[i] = (i % 2 == 0) ? W + Row : W - Row;
+	}
+
+	// screen space footprint. size of a pixel at unit distance, and the -1 lod bias of the wrap sampler.
+	const float PixelSizeAtUnitDist = 2.0f * glm::tan(Fov * 0.5f) / RenderHeight;
+	const float MipBias = -1.0f;
+	const glm::vec3 CameraPos = m_camera.m_position;
+
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		if (!scene)
+			continue;
+
+		for (auto& mesh : scene->meshes)
+		{
+			glm::vec3 WorldMin = glm::vec3(FLT_MAX);
+			glm::vec3 WorldMax = glm::vec3(-FLT_MAX);
+			for (int c = 0; c < 8; c++)
+			{
+				glm::vec3 Corner = glm::vec3((c & 1) ? mesh->AABBMax.x : mesh->AABBMin.x, (c & 2) ? mesh->AABBMax.y : mesh->AABBMin.y, (c & 4) ? mesh->AABBMax.z : mesh->AABBMin.z);
+				Corner = glm::vec3(mesh->transform * glm::vec4(Corner, 1));
+				WorldMin = glm::min(WorldMin, Corner);
+				WorldMax = glm::max(WorldMax, Corner);
+			}
+
+			bool bVisible = true;
+			for (auto& Plane : Planes)
+			{
+				glm::vec3 Positive = glm::vec3(Plane.x > 0 ? WorldMax.x : WorldMin.x, Plane.y > 0 ? WorldMax.y : WorldMin.y, Plane.z > 0 ? WorldMax.z : WorldMin.z);
+				if (glm::dot(glm::vec3(Plane), Positive) + Plane.w < 0)
+					bVisible = false;
+			}
+			if (!bVisible)
+				continue;
+
+			const float Scale = glm::length(glm::vec3(mesh->transform[0]));
+			const float Dist = glm::max(glm::distance(CameraPos, glm::clamp(CameraPos, WorldMin, WorldMax)), Near);
+			const float WorldPerPixel = Dist * PixelSizeAtUnitDist;
+
+			for (auto& dc : mesh->Draws)
+			{
+				if (dc.UVDensity <= 0.f)
+					continue;
+
+				const float BaseMip = glm::log2(WorldPerPixel * dc.UVDensity / Scale) + MipBias;
+
+				GfxTexture* Textures[] = { dc.mat->Diffuse.get(), dc.mat->Normal.get(), dc.mat->Roughness.get(), dc.mat->Metallic.get() };
+				for (auto& tex : Textures)
+				{
+					auto it = StreamingTextureInfos.find(tex);
+					if (it != StreamingTextureInfos.end())
+						TexStreamer.ReportMipUsage(it->second.ID, BaseMip + it->second.Log2Dim, FrameCounter);
+				}
+			}
+		}
+	}
+
+	TexStreamer.Update(FrameCounter);
+}
+
+void Corona::InitSceneBounds()
+{
+	SceneBounds.Clear();
+
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		if (!scene)
+			continue;
+
+		for (auto& mesh : scene->meshes)
+		{
+			for (auto& dc : mesh->Draws)
+			{
+				// one instanced draw covers every instance, it is culled with the union of their bounds.
+				glm::vec3 WorldMin, WorldMax;
+				scene->Instances.TransformBounds(dc.AABBMin, dc.AABBMax, WorldMin, WorldMax);
+				dc.CullIndex = SceneBounds.Add(WorldMin, WorldMax);
+			}
+		}
+	}
+
+	DrawVisibility.assign(SceneBounds.Count, 1);
+}
+
+void Corona::InitInstanceBuffers()
+{
+	NumInstanceSlots = 0;
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		if (!scene)
+			continue;
+
+		scene->InstanceBase = NumInstanceSlots;
+		NumInstanceSlots += scene->Instances.Size();
+	}
+
+	vector<glm::mat4x4> Transforms(NumInstanceSlots);
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		if (!scene)
+			continue;
+
+		uint32_t First, End;
+		scene->Instances.MarkAllDirty();
+		scene->Instances.PackDirty(reinterpret_cast<uint8_t*>(&Transforms[scene->InstanceBase]), sizeof(glm::mat4x4), First, End);
+	}
+
+	InstanceTransformBuffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(NumInstanceSlots * sizeof(glm::mat4x4) / sizeof(UINT32), sizeof(UINT32),
+		HEAP_TYPE_DEFAULT, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_FLAG_NONE, Transforms.data()));
+	NAME_BUFFER(InstanceTransformBuffer);
+
+	InstanceStagingBuffers.resize(framebuffers.size());
+	for (auto& Buffer : InstanceStagingBuffers)
+		Buffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(NumInstanceSlots * sizeof(glm::mat4x4) / sizeof(UINT32), sizeof(UINT32),
+			HEAP_TYPE_UPLOAD, RESOURCE_STATE_GENERIC_READ, RESOURCE_FLAG_NONE));
+}
+
+void Corona::UploadInstanceTransforms()
+{
+	// BeginFrame waited for the frame that last copied from this buffer. only the dirty range of each
+	// scene is written and copied, the rest of the staging buffer is stale and never read.
+	GfxBuffer* Staging = InstanceStagingBuffers[AbstractGfxLayer::GetCurrentFrameIndex()].get();
+
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		if (!scene || scene->Instances.GetNumDirty() == 0)
+			continue;
+
+		uint8_t* pStaging = nullptr;
+		AbstractGfxLayer::MapBuffer(Staging, reinterpret_cast<void**>(&pStaging));
+
+		uint32_t First, End;
+		scene->Instances.PackDirty(pStaging + scene->InstanceBase * sizeof(glm::mat4x4), sizeof(glm::mat4x4), First, End);
+
+		AbstractGfxLayer::UnmapBuffer(Staging);
+
+		const UINT64 Offset = (scene->InstanceBase + First) * sizeof(glm::mat4x4);
+		const UINT64 Size = (End - First) * sizeof(glm::mat4x4);
+
+		{
+			std::array<ResourceTransition, 1> Transition = { {
+				{InstanceTransformBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_COPY_DEST},
+			} };
+			AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+		}
+
+		AbstractGfxLayer::CopyBufferRegion(AbstractGfxLayer::GetGlobalCommandList(), InstanceTransformBuffer.get(), Offset, Staging, Offset, Size);
+
+		{
+			std::array<ResourceTransition, 1> Transition = { {
+				{InstanceTransformBuffer.get(), RESOURCE_STATE_COPY_DEST, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
+			} };
+			AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+		}
+	}
+}
+
+void Corona::CullScene()
+{
+	ProfileCPUScope("CullScene");
+
+	if (!bOcclusionCulling)
+	{
+		SceneHiZ.Invalidate();
+		for (HiZReadback& Readback : HiZReadbacks)
+			Readback.bValid = false;
+	}
+	else
+	{
+		// BeginFrame waited for the frame that last used this slot, its copy is done.
+		HiZReadback& Readback = HiZReadbacks[AbstractGfxLayer::GetCurrentFrameIndex()];
+		if (Readback.bValid)
+		{
+			float* pDepth = nullptr;
+			AbstractGfxLayer::MapBuffer(Readback.Buffer.get(), reinterpret_cast<void**>(&pDepth));
+			SceneHiZ.Build(pDepth, kHiZWidth, kHiZHeight, Readback.ViewProj);
+			AbstractGfxLayer::UnmapBuffer(Readback.Buffer.get());
+			Readback.bValid = false;
+		}
+	}
+
+	if (!bFrustumCulling)
+	{
+		DrawVisibility.assign(SceneBounds.Count, 1);
+		SceneCullingStats = CullingStats();
+		SceneCullingStats.NumTested = SceneCullingStats.NumVisible = SceneBounds.Count;
+		return;
+	}
+
+	CullCPU(SceneBounds, ViewProjMat, bOcclusionCulling ? &SceneHiZ : nullptr, DrawVisibility, SceneCullingStats, &g_TS);
+}
+
+void Corona::InitGPUDrivenScene()
+{
+	GPUScene.ClearDraws();
+
+	MaterialTextureTable = shared_ptr<GfxTextureTable>(AbstractGfxLayer::CreateTextureTable(kMaxMaterialTextures));
+	if (!MaterialTextureTable)
+		return;
+
+	// the DrawID is the position in this walk. every instance gets its own draws so they are culled one by
+	// one, the scene index picks the roughness sliders of GPUDrivenSceneCB.
+	map<GfxMaterial*, uint32_t> MaterialIndices;
+	const shared_ptr<Scene> Scenes[kMaxGPUDrivenScenes] = { Sponza, ShaderBall };
+	for (uint32_t SceneIndex = 0; SceneIndex < kMaxGPUDrivenScenes; SceneIndex++)
+	{
+		const shared_ptr<Scene>& scene = Scenes[SceneIndex];
+		if (!scene)
+			continue;
+
+		for (UINT Instance = 0; Instance < scene->Instances.Size(); Instance++)
+		{
+			const glm::mat4x4 WorldMatrix = scene->Instances.Get(Instance);
+			for (auto& mesh : scene->meshes)
+			{
+				for (auto& dc : mesh->Draws)
+				{
+					uint32_t MaterialIndex;
+					auto it = MaterialIndices.find(dc.mat.get());
+					if (it == MaterialIndices.end())
+					{
+						MaterialIndex = GPUScene.AddMaterial();
+						MaterialIndices.emplace(dc.mat.get(), MaterialIndex);
+
+						if (MaterialIndex < kMaxGPUDrivenMaterials)
+						{
+							GfxTexture* Textures[kTexturesPerMaterial] = { dc.mat->Diffuse.get(), dc.mat->Normal.get(), dc.mat->Roughness.get(), dc.mat->Metallic.get() };
+							for (uint32_t i = 0; i < kTexturesPerMaterial; i++)
+								AbstractGfxLayer::SetTextureTableEntry(MaterialTextureTable.get(), MaterialIndex * kTexturesPerMaterial + i, Textures[i]);
+						}
+					}
+					else
+					{
+						MaterialIndex = it->second;
+					}
+
+					GPUDrawData Data = {};
+					Data.InstanceIndex = scene->InstanceBase + Instance;
+					Data.MaterialIndex = MaterialIndex;
+					Data.SceneIndex = SceneIndex;
+
+					glm::vec3 WorldMin, WorldMax;
+					TransformBounds(WorldMatrix, dc.AABBMin, dc.AABBMax, WorldMin, WorldMax);
+					GPUScene.AddDraw(Data, WorldMin, WorldMax, dc.IndexCount, mesh->MergedStartIndex + dc.IndexStart, int32_t(mesh->MergedBaseVertex + dc.VertexBase));
+				}
+			}
+		}
+	}
+
+	string Error;
+	if (!GPUScene.Validate(&Error))
+	{
+		OutputDebugStringA(("GPU driven gbuffer disabled, " + Error + "\n").c_str());
+		bGPUDrivenGBuffer = false;
+		vector<MeshVertex>().swap(MergedVertices);
+		vector<UINT16>().swap(MergedIndices);
+		return;
+	}
+
+	MergedVb = shared_ptr<GfxVertexBuffer>(AbstractGfxLayer::CreateVertexBuffer(sizeof(MeshVertex) * MergedVertices.size(), sizeof(MeshVertex), MergedVertices.data()));
+	MergedIb = shared_ptr<GfxIndexBuffer>(AbstractGfxLayer::CreateIndexBuffer(FORMAT_R16_UINT, sizeof(UINT16) * MergedIndices.size(), MergedIndices.data()));
+
+	vector<MeshVertex>().swap(MergedVertices);
+	vector<UINT16>().swap(MergedIndices);
+
+	const UINT NumDraws = GPUScene.GetNumDraws();
+
+	vector<GPUDrawRecord> Records = GPUScene.GetRecords();
+	GPUDrawRecords = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(NumDraws * sizeof(GPUDrawRecord) / sizeof(UINT32), sizeof(UINT32),
+		HEAP_TYPE_DEFAULT, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, RESOURCE_FLAG_NONE, Records.data()));
+	NAME_BUFFER(GPUDrawRecords);
+
+	vector<GPUDrawData> DrawData = GPUScene.GetDrawData();
+	GPUDrawDataBuffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(NumDraws * sizeof(GPUDrawData) / sizeof(UINT32), sizeof(UINT32),
+		HEAP_TYPE_DEFAULT, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_FLAG_NONE, DrawData.data()));
+	NAME_BUFFER(GPUDrawDataBuffer);
+
+	// indirect arguments between frames, unordered access only during GPUDrivenCullPass.
+	GPUDrawCommands = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(NumDraws * sizeof(GPUDrawCommand) / sizeof(UINT32), sizeof(UINT32),
+		HEAP_TYPE_DEFAULT, RESOURCE_STATE_INDIRECT_ARGUMENT, RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+	NAME_BUFFER(GPUDrawCommands);
+
+	GPUDrawCount = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(1, sizeof(UINT32),
+		HEAP_TYPE_DEFAULT, RESOURCE_STATE_INDIRECT_ARGUMENT, RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
+	NAME_BUFFER(GPUDrawCount);
+}
+
+bool Corona::IsGPUDrivenGBuffer()
+{
+	// the merged buffers and every pso of the path have to exist, InitGPUDrivenScene bails out on invalid draws.
+	return bGPUDrivenGBuffer && MergedVb && GBufferIndirectPSO && GBufferCommandSignature && GPUDrivenCullPSO && ClearDrawCountPSO;
+}
+
+void Corona::InitBindlessMaterials()
+{
+	// the texture table is dx12 only for now, the other backends keep the srvs per draw.
+	BindlessTextureTable = shared_ptr<GfxTextureTable>(AbstractGfxLayer::CreateTextureTable(kMaxBindlessTextures));
+	if (!BindlessTextureTable)
+		return;
+
+	BindlessMaterials.Init(kMaxBindlessMaterials, kMaxBindlessTextures, UINT(framebuffers.size()));
+
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		if (!scene)
+			continue;
+
+		for (auto& mesh : scene->meshes)
+		{
+			for (auto& dc : mesh->Draws)
+			{
+				GfxMaterial* mat = dc.mat.get();
+				if (mat->BindlessIndex != kInvalidBindlessIndex)
+					continue;
+
+				void* Textures[4] = { mat->Diffuse.get(), mat->Normal.get(), mat->Roughness.get(), mat->Metallic.get() };
+				mat->BindlessIndex = BindlessMaterials.AddMaterial(Textures);
+				if (mat->BindlessIndex == kInvalidBindlessIndex)
+				{
+					OutputDebugStringA("bindless gbuffer disabled, the material or texture table is full\n");
+					bBindlessGBuffer = false;
+					BindlessTextureTable.reset();
+					return;
+				}
+			}
+		}
+	}
+
+	BindlessMaterialBuffers.resize(framebuffers.size());
+	for (auto& Buffer : BindlessMaterialBuffers)
+		Buffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(kMaxBindlessMaterials * sizeof(BindlessMaterialData) / sizeof(UINT32), sizeof(UINT32),
+			HEAP_TYPE_UPLOAD, RESOURCE_STATE_GENERIC_READ, RESOURCE_FLAG_NONE));
+	BindlessMaterialVersions.assign(framebuffers.size(), ~0ull);
+}
+
+void Corona::UpdateBindlessMaterials()
+{
+	BindlessMaterials.NewFrame();
+
+	// the table keeps a copy per frame in flight and rewrites the changed entries when it's bound.
+	BindlessTextureRegistry& Textures = BindlessMaterials.GetTextures();
+	Textures.TakeDirtySlots(BindlessDirtySlots);
+	for (uint32_t Slot : BindlessDirtySlots)
+		AbstractGfxLayer::SetTextureTableEntry(BindlessTextureTable.get(), Slot, static_cast<GfxTexture*>(Textures.GetTexture(Slot)));
+
+	// BeginFrame waited for the frame that last read this copy.
+	const UINT FrameIndex = AbstractGfxLayer::GetCurrentFrameIndex();
+	if (BindlessMaterialVersions[FrameIndex] == BindlessMaterials.GetVersion())
+		return;
+
+	const vector<BindlessMaterialData>& Data = BindlessMaterials.GetMaterialData();
+	void* pData = nullptr;
+	AbstractGfxLayer::MapBuffer(BindlessMaterialBuffers[FrameIndex].get(), &pData);
+	memcpy(pData, Data.data(), Data.size() * sizeof(BindlessMaterialData));
+	AbstractGfxLayer::UnmapBuffer(BindlessMaterialBuffers[FrameIndex].get());
+
+	BindlessMaterialVersions[FrameIndex] = BindlessMaterials.GetVersion();
+}
+
+bool Corona::IsBindlessGBuffer()
+{
+	return bBindlessGBuffer && GBufferBindlessPSO && BindlessTextureTable && !BindlessMaterialBuffers.empty();
+}
+
 void Corona::InitSpatialDenoisingPass()
 {
 	SHADER_CREATE_DESC csDesc =
@@ -808,6 +1324,10 @@ void Corona::InitTemporalDenoisingPass()
 
 void Corona::InitBloomPass()
 {
+	BloomBufferWidth = glm::max(RenderWidth / 2, 1u);
+	BloomBufferHeight = glm::max(RenderHeight / 2, 1u);
+	BloomNumMips = GetBloomMipCount(BloomBufferWidth, BloomBufferHeight, BloomMaxMips);
+
 	{
 		SHADER_CREATE_DESC csDesc =
 		{
@@ -835,23 +1355,42 @@ void Corona::InitBloomPass()
 	{
 		SHADER_CREATE_DESC csDesc =
 		{
-			GetAssetFullPath(L"Shaders\\"),		L"BloomBlur.hlsl", L"BloomBlur", L"cs_6_0", nullopt
+			GetAssetFullPath(L"Shaders\\"),		L"SinglePassDownsampleCS.hlsl", L"SinglePassDownsample", L"cs_6_0", nullopt
+		};
+
+		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+
+		computePsoDesc.csDesc = &csDesc;
+
+		GfxPipelineStateObject* TEMP_SinglePassDownsamplePSO = AbstractGfxLayer::CreatePSO();
+
+		AbstractGfxLayer::BindUAV(TEMP_SinglePassDownsamplePSO, "Mips", 0, kSPDMaxMips);
+		AbstractGfxLayer::BindUAV(TEMP_SinglePassDownsamplePSO, "AtomicCounter", kSPDMaxMips);
+		AbstractGfxLayer::BindCBV(TEMP_SinglePassDownsamplePSO, "DownsampleCB", 0, sizeof(DownsampleCB));
+
+		bool bSucess = AbstractGfxLayer::InitPSO(TEMP_SinglePassDownsamplePSO, &computePsoDesc);
+		if (bSucess)
+			SinglePassDownsamplePSO = shared_ptr<GfxPipelineStateObject>(TEMP_SinglePassDownsamplePSO);
+	}
+
+	{
+		SHADER_CREATE_DESC csDesc =
+		{
+			GetAssetFullPath(L"Shaders\\"),		L"BloomUpsampleCS.hlsl", L"BloomUpsample", L"cs_6_0", nullopt
 		};
 
 		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
 
 		computePsoDesc.csDesc = &csDesc;
 
-		GfxPipelineStateObject* TEMP_BloomBlurPSO = AbstractGfxLayer::CreatePSO();
+		GfxPipelineStateObject* TEMP_BloomUpsamplePSO = AbstractGfxLayer::CreatePSO();
 
-		AbstractGfxLayer::BindSRV(TEMP_BloomBlurPSO, "SrcTex", 0, 1);
-		AbstractGfxLayer::BindUAV(TEMP_BloomBlurPSO, "DstTex", 0);
-		AbstractGfxLayer::BindSampler(TEMP_BloomBlurPSO, "samplerWrap", 0);
-		AbstractGfxLayer::BindCBV(TEMP_BloomBlurPSO, "BloomCB", 0, sizeof(BloomCB));
+		AbstractGfxLayer::BindUAV(TEMP_BloomUpsamplePSO, "Mips", 0, 2);
+		AbstractGfxLayer::BindCBV(TEMP_BloomUpsamplePSO, "BloomUpsampleCB", 0, sizeof(BloomUpsampleCB));
 
-		bool bSucess = AbstractGfxLayer::InitPSO(TEMP_BloomBlurPSO, &computePsoDesc);
+		bool bSucess = AbstractGfxLayer::InitPSO(TEMP_BloomUpsamplePSO, &computePsoDesc);
 		if (bSucess)
-			BloomBlurPSO = shared_ptr<GfxPipelineStateObject>(TEMP_BloomBlurPSO);
+			BloomUpsamplePSO = shared_ptr<GfxPipelineStateObject>(TEMP_BloomUpsamplePSO);
 	}
 
 	{
@@ -1038,17 +1577,18 @@ void Corona::InitBloomPass()
 			AddBloomPSO = shared_ptr<GfxPipelineStateObject>(TEMP_AddBloomPSO);
 	}
 
-	BloomBlurPingPong[0] = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture2D(FORMAT_R16G16B16A16_FLOAT,
+	BloomChain = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture2D(FORMAT_R16G16B16A16_FLOAT,
 		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, BloomBufferWidth, BloomBufferHeight, 1));
+		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, BloomBufferWidth, BloomBufferHeight, BloomNumMips));
 
-	NAME_TEXTURE(BloomBlurPingPong[0]);
+	NAME_TEXTURE(BloomChain);
 
-	BloomBlurPingPong[1] = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture2D(FORMAT_R16G16B16A16_FLOAT,
-		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS,
-		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, BloomBufferWidth, BloomBufferHeight, 1));
+	// every pass binds a fixed size array of mips.
+	AbstractGfxLayer::MakeMipUAVs(BloomChain.get(), kSPDMaxMips);
 
-	NAME_TEXTURE(BloomBlurPingPong[1]);
+	UINT32 ZeroCounter = 0;
+	DownsampleCounter = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(1, sizeof(UINT32), HEAP_TYPE_DEFAULT, RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, &ZeroCounter));
+	NAME_BUFFER(DownsampleCounter);
 
 
 	LumaBuffer = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture2D(FORMAT_R8_UINT,
@@ -1060,18 +1600,8 @@ void Corona::InitBloomPass()
 	Histogram = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(256, sizeof(UINT32), HEAP_TYPE_DEFAULT, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS));
 	NAME_BUFFER(Histogram);
 
-	__declspec(align(16)) float initExposure[] =
-	{
-		Exposure,
-		1.0f / Exposure,
-		0.01,
-		Exposure,
-		0.0f,
-		kInitialMinLog,
-		kInitialMaxLog,
-		kInitialMaxLog - kInitialMinLog,
-		1.0f / (kInitialMaxLog - kInitialMinLog)
-	};
+	__declspec(align(16)) float initExposure[kExposureDataCount];
+	InitExposureData(Exposure, HistogramMinLog, HistogramMaxLog, initExposure);
 
 	ExposureData = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(8, sizeof(float), HEAP_TYPE_DEFAULT, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, initExposure));
 	NAME_BUFFER(ExposureData);
@@ -1283,6 +1813,7 @@ void Corona::InitGBufferPass()
 	AbstractGfxLayer::BindSRV(TEMP_GBufferPassPSO, "NormalTex", 1, 1);
 	AbstractGfxLayer::BindSRV(TEMP_GBufferPassPSO, "RoughnessTex", 2, 1);
 	AbstractGfxLayer::BindSRV(TEMP_GBufferPassPSO, "MetallicTex", 3, 1);
+	AbstractGfxLayer::BindSRV(TEMP_GBufferPassPSO, "InstanceTransforms", 4, 1);
 	AbstractGfxLayer::BindSampler(TEMP_GBufferPassPSO, "samplerWrap", 0);
 	AbstractGfxLayer::BindCBV(TEMP_GBufferPassPSO, "GBufferConstantBuffer", 0, sizeof(GBufferConstantBuffer));
 
@@ -1290,16 +1821,85 @@ void Corona::InitGBufferPass()
 
 	if (bSuccess)
 		GBufferPassPSO = shared_ptr<GfxPipelineStateObject>(TEMP_GBufferPassPSO);
-}
 
-#if USE_IMGUI
-void Corona::InitImgui()
-{
-	IMGUI_CHECKVERSION();
-	ImGui::CreateContext();
-	ImGuiIO& io = ImGui::GetIO(); (void)io;
+	// gpu driven variant, one ExecuteIndirect over the merged geometry.
+	std::vector<ShaderDefine> GPUDrivenDefines = {
+		{L"GPU_DRIVEN", L"1"},
+		{L"MAX_MATERIAL_TEXTURES", std::to_wstring(kMaxMaterialTextures)},
+		{L"MAX_GPU_DRIVEN_SCENES", std::to_wstring(kMaxGPUDrivenScenes)},
+	};
 
-	io.DisplaySize.x = DisplayWidth;
+	SHADER_CREATE_DESC vsIndirectDesc =
+	{
+		GetAssetFullPath(L"Shaders\\"),		L"GBuffer.hlsl", L"VSMain", L"vs_6_0", GPUDrivenDefines
+	};
+
+	SHADER_CREATE_DESC psIndirectDesc =
+	{
+		GetAssetFullPath(L"Shaders\\"),		L"GBuffer.hlsl", L"PSMain", L"ps_6_0", GPUDrivenDefines
+	};
+	psoDescMesh.vsDesc = &vsIndirectDesc;
+	psoDescMesh.psDesc = &psIndirectDesc;
+
+	GfxPipelineStateObject* TEMP_GBufferIndirectPSO = AbstractGfxLayer::CreatePSO();
+
+	AbstractGfxLayer::BindSRV(TEMP_GBufferIndirectPSO, "DrawData", 0, 1);
+	AbstractGfxLayer::BindSRV(TEMP_GBufferIndirectPSO, "InstanceTransforms", 1, 1);
+	AbstractGfxLayer::BindSRV(TEMP_GBufferIndirectPSO, "MaterialTextures", 2, kMaxMaterialTextures);
+	AbstractGfxLayer::BindSampler(TEMP_GBufferIndirectPSO, "samplerWrap", 0);
+	AbstractGfxLayer::BindCBV(TEMP_GBufferIndirectPSO, "GBufferConstantBuffer", 0, sizeof(GBufferConstantBuffer));
+	AbstractGfxLayer::BindRootConstant(TEMP_GBufferIndirectPSO, "GPUDrivenDraw", 1);
+	AbstractGfxLayer::BindCBV(TEMP_GBufferIndirectPSO, "GPUDrivenScene", 2, sizeof(GPUDrivenSceneCB));
+
+	bSuccess = AbstractGfxLayer::InitPSO(TEMP_GBufferIndirectPSO, &psoDescMesh);
+
+	if (bSuccess)
+	{
+		GBufferIndirectPSO = shared_ptr<GfxPipelineStateObject>(TEMP_GBufferIndirectPSO);
+		GBufferCommandSignature = shared_ptr<GfxCommandSignature>(AbstractGfxLayer::CreateDrawIndexedCommandSignature(GBufferIndirectPSO.get(), "GPUDrivenDraw"));
+	}
+
+	// bindless variant of the per draw path, the draw passes a material index instead of four srvs.
+	std::vector<ShaderDefine> BindlessDefines = {
+		{L"BINDLESS", L"1"},
+		{L"MAX_MATERIAL_TEXTURES", std::to_wstring(kMaxBindlessTextures)},
+	};
+
+	SHADER_CREATE_DESC vsBindlessDesc =
+	{
+		GetAssetFullPath(L"Shaders\\"),		L"GBuffer.hlsl", L"VSMain", L"vs_6_0", BindlessDefines
+	};
+
+	SHADER_CREATE_DESC psBindlessDesc =
+	{
+		GetAssetFullPath(L"Shaders\\"),		L"GBuffer.hlsl", L"PSMain", L"ps_6_0", BindlessDefines
+	};
+	psoDescMesh.vsDesc = &vsBindlessDesc;
+	psoDescMesh.psDesc = &psBindlessDesc;
+
+	GfxPipelineStateObject* TEMP_GBufferBindlessPSO = AbstractGfxLayer::CreatePSO();
+
+	AbstractGfxLayer::BindSRV(TEMP_GBufferBindlessPSO, "Materials", 0, 1);
+	AbstractGfxLayer::BindSRV(TEMP_GBufferBindlessPSO, "InstanceTransforms", 4, 1);
+	AbstractGfxLayer::BindSRV(TEMP_GBufferBindlessPSO, "MaterialTextures", 5, kMaxBindlessTextures);
+	AbstractGfxLayer::BindSampler(TEMP_GBufferBindlessPSO, "samplerWrap", 0);
+	AbstractGfxLayer::BindCBV(TEMP_GBufferBindlessPSO, "GBufferConstantBuffer", 0, sizeof(GBufferConstantBuffer));
+	AbstractGfxLayer::BindRootConstant(TEMP_GBufferBindlessPSO, "BindlessDraw", 1);
+
+	bSuccess = AbstractGfxLayer::InitPSO(TEMP_GBufferBindlessPSO, &psoDescMesh);
+
+	if (bSuccess)
+		GBufferBindlessPSO = shared_ptr<GfxPipelineStateObject>(TEMP_GBufferBindlessPSO);
+}
+
+#if USE_IMGUI
+void Corona::InitImgui()
+{
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGuiIO& io = ImGui::GetIO(); (void)io;
+
+	io.DisplaySize.x = DisplayWidth;
 	io.DisplaySize.y = DisplayHeight;
 
 	DX12Impl* dx12_rhi = (DX12Impl*)AbstractGfxLayer::GetDX12Impl();
@@ -1315,69 +1915,64 @@ void Corona::InitImgui()
 
 void Corona::InitBlueNoiseTexture()
 {
-	string path = "assets/bluenoise/64_64_64/HDR_RGBA.raw";
-	ifstream file(path.data(), ios::in | ios::binary);
-	if (file.is_open())
+	struct BlueNoiseSetDesc
 	{
-		file.seekg(0, file.end);
-		int length = file.tellg();
-		file.seekg(0, file.beg);
-
-		UINT32 Version;
-		file.read(reinterpret_cast<char*>(&Version), sizeof(UINT32));
-
-		UINT32 nChannel;
-		file.read(reinterpret_cast<char*>(&nChannel), sizeof(UINT32));
+		string Path;
+		BlueNoiseFormat Format;
+	};
 
-		UINT32 nDimension;
-		file.read(reinterpret_cast<char*>(&nDimension), sizeof(UINT32));
+	// precomputed sets from the blue noise release in assets/bluenoise. missing files are skipped, more sets
+	// can be listed here and picked per pass in the ui.
+	const BlueNoiseSetDesc Sets[] = {
+		{ "assets/bluenoise/64_64_64/HDR_RGBA.raw", BlueNoiseFormat::RGBA16_UNORM },
+	};
 
-		UINT32 Shape[3];
-		for(int i=0;i< nDimension;i++)
-			file.read(reinterpret_cast<char*>(&Shape[i]), sizeof(UINT32));
+	auto AddVolume = [&](const BlueNoiseVolume& Volume, const string& Name)
+	{
+		FORMAT Format = Set.Format == BlueNoiseFormat::RGBA16_UNORM ? FORMAT_R16G16B16A16_UNORM : FORMAT_R8G8B8A8_UNORM;
+		shared_ptr<GfxTexture> Tex = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture3D(Format, RESOURCE_FLAG_NONE,
+			RESOURCE_STATE_COPY_DEST, Volume.Width, Volume.Height, Volume.Depth, 1));
 
-		UINT DataSize = sizeof(UINT32) * nChannel * Shape[0] * Shape[1] * Shape[2];
-		UINT32* NoiseDataRaw = new UINT32[DataSize];
+		SUBRESOURCE_DATA data = {
+			Volume.Data.data(), // pData
+			Volume.RowPitch, // RowPitch
+			Volume.SlicePitch // SlicePitch
+		};
 
-		file.read(reinterpret_cast<char*>(NoiseDataRaw), DataSize);
-		size_t extracted = file.gcount();
-		/*UINT32 NoiseData[128];
-		file.read(reinterpret_cast<char*>(NoiseData), 128*sizeof(UINT32));*/
-		int NumFloat = nChannel * Shape[0] * Shape[1] * Shape[2];
+		AbstractGfxLayer::UploadSRCData3D(Tex.get(), &data);
 
-		float* NoiseDataFloat = new float[NumFloat];
-		stringstream ss;
+		BlueNoiseTextures.push_back(Tex);
+		BlueNoiseSetNames.push_back(Name);
+	};
 
-		float MaxValue = Shape[0] * Shape[1] * Shape[2];
-		for (int i = 0; i < NumFloat; i++)
+	for (auto& Set : Sets)
+	{
+		BlueNoiseVolume Volume;
+		string Error;
+		if (!LoadBlueNoiseRaw(Set.Path, Set.Format, Volume, Error))
 		{
-			if (NoiseDataRaw[i] == 3452816845)
-			{
-				int a = 0;
-			}
-			NoiseDataFloat[i] = static_cast<float>(NoiseDataRaw[i]) / MaxValue;
-
-			ss << NoiseDataFloat[i] << " ";
-			if(i %(64*4) == 0)
-				ss << "\n";
+			OutputDebugStringA((Error + "\n").c_str());
+			continue;
 		}
 
-		BlueNoiseTex = shared_ptr<GfxTexture>(AbstractGfxLayer::CreateTexture3D(FORMAT_R32G32B32A32_FLOAT, RESOURCE_FLAG_NONE,
-			RESOURCE_STATE_COPY_DEST, Shape[0], Shape[1], Shape[2], 1));
-
-		SUBRESOURCE_DATA data = {
-			NoiseDataFloat, // pData
-			Shape[0] * nChannel * sizeof(UINT32), // RowPitch
-			data.RowPitch * Shape[1] // SlicePitch
-		};
-		
-		AbstractGfxLayer::UploadSRCData3D(BlueNoiseTex.get(), &data);
+		AddVolume(Volume, Set.Path.substr(Set.Path.find("bluenoise/") + 10));
+	}
 
-		delete[] NoiseDataRaw;
-		delete[] NoiseDataFloat;
+	// the passes always bind a noise volume, white noise stands in when no set could be loaded.
+	if (BlueNoiseTextures.size() == 0)
+	{
+		BlueNoiseVolume Volume;
+		MakeWhiteNoiseVolume(32, BlueNoiseFormat::RGBA8_UNORM, Volume);
+		AddVolume(Volume, "white noise (fallback)");
 	}
-	
-	file.close();
+}
+
+GfxTexture* Corona::GetBlueNoiseTexture(int Set)
+{
+	if (BlueNoiseTextures.size() == 0)
+		return nullptr;
+
+	return BlueNoiseTextures[glm::clamp<int>(Set, 0, BlueNoiseTextures.size() - 1)].get();
 }
 
 void Corona::InitToneMapPass()
@@ -1699,11 +2294,23 @@ void Corona::InitLightingPass()
 	AbstractGfxLayer::BindUAV(TEMP_BufferVisualizePSO, "DDGIProbeStates", 0);
 	AbstractGfxLayer::BindUAV(TEMP_BufferVisualizePSO, "DDGIProbeOffsets", 1);
 
+	AbstractGfxLayer::BindSRV(TEMP_BufferVisualizePSO, "DDGIProbeIrradianceSRV1", 12, 1);
+	AbstractGfxLayer::BindSRV(TEMP_BufferVisualizePSO, "DDGIProbeDistanceSRV1", 13, 1);
+	AbstractGfxLayer::BindSRV(TEMP_BufferVisualizePSO, "DDGIProbeIrradianceSRV2", 14, 1);
+	AbstractGfxLayer::BindSRV(TEMP_BufferVisualizePSO, "DDGIProbeDistanceSRV2", 15, 1);
+
+	AbstractGfxLayer::BindUAV(TEMP_BufferVisualizePSO, "DDGIProbeStates1", 2);
+	AbstractGfxLayer::BindUAV(TEMP_BufferVisualizePSO, "DDGIProbeOffsets1", 3);
+	AbstractGfxLayer::BindUAV(TEMP_BufferVisualizePSO, "DDGIProbeStates2", 4);
+	AbstractGfxLayer::BindUAV(TEMP_BufferVisualizePSO, "DDGIProbeOffsets2", 5);
+
 	AbstractGfxLayer::BindSampler(TEMP_BufferVisualizePSO, "samplerWrap", 0);
 	AbstractGfxLayer::BindSampler(TEMP_BufferVisualizePSO, "TrilinearSampler", 1);
 
 	AbstractGfxLayer::BindCBV(TEMP_BufferVisualizePSO, "LightingParam", 0, sizeof(LightingParam));
 	AbstractGfxLayer::BindCBV(TEMP_BufferVisualizePSO, "DDGIVolume", 1, rtxgi::GetDDGIVolumeConstantBufferSize());
+	AbstractGfxLayer::BindCBV(TEMP_BufferVisualizePSO, "DDGIVolume1", 2, rtxgi::GetDDGIVolumeConstantBufferSize());
+	AbstractGfxLayer::BindCBV(TEMP_BufferVisualizePSO, "DDGIVolume2", 3, rtxgi::GetDDGIVolumeConstantBufferSize());
 
 	bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_BufferVisualizePSO, &psoDescMesh);
 
@@ -1713,102 +2320,172 @@ void Corona::InitLightingPass()
 
 void Corona::InitTemporalAAPass()
 {
-	INPUT_ELEMENT_DESC StandardVertexDescription[] =
+	for (UINT Mode = 0; Mode < TAA_CLAMP_MODE_COUNT; Mode++)
 	{
-		{ "POSITION", 0, FORMAT_R32G32B32A32_FLOAT, 0, 0,  INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-		{ "TEXCOORD", 0, FORMAT_R32G32_FLOAT,    0, 16, INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0 },
-	};
+		std::vector<ShaderDefine> Defines = {
+			{L"CLAMP_MODE", std::to_wstring(Mode)},
+			{L"FILTER_TYPE", std::to_wstring(TAAFilterType)},
+		};
 
-	UINT StandardVertexDescriptionNumElements = _countof(StandardVertexDescription);
+		SHADER_CREATE_DESC csDesc =
+		{
+			GetAssetFullPath(L"Shaders\\"),		L"TemporalAA.hlsl", L"TemporalAA", L"cs_6_0", Defines
+		};
 
-	RENDER_TARGET_BLEND_DESC defaultRenderTargetBlendDesc =
-	{
-		/*BlendEnable=*/FALSE,
-		/*LogicOpEnable=*/FALSE,
-		/*SrcBlend=*/ BLEND_ONE,
-		/*DestBlend=*/BLEND_ZERO,
-		/*BlendOp=*/BLEND_OP_ADD,
-		/*SrcBlendAlpha=*/BLEND_ONE,
-		/*DestBlendAlpha=*/BLEND_ZERO,
-		/*BlendOpAlpha=*/BLEND_OP_ADD,
-		/*LogicOp=*/LOGIC_OP_NOOP,
-		/*RenderTargetWriteMask=*/COLOR_WRITE_ENABLE_ALL,
-	};
+		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
 
-	BLEND_DESC blendState = {
-		/*AlphaToCoverageEnable=*/FALSE,
-		/*IndependentBlendEnable*/FALSE,
-		/*RenderTarget[0]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[1]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[2]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[3]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[4]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[5]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[6]=*/defaultRenderTargetBlendDesc,
-		/*RenderTarget[7]=*/defaultRenderTargetBlendDesc
-	};
+		computePsoDesc.csDesc = &csDesc;
 
+		GfxPipelineStateObject* TEMP_TemporalAAPSO = AbstractGfxLayer::CreatePSO();
 
-	const DEPTH_STENCILOP_DESC defaultStencilOp =
+		AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "CurrentColorTex", 0, 1);
+		AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "PrevColorTex", 1, 1);
+		AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "VelocityTex", 2, 1);
+		AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "DepthTex", 3, 1);
+		AbstractGfxLayer::BindUAV(TEMP_TemporalAAPSO, "ResolveTex", 0);
+		AbstractGfxLayer::BindSampler(TEMP_TemporalAAPSO, "samplerWrap", 0);
+		AbstractGfxLayer::BindCBV(TEMP_TemporalAAPSO, "TemporalAAParam", 0, sizeof(TemporalAAParam));
+
+		bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_TemporalAAPSO, &computePsoDesc);
+
+		if (bSuccess)
+			TemporalAAPSO[Mode] = shared_ptr<GfxPipelineStateObject>(TEMP_TemporalAAPSO);
+	}
+}
+
+void Corona::InitRayReconstructPass()
+{
+	// reflection writes one target, gi the sh and cocg targets.
+	for (UINT NumTargets = 1; NumTargets <= 2; NumTargets++)
 	{
-		/*StencilFailOp =*/ STENCIL_OP_KEEP,
-		/*StencilDepthFailOp =*/ STENCIL_OP_KEEP,
-		/*StencilPassOp = */STENCIL_OP_KEEP,
-		/*StencilFunc = */COMPARISON_FUNC_ALWAYS
-	};
+		std::vector<ShaderDefine> Defines = {
+			{L"NUM_TARGETS", std::to_wstring(NumTargets)},
+		};
 
-	DEPTH_STENCIL_DESC depthStencilState = {
-		/*DepthEnable = */FALSE,
-		/*DepthWriteMask = */DEPTH_WRITE_MASK_ALL,
-		/*DepthFunc = */COMPARISON_FUNC_LESS,
-		/*StencilEnable = */FALSE,
-		/*StencilReadMask = */DEFAULT_STENCIL_READ_MASK,
-		/*StencilWriteMask = */DEFAULT_STENCIL_WRITE_MASK,
-		/*FrontFace = */defaultStencilOp,
-		/*BackFace = */defaultStencilOp
+		SHADER_CREATE_DESC csDesc =
+		{
+			GetAssetFullPath(L"Shaders\\"),		L"RayReconstructCS.hlsl", L"RayReconstruct", L"cs_6_0", Defines
+		};
 
-	};
+		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
 
-	GRAPHICS_PIPELINE_STATE_DESC psoDescMesh = {};
-	psoDescMesh.InputLayout = { StandardVertexDescription, StandardVertexDescriptionNumElements , sizeof(PostVertex) };
-	psoDescMesh.CullMode = CULL_MODE_NONE; // rasterizer state is too big. and currently I use only CullMode.
-	psoDescMesh.BlendState = blendState;
+		computePsoDesc.csDesc = &csDesc;
 
-	psoDescMesh.DepthStencilState = depthStencilState;
-	psoDescMesh.SampleMask = UINT_MAX;
-	psoDescMesh.PrimitiveTopologyType = PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
-	psoDescMesh.PrimitiveTopology = PRIMITIVE_TOPOLOGY_TRIANGLESTRIP;
-	psoDescMesh.NumRenderTargets = 1;
-	psoDescMesh.RTVFormats[0] = FORMAT_R16G16B16A16_FLOAT;
-	psoDescMesh.MultiSampleCount = 1;
+		GfxPipelineStateObject* TEMP_RayReconstructPSO = AbstractGfxLayer::CreatePSO();
 
+		AbstractGfxLayer::BindSRV(TEMP_RayReconstructPSO, "DepthTex", 0, 1);
+		AbstractGfxLayer::BindSRV(TEMP_RayReconstructPSO, "WorldNormalTex", 1, 1);
+		AbstractGfxLayer::BindSRV(TEMP_RayReconstructPSO, "TileRayBudgetTex", 2, 1);
+		AbstractGfxLayer::BindUAV(TEMP_RayReconstructPSO, "Target0", 0);
+		if (NumTargets > 1)
+			AbstractGfxLayer::BindUAV(TEMP_RayReconstructPSO, "Target1", 1);
+		AbstractGfxLayer::BindCBV(TEMP_RayReconstructPSO, "RayReconstructCB", 0, sizeof(RayReconstructCB));
 
-	SHADER_CREATE_DESC vsDesc =
+		bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_RayReconstructPSO, &computePsoDesc);
+
+		if (bSuccess)
+		{
+			if (NumTargets == 1)
+				RayReconstructReflectionPSO = shared_ptr<GfxPipelineStateObject>(TEMP_RayReconstructPSO);
+			else
+				RayReconstructGIPSO = shared_ptr<GfxPipelineStateObject>(TEMP_RayReconstructPSO);
+		}
+	}
+}
+
+void Corona::InitRayBudgetClassifyPass()
+{
+	SHADER_CREATE_DESC csDesc =
 	{
-		GetAssetFullPath(L"Shaders\\"),		L"TemporalAA.hlsl", L"VSMain", L"vs_6_0", nullopt
+		GetAssetFullPath(L"Shaders\\"),		L"RayBudgetClassifyCS.hlsl", L"RayBudgetClassify", L"cs_6_0", nullopt
 	};
 
-	SHADER_CREATE_DESC psDesc =
+	COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+
+	computePsoDesc.csDesc = &csDesc;
+
+	GfxPipelineStateObject* TEMP_RayBudgetClassifyPSO = AbstractGfxLayer::CreatePSO();
+
+	AbstractGfxLayer::BindSRV(TEMP_RayBudgetClassifyPSO, "SpecularTemporalTex", 0, 1);
+	AbstractGfxLayer::BindSRV(TEMP_RayBudgetClassifyPSO, "DiffuseSHTemporalTex", 1, 1);
+	AbstractGfxLayer::BindSRV(TEMP_RayBudgetClassifyPSO, "VelocityTex", 2, 1);
+	AbstractGfxLayer::BindSRV(TEMP_RayBudgetClassifyPSO, "RoughnessMetalicTex", 3, 1);
+	AbstractGfxLayer::BindUAV(TEMP_RayBudgetClassifyPSO, "TileRayBudget", 0);
+	AbstractGfxLayer::BindCBV(TEMP_RayBudgetClassifyPSO, "RayBudgetClassifyCB", 0, sizeof(RayBudgetClassifyCB));
+
+	bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_RayBudgetClassifyPSO, &computePsoDesc);
+
+	if (bSuccess)
+		RayBudgetClassifyPSO = shared_ptr<GfxPipelineStateObject>(TEMP_RayBudgetClassifyPSO);
+}
+
+void Corona::InitHiZReducePass()
+{
+	SHADER_CREATE_DESC csDesc =
 	{
-		GetAssetFullPath(L"Shaders\\"),		L"TemporalAA.hlsl", L"PSMain", L"ps_6_0", nullopt
+		GetAssetFullPath(L"Shaders\\"),		L"HiZReduceCS.hlsl", L"HiZReduce", L"cs_6_0", nullopt
 	};
-	psoDescMesh.vsDesc = &vsDesc;
-	psoDescMesh.psDesc = &psDesc;
 
-	GfxPipelineStateObject* TEMP_TemporalAAPSO = AbstractGfxLayer::CreatePSO();
+	COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+
+	computePsoDesc.csDesc = &csDesc;
 
+	GfxPipelineStateObject* TEMP_HiZReducePSO = AbstractGfxLayer::CreatePSO();
 
-	AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "CurrentColorTex", 0, 1);
-	AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "PrevColorTex", 1, 1);
-	AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "VelocityTex", 2, 1);
-	AbstractGfxLayer::BindSRV(TEMP_TemporalAAPSO, "DepthTex", 3, 1);
-	AbstractGfxLayer::BindSampler(TEMP_TemporalAAPSO, "samplerWrap", 0);
-	AbstractGfxLayer::BindCBV(TEMP_TemporalAAPSO, "LightingParam", 0, sizeof(LightingParam));
+	AbstractGfxLayer::BindSRV(TEMP_HiZReducePSO, "DepthTex", 0, 1);
+	AbstractGfxLayer::BindUAV(TEMP_HiZReducePSO, "HiZ", 0);
+	AbstractGfxLayer::BindCBV(TEMP_HiZReducePSO, "HiZReduceCB", 0, sizeof(HiZReduceCB));
 
-	bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_TemporalAAPSO, &psoDescMesh);
+	bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_HiZReducePSO, &computePsoDesc);
 
 	if (bSuccess)
-		TemporalAAPSO = shared_ptr<GfxPipelineStateObject>(TEMP_TemporalAAPSO);
+		HiZReducePSO = shared_ptr<GfxPipelineStateObject>(TEMP_HiZReducePSO);
+}
+
+void Corona::InitGPUDrivenCullPass()
+{
+	{
+		SHADER_CREATE_DESC csDesc =
+		{
+			GetAssetFullPath(L"Shaders\\"),		L"GPUDrivenCullCS.hlsl", L"CullDraws", L"cs_6_0", nullopt
+		};
+
+		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+
+		computePsoDesc.csDesc = &csDesc;
+
+		GfxPipelineStateObject* TEMP_GPUDrivenCullPSO = AbstractGfxLayer::CreatePSO();
+
+		AbstractGfxLayer::BindSRV(TEMP_GPUDrivenCullPSO, "DrawRecords", 0, 1);
+		AbstractGfxLayer::BindUAV(TEMP_GPUDrivenCullPSO, "DrawCommands", 0);
+		AbstractGfxLayer::BindUAV(TEMP_GPUDrivenCullPSO, "DrawCount", 1);
+		AbstractGfxLayer::BindCBV(TEMP_GPUDrivenCullPSO, "GPUDrivenCullCB", 0, sizeof(GPUDrivenCullCB));
+
+		bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_GPUDrivenCullPSO, &computePsoDesc);
+
+		if (bSuccess)
+			GPUDrivenCullPSO = shared_ptr<GfxPipelineStateObject>(TEMP_GPUDrivenCullPSO);
+	}
+
+	{
+		SHADER_CREATE_DESC csDesc =
+		{
+			GetAssetFullPath(L"Shaders\\"),		L"GPUDrivenCullCS.hlsl", L"ClearDrawCount", L"cs_6_0", nullopt
+		};
+
+		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+
+		computePsoDesc.csDesc = &csDesc;
+
+		GfxPipelineStateObject* TEMP_ClearDrawCountPSO = AbstractGfxLayer::CreatePSO();
+
+		AbstractGfxLayer::BindUAV(TEMP_ClearDrawCountPSO, "DrawCount", 1);
+
+		bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_ClearDrawCountPSO, &computePsoDesc);
+
+		if (bSuccess)
+			ClearDrawCountPSO = shared_ptr<GfxPipelineStateObject>(TEMP_ClearDrawCountPSO);
+	}
 }
 
 void Corona::ToneMapPass()
@@ -1829,8 +2506,8 @@ void Corona::ToneMapPass()
 	std::vector<GfxTexture*> Rendertargets = { backbuffer };
 	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), ToneMapPSO.get(), Rendertargets.size(), Rendertargets.data(), nullptr);
 
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "CopyPass");
-	//ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "CopyPass")
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "CopyPass");
+	//ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "CopyPass");
 
 	GfxTexture* ResolveTarget = ColorBuffers[ColorBufferWriteIndex].get();
 
@@ -1868,7 +2545,7 @@ void Corona::DebugPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "DebugPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "DebugPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "DebugPass");
 
 	AbstractGfxLayer::SetPSO(BufferVisualizePSO.get(), AbstractGfxLayer::GetGlobalCommandList());
 
@@ -1888,7 +2565,7 @@ void Corona::DebugPass()
 
 		cb.DebugMode = RAW_COPY;
 		AbstractGfxLayer::SetUniformValue(BufferVisualizePSO.get(), "DebugPassCB", &cb, AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTex", probeIrradiance.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTex", RTXGICascades[VisualizedCascade].probeIrradiance.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 		AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 4, 1, 0, 0);
 	}
@@ -1902,7 +2579,7 @@ void Corona::DebugPass()
 
 		cb.DebugMode = RAW_COPY;
 		AbstractGfxLayer::SetUniformValue(BufferVisualizePSO.get(), "DebugPassCB", &cb, AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTex", probeDistance.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTex", RTXGICascades[VisualizedCascade].probeDistance.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 		AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 4, 1, 0, 0);
 	}
@@ -2004,7 +2681,7 @@ void Corona::DebugPass()
 		}
 		cb.DebugMode = RAW_COPY;
 		AbstractGfxLayer::SetUniformValue(BufferVisualizePSO.get(), "DebugPassCB", &cb, AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTex", BloomBlurPingPong[0].get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTex", BloomChain.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 		AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 4, 1, 0, 0);
 	});
@@ -2372,21 +3049,21 @@ void Corona::DebugPass()
 		cb.DebugMode = RTXGI_LIGHTING;
 		cb.RTSize = glm::vec2(RenderWidth, RenderHeight);
 
-		cb.InvViewMatrix = glm::transpose(InvViewMat);
-		cb.InvProjMatrix = glm::transpose(InvProjMat);
+		cb.InvViewMatrix = ViewMatsT.InvView;
+		cb.InvProjMatrix = ViewMatsT.InvProj;
 		cb.CameraPosition = glm::vec4(m_camera.m_position, 0);
 
 		AbstractGfxLayer::SetUniformValue(BufferVisualizePSO.get(), "DebugPassCB", &cb, AbstractGfxLayer::GetGlobalCommandList());
 
 		UINT64 offset = dx12_rhi->CurrentFrameIndex * rtxgi::GetDDGIVolumeConstantBufferSize();
 
-		AbstractGfxLayer::SetUniformBuffer(BufferVisualizePSO.get(), "DDGIVolume", VolumeCB.get(), offset, AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "DDGIProbeIrradianceSRV", probeIrradiance.get(), AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "DDGIProbeDistanceSRV", probeDistance.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetUniformBuffer(BufferVisualizePSO.get(), "DDGIVolume", RTXGICascades[VisualizedCascade].VolumeCB.get(), offset, AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "DDGIProbeIrradianceSRV", RTXGICascades[VisualizedCascade].probeIrradiance.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "DDGIProbeDistanceSRV", RTXGICascades[VisualizedCascade].probeDistance.get(), AbstractGfxLayer::GetGlobalCommandList());
 		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "DepthTex", DepthBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 		AbstractGfxLayer::SetReadTexture(BufferVisualizePSO.get(), "SrcTexNormal", NormalBuffers[ColorBufferWriteIndex].get(), AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetWriteTexture(BufferVisualizePSO.get(), "DDGIProbeStates", probeStates.get(), AbstractGfxLayer::GetGlobalCommandList());
-		AbstractGfxLayer::SetWriteTexture(BufferVisualizePSO.get(), "DDGIProbeOffsets", probeOffsets.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetWriteTexture(BufferVisualizePSO.get(), "DDGIProbeStates", RTXGICascades[VisualizedCascade].probeStates.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetWriteTexture(BufferVisualizePSO.get(), "DDGIProbeOffsets", RTXGICascades[VisualizedCascade].probeOffsets.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 		AbstractGfxLayer::SetSampler("TrilinearSampler", AbstractGfxLayer::GetGlobalCommandList(), BufferVisualizePSO.get(), samplerTrilinearClamp.get());
 
@@ -2407,7 +3084,7 @@ void Corona::LightingPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "LightingPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "LightingPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "LightingPass");
 	
 	{
 		std::vector<ResourceTransition> Transition = { {LightingBuffer.get(),  RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET} };
@@ -2444,17 +3121,21 @@ void Corona::LightingPass()
 	AbstractGfxLayer::SetReadTexture(LightingPSO.get(), "RoughnessMetalicTex", RoughnessMetalicBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 #if USE_RTXGI
-	AbstractGfxLayer::SetReadTexture(LightingPSO.get(), "DDGIProbeIrradianceSRV", probeIrradiance.get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetReadTexture(LightingPSO.get(), "DDGIProbeDistanceSRV", probeDistance.get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetWriteTexture(LightingPSO.get(), "DDGIProbeStates", probeStates.get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetWriteTexture(LightingPSO.get(), "DDGIProbeOffsets", probeOffsets.get(), AbstractGfxLayer::GetGlobalCommandList());
+	// cascade 0 keeps the unsuffixed names, the coarser ones are suffixed with their index.
+	for (uint32_t i = 0; i < kNumDDGICascades; i++)
+	{
+		const std::string Suffix = i == 0 ? "" : std::to_string(i);
+		AbstractGfxLayer::SetReadTexture(LightingPSO.get(), "DDGIProbeIrradianceSRV" + Suffix, RTXGICascades[i].probeIrradiance.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTexture(LightingPSO.get(), "DDGIProbeDistanceSRV" + Suffix, RTXGICascades[i].probeDistance.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetWriteTexture(LightingPSO.get(), "DDGIProbeStates" + Suffix, RTXGICascades[i].probeStates.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetWriteTexture(LightingPSO.get(), "DDGIProbeOffsets" + Suffix, RTXGICascades[i].probeOffsets.get(), AbstractGfxLayer::GetGlobalCommandList());
+	}
 #endif
 
-	glm::mat4x4 InvViewMat = glm::inverse(ViewMat);
 	LightingParam Param;
-	Param.ViewMatrix = glm::transpose(ViewMat);
-	Param.InvViewMatrix = glm::transpose(InvViewMat);
-	Param.InvProjMatrix = glm::transpose(InvProjMat);
+	Param.ViewMatrix = ViewMatsT.View;
+	Param.InvViewMatrix = ViewMatsT.InvView;
+	Param.InvProjMatrix = ViewMatsT.InvProj;
 
 	Param.LightDir = glm::vec4(glm::normalize(LightDir), LightIntensity);
 	
@@ -2477,7 +3158,8 @@ void Corona::LightingPass()
 	AbstractGfxLayer::SetUniformValue(LightingPSO.get(), "LightingParam", &Param, AbstractGfxLayer::GetGlobalCommandList());
 #if USE_RTXGI
 	UINT64 offset = dx12_rhi->CurrentFrameIndex * rtxgi::GetDDGIVolumeConstantBufferSize();
-	AbstractGfxLayer::SetUniformBuffer(LightingPSO.get(), "DDGIVolume", VolumeCB.get(), offset, AbstractGfxLayer::GetGlobalCommandList());
+	for (uint32_t i = 0; i < kNumDDGICascades; i++)
+		AbstractGfxLayer::SetUniformBuffer(LightingPSO.get(), i == 0 ? "DDGIVolume" : "DDGIVolume" + std::to_string(i), RTXGICascades[i].VolumeCB.get(), offset, AbstractGfxLayer::GetGlobalCommandList());
 #endif
 
 	AbstractGfxLayer::SetPSO(LightingPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
@@ -2504,62 +3186,49 @@ void Corona::TemporalAAPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "TemporalAAPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "TemporalAAPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "TemporalAAPass");
 
 	UINT PrevColorBufferIndex = 1 - ColorBufferWriteIndex;
 	GfxTexture* ResolveTarget = ColorBuffers[ColorBufferWriteIndex].get();
 
 	std::array<ResourceTransition, 1> Transition0 = { {
-		{ResolveTarget, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET},
+		{ResolveTarget, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
 	} };
 	AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition0.size(), Transition0.data());
 
-	AbstractGfxLayer::SetPSO(TemporalAAPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	GfxPipelineStateObject* PSO = TemporalAAPSO[ClampMode % TAA_CLAMP_MODE_COUNT].get();
+
+	AbstractGfxLayer::SetPSO(PSO, AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), TemporalAAPSO.get(), samplerBilinearWrap.get());
+	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), PSO, samplerBilinearWrap.get());
 
 
-	AbstractGfxLayer::SetReadTexture(TemporalAAPSO.get(), "CurrentColorTex", LightingWithBloomBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(PSO, "CurrentColorTex", LightingWithBloomBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 
 	GfxTexture* PrevColorBuffer = ColorBuffers[PrevColorBufferIndex].get();
-	AbstractGfxLayer::SetReadTexture(TemporalAAPSO.get(), "PrevColorTex", PrevColorBuffer, AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetReadTexture(TemporalAAPSO.get(), "VelocityTex", VelocityBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetReadTexture(TemporalAAPSO.get(), "DepthTex", DepthBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(PSO, "PrevColorTex", PrevColorBuffer, AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(PSO, "VelocityTex", VelocityBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(PSO, "DepthTex", DepthBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTexture(PSO, "ResolveTex", ResolveTarget, AbstractGfxLayer::GetGlobalCommandList());
 
 	TemporalAAParam Param;
 
 	Param.RTSize.x = RenderWidth;
 	Param.RTSize.y = RenderHeight;
 
+	// 1 resolves the current frame alone, NO_AA doesn't accumulate history.
 	if(AAMethod == TEMPORAL_AA)
 	Param.TAABlendFactor = 0.1;
 	else
 		Param.TAABlendFactor = 1.0;
 
-	Param.ClampMode = ClampMode;
+	AbstractGfxLayer::SetUniformValue(PSO, "TemporalAAParam", &Param, AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::SetUniformValue(TemporalAAPSO.get(), "LightingParam", &Param, AbstractGfxLayer::GetGlobalCommandList());
+	// 8x8 pixels per group
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (RenderWidth + 7) / 8, (RenderHeight + 7) / 8, 1);
 
-	AbstractGfxLayer::SetPSO(TemporalAAPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
-
-
-	std::vector<GfxTexture*> Rendertargets = { ResolveTarget };
-	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), TemporalAAPSO.get(), Rendertargets.size(), Rendertargets.data(), nullptr);
-
-	ViewPort viewPort = { 0.0f, 0.0f, static_cast<float>(RenderWidth), static_cast<float>(RenderHeight), 0, 1 };
-	AbstractGfxLayer::SetViewports(AbstractGfxLayer::GetGlobalCommandList(), 1, &viewPort);
-
-	AbstractGfxLayer::SetScissorRects(AbstractGfxLayer::GetGlobalCommandList(), 1, &m_scissorRect);
-	AbstractGfxLayer::SetPrimitiveTopology(AbstractGfxLayer::GetGlobalCommandList(), PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, FullScreenVB.get());
-	
-	AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 4, 1, 0, 0);
-		
-	std::array<ResourceTransition, 1> Transition1 = { {
-		{ResolveTarget, RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_UNORDERED_ACCESS},
-	} };
-	AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition1.size(), Transition1.data());
+	AbstractGfxLayer::UAVBarrier(AbstractGfxLayer::GetGlobalCommandList(), ResolveTarget);
 
 	if (bDrawHistogram)
 	{
@@ -2584,7 +3253,7 @@ void Corona::DLSSPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "DLSSPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "DLSSPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "DLSSPass");
 
 	UINT PrevColorBufferIndex = 1 - ColorBufferWriteIndex;
 	Texture* ResolveTarget = (Texture*)ColorBuffers[ColorBufferWriteIndex].get();
@@ -2688,45 +3357,116 @@ void Corona::ResolvePixelVelocityPass()
 }
 
 #if USE_RTXGI
-void Corona::RTXGIPass()
+void Corona::ProbeSchedulePass(uint32_t CascadeIndex)
 {
-	if (volume)
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "ProbeSchedulePass");
+
+	RTXGICascade& Cascade = RTXGICascades[CascadeIndex];
+	const DDGICascade& Layout = DDGICascadeLayout.GetCascade(CascadeIndex);
+
+	// probes that scrolled in hold another probe's data, they are all traced this frame.
+	DDGICascadeLayout.GetScrolledInProbes(CascadeIndex, ScrolledInProbes);
+	Cascade.probeScheduler.ForceSchedule(ScrolledInProbes);
+
+	const std::vector<uint32_t>& ScheduledProbes = Cascade.probeScheduler.Schedule(Layout.Grid, probeScheduleParams, m_camera.m_position, UnjitteredViewProjMat);
+
+	GfxBuffer* ScheduledProbesUpload = Cascade.ScheduledProbesBuffer[dx12_rhi->CurrentFrameIndex].get();
+	UINT32* pData = nullptr;
+	AbstractGfxLayer::MapBuffer(ScheduledProbesUpload, (void**)&pData);
+	memcpy(pData, ScheduledProbes.data(), ScheduledProbes.size() * sizeof(UINT32));
+	AbstractGfxLayer::UnmapBuffer(ScheduledProbesUpload);
+
+	{
+		std::array<ResourceTransition, 1> Transition = { {
+			{Cascade.probeRTRadiance.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+
+	ProbeScheduleCB ProbeScheduleParam;
+	ProbeScheduleParam.NumProbes = Cascade.probeScheduler.GetNumProbes();
+
+	UINT64 offset = dx12_rhi->CurrentFrameIndex * rtxgi::GetDDGIVolumeConstantBufferSize();
+
+	AbstractGfxLayer::SetPSO(ProbeMarkNotTracedPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTexture(ProbeMarkNotTracedPSO.get(), "DDGIProbeRTRadiance", Cascade.probeRTRadiance.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTexture(ProbeMarkNotTracedPSO.get(), "DDGIProbeOffsets", Cascade.probeOffsets.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTexture(ProbeMarkNotTracedPSO.get(), "DDGIProbeStates", Cascade.probeStates.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetUniformValue(ProbeMarkNotTracedPSO.get(), "ProbeScheduleCB", &ProbeScheduleParam, AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetUniformBuffer(ProbeMarkNotTracedPSO.get(), "DDGIVolume", Cascade.VolumeCB.get(), offset, AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (ProbeScheduleParam.NumProbes + 63) / 64, 1, 1);
+
 	{
-		volume->SetOrigin(volumeTranslation);
+		std::array<ResourceTransition, 1> Transition = { {
+			{Cascade.probeRTRadiance.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+}
 
-		volume->Update(VolumeCB->resource.Get(), dx12_rhi->CurrentFrameIndex * rtxgi::GetDDGIVolumeConstantBufferSize());
+void Corona::RTXGICascadePass(uint32_t CascadeIndex)
+{
+	RTXGICascade& Cascade = RTXGICascades[CascadeIndex];
+	const DDGICascade& Layout = DDGICascadeLayout.GetCascade(CascadeIndex);
+
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RTXGICascadePass");
+
+	if (Cascade.bPlacementUploaded)
+	{
+		// UploadSRCData3D leaves the textures readable, the volume passes write them.
+		std::array<ResourceTransition, 2> Transition = { {
+			{Cascade.probeOffsets.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+			{Cascade.probeStates.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+		Cascade.bPlacementUploaded = false;
 	}
 
+	Cascade.volume->SetOrigin({ Layout.Grid.Origin.x, Layout.Grid.Origin.y, Layout.Grid.Origin.z });
 
-#if USE_AFTERMATH
-	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "RTXGIPass");
-#endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "RTXGIPass");
+	// every probe updates once per 1 / UpdateFraction frames, so the blend keeps less history per update.
+	Cascade.volume->SetProbeHysteresis(ProbeScheduler::GetCompensatedHysteresis(probeHysteresis, probeScheduleParams.UpdateFraction));
+	Cascade.volume->SetNormalBias(normalBias);
+	Cascade.volume->SetViewBias(viewBias);
+
+	const UINT64 VolumeCBOffset = dx12_rhi->CurrentFrameIndex * rtxgi::GetDDGIVolumeConstantBufferSize();
+	Cascade.volume->Update(Cascade.VolumeCB->resource.Get(), VolumeCBOffset);
+
+	// the ring addressing goes into the padding the sdk leaves at the end of the volume constants.
+	static_assert(kDDGIScrollDescOffset + sizeof(DDGIScrollDescGPU) == sizeof(rtxgi::DDGIVolumeDescGPU), "DDGIScrollDescGPU has to end the volume constants");
+	const DDGIScrollDescGPU ScrollDesc = DDGICascadeLayout.GetScrollDescGPU(CascadeIndex);
+	UINT8* pVolumeCB = nullptr;
+	ThrowIfFailed(Cascade.VolumeCB->resource->Map(0, nullptr, reinterpret_cast<void**>(&pVolumeCB)));
+	memcpy(pVolumeCB + VolumeCBOffset + kDDGIScrollDescOffset, &ScrollDesc, sizeof(ScrollDesc));
+	Cascade.VolumeCB->resource->Unmap(0, nullptr);
 
+	ProbeSchedulePass(CascadeIndex);
 
-	PSO_RT_PROBE->NumInstance = vecBLAS.size();
-	PSO_RT_PROBE->BeginShaderTable();
+	Cascade.PSO_RT_PROBE->NumInstance = vecBLAS.size();
+	Cascade.PSO_RT_PROBE->BeginShaderTable();
 
-	PSO_RT_PROBE->SetUAV("global", "DDGIProbeRTRadiance", probeRTRadiance->GpuHandleUAV);
-	PSO_RT_PROBE->SetUAV("global", "DDGIProbeStates", probeStates->GpuHandleUAV);
-	PSO_RT_PROBE->SetSRV("global", "DDGIProbeOffsets", probeOffsets->GpuHandleUAV);
+	Cascade.PSO_RT_PROBE->SetUAV("global", "DDGIProbeRTRadiance", Cascade.probeRTRadiance->GpuHandleUAV);
+	Cascade.PSO_RT_PROBE->SetUAV("global", "DDGIProbeStates", Cascade.probeStates->GpuHandleUAV);
+	Cascade.PSO_RT_PROBE->SetSRV("global", "DDGIProbeOffsets", Cascade.probeOffsets->GpuHandleUAV);
 
 
-	PSO_RT_PROBE->SetSRV("global", "SceneBVH", TLAS->GPUHandle);
-	PSO_RT_PROBE->SetSRV("global", "DDGIProbeIrradianceSRV", probeIrradiance->GpuHandleSRV);
-	PSO_RT_PROBE->SetSRV("global", "DDGIProbeDistanceSRV", probeDistance->GpuHandleSRV);
-	//PSO_RT_PROBE->SetSRV("global", "DDGIProbeStates", probeStates->GpuHandleSRV);
-	//PSO_RT_PROBE->SetSRV("global", "DDGIProbeOffsets", probeOffsets->GpuHandleSRV);
-	PSO_RT_PROBE->SetSRV("global", "BlueNoiseTex", BlueNoiseTex->GpuHandleSRV);
+	Cascade.PSO_RT_PROBE->SetSRV("global", "SceneBVH", TLAS->GPUHandle);
+	Cascade.PSO_RT_PROBE->SetSRV("global", "DDGIProbeIrradianceSRV", Cascade.probeIrradiance->GpuHandleSRV);
+	Cascade.PSO_RT_PROBE->SetSRV("global", "DDGIProbeDistanceSRV", Cascade.probeDistance->GpuHandleSRV);
+	//Cascade.PSO_RT_PROBE->SetSRV("global", "DDGIProbeStates", Cascade.probeStates->GpuHandleSRV);
+	//Cascade.PSO_RT_PROBE->SetSRV("global", "DDGIProbeOffsets", Cascade.probeOffsets->GpuHandleSRV);
+	if (GfxTexture* BlueNoiseTex = GetBlueNoiseTexture(0))
+		Cascade.PSO_RT_PROBE->SetSRV("global", "BlueNoiseTex", BlueNoiseTex->GpuHandleSRV);
+	Cascade.PSO_RT_PROBE->SetSRV("global", "ScheduledProbes", static_cast<Buffer*>(Cascade.ScheduledProbesBuffer[dx12_rhi->CurrentFrameIndex].get())->SRV.GpuHandle);
 	
 	UINT64 offset = dx12_rhi->CurrentFrameIndex * rtxgi::GetDDGIVolumeConstantBufferSize();
 
-	PSO_RT_PROBE->SetCBVValue("global", "DDGIVolume", VolumeCB->resource->GetGPUVirtualAddress() + offset);
+	Cascade.PSO_RT_PROBE->SetCBVValue("global", "DDGIVolume", Cascade.VolumeCB->resource->GetGPUVirtualAddress() + offset);
 	LightInfoCB LightInfoCB;
 	LightInfoCB.LightDirAndIntensity = glm::vec4(LightDir.x, LightDir.y, LightDir.z, LightIntensity);
-	PSO_RT_PROBE->SetCBVValue("global", "LightInfoCB", &LightInfoCB);
+	Cascade.PSO_RT_PROBE->SetCBVValue("global", "LightInfoCB", &LightInfoCB);
 
-	PSO_RT_PROBE->SetSampler("global", "TrilinearSampler", samplerTrilinearClamp.get());
+	Cascade.PSO_RT_PROBE->SetSampler("global", "TrilinearSampler", samplerTrilinearClamp.get());
 
 	int i = 0;
 	for (auto& as : vecBLAS)
@@ -2737,61 +3477,69 @@ void Corona::RTXGIPass()
 		if (!diffuseTex)
 			diffuseTex = DefaultWhiteTex.get();
 
-		PSO_RT_PROBE->ResetHitProgram(i);
+		Cascade.PSO_RT_PROBE->ResetHitProgram(i);
 
-		PSO_RT_PROBE->StartHitProgram("HitGroup", i);
-		PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", mesh->Vb->GpuHandleSRV, i);
-		PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", mesh->Ib->GpuHandleSRV, i);
-		PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", InstancePropertyBuffer->GpuHandleSRV, i);
-		PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", diffuseTex->GpuHandleSRV, i);
+		Cascade.PSO_RT_PROBE->StartHitProgram("HitGroup", i);
+		Cascade.PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", mesh->Vb->GpuHandleSRV, i);
+		Cascade.PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", mesh->Ib->GpuHandleSRV, i);
+		Cascade.PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", InstancePropertyBuffer->GpuHandleSRV, i);
+		Cascade.PSO_RT_PROBE->AddDescriptor2HitProgram("HitGroup", diffuseTex->GpuHandleSRV, i);
 
 		i++;
 	}
 
-	PSO_RT_PROBE->EndShaderTable(vecBLAS.size());
+	Cascade.PSO_RT_PROBE->EndShaderTable(vecBLAS.size());
 
 
-	PSO_RT_PROBE->Apply(volume->GetNumRaysPerProbe(), volume->GetNumProbes(), AbstractGfxLayer::GetGlobalCommandList());
+	// one dispatch row per scheduled probe.
+	Cascade.PSO_RT_PROBE->Apply(Cascade.volume->GetNumRaysPerProbe(), Cascade.probeScheduler.GetScheduledProbes().size(), AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::GetGlobalCommandList()->CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(probeRTRadiance->resource.Get()));
-	
+	AbstractGfxLayer::GetGlobalCommandList()->CmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::UAV(Cascade.probeRTRadiance->resource.Get()));
 
-	if (volume)
-	{
-		volume->UpdateProbes(AbstractGfxLayer::GetGlobalCommandList()->CmdList.Get());
-	}
+	Cascade.volume->UpdateProbes(AbstractGfxLayer::GetGlobalCommandList()->CmdList.Get());
 
 	ID3D12DescriptorHeap* ppHeaps[] = { dx12_rhi->SRVCBVDescriptorHeapShaderVisible->DH.Get(), dx12_rhi->SamplerDescriptorHeapShaderVisible->DH.Get() };
 	AbstractGfxLayer::GetGlobalCommandList()->CmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
 }
-#endif
 
-void Corona::BloomPass()
+void Corona::RTXGIPass()
 {
 #if USE_AFTERMATH
-	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "BloomPass");
+	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "RTXGIPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "BloomPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RTXGIPass");
 
-	BloomCB.RTSize.x = BloomBufferWidth;
-	BloomCB.RTSize.y = BloomBufferHeight;
+	// a new light direction or intensity changes every probe.
+	const glm::vec4 LightDirAndIntensity = glm::vec4(LightDir, LightIntensity);
+	if (LightDirAndIntensity != ScheduledLightDirAndIntensity)
+	{
+		for (RTXGICascade& Cascade : RTXGICascades)
+			Cascade.probeScheduler.InvalidateAll();
+		ScheduledLightDirAndIntensity = LightDirAndIntensity;
+	}
+
+	// the cascades follow the camera in whole probe steps.
+	DDGICascadeLayout.Update(m_camera.m_position);
 
-	float sigma_pixels = BloomSigma * RenderHeight;
+	for (uint32_t i = 0; i < kNumDDGICascades; i++)
+		RTXGICascadePass(i);
+}
+#endif
+
+void Corona::BloomPass()
+{
+#if USE_AFTERMATH
+	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "BloomPass");
+#endif
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "BloomPass");
 
-	float effective_sigma = sigma_pixels * 0.25f;
-	effective_sigma = glm::min(effective_sigma, 100.f);
-	effective_sigma = glm::max(effective_sigma, 1.f);
-	BloomCB.NumSamples = glm::round(effective_sigma*4.f);
-	BloomCB.WeightScale = -1.f / (2.0 * effective_sigma * effective_sigma);
-	BloomCB.NormalizationScale = 1.f / (sqrtf(2 * glm::pi<float>()) * effective_sigma);;
-	//BloomCB.Exposure = Exposure;
-	/*BloomCB.MinLog = kInitialMinLog;
-	BloomCB.RcpLogRange = 1.0f / (kInitialMaxLog - kInitialMinLog);*/
+	BloomCB.RTSize.x = BloomBufferWidth;
+	BloomCB.RTSize.y = BloomBufferHeight;
 
-	// extraction pass
+	// extraction pass. writes mip 0 of the chain and the luma buffer.
 	
 	std::array<ResourceTransition, 2> Transition0 = { {
-		{BloomBlurPingPong[0].get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+		{BloomChain.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
 		{LumaBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS}
 	} };
 	AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), 2, Transition0.data());
@@ -2801,7 +3549,7 @@ void Corona::BloomPass()
 
 	AbstractGfxLayer::SetReadTexture(BloomExtractPSO.get(), "SrcTex", LightingBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 	AbstractGfxLayer::SetReadBuffer(BloomExtractPSO.get(), "Exposure", ExposureData.get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetWriteTexture(BloomExtractPSO.get(), "DstTex", BloomBlurPingPong[0].get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTextureMips(BloomExtractPSO.get(), "DstTex", BloomChain.get(), 0, AbstractGfxLayer::GetGlobalCommandList());
 	AbstractGfxLayer::SetWriteTexture(BloomExtractPSO.get(), "LumaResult", LumaBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), BloomExtractPSO.get(), samplerBilinearWrap.get());
@@ -2809,60 +3557,125 @@ void Corona::BloomPass()
 	AbstractGfxLayer::SetUniformValue(BloomExtractPSO.get(), "BloomCB", &BloomCB, AbstractGfxLayer::GetGlobalCommandList());
 
 
-	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), BloomBufferWidth / 32, BloomBufferHeight / 32, 1);
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (BloomBufferWidth + 31) / 32, (BloomBufferHeight + 31) / 32, 1);
+
+	AbstractGfxLayer::UAVBarrier(AbstractGfxLayer::GetGlobalCommandList(), BloomChain.get());
+
+	// the whole mip chain in one dispatch
 	{
-		std::array<ResourceTransition, 3> Transition = { {
-			{BloomBlurPingPong[0].get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
-			{LumaBuffer.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
-			{BloomBlurPingPong[1].get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+		DownsampleCB CB;
+		CB.SrcSize = glm::uvec2(BloomBufferWidth, BloomBufferHeight);
+		CB.NumMips = BloomNumMips;
+		UINT NumGroupsX = (BloomBufferWidth + kSPDTileSize - 1) / kSPDTileSize;
+		UINT NumGroupsY = (BloomBufferHeight + kSPDTileSize - 1) / kSPDTileSize;
+		CB.NumWorkGroups = NumGroupsX * NumGroupsY;
 
-		} };
-		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size() , Transition.data());
+		AbstractGfxLayer::SetPSO(SinglePassDownsamplePSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+
+		AbstractGfxLayer::SetWriteTextureMips(SinglePassDownsamplePSO.get(), "Mips", BloomChain.get(), 0, AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetWriteBuffer(SinglePassDownsamplePSO.get(), "AtomicCounter", DownsampleCounter.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetUniformValue(SinglePassDownsamplePSO.get(), "DownsampleCB", &CB, AbstractGfxLayer::GetGlobalCommandList());
+
+		AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), NumGroupsX, NumGroupsY, 1);
 	}
-	
 
-	AbstractGfxLayer::SetPSO(BloomBlurPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	// upsample and blend, from the smallest mip up to mip 0
+	AbstractGfxLayer::SetPSO(BloomUpsamplePSO.get(), AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::SetReadTexture(BloomBlurPSO.get(), "SrcTex", BloomBlurPingPong[0].get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetWriteTexture(BloomBlurPSO.get(), "DstTex", BloomBlurPingPong[1].get(), AbstractGfxLayer::GetGlobalCommandList());
+	for (int Mip = int(BloomNumMips) - 2; Mip >= 0; Mip--)
+	{
+		AbstractGfxLayer::UAVBarrier(AbstractGfxLayer::GetGlobalCommandList(), BloomChain.get());
 
-	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), BloomBlurPSO.get(), samplerBilinearWrap.get());
+		BloomUpsampleCB CB;
+		CB.DstSize = glm::uvec2(BloomBufferWidth >> Mip, BloomBufferHeight >> Mip);
+		CB.SrcSize = glm::uvec2(BloomBufferWidth >> (Mip + 1), BloomBufferHeight >> (Mip + 1));
+		CB.BloomScatter = BloomScatter;
 
-	BloomCB.BlurDirection = glm::vec2(1, 0);
-	AbstractGfxLayer::SetUniformValue(BloomBlurPSO.get(), "BloomCB", &BloomCB, AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetWriteTextureMips(BloomUpsamplePSO.get(), "Mips", BloomChain.get(), Mip, AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetUniformValue(BloomUpsamplePSO.get(), "BloomUpsampleCB", &CB, AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), BloomBufferWidth / 32, BloomBufferHeight / 32, 1);
+		AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (CB.DstSize.x + 7) / 8, (CB.DstSize.y + 7) / 8, 1);
+	}
 
 	{
-		std::array<ResourceTransition, 2> Transition = { {
-		{BloomBlurPingPong[1].get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
-		{BloomBlurPingPong[0].get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS}
-		} };
+		std::vector<ResourceTransition> Transition = {
+			ResourceTransition(BloomChain.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+			ResourceTransition(LumaBuffer.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+		};
+
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+
+	// with async compute the exposure of this frame's luma adapts at the start of the next one.
+	if (!bAsyncExposure)
+		ExposurePass();
+
+	{
+		std::vector<ResourceTransition> Transition = {
+			ResourceTransition(LightingWithBloomBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET)
+		};
+
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
 
-	AbstractGfxLayer::SetPSO(BloomBlurPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetPSO(AddBloomPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::SetReadTexture(BloomBlurPSO.get(), "SrcTex", BloomBlurPingPong[1].get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetWriteTexture(BloomBlurPSO.get(), "DstTex", BloomBlurPingPong[0].get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), AddBloomPSO.get(), samplerBilinearWrap.get());
 
-	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), BloomBlurPSO.get(), samplerBilinearWrap.get());
+	AbstractGfxLayer::SetReadTexture(AddBloomPSO.get(), "SrcTex", LightingBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(AddBloomPSO.get(), "BloomTex", BloomChain.get(), AbstractGfxLayer::GetGlobalCommandList());
+
+	AddBloomCB.Offset = glm::vec4(0, 0, 0, 0);
+	AddBloomCB.Scale = glm::vec4(1, 1, 0, 0);
+	AddBloomCB.BloomStrength = BloomStrength;
+	AbstractGfxLayer::SetUniformValue(AddBloomPSO.get(), "AddBloomCB", &AddBloomCB, AbstractGfxLayer::GetGlobalCommandList());
 
-	BloomCB.BlurDirection = glm::vec2(0, 1);
-	AbstractGfxLayer::SetUniformValue(BloomBlurPSO.get(), "BloomCB", &BloomCB, AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), BloomBufferWidth / 32, BloomBufferHeight / 32, 1);
+	UINT Width = RenderWidth;
+	UINT Height = RenderHeight;
+	
+	ViewPort viewPort = { 0.0f, 0.0f, static_cast<float>(Width), static_cast<float>(Height) };
+	AbstractGfxLayer::SetViewports(AbstractGfxLayer::GetGlobalCommandList(), 1, &viewPort);
 
+	Rect scissorRect = { 0, 0, static_cast<LONG>(Width), static_cast<LONG>(Height) };
+	AbstractGfxLayer::SetScissorRects(AbstractGfxLayer::GetGlobalCommandList(), 1, &scissorRect);
+
+	std::vector<GfxTexture*> Rendertargets = { LightingWithBloomBuffer.get() };
+	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), AddBloomPSO.get(), Rendertargets.size(), Rendertargets.data(), nullptr);
+
+	AbstractGfxLayer::SetPrimitiveTopology(AbstractGfxLayer::GetGlobalCommandList(), PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
+	AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, FullScreenVB.get());
+
+	AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 4, 1, 0, 0);
 
 	{
 		std::vector<ResourceTransition> Transition = {
-			ResourceTransition(BloomBlurPingPong[0].get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-			ResourceTransition(Histogram.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS)
+			ResourceTransition(LightingWithBloomBuffer.get(), RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
 		};
 
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
+}
 
+// histogram of the luma the bloom extraction wrote and the exposure adaptation. inline in BloomPass it
+// sees this frame's luma. with async compute it runs at the start of the frame from the last frame's luma,
+// AsyncExposureAcquirePass and AsyncExposureReleasePass move its buffers to states a compute queue
+// allows and back.
+void Corona::ExposurePass()
+{
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "ExposurePass");
+
+	// compute queues can't use the pixel shader resource state.
+	const RESOURCE_STATES ReadState = bAsyncExposure ? RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE : RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+
+	if (!bAsyncExposure)
+	{
+		std::vector<ResourceTransition> Transition = {
+			ResourceTransition(Histogram.get(), ReadState, RESOURCE_STATE_UNORDERED_ACCESS)
+		};
+
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
 
 	AbstractGfxLayer::SetPSO(ClearHistogramPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
 
@@ -2875,13 +3688,15 @@ void Corona::BloomPass()
 	AbstractGfxLayer::SetReadTexture(HistogramPSO.get(), "LumaTex", LumaBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 	AbstractGfxLayer::SetWriteBuffer(HistogramPSO.get(), "Histogram", Histogram.get(), AbstractGfxLayer::GetGlobalCommandList());
 
-	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), BloomBufferWidth / 16, 1, 1);
+	// 16x64 luma tiles per group
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (BloomBufferWidth + 15) / 16, (BloomBufferHeight + 63) / 64, 1);
 
 	{
 		std::vector<ResourceTransition> Transition = {
-			ResourceTransition(Histogram.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-			ResourceTransition(ExposureData.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS)
+			ResourceTransition(Histogram.get(), RESOURCE_STATE_UNORDERED_ACCESS, ReadState)
 		};
+		if (!bAsyncExposure)
+			Transition.push_back(ResourceTransition(ExposureData.get(), ReadState, RESOURCE_STATE_UNORDERED_ACCESS));
 
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
@@ -2892,57 +3707,45 @@ void Corona::BloomPass()
 	AbstractGfxLayer::SetWriteBuffer(AdapteExposurePSO.get(), "Exposure", ExposureData.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 	AdaptExposureCB.PixelCount = BloomBufferWidth * BloomBufferHeight;
+	AdaptExposureCB.ResetLogRange = bResetHistogramRange;
+	AdaptExposureCB.ResetMinLog = HistogramMinLog;
+	AdaptExposureCB.ResetMaxLog = HistogramMaxLog;
+	bResetHistogramRange = false;
 	
 	AbstractGfxLayer::SetUniformValue(AdapteExposurePSO.get(), "AdaptExposureCB", &AdaptExposureCB, AbstractGfxLayer::GetGlobalCommandList());
 
 	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), 1, 1, 1);
 
+	if (!bAsyncExposure)
 	{
 		std::vector<ResourceTransition> Transition = {
-			ResourceTransition(ExposureData.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-			ResourceTransition(LightingWithBloomBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET)
+			ResourceTransition(ExposureData.get(), RESOURCE_STATE_UNORDERED_ACCESS, ReadState)
 		};
 
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
+}
 
-	AbstractGfxLayer::SetPSO(AddBloomPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
-
-	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), AddBloomPSO.get(), samplerBilinearWrap.get());
-
-	AbstractGfxLayer::SetReadTexture(AddBloomPSO.get(), "SrcTex", LightingBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
-	AbstractGfxLayer::SetReadTexture(AddBloomPSO.get(), "BloomTex", BloomBlurPingPong[0].get(), AbstractGfxLayer::GetGlobalCommandList());
-
-	AddBloomCB.Offset = glm::vec4(0, 0, 0, 0);
-	AddBloomCB.Scale = glm::vec4(1, 1, 0, 0);
-	AddBloomCB.BloomStrength = BloomStrength;
-	AbstractGfxLayer::SetUniformValue(AddBloomPSO.get(), "AddBloomCB", &AddBloomCB, AbstractGfxLayer::GetGlobalCommandList());
-
-
-	UINT Width = RenderWidth;
-	UINT Height = RenderHeight;
-	
-	ViewPort viewPort = { 0.0f, 0.0f, static_cast<float>(Width), static_cast<float>(Height) };
-	AbstractGfxLayer::SetViewports(AbstractGfxLayer::GetGlobalCommandList(), 1, &viewPort);
-
-	Rect scissorRect = { 0, 0, static_cast<LONG>(Width), static_cast<LONG>(Height) };
-	AbstractGfxLayer::SetScissorRects(AbstractGfxLayer::GetGlobalCommandList(), 1, &scissorRect);
-
-	std::vector<GfxTexture*> Rendertargets = { LightingWithBloomBuffer.get() };
-	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), AddBloomPSO.get(), Rendertargets.size(), Rendertargets.data(), nullptr);
-
-	AbstractGfxLayer::SetPrimitiveTopology(AbstractGfxLayer::GetGlobalCommandList(), PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
-	AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, FullScreenVB.get());
+void Corona::AsyncExposureAcquirePass()
+{
+	std::vector<ResourceTransition> Transition = {
+		ResourceTransition(LumaBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE),
+		ResourceTransition(Histogram.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS),
+		ResourceTransition(ExposureData.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS)
+	};
 
-	AbstractGfxLayer::DrawInstanced(AbstractGfxLayer::GetGlobalCommandList(), 4, 1, 0, 0);
+	AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+}
 
-	{
-		std::vector<ResourceTransition> Transition = {
-			ResourceTransition(LightingWithBloomBuffer.get(), RESOURCE_STATE_RENDER_TARGET, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
-		};
+void Corona::AsyncExposureReleasePass()
+{
+	std::vector<ResourceTransition> Transition = {
+		ResourceTransition(LumaBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+		ResourceTransition(Histogram.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE),
+		ResourceTransition(ExposureData.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE)
+	};
 
-		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
-	}
+	AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 }
 
 void Corona::InitSimpleDraw()
@@ -3048,6 +3851,16 @@ void Corona::InitSimpleDraw()
 
 	if (bSuccess)
 		SimpleDrawPSO = shared_ptr<GfxPipelineStateObject>(TEMP_SimpleDrawPSO);
+
+	// one triangle at the origin, enough to see the pso, the uniform and the present work.
+	MeshVertex triangleVertices[] =
+	{
+		{ { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.5f, 0.0f }, { 1.0f, 0.0f, 0.0f } },
+		{ { 1.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 1.0f, 1.0f }, { 1.0f, 0.0f, 0.0f } },
+		{ { -1.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, -1.0f }, { 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f } },
+	};
+
+	SimpleDrawVB = shared_ptr<GfxVertexBuffer>(AbstractGfxLayer::CreateVertexBuffer(sizeof(triangleVertices), sizeof(MeshVertex), triangleVertices));
 }
 
 static const float OneMinusEpsilon = 0.9999999403953552f;
@@ -3066,8 +3879,192 @@ inline glm::vec2 Hammersley2D(uint64 sampleIdx, uint64 numSamples)
 	return glm::vec2(float(sampleIdx) / float(numSamples), RadicalInverseBase2(uint32(sampleIdx)));
 }
 
+void Corona::UpdateProfiler()
+{
+	// every thread's zones of the previous frame, and the gpu zones of the frame that retired last.
+	ProfileEvents.clear();
+	CPUProfiler::Get().Collect(ProfileEvents);
+
+	const vector<GPUZoneTiming>& GPUZones = AbstractGfxLayer::GetGPUZoneTimings();
+
+	// zones are pushed when they close, sort the main thread's by start so parents come before children.
+	const uint32_t MainThreadID = CPUProfiler::Get().GetThreadBuffer()->ThreadID;
+	vector<const ProfileEvent*> MainThreadEvents;
+	for (const ProfileEvent& Event : ProfileEvents)
+	{
+		if (Event.ThreadID == MainThreadID)
+			MainThreadEvents.push_back(&Event);
+	}
+	std::sort(MainThreadEvents.begin(), MainThreadEvents.end(), [](const ProfileEvent* A, const ProfileEvent* B) { return A->BeginNs < B->BeginNs; });
+
+	for (const ProfileEvent* Event : MainThreadEvents)
+		CPUProfileStats.AddSample(Event->Name, Event->Depth, (Event->EndNs - Event->BeginNs) * 1e-6);
+	CPUProfileStats.EndFrame();
+
+	for (const GPUZoneTiming& Zone : GPUZones)
+		GPUProfileStats.AddSample(Zone.Name, Zone.Depth, (Zone.EndNs - Zone.BeginNs) * 1e-6);
+	GPUProfileStats.EndFrame();
+
+	if (BenchmarkConfig.bEnabled)
+		RecordBenchmarkFrame(MainThreadEvents, GPUZones);
+
+	if (TraceCaptureFrames > 0)
+	{
+		for (const ProfileEvent& Event : ProfileEvents)
+			ProfileTrace.AddEvent(Event.Name, "cpu", Event.ThreadID, Event.BeginNs, Event.EndNs);
+		for (const GPUZoneTiming& Zone : GPUZones)
+			ProfileTrace.AddEvent(Zone.Name, "gpu", ChromeTraceWriter::kGPUTrackID, Zone.BeginNs, Zone.EndNs);
+
+		if (--TraceCaptureFrames == 0)
+		{
+			CPUProfiler::Get().ForEachThread([&](ProfilerThreadBuffer& Buffer) { ProfileTrace.SetTrackName(Buffer.ThreadID, Buffer.ThreadName); });
+			ProfileTrace.SetTrackName(ChromeTraceWriter::kGPUTrackID, "GPU");
+
+			string Error;
+			if (ProfileTrace.WriteFile("ProfileTrace.json", Error))
+				TraceCaptureStatus = "ProfileTrace.json : " + std::to_string(ProfileTrace.GetNumEvents()) + " zones";
+			else
+				TraceCaptureStatus = Error;
+			ProfileTrace.Clear();
+		}
+	}
+}
+
+void Corona::InitBenchmark()
+{
+	vector<string> Args;
+	std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> converter;
+	for (const wstring& Arg : m_commandLineArgs)
+		Args.push_back(converter.to_bytes(Arg));
+
+	string Error;
+	if (!ParseBenchmarkArgs(Args, BenchmarkConfig, Error) || (BenchmarkConfig.bEnabled && !BenchmarkPath.LoadFile(BenchmarkConfig.PathFile, Error)))
+	{
+		OutputDebugStringA(("benchmark : " + Error + "\n").c_str());
+		BenchmarkConfig.bEnabled = false;
+		PostQuitMessage(1);
+		return;
+	}
+
+	if (!BenchmarkConfig.bEnabled)
+		return;
+
+	// nothing but the frame itself, the ui costs cpu and gpu time.
+	bShowImgui = false;
+}
+
+void Corona::UpdateBenchmark()
+{
+	// the warmup frames hold the first key, then every frame advances the path by the same step.
+	const uint32_t PathFrame = BenchmarkFrameIndex > BenchmarkConfig.NumWarmupFrames ? BenchmarkFrameIndex - BenchmarkConfig.NumWarmupFrames : 0;
+	BenchmarkTime = BenchmarkPath.GetKeys().front().Time + PathFrame * BenchmarkConfig.TimeStep;
+
+	const CameraPathKey Key = BenchmarkPath.Sample(float(BenchmarkTime));
+	m_camera.SetPose(Key.Position, Key.Yaw, Key.Pitch);
+	LightDir = Key.LightDir;
+	LightIntensity = Key.LightIntensity;
+
+	BenchmarkFrameIndex++;
+}
+
+void Corona::RecordBenchmarkFrame(const vector<const ProfileEvent*>& MainThreadEvents, const vector<GPUZoneTiming>& GPUZones)
+{
+	const uint64_t NowNs = ProfilerNowNs();
+	const uint64_t LastFrameNs = BenchmarkLastFrameNs;
+	BenchmarkLastFrameNs = NowNs;
+
+	// the zones collected now are of the previous frame, the first recorded one is the frame after the warmup.
+	if (BenchmarkFrameIndex <= BenchmarkConfig.NumWarmupFrames)
+		return;
+
+	BenchmarkFrame Frame;
+	Frame.Frame = uint32_t(BenchmarkResults.GetNumFrames());
+	Frame.FrameMs = (NowNs - LastFrameNs) * 1e-6;
+
+	// top level zones are the frame, their children the passes.
+	for (const ProfileEvent* Event : MainThreadEvents)
+	{
+		const double Ms = (Event->EndNs - Event->BeginNs) * 1e-6;
+		if (Event->Depth == 0)
+			Frame.CPUMs += Ms;
+		else if (Event->Depth == 1)
+			Frame.Zones.push_back({ Event->Name, false, Ms });
+	}
+	for (const GPUZoneTiming& Zone : GPUZones)
+	{
+		const double Ms = (Zone.EndNs - Zone.BeginNs) * 1e-6;
+		if (Zone.Depth == 0)
+			Frame.GPUMs += Ms;
+		else if (Zone.Depth == 1)
+			Frame.Zones.push_back({ Zone.Name, true, Ms });
+	}
+
+	PROCESS_MEMORY_COUNTERS_EX MemoryCounters = {};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), reinterpret_cast<PROCESS_MEMORY_COUNTERS*>(&MemoryCounters), sizeof(MemoryCounters)))
+		Frame.ProcessBytes = MemoryCounters.PrivateUsage;
+	Frame.GPUBytes = AbstractGfxLayer::GetGPUMemoryUsage();
+	Frame.StreamingBytes = TexStreamer.GetStats().ResidentBytes;
+	if (const FramePacer* Pacer = AbstractGfxLayer::GetFramePacer())
+		Frame.LatencyMs = Pacer->GetInputToPresent().GetLastMs();
+
+	BenchmarkResults.AddFrame(Frame);
+
+	if (BenchmarkResults.GetNumFrames() == BenchmarkConfig.NumFrames)
+		FinishBenchmark();
+}
+
+void Corona::FinishBenchmark()
+{
+	BenchmarkConfig.bEnabled = false;
+
+	std::stringstream Summary;
+	Summary << "benchmark " << BenchmarkConfig.PathFile << ", step " << BenchmarkConfig.TimeStep * 1000.0 << " ms, ";
+	BenchmarkResults.WriteSummary(Summary);
+	AsyncScheduler.WriteReport(Summary);
+
+	string Error;
+	const bool bWritten = BenchmarkResults.WriteFiles(BenchmarkConfig.OutputPrefix, Error);
+	if (bWritten)
+		Summary << "written to " << BenchmarkConfig.OutputPrefix << ".csv and .json\n";
+	else
+		Summary << Error << "\n";
+
+	OutputDebugStringA(Summary.str().c_str());
+	printf("%s", Summary.str().c_str());
+	fflush(stdout);
+
+	PostQuitMessage(bWritten ? 0 : 1);
+}
+
+void Corona::RecordCameraPathKey()
+{
+	// a key every 0.25 seconds, the benchmark plays it back with catmull-rom.
+	const float Time = float(m_timer.GetTotalSeconds() - CameraPathRecordStart);
+	const vector<CameraPathKey>& Keys = RecordedCameraPath.GetKeys();
+	if (!Keys.empty() && Time - Keys.back().Time < 0.25f)
+		return;
+
+	CameraPathKey Key;
+	Key.Time = Time;
+	Key.Position = m_camera.m_position;
+	Key.Yaw = m_camera.m_yaw;
+	Key.Pitch = m_camera.m_pitch;
+	Key.LightDir = LightDir;
+	Key.LightIntensity = LightIntensity;
+	RecordedCameraPath.AddKey(Key);
+}
+
 void Corona::OnUpdate()
 {
+	// block for the frame slot before sampling input, so the camera is as fresh as it can be when the
+	// frame gets recorded.
+	AbstractGfxLayer::SetMaxFramesInFlight(MaxFramesInFlight);
+	AbstractGfxLayer::WaitForFrameSlot();
+
+	UpdateProfiler();
+
+	ProfileCPUScope("OnUpdate");
+
 	m_timer.Tick(NULL);
 
 	if (m_frameCounter == 100)
@@ -3081,26 +4078,27 @@ void Corona::OnUpdate()
 
 	m_frameCounter++;
 
-	m_camera.SetTurnSpeed(m_turnSpeed);
-	m_camera.Update(static_cast<float>(m_timer.GetElapsedSeconds()));
+	if (BenchmarkConfig.bEnabled)
+	{
+		UpdateBenchmark();
+	}
+	else
+	{
+		m_camera.SetTurnSpeed(m_turnSpeed);
+		m_camera.Update(static_cast<float>(m_timer.GetElapsedSeconds()));
+
+		if (bRecordingCameraPath)
+			RecordCameraPathKey();
+	}
+	AbstractGfxLayer::MarkInputSampled();
 
 	ViewMat = m_camera.GetViewMatrix();
 	ProjMat = m_camera.GetProjectionMatrix(Fov, m_aspectRatio, Near, Far);
-	UnjitteredViewProjMat = ProjMat * ViewMat;
+	const glm::mat4x4 UnjitteredProjMat = ProjMat;
 
-	InvViewMat = glm::inverse(ViewMat);
+	BatchAffineInverse(&ViewMat, &InvViewMat, 1);
 	InvProjMat = glm::inverse(ProjMat);
 
-	RTShadowViewParam.ViewMatrix = glm::transpose(ViewMat);
-	RTShadowViewParam.InvViewMatrix = glm::transpose(InvViewMat);
-	RTShadowViewParam.ProjMatrix = glm::transpose(ProjMat);
-	RTShadowViewParam.InvProjMatrix = glm::transpose(InvProjMat);
-	RTShadowViewParam.ProjectionParams.x = Far / (Far - Near);
-	RTShadowViewParam.ProjectionParams.y = Near / (Near - Far);
-	RTShadowViewParam.ProjectionParams.z = Near;
-	RTShadowViewParam.ProjectionParams.w = Far;
-	RTShadowViewParam.LightDir = glm::vec4(LightDir, 0);
-
 	glm::vec2 Jitter;
 	uint64 idx = FrameCounter % 8;
 	const vec2 offsets[] = {
@@ -3128,17 +4126,43 @@ void Corona::OnUpdate()
 		ProjMat = JitterMat * ProjMat;
 
 
+	UnjitteredViewProjMat = UnjitteredProjMat * ViewMat;
 	ViewProjMat = ProjMat * ViewMat;
 
 	InvViewProjMat = glm::inverse(ViewProjMat);
+
+	// every matrix a constant buffer needs transposed once.
+	const glm::mat4x4 ViewMats[] = { ViewMat, InvViewMat, UnjitteredProjMat, InvProjMat, ProjMat, ViewProjMat,
+		PrevViewProjMat, UnjitteredViewProjMat, PrevUnjitteredViewProjMat };
+	glm::mat4x4 Transposed[std::size(ViewMats)];
+	BatchTranspose(ViewMats, Transposed, std::size(ViewMats));
+	ViewMatsT.View = Transposed[0];
+	ViewMatsT.InvView = Transposed[1];
+	ViewMatsT.Proj = Transposed[2];
+	ViewMatsT.InvProj = Transposed[3];
+	ViewMatsT.JitteredProj = Transposed[4];
+	ViewMatsT.ViewProj = Transposed[5];
+	ViewMatsT.PrevViewProj = Transposed[6];
+	ViewMatsT.UnjitteredViewProj = Transposed[7];
+	ViewMatsT.PrevUnjitteredViewProj = Transposed[8];
+
+	RTShadowViewParam.ViewMatrix = ViewMatsT.View;
+	RTShadowViewParam.InvViewMatrix = ViewMatsT.InvView;
+	RTShadowViewParam.ProjMatrix = ViewMatsT.Proj;
+	RTShadowViewParam.InvProjMatrix = ViewMatsT.InvProj;
+	RTShadowViewParam.ProjectionParams.x = Far / (Far - Near);
+	RTShadowViewParam.ProjectionParams.y = Near / (Near - Far);
+	RTShadowViewParam.ProjectionParams.z = Near;
+	RTShadowViewParam.ProjectionParams.w = Far;
+	RTShadowViewParam.LightDir = glm::vec4(LightDir, 0);
 	
-	float timeElapsed = m_timer.GetTotalSeconds();
+	float timeElapsed = BenchmarkConfig.bEnabled ? float(BenchmarkTime) : float(m_timer.GetTotalSeconds());
 	timeElapsed *= 0.01f;
 	// reflection view param
-	RTReflectionViewParam.ViewMatrix = glm::transpose(ViewMat);
-	RTReflectionViewParam.InvViewMatrix = glm::transpose(InvViewMat);
-	RTReflectionViewParam.ProjMatrix = glm::transpose(ProjMat);
-	RTReflectionViewParam.InvProjMatrix = glm::transpose(InvProjMat);
+	RTReflectionViewParam.ViewMatrix = ViewMatsT.View;
+	RTReflectionViewParam.InvViewMatrix = ViewMatsT.InvView;
+	RTReflectionViewParam.ProjMatrix = ViewMatsT.JitteredProj;
+	RTReflectionViewParam.InvProjMatrix = ViewMatsT.InvProj;
 	RTReflectionViewParam.ProjectionParams.x = Far / (Far - Near);
 	RTReflectionViewParam.ProjectionParams.y = Near / (Near - Far);
 	RTReflectionViewParam.ProjectionParams.z = Near;
@@ -3148,10 +4172,10 @@ void Corona::OnUpdate()
 	RTReflectionViewParam.FrameCounter = FrameCounter;
 
 	// GI view param
-	RTGIViewParam.ViewMatrix = glm::transpose(ViewMat);
-	RTGIViewParam.InvViewMatrix = glm::transpose(InvViewMat);
-	RTGIViewParam.ProjMatrix = glm::transpose(ProjMat);
-	RTGIViewParam.InvProjMatrix = glm::transpose(InvProjMat);
+	RTGIViewParam.ViewMatrix = ViewMatsT.View;
+	RTGIViewParam.InvViewMatrix = ViewMatsT.InvView;
+	RTGIViewParam.ProjMatrix = ViewMatsT.JitteredProj;
+	RTGIViewParam.InvProjMatrix = ViewMatsT.InvProj;
 	RTGIViewParam.ProjectionParams.x = Far / (Far - Near);
 	RTGIViewParam.ProjectionParams.y = Near / (Near - Far);
 	RTGIViewParam.ProjectionParams.z = Near;
@@ -3164,14 +4188,16 @@ void Corona::OnUpdate()
 	SpatialFilterCB.ProjectionParams.w = Far;
 
 
-	TemporalFilterCB.InvViewMatrix = glm::transpose(InvViewMat);
-	TemporalFilterCB.InvProjMatrix = glm::transpose(InvProjMat);
+	TemporalFilterCB.InvViewMatrix = ViewMatsT.InvView;
+	TemporalFilterCB.InvProjMatrix = ViewMatsT.InvProj;
 	TemporalFilterCB.ProjectionParams.z = Near;
 	TemporalFilterCB.ProjectionParams.w = Far;
 	TemporalFilterCB.RTSize.x = RenderWidth;
 	TemporalFilterCB.RTSize.y = RenderHeight;
 	TemporalFilterCB.FrameIndex = FrameCounter;
 
+	UpdateTextureStreaming();
+
 	FrameCounter++;
 
 	if (bRecompileShaders)
@@ -3213,15 +4239,198 @@ void Corona::OnUpdate()
 
 			bResetDLSS = true;
 		}
-#endif
+#endif
+
+		PrevAAMethod = AAMethod;
+	}
+}
+
+// the frame's gpu passes in submission order with the resources they read and write. the scheduler moves
+// compute passes with independent graphics work next to them onto the async compute queue and places the
+// fences, the recording follows its sync points.
+void Corona::RecordFramePasses()
+{
+	ProfileCPUScope("RecordFramePasses");
+
+	bAsyncExposure = bAsyncCompute && AbstractGfxLayer::HasAsyncCompute();
+
+	AsyncScheduler.Clear();
+	AsyncScheduler.SetAsyncEnabled(bAsyncExposure);
+
+	std::vector<std::function<void()>> Records;
+
+	auto AddPass = [&](const char* Name, bool bComputeCapable, std::vector<const void*> Reads, std::vector<const void*> Writes, std::function<void()> Record)
+	{
+		AsyncPassDesc Desc;
+		Desc.Name = Name;
+		Desc.bComputeCapable = bComputeCapable;
+		Desc.Reads = std::move(Reads);
+		Desc.Writes = std::move(Writes);
+
+		// the gpu zone of the same name over the last frames.
+		for (auto& Zone : GPUProfileStats.GetStats())
+		{
+			if (Zone.Name == Name)
+				Desc.EstimatedMs = Zone.AvgMs;
+		}
+
+		AsyncScheduler.AddPass(Desc);
+		Records.push_back(std::move(Record));
+	};
+
+	const UINT W = ColorBufferWriteIndex;
+	const UINT G = GIBufferWriteIndex;
+	GfxTexture* BackBuffer = framebuffers[AbstractGfxLayer::GetCurrentFrameIndex()].get();
+
+	AddPass("UploadInstanceTransforms", false, {}, { InstanceTransformBuffer.get() }, [this] { UploadInstanceTransforms(); });
+
+	if (IsGPUDrivenGBuffer())
+	{
+		AddPass("GPUDrivenCullPass", false, { InstanceTransformBuffer.get(), GPUDrawRecords.get() }, { GPUDrawCount.get(), GPUDrawCommands.get() },
+			[this] { GPUDrivenCullPass(); });
+	}
+
+	if (bAsyncExposure)
+	{
+		AddPass("AsyncExposureAcquire", false, {}, { LumaBuffer.get(), Histogram.get(), ExposureData.get() }, [this] { AsyncExposureAcquirePass(); });
+		AddPass("ExposurePass", true, { LumaBuffer.get() }, { Histogram.get(), ExposureData.get() }, [this] { ExposurePass(); });
+	}
+
+	AddPass("GBufferPass", false, { InstanceTransformBuffer.get(), GPUDrawCommands.get(), GPUDrawCount.get() },
+		{ AlbedoBuffer.get(), NormalBuffers[W].get(), GeomNormalBuffer.get(), VelocityBuffer.get(), RoughnessMetalicBuffer.get(), DepthBuffer.get(), UnjitteredDepthBuffers[W].get() },
+		[this] { GBufferPass(); });
+
+	AddPass("ResolvePixelVelocityPass", false, { VelocityBuffer.get(), DepthBuffer.get() }, { PixelVelocityBuffer.get() }, [this] { ResolvePixelVelocityPass(); });
+
+	AddPass("RaytraceShadowPass", false, { DepthBuffer.get(), GeomNormalBuffer.get() }, { ShadowBuffer.get() }, [this] { RaytraceShadowPass(); });
+
+	if (RayBudgetMode == RAY_BUDGET_ADAPTIVE)
+	{
+		AddPass("RayBudgetClassifyPass", false, { SpeculaGIBufferTemporal[G].get(), DiffuseGISHTemporal[G].get(), VelocityBuffer.get(), RoughnessMetalicBuffer.get() },
+			{ TileRayBudget.get() }, [this] { RayBudgetClassifyPass(); });
+	}
+
+	AddPass("RaytraceReflectionPass", false, { DepthBuffer.get(), GeomNormalBuffer.get(), RoughnessMetalicBuffer.get(), NormalBuffers[W].get(), TileRayBudget.get() },
+		{ SpeculaGIBufferRaw.get() }, [this] { RaytraceReflectionPass(); });
+
+	std::vector<const void*> ProbeTextures;
+#if USE_RTXGI
+	for (RTXGICascade& Cascade : RTXGICascades)
+	{
+		if (!Cascade.volume)
+			continue;
+
+		ProbeTextures.push_back(Cascade.probeRTRadiance.get());
+		ProbeTextures.push_back(Cascade.probeIrradiance.get());
+		ProbeTextures.push_back(Cascade.probeDistance.get());
+		ProbeTextures.push_back(Cascade.probeOffsets.get());
+		ProbeTextures.push_back(Cascade.probeStates.get());
+	}
+#endif
+
+	// the debug view shows both.
+	if (bDebugDraw || DiffuseGIMethod == PATH_TRACING)
+	{
+		AddPass("RaytraceGIPass", false, { DepthBuffer.get(), GeomNormalBuffer.get(), NormalBuffers[W].get(), TileRayBudget.get() },
+			{ DiffuseGISHRaw.get(), DiffuseGICoCgRaw.get() }, [this] { RaytraceGIPass(); });
+	}
+#if USE_RTXGI
+	if (bDebugDraw || DiffuseGIMethod != PATH_TRACING)
+		AddPass("RTXGIPass", false, {}, ProbeTextures, [this] { RTXGIPass(); });
+#endif
+
+	std::vector<const void*> LightingReads = { AlbedoBuffer.get(), NormalBuffers[W].get(), ShadowBuffer.get(), VelocityBuffer.get(), DepthBuffer.get(), RoughnessMetalicBuffer.get() };
+	LightingReads.insert(LightingReads.end(), ProbeTextures.begin(), ProbeTextures.end());
+
+#if USE_NRD
+	if (bNRDDenoising)
+	{
+		AddPass("NRDPass", false, { NormalBuffers[W].get(), RoughnessMetalicBuffer.get(), DepthBuffer.get(), VelocityBuffer.get(), DiffuseGISHRaw.get(), SpeculaGIBufferRaw.get() },
+			{ NormalRoughness_NRD.get(), LinearDepth_NRD.get(), DiffuseGI_NRD.get(), SpecularGI_NRD.get() }, [this] { NRDPass(); });
+
+		LightingReads.insert(LightingReads.end(), { DiffuseGI_NRD.get(), SpecularGI_NRD.get() });
+	}
+	else
+#endif
+	{
+		AddPass("TemporalDenoisingPass", false,
+			{ UnjitteredDepthBuffers[0].get(), UnjitteredDepthBuffers[1].get(), NormalBuffers[0].get(), NormalBuffers[1].get(), VelocityBuffer.get(), RoughnessMetalicBuffer.get(),
+			DiffuseGISHRaw.get(), DiffuseGICoCgRaw.get(), SpeculaGIBufferRaw.get(), DiffuseGISHTemporal[1 - G].get(), DiffuseGICoCgTemporal[1 - G].get(), SpeculaGIBufferTemporal[1 - G].get() },
+			{ DiffuseGISHTemporal[G].get(), DiffuseGICoCgTemporal[G].get(), SpeculaGIBufferTemporal[G].get(), DiffuseGISHSpatial[0].get(), DiffuseGICoCgSpatial[0].get() },
+			[this] { TemporalDenoisingPass(); });
+
+		AddPass("SpatialDenoisingPass", false, { DepthBuffer.get(), GeomNormalBuffer.get() },
+			{ DiffuseGISHSpatial[0].get(), DiffuseGISHSpatial[1].get(), DiffuseGICoCgSpatial[0].get(), DiffuseGICoCgSpatial[1].get() },
+			[this] { SpatialDenoisingPass(); });
+
+		LightingReads.insert(LightingReads.end(), { DiffuseGISHSpatial[0].get(), DiffuseGICoCgSpatial[0].get(), SpeculaGIBufferTemporal[G].get() });
+	}
+
+	AddPass("LightingPass", false, LightingReads, { LightingBuffer.get() }, [this] { LightingPass(); });
+
+	if (bAsyncExposure)
+		AddPass("AsyncExposureRelease", false, {}, { LumaBuffer.get(), Histogram.get(), ExposureData.get() }, [this] { AsyncExposureReleasePass(); });
+
+	std::vector<const void*> BloomWrites = { BloomChain.get(), LumaBuffer.get(), DownsampleCounter.get(), LightingWithBloomBuffer.get() };
+	if (!bAsyncExposure)
+		BloomWrites.insert(BloomWrites.end(), { Histogram.get(), ExposureData.get() });
+	AddPass("BloomPass", false, { LightingBuffer.get(), ExposureData.get() }, BloomWrites, [this] { BloomPass(); });
+
+	if (AAMethod == TEMPORAL_AA || AAMethod == NO_AA)
+	{
+		AddPass("TemporalAAPass", false, { LightingWithBloomBuffer.get(), ColorBuffers[1 - W].get(), VelocityBuffer.get(), DepthBuffer.get(), Histogram.get(), ExposureData.get() },
+			{ ColorBuffers[W].get() }, [this] { TemporalAAPass(); });
+	}
+#if USE_DLSS
+	else if (AAMethod == DLSS)
+	{
+		AddPass("DLSSPass", false, { LightingWithBloomBuffer.get(), VelocityBuffer.get(), DepthBuffer.get(), ExposureData.get() }, { ColorBuffers[W].get() }, [this] { DLSSPass(); });
+	}
+#endif
+
+	AddPass("ToneMapPass", false, { ColorBuffers[W].get(), ExposureData.get() }, { BackBuffer }, [this] { ToneMapPass(); });
+
+	if (bDebugDraw)
+		AddPass("DebugPass", false, {}, { BackBuffer }, [this] { DebugPass(); });
+
+	AsyncScheduler.Solve();
+
+	const std::vector<AsyncScheduledPass>& Schedule = AsyncScheduler.GetSchedule();
+	std::vector<UINT64> SignalValues(Schedule.size(), 0);
+
+	for (UINT i = 0; i < Schedule.size(); i++)
+	{
+		const AsyncScheduledPass& Pass = Schedule[i];
+
+		if (Pass.bWaitPreviousFrame)
+			AbstractGfxLayer::WaitQueue(Pass.Queue, AbstractGfxLayer::GetPreviousFrameFenceValue());
+		if (Pass.WaitForPass >= 0)
+			AbstractGfxLayer::WaitQueue(Pass.Queue, SignalValues[Pass.WaitForPass]);
+
+		if (Pass.Queue == GPUQueue::Compute)
+		{
+			AbstractGfxLayer::BeginAsyncCompute();
+			Records[i]();
+			AbstractGfxLayer::EndAsyncCompute();
+		}
+		else
+		{
+			Records[i]();
+		}
 
-		PrevAAMethod = AAMethod;
+		if (Pass.bSignal)
+			SignalValues[i] = AbstractGfxLayer::SignalQueue(Pass.Queue);
 	}
+
+	if (AsyncScheduler.GetFrameEndWaitForPass() >= 0)
+		AbstractGfxLayer::WaitQueue(GPUQueue::Graphics, SignalValues[AsyncScheduler.GetFrameEndWaitForPass()]);
 }
 
 // Render the scene.
 void Corona::OnRender()
 {
+	ProfileCPUScope("OnRender");
+
 #if VULKAN_RENDERER
 	SimpleDrawPass();
 #else
@@ -3262,9 +4471,9 @@ void Corona::OnRender()
 	DiffuseGISHSpatial[1].get(),
 	DiffuseGICoCgSpatial[0].get(),
 	DiffuseGICoCgSpatial[1].get(),
-	BloomBlurPingPong[0].get(),
-	BloomBlurPingPong[1].get(),
+	BloomChain.get(),
 	LumaBuffer.get(),
+	TileRayBudget.get(),
 
 	};
 
@@ -3272,90 +4481,28 @@ void Corona::OnRender()
 		DynamicTexture.push_back(fb.get());
 
 #if USE_RTXGI
-	if (volume)
-	{
-		DynamicTexture.push_back(probeRTRadiance);
-		DynamicTexture.push_back(probeIrradiance);
-		DynamicTexture.push_back(probeDistance);
-		DynamicTexture.push_back(probeOffsets);
-		DynamicTexture.push_back(probeStates);
-	}
-#endif
-
-	AbstractGfxLayer::BeginFrame(DynamicTexture);
-	
-	// Record all the commands we need to render the scene into the command list.
-
-	GBufferPass();
-
-	ResolvePixelVelocityPass();
-
-
-	RaytraceShadowPass();
-
-
-	RaytraceReflectionPass();
-	
-	if (!bDebugDraw)
-	{
-		if(DiffuseGIMethod == PATH_TRACING)
-			RaytraceGIPass();
-#if USE_RTXGI
-		else
-			RTXGIPass();
-#endif
-	}
-	else
-	{
-		RaytraceGIPass();
-#if USE_RTXGI
-		RTXGIPass();
-#endif
-	}
-#if USE_NRD
-
-	if (bNRDDenoising)
-	{
-		NRDPass();
-	}
-	else
-#endif
+	for (RTXGICascade& Cascade : RTXGICascades)
 	{
-		TemporalDenoisingPass();
-
+		if (!Cascade.volume)
+			continue;
 
-		SpatialDenoisingPass();
+		DynamicTexture.push_back(Cascade.probeRTRadiance);
+		DynamicTexture.push_back(Cascade.probeIrradiance);
+		DynamicTexture.push_back(Cascade.probeDistance);
+		DynamicTexture.push_back(Cascade.probeOffsets);
+		DynamicTexture.push_back(Cascade.probeStates);
 	}
-
-	LightingPass();
-
-	BloomPass();
-	
-	if (AAMethod == TEMPORAL_AA || AAMethod == NO_AA)
-		TemporalAAPass();
-#if USE_DLSS
-	else if (AAMethod == DLSS)
-		DLSSPass();
 #endif
 
-	
-	/*GfxTexture* backbuffer = framebuffers[AbstractGfxLayer::GetCurrentFrameIndex()].get();
+	AbstractGfxLayer::BeginFrame(DynamicTexture);
 
-	{
-		std::array<ResourceTransition, 1> Transition = { {
-		{backbuffer, RESOURCE_STATE_PRESENT, RESOURCE_STATE_RENDER_TARGET},
-		} };
-		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
-	}
-	
-	std::vector<GfxTexture*> Rendertargets = { backbuffer };
-	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), Rendertargets.size(), Rendertargets.data(), nullptr);*/
+	const UINT GPUFrameZone = AbstractGfxLayer::BeginGPUZone(AbstractGfxLayer::GetGlobalCommandList(), "GPUFrame");
 	
-	ToneMapPass();
+	// Record all the commands we need to render the scene into the command list.
 
-	if(bDebugDraw)
-		DebugPass();
+	CullScene();
 
+	RecordFramePasses();
 	
 	if (bShowImgui)
 	{
@@ -3375,6 +4522,9 @@ void Corona::OnRender()
 		ImGui::Begin("Hi, Let's traceray!");
 		ImGui::Text(fps);
 
+		const TimingStats FrameTimes = m_timer.GetFrameTimes().GetStats();
+		ImGui::Text("Frame : %.2f ms, p50 %.2f, p95 %.2f, p99 %.2f", m_timer.GetFrameTimes().GetLastMs(), FrameTimes.P50Ms, FrameTimes.P95Ms, FrameTimes.P99Ms);
+
 		glm::vec4 test = glm::vec4(0, -0, 0, 1) * glm::transpose(UnjitteredViewProjMat);
 		test.x /= test.w;
 		test.y /= test.w;
@@ -3400,16 +4550,18 @@ void Corona::OnRender()
 		ImGui::Checkbox("Draw Distance Texture", &bDrawDistance);
 		ImGui::SliderFloat("Distance Scale", &DistanceScale, 0.1f, 1.0f);
 
-		if (volume)
+		ImGui::SliderInt("Visualized Cascade", &VisualizedCascade, 0, kNumDDGICascades - 1);
+
+		if (RTXGICascades[0].volume)
 		{
+			// applied per frame, RTXGICascadePass compensates it for the update fraction.
 			ImGui::SliderFloat("Probe Hysteresis", &probeHysteresis, 0.1f, 1.0f);
-			volume->SetProbeHysteresis(probeHysteresis);
+			ImGui::SliderFloat("Probe Update Fraction", &probeScheduleParams.UpdateFraction, 0.05f, 1.0f);
+			ImGui::SliderFloat("Probe Near Distance", &probeScheduleParams.NearDistance, 0.0f, 5000.0f);
+			ImGui::SliderInt("Probe Max Age", (int*)&probeScheduleParams.MaxAge, 1, 64);
 
 			ImGui::SliderFloat("Normal Bias", &normalBias, 0.0f, 10.0f);
-			volume->SetNormalBias(normalBias);
-
 			ImGui::SliderFloat("View Bias", &viewBias, 0.1f, 10.0f);
-			volume->SetViewBias(viewBias);
 		}
 #endif
 
@@ -3446,7 +4598,77 @@ void Corona::OnRender()
 			}
 
 		}
-	
+
+		{
+			const char* items[] = {
+					"FULL",
+					"CHECKERBOARD",
+					"QUARTER",
+					"NINTH",
+					"ADAPTIVE"
+			};
+			static_assert(IM_ARRAYSIZE(items) == RAY_BUDGET_MODE_COUNT, "one name per ERayBudgetMode");
+			const char* item_current = items[RayBudgetMode];
+			if (ImGui::BeginCombo("Ray Budget", item_current, 0))
+			{
+				for (int n = 0; n < IM_ARRAYSIZE(items); n++)
+				{
+					bool is_selected = (item_current == items[n]);
+					if (ImGui::Selectable(items[n], is_selected))
+						RayBudgetMode = (ERayBudgetMode)n;
+					if (is_selected)
+					{
+						ImGui::SetItemDefaultFocus();
+					}
+				}
+				ImGui::EndCombo();
+			}
+
+			if (RayBudgetMode == RAY_BUDGET_ADAPTIVE)
+			{
+				ImGui::SliderFloat("Ray Budget High Variance", &RayBudgetClassifyParam.HighVariance, 0.0f, 2.0f);
+				ImGui::SliderFloat("Ray Budget Low Variance", &RayBudgetClassifyParam.LowVariance, 0.0f, 1.0f);
+				ImGui::SliderFloat("Ray Budget Converged History", &RayBudgetClassifyParam.ConvergedHistory, 1.0f, 32.0f);
+				ImGui::SliderFloat("Ray Budget Rough Threshold", &RayBudgetClassifyParam.RoughThreshold, 0.0f, 1.0f);
+			}
+		}
+
+		{
+			const char* items[] = {
+					"CENTER",
+					"BOX",
+					"TRIANGLE",
+					"GAUSSIAN",
+					"BLACKMAN_HARRIS",
+					"SMOOTHSTEP",
+					"B_SPLINE",
+					"CATMULL_ROM",
+					"MITCHELL",
+					"CUBIC",
+					"SINC"
+			};
+			static_assert(IM_ARRAYSIZE(items) == kTAAFilterCount + 1, "one name per FILTER_TYPE");
+			const char* item_current = items[TAAFilterType + 1];
+			if (ImGui::BeginCombo("TAA Filter", item_current, 0))
+			{
+				for (int n = 0; n < IM_ARRAYSIZE(items); n++)
+				{
+					bool is_selected = (item_current == items[n]);
+					if (ImGui::Selectable(items[n], is_selected) && !is_selected)
+					{
+						// the filter is a shader define
+						TAAFilterType = n - 1;
+						bRecompileShaders = true;
+					}
+					if (is_selected)
+					{
+						ImGui::SetItemDefaultFocus();
+					}
+				}
+				ImGui::EndCombo();
+			}
+		}
+
 		/*
 		enum class EDebugVisualization
 		{
@@ -3511,6 +4733,31 @@ void Corona::OnRender()
 			ImGui::EndCombo();
 		}
 
+		if (BlueNoiseTextures.size() > 0)
+		{
+			std::pair<const char*, int*> passes[] = {
+				{ "Reflection Blue Noise", &ReflectionBlueNoiseSet },
+				{ "GI Blue Noise", &GIBlueNoiseSet },
+			};
+			for (auto& pass : passes)
+			{
+				int& set = *pass.second;
+				set = glm::clamp<int>(set, 0, BlueNoiseSetNames.size() - 1);
+				if (ImGui::BeginCombo(pass.first, BlueNoiseSetNames[set].c_str(), 0))
+				{
+					for (int n = 0; n < BlueNoiseSetNames.size(); n++)
+					{
+						bool is_selected = (set == n);
+						if (ImGui::Selectable(BlueNoiseSetNames[n].c_str(), is_selected))
+							set = n;
+						if (is_selected)
+							ImGui::SetItemDefaultFocus();
+					}
+					ImGui::EndCombo();
+				}
+			}
+		}
+
 		{
 			static ImGuiComboFlags flags = 0;
 			const char* items[] = {
@@ -3598,22 +4845,95 @@ void Corona::OnRender()
 		ImGui::SameLine();
 		ImGui::Text("Light Direction");
 
-#if USE_RTXGI
-		ImGui::SliderFloat3("Volume Origin", (float*)&volumeTranslation, -3000, 3000);
-#endif
-
 		ImGui::SliderFloat("Light Brightness", &LightIntensity, 0.0f, 20.0f);
 
 		ImGui::SliderFloat("SponzaRoughness multiplier", &SponzaRoughnessMultiplier, 0.0f, 1.0f);
 		ImGui::SliderFloat("ShaderBallRoughness multiplier", &ShaderBallRoughnessMultiplier, 0.0f, 1.0f);
 
+		ImGui::SliderInt("Texture Budget (MB)", &TextureStreamingBudgetMB, 64, 4096);
+		const TextureStreamer::Stats& StreamingStats = TexStreamer.GetStats();
+		sprintf(fps, "Texture Resident : %.1f MB, Pending : %u", StreamingStats.ResidentBytes / (1024.0f * 1024.0f), StreamingStats.NumPendingRequests);
+		ImGui::Text(fps);
+
+		ImGui::Checkbox("Frustum Culling", &bFrustumCulling);
+		ImGui::Checkbox("Occlusion Culling (previous frame HiZ)", &bOcclusionCulling);
+		ImGui::Checkbox("GPU Driven GBuffer (ExecuteIndirect)", &bGPUDrivenGBuffer);
+		ImGui::Checkbox("Bindless GBuffer Materials", &bBindlessGBuffer);
+		sprintf(fps, "Draws : %u / %u", SceneCullingStats.NumVisible, SceneCullingStats.NumTested);
+		ImGui::Text(fps);
+		sprintf(fps, "Frustum Culled : %u, Occlusion Culled : %u", SceneCullingStats.NumFrustumCulled, SceneCullingStats.NumOcclusionCulled);
+		ImGui::Text(fps);
+		sprintf(fps, "Material Binds : %u, Mesh Binds : %u", GBufferBindStats.NumMaterialBinds, GBufferBindStats.NumGeometryBinds);
+		ImGui::Text(fps);
+
+		if (ImGui::Button("Capture Trace (60 frames)") && TraceCaptureFrames == 0)
+		{
+			ProfileTrace.Clear();
+			TraceCaptureFrames = 60;
+			TraceCaptureStatus = "capturing";
+		}
+		ImGui::SameLine();
+		ImGui::Text("%s", TraceCaptureStatus.c_str());
+
+		if (ImGui::Button(bRecordingCameraPath ? "Stop Camera Path" : "Record Camera Path"))
+		{
+			if (bRecordingCameraPath)
+			{
+				string Error;
+				if (RecordedCameraPath.WriteFile("CameraPath.txt", Error))
+					CameraPathStatus = "CameraPath.txt : " + std::to_string(RecordedCameraPath.GetKeys().size()) + " keys";
+				else
+					CameraPathStatus = Error;
+			}
+			else
+			{
+				RecordedCameraPath.Clear();
+				CameraPathRecordStart = m_timer.GetTotalSeconds();
+				CameraPathStatus = "recording";
+			}
+			bRecordingCameraPath = !bRecordingCameraPath;
+		}
+		ImGui::SameLine();
+		ImGui::Text("%s", CameraPathStatus.c_str());
+
+		ImGui::SliderInt("Frames In Flight", &MaxFramesInFlight, 1, 3);
+		if (const FramePacer* Pacer = AbstractGfxLayer::GetFramePacer())
+		{
+			const TimingStats ToPresent = Pacer->GetInputToPresent().GetStats();
+			const TimingStats ToRetire = Pacer->GetInputToRetire().GetStats();
+			const TimingStats Wait = Pacer->GetWaitTimes().GetStats();
+			ImGui::Text("Input to present p50 %.2f p95 %.2f ms, to gpu done p50 %.2f p95 %.2f ms, wait p50 %.2f ms",
+				ToPresent.P50Ms, ToPresent.P95Ms, ToRetire.P50Ms, ToRetire.P95Ms, Wait.P50Ms);
+		}
+
+		ImGui::Checkbox("Async Compute", &bAsyncCompute);
+		for (UINT i = 0; i < AsyncScheduler.GetNumPasses(); i++)
+		{
+			const AsyncScheduledPass& Pass = AsyncScheduler.GetSchedule()[i];
+			if (Pass.Queue == GPUQueue::Compute)
+				ImGui::Text("  %s on compute, overlaps %.2f ms of graphics work", AsyncScheduler.GetPass(i).Name, Pass.OverlapMs);
+			else if (AsyncScheduler.GetPass(i).bComputeCapable)
+				ImGui::Text("  %s on graphics, %s", AsyncScheduler.GetPass(i).Name, Pass.Reason);
+		}
+
+		ImGui::Checkbox("Profiler (last / min / avg / p95 / max ms)", &bShowProfiler);
+		if (bShowProfiler)
+		{
+			ImGui::Text("GPU");
+			for (auto& Zone : GPUProfileStats.GetStats())
+				ImGui::Text("%*s%-24s %6.2f %6.2f %6.2f %6.2f %6.2f", int(Zone.Depth * 2), "", Zone.Name.c_str(), Zone.LastMs, Zone.MinMs, Zone.AvgMs, Zone.P95Ms, Zone.MaxMs);
+			ImGui::Text("CPU");
+			for (auto& Zone : CPUProfileStats.GetStats())
+				ImGui::Text("%*s%-24s %6.2f %6.2f %6.2f %6.2f %6.2f", int(Zone.Depth * 2), "", Zone.Name.c_str(), Zone.LastMs, Zone.MinMs, Zone.AvgMs, Zone.P95Ms, Zone.MaxMs);
+		}
+
 
 		ImGui::SliderFloat("IndirectDiffuse Depth Weight Factor", &SpatialFilterCB.IndirectDiffuseWeightFactorDepth, 0.0f, 20.0f);
 		ImGui::SliderFloat("IndirectDiffuse Normal Weight Factor", &SpatialFilterCB.IndirectDiffuseWeightFactorNormal, 0.0f, 20.0f);
 
 		ImGui::SliderFloat("TemporalValidParams.x", &TemporalFilterCB.TemporalValidParams.x, 0.0f, 128);
 
-		ImGui::SliderFloat("BloomSigma", &BloomSigma, 0.0f, 2.0f);
+		ImGui::SliderFloat("BloomScatter", &BloomScatter, 0.0f, 1.0f);
 
 		ImGui::SliderFloat("BloomThreshHold", &BloomCB.BloomThreshHold, 0.0f, 2.0f);
 
@@ -3626,6 +4946,11 @@ void Corona::OnRender()
 		ImGui::SliderFloat("MinExposure", &AdaptExposureCB.MinExposure, -8.0f, 0.0f);
 		ImGui::SliderFloat("MaxExposure", &AdaptExposureCB.MaxExposure, 0.0f, 8.0f);
 
+		if (ImGui::SliderFloat("Histogram MinLog", &HistogramMinLog, -20.0f, HistogramMaxLog - 1.0f))
+			bResetHistogramRange = true;
+		if (ImGui::SliderFloat("Histogram MaxLog", &HistogramMaxLog, HistogramMinLog + 1.0f, 20.0f))
+			bResetHistogramRange = true;
+
 		ImGui::SliderFloat("BayerRotScale", &TemporalFilterCB.BayerRotScale, 0.0f, 1.0f);
 
 		ImGui::SliderFloat("SpecularBlurRadius", &TemporalFilterCB.SpecularBlurRadius, 0.0f, 5.0f);
@@ -3680,6 +5005,9 @@ void Corona::OnRender()
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
 
+	AbstractGfxLayer::EndGPUZone(AbstractGfxLayer::GetGlobalCommandList(), GPUFrameZone);
+	AbstractGfxLayer::ResolveGPUZones(AbstractGfxLayer::GetGlobalCommandList());
+
 	AbstractGfxLayer::ExecuteCommandList(AbstractGfxLayer::GetGlobalCommandList());
 
 	AbstractGfxLayer::EndFrame();
@@ -3694,6 +5022,8 @@ void Corona::OnRender()
 
 void Corona::OnDestroy()
 {
+	TexStreamer.Shutdown();
+
 	AbstractGfxLayer::WaitGPUFlush();
 
 #if USE_IMGUI
@@ -3740,7 +5070,7 @@ void Corona::OnKeyDown(UINT8 key)
 		break;
 	case 'C':
 		ClampMode++;
-		ClampMode = ClampMode % 3;
+		ClampMode = ClampMode % TAA_CLAMP_MODE_COUNT;
 		break;
 	case 'R':
 		RecompileShaders();
@@ -3787,64 +5117,118 @@ struct ParallelDrawTaskSet : enki::ITaskSet
 	}
 };
 
-void Corona::DrawScene(shared_ptr<Scene> scene, float Roughness, float Metalic, bool bOverrideRoughnessMetallic)
+void Corona::AddSceneToGBufferQueue(shared_ptr<Scene> scene, float Roughness, float Metalic, bool bOverrideRoughnessMetallic)
 {
 	for (auto& mesh : scene->meshes)
 	{
-		AbstractGfxLayer::SetIndexBuffer(AbstractGfxLayer::GetGlobalCommandList(), mesh->Ib.get());
-		AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, mesh->Vb.get());
-
-		for (int i = 0; i < mesh->Draws.size(); i++)
+		for (auto& drawcall : mesh->Draws)
 		{
-			GfxMesh::DrawCall& drawcall = mesh->Draws[i];
-			GBufferConstantBuffer objCB;
-			int sizea = sizeof(GBufferConstantBuffer);
+			if (!DrawVisibility[drawcall.CullIndex])
+				continue;
+
+			const UINT Index = drawcall.CullIndex;
+			const glm::vec3 Center = glm::vec3(SceneBounds.MinX[Index] + SceneBounds.MaxX[Index],
+				SceneBounds.MinY[Index] + SceneBounds.MaxY[Index], SceneBounds.MinZ[Index] + SceneBounds.MaxZ[Index]) * 0.5f;
+			const float Depth = glm::length(Center - m_camera.m_position);
+
+			GBufferDrawItem Item;
+			Item.scene = scene.get();
+			Item.mesh = mesh.get();
+			Item.drawcall = &drawcall;
+			Item.Roughness = Roughness;
+			Item.Metallic = Metalic;
+			Item.bOverrideRoughnessMetallic = bOverrideRoughnessMetallic;
+
+			const UINT Pass = drawcall.mat->bHasAlpha ? DRAW_PASS_ALPHA_TEST : DRAW_PASS_OPAQUE;
+			GBufferQueue.Add(MakeDrawSortKey(Pass, 0, drawcall.mat->SortID, Depth), UINT(GBufferDrawItems.size()));
+			GBufferDrawItems.push_back(Item);
+		}
+	}
+}
 
-			objCB.ViewProjectionMatrix = glm::transpose(ViewProjMat);
-			objCB.PrevViewProjectionMatrix = glm::transpose(PrevViewProjMat);
+void Corona::DrawGBufferQueue()
+{
+	GBufferQueue.Sort();
 
-			//glm::mat4 m; // Identity matrix
-			objCB.WorldMatrix = glm::transpose(mesh->transform);
+	const bool bBindless = IsBindlessGBuffer();
+	if (bBindless)
+		UpdateBindlessMaterials();
+	GfxPipelineStateObject* PSO = bBindless ? GBufferBindlessPSO.get() : GBufferPassPSO.get();
 
-			objCB.UnjitteredViewProjMat = glm::transpose(UnjitteredViewProjMat);
-			objCB.PrevUnjitteredViewProjMat = glm::transpose(PrevUnjitteredViewProjMat);
-			objCB.ViewDir.x = m_camera.m_lookDirection.x;
-			objCB.ViewDir.y = m_camera.m_lookDirection.y;
-			objCB.ViewDir.z = m_camera.m_lookDirection.z;
+	RedundantBindFilter Filter;
+	Filter.Reset();
 
-			objCB.RTSize.x = RenderWidth;
-			objCB.RTSize.y = RenderHeight;
+	for (size_t i = 0; i < GBufferQueue.Size(); i++)
+	{
+		const GBufferDrawItem& Item = GBufferDrawItems[GBufferQueue.GetItem(i)];
+		GfxMesh* mesh = Item.mesh;
+		GfxMesh::DrawCall& drawcall = *Item.drawcall;
+
+		// one gbuffer pso for now, the pso field of the key is 0 for every draw.
+		if (Filter.SetPSO(PSO))
+		{
+			AbstractGfxLayer::SetPSO(PSO, AbstractGfxLayer::GetGlobalCommandList());
+			AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), PSO, samplerAnisoWrap.get());
 
-			objCB.RougnessMetalic.x = Roughness;
-			objCB.RougnessMetalic.y = Metalic;
+			if (bBindless)
+			{
+				AbstractGfxLayer::SetReadBuffer(PSO, "Materials", BindlessMaterialBuffers[AbstractGfxLayer::GetCurrentFrameIndex()].get(), AbstractGfxLayer::GetGlobalCommandList());
+				AbstractGfxLayer::SetReadTextureTable(PSO, "MaterialTextures", BindlessTextureTable.get(), AbstractGfxLayer::GetGlobalCommandList());
+			}
+		}
 
-			objCB.bOverrideRougnessMetallic = bOverrideRoughnessMetallic ? 1 : 0;
+		// the constant buffer only holds per mesh values, a scene's parameters are the same for all its meshes.
+		if (Filter.SetGeometry(mesh))
+		{
+			AbstractGfxLayer::SetIndexBuffer(AbstractGfxLayer::GetGlobalCommandList(), mesh->Ib.get());
+			AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, mesh->Vb.get());
+			AbstractGfxLayer::SetReadBuffer(PSO, "InstanceTransforms", InstanceTransformBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
 
-			AbstractGfxLayer::SetUniformValue(GBufferPassPSO.get(), "GBufferConstantBuffer", &objCB, AbstractGfxLayer::GetGlobalCommandList());
+			GBufferConstantBuffer objCB;
 
-			GfxTexture* AlbedoTex = drawcall.mat->Diffuse.get();
-			if (AlbedoTex)
-				AbstractGfxLayer::SetReadTexture(GBufferPassPSO.get(), "AlbedoTex", AlbedoTex, AbstractGfxLayer::GetGlobalCommandList());
+			objCB.ViewProjectionMatrix = ViewMatsT.ViewProj;
+			objCB.PrevViewProjectionMatrix = ViewMatsT.PrevViewProj;
 
+			objCB.UnjitteredViewProjMat = ViewMatsT.UnjitteredViewProj;
+			objCB.PrevUnjitteredViewProjMat = ViewMatsT.PrevUnjitteredViewProj;
+			objCB.ViewDir.x = m_camera.m_lookDirection.x;
+			objCB.ViewDir.y = m_camera.m_lookDirection.y;
+			objCB.ViewDir.z = m_camera.m_lookDirection.z;
 
-			GfxTexture* NormalTex = drawcall.mat->Normal.get();
-			if (NormalTex)
-				AbstractGfxLayer::SetReadTexture(GBufferPassPSO.get(), "NormalTex", NormalTex, AbstractGfxLayer::GetGlobalCommandList());
+			objCB.RTSize.x = RenderWidth;
+			objCB.RTSize.y = RenderHeight;
 
+			objCB.RougnessMetalic.x = Item.Roughness;
+			objCB.RougnessMetalic.y = Item.Metallic;
 
-			GfxTexture* RoughnessTex = drawcall.mat->Roughness.get();
-			if (RoughnessTex)
-				AbstractGfxLayer::SetReadTexture(GBufferPassPSO.get(), "RoughnessTex", RoughnessTex, AbstractGfxLayer::GetGlobalCommandList());
+			objCB.bOverrideRougnessMetallic = Item.bOverrideRoughnessMetallic ? 1 : 0;
 
-			GfxTexture* MetallicTex = drawcall.mat->Metallic.get();
-			if (MetallicTex)
-				AbstractGfxLayer::SetReadTexture(GBufferPassPSO.get(), "MetallicTex", MetallicTex, AbstractGfxLayer::GetGlobalCommandList());
+			objCB.InstanceBase = Item.scene->InstanceBase;
 
+			AbstractGfxLayer::SetUniformValue(PSO, "GBufferConstantBuffer", &objCB, AbstractGfxLayer::GetGlobalCommandList());
+		}
 
-			//AbstractGfxLayer::GetGlobalCommandList()->CmdList->DrawIndexedInstanced(drawcall.IndexCount, 1, drawcall.IndexStart, drawcall.VertexBase, 0);
-			AbstractGfxLayer::DrawIndexedInstanced(AbstractGfxLayer::GetGlobalCommandList(), drawcall.IndexCount, 1, drawcall.IndexStart, drawcall.VertexBase, 0);
+		if (Filter.SetMaterial(drawcall.mat.get()))
+		{
+			if (bBindless)
+			{
+				AbstractGfxLayer::SetRootConstant(PSO, "BindlessDraw", drawcall.mat->BindlessIndex, AbstractGfxLayer::GetGlobalCommandList());
+			}
+			else
+			{
+				AbstractGfxLayer::SetReadTexture(PSO, "AlbedoTex", drawcall.mat->Diffuse.get(), AbstractGfxLayer::GetGlobalCommandList());
+				AbstractGfxLayer::SetReadTexture(PSO, "NormalTex", drawcall.mat->Normal.get(), AbstractGfxLayer::GetGlobalCommandList());
+				AbstractGfxLayer::SetReadTexture(PSO, "RoughnessTex", drawcall.mat->Roughness.get(), AbstractGfxLayer::GetGlobalCommandList());
+				AbstractGfxLayer::SetReadTexture(PSO, "MetallicTex", drawcall.mat->Metallic.get(), AbstractGfxLayer::GetGlobalCommandList());
+			}
 		}
+
+		// the vertex shader reads the world matrix of SV_InstanceID from InstanceTransforms.
+		AbstractGfxLayer::DrawIndexedInstanced(AbstractGfxLayer::GetGlobalCommandList(), drawcall.IndexCount, Item.scene->Instances.Size(), drawcall.IndexStart, drawcall.VertexBase, 0);
+		Filter.CountDraw();
 	}
+
+	GBufferBindStats = Filter.GetStats();
 }
 
 void Corona::GBufferPass()
@@ -3854,8 +5238,8 @@ void Corona::GBufferPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "GBufferPass");
 #endif
-	//ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "GBufferPass");
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "GBufferPass");
+	//ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "GBufferPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "GBufferPass");
 	{
 		std::array<ResourceTransition, 7> Transition = { {
 		{AlbedoBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_RENDER_TARGET},
@@ -3902,16 +5286,49 @@ void Corona::GBufferPass()
 		UnjitteredDepthBuffers[ColorBufferWriteIndex].get()};
 	AbstractGfxLayer::SetRenderTargets(AbstractGfxLayer::GetGlobalCommandList(), GBufferPassPSO.get(), Rendertarget.size(), Rendertarget.data(), DepthBuffer.get());
 
-	AbstractGfxLayer::SetPSO(GBufferPassPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	if (IsGPUDrivenGBuffer())
+	{
+		AbstractGfxLayer::SetPSO(GBufferIndirectPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+
+		AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), GBufferIndirectPSO.get(), samplerAnisoWrap.get());
+
+		// the per draw part comes from DrawData.
+		GBufferConstantBuffer objCB;
+		objCB.ViewProjectionMatrix = ViewMatsT.ViewProj;
+		objCB.PrevViewProjectionMatrix = ViewMatsT.PrevViewProj;
+		objCB.UnjitteredViewProjMat = ViewMatsT.UnjitteredViewProj;
+		objCB.PrevUnjitteredViewProjMat = ViewMatsT.PrevUnjitteredViewProj;
+		objCB.ViewDir.x = m_camera.m_lookDirection.x;
+		objCB.ViewDir.y = m_camera.m_lookDirection.y;
+		objCB.ViewDir.z = m_camera.m_lookDirection.z;
+		objCB.RTSize.x = RenderWidth;
+		objCB.RTSize.y = RenderHeight;
 
-	AbstractGfxLayer::SetSampler("samplerWrap", AbstractGfxLayer::GetGlobalCommandList(), GBufferPassPSO.get(), samplerAnisoWrap.get());
+		AbstractGfxLayer::SetUniformValue(GBufferIndirectPSO.get(), "GBufferConstantBuffer", &objCB, AbstractGfxLayer::GetGlobalCommandList());
+		// the same sliders AddSceneToGBufferQueue passes per draw, in the order of InitGPUDrivenScene.
+		GPUDrivenSceneCB SceneCB;
+		SceneCB.SceneMaterial[0] = glm::vec4(SponzaRoughnessMultiplier, 0, 0, 0);
+		SceneCB.SceneMaterial[1] = glm::vec4(ShaderBallRoughnessMultiplier, 1, 1, 0);
 
-	if (!bMultiThreadRendering)
+		AbstractGfxLayer::SetUniformValue(GBufferIndirectPSO.get(), "GPUDrivenScene", &SceneCB, AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadBuffer(GBufferIndirectPSO.get(), "DrawData", GPUDrawDataBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadBuffer(GBufferIndirectPSO.get(), "InstanceTransforms", InstanceTransformBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+		AbstractGfxLayer::SetReadTextureTable(GBufferIndirectPSO.get(), "MaterialTextures", MaterialTextureTable.get(), AbstractGfxLayer::GetGlobalCommandList());
+
+		AbstractGfxLayer::SetIndexBuffer(AbstractGfxLayer::GetGlobalCommandList(), MergedIb.get());
+		AbstractGfxLayer::SetVertexBuffer(AbstractGfxLayer::GetGlobalCommandList(), 0, 1, MergedVb.get());
+
+		AbstractGfxLayer::ExecuteIndirect(AbstractGfxLayer::GetGlobalCommandList(), GBufferCommandSignature.get(), GPUScene.GetNumDraws(), GPUDrawCommands.get(), GPUDrawCount.get());
+	}
+	else if (!bMultiThreadRendering)
 	{
+		GBufferQueue.Clear();
+		GBufferDrawItems.clear();
 
-		
-		DrawScene(Sponza, SponzaRoughnessMultiplier, 0, false);
-		DrawScene(ShaderBall, ShaderBallRoughnessMultiplier, 1, true);
+		AddSceneToGBufferQueue(Sponza, SponzaRoughnessMultiplier, 0, false);
+		AddSceneToGBufferQueue(ShaderBall, ShaderBallRoughnessMultiplier, 1, true);
+
+		DrawGBufferQueue();
 	}
 	else
 	{
@@ -3973,6 +5390,9 @@ void Corona::GBufferPass()
 		} };
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
+
+	if (bOcclusionCulling)
+		HiZReducePass();
 }
 
 void Corona::SpatialDenoisingPass()
@@ -3980,7 +5400,7 @@ void Corona::SpatialDenoisingPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "SpatialDenoisingPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "SpatialDenoisingPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "SpatialDenoisingPass");
 
 	UINT WriteIndex = 0;
 	UINT ReadIndex = 1;
@@ -4031,7 +5451,7 @@ void Corona::TemporalDenoisingPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "TemporalDenoisingPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "TemporalDenoisingPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "TemporalDenoisingPass");
 
 	// GIBufferSH : full scale
 	// FilterIndirectDiffusePingPongSH : 3x3 downsample
@@ -4095,7 +5515,7 @@ void Corona::TemporalDenoisingPass()
 #if USE_NRD
 void Corona::NRDPass()
 {
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "NRDPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "NRDPass");
 
 	// resolve normal-roughness 
 	{
@@ -4116,7 +5536,7 @@ void Corona::NRDPass()
 	AbstractGfxLayer::SetWriteTexture(ResolveNormalRoughnessPSO.get(), "LinearDepth", LinearDepth_NRD.get(), AbstractGfxLayer::GetGlobalCommandList());
 
 	ResolveNRDParam param;
-	param.InvProjMatrix = glm::transpose(InvProjMat);
+	param.InvProjMatrix = ViewMatsT.InvProj;
 	param.Near = Near;
 	param.Far = Far;
 
@@ -4285,10 +5705,10 @@ void Corona::NRDPass()
 	//vec2 jitterPrev = m_Settings.temporal ? m_Camera.m_ViewportJitterPrev : 0.0f;
 
 	nrd::CommonSettings commonSettings = {};
-	memcpy(commonSettings.worldToViewMatrix, &glm::transpose(InvViewMat), sizeof(glm::mat4x4));
-	memcpy(commonSettings.worldToViewMatrixPrev, &glm::transpose(InvViewMat), sizeof(glm::mat4x4));
+	memcpy(commonSettings.worldToViewMatrix, &ViewMatsT.InvView, sizeof(glm::mat4x4));
+	memcpy(commonSettings.worldToViewMatrixPrev, &ViewMatsT.InvView, sizeof(glm::mat4x4));
 
-	memcpy(commonSettings.viewToClipMatrix, &glm::transpose(ProjMat), sizeof(glm::mat4x4));
+	memcpy(commonSettings.viewToClipMatrix, &ViewMatsT.JitteredProj, sizeof(glm::mat4x4));
 	memcpy(commonSettings.viewToClipMatrixPrev, &glm::transpose(PrevProjMat), sizeof(glm::mat4x4));
 
 	commonSettings.metersToUnitsMultiplier = 1000;// / m_Settings.unitsToMetersMultiplier;
@@ -4347,6 +5767,7 @@ void Corona::RecompileShaders()
 
 #if USE_RTXGI
 	InitRTXGI();
+	PlaceRTXGIProbes();
 #endif
 
 	InitSpatialDenoisingPass();
@@ -4357,6 +5778,10 @@ void Corona::RecompileShaders()
 	InitLightingPass();
 	InitTemporalAAPass();
 	InitBloomPass();
+	InitRayReconstructPass();
+	InitRayBudgetClassifyPass();
+	InitHiZReducePass();
+	InitGPUDrivenCullPass();
 #endif
 
 	InitSimpleDraw();
@@ -4367,23 +5792,44 @@ void Corona::InitRaytracingData()
 	UINT NumTotalMesh = Sponza->meshes.size() + ShaderBall->meshes.size();
 	vecBLAS.reserve(NumTotalMesh);
 
-	AddMeshToVec(vecBLAS, Sponza);
-	AddMeshToVec(vecBLAS, ShaderBall);
+	// one blas per mesh, every instance of the scene adds a tlas instance of it. InstanceID() is the
+	// instance slot, the hit group record stays the one of the blas.
+	vector<GfxRTInstance> RTInstances;
+	for (auto& scene : { Sponza, ShaderBall })
+	{
+		const UINT BLASBase = vecBLAS.size();
+		AddMeshToVec(vecBLAS, scene);
+
+		for (UINT Instance = 0; Instance < scene->Instances.Size(); Instance++)
+		{
+			// meshes without a blas were skipped by AddMeshToVec.
+			for (UINT i = BLASBase; i < vecBLAS.size(); i++)
+			{
+				GfxRTInstance RTInstance;
+				RTInstance.BLASIndex = i;
+				RTInstance.InstanceID = scene->InstanceBase + Instance;
+				RTInstance.Transform = scene->Instances.Get(Instance);
+				RTInstances.push_back(RTInstance);
+			}
+		}
+	}
 
-	TLAS = shared_ptr<GfxRTAS>(AbstractGfxLayer::CreateTLAS(vecBLAS));
+	TLAS = shared_ptr<GfxRTAS>(AbstractGfxLayer::CreateTLAS(vecBLAS, RTInstances));
 
-	InstancePropertyBuffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(500, sizeof(InstanceProperty), HEAP_TYPE_UPLOAD, RESOURCE_STATE_GENERIC_READ, RESOURCE_FLAG_NONE));
+	InstancePropertyBuffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(NumInstanceSlots, sizeof(InstanceProperty), HEAP_TYPE_UPLOAD, RESOURCE_STATE_GENERIC_READ, RESOURCE_FLAG_NONE));
 	NAME_BUFFER(InstancePropertyBuffer);
 
 
 	uint8_t* pData;
 	AbstractGfxLayer::MapBuffer(InstancePropertyBuffer.get(), (void**)&pData);
 
-	for (auto& m : vecBLAS)
+	for (auto& scene : { Sponza, ShaderBall })
 	{
-		glm::mat4x4 mat = glm::transpose(m->mesh->transform);
-		memcpy(pData, &mat, sizeof(glm::mat4x4));
-		pData += sizeof(InstanceProperty);
+		for (UINT Instance = 0; Instance < scene->Instances.Size(); Instance++)
+		{
+			glm::mat4x4 mat = glm::transpose(scene->Instances.Get(Instance));
+			memcpy(pData + (scene->InstanceBase + Instance) * sizeof(InstanceProperty), &mat, sizeof(glm::mat4x4));
+		}
 	}
 
 	AbstractGfxLayer::UnmapBuffer(InstancePropertyBuffer.get());
@@ -4642,163 +6088,37 @@ void Corona::InitRTXGI()
 	{
 		ComPtr<ID3DBlob> shaderByteCode;
 
-		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeBorderUpdateCS.hlsl"), L"DDGIProbeBorderColumnUpdateCS", L"cs_6_0", nullopt);
-		shaders.push_back(shaderByteCode);
-	}
-
-	// RTXGI probe relocation
-	{
-		ComPtr<ID3DBlob> shaderByteCode;
-
-		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeRelocationCS.hlsl"), L"DDGIProbeRelocationCS", L"cs_6_0", nullopt);
-		shaders.push_back(shaderByteCode);
-	}
-
-	// RTXGI probe state classifier
-	{
-		ComPtr<ID3DBlob> shaderByteCode;
-
-		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeStateClassifierCS.hlsl"), L"DDGIProbeStateClassifierCS", L"cs_6_0", nullopt);
-		shaders.push_back(shaderByteCode);
-	}
-
-	// RTXGI probe state classifier, activate all probes
-	{
-		ComPtr<ID3DBlob> shaderByteCode;
-
-		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeStateClassifierCS.hlsl"), L"DDGIProbeStateActivateAllCS", L"cs_6_0", nullopt);
-		shaders.push_back(shaderByteCode);
-	}
-
-
-	// create Volume
-
-	volumeDesc.origin = { 0.f, 0.f, 0.f };
-	int mul = 1;
-	volumeDesc.probeGridCounts = { 40* mul, 16 * mul, 20 * mul };
-
-	volumeDesc.probeGridSpacing = { 100, 100, 100 };
-	//volumeDesc.viewBias = 4.0f;
-	//volumeDesc.normalBias = 1.0f;
-	volumeDesc.probeMaxRayDistance = 10000.0f;
-	volumeDesc.probeBrightnessThreshold = 2.00f;
-	volumeDesc.probeChangeThreshold = 0.2;
-	volumeDesc.numRaysPerProbe = 144;
-	volumeDesc.numIrradianceTexels = 6;
-	volumeDesc.numDistanceTexels = 14;
-	//volumeDesc.probeHysteresis = 0.97;
-	//volumeDesc.probeIrradianceEncodingGamma = 5;
-
-	UINT size = rtxgi::GetDDGIVolumeConstantBufferSize() * 3;   // sized to triple buffer the data
-
-	VolumeCB = dx12_rhi->CreateBuffer(size, sizeof(InstanceProperty), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_FLAG_NONE);
-
-	NAME_D3D12_OBJECT(VolumeCB->resource);
-
-
-	UINT width = 0;
-	UINT height = 0;
-
-	// probe radiance
-	rtxgi::GetDDGIVolumeTextureDimensions(volumeDesc, rtxgi::EDDGITextureType::RTRadiance, width, height);
-	DXGI_FORMAT format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::RTRadiance);
-	probeRTRadiance = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
-		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
-		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, width, height, 1)));
-	NAME_TEXTURE(probeRTRadiance);
-
-	volumeResources.probeRTRadiance = probeRTRadiance->resource.Get();
-
-	
-	// probe irradiance
-	rtxgi::GetDDGIVolumeTextureDimensions(volumeDesc, rtxgi::EDDGITextureType::Irradiance, width, height);
-	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Irradiance);
-	probeIrradiance = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
-		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
-		RESOURCE_STATE_PIXEL_SHADER_RESOURCE, width, height, 1)));
-	NAME_TEXTURE(probeIrradiance);
-
-	volumeResources.probeIrradiance = probeIrradiance->resource.Get();
-
-	// probe distance
-	rtxgi::GetDDGIVolumeTextureDimensions(volumeDesc, rtxgi::EDDGITextureType::Distance, width, height);
-	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Distance);
-	probeDistance = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
-		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
-		RESOURCE_STATE_PIXEL_SHADER_RESOURCE, width, height, 1)));
-	NAME_TEXTURE(probeDistance);
-	
-	volumeResources.probeDistance = probeDistance->resource.Get();
-	
-
-	// probe offsets
-	rtxgi::GetDDGIVolumeTextureDimensions(volumeDesc, rtxgi::EDDGITextureType::Offsets, width, height);
-	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Offsets);
-	probeOffsets = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
-		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
-		RESOURCE_STATE_UNORDERED_ACCESS, width, height, 1)));
-	NAME_TEXTURE(probeOffsets);
-
-	volumeResources.probeOffsets = probeOffsets->resource.Get();
-	
-
-	// probe states
-	rtxgi::GetDDGIVolumeTextureDimensions(volumeDesc, rtxgi::EDDGITextureType::States, width, height);
-	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::States);
-	probeStates = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
-		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
-		RESOURCE_STATE_UNORDERED_ACCESS, width, height, 1)));
-	NAME_TEXTURE(probeStates);
+		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeBorderUpdateCS.hlsl"), L"DDGIProbeBorderColumnUpdateCS", L"cs_6_0", nullopt);
+		shaders.push_back(shaderByteCode);
+	}
 
-	volumeResources.probeStates = probeStates->resource.Get();
+	// RTXGI probe relocation
+	{
+		ComPtr<ID3DBlob> shaderByteCode;
 
+		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeRelocationCS.hlsl"), L"DDGIProbeRelocationCS", L"cs_6_0", nullopt);
+		shaders.push_back(shaderByteCode);
+	}
 
-	// create descriptors
-	UINT DescriptorSize = dx12_rhi->TextureDHRing->DescriptorSize;
-	dx12_rhi->TextureDHRing->AllocDescriptor(volumeDescriptorTableCPUHandle, volumeDescriptorTableGPUHandle, 5); // descriptor table size is 5
-	//DHOfsset = volumeDescriptorTableCPUHandle.ptr;
-	volumeResources.descriptorHeap = dx12_rhi->SRVCBVDescriptorHeapShaderVisible->DH.Get();
-	volumeResources.descriptorHeapDescSize = dx12_rhi->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	volumeResources.descriptorHeapOffset = volumeDescriptorTableCPUHandle.ptr;
+	// RTXGI probe state classifier
+	{
+		ComPtr<ID3DBlob> shaderByteCode;
 
-	D3D12_CPU_DESCRIPTOR_HANDLE probeRTRadianceHandleCPU = volumeDescriptorTableCPUHandle;
-	// Create the RT radiance UAV 
-	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
-	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::RTRadiance);
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-	dx12_rhi->Device->CreateUnorderedAccessView(probeRTRadiance->resource.Get(), nullptr, &uavDesc, probeRTRadianceHandleCPU);
+		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeStateClassifierCS.hlsl"), L"DDGIProbeStateClassifierCS", L"cs_6_0", nullopt);
+		shaders.push_back(shaderByteCode);
+	}
 
-	// irradiance
-	D3D12_CPU_DESCRIPTOR_HANDLE probeIrradianceHandleCPU = volumeDescriptorTableCPUHandle;
-	probeIrradianceHandleCPU.ptr += DescriptorSize * 1;
-	uavDesc = {};
-	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Irradiance);
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-	dx12_rhi->Device->CreateUnorderedAccessView(probeIrradiance->resource.Get(), nullptr, &uavDesc, probeIrradianceHandleCPU);
+	// RTXGI probe state classifier, activate all probes
+	{
+		ComPtr<ID3DBlob> shaderByteCode;
 
-	// distance
-	D3D12_CPU_DESCRIPTOR_HANDLE probeDistanceHandleCPU = volumeDescriptorTableCPUHandle;
-	probeDistanceHandleCPU.ptr += DescriptorSize * 2;
-	uavDesc = {};
-	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Distance);
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-	dx12_rhi->Device->CreateUnorderedAccessView(probeDistance->resource.Get(), nullptr, &uavDesc, probeDistanceHandleCPU);
+		shaderByteCode = dx12_rhi->CreateShaderDXC(GetAssetFullPath(L"Shaders/rtxgi/ddgi/ProbeStateClassifierCS.hlsl"), L"DDGIProbeStateActivateAllCS", L"cs_6_0", nullopt);
+		shaders.push_back(shaderByteCode);
+	}
 
-	// offsets
-	D3D12_CPU_DESCRIPTOR_HANDLE probeOffsetsHandleCPU = volumeDescriptorTableCPUHandle;
-	probeOffsetsHandleCPU.ptr += DescriptorSize * 3;
-	uavDesc = {};
-	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Offsets);
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-	dx12_rhi->Device->CreateUnorderedAccessView(probeOffsets->resource.Get(), nullptr, &uavDesc, probeOffsetsHandleCPU);
 
-	// states
-	D3D12_CPU_DESCRIPTOR_HANDLE probeStatesHandleCPU = volumeDescriptorTableCPUHandle;
-	probeStatesHandleCPU.ptr += DescriptorSize * 4;
-	uavDesc = {};
-	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::States);
-	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
-	dx12_rhi->Device->CreateUnorderedAccessView(probeStates->resource.Get(), nullptr, &uavDesc, probeStatesHandleCPU);
+	// root signature and psos shared by every cascade
+	rtxgi::DDGIVolumeResources SharedResources = {};
 
 	ComPtr<ID3DBlob> signature;
 	rtxgi::GetDDGIVolumeRootSignatureDesc(0, &signature); // will use zero descriptorHeapOffset, because we will seperated descriptor table for volume
@@ -4807,13 +6127,13 @@ void Corona::InitRTXGI()
 		assert(false);
 	}
 
-	HRESULT hr = dx12_rhi->Device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&volumeResources.rootSignature));
+	HRESULT hr = dx12_rhi->Device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&SharedResources.rootSignature));
 	if (FAILED(hr))
 	{
 		assert(false);
 
 	}
-	volumeResources.rootSignature->SetName(L"volumeResources.rootSignature");
+	SharedResources.rootSignature->SetName(L"SharedResources.rootSignature");
 
 	// create volume pso
 
@@ -4821,9 +6141,9 @@ void Corona::InitRTXGI()
 	D3D12_COMPUTE_PIPELINE_STATE_DESC psoDesc = {};
 	psoDesc.CS.BytecodeLength = shaders[0]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[0]->GetBufferPointer();
-	psoDesc.pRootSignature = volumeResources.rootSignature;
+	psoDesc.pRootSignature = SharedResources.rootSignature;
 
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeRadianceBlendingPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeRadianceBlendingPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
@@ -4832,7 +6152,7 @@ void Corona::InitRTXGI()
 	// Create the distance blending PSO
 	psoDesc.CS.BytecodeLength = shaders[1]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[1]->GetBufferPointer();
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeDistanceBlendingPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeDistanceBlendingPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
@@ -4841,7 +6161,7 @@ void Corona::InitRTXGI()
 	// Create the border row PSO
 	psoDesc.CS.BytecodeLength = shaders[2]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[2]->GetBufferPointer();
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeBorderRowPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeBorderRowPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
@@ -4850,7 +6170,7 @@ void Corona::InitRTXGI()
 	// Create the border column PSO
 	psoDesc.CS.BytecodeLength = shaders[3]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[3]->GetBufferPointer();
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeBorderColumnPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeBorderColumnPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
@@ -4859,7 +6179,7 @@ void Corona::InitRTXGI()
 	// Create the probe relocation PSO
 	psoDesc.CS.BytecodeLength = shaders[4]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[4]->GetBufferPointer();
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeRelocationPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeRelocationPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
@@ -4868,7 +6188,7 @@ void Corona::InitRTXGI()
 	// Create the probe classifier PSO
 	psoDesc.CS.BytecodeLength = shaders[5]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[5]->GetBufferPointer();
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeStateClassifierPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeStateClassifierPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
@@ -4877,27 +6197,49 @@ void Corona::InitRTXGI()
 	// Create the probe classifier activate all PSO
 	psoDesc.CS.BytecodeLength = shaders[6]->GetBufferSize();
 	psoDesc.CS.pShaderBytecode = shaders[6]->GetBufferPointer();
-	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&volumeResources.probeStateClassifierActivateAllPSO));
+	hr = dx12_rhi->Device->CreateComputePipelineState(&psoDesc, IID_PPV_ARGS(&SharedResources.probeStateClassifierActivateAllPSO));
 	if (FAILED(hr))
 	{
 		assert(false);
 	}
 
 
-	rtxgi::ERTXGIStatus status = rtxgi::ERTXGIStatus::OK;
-
-	volume = shared_ptr<rtxgi::DDGIVolume>(new rtxgi::DDGIVolume("Scene Volume"));
+	// create cascades, each one a ddgi volume following the camera
+	DDGICascadeParam.NumCascades = kNumDDGICascades;
+	DDGICascadeLayout.Init(DDGICascadeParam);
+	// placed around the camera now, so the probes placed on the cpu are not scrolled in again on the first frame.
+	DDGICascadeLayout.Update(m_camera.m_position);
 
+	for (uint32_t i = 0; i < kNumDDGICascades; i++)
+		InitRTXGICascade(i, SharedResources);
 
-	volume->volumeDescriptorTableGPUHandle = volumeDescriptorTableGPUHandle;
-	// Create the DDGIVolume
-	status = volume->Create(volumeDesc, volumeResources);
-	if (status != rtxgi::ERTXGIStatus::OK)
 	{
-		assert(false);
+		SHADER_CREATE_DESC csDesc =
+		{
+			GetAssetFullPath(L"Shaders\\"),		L"DDGIProbeScheduleCS.hlsl", L"DDGIProbeMarkNotTraced", L"cs_6_0", nullopt
+		};
+
+		COMPUTE_PIPELINE_STATE_DESC computePsoDesc = {};
+
+		computePsoDesc.csDesc = &csDesc;
+
+		GfxPipelineStateObject* TEMP_ProbeMarkNotTracedPSO = AbstractGfxLayer::CreatePSO();
+
+		AbstractGfxLayer::BindUAV(TEMP_ProbeMarkNotTracedPSO, "DDGIProbeRTRadiance", 0);
+		AbstractGfxLayer::BindUAV(TEMP_ProbeMarkNotTracedPSO, "DDGIProbeOffsets", 1);
+		AbstractGfxLayer::BindUAV(TEMP_ProbeMarkNotTracedPSO, "DDGIProbeStates", 2);
+		AbstractGfxLayer::BindCBV(TEMP_ProbeMarkNotTracedPSO, "ProbeScheduleCB", 0, sizeof(ProbeScheduleCB));
+		AbstractGfxLayer::BindCBV(TEMP_ProbeMarkNotTracedPSO, "DDGIVolume", 1, rtxgi::GetDDGIVolumeConstantBufferSize());
+
+		bool bSuccess = AbstractGfxLayer::InitPSO(TEMP_ProbeMarkNotTracedPSO, &computePsoDesc);
+
+		if (bSuccess)
+			ProbeMarkNotTracedPSO = shared_ptr<GfxPipelineStateObject>(TEMP_ProbeMarkNotTracedPSO);
 	}
 
-	// gi rtpso
+
+	// gi rtpso, one per cascade so each keeps its own shader table.
+	for (RTXGICascade& Cascade : RTXGICascades)
 	{
 		shared_ptr<RTPipelineStateObject> TEMP_PSO = shared_ptr<RTPipelineStateObject>(new RTPipelineStateObject);
 		TEMP_PSO->NumInstance = vecBLAS.size();// scene->meshes.size();
@@ -4918,6 +6260,7 @@ void Corona::InitRTXGI()
 		//TEMP_PSO->BindSRV("global", "DDGIProbeStates", 3);
 		//TEMP_PSO->BindSRV("global", "DDGIProbeOffsets", 4);
 		TEMP_PSO->BindSRV("global", "BlueNoiseTex", 5);
+		TEMP_PSO->BindSRV("global", "ScheduledProbes", 6);
 
 		TEMP_PSO->BindCBV("global", "DDGIVolume", 0, sizeof(rtxgi::DDGIVolumeDesc));
 		TEMP_PSO->BindCBV("global", "LightInfoCB", 1, sizeof(LightInfoCB));
@@ -4947,9 +6290,245 @@ void Corona::InitRTXGI()
 
 		if (bSuccess)
 		{
-			PSO_RT_PROBE = TEMP_PSO;
+			Cascade.PSO_RT_PROBE = TEMP_PSO;
+		}
+	}
+}
+
+void Corona::InitRTXGICascade(uint32_t CascadeIndex, const rtxgi::DDGIVolumeResources& SharedResources)
+{
+	RTXGICascade& Cascade = RTXGICascades[CascadeIndex];
+	const DDGICascade& Layout = DDGICascadeLayout.GetCascade(CascadeIndex);
+
+	// create Volume
+	Cascade.volumeResources = SharedResources;
+
+	// placed by DDGICascadeLayout every frame
+	Cascade.volumeDesc.origin = { Layout.Grid.Origin.x, Layout.Grid.Origin.y, Layout.Grid.Origin.z };
+	Cascade.volumeDesc.probeGridCounts = { Layout.Grid.Counts.x, Layout.Grid.Counts.y, Layout.Grid.Counts.z };
+	Cascade.volumeDesc.probeGridSpacing = { Layout.Grid.Spacing.x, Layout.Grid.Spacing.y, Layout.Grid.Spacing.z };
+	//Cascade.volumeDesc.viewBias = 4.0f;
+	//Cascade.volumeDesc.normalBias = 1.0f;
+	Cascade.volumeDesc.probeMaxRayDistance = 10000.0f;
+	Cascade.volumeDesc.probeBrightnessThreshold = 2.00f;
+	Cascade.volumeDesc.probeChangeThreshold = 0.2;
+	Cascade.volumeDesc.numRaysPerProbe = 144;
+	Cascade.volumeDesc.numIrradianceTexels = 6;
+	Cascade.volumeDesc.numDistanceTexels = 14;
+	//Cascade.volumeDesc.probeHysteresis = 0.97;
+	//Cascade.volumeDesc.probeIrradianceEncodingGamma = 5;
+
+	UINT size = rtxgi::GetDDGIVolumeConstantBufferSize() * 3;   // sized to triple buffer the data
+
+	Cascade.VolumeCB = dx12_rhi->CreateBuffer(size, sizeof(InstanceProperty), D3D12_HEAP_TYPE_UPLOAD, D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_FLAG_NONE);
+
+	NAME_D3D12_OBJECT(Cascade.VolumeCB->resource);
+
+
+	UINT width = 0;
+	UINT height = 0;
+
+	// probe radiance
+	rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::RTRadiance, width, height);
+	DXGI_FORMAT format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::RTRadiance);
+	Cascade.probeRTRadiance = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
+		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
+		RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, width, height, 1)));
+	NAME_TEXTURE(Cascade.probeRTRadiance);
+
+	Cascade.volumeResources.probeRTRadiance = Cascade.probeRTRadiance->resource.Get();
+
+	
+	// probe irradiance
+	rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::Irradiance, width, height);
+	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Irradiance);
+	Cascade.probeIrradiance = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
+		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
+		RESOURCE_STATE_PIXEL_SHADER_RESOURCE, width, height, 1)));
+	NAME_TEXTURE(Cascade.probeIrradiance);
+
+	Cascade.volumeResources.probeIrradiance = Cascade.probeIrradiance->resource.Get();
+
+	// probe distance
+	rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::Distance, width, height);
+	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Distance);
+	Cascade.probeDistance = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
+		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
+		RESOURCE_STATE_PIXEL_SHADER_RESOURCE, width, height, 1)));
+	NAME_TEXTURE(Cascade.probeDistance);
+	
+	Cascade.volumeResources.probeDistance = Cascade.probeDistance->resource.Get();
+	
+
+	// probe offsets, written by PlaceRTXGIProbes before the first frame
+	rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::Offsets, width, height);
+	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Offsets);
+	Cascade.probeOffsets = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
+		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
+		RESOURCE_STATE_COPY_DEST, width, height, 1)));
+	NAME_TEXTURE(Cascade.probeOffsets);
+
+	Cascade.volumeResources.probeOffsets = Cascade.probeOffsets->resource.Get();
+	
+
+	// probe states
+	rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::States, width, height);
+	format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::States);
+	Cascade.probeStates = shared_ptr<Texture>(static_cast<Texture*>(AbstractGfxLayer::CreateTexture2D(static_cast<FORMAT>(format), 
+		RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS, 
+		RESOURCE_STATE_COPY_DEST, width, height, 1)));
+	NAME_TEXTURE(Cascade.probeStates);
+
+	Cascade.volumeResources.probeStates = Cascade.probeStates->resource.Get();
+
+
+	// create descriptors
+	UINT DescriptorSize = dx12_rhi->TextureDHRing->DescriptorSize;
+	dx12_rhi->TextureDHRing->AllocDescriptor(Cascade.volumeDescriptorTableCPUHandle, Cascade.volumeDescriptorTableGPUHandle, 5); // descriptor table size is 5
+	//DHOfsset = Cascade.volumeDescriptorTableCPUHandle.ptr;
+	Cascade.volumeResources.descriptorHeap = dx12_rhi->SRVCBVDescriptorHeapShaderVisible->DH.Get();
+	Cascade.volumeResources.descriptorHeapDescSize = dx12_rhi->Device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+	Cascade.volumeResources.descriptorHeapOffset = Cascade.volumeDescriptorTableCPUHandle.ptr;
+
+	D3D12_CPU_DESCRIPTOR_HANDLE probeRTRadianceHandleCPU = Cascade.volumeDescriptorTableCPUHandle;
+	// Create the RT radiance UAV 
+	D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::RTRadiance);
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	dx12_rhi->Device->CreateUnorderedAccessView(Cascade.probeRTRadiance->resource.Get(), nullptr, &uavDesc, probeRTRadianceHandleCPU);
+
+	// irradiance
+	D3D12_CPU_DESCRIPTOR_HANDLE probeIrradianceHandleCPU = Cascade.volumeDescriptorTableCPUHandle;
+	probeIrradianceHandleCPU.ptr += DescriptorSize * 1;
+	uavDesc = {};
+	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Irradiance);
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	dx12_rhi->Device->CreateUnorderedAccessView(Cascade.probeIrradiance->resource.Get(), nullptr, &uavDesc, probeIrradianceHandleCPU);
+
+	// distance
+	D3D12_CPU_DESCRIPTOR_HANDLE probeDistanceHandleCPU = Cascade.volumeDescriptorTableCPUHandle;
+	probeDistanceHandleCPU.ptr += DescriptorSize * 2;
+	uavDesc = {};
+	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Distance);
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	dx12_rhi->Device->CreateUnorderedAccessView(Cascade.probeDistance->resource.Get(), nullptr, &uavDesc, probeDistanceHandleCPU);
+
+	// offsets
+	D3D12_CPU_DESCRIPTOR_HANDLE probeOffsetsHandleCPU = Cascade.volumeDescriptorTableCPUHandle;
+	probeOffsetsHandleCPU.ptr += DescriptorSize * 3;
+	uavDesc = {};
+	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Offsets);
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	dx12_rhi->Device->CreateUnorderedAccessView(Cascade.probeOffsets->resource.Get(), nullptr, &uavDesc, probeOffsetsHandleCPU);
+
+	// states
+	D3D12_CPU_DESCRIPTOR_HANDLE probeStatesHandleCPU = Cascade.volumeDescriptorTableCPUHandle;
+	probeStatesHandleCPU.ptr += DescriptorSize * 4;
+	uavDesc = {};
+	uavDesc.Format = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::States);
+	uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+	dx12_rhi->Device->CreateUnorderedAccessView(Cascade.probeStates->resource.Get(), nullptr, &uavDesc, probeStatesHandleCPU);
+
+	rtxgi::ERTXGIStatus status = rtxgi::ERTXGIStatus::OK;
+
+	Cascade.volume = shared_ptr<rtxgi::DDGIVolume>(new rtxgi::DDGIVolume("Scene Volume " + std::to_string(CascadeIndex)));
+
+
+	Cascade.volume->volumeDescriptorTableGPUHandle = Cascade.volumeDescriptorTableGPUHandle;
+	// Create the DDGIVolume
+	status = Cascade.volume->Create(Cascade.volumeDesc, Cascade.volumeResources);
+	if (status != rtxgi::ERTXGIStatus::OK)
+	{
+		assert(false);
+	}
+
+	// probe update scheduling
+	Cascade.probeScheduler.Init(Cascade.volume->GetNumProbes());
+
+	for (auto& Buffer : Cascade.ScheduledProbesBuffer)
+	{
+		Buffer = shared_ptr<GfxBuffer>(AbstractGfxLayer::CreateByteAddressBuffer(Cascade.volume->GetNumProbes(), sizeof(UINT32), HEAP_TYPE_UPLOAD, RESOURCE_STATE_GENERIC_READ, RESOURCE_FLAG_NONE));
+		NAME_BUFFER(Buffer);
+	}
+}
+
+void Corona::PlaceRTXGIProbes()
+{
+	auto StartTime = std::chrono::steady_clock::now();
+
+	// the geometry does not change, so it survives shader recompiles.
+	if (ProbeGeometry.GetNumTriangles() == 0)
+	{
+		for (auto& scene : { Sponza, ShaderBall })
+		{
+			if (!scene)
+				continue;
+
+			for (UINT Instance = 0; Instance < scene->Instances.Size(); Instance++)
+				for (auto& mesh : scene->meshes)
+					ProbeGeometry.AddMesh(mesh->CPUPositions, mesh->CPUNormals, mesh->CPUIndices, scene->Instances.Get(Instance));
+		}
+		ProbeBVH.Build(ProbeGeometry);
+	}
+
+	const bool bHalfOffsets = rtxgi::GetDDGIVolumeTextureFormat(rtxgi::EDDGITextureType::Offsets) == DXGI_FORMAT_R16G16B16A16_FLOAT;
+
+	for (uint32_t i = 0; i < kNumDDGICascades; i++)
+	{
+		RTXGICascade& Cascade = RTXGICascades[i];
+		const DDGICascade& Layout = DDGICascadeLayout.GetCascade(i);
+
+		ProbePlacementParams Params = probePlacementParams;
+		Params.NumRaysPerProbe = Cascade.volume->GetNumRaysPerProbe();
+		Params.BackfaceThreshold = Cascade.volumeDesc.probeBackfaceThreshold;
+		Params.MinFrontfaceDistance = Cascade.volumeDesc.probeMinFrontfaceDistance;
+
+		std::vector<glm::vec4> Offsets;
+		std::vector<uint8_t> States;
+		ProbePlacementStats Stats;
+		PlaceProbesCPU(Params, Layout.Grid, ProbeBVH, Offsets, States, &Stats, &g_TS);
+
+		// storage index order is the texel order of both textures.
+		UINT width = 0;
+		UINT height = 0;
+		rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::Offsets, width, height);
+
+		// the offsets texture is fp16 unless RTXGI_DDGI_DEBUG_FORMAT_OFFSETS is set.
+		std::vector<glm::uint64> HalfOffsets;
+		SUBRESOURCE_DATA OffsetsData;
+		OffsetsData.pData = Offsets.data();
+		OffsetsData.RowPitch = width * sizeof(glm::vec4);
+		if (bHalfOffsets)
+		{
+			HalfOffsets.resize(Offsets.size());
+			for (size_t p = 0; p < Offsets.size(); p++)
+				HalfOffsets[p] = glm::packHalf4x16(Offsets[p]);
+			OffsetsData.pData = HalfOffsets.data();
+			OffsetsData.RowPitch = width * sizeof(glm::uint64);
 		}
+		OffsetsData.SlicePitch = OffsetsData.RowPitch * height;
+		AbstractGfxLayer::UploadSRCData3D(Cascade.probeOffsets.get(), &OffsetsData);
+
+		rtxgi::GetDDGIVolumeTextureDimensions(Cascade.volumeDesc, rtxgi::EDDGITextureType::States, width, height);
+		SUBRESOURCE_DATA StatesData;
+		StatesData.pData = States.data();
+		StatesData.RowPitch = width * sizeof(uint8_t);
+		StatesData.SlicePitch = StatesData.RowPitch * height;
+		AbstractGfxLayer::UploadSRCData3D(Cascade.probeStates.get(), &StatesData);
+
+		Cascade.bPlacementUploaded = true;
+
+		stringstream ss;
+		ss << "DDGI cascade " << i << " : " << Stats.NumProbes << " probes, " << Stats.NumMoved << " moved, "
+			<< Stats.NumInactive << " inactive, " << Stats.NumRays << " rays\n";
+		OutputDebugStringA(ss.str().c_str());
 	}
+
+	float PlaceTimeMs = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - StartTime).count();
+
+	stringstream ss;
+	ss << "DDGI probe placement : " << ProbeGeometry.GetNumTriangles() << " triangles, " << PlaceTimeMs << " ms\n";
+	OutputDebugStringA(ss.str().c_str());
 }
 #endif
 
@@ -5022,6 +6601,7 @@ void Corona::InitRTPSO()
 		AbstractGfxLayer::BindSRV(TEMP_PSO_RT_REFLECTION.get(), "global", "RougnessMetallicTex", 6);
 		AbstractGfxLayer::BindSRV(TEMP_PSO_RT_REFLECTION.get(), "global", "BlueNoiseTex", 7);
 		AbstractGfxLayer::BindSRV(TEMP_PSO_RT_REFLECTION.get(), "global", "WorldNormalTex", 8);
+		AbstractGfxLayer::BindSRV(TEMP_PSO_RT_REFLECTION.get(), "global", "TileRayBudgetTex", 10);
 		AbstractGfxLayer::BindCBV(TEMP_PSO_RT_REFLECTION.get(), "global", "ViewParameter", 0, sizeof(RTReflectionViewParam));
 		AbstractGfxLayer::BindSampler(TEMP_PSO_RT_REFLECTION.get(), "global", "samplerWrap", 0);
 		AbstractGfxLayer::AddShader(TEMP_PSO_RT_REFLECTION.get(), "miss", MISS);
@@ -5063,6 +6643,7 @@ void Corona::InitRTPSO()
 		AbstractGfxLayer::BindCBV(TEMP_PSO_RT_GI.get(), "global", "ViewParameter", 0, sizeof(RTGIViewParam));
 		AbstractGfxLayer::BindSampler(TEMP_PSO_RT_GI.get(), "global", "samplerWrap", 0);
 		AbstractGfxLayer::BindSRV(TEMP_PSO_RT_GI.get(), "global", "BlueNoiseTex", 7);
+		AbstractGfxLayer::BindSRV(TEMP_PSO_RT_GI.get(), "global", "TileRayBudgetTex", 8);
 		AbstractGfxLayer::AddShader(TEMP_PSO_RT_GI.get(), "miss", MISS);
 		AbstractGfxLayer::AddShader(TEMP_PSO_RT_GI.get(), "missShadow", MISS);
 		AbstractGfxLayer::AddShader(TEMP_PSO_RT_GI.get(), "chs", HIT);
@@ -5094,7 +6675,7 @@ void Corona::RaytraceShadowPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "RaytraceShadowPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand()%255, rand() % 255, rand() % 255), "RaytraceShadowPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RaytraceShadowPass");
 
 	{
 		std::array<ResourceTransition, 1> Transition = { {
@@ -5148,12 +6729,129 @@ void Corona::RaytraceShadowPass()
 	}
 }
 
+void Corona::RayBudgetClassifyPass()
+{
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RayBudgetClassifyPass");
+
+	{
+		std::array<ResourceTransition, 1> Transition = { {
+			{TileRayBudget.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+
+	RayBudgetClassifyParam.RTSize = glm::vec2(RenderWidth, RenderHeight);
+	RayBudgetClassifyParam.NumTilesX = (RenderWidth + kRayBudgetTileSize - 1) / kRayBudgetTileSize;
+	RayBudgetClassifyParam.NumTilesY = (RenderHeight + kRayBudgetTileSize - 1) / kRayBudgetTileSize;
+
+	AbstractGfxLayer::SetPSO(RayBudgetClassifyPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+
+	// GIBufferWriteIndex still points at last frame's temporal denoiser output.
+	AbstractGfxLayer::SetReadTexture(RayBudgetClassifyPSO.get(), "SpecularTemporalTex", SpeculaGIBufferTemporal[GIBufferWriteIndex].get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(RayBudgetClassifyPSO.get(), "DiffuseSHTemporalTex", DiffuseGISHTemporal[GIBufferWriteIndex].get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(RayBudgetClassifyPSO.get(), "VelocityTex", VelocityBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(RayBudgetClassifyPSO.get(), "RoughnessMetalicTex", RoughnessMetalicBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTexture(RayBudgetClassifyPSO.get(), "TileRayBudget", TileRayBudget.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetUniformValue(RayBudgetClassifyPSO.get(), "RayBudgetClassifyCB", &RayBudgetClassifyParam, AbstractGfxLayer::GetGlobalCommandList());
+
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), RayBudgetClassifyParam.NumTilesX, RayBudgetClassifyParam.NumTilesY, 1);
+
+	{
+		std::array<ResourceTransition, 1> Transition = { {
+			{TileRayBudget.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+}
+
+void Corona::HiZReducePass()
+{
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "HiZReducePass");
+
+	{
+		std::array<ResourceTransition, 1> Transition = { {
+			{HiZReduceBuffer.get(), RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE, RESOURCE_STATE_UNORDERED_ACCESS},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+
+	HiZReduceCB CB;
+	CB.DepthWidth = RenderWidth;
+	CB.DepthHeight = RenderHeight;
+
+	AbstractGfxLayer::SetPSO(HiZReducePSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(HiZReducePSO.get(), "DepthTex", DepthBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteBuffer(HiZReducePSO.get(), "HiZ", HiZReduceBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetUniformValue(HiZReducePSO.get(), "HiZReduceCB", &CB, AbstractGfxLayer::GetGlobalCommandList());
+
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (kHiZWidth + 7) / 8, (kHiZHeight + 7) / 8, 1);
+
+	{
+		std::array<ResourceTransition, 1> Transition = { {
+			{HiZReduceBuffer.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_COPY_SOURCE},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+
+	HiZReadback& Readback = HiZReadbacks[AbstractGfxLayer::GetCurrentFrameIndex()];
+	AbstractGfxLayer::CopyBuffer(AbstractGfxLayer::GetGlobalCommandList(), Readback.Buffer.get(), HiZReduceBuffer.get());
+	Readback.ViewProj = ViewProjMat;
+	Readback.bValid = true;
+
+	{
+		std::array<ResourceTransition, 1> Transition = { {
+			{HiZReduceBuffer.get(), RESOURCE_STATE_COPY_SOURCE, RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | RESOURCE_STATE_PIXEL_SHADER_RESOURCE},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+}
+
+void Corona::GPUDrivenCullPass()
+{
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "GPUDrivenCullPass");
+
+	{
+		std::array<ResourceTransition, 2> Transition = { {
+			{GPUDrawCommands.get(), RESOURCE_STATE_INDIRECT_ARGUMENT, RESOURCE_STATE_UNORDERED_ACCESS},
+			{GPUDrawCount.get(), RESOURCE_STATE_INDIRECT_ARGUMENT, RESOURCE_STATE_UNORDERED_ACCESS},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+
+	AbstractGfxLayer::SetPSO(ClearDrawCountPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteBuffer(ClearDrawCountPSO.get(), "DrawCount", GPUDrawCount.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), 1, 1, 1);
+
+	AbstractGfxLayer::UAVBarrier(AbstractGfxLayer::GetGlobalCommandList(), GPUDrawCount.get());
+
+	GPUDrivenCullCB CB;
+	GetFrustumPlanes(ViewProjMat, CB.Planes);
+	CB.NumDraws = GPUScene.GetNumDraws();
+	CB.bFrustumCulling = bFrustumCulling ? 1 : 0;
+
+	AbstractGfxLayer::SetPSO(GPUDrivenCullPSO.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadBuffer(GPUDrivenCullPSO.get(), "DrawRecords", GPUDrawRecords.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteBuffer(GPUDrivenCullPSO.get(), "DrawCommands", GPUDrawCommands.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteBuffer(GPUDrivenCullPSO.get(), "DrawCount", GPUDrawCount.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetUniformValue(GPUDrivenCullPSO.get(), "GPUDrivenCullCB", &CB, AbstractGfxLayer::GetGlobalCommandList());
+
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (CB.NumDraws + 63) / 64, 1, 1);
+
+	{
+		std::array<ResourceTransition, 2> Transition = { {
+			{GPUDrawCommands.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_INDIRECT_ARGUMENT},
+			{GPUDrawCount.get(), RESOURCE_STATE_UNORDERED_ACCESS, RESOURCE_STATE_INDIRECT_ARGUMENT},
+		} };
+		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
+	}
+}
+
 void Corona::RaytraceReflectionPass()
 {
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "RaytraceReflectionPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "RaytraceReflectionPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RaytraceReflectionPass");
 
 	{
 		std::array<ResourceTransition, 1> Transition = { {
@@ -5169,10 +6867,15 @@ void Corona::RaytraceReflectionPass()
 	AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "DepthTex", DepthBuffer.get());
 	AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "GeoNormalTex", GeomNormalBuffer.get());
 	AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "RougnessMetallicTex", RoughnessMetalicBuffer.get());
-	AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "BlueNoiseTex", BlueNoiseTex.get());
+	if (GfxTexture* BlueNoiseTex = GetBlueNoiseTexture(ReflectionBlueNoiseSet))
+		AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "BlueNoiseTex", BlueNoiseTex);
 	AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "WorldNormalTex", NormalBuffers[ColorBufferWriteIndex].get());
+	AbstractGfxLayer::SetSRV(PSO_RT_REFLECTION.get(), "global", "TileRayBudgetTex", TileRayBudget.get());
 
 	RTReflectionViewParam.ViewSpreadAngle = glm::tan(Fov * 0.5) / (0.5f * RenderHeight);
+	RTReflectionViewParam.RayBudgetMode = RayBudgetMode;
+	RTReflectionViewParam.RTWidth = RenderWidth;
+	RTReflectionViewParam.RTHeight = RenderHeight;
 	AbstractGfxLayer::SetCBVValue(PSO_RT_REFLECTION.get(), "global", "ViewParameter", &RTReflectionViewParam);
 	AbstractGfxLayer::SetSampler(PSO_RT_REFLECTION.get(), "global", "samplerWrap", samplerBilinearWrap.get());
 
@@ -5199,7 +6902,11 @@ void Corona::RaytraceReflectionPass()
 
 	AbstractGfxLayer::EndShaderTable(PSO_RT_REFLECTION.get(), vecBLAS.size());
 
-	AbstractGfxLayer::DispatchRay(PSO_RT_REFLECTION.get(), RenderWidth, RenderHeight, AbstractGfxLayer::GetGlobalCommandList(), vecBLAS.size());
+	RayBudgetPoint DispatchSize = GetRayDispatchSize(RayBudgetMode, RenderWidth, RenderHeight);
+	AbstractGfxLayer::DispatchRay(PSO_RT_REFLECTION.get(), DispatchSize.x, DispatchSize.y, AbstractGfxLayer::GetGlobalCommandList(), vecBLAS.size());
+
+	if (RayBudgetMode != RAY_BUDGET_FULL)
+		RayReconstructPass(RayReconstructReflectionPSO.get(), SpeculaGIBufferRaw.get(), nullptr, RTReflectionViewParam.ProjectionParams, RTReflectionViewParam.FrameCounter);
 
 	{
 		std::array<ResourceTransition, 1> Transition = { {
@@ -5214,7 +6921,7 @@ void Corona::RaytraceGIPass()
 #if USE_AFTERMATH
 	NVAftermathMarker(dx12_rhi->AM_CL_Handle, "RaytraceGIPass");
 #endif
-	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), PIX_COLOR(rand() % 255, rand() % 255, rand() % 255), "RaytraceGIPass");
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RaytraceGIPass");
 
 	{
 		std::array<ResourceTransition, 2> Transition = { {
@@ -5231,7 +6938,9 @@ void Corona::RaytraceGIPass()
 	AbstractGfxLayer::SetSRV(PSO_RT_GI.get(), "global", "gRtScene", TLAS.get());
 	AbstractGfxLayer::SetSRV(PSO_RT_GI.get(), "global", "DepthTex", DepthBuffer.get());
 	AbstractGfxLayer::SetSRV(PSO_RT_GI.get(), "global", "WorldNormalTex", NormalBuffers[ColorBufferWriteIndex].get());
-	AbstractGfxLayer::SetSRV(PSO_RT_GI.get(), "global", "BlueNoiseTex", BlueNoiseTex.get());
+	if (GfxTexture* BlueNoiseTex = GetBlueNoiseTexture(GIBlueNoiseSet))
+		AbstractGfxLayer::SetSRV(PSO_RT_GI.get(), "global", "BlueNoiseTex", BlueNoiseTex);
+	AbstractGfxLayer::SetSRV(PSO_RT_GI.get(), "global", "TileRayBudgetTex", TileRayBudget.get());
 	
 	RTGIViewParam.ViewSpreadAngle = glm::tan(Fov * 0.5) / (0.5f * RenderHeight);
 
@@ -5242,6 +6951,10 @@ void Corona::RaytraceGIPass()
 #endif
 		RTGIViewParam.bPackNRD = 0;
 
+	RTGIViewParam.RayBudgetMode = RayBudgetMode;
+	RTGIViewParam.RTWidth = RenderWidth;
+	RTGIViewParam.RTHeight = RenderHeight;
+
 	AbstractGfxLayer::SetCBVValue(PSO_RT_GI.get(), "global", "ViewParameter", &RTGIViewParam);
 	AbstractGfxLayer::SetSampler(PSO_RT_GI.get(), "global", "samplerWrap", samplerBilinearWrap.get());
 
@@ -5269,7 +6982,11 @@ void Corona::RaytraceGIPass()
 	AbstractGfxLayer::EndShaderTable(PSO_RT_GI.get(), vecBLAS.size());
 
 
-	AbstractGfxLayer::DispatchRay(PSO_RT_GI.get(), RenderWidth, RenderHeight, AbstractGfxLayer::GetGlobalCommandList(), vecBLAS.size());
+	RayBudgetPoint DispatchSize = GetRayDispatchSize(RayBudgetMode, RenderWidth, RenderHeight);
+	AbstractGfxLayer::DispatchRay(PSO_RT_GI.get(), DispatchSize.x, DispatchSize.y, AbstractGfxLayer::GetGlobalCommandList(), vecBLAS.size());
+
+	if (RayBudgetMode != RAY_BUDGET_FULL)
+		RayReconstructPass(RayReconstructGIPSO.get(), DiffuseGISHRaw.get(), DiffuseGICoCgRaw.get(), RTGIViewParam.ProjectionParams, RTGIViewParam.FrameCounter);
 
 	{
 		std::array<ResourceTransition, 2> Transition = { {
@@ -5279,3 +6996,32 @@ void Corona::RaytraceGIPass()
 		AbstractGfxLayer::TransitionResource(AbstractGfxLayer::GetGlobalCommandList(), Transition.size(), Transition.data());
 	}
 }
+
+void Corona::RayReconstructPass(GfxPipelineStateObject* PSO, GfxTexture* Target0, GfxTexture* Target1, const glm::vec4& ProjectionParams, UINT32 FrameIndex)
+{
+	ProfileGPUScope(AbstractGfxLayer::GetGlobalCommandList(), "RayReconstructPass");
+
+	// the rays write the traced pixels, the reconstruction reads them.
+	AbstractGfxLayer::UAVBarrier(AbstractGfxLayer::GetGlobalCommandList(), Target0);
+	if (Target1)
+		AbstractGfxLayer::UAVBarrier(AbstractGfxLayer::GetGlobalCommandList(), Target1);
+
+	RayReconstructCB CB;
+	CB.ProjectionParams = ProjectionParams;
+	CB.RayBudgetMode = RayBudgetMode;
+	CB.FrameIndex = FrameIndex;
+	CB.RTWidth = RenderWidth;
+	CB.RTHeight = RenderHeight;
+
+	AbstractGfxLayer::SetPSO(PSO, AbstractGfxLayer::GetGlobalCommandList());
+
+	AbstractGfxLayer::SetReadTexture(PSO, "DepthTex", DepthBuffer.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(PSO, "WorldNormalTex", NormalBuffers[ColorBufferWriteIndex].get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetReadTexture(PSO, "TileRayBudgetTex", TileRayBudget.get(), AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetWriteTexture(PSO, "Target0", Target0, AbstractGfxLayer::GetGlobalCommandList());
+	if (Target1)
+		AbstractGfxLayer::SetWriteTexture(PSO, "Target1", Target1, AbstractGfxLayer::GetGlobalCommandList());
+	AbstractGfxLayer::SetUniformValue(PSO, "RayReconstructCB", &CB, AbstractGfxLayer::GetGlobalCommandList());
+
+	AbstractGfxLayer::Dispatch(AbstractGfxLayer::GetGlobalCommandList(), (RenderWidth + 7) / 8, (RenderHeight + 7) / 8, 1);
+}
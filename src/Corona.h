@@ -12,6 +12,7 @@
 #pragma once
 #define GLM_FORCE_CTOR_INIT
 #include <array>
+#include <map>
 
 #include "glm/glm.hpp"
 #define GLM_ENABLE_EXPERIMENTAL
@@ -24,6 +25,22 @@
 #include "StepTimer.h"
 #include "SimpleCamera.h"
 #include "AbstractGfxLayer.h"
+#include "TextureStreaming.h"
+#include "GIDenoiserCPU.h"
+#include "HistogramCPU.h"
+#include "BloomCPU.h"
+#include "TemporalAACPU.h"
+#include "RayBudget.h"
+#include "ProbeScheduler.h"
+#include "DDGICascades.h"
+#include "ProbePlacementCPU.h"
+#include "SceneCulling.h"
+#include "GPUDrivenScene.h"
+#include "BindlessMaterials.h"
+#include "MaterialLibrary.h"
+#include "DrawQueue.h"
+#include "Benchmark.h"
+#include "BatchMath.h"
 #include "enkiTS/TaskScheduler.h""
 
 
@@ -158,7 +175,9 @@ private:
 	shared_ptr<GfxTexture> DiffuseGISHSpatial[2];
 	shared_ptr<GfxTexture> DiffuseGICoCgSpatial[2];
 
-	shared_ptr<GfxTexture> BloomBlurPingPong[2];
+	// extracted bloom in mip 0, downsampled and then upsampled in place.
+	shared_ptr<GfxTexture> BloomChain;
+	std::shared_ptr<GfxBuffer> DownsampleCounter;
 	shared_ptr<GfxTexture> LumaBuffer;
 	std::shared_ptr<GfxBuffer> Histogram;
 	std::shared_ptr<GfxBuffer> ExposureData;
@@ -172,26 +191,20 @@ private:
 	{
 		glm::mat4x4 ViewProjectionMatrix;
 		glm::mat4x4 PrevViewProjectionMatrix;
-		glm::mat4x4 WorldMatrix;
 		glm::mat4x4 UnjitteredViewProjMat;
 		glm::mat4x4 PrevUnjitteredViewProjMat;
 		glm::vec4 ViewDir;
 		glm::vec2 RTSize;
 		glm::vec2 RougnessMetalic;
 		UINT32 bOverrideRougnessMetallic;
+		UINT32 InstanceBase;
 	};
 
 	shared_ptr<GfxPipelineStateObject> GBufferPassPSO;
 
 	// spatial denoising
-	struct SpatialFilterConstant
-	{
-		glm::vec4 ProjectionParams;
-		UINT32 Iteration;
-		UINT32 GIBufferScale;
-		float IndirectDiffuseWeightFactorDepth = 0.5f;
-		float IndirectDiffuseWeightFactorNormal = 1.0f;
-	};
+	// shared with the cpu reference in GIDenoiserCPU.h
+	typedef ::SpatialFilterConstant SpatialFilterConstant;
 
 	SpatialFilterConstant SpatialFilterCB;
 
@@ -200,18 +213,7 @@ private:
 
 
 	// temporal denoising
-	struct TemporalFilterConstant
-	{
-		glm::mat4x4 InvViewMatrix;
-		glm::mat4x4 InvProjMatrix;
-		glm::vec4 ProjectionParams;
-		glm::vec4 TemporalValidParams = glm::vec4(28, 0, 0, 0);
-		glm::vec2 RTSize;
-		UINT32 FrameIndex;
-		float BayerRotScale = 0.1;
-		float SpecularBlurRadius = 4;
-		float Point2PlaneDistScale = 10.0f;
-	};
+	typedef ::TemporalFilterConstant TemporalFilterConstant;
 
 	TemporalFilterConstant TemporalFilterCB;
 
@@ -247,6 +249,9 @@ private:
 		UINT32 FrameCounter;
 		UINT32 BlueNoiseOffsetStride = 1.0f;
 		float ViewSpreadAngle;
+		UINT32 RayBudgetMode;
+		UINT32 RTWidth;
+		UINT32 RTHeight;
 	};
 
 	RTReflectionViewParamCB RTReflectionViewParam;
@@ -267,10 +272,25 @@ private:
 		UINT32 BlueNoiseOffsetStride = 1.0f;
 		float ViewSpreadAngle;
 		UINT32 bPackNRD;
+		UINT32 RayBudgetMode;
+		UINT32 RTWidth;
+		UINT32 RTHeight;
 	};
 
 	RTGIViewParamCB RTGIViewParam;
 	shared_ptr<GfxRTPipelineStateObject> PSO_RT_GI;
+
+	// reduced rate rt reflection and gi. the skipped pixels are reconstructed in place before the temporal denoiser.
+	ERayBudgetMode RayBudgetMode = RAY_BUDGET_FULL;
+	typedef ::RayReconstructCB RayReconstructCB;
+	shared_ptr<GfxPipelineStateObject> RayReconstructReflectionPSO;
+	shared_ptr<GfxPipelineStateObject> RayReconstructGIPSO;
+
+	// adaptive ray budget, one ERayBudgetMode per kRayBudgetTileSize tile.
+	shared_ptr<GfxTexture> TileRayBudget;
+	typedef ::RayBudgetClassifyCB RayBudgetClassifyCB;
+	RayBudgetClassifyCB RayBudgetClassifyParam;
+	shared_ptr<GfxPipelineStateObject> RayBudgetClassifyPSO;
 	
 
 	// full screen copy pass
@@ -354,13 +374,8 @@ private:
 	shared_ptr<GfxPipelineStateObject> LightingPSO;
 
 	// temporalAA
-	struct TemporalAAParam
-	{
-		glm::vec2 RTSize;
-		float TAABlendFactor;
-		UINT32 ClampMode;
-		//float Exposure;
-	};
+	// declared in TemporalAACPU.h
+	typedef ::TemporalAAParam TemporalAAParam;
 	
 	bool bEnableTAA = true;
 
@@ -377,39 +392,59 @@ private:
 #endif
 	EAntialiasingMethod PrevAAMethod = TEMPORAL_AA;
 
-	UINT32 ClampMode = 2;
+	UINT32 ClampMode = TAA_VARIANCE_CLIP;
+	// compiled into the taa psos, changing it recompiles the shaders.
+	int TAAFilterType = kTAAFilterNone;
 
 	float JitterScale = 1;
 
-	shared_ptr<GfxPipelineStateObject> TemporalAAPSO;
+	// one pso per clamp mode
+	shared_ptr<GfxPipelineStateObject> TemporalAAPSO[TAA_CLAMP_MODE_COUNT];
 
 
-	// bloom blur
+	// bloom extract
 	struct BloomCB
 	{
-		glm::vec2 BlurDirection;
 		glm::vec2 RTSize;
-		UINT32 NumSamples;
-		float WeightScale;
-		float NormalizationScale;
 		float BloomThreshHold = 1.0;
-		//float Exposure;
-		//float MinLog;
-		//float RcpLogRange;
+	};
+
+	struct DownsampleCB
+	{
+		glm::uvec2 SrcSize;
+		UINT32 NumMips;
+		UINT32 NumWorkGroups;
+	};
+
+	struct BloomUpsampleCB
+	{
+		glm::uvec2 DstSize;
+		glm::uvec2 SrcSize;
+		float BloomScatter;
 	};
 
 	const float kInitialMinLog = -12.0f;
 	const float kInitialMaxLog = 4.0f;
 
+	// log2 luminance range of the histogram bins. changing it resets the recentered range on the gpu.
+	float HistogramMinLog = kInitialMinLog;
+	float HistogramMaxLog = kInitialMaxLog;
+	bool bResetHistogramRange = false;
+
 	BloomCB BloomCB;
-	float BloomSigma = 0.037;
+	// how much of the wider mips is blended over each level of the chain.
+	float BloomScatter = 0.7;
 	float Exposure = 1;
 	float BloomStrength = 1.0;
 
-	UINT BloomBufferWidth = 640;
-	UINT  BloomBufferHeight = 384;
+	// half of the render resolution, set in InitBloomPass.
+	UINT BloomBufferWidth = 0;
+	UINT BloomBufferHeight = 0;
+	UINT BloomMaxMips = 8;
+	UINT BloomNumMips = 0;
 
-	shared_ptr<GfxPipelineStateObject> BloomBlurPSO;
+	shared_ptr<GfxPipelineStateObject> SinglePassDownsamplePSO;
+	shared_ptr<GfxPipelineStateObject> BloomUpsamplePSO;
 
 	shared_ptr<GfxPipelineStateObject> BloomExtractPSO;
 
@@ -420,20 +455,19 @@ private:
 	bool bDrawHistogram = false;
 	shared_ptr<GfxPipelineStateObject> DrawHistogramPSO;
 
-	struct AdaptExposureCB
-	{
-		float TargetLuminance = 0.03;
-		float AdaptationRate = 0.05;
-		float MinExposure = 1.0f / 64.0f;
-		float MaxExposure = 8;
-		UINT32 PixelCount;
-	};
+	// async compute, see AsyncCompute.h. the frame's passes are declared with their resources each frame,
+	// the scheduler picks the queues and the fences between them. with it on the exposure adapts from the
+	// last frame's luma at the frame's start, overlapping the gbuffer and ray tracing.
+	bool bAsyncCompute = true;
+	bool bAsyncExposure = false;	// latched at the start of a frame
+	AsyncComputeScheduler AsyncScheduler;
 
 	/*AdaptExposureCB.TargetLuminance = 0.08;
 AdaptExposureCB.AdaptationRate = 0.05;
 AdaptExposureCB.MinExposure = 1.0f / 64.0f;
 AdaptExposureCB.MaxExposure = 64.0f;*/
-	AdaptExposureCB AdaptExposureCB;
+	// declared in HistogramCPU.h
+	::AdaptExposureCB AdaptExposureCB;
 
 	shared_ptr<GfxPipelineStateObject> AdapteExposurePSO;
 
@@ -456,13 +490,100 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 
 	shared_ptr<GfxVertexBuffer> FullScreenVB;
 
-	// blue noise texture
-	shared_ptr<GfxTexture> BlueNoiseTex;
+	// blue noise textures. each ray traced pass picks one of the loaded sets.
+	vector<shared_ptr<GfxTexture>> BlueNoiseTextures;
+	vector<string> BlueNoiseSetNames;
+	int ReflectionBlueNoiseSet = 0;
+	int GIBlueNoiseSet = 0;
 	shared_ptr<GfxTexture> DefaultWhiteTex;
 	shared_ptr<GfxTexture> DefaultBlackTex;
 	shared_ptr<GfxTexture> DefaultNormalTex;
 	shared_ptr<GfxTexture> DefaultRougnessTex;
 
+	// texture streaming
+	struct StreamingTextureInfo
+	{
+		TextureStreamer::TextureID ID;
+		float Log2Dim;
+	};
+	TextureStreamer TexStreamer;
+	map<GfxTexture*, StreamingTextureInfo> StreamingTextureInfos;
+	bool bTextureStreaming = true;
+	int TextureStreamingBudgetMB = 512;
+
+	// frustum and hi-z occlusion culling of the gbuffer draws. one box per draw call, indexed by CullIndex.
+	CullingBounds SceneBounds;
+	vector<uint8_t> DrawVisibility;
+	CullingStats SceneCullingStats;
+	bool bFrustumCulling = true;
+	bool bOcclusionCulling = false;
+	HiZBuffer SceneHiZ;
+
+	// max depth of the gbuffer reduced to kHiZWidth x kHiZHeight and copied to the readback buffer of the
+	// frame in flight. read once the frame slot comes around again, with the matrix the depth was rendered with.
+	struct HiZReadback
+	{
+		shared_ptr<GfxBuffer> Buffer;
+		glm::mat4x4 ViewProj;
+		bool bValid = false;
+	};
+	shared_ptr<GfxBuffer> HiZReduceBuffer;
+	vector<HiZReadback> HiZReadbacks;
+	shared_ptr<GfxPipelineStateObject> HiZReducePSO;
+	typedef ::HiZReduceCB HiZReduceCB;
+
+	// visible draws of the classic gbuffer path, sorted by DrawQueue.h keys so consecutive draws skip
+	// the binds they share.
+	struct GBufferDrawItem
+	{
+		Scene* scene;
+		GfxMesh* mesh;
+		GfxMesh::DrawCall* drawcall;
+		float Roughness;
+		float Metallic;
+		bool bOverrideRoughnessMetallic;
+	};
+	vector<GBufferDrawItem> GBufferDrawItems;
+	DrawQueue GBufferQueue;
+	DrawBindStats GBufferBindStats;
+	UINT NumLoadedMaterials = 0;
+
+	// world matrices of every scene instance, glm::mat4x4 at Scene::InstanceBase + instance. only the
+	// instances Scene::Instances marked dirty are copied in, from the staging buffer of the frame.
+	shared_ptr<GfxBuffer> InstanceTransformBuffer;
+	vector<shared_ptr<GfxBuffer>> InstanceStagingBuffers;
+	UINT NumInstanceSlots = 0;
+	// shader balls drawn from the one loaded mesh, see LoadAssets.
+	UINT NumShaderBallInstances = 1;
+
+	// gpu driven gbuffer, see GPUDrivenScene.h.
+	bool bGPUDrivenGBuffer = false;
+	GPUDrivenSceneBuilder GPUScene;
+	shared_ptr<GfxVertexBuffer> MergedVb;
+	shared_ptr<GfxIndexBuffer> MergedIb;
+	shared_ptr<GfxBuffer> GPUDrawRecords;
+	// GPUDrawData, uploaded once. the transforms come from InstanceTransformBuffer.
+	shared_ptr<GfxBuffer> GPUDrawDataBuffer;
+	shared_ptr<GfxBuffer> GPUDrawCommands;
+	shared_ptr<GfxBuffer> GPUDrawCount;
+	shared_ptr<GfxTextureTable> MaterialTextureTable;
+	shared_ptr<GfxCommandSignature> GBufferCommandSignature;
+	shared_ptr<GfxPipelineStateObject> GBufferIndirectPSO;
+	shared_ptr<GfxPipelineStateObject> GPUDrivenCullPSO;
+	shared_ptr<GfxPipelineStateObject> ClearDrawCountPSO;
+	typedef ::GPUDrivenCullCB GPUDrivenCullCB;
+
+	// bindless gbuffer materials, see BindlessMaterials.h. a draw passes GfxMaterial::BindlessIndex instead
+	// of binding four srvs.
+	bool bBindlessGBuffer = false;
+	BindlessMaterialTable BindlessMaterials;
+	shared_ptr<GfxTextureTable> BindlessTextureTable;
+	// BindlessMaterialData per frame in flight, rewritten when the table changed since the copy was written.
+	vector<shared_ptr<GfxBuffer>> BindlessMaterialBuffers;
+	vector<uint64_t> BindlessMaterialVersions;
+	vector<uint32_t> BindlessDirtySlots;
+	shared_ptr<GfxPipelineStateObject> GBufferBindlessPSO;
+
 	// global wrap sampler
 	std::shared_ptr<GfxSampler> samplerAnisoWrap;
 	std::shared_ptr<GfxSampler> samplerBilinearWrap;
@@ -479,6 +600,35 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 	// time & camera
 	StepTimer m_timer;
 
+	// per pass timings, see Profiler.h. the stats follow the main thread's cpu zones and the gpu zones,
+	// a capture writes every thread's zones of TraceCaptureFrames frames to a chrome trace.
+	ProfilerStats CPUProfileStats;
+	ProfilerStats GPUProfileStats;
+	vector<ProfileEvent> ProfileEvents;
+	ChromeTraceWriter ProfileTrace;
+	int TraceCaptureFrames = 0;
+	string TraceCaptureStatus;
+	bool bShowProfiler = true;
+
+	// frames the cpu may run ahead of the gpu plus one, see FramePacing.h. fewer cut input latency when
+	// gpu bound, 1 serializes cpu and gpu.
+	int MaxFramesInFlight = 3;
+
+	// deterministic benchmark, see Benchmark.h. -benchmark <path file> replaces the live camera with the
+	// path at a fixed time step, records NumFrames frames after the warmup, writes the reports and quits.
+	BenchmarkSettings BenchmarkConfig;
+	CameraPath BenchmarkPath;
+	BenchmarkRecorder BenchmarkResults;
+	uint32_t BenchmarkFrameIndex = 0;	// frames the path has driven
+	double BenchmarkTime = 0.0;			// path time of the current frame
+	uint64_t BenchmarkLastFrameNs = 0;
+
+	// records the live camera into a path file for the benchmark.
+	CameraPath RecordedCameraPath;
+	bool bRecordingCameraPath = false;
+	double CameraPathRecordStart = 0.0;
+	string CameraPathStatus;
+
 	float m_turnSpeed = glm::half_pi<float>();
 
 	SimpleCamera m_camera;
@@ -512,6 +662,22 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 	glm::mat4x4 UnjitteredViewProjMat;
 	glm::mat4x4 PrevUnjitteredViewProjMat;
 
+	// the matrices above transposed for the constant buffers, hlsl reads them row major. OnUpdate transposes
+	// them in one batch per frame and copies them to the members by name.
+	struct TransposedViewMatrices
+	{
+		glm::mat4x4 View;
+		glm::mat4x4 InvView;
+		glm::mat4x4 Proj;	// unjittered, like InvProj
+		glm::mat4x4 InvProj;
+		glm::mat4x4 JitteredProj;
+		glm::mat4x4 ViewProj;
+		glm::mat4x4 PrevViewProj;
+		glm::mat4x4 UnjitteredViewProj;
+		glm::mat4x4 PrevUnjitteredViewProj;
+	};
+	TransposedViewMatrices ViewMatsT;
+
 
 	// raytracing resources
 
@@ -556,29 +722,55 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 #endif
 
 #if USE_RTXGI
-	shared_ptr<rtxgi::DDGIVolume> volume;
-	rtxgi::DDGIVolumeDesc volumeDesc = {};
-	rtxgi::DDGIVolumeResources volumeResources = {};
-	rtxgi::float3 volumeTranslation = { 0, 800, 0 };
+	// LightingPS.hlsl samples this many cascades.
+	static const uint32_t kNumDDGICascades = 3;
+
+	struct RTXGICascade
+	{
+		shared_ptr<rtxgi::DDGIVolume> volume;
+		rtxgi::DDGIVolumeDesc volumeDesc = {};
+		rtxgi::DDGIVolumeResources volumeResources = {};
+
+		std::shared_ptr<Buffer> VolumeCB;
+
+		shared_ptr<Texture> probeRTRadiance;
+		shared_ptr<Texture> probeIrradiance;
+		shared_ptr<Texture> probeDistance;
+		shared_ptr<Texture> probeOffsets;
+		shared_ptr<Texture> probeStates;
 
-	std::shared_ptr<Buffer> VolumeCB;
+		D3D12_CPU_DESCRIPTOR_HANDLE volumeDescriptorTableCPUHandle;
+		D3D12_GPU_DESCRIPTOR_HANDLE volumeDescriptorTableGPUHandle;
 
-	shared_ptr<Texture> probeRTRadiance;
-	shared_ptr<Texture> probeIrradiance;
-	shared_ptr<Texture> probeDistance;
-	shared_ptr<Texture> probeOffsets;
-	shared_ptr<Texture> probeStates;
+		// only a rotating subset of the probes is traced and blended each frame.
+		ProbeScheduler probeScheduler;
+		shared_ptr<GfxBuffer> ScheduledProbesBuffer[3]; // one per frame in flight
 
-	D3D12_CPU_DESCRIPTOR_HANDLE volumeDescriptorTableCPUHandle;
-	D3D12_GPU_DESCRIPTOR_HANDLE volumeDescriptorTableGPUHandle;
+		// own shader table, the volume resources are global root arguments.
+		shared_ptr<RTPipelineStateObject> PSO_RT_PROBE;
+
+		// offsets and states were uploaded and still need the transition to unordered access.
+		bool bPlacementUploaded = false;
+	};
+
+	// nested volumes centered on the camera, cascade 0 is the finest. they scroll by whole probes.
+	RTXGICascade RTXGICascades[kNumDDGICascades];
+	DDGICascadeDesc DDGICascadeParam;
+	DDGICascadeSet DDGICascadeLayout;
+	std::vector<uint32_t> ScrolledInProbes;
+	// cascade shown by the irradiance, distance and RTXGI_RESULT visualizations.
+	int VisualizedCascade = 0;
+
+	// initial probe offsets and states, ray cast on the cpu against the loaded scenes.
+	ProbePlacementParams probePlacementParams;
+	ProbePlacementGeometry ProbeGeometry;
+	ProbePlacementBVH ProbeBVH;
 
 	struct LightInfoCB
 	{
 		glm::vec4 LightDirAndIntensity;
 
 	};
-	shared_ptr<RTPipelineStateObject> PSO_RT_PROBE;
-
 	bool bDrawIrradiance = false;
 	float IrradianceScale = 1;
 	bool bDrawDistance = false;
@@ -587,6 +779,15 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 	float probeHysteresis = 0.996f;
 	float normalBias= 0.1;
 	float viewBias = 0.1;
+
+	ProbeScheduleParams probeScheduleParams;
+	glm::vec4 ScheduledLightDirAndIntensity = glm::vec4(0.f);
+
+	struct ProbeScheduleCB
+	{
+		UINT32 NumProbes;
+	};
+	shared_ptr<GfxPipelineStateObject> ProbeMarkNotTracedPSO;
 #endif
 
 # if USE_NRD
@@ -619,6 +820,7 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 	};
 
 	shared_ptr<GfxPipelineStateObject> SimpleDrawPSO;
+	shared_ptr<GfxVertexBuffer> SimpleDrawVB;
 
 
 	struct PostVertex
@@ -634,6 +836,11 @@ AdaptExposureCB.MaxExposure = 64.0f;*/
 		glm::vec2 UV;
 		glm::vec3 Tangent;
 	};
+
+	// geometry of every mesh appended while loading, dropped once the merged buffers of the gpu driven
+	// gbuffer are created.
+	vector<MeshVertex> MergedVertices;
+	vector<UINT16> MergedIndices;
 public:
 
 	void InitRaytracingData();
@@ -644,6 +851,8 @@ public:
 
 #if USE_RTXGI
 	void InitRTXGI();
+	void InitRTXGICascade(uint32_t CascadeIndex, const rtxgi::DDGIVolumeResources& SharedResources);
+	void PlaceRTXGIProbes();
 #endif
 
 	void ShutDownDLSS();
@@ -655,6 +864,39 @@ public:
 
 	shared_ptr<Scene> LoadModel(string fileName);
 
+	void InitTextureStreaming();
+
+	shared_ptr<GfxTexture> LoadMaterialTexture(wstring fileName, bool nonSRGB, shared_ptr<GfxTexture> placeholder);
+
+	void UpdateTextureStreaming();
+
+	void UpdateProfiler();
+
+	void InitBenchmark();
+	void UpdateBenchmark();
+	void RecordBenchmarkFrame(const vector<const ProfileEvent*>& MainThreadEvents, const vector<GPUZoneTiming>& GPUZones);
+	void FinishBenchmark();
+	void RecordCameraPathKey();
+
+	void InitSceneBounds();
+
+	void CullScene();
+
+	void InitGPUDrivenScene();
+
+
+	void InitInstanceBuffers();
+
+	void UploadInstanceTransforms();
+
+	bool IsGPUDrivenGBuffer();
+
+	void InitBindlessMaterials();
+
+	void UpdateBindlessMaterials();
+
+	bool IsBindlessGBuffer();
+
 	void InitRTPSO();
 
 	void InitSpatialDenoisingPass();
@@ -675,13 +917,25 @@ public:
 
 	void InitResolvePixelVelocityPass();
 
+	void InitRayReconstructPass();
+
+	void InitRayBudgetClassifyPass();
+
+	void InitHiZReducePass();
+
+	void InitGPUDrivenCullPass();
+
 	void InitImgui();
 
 	void InitBlueNoiseTexture();
 
+	GfxTexture* GetBlueNoiseTexture(int Set);
+
 	void InitSimpleDraw();
 
-	void DrawScene(shared_ptr<Scene> scene, float Roughness, float Metalic, bool bOverrideRoughnessMetallic);
+	void AddSceneToGBufferQueue(shared_ptr<Scene> scene, float Roughness, float Metalic, bool bOverrideRoughnessMetallic);
+
+	void DrawGBufferQueue();
 
 	void GBufferPass();
 
@@ -691,6 +945,14 @@ public:
 
 	void RaytraceGIPass();
 
+	void RayBudgetClassifyPass();
+
+	void HiZReducePass();
+
+	void GPUDrivenCullPass();
+
+	void RayReconstructPass(GfxPipelineStateObject* PSO, GfxTexture* Target0, GfxTexture* Target1, const glm::vec4& ProjectionParams, UINT32 FrameIndex);
+
 	void SpatialDenoisingPass();
 
 
@@ -701,6 +963,14 @@ public:
 
 	void BloomPass();
 
+	void ExposurePass();
+
+	void AsyncExposureAcquirePass();
+
+	void AsyncExposureReleasePass();
+
+	void RecordFramePasses();
+
 
 
 	void ToneMapPass();
@@ -718,6 +988,10 @@ public:
 	void ResolvePixelVelocityPass();
 
 	void RTXGIPass();
+#if USE_RTXGI
+	void ProbeSchedulePass(uint32_t CascadeIndex);
+	void RTXGICascadePass(uint32_t CascadeIndex);
+#endif
 
 	void SimpleDrawPass();
 
@@ -0,0 +1,143 @@
+#include "DDGICascades.h"
+
+#include <algorithm>
+#include <cmath>
+
+bool DDGICascade::IsScrolledIn(const glm::ivec3& GridCoords) const
+{
+	const glm::ivec3 Local = GridCoords - ClearStart;
+	return glm::any(glm::lessThan(glm::uvec3(Local), glm::uvec3(ClearCount)));
+}
+
+void DDGICascadeSet::Init(const DDGICascadeDesc& InDesc)
+{
+	Desc = InDesc;
+	Cascades.assign(Desc.NumCascades, DDGICascade());
+
+	glm::vec3 Spacing = Desc.BaseSpacing;
+	for (DDGICascade& Cascade : Cascades)
+	{
+		Cascade.Grid.Counts = Desc.Counts;
+		Cascade.Grid.Spacing = Spacing;
+		Spacing *= Desc.SpacingScale;
+	}
+}
+
+void DDGICascadeSet::Invalidate()
+{
+	for (DDGICascade& Cascade : Cascades)
+		Cascade.bValid = false;
+}
+
+glm::ivec3 DDGICascadeSet::GetScrollOffsets(const glm::ivec3& GridMin, const glm::ivec3& Counts)
+{
+	return ((GridMin % Counts) + Counts) % Counts;
+}
+
+bool DDGICascadeSet::Update(const glm::vec3& CameraPos)
+{
+	bool bScrolled = false;
+
+	for (DDGICascade& Cascade : Cascades)
+	{
+		const glm::ivec3 Counts = Cascade.Grid.Counts;
+		const glm::ivec3 CameraGrid = glm::ivec3(glm::floor(CameraPos / Cascade.Grid.Spacing));
+
+		glm::ivec3 GridMin = CameraGrid - Counts / 2;
+		if (Cascade.bValid)
+		{
+			// only scroll once the camera leaves the dead zone around the center, so a camera
+			// sitting on a cell boundary does not scroll the same plane back and forth.
+			const glm::ivec3 Center = Cascade.GridMin + Counts / 2;
+			const glm::ivec3 Delta = CameraGrid - Center;
+			const glm::ivec3 Excess = glm::max(glm::abs(Delta) - Desc.ScrollDeadzone, 0);
+			GridMin = Cascade.GridMin + glm::sign(Delta) * Excess;
+		}
+
+		const glm::ivec3 Scroll = GridMin - Cascade.GridMin;
+
+		if (!Cascade.bValid || glm::any(glm::greaterThanEqual(glm::abs(Scroll), Counts)))
+		{
+			// nothing overlaps, every probe starts over.
+			Cascade.ClearStart = glm::ivec3(0);
+			Cascade.ClearCount = Counts;
+		}
+		else
+		{
+			for (int32_t Axis = 0; Axis < 3; Axis++)
+			{
+				if (Scroll[Axis] > 0)
+				{
+					Cascade.ClearStart[Axis] = Counts[Axis] - Scroll[Axis];
+					Cascade.ClearCount[Axis] = Scroll[Axis];
+				}
+				else
+				{
+					Cascade.ClearStart[Axis] = 0;
+					Cascade.ClearCount[Axis] = -Scroll[Axis];
+				}
+			}
+		}
+
+		bScrolled |= glm::any(glm::notEqual(Cascade.ClearCount, glm::ivec3(0)));
+
+		Cascade.GridMin = GridMin;
+		Cascade.bValid = true;
+		Cascade.Grid.ScrollOffsets = GetScrollOffsets(GridMin, Counts);
+		// DDGIGetProbeWorldPosition centers the grid on the origin.
+		Cascade.Grid.Origin = (glm::vec3(GridMin) + glm::vec3(Counts - 1) * 0.5f) * Cascade.Grid.Spacing;
+	}
+
+	return bScrolled;
+}
+
+DDGIScrollDescGPU DDGICascadeSet::GetScrollDescGPU(uint32_t CascadeIndex) const
+{
+	const DDGICascade& Cascade = Cascades[CascadeIndex];
+
+	DDGIScrollDescGPU Desc = {};
+	Desc.ScrollOffsets = Cascade.Grid.ScrollOffsets;
+	Desc.ClearStart = Cascade.ClearStart;
+	Desc.ClearCount = Cascade.ClearCount;
+	return Desc;
+}
+
+void DDGICascadeSet::GetScrolledInProbes(uint32_t CascadeIndex, std::vector<uint32_t>& ProbeIndices) const
+{
+	const DDGICascade& Cascade = Cascades[CascadeIndex];
+	const ProbeGridDesc& Grid = Cascade.Grid;
+
+	ProbeIndices.clear();
+	if (glm::all(glm::equal(Cascade.ClearCount, glm::ivec3(0))))
+		return;
+
+	for (uint32_t i = 0; i < Grid.GetNumProbes(); i++)
+	{
+		const glm::ivec3 GridCoords = GetUnscrolledProbeCoords(GetProbeCoords(i, Grid.Counts), Grid.Counts, Grid.ScrollOffsets);
+		if (Cascade.IsScrolledIn(GridCoords))
+			ProbeIndices.push_back(i);
+	}
+}
+
+float DDGICascadeSet::GetBlendWeight(uint32_t CascadeIndex, const glm::vec3& Position) const
+{
+	const ProbeGridDesc& Grid = Cascades[CascadeIndex].Grid;
+
+	const glm::vec3 Extent = Grid.Spacing * glm::vec3(Grid.Counts - 1) * 0.5f;
+	const glm::vec3 ProbeCoords = (Position - Grid.Origin + Extent) / Grid.Spacing;
+	const glm::vec3 OverProbeMax = glm::vec3(Grid.Counts - 1) - ProbeCoords;
+
+	const glm::vec3 Low = glm::clamp(ProbeCoords, 0.f, 1.f);
+	const glm::vec3 High = glm::clamp(OverProbeMax, 0.f, 1.f);
+	return Low.x * Low.y * Low.z * High.x * High.y * High.z;
+}
+
+uint32_t DDGICascadeSet::SelectCascade(const glm::vec3& Position) const
+{
+	for (uint32_t i = 0; i < GetNumCascades(); i++)
+	{
+		if (GetBlendWeight(i, Position) >= 1.0f)
+			return i;
+	}
+	return GetNumCascades() - 1;
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "ProbeScheduler.h"
+
+struct DDGICascadeDesc
+{
+	glm::ivec3 Counts = glm::ivec3(32, 16, 32);
+	glm::vec3 BaseSpacing = glm::vec3(100.f);
+	// spacing grows by this factor per cascade, so every cascade covers the finer ones.
+	float SpacingScale = 2.0f;
+	uint32_t NumCascades = 3;
+	// probes the camera can move off the volume center before the volume scrolls.
+	int32_t ScrollDeadzone = 1;
+};
+
+// a camera centered ddgi volume that scrolls by whole probes. the probe at world grid coordinate c
+// is stored at c mod Counts, so probes that stay inside the volume keep their data when it scrolls.
+struct DDGICascade
+{
+	// Grid.Origin is the volume center, Grid.ScrollOffsets the ring offset for the shaders.
+	ProbeGridDesc Grid;
+	// world grid coordinates of the probe at grid coordinate zero. world position is GridMin * Spacing.
+	glm::ivec3 GridMin = glm::ivec3(0);
+	// probe planes that scrolled in on the last update, in grid coordinates. zero count on axes that did not move.
+	glm::ivec3 ClearStart = glm::ivec3(0);
+	glm::ivec3 ClearCount = glm::ivec3(0);
+	bool bValid = false;
+
+	bool IsScrolledIn(const glm::ivec3& GridCoords) const;
+};
+
+// the ring addressing of a cascade as the shaders read it. the sdk's DDGIVolumeDescGPU is left as
+// shipped, Corona writes this into the last 48 bytes of its padding after DDGIVolume::Update and
+// DDGIGetScrollDesc in ProbeCommon.hlsl reads it back.
+const uint32_t kDDGIScrollDescOffset = 208;
+
+struct DDGIScrollDescGPU
+{
+	glm::ivec3 ScrollOffsets;
+	int32_t Pad0;
+	glm::ivec3 ClearStart;
+	int32_t Pad1;
+	glm::ivec3 ClearCount;
+	int32_t Pad2;
+};
+
+static_assert(sizeof(DDGIScrollDescGPU) == 48 && kDDGIScrollDescOffset + sizeof(DDGIScrollDescGPU) == 256,
+	"DDGIScrollDescGPU fills the tail of the 256 byte DDGIVolumeDescGPU");
+
+class DDGICascadeSet
+{
+public:
+	void Init(const DDGICascadeDesc& InDesc);
+
+	// follows the camera. returns true if any cascade scrolled.
+	bool Update(const glm::vec3& CameraPos);
+
+	// all probes of every cascade scroll in on the next update.
+	void Invalidate();
+
+	uint32_t GetNumCascades() const { return uint32_t(Cascades.size()); }
+	const DDGICascade& GetCascade(uint32_t Cascade) const { return Cascades[Cascade]; }
+	const DDGICascadeDesc& GetDesc() const { return Desc; }
+
+	DDGIScrollDescGPU GetScrollDescGPU(uint32_t Cascade) const;
+
+	// storage indices of the probes that scrolled into the cascade on the last update.
+	void GetScrolledInProbes(uint32_t Cascade, std::vector<uint32_t>& ProbeIndices) const;
+
+	// DDGIGetVolumeBlendWeight of Irradiance.hlsl, 1 inside the cascade fading to 0 over the outer probe cell.
+	float GetBlendWeight(uint32_t Cascade, const glm::vec3& Position) const;
+
+	// finest cascade with full weight at Position, the coarsest one if none.
+	uint32_t SelectCascade(const glm::vec3& Position) const;
+
+	static glm::ivec3 GetScrollOffsets(const glm::ivec3& GridMin, const glm::ivec3& Counts);
+
+private:
+	DDGICascadeDesc Desc;
+	std::vector<DDGICascade> Cascades;
+};
@@ -64,27 +64,46 @@ void DescriptorHeap::AllocDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& cpuHandle, D3D
 
 void DescriptorHeap::AllocDescriptors(D3D12_CPU_DESCRIPTOR_HANDLE& cpuHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT num)
 {
+	assert(NumAllocated + num <= MaxNumDescriptors && "descriptor heap is full");
+
 	cpuHandle.ptr = CPUHeapStart + NumAllocated * DescriptorSize;
 	gpuHandle.ptr = GPUHeapStart + NumAllocated * DescriptorSize;
 
 	NumAllocated += num;
 }
 
+void DX12Impl::WaitForFrameSlot()
+{
+	if (bFrameSlotReady)
+		return;
+
+	// waiting for the frame MaxFramesInFlight back also covers the frame NumFrame back, the last user
+	// of this frame's backbuffer and ring ranges.
+	const UINT64 StartNs = ProfilerNowNs();
+	const UINT64 WaitFenceValue = Pacer.GetWaitFenceValue();
+	if (WaitFenceValue > CmdQSync->m_fence->GetCompletedValue())
+		CmdQSync->WaitFenceValue(WaitFenceValue);
+	const UINT64 EndNs = ProfilerNowNs();
+
+	Pacer.Retire(CmdQSync->m_fence->GetCompletedValue(), EndNs);
+	Pacer.BeginFrame(EndNs, EndNs - StartNs);
+	bFrameSlotReady = true;
+}
+
 void DX12Impl::BeginFrame(std::list<Texture*>& DynamicTexture)
 {
 	CurrentFrameIndex = m_swapChain->GetCurrentBackBufferIndex();
 
-	// wait until gpu processing for this frame resource is completed
-	UINT64 ThisFrameFenceValue = FrameFenceValueVec[CurrentFrameIndex];
-	
-	CmdQSync->WaitFenceValue(ThisFrameFenceValue);
+	// no-op when the app already waited before sampling its input.
+	WaitForFrameSlot();
 
-	
-	GlobalCmdList = CmdQSync->AllocCmdList();
-	GlobalCmdList->Fence = CmdQSync->CurrentFenceValue;
+	ReleaseRetiredStreamingTextures();
+
+	ReadbackGPUZones();
+	TimestampRing.BeginFrame(CurrentFrameIndex);
 
-	ID3D12DescriptorHeap* ppHeaps[] = { SRVCBVDescriptorHeapShaderVisible->DH.Get(), SamplerDescriptorHeapShaderVisible->DH.Get() };
-	GlobalCmdList->CmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+	
+	OpenGlobalCommandList();
 	
 
 	g_dx12_rhi->GlobalDHRing->Advance();
@@ -181,8 +200,74 @@ void DX12Impl::EndFrame()
 	ThrowIfFailed(m_swapChain->Present(0, 0), nullptr);
 
 #endif
-	FrameFenceValueVec[CurrentFrameIndex] = CmdQSync->CurrentFenceValue;;
+	Pacer.EndFrame(CmdQSync->CurrentFenceValue, ProfilerNowNs());
+	PreviousFrameFenceValue = CmdQSync->CurrentFenceValue;
+	CmdQSync->SignalCurrentFence();
+	bFrameSlotReady = false;
+}
+
+void DX12Impl::OpenGlobalCommandList()
+{
+	// the list's fence value is the next one the queue signals, after a flush or at the frame's end.
+	GlobalCmdList = CmdQSync->AllocCmdList();
+	GlobalCmdList->Fence = CmdQSync->CurrentFenceValue;
+
+	ID3D12DescriptorHeap* ppHeaps[] = { SRVCBVDescriptorHeapShaderVisible->DH.Get(), SamplerDescriptorHeapShaderVisible->DH.Get() };
+	GlobalCmdList->CmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+}
+
+void DX12Impl::FlushGlobalCommandList()
+{
+	CmdQSync->ExecuteCommandList(GlobalCmdList);
+	OpenGlobalCommandList();
+}
+
+void DX12Impl::BeginAsyncCompute()
+{
+	CommandList* AsyncCmdList = CmdQAsync->AllocCmdList();
+	AsyncCmdList->Fence = CmdQAsync->CurrentFenceValue;
+
+	ID3D12DescriptorHeap* ppHeaps[] = { SRVCBVDescriptorHeapShaderVisible->DH.Get(), SamplerDescriptorHeapShaderVisible->DH.Get() };
+	AsyncCmdList->CmdList->SetDescriptorHeaps(_countof(ppHeaps), ppHeaps);
+
+	SuspendedCmdList = GlobalCmdList;
+	GlobalCmdList = AsyncCmdList;
+}
+
+void DX12Impl::EndAsyncCompute()
+{
+	CmdQAsync->ExecuteCommandList(GlobalCmdList);
+	GlobalCmdList = SuspendedCmdList;
+	SuspendedCmdList = nullptr;
+}
+
+UINT64 DX12Impl::SignalQueue(GPUQueue Queue)
+{
+	if (Queue == GPUQueue::Compute)
+	{
+		const UINT64 FenceValue = CmdQAsync->CurrentFenceValue;
+		CmdQAsync->SignalCurrentFence();
+		return FenceValue;
+	}
+
+	const UINT64 FenceValue = CmdQSync->CurrentFenceValue;
+	CmdQSync->ExecuteCommandList(GlobalCmdList);
 	CmdQSync->SignalCurrentFence();
+	OpenGlobalCommandList();
+	return FenceValue;
+}
+
+void DX12Impl::WaitQueue(GPUQueue Queue, UINT64 FenceValue)
+{
+	if (Queue == GPUQueue::Compute)
+	{
+		CmdQAsync->CmdQueue->Wait(CmdQSync->m_fence.Get(), FenceValue);
+	}
+	else
+	{
+		FlushGlobalCommandList();
+		CmdQSync->CmdQueue->Wait(CmdQAsync->m_fence.Get(), FenceValue);
+	}
 }
 
 Sampler* DX12Impl::CreateSampler(D3D12_SAMPLER_DESC& InSamplerDesc)
@@ -195,6 +280,69 @@ Sampler* DX12Impl::CreateSampler(D3D12_SAMPLER_DESC& InSamplerDesc)
 	return sampler;
 }
 
+static void CreateTextureTableSRV(ID3D12Resource* resource, const D3D12_RESOURCE_DESC* textureDesc, D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle)
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+	SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	SrvDesc.Format = textureDesc ? textureDesc->Format : DXGI_FORMAT_R8G8B8A8_UNORM;
+	SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	SrvDesc.Texture2D.MipLevels = textureDesc ? textureDesc->MipLevels : 1;
+	g_dx12_rhi->Device->CreateShaderResourceView(resource, &SrvDesc, CpuHandle);
+}
+
+TextureTable* DX12Impl::CreateTextureTable(UINT NumDescriptors)
+{
+	TextureTable* table = new TextureTable;
+	table->NumDescriptors = NumDescriptors;
+	table->Textures.resize(NumDescriptors, nullptr);
+	table->FrameTables.resize(NumFrame);
+	table->FrameResources.resize(NumFrame);
+
+	// a range of its own in the shader visible heap, one table per frame. taken from TextureDHRing the
+	// tables would eat most of its per frame range and the texture srvs after them would run into the next frame's.
+	const UINT DescriptorSize = SRVCBVDescriptorHeapShaderVisible->DescriptorSize;
+	D3D12_CPU_DESCRIPTOR_HANDLE RangeCpuHandle;
+	D3D12_GPU_DESCRIPTOR_HANDLE RangeGpuHandle;
+	SRVCBVDescriptorHeapShaderVisible->AllocDescriptors(RangeCpuHandle, RangeGpuHandle, NumDescriptors * NumFrame);
+
+	for (UINT frame = 0; frame < NumFrame; frame++)
+	{
+		Descriptor& FrameTable = table->FrameTables[frame];
+		FrameTable.CpuHandle.ptr = RangeCpuHandle.ptr + SIZE_T(frame) * NumDescriptors * DescriptorSize;
+		FrameTable.GpuHandle.ptr = RangeGpuHandle.ptr + UINT64(frame) * NumDescriptors * DescriptorSize;
+		table->FrameResources[frame].resize(NumDescriptors, nullptr);
+
+		for (UINT i = 0; i < NumDescriptors; i++)
+		{
+			D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle = FrameTable.CpuHandle;
+			CpuHandle.ptr += i * DescriptorSize;
+			CreateTextureTableSRV(nullptr, nullptr, CpuHandle);
+		}
+	}
+
+	return table;
+}
+
+Descriptor& TextureTable::UpdateFrameTable(UINT FrameIndex)
+{
+	Descriptor& FrameTable = FrameTables[FrameIndex];
+	vector<ID3D12Resource*>& Resources = FrameResources[FrameIndex];
+
+	for (UINT i = 0; i < NumDescriptors; i++)
+	{
+		ID3D12Resource* resource = Textures[i] ? Textures[i]->resource.Get() : nullptr;
+		if (resource == Resources[i])
+			continue;
+
+		D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle = FrameTable.CpuHandle;
+		CpuHandle.ptr += i * g_dx12_rhi->SRVCBVDescriptorHeapShaderVisible->DescriptorSize;
+		CreateTextureTableSRV(resource, resource ? &Textures[i]->textureDesc : nullptr, CpuHandle);
+		Resources[i] = resource;
+	}
+
+	return FrameTable;
+}
+
 Buffer* DX12Impl::CreateBuffer(UINT InNumElements, UINT InElementSize, D3D12_HEAP_TYPE InType, D3D12_RESOURCE_STATES initResState, D3D12_RESOURCE_FLAGS InFlags, void* SrcData)
 {
 	Buffer * buffer = new Buffer;
@@ -516,6 +664,13 @@ DX12Impl::DX12Impl(HWND hWnd, UINT DisplayWidth, UINT DisplayHeight)
 		break;
 	}
 
+	// the pipeline cache is read while the heaps are set up and the shaders compile.
+	{
+		DXGI_ADAPTER_DESC1 AdapterDesc;
+		m_hardwareAdapter->GetDesc1(&AdapterDesc);
+		PipelineLibrary.Start("PipelineCache_DX12.bin", (UINT64(AdapterDesc.VendorId) << 32) | AdapterDesc.DeviceId);
+	}
+
 	// Describe and create the swap chain.
 	DXGI_SWAP_CHAIN_DESC1 swapChainDesc = {};
 	swapChainDesc.BufferCount = NumFrame;
@@ -530,6 +685,9 @@ DX12Impl::DX12Impl(HWND hWnd, UINT DisplayWidth, UINT DisplayHeight)
 
 	CmdQSync = unique_ptr<CommandQueue>(new CommandQueue);
 
+	// a few compute lists a frame, the pool only has to outlast the frames in flight.
+	CmdQAsync = unique_ptr<CommandQueue>(new CommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE, 64));
+
 
 	ComPtr<IDXGISwapChain1> swapChain;
 	ThrowIfFailed(factory->CreateSwapChainForHwnd(
@@ -560,7 +718,7 @@ DX12Impl::DX12Impl(HWND hWnd, UINT DisplayWidth, UINT DisplayHeight)
 #endif
 
 
-	FrameFenceValueVec.resize(NumFrame);
+	Pacer.Init(NumFrame);
 
 
 	{
@@ -643,20 +801,123 @@ DX12Impl::DX12Impl(HWND hWnd, UINT DisplayWidth, UINT DisplayHeight)
 	GlobalRTDHRing = std::make_unique<DescriptorHeapRing>();
 	GlobalRTDHRing->Init(RTVDescriptorHeap.get(), 30, NumFrame);
 
+	InitTimestampQueries();
+
 	CmdQSync->WaitGPU();
 }
 
+void DX12Impl::InitTimestampQueries()
+{
+	TimestampRing.Init(NumFrame, MaxGPUZonesPerFrame);
+
+	D3D12_QUERY_HEAP_DESC HeapDesc = {};
+	HeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+	HeapDesc.Count = TimestampRing.GetNumQueries();
+	ThrowIfFailed(Device->CreateQueryHeap(&HeapDesc, IID_PPV_ARGS(&TimestampHeap)));
+	NAME_D3D12_OBJECT(TimestampHeap);
+
+	D3D12_HEAP_PROPERTIES HeapProps = {};
+	HeapProps.Type = D3D12_HEAP_TYPE_READBACK;
+
+	D3D12_RESOURCE_DESC bufDesc = {};
+	bufDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+	bufDesc.Width = sizeof(UINT64) * TimestampRing.GetNumQueries();
+	bufDesc.Height = 1;
+	bufDesc.DepthOrArraySize = 1;
+	bufDesc.MipLevels = 1;
+	bufDesc.Format = DXGI_FORMAT_UNKNOWN;
+	bufDesc.SampleDesc.Count = 1;
+	bufDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+	ThrowIfFailed(Device->CreateCommittedResource(&HeapProps, D3D12_HEAP_FLAG_NONE, &bufDesc, D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&TimestampReadback)));
+	NAME_D3D12_OBJECT(TimestampReadback);
+
+	ThrowIfFailed(CmdQSync->CmdQueue->GetTimestampFrequency(&TimestampFrequency));
+}
+
+UINT DX12Impl::BeginGPUZone(CommandList* CL, const char* Name)
+{
+	// the compute queue's timestamps aren't calibrated against the cpu clock, its passes go untimed.
+	if (SuspendedCmdList)
+		return GPUTimestampRing::InvalidZone;
+
+	UINT Zone = TimestampRing.BeginZone(Name);
+	if (Zone != GPUTimestampRing::InvalidZone)
+		CL->CmdList->EndQuery(TimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, TimestampRing.GetBeginQuery(Zone));
+	return Zone;
+}
+
+void DX12Impl::EndGPUZone(CommandList* CL, UINT Zone)
+{
+	if (Zone == GPUTimestampRing::InvalidZone)
+		return;
+
+	CL->CmdList->EndQuery(TimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, TimestampRing.GetEndQuery(Zone));
+	TimestampRing.EndZone(Zone);
+}
+
+void DX12Impl::ResolveGPUZones(CommandList* CL)
+{
+	const UINT First = TimestampRing.GetFirstQuery();
+	const UINT Num = TimestampRing.GetNumFrameQueries();
+	if (Num > 0)
+		CL->CmdList->ResolveQueryData(TimestampHeap.Get(), D3D12_QUERY_TYPE_TIMESTAMP, First, Num, TimestampReadback.Get(), First * sizeof(UINT64));
+	TimestampRing.MarkResolved();
+}
+
+void DX12Impl::ReadbackGPUZones()
+{
+	// BeginFrame waited for the frame that last used this range.
+	const UINT First = CurrentFrameIndex * MaxGPUZonesPerFrame * 2;
+	const UINT Num = MaxGPUZonesPerFrame * 2;
+
+	// one calibrated pair of gpu ticks and qpc, msvc's steady_clock counts qpc so it converts to the
+	// time base of ProfilerNowNs.
+	UINT64 GPUTicks = 0, CPUTicks = 0;
+	LARGE_INTEGER QPCFrequency;
+	QueryPerformanceFrequency(&QPCFrequency);
+	if (FAILED(CmdQSync->CmdQueue->GetClockCalibration(&GPUTicks, &CPUTicks)))
+		return;
+	const UINT64 Freq = QPCFrequency.QuadPart;
+	const UINT64 CPUNs = CPUTicks / Freq * 1000000000ull + CPUTicks % Freq * 1000000000ull / Freq;
+
+	D3D12_RANGE ReadRange = { First * sizeof(UINT64), (First + Num) * sizeof(UINT64) };
+	D3D12_RANGE WriteRange = { 0, 0 };
+	UINT8* pData = nullptr;
+	if (FAILED(TimestampReadback->Map(0, &ReadRange, reinterpret_cast<void**>(&pData))))
+		return;
+
+	GPUZoneTimings.clear();
+	TimestampRing.Resolve(CurrentFrameIndex, reinterpret_cast<const UINT64*>(pData + First * sizeof(UINT64)), TimestampFrequency, GPUTicks, CPUNs, GPUZoneTimings);
+
+	TimestampReadback->Unmap(0, &WriteRange);
+}
+
+UINT64 DX12Impl::GetGPUMemoryUsage()
+{
+	ComPtr<IDXGIAdapter3> Adapter3;
+	if (FAILED(m_hardwareAdapter.As(&Adapter3)))
+		return 0;
+
+	DXGI_QUERY_VIDEO_MEMORY_INFO LocalVideoMemoryInfo;
+	if (FAILED(Adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &LocalVideoMemoryInfo)))
+		return 0;
+	return LocalVideoMemoryInfo.CurrentUsage;
+}
+
 DX12Impl::~DX12Impl()
 {
 	CmdQSync->WaitGPU();
+	CmdQAsync->WaitGPU();
+
+	PipelineLibrary.Save();
 }
 
-void PipelineStateObject::BindUAV(string name, int baseRegister)
+void PipelineStateObject::BindUAV(string name, int baseRegister, int num)
 {
 	BindingData binding;
 	binding.name = name;
 	binding.baseRegister = baseRegister;
-	binding.numDescriptors = 1;
+	binding.numDescriptors = num;
 	uavBinding.insert(pair<string, BindingData>(name, binding));
 }
 
@@ -810,105 +1071,49 @@ void PipelineStateObject::SetRootConstant(string name, UINT value, ID3D12Graphic
 		CommandList->SetGraphicsRoot32BitConstant(rootBinding[name].rootParamIndex, rootBinding[name].rootConst, 0);
 }
 
-bool PipelineStateObject::Init()
+const RootSignatureCache::Entry* RootSignatureCache::FindOrCreate(const RootSignatureLayout& Layout)
 {
-	if (!IsCompute &&(!vs || !ps)) return false;
-	if (IsCompute && !cs) return false;
-
-
-	vector<CD3DX12_ROOT_PARAMETER1> rootParamVec;
-
-	vector<CD3DX12_DESCRIPTOR_RANGE1> TextureRanges;
-	if (textureBinding.size() != 0)
-	{
-		TextureRanges.resize(textureBinding.size());
-		int i = 0;
-		for (auto& bindingPair : textureBinding)
-		{
-			PipelineStateObject::BindingData& bindingData = bindingPair.second;
-
-			CD3DX12_ROOT_PARAMETER1 TextureParam;
-			TextureRanges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, bindingData.numDescriptors, bindingData.baseRegister, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
-			TextureParam.InitAsDescriptorTable(1, &TextureRanges[i], D3D12_SHADER_VISIBILITY_ALL);
-			rootParamVec.push_back(TextureParam);
-			i++;
-			bindingData.rootParamIndex = RootParamIndex++;
-		}
-	}
-
-	vector<CD3DX12_DESCRIPTOR_RANGE1> SamplerRanges;
-	if (samplerBinding.size() != 0)
-	{
-		SamplerRanges.resize(samplerBinding.size());
-		int i = 0;
-		for (auto& bindingPair : samplerBinding)
-		{
-			PipelineStateObject::BindingData& bindingData = bindingPair.second;
-
-			CD3DX12_ROOT_PARAMETER1 SamplerParam;
-			SamplerRanges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, bindingData.numDescriptors, bindingData.baseRegister);
-			SamplerParam.InitAsDescriptorTable(1, &SamplerRanges[i], D3D12_SHADER_VISIBILITY_ALL);
-			rootParamVec.push_back(SamplerParam);
-			i++;
-			bindingData.rootParamIndex = RootParamIndex++;
-		}
-	}
-
-
-	if (rootBinding.size() != 0)
-	{
-		int i = 0;
-		for (auto& bindingPair : rootBinding)
-		{
-			PipelineStateObject::BindingData& bindingData = bindingPair.second;
-
-			CD3DX12_ROOT_PARAMETER1 ConstantParam;
-			ConstantParam.InitAsConstants(bindingData.numDescriptors, bindingData.baseRegister, 0, D3D12_SHADER_VISIBILITY_ALL);
-			rootParamVec.push_back(ConstantParam);
-			i++;
-			bindingData.rootParamIndex = RootParamIndex++;
-		}
-	}
+	NumRequests++;
 
-	vector<CD3DX12_DESCRIPTOR_RANGE1> CBRanges;
-	if (constantBufferBinding.size() != 0)
+	std::vector<std::unique_ptr<Entry>>& Bucket = Entries[Layout.GetHash()];
+	for (const std::unique_ptr<Entry>& Cached : Bucket)
 	{
-
-		CBRanges.resize(constantBufferBinding.size());
-		int i = 0;
-		for (auto& bindingPair : constantBufferBinding)
-		{
-			PipelineStateObject::BindingData& bindingData = bindingPair.second;
-
-			CD3DX12_ROOT_PARAMETER1 CBParam;
-			CBRanges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, bindingData.numDescriptors, bindingData.baseRegister, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
-			CBParam.InitAsDescriptorTable(1, &CBRanges[i], D3D12_SHADER_VISIBILITY_ALL);
-
-			rootParamVec.push_back(CBParam);
-			i++;
-			bindingData.rootParamIndex = RootParamIndex++;
-		}
+		if (Cached->Layout == Layout)
+			return Cached.get();
 	}
 
-	vector<CD3DX12_DESCRIPTOR_RANGE1> UAVRanges;
-	if (uavBinding.size() != 0)
+	const std::vector<RootParamDesc>& Params = Layout.GetParams();
+	vector<CD3DX12_ROOT_PARAMETER1> rootParamVec(Params.size());
+	vector<CD3DX12_DESCRIPTOR_RANGE1> Ranges(Params.size());
+	for (size_t i = 0; i < Params.size(); i++)
 	{
-		UAVRanges.resize(uavBinding.size());
-		int i = 0;
-		for (auto& bindingPair : uavBinding)
+		const RootParamDesc& Param = Params[i];
+		switch (Param.Type)
 		{
-			PipelineStateObject::BindingData& bindingData = bindingPair.second;
-			CD3DX12_ROOT_PARAMETER1 TextureParam;
-			UAVRanges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, bindingData.numDescriptors, bindingData.baseRegister, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
-			TextureParam.InitAsDescriptorTable(1, &UAVRanges[i], D3D12_SHADER_VISIBILITY_ALL);
-			rootParamVec.push_back(TextureParam);
-			i++;
-			bindingData.rootParamIndex = RootParamIndex++;
+		case RootParamType::SRVTable:
+			Ranges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, Param.NumDescriptors, Param.BaseRegister, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+			rootParamVec[i].InitAsDescriptorTable(1, &Ranges[i], D3D12_SHADER_VISIBILITY_ALL);
+			break;
+		case RootParamType::UAVTable:
+			Ranges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_UAV, Param.NumDescriptors, Param.BaseRegister, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+			rootParamVec[i].InitAsDescriptorTable(1, &Ranges[i], D3D12_SHADER_VISIBILITY_ALL);
+			break;
+		case RootParamType::CBVTable:
+			Ranges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_CBV, Param.NumDescriptors, Param.BaseRegister, 0, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE);
+			rootParamVec[i].InitAsDescriptorTable(1, &Ranges[i], D3D12_SHADER_VISIBILITY_ALL);
+			break;
+		case RootParamType::SamplerTable:
+			Ranges[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, Param.NumDescriptors, Param.BaseRegister);
+			rootParamVec[i].InitAsDescriptorTable(1, &Ranges[i], D3D12_SHADER_VISIBILITY_ALL);
+			break;
+		case RootParamType::Constants:
+			rootParamVec[i].InitAsConstants(Param.NumDescriptors, Param.BaseRegister, 0, D3D12_SHADER_VISIBILITY_ALL);
+			break;
 		}
 	}
 
 	CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDesc;
-	rootSignatureDesc.Init_1_1(rootParamVec.size(), &rootParamVec[0], 0, nullptr, D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+	rootSignatureDesc.Init_1_1(rootParamVec.size(), rootParamVec.data(), 0, nullptr, D3D12_ROOT_SIGNATURE_FLAGS(Layout.GetFlags()));
 
 	D3D12_FEATURE_DATA_ROOT_SIGNATURE featureData = {};
 	featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_1;
@@ -918,26 +1123,61 @@ bool PipelineStateObject::Init()
 		featureData.HighestVersion = D3D_ROOT_SIGNATURE_VERSION_1_0;
 	}
 
-	ComPtr<ID3DBlob> signature;
-	ComPtr<ID3DBlob> error;
+	std::unique_ptr<Entry> NewEntry = std::make_unique<Entry>();
+	NewEntry->Layout = Layout;
 
-	try
-	{
-		ThrowIfFailed(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &signature, &error));
-	}
-	catch (const std::exception& e)
+	ComPtr<ID3DBlob> error;
+	if (FAILED(D3DX12SerializeVersionedRootSignature(&rootSignatureDesc, featureData.HighestVersion, &NewEntry->Blob, &error)))
 	{
-		OutputDebugStringA(reinterpret_cast<const char*>(error->GetBufferPointer()));
+		if (error)
+			OutputDebugStringA(reinterpret_cast<const char*>(error->GetBufferPointer()));
+		return nullptr;
 	}
 
-	try
-	{
-		ThrowIfFailed(g_dx12_rhi->Device->CreateRootSignature(0, signature->GetBufferPointer(), signature->GetBufferSize(), IID_PPV_ARGS(&RS)));
-	}
-	catch (const std::exception& e)
+	if (FAILED(g_dx12_rhi->Device->CreateRootSignature(0, NewEntry->Blob->GetBufferPointer(), NewEntry->Blob->GetBufferSize(), IID_PPV_ARGS(&NewEntry->RS))))
+		return nullptr;
+
+	NumRootSignatures++;
+	Bucket.push_back(std::move(NewEntry));
+	return Bucket.back().get();
+}
+
+bool PipelineStateObject::Init()
+{
+	if (!IsCompute &&(!vs || !ps)) return false;
+	if (IsCompute && !cs) return false;
+
+	// root parameters in canonical order, psos with the same bindings under other names share the root
+	// signature and its parameter indices.
+	RootSignatureLayout Layout;
+	Layout.SetFlags(D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+	vector<BindingData*> Bindings;
+	auto AddBindings = [&Layout, &Bindings](map<string, BindingData>& BindingMap, RootParamType Type)
 	{
-		OutputDebugStringA(reinterpret_cast<const char*>(error->GetBufferPointer()));
-	}
+		for (auto& bindingPair : BindingMap)
+		{
+			Layout.AddParam(Type, bindingPair.second.baseRegister, bindingPair.second.numDescriptors);
+			Bindings.push_back(&bindingPair.second);
+		}
+	};
+	AddBindings(textureBinding, RootParamType::SRVTable);
+	AddBindings(samplerBinding, RootParamType::SamplerTable);
+	AddBindings(rootBinding, RootParamType::Constants);
+	AddBindings(constantBufferBinding, RootParamType::CBVTable);
+	AddBindings(uavBinding, RootParamType::UAVTable);
+
+	Layout.Canonicalize();
+	for (UINT i = 0; i < Bindings.size(); i++)
+		Bindings[i]->rootParamIndex = Layout.GetRootParamIndex(i);
+	RootParamIndex = UINT(Bindings.size());
+
+	const RootSignatureCache::Entry* Cached = g_dx12_rhi->RootSignatures.FindOrCreate(Layout);
+	if (!Cached)
+		return false;
+
+	RS = Cached->RS;
+	ID3DBlob* signature = Cached->Blob.Get();
 
 	NAME_D3D12_OBJECT(RS);
 	if (IsCompute)
@@ -945,7 +1185,7 @@ bool PipelineStateObject::Init()
 		computePSODesc.CS = CD3DX12_SHADER_BYTECODE(cs->GetBufferPointer(), cs->GetBufferSize());
 		computePSODesc.pRootSignature = RS.Get();
 		HRESULT hr;
-		ThrowIfFailed(hr = g_dx12_rhi->Device->CreateComputePipelineState(&computePSODesc, IID_PPV_ARGS(&PSO)));
+		ThrowIfFailed(hr = g_dx12_rhi->PipelineLibrary.CreateComputePipelineState(PSOLibrary::GetKey(computePSODesc, signature), computePSODesc, PSO));
 		NAME_D3D12_OBJECT(PSO);
 		return SUCCEEDED(hr);
 
@@ -957,7 +1197,7 @@ bool PipelineStateObject::Init()
 
 		graphicsPSODesc.pRootSignature = RS.Get();
 		HRESULT hr;
-		ThrowIfFailed(hr = g_dx12_rhi->Device->CreateGraphicsPipelineState(&graphicsPSODesc, IID_PPV_ARGS(&PSO)));
+		ThrowIfFailed(hr = g_dx12_rhi->PipelineLibrary.CreateGraphicsPipelineState(PSOLibrary::GetKey(graphicsPSODesc, signature), graphicsPSODesc, PSO));
 		NAME_D3D12_OBJECT(PSO);
 		return SUCCEEDED(hr);
 	}
@@ -993,6 +1233,29 @@ void Texture::MakeStaticSRV()
 	g_dx12_rhi->Device->CreateShaderResourceView(resource.Get(), &SrvDesc, SRV.CpuHandle);
 }
 
+void Texture::MakeStaticMipUAVs(UINT NumDescriptors)
+{
+	g_dx12_rhi->TextureDHRing->AllocDescriptor(MipUAVs.CpuHandle, MipUAVs.GpuHandle, NumDescriptors);
+	NumMipUAVs = NumDescriptors;
+
+	for (UINT i = 0; i < NumDescriptors; i++)
+	{
+		D3D12_CPU_DESCRIPTOR_HANDLE CpuHandle = MipUAVs.CpuHandle;
+		CpuHandle.ptr += i * g_dx12_rhi->TextureDHRing->DescriptorSize;
+
+		D3D12_UNORDERED_ACCESS_VIEW_DESC uavDesc = {};
+		uavDesc.ViewDimension = D3D12_UAV_DIMENSION_TEXTURE2D;
+		uavDesc.Format = textureDesc.Format;
+		uavDesc.Texture2D.MipSlice = i;
+
+		// null uav for the unused slots
+		ID3D12Resource* Res = i < textureDesc.MipLevels ? resource.Get() : nullptr;
+		if (!Res)
+			uavDesc.Texture2D.MipSlice = 0;
+		g_dx12_rhi->Device->CreateUnorderedAccessView(Res, nullptr, &uavDesc, CpuHandle);
+	}
+}
+
 void Texture::MakeDSV()
 {
 	g_dx12_rhi->DSVDescriptorHeap->AllocDescriptor(DSV.CpuHandle, DSV.GpuHandle);
@@ -1202,9 +1465,18 @@ void Texture::UploadSRCData3D(D3D12_SUBRESOURCE_DATA* SrcData)
 
 		NAME_D3D12_OBJECT(textureUploadHeap);
 
+		// rows of the upload footprint are 256 byte aligned, the source may be tightly packed.
 		UINT8* pData = nullptr;
 		textureUploadHeap->Map(0, nullptr, reinterpret_cast<void**>(&pData));
-		memcpy(reinterpret_cast<void*>(pData), SrcData->pData, TotalBytes);
+		for (UINT z = 0; z < descFootPrint.Footprint.Depth; z++)
+		{
+			for (UINT y = 0; y < Rows; y++)
+			{
+				UINT8* pDst = pData + descFootPrint.Offset + (z * Rows + y) * descFootPrint.Footprint.RowPitch;
+				const UINT8* pSrc = reinterpret_cast<const UINT8*>(SrcData->pData) + z * SrcData->SlicePitch + y * SrcData->RowPitch;
+				memcpy(pDst, pSrc, RowSize);
+			}
+		}
 		textureUploadHeap->Unmap(0, nullptr);
 
 		D3D12_TEXTURE_COPY_LOCATION dst = { };
@@ -1240,37 +1512,136 @@ void Texture::UploadSRCData3D(D3D12_SUBRESOURCE_DATA* SrcData)
 	}
 }
 
-Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
+class TextureMipData : public GfxTextureMipData
 {
-	if (FileExists(fileName.c_str()) == false)
-		return nullptr;
+public:
+	DirectX::ScratchImage image;
 
-	CommandList* cmd = g_dx12_rhi->CmdQSync->AllocCmdList();
+	TextureMipData() {}
+	virtual ~TextureMipData() {}
+};
 
+static bool LoadImageFromFile(const wstring& fileName, DirectX::ScratchImage& image)
+{
+	const std::wstring extension = GetFileExtension(fileName.c_str());
 
-	Texture* tex = new Texture;
+	HRESULT hr;
+	if (extension == L"DDS" || extension == L"dds")
+	{
+		hr = DirectX::LoadFromDDSFile(fileName.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image);
+	}
+	else if (extension == L"TGA" || extension == L"tga")
+	{
+		DirectX::ScratchImage tempImage;
+		hr = DirectX::LoadFromTGAFile(fileName.c_str(), nullptr, tempImage);
+		if (SUCCEEDED(hr))
+			hr = DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false);
+	}
+	else
+	{
+		DirectX::ScratchImage tempImage;
+		hr = DirectX::LoadFromWICFile(fileName.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, tempImage);
+		if (SUCCEEDED(hr))
+			hr = DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false);
+	}
 
-	DirectX::ScratchImage image;
+	return SUCCEEDED(hr);
+}
+
+// the chain LoadImageFromFile produces from mip FirstMip down, image's mip 0 is FirstMip. png and tga are
+// scaled straight to FirstMip so only the requested mips are generated, dds copies out its stored ones.
+static bool LoadImageMipsFromFile(const wstring& fileName, UINT FirstMip, DirectX::ScratchImage& image)
+{
+	if (FirstMip == 0)
+		return LoadImageFromFile(fileName, image);
+
+	const std::wstring extension = GetFileExtension(fileName.c_str());
+
+	DirectX::ScratchImage fileImage;
+	HRESULT hr;
+	if (extension == L"DDS" || extension == L"dds")
+	{
+		hr = DirectX::LoadFromDDSFile(fileName.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, fileImage);
+		if (FAILED(hr))
+			return false;
+
+		const DirectX::TexMetadata& metaData = fileImage.GetMetadata();
+		if (FirstMip >= metaData.mipLevels || metaData.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metaData.arraySize != 1)
+			return false;
+
+		const size_t numMips = metaData.mipLevels - FirstMip;
+		hr = image.Initialize2D(metaData.format, std::max<size_t>(metaData.width >> FirstMip, 1), std::max<size_t>(metaData.height >> FirstMip, 1), 1, numMips);
+		for (size_t mip = 0; SUCCEEDED(hr) && mip < numMips; mip++)
+		{
+			const DirectX::Image* src = fileImage.GetImage(FirstMip + mip, 0, 0);
+			const DirectX::Image* dst = image.GetImage(mip, 0, 0);
+			memcpy(dst->pixels, src->pixels, std::min(src->slicePitch, dst->slicePitch));
+		}
+		return SUCCEEDED(hr);
+	}
+
+	if (extension == L"TGA" || extension == L"tga")
+		hr = DirectX::LoadFromTGAFile(fileName.c_str(), nullptr, fileImage);
+	else
+		hr = DirectX::LoadFromWICFile(fileName.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, fileImage);
+	if (FAILED(hr))
+		return false;
+
+	const DirectX::Image& baseImage = *fileImage.GetImage(0, 0, 0);
+	const size_t width = std::max<size_t>(baseImage.width >> FirstMip, 1);
+	const size_t height = std::max<size_t>(baseImage.height >> FirstMip, 1);
+
+	DirectX::ScratchImage scaledImage;
+	hr = DirectX::Resize(baseImage, width, height, DirectX::TEX_FILTER_DEFAULT, scaledImage);
+	if (FAILED(hr))
+		return false;
+
+	// a 1x1 image is its own chain.
+	if (width == 1 && height == 1)
+	{
+		image = std::move(scaledImage);
+		return true;
+	}
 
+	return SUCCEEDED(DirectX::GenerateMipMaps(*scaledImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false));
+}
+
+// reads only the header. mip count is the one LoadImageFromFile will produce.
+static bool LoadImageMetadataFromFile(const wstring& fileName, DirectX::TexMetadata& metaData)
+{
 	const std::wstring extension = GetFileExtension(fileName.c_str());
 
+	HRESULT hr;
 	if (extension == L"DDS" || extension == L"dds")
 	{
-		DirectX::LoadFromDDSFile(fileName.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image);
+		return SUCCEEDED(DirectX::GetMetadataFromDDSFile(fileName.c_str(), DirectX::DDS_FLAGS_NONE, metaData));
 	}
 	else if (extension == L"TGA" || extension == L"tga")
 	{
-		DirectX::ScratchImage tempImage;
-		DirectX::LoadFromTGAFile(fileName.c_str(), nullptr, tempImage);
-		DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false);
+		hr = DirectX::GetMetadataFromTGAFile(fileName.c_str(), metaData);
 	}
 	else
 	{
-		DirectX::ScratchImage tempImage;
-		DirectX::LoadFromWICFile(fileName.c_str(), DirectX::WIC_FLAGS_NONE, nullptr, tempImage);
-		DirectX::GenerateMipMaps(*tempImage.GetImage(0, 0, 0), DirectX::TEX_FILTER_DEFAULT, 0, image, false);
+		hr = DirectX::GetMetadataFromWICFile(fileName.c_str(), DirectX::WIC_FLAGS_NONE, metaData);
 	}
 
+	size_t mipLevels = 1;
+	size_t dim = std::max(metaData.width, metaData.height);
+	while (dim > 1)
+	{
+		dim >>= 1;
+		mipLevels++;
+	}
+	metaData.mipLevels = mipLevels;
+
+	return SUCCEEDED(hr);
+}
+
+// creates a texture from mips [FirstMip, mipLevels) of image and records the copy into cmd.
+// uploadHeap has to be kept alive until cmd is executed.
+static void UploadImageMips(CommandList* cmd, const DirectX::ScratchImage& image, UINT FirstMip, bool nonSRGB, const wstring& name,
+	ComPtr<ID3D12Resource>& resource, ComPtr<ID3D12Resource>& uploadHeap, D3D12_RESOURCE_DESC& textureDesc)
+{
 	const DirectX::TexMetadata& metaData = image.GetMetadata();
 	DXGI_FORMAT format = metaData.format;
 
@@ -1279,13 +1650,16 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 
 	const bool is3D = metaData.dimension == DirectX::TEX_DIMENSION_TEXTURE3D;
 
-	D3D12_RESOURCE_DESC textureDesc = { };
-	textureDesc.MipLevels = UINT16(metaData.mipLevels);
+	FirstMip = glm::min<UINT>(FirstMip, UINT(metaData.mipLevels) - 1);
+	const UINT64 numMips = metaData.mipLevels - FirstMip;
+
+	textureDesc = { };
+	textureDesc.MipLevels = UINT16(numMips);
 	textureDesc.Format = format;
-	textureDesc.Width = UINT64(metaData.width);
-	textureDesc.Height = UINT64(metaData.height);
+	textureDesc.Width = glm::max<UINT64>(UINT64(metaData.width) >> FirstMip, 1);
+	textureDesc.Height = glm::max<UINT>(UINT(metaData.height) >> FirstMip, 1);
 	textureDesc.Flags = D3D12_RESOURCE_FLAG_NONE;
-	textureDesc.DepthOrArraySize = is3D ? UINT16(metaData.depth) : UINT16(metaData.arraySize);
+	textureDesc.DepthOrArraySize = is3D ? UINT16(glm::max<size_t>(metaData.depth >> FirstMip, 1)) : UINT16(metaData.arraySize);
 	textureDesc.SampleDesc.Count = 1;
 	textureDesc.SampleDesc.Quality = 0;
 	textureDesc.Dimension = is3D ? D3D12_RESOURCE_DIMENSION_TEXTURE3D : D3D12_RESOURCE_DIMENSION_TEXTURE2D;
@@ -1299,11 +1673,9 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 	heapProp.CreationNodeMask = 1;
 	heapProp.VisibleNodeMask = 1;
 
-	tex->textureDesc = textureDesc;
-
 	g_dx12_rhi->Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
-		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&tex->resource));
-	tex->resource->SetName(fileName.c_str());
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource));
+	resource->SetName(name.c_str());
 
 	D3D12_HEAP_PROPERTIES heapPropUpload;
 	heapPropUpload.Type = D3D12_HEAP_TYPE_UPLOAD;
@@ -1312,10 +1684,9 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 	heapPropUpload.CreationNodeMask = 1;
 	heapPropUpload.VisibleNodeMask = 1;
 
-	ComPtr<ID3D12Resource> uploadHeap;
-	
-	const UINT subresourceCount = textureDesc.DepthOrArraySize * textureDesc.MipLevels;
-	const UINT64 uploadBufferSize = GetRequiredIntermediateSize(tex->resource.Get(), 0, subresourceCount);
+	const UINT64 arraySize = is3D ? 1 : metaData.arraySize;
+	const UINT subresourceCount = UINT(arraySize * numMips);
+	const UINT64 uploadBufferSize = GetRequiredIntermediateSize(resource.Get(), 0, subresourceCount);
 	D3D12_RESOURCE_DESC resDesc;
 	resDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
 	resDesc.Alignment = 0;
@@ -1337,7 +1708,7 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&uploadHeap));
 	uploadHeap->SetName(L"TexUploadingHeap");
 
-	const UINT64 numSubResources = metaData.mipLevels * metaData.arraySize;
+	const UINT64 numSubResources = subresourceCount;
 	D3D12_PLACED_SUBRESOURCE_FOOTPRINT* layouts = (D3D12_PLACED_SUBRESOURCE_FOOTPRINT*)_alloca(sizeof(D3D12_PLACED_SUBRESOURCE_FOOTPRINT) * numSubResources);
 	UINT32* numRows = (UINT32*)_alloca(sizeof(UINT32) * numSubResources);
 	UINT64* rowSizes = (UINT64*)_alloca(sizeof(UINT64) * numSubResources);
@@ -1349,12 +1720,12 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 
 	D3D12_RANGE readRange = { };
 	uploadHeap->Map(0, &readRange, reinterpret_cast<void**>(&uploadMem));
-	for (UINT64 arrayIdx = 0; arrayIdx < metaData.arraySize; ++arrayIdx)
+	for (UINT64 arrayIdx = 0; arrayIdx < arraySize; ++arrayIdx)
 	{
 
-		for (UINT64 mipIdx = 0; mipIdx < metaData.mipLevels; ++mipIdx)
+		for (UINT64 mipIdx = 0; mipIdx < numMips; ++mipIdx)
 		{
-			const UINT64 subResourceIdx = mipIdx + (arrayIdx * metaData.mipLevels);
+			const UINT64 subResourceIdx = mipIdx + (arrayIdx * numMips);
 
 			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& subResourceLayout = layouts[subResourceIdx];
 			const UINT64 subResourceHeight = numRows[subResourceIdx];
@@ -1364,7 +1735,7 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 
 			for (UINT64 z = 0; z < subResourceDepth; ++z)
 			{
-				const DirectX::Image* subImage = image.GetImage(mipIdx, arrayIdx, z);
+				const DirectX::Image* subImage = image.GetImage(FirstMip + mipIdx, arrayIdx, z);
 				const UINT8* srcSubResourceMem = subImage->pixels;
 
 				for (UINT64 y = 0; y < subResourceHeight; ++y)
@@ -1381,7 +1752,7 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 	for (UINT64 subResourceIdx = 0; subResourceIdx < numSubResources; ++subResourceIdx)
 	{
 		D3D12_TEXTURE_COPY_LOCATION dst = { };
-		dst.pResource = tex->resource.Get();
+		dst.pResource = resource.Get();
 		dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
 		dst.SubresourceIndex = UINT32(subResourceIdx);
 		D3D12_TEXTURE_COPY_LOCATION src = { };
@@ -1397,11 +1768,29 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 	D3D12_RESOURCE_BARRIER BarrierDesc = {};
 	BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
 	BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
-	BarrierDesc.Transition.pResource = tex->resource.Get();
+	BarrierDesc.Transition.pResource = resource.Get();
 	BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
 	BarrierDesc.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
 	BarrierDesc.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
 	cmd->CmdList->ResourceBarrier(1, &BarrierDesc);
+}
+
+Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
+{
+	if (FileExists(fileName.c_str()) == false)
+		return nullptr;
+
+	DirectX::ScratchImage image;
+	if (!LoadImageFromFile(fileName, image))
+		return nullptr;
+
+	CommandList* cmd = g_dx12_rhi->CmdQSync->AllocCmdList();
+
+	Texture* tex = new Texture;
+	tex->name = fileName;
+
+	ComPtr<ID3D12Resource> uploadHeap;
+	UploadImageMips(cmd, image, 0, nonSRGB, fileName, tex->resource, uploadHeap, tex->textureDesc);
 
 	g_dx12_rhi->CmdQSync->ExecuteCommandList(cmd);
 	g_dx12_rhi->CmdQSync->WaitGPU();
@@ -1410,6 +1799,215 @@ Texture* DX12Impl::CreateTextureFromFile(wstring fileName, bool nonSRGB)
 
 	return tex;
 }
+
+Texture* DX12Impl::CreateStreamingTexture(wstring fileName, bool nonSRGB, Texture* placeholder, UINT& width, UINT& height, vector<UINT64>& mipBytes)
+{
+	if (FileExists(fileName.c_str()) == false || placeholder == nullptr)
+		return nullptr;
+
+	DirectX::TexMetadata metaData;
+	if (!LoadImageMetadataFromFile(fileName, metaData))
+		return nullptr;
+
+	// block compressed mips can't be used as the top of a resource once they get smaller than a block.
+	if (metaData.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metaData.arraySize != 1 || DirectX::IsCompressed(metaData.format))
+		return nullptr;
+
+	D3D12_RESOURCE_DESC fullDesc = { };
+	fullDesc.MipLevels = UINT16(metaData.mipLevels);
+	fullDesc.Format = nonSRGB ? metaData.format : DirectX::MakeSRGB(metaData.format);
+	fullDesc.Width = UINT64(metaData.width);
+	fullDesc.Height = UINT(metaData.height);
+	fullDesc.DepthOrArraySize = 1;
+	fullDesc.SampleDesc.Count = 1;
+	fullDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+	vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts(metaData.mipLevels);
+	vector<UINT> numRows(metaData.mipLevels);
+	Device->GetCopyableFootprints(&fullDesc, 0, UINT(metaData.mipLevels), 0, layouts.data(), numRows.data(), nullptr, nullptr);
+
+	mipBytes.resize(metaData.mipLevels);
+	for (size_t i = 0; i < metaData.mipLevels; i++)
+		mipBytes[i] = UINT64(layouts[i].Footprint.RowPitch) * numRows[i];
+
+	width = UINT(metaData.width);
+	height = UINT(metaData.height);
+
+	// nothing is resident until the mip tail arrives, so it points to the placeholder.
+	Texture* tex = new Texture;
+	tex->name = fileName;
+	tex->bStreaming = true;
+	tex->bNonSRGB = nonSRGB;
+	tex->NumStreamingMips = UINT(metaData.mipLevels);
+	tex->FirstResidentMip = UINT(metaData.mipLevels);
+	tex->resource = placeholder->resource;
+	tex->textureDesc = placeholder->textureDesc;
+
+	AllocStreamingSRV(tex->SRV);
+	CreateStreamingSRV(tex);
+
+	return tex;
+}
+
+GfxTextureMipData* DX12Impl::LoadStreamingTextureMips(Texture* tex, UINT FirstMip)
+{
+	// runs on the streaming thread. WIC needs com on every thread using it.
+	static thread_local bool bComInitialized = false;
+	if (!bComInitialized)
+	{
+		CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+		bComInitialized = true;
+	}
+
+	TextureMipData* data = new TextureMipData;
+	if (FirstMip >= tex->NumStreamingMips || !LoadImageMipsFromFile(tex->name, FirstMip, data->image)
+		|| data->image.GetMetadata().mipLevels != tex->NumStreamingMips - FirstMip)
+	{
+		delete data;
+		return nullptr;
+	}
+
+	return data;
+}
+
+bool DX12Impl::UpdateStreamingTexture(Texture* tex, GfxTextureMipData* data, UINT FirstMip)
+{
+	if (!tex->bStreaming || !data)
+		return false;
+
+	TextureMipData* mipData = static_cast<TextureMipData*>(data);
+
+	// recorded before this frame's command list on the same queue, so it's complete before any draw reads it.
+	// the list is recycled once the queue passes this frame's fence.
+	CommandList* cmd = CmdQSync->AllocCmdList();
+	cmd->Fence = CmdQSync->CurrentFenceValue;
+
+	// the loaded chain starts at FirstMip.
+	ComPtr<ID3D12Resource> resource;
+	ComPtr<ID3D12Resource> uploadHeap;
+	D3D12_RESOURCE_DESC textureDesc;
+	UploadImageMips(cmd, mipData->image, 0, tex->bNonSRGB, tex->name, resource, uploadHeap, textureDesc);
+
+	CmdQSync->ExecuteCommandList(cmd);
+
+	SwapStreamingTexture(tex, resource, textureDesc, FirstMip, uploadHeap);
+	return true;
+}
+
+bool DX12Impl::TrimStreamingTexture(Texture* tex, UINT FirstMip)
+{
+	if (!tex->bStreaming || FirstMip <= tex->FirstResidentMip || FirstMip >= tex->NumStreamingMips)
+		return false;
+
+	// keeps the coarse mips by copying them on the gpu, the file is not touched.
+	const UINT srcMipOffset = FirstMip - tex->FirstResidentMip;
+
+	D3D12_RESOURCE_DESC textureDesc = tex->textureDesc;
+	textureDesc.MipLevels = UINT16(tex->NumStreamingMips - FirstMip);
+	textureDesc.Width = glm::max<UINT64>(tex->textureDesc.Width >> srcMipOffset, 1);
+	textureDesc.Height = glm::max<UINT>(tex->textureDesc.Height >> srcMipOffset, 1);
+
+	D3D12_HEAP_PROPERTIES heapProp = {};
+	heapProp.Type = D3D12_HEAP_TYPE_DEFAULT;
+	heapProp.CreationNodeMask = 1;
+	heapProp.VisibleNodeMask = 1;
+
+	ComPtr<ID3D12Resource> resource;
+	if (FAILED(Device->CreateCommittedResource(&heapProp, D3D12_HEAP_FLAG_NONE, &textureDesc,
+		D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&resource))))
+		return false;
+	resource->SetName(tex->name.c_str());
+
+	CommandList* cmd = CmdQSync->AllocCmdList();
+	cmd->Fence = CmdQSync->CurrentFenceValue;
+
+	D3D12_RESOURCE_BARRIER BarrierDesc = {};
+	BarrierDesc.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+	BarrierDesc.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+	BarrierDesc.Transition.pResource = tex->resource.Get();
+	BarrierDesc.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
+	BarrierDesc.Transition.StateBefore = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	BarrierDesc.Transition.StateAfter = D3D12_RESOURCE_STATE_COPY_SOURCE;
+	cmd->CmdList->ResourceBarrier(1, &BarrierDesc);
+
+	for (UINT mip = 0; mip < textureDesc.MipLevels; mip++)
+	{
+		D3D12_TEXTURE_COPY_LOCATION dst = { };
+		dst.pResource = resource.Get();
+		dst.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		dst.SubresourceIndex = mip;
+		D3D12_TEXTURE_COPY_LOCATION src = { };
+		src.pResource = tex->resource.Get();
+		src.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+		src.SubresourceIndex = mip + srcMipOffset;
+
+		cmd->CmdList->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
+
+	BarrierDesc.Transition.pResource = resource.Get();
+	BarrierDesc.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
+	BarrierDesc.Transition.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
+	cmd->CmdList->ResourceBarrier(1, &BarrierDesc);
+
+	CmdQSync->ExecuteCommandList(cmd);
+
+	SwapStreamingTexture(tex, resource, textureDesc, FirstMip, nullptr);
+	return true;
+}
+
+void DX12Impl::AllocStreamingSRV(Descriptor& SRV)
+{
+	if (FreeStreamingSRVs.size() > 0)
+	{
+		SRV = FreeStreamingSRVs.back();
+		FreeStreamingSRVs.pop_back();
+	}
+	else
+	{
+		TextureDHRing->AllocDescriptor(SRV.CpuHandle, SRV.GpuHandle);
+	}
+}
+
+void DX12Impl::CreateStreamingSRV(Texture* tex)
+{
+	D3D12_SHADER_RESOURCE_VIEW_DESC SrvDesc = {};
+	SrvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+	SrvDesc.Format = tex->textureDesc.Format;
+	SrvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+	SrvDesc.Texture2D.MipLevels = tex->textureDesc.MipLevels;
+	Device->CreateShaderResourceView(tex->resource.Get(), &SrvDesc, tex->SRV.CpuHandle);
+}
+
+void DX12Impl::SwapStreamingTexture(Texture* tex, ComPtr<ID3D12Resource> resource, const D3D12_RESOURCE_DESC& textureDesc, UINT FirstMip, ComPtr<ID3D12Resource> uploadHeap)
+{
+	// command lists already recorded still reference the old descriptor and resource, so both are
+	// retired until the gpu passes the fence of the frame being recorded now.
+	RetiredStreamingTexture retired;
+	retired.resource = tex->resource;
+	retired.uploadHeap = uploadHeap;
+	retired.SRV = tex->SRV;
+	retired.FenceValue = CmdQSync->CurrentFenceValue;
+	RetiredStreamingTextures.push_back(retired);
+
+	tex->resource = resource;
+	tex->textureDesc = textureDesc;
+	tex->FirstResidentMip = FirstMip;
+
+	AllocStreamingSRV(tex->SRV);
+	CreateStreamingSRV(tex);
+}
+
+void DX12Impl::ReleaseRetiredStreamingTextures()
+{
+	const UINT64 completedFenceValue = CmdQSync->m_fence->GetCompletedValue();
+
+	while (RetiredStreamingTextures.size() > 0 && RetiredStreamingTextures.front().FenceValue <= completedFenceValue)
+	{
+		FreeStreamingSRVs.push_back(RetiredStreamingTextures.front().SRV);
+		RetiredStreamingTextures.pop_front();
+	}
+}
+
 static const D3D12_HEAP_PROPERTIES kDefaultHeapProps =
 {
 	D3D12_HEAP_TYPE_DEFAULT,
@@ -1527,6 +2125,18 @@ static const D3D12_HEAP_PROPERTIES kUploadHeapProps =
 //}
 
 RTAS* DX12Impl::CreateTLAS(vector<RTAS*>& VecBottomLevelAS)
+{
+	vector<GfxRTInstance> Instances(VecBottomLevelAS.size());
+	for (int i = 0; i < VecBottomLevelAS.size(); i++)
+	{
+		Instances[i].BLASIndex = i;
+		Instances[i].InstanceID = i;
+		Instances[i].Transform = VecBottomLevelAS[i]->mesh->transform;
+	}
+	return CreateTLAS(VecBottomLevelAS, Instances);
+}
+
+RTAS* DX12Impl::CreateTLAS(vector<RTAS*>& VecBottomLevelAS, const vector<GfxRTInstance>& Instances)
 {
 	RTAS* as = new  RTAS;
 
@@ -1534,7 +2144,7 @@ RTAS* DX12Impl::CreateTLAS(vector<RTAS*>& VecBottomLevelAS)
 	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS inputs = {};
 	inputs.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
 	inputs.Flags = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
-	inputs.NumDescs = VecBottomLevelAS.size();
+	inputs.NumDescs = Instances.size();
 	inputs.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
 
 	D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info;
@@ -1586,25 +2196,26 @@ RTAS* DX12Impl::CreateTLAS(vector<RTAS*>& VecBottomLevelAS)
 		bufDesc.MipLevels = 1;
 		bufDesc.SampleDesc.Count = 1;
 		bufDesc.SampleDesc.Quality = 0;
-		bufDesc.Width = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * VecBottomLevelAS.size();
+		bufDesc.Width = sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * Instances.size();
 
 		g_dx12_rhi->Device->CreateCommittedResource(&kUploadHeapProps, D3D12_HEAP_FLAG_NONE, &bufDesc, D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(&as->Instance));
 	}
 
-	if (VecBottomLevelAS.size() > 0)
+	if (Instances.size() > 0)
 	{
 		D3D12_RAYTRACING_INSTANCE_DESC* pInstanceDesc;
 		as->Instance->Map(0, nullptr, (void**)&pInstanceDesc);
-		ZeroMemory(pInstanceDesc, sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * VecBottomLevelAS.size());
+		ZeroMemory(pInstanceDesc, sizeof(D3D12_RAYTRACING_INSTANCE_DESC) * Instances.size());
 
-		for (int i = 0; i < VecBottomLevelAS.size(); i++)
+		for (int i = 0; i < Instances.size(); i++)
 		{
-			pInstanceDesc[i].InstanceID = i;                            // This value will be exposed to the shader via InstanceID()
-			pInstanceDesc[i].InstanceContributionToHitGroupIndex = i;   // This is the offset inside the shader-table. We only have a single geometry, so the offset 0
+			const GfxRTInstance& Instance = Instances[i];
+			pInstanceDesc[i].InstanceID = Instance.InstanceID;                                  // This value will be exposed to the shader via InstanceID()
+			pInstanceDesc[i].InstanceContributionToHitGroupIndex = Instance.BLASIndex;          // hit group record of the blas, shared by its instances
 			pInstanceDesc[i].Flags = D3D12_RAYTRACING_INSTANCE_FLAG_NONE;
-			glm::mat4x4 mat = glm::transpose(VecBottomLevelAS[i]->mesh->transform);
+			glm::mat4x4 mat = glm::transpose(Instance.Transform);
 			memcpy(pInstanceDesc[i].Transform, &mat, sizeof(pInstanceDesc[i].Transform));
-			pInstanceDesc[i].AccelerationStructure = VecBottomLevelAS[i]->Result->GetGPUVirtualAddress();
+			pInstanceDesc[i].AccelerationStructure = VecBottomLevelAS[Instance.BLASIndex]->Result->GetGPUVirtualAddress();
 			pInstanceDesc[i].InstanceMask = 0xFF;
 		}
 		as->Instance->Unmap(0, nullptr);
@@ -1617,7 +2228,7 @@ RTAS* DX12Impl::CreateTLAS(vector<RTAS*>& VecBottomLevelAS)
 	D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC asDesc = {};
 	asDesc.Inputs = inputs;
 
-	if (VecBottomLevelAS.size() > 0)
+	if (Instances.size() > 0)
 		asDesc.Inputs.InstanceDescs = as->Instance->GetGPUVirtualAddress();
 	asDesc.DestAccelerationStructureData = as->Result->GetGPUVirtualAddress();
 	asDesc.ScratchAccelerationStructureData = as->Scratch->GetGPUVirtualAddress();
@@ -3017,6 +3628,9 @@ void DescriptorHeapRing::Init(DescriptorHeap* InDHHeap, UINT InNumDescriptors, U
 
 UINT DescriptorHeapRing::AllocDescriptor(D3D12_CPU_DESCRIPTOR_HANDLE& cpuHandle, D3D12_GPU_DESCRIPTOR_HANDLE& gpuHandle, UINT32 Num)
 {
+	// past the frame's range the descriptors would overwrite the next frame's, which may still be in flight.
+	assert(NumAllocated + Num <= NumDescriptors && "descriptor ring range of the frame is full");
+
 	UINT offset = NumAllocated * DescriptorSize + NumDescriptors * DescriptorSize * CurrentFrame;
 	cpuHandle.ptr = CPUHeapStart.ptr + offset;// NumAllocated* DescriptorSize + NumDescriptors * DescriptorSize * CurrentFrame;
 	gpuHandle.ptr = GPUHeapStart.ptr + offset;//  NumAllocated* DescriptorSize + NumDescriptors * DescriptorSize * CurrentFrame;
@@ -3038,9 +3652,21 @@ void Scene::SetTransform(glm::mat4x4 inTransform)
 	{
 		mesh->transform = inTransform;
 	}
+
+	if (Instances.Size() == 0)
+		Instances.Add(inTransform);
+	else
+		Instances.Set(0, inTransform);
 }
 
-CommandQueue::CommandQueue()
+UINT Scene::AddInstance(glm::mat4x4 inTransform)
+{
+	return Instances.Add(inTransform);
+}
+
+CommandQueue::CommandQueue(D3D12_COMMAND_LIST_TYPE InType, UINT32 InCommandListPoolSize)
+	: Type(InType)
+	, CommandListPoolSize(InCommandListPoolSize)
 {
 	ThrowIfFailed(g_dx12_rhi->Device->CreateFence(CurrentFenceValue, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence)));
 	// Create an event handle to use for frame synchronization.
@@ -3048,7 +3674,7 @@ CommandQueue::CommandQueue()
 
 	D3D12_COMMAND_QUEUE_DESC queueDesc = {};
 	queueDesc.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE;
-	queueDesc.Type = D3D12_COMMAND_LIST_TYPE_DIRECT;
+	queueDesc.Type = Type;
 
 	ThrowIfFailed(g_dx12_rhi->Device->CreateCommandQueue(&queueDesc, IID_PPV_ARGS(&CmdQueue)));
 	NAME_D3D12_OBJECT(CmdQueue);
@@ -3057,10 +3683,10 @@ CommandQueue::CommandQueue()
 	for (int i = 0; i < CommandListPoolSize; i++)
 	{
 		CommandList * cmdList = new CommandList;
-		ThrowIfFailed(g_dx12_rhi->Device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&cmdList->CmdAllocator)));
+		ThrowIfFailed(g_dx12_rhi->Device->CreateCommandAllocator(Type, IID_PPV_ARGS(&cmdList->CmdAllocator)));
 		NAME_D3D12_OBJECT(cmdList->CmdAllocator);
 
-		ThrowIfFailed(g_dx12_rhi->Device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, cmdList->CmdAllocator.Get(), nullptr, IID_PPV_ARGS(&cmdList->CmdList)));
+		ThrowIfFailed(g_dx12_rhi->Device->CreateCommandList(0, Type, cmdList->CmdAllocator.Get(), nullptr, IID_PPV_ARGS(&cmdList->CmdList)));
 		cmdList->CmdList->Close();
 		NAME_D3D12_OBJECT(cmdList->CmdList);
 
@@ -3185,6 +3811,220 @@ ConstantBufferRingBuffer::~ConstantBufferRingBuffer()
 	CBMem->Unmap(0, nullptr);
 }
 
+static void HashShader(PipelineHasher& Hasher, const D3D12_SHADER_BYTECODE& Shader)
+{
+	Hasher.AddBlob(Shader.pShaderBytecode, Shader.BytecodeLength);
+}
+
+static void HashRootSignature(PipelineHasher& Hasher, ID3DBlob* RootSignature)
+{
+	if (RootSignature)
+		Hasher.AddBlob(RootSignature->GetBufferPointer(), RootSignature->GetBufferSize());
+	else
+		Hasher.AddBlob(nullptr, 0);
+}
+
+UINT64 PSOLibrary::GetKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ID3DBlob* RootSignature)
+{
+	// field by field, the state structs have padding.
+	PipelineHasher Hasher;
+	Hasher.AddValue(UINT(0));
+	HashRootSignature(Hasher, RootSignature);
+	HashShader(Hasher, Desc.VS);
+	HashShader(Hasher, Desc.PS);
+	HashShader(Hasher, Desc.DS);
+	HashShader(Hasher, Desc.HS);
+	HashShader(Hasher, Desc.GS);
+
+	Hasher.AddValue(Desc.StreamOutput.NumEntries);
+	for (UINT i = 0; i < Desc.StreamOutput.NumEntries; i++)
+	{
+		const D3D12_SO_DECLARATION_ENTRY& Entry = Desc.StreamOutput.pSODeclaration[i];
+		Hasher.AddValue(Entry.Stream);
+		Hasher.AddString(Entry.SemanticName);
+		Hasher.AddValue(Entry.SemanticIndex);
+		Hasher.AddValue(Entry.StartComponent);
+		Hasher.AddValue(Entry.ComponentCount);
+		Hasher.AddValue(Entry.OutputSlot);
+	}
+	Hasher.AddValue(Desc.StreamOutput.NumStrides);
+	for (UINT i = 0; i < Desc.StreamOutput.NumStrides; i++)
+		Hasher.AddValue(Desc.StreamOutput.pBufferStrides[i]);
+	Hasher.AddValue(Desc.StreamOutput.RasterizedStream);
+
+	Hasher.AddValue(Desc.BlendState.AlphaToCoverageEnable);
+	Hasher.AddValue(Desc.BlendState.IndependentBlendEnable);
+	for (const D3D12_RENDER_TARGET_BLEND_DESC& Blend : Desc.BlendState.RenderTarget)
+	{
+		Hasher.AddValue(Blend.BlendEnable);
+		Hasher.AddValue(Blend.LogicOpEnable);
+		Hasher.AddValue(Blend.SrcBlend);
+		Hasher.AddValue(Blend.DestBlend);
+		Hasher.AddValue(Blend.BlendOp);
+		Hasher.AddValue(Blend.SrcBlendAlpha);
+		Hasher.AddValue(Blend.DestBlendAlpha);
+		Hasher.AddValue(Blend.BlendOpAlpha);
+		Hasher.AddValue(Blend.LogicOp);
+		Hasher.AddValue(Blend.RenderTargetWriteMask);
+	}
+	Hasher.AddValue(Desc.SampleMask);
+
+	const D3D12_RASTERIZER_DESC& Rasterizer = Desc.RasterizerState;
+	Hasher.AddValue(Rasterizer.FillMode);
+	Hasher.AddValue(Rasterizer.CullMode);
+	Hasher.AddValue(Rasterizer.FrontCounterClockwise);
+	Hasher.AddValue(Rasterizer.DepthBias);
+	Hasher.AddValue(Rasterizer.DepthBiasClamp);
+	Hasher.AddValue(Rasterizer.SlopeScaledDepthBias);
+	Hasher.AddValue(Rasterizer.DepthClipEnable);
+	Hasher.AddValue(Rasterizer.MultisampleEnable);
+	Hasher.AddValue(Rasterizer.AntialiasedLineEnable);
+	Hasher.AddValue(Rasterizer.ForcedSampleCount);
+	Hasher.AddValue(Rasterizer.ConservativeRaster);
+
+	const D3D12_DEPTH_STENCIL_DESC& DepthStencil = Desc.DepthStencilState;
+	Hasher.AddValue(DepthStencil.DepthEnable);
+	Hasher.AddValue(DepthStencil.DepthWriteMask);
+	Hasher.AddValue(DepthStencil.DepthFunc);
+	Hasher.AddValue(DepthStencil.StencilEnable);
+	Hasher.AddValue(DepthStencil.StencilReadMask);
+	Hasher.AddValue(DepthStencil.StencilWriteMask);
+	for (const D3D12_DEPTH_STENCILOP_DESC& Face : { DepthStencil.FrontFace, DepthStencil.BackFace })
+	{
+		Hasher.AddValue(Face.StencilFailOp);
+		Hasher.AddValue(Face.StencilDepthFailOp);
+		Hasher.AddValue(Face.StencilPassOp);
+		Hasher.AddValue(Face.StencilFunc);
+	}
+
+	Hasher.AddValue(Desc.InputLayout.NumElements);
+	for (UINT i = 0; i < Desc.InputLayout.NumElements; i++)
+	{
+		const D3D12_INPUT_ELEMENT_DESC& Element = Desc.InputLayout.pInputElementDescs[i];
+		Hasher.AddString(Element.SemanticName);
+		Hasher.AddValue(Element.SemanticIndex);
+		Hasher.AddValue(Element.Format);
+		Hasher.AddValue(Element.InputSlot);
+		Hasher.AddValue(Element.AlignedByteOffset);
+		Hasher.AddValue(Element.InputSlotClass);
+		Hasher.AddValue(Element.InstanceDataStepRate);
+	}
+
+	Hasher.AddValue(Desc.IBStripCutValue);
+	Hasher.AddValue(Desc.PrimitiveTopologyType);
+	Hasher.AddValue(Desc.NumRenderTargets);
+	for (UINT i = 0; i < Desc.NumRenderTargets; i++)
+		Hasher.AddValue(Desc.RTVFormats[i]);
+	Hasher.AddValue(Desc.DSVFormat);
+	Hasher.AddValue(Desc.SampleDesc.Count);
+	Hasher.AddValue(Desc.SampleDesc.Quality);
+	Hasher.AddValue(Desc.NodeMask);
+	Hasher.AddValue(Desc.Flags);
+	return Hasher.Get();
+}
+
+UINT64 PSOLibrary::GetKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ID3DBlob* RootSignature)
+{
+	PipelineHasher Hasher;
+	Hasher.AddValue(UINT(1));
+	HashRootSignature(Hasher, RootSignature);
+	HashShader(Hasher, Desc.CS);
+	Hasher.AddValue(Desc.NodeMask);
+	Hasher.AddValue(Desc.Flags);
+	return Hasher.Get();
+}
+
+void PSOLibrary::Start(const std::string& InPath, uint64_t InDeviceId)
+{
+	Path = InPath;
+	DeviceId = InDeviceId;
+	Loader.Start(Path, DeviceId);
+}
+
+void PSOLibrary::WaitLoaded()
+{
+	if (bLoaded)
+		return;
+	bLoaded = true;
+
+	std::string Error;
+	if (!Loader.Get(LibraryData, Error) && !Error.empty())
+		OutputDebugStringA(("pipeline cache: " + Error + "\n").c_str());
+
+	HRESULT hr = E_FAIL;
+	if (!LibraryData.empty())
+		hr = g_dx12_rhi->Device->CreatePipelineLibrary(LibraryData.data(), LibraryData.size(), IID_PPV_ARGS(&Library));
+
+	// a new driver rejects the blob, start with an empty library.
+	if (FAILED(hr))
+	{
+		LibraryData.clear();
+		hr = g_dx12_rhi->Device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&Library));
+	}
+
+	// without pipeline library support psos are created directly.
+	if (FAILED(hr))
+		Library = nullptr;
+}
+
+HRESULT PSOLibrary::CreateGraphicsPipelineState(UINT64 Key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ComPtr<ID3D12PipelineState>& OutPSO)
+{
+	WaitLoaded();
+
+	const std::wstring Name = GetPipelineKeyName(Key);
+	if (Library && SUCCEEDED(Library->LoadGraphicsPipeline(Name.c_str(), &Desc, IID_PPV_ARGS(&OutPSO))))
+	{
+		NumLoaded++;
+		return S_OK;
+	}
+
+	HRESULT hr = g_dx12_rhi->Device->CreateGraphicsPipelineState(&Desc, IID_PPV_ARGS(&OutPSO));
+	if (SUCCEEDED(hr))
+	{
+		NumCreated++;
+		if (Library && SUCCEEDED(Library->StorePipeline(Name.c_str(), OutPSO.Get())))
+			bDirty = true;
+	}
+	return hr;
+}
+
+HRESULT PSOLibrary::CreateComputePipelineState(UINT64 Key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ComPtr<ID3D12PipelineState>& OutPSO)
+{
+	WaitLoaded();
+
+	const std::wstring Name = GetPipelineKeyName(Key);
+	if (Library && SUCCEEDED(Library->LoadComputePipeline(Name.c_str(), &Desc, IID_PPV_ARGS(&OutPSO))))
+	{
+		NumLoaded++;
+		return S_OK;
+	}
+
+	HRESULT hr = g_dx12_rhi->Device->CreateComputePipelineState(&Desc, IID_PPV_ARGS(&OutPSO));
+	if (SUCCEEDED(hr))
+	{
+		NumCreated++;
+		if (Library && SUCCEEDED(Library->StorePipeline(Name.c_str(), OutPSO.Get())))
+			bDirty = true;
+	}
+	return hr;
+}
+
+void PSOLibrary::Save()
+{
+	if (!Library || !bDirty)
+		return;
+
+	// psos of replaced shaders stay in the library, deleting the file drops them.
+	std::vector<uint8_t> Data(Library->GetSerializedSize());
+	if (FAILED(Library->Serialize(Data.data(), Data.size())))
+		return;
+
+	std::string Error;
+	if (!WritePipelineCacheFile(Path, DeviceId, Data.data(), Data.size(), Error))
+		OutputDebugStringA(("pipeline cache: " + Error + "\n").c_str());
+	bDirty = false;
+}
+
 void Buffer::MakeByteAddressBufferSRV()
 {
 	// create shader resource view
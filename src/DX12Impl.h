@@ -10,6 +10,7 @@
 #include <vector>
 #include <list>
 #include <map>
+#include <unordered_map>
 #include <memory>
 #include <string>
 #include <optional>
@@ -35,6 +36,8 @@
 #include "DXSampleHelper.h"
 
 #include "AbstractGfxLayer.h"
+#include "PipelineCache.h"
+#include "RootSignatureLayout.h"
 
 
 using namespace Microsoft::WRL;
@@ -102,7 +105,8 @@ public:
 class CommandQueue
 {
 public:
-	const UINT32 CommandListPoolSize = 4096;
+	const D3D12_COMMAND_LIST_TYPE Type;
+	const UINT32 CommandListPoolSize;
 
 	ComPtr<ID3D12CommandQueue> CmdQueue;
 
@@ -115,7 +119,7 @@ public:
 	ComPtr<ID3D12Fence> m_fence;
 	UINT64 CurrentFenceValue = 2;
 public:
-	CommandQueue();
+	CommandQueue(D3D12_COMMAND_LIST_TYPE InType = D3D12_COMMAND_LIST_TYPE_DIRECT, UINT32 InCommandListPoolSize = 4096);
 	virtual ~CommandQueue();
 
 	CommandList* AllocCmdList();
@@ -179,7 +183,7 @@ public:
 
 	void Apply(ID3D12GraphicsCommandList* CommandList);
 
-	void BindUAV(string name, int baseRegister);
+	void BindUAV(string name, int baseRegister, int num = 1);
 	void BindSRV(string name, int baseRegister, int num);
 	void BindCBV(string name, int baseRegister, int size);
 	void BindRootConstant(string name, int baseRegister);
@@ -343,6 +347,33 @@ public:
 	}
 };
 
+class CommandSignature : public GfxCommandSignature
+{
+public:
+	ComPtr<ID3D12CommandSignature> Signature;
+	UINT Stride = 0;
+
+	CommandSignature() {}
+	virtual ~CommandSignature() {}
+};
+
+// one copy of the table per frame in flight. a copy is rewritten when it's bound, only for the entries
+// whose resource changed since then. the frame that used it last is complete at that point.
+class TextureTable : public GfxTextureTable
+{
+public:
+	UINT NumDescriptors = 0;
+	vector<Texture*> Textures;
+
+	vector<Descriptor> FrameTables;
+	vector<vector<ID3D12Resource*>> FrameResources;
+
+	Descriptor& UpdateFrameTable(UINT FrameIndex);
+
+	TextureTable() {}
+	virtual ~TextureTable() {}
+};
+
 class IndexBuffer : public GfxIndexBuffer
 {
 public:
@@ -389,6 +420,12 @@ public:
 	wstring name;
 	D3D12_RESOURCE_DESC textureDesc;
 
+	// streaming textures only hold mips [FirstResidentMip, NumStreamingMips) of the file.
+	bool bStreaming = false;
+	bool bNonSRGB = false;
+	UINT NumStreamingMips = 0;
+	UINT FirstResidentMip = 0;
+
 	ComPtr<ID3D12Resource> resource;
 
 	Descriptor UAV;
@@ -396,7 +433,12 @@ public:
 	Descriptor DSV;
 	Descriptor SRV;
 
+	// first of NumMipUAVs contiguous per mip uavs in TextureDHRing.
+	Descriptor MipUAVs;
+	UINT NumMipUAVs = 0;
+
 	void MakeStaticSRV();
+	void MakeStaticMipUAVs(UINT NumDescriptors);
 	void MakeDSV();
 
 	void UploadSRCData3D(D3D12_SUBRESOURCE_DATA* SrcData);
@@ -473,6 +515,60 @@ public:
 	virtual ~ConstantBufferRingBuffer();
 };
 
+// psos kept in an ID3D12PipelineLibrary and its serialized form on disk, see PipelineCache.h. a pso is
+// stored under the hash of its description, shaders and root signature, a recompiled shader gets a new key.
+// the file is read on a worker thread from Start until the first pso needs it.
+class PSOLibrary
+{
+	ComPtr<ID3D12PipelineLibrary> Library;
+	std::vector<uint8_t> LibraryData;	// the library reads from it for its whole lifetime
+	PipelineCacheLoader Loader;
+	std::string Path;
+	uint64_t DeviceId = 0;
+	bool bLoaded = false;
+	bool bDirty = false;
+
+	void WaitLoaded();
+
+public:
+	UINT NumLoaded = 0;
+	UINT NumCreated = 0;
+
+	void Start(const std::string& InPath, uint64_t InDeviceId);
+	HRESULT CreateGraphicsPipelineState(UINT64 Key, const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ComPtr<ID3D12PipelineState>& OutPSO);
+	HRESULT CreateComputePipelineState(UINT64 Key, const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ComPtr<ID3D12PipelineState>& OutPSO);
+	// writes the file when a pso was added.
+	void Save();
+
+	static UINT64 GetKey(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& Desc, ID3DBlob* RootSignature);
+	static UINT64 GetKey(const D3D12_COMPUTE_PIPELINE_STATE_DESC& Desc, ID3DBlob* RootSignature);
+};
+
+// one root signature per canonical layout, see RootSignatureLayout.h. the serialized blob is kept for the
+// pso keys of PSOLibrary.
+class RootSignatureCache
+{
+public:
+	struct Entry
+	{
+		RootSignatureLayout Layout;
+		ComPtr<ID3D12RootSignature> RS;
+		ComPtr<ID3DBlob> Blob;
+	};
+
+	// the entry of an equal layout or a new one, nullptr when the root signature can't be created. Layout
+	// has to be canonicalized.
+	const Entry* FindOrCreate(const RootSignatureLayout& Layout);
+
+	UINT GetNumRootSignatures() const { return NumRootSignatures; }
+	UINT GetNumRequests() const { return NumRequests; }
+
+private:
+	std::unordered_map<UINT64, std::vector<std::unique_ptr<Entry>>> Entries;
+	UINT NumRootSignatures = 0;
+	UINT NumRequests = 0;
+};
+
 class RTAS : public GfxRTAS
 {
 public:
@@ -501,7 +597,15 @@ public:
 	unique_ptr<CommandQueue> CmdQSync;
 	CommandList* GlobalCmdList = nullptr;
 
-	vector<UINT32> FrameFenceValueVec;
+	// async compute, see AsyncCompute.h. while a compute pass records GlobalCmdList is its compute list and
+	// the graphics list waits in SuspendedCmdList.
+	unique_ptr<CommandQueue> CmdQAsync;
+	CommandList* SuspendedCmdList = nullptr;
+	UINT64 PreviousFrameFenceValue = 0;	// graphics fence value of the last frame's end
+
+	// frames in flight, see FramePacing.h. at most NumFrame, the per frame resources are sized for it.
+	FramePacer Pacer;
+	bool bFrameSlotReady = false;
 
 	std::unique_ptr<DescriptorHeap> RTVDescriptorHeap;
 	std::unique_ptr<DescriptorHeap> DSVDescriptorHeap;
@@ -517,10 +621,32 @@ public:
 
 	std::unique_ptr<DescriptorHeapRing> GlobalRTDHRing; // can be changed only when new texture is added or removed. it works like static at this moment.
 
+	PSOLibrary PipelineLibrary;
+	RootSignatureCache RootSignatures;
+
 
 	std::vector<std::shared_ptr<Texture>> renderTargetTextures;
 	std::list<Buffer*> DynamicBuffers;
 
+	struct RetiredStreamingTexture
+	{
+		ComPtr<ID3D12Resource> resource;
+		ComPtr<ID3D12Resource> uploadHeap;
+		Descriptor SRV;
+		UINT64 FenceValue;
+	};
+	std::list<RetiredStreamingTexture> RetiredStreamingTextures;
+	std::vector<Descriptor> FreeStreamingSRVs;
+
+	// timestamp pairs of the profiler's gpu zones, a range of the heap per frame in flight. the
+	// readback buffer mirrors the heap, query i at byte i * 8.
+	const UINT MaxGPUZonesPerFrame = 256;
+	GPUTimestampRing TimestampRing;
+	ComPtr<ID3D12QueryHeap> TimestampHeap;
+	ComPtr<ID3D12Resource> TimestampReadback;
+	UINT64 TimestampFrequency = 0;
+	vector<GPUZoneTiming> GPUZoneTimings; // the frame that retired last
+
 
 	bool m_windowedMode;
 
@@ -536,20 +662,50 @@ public:
 	ComPtr<IDXGIAdapter1> m_hardwareAdapter;
 
 public:
+	void WaitForFrameSlot();
 	void BeginFrame(std::list<Texture*>& DynamicTexture);
 	void EndFrame();
 
+	void BeginAsyncCompute();
+	void EndAsyncCompute();
+	// submits what the queue recorded so far and signals its fence, returns the signaled value.
+	UINT64 SignalQueue(GPUQueue Queue);
+	// Queue waits until the other queue's fence reaches FenceValue. the graphics list recorded so far is
+	// submitted first so it doesn't wait as well.
+	void WaitQueue(GPUQueue Queue, UINT64 FenceValue);
+	void OpenGlobalCommandList();
+	void FlushGlobalCommandList();
+
+	void InitTimestampQueries();
+	UINT BeginGPUZone(CommandList* CL, const char* Name);
+	void EndGPUZone(CommandList* CL, UINT Zone);
+	void ResolveGPUZones(CommandList* CL);
+	void ReadbackGPUZones();
+
+	UINT64 GetGPUMemoryUsage();
+
 	Texture* CreateTexture2D(DXGI_FORMAT format, D3D12_RESOURCE_FLAGS resFlags, D3D12_RESOURCE_STATES initResState, int width, int height, int mipLevels, std::optional<glm::vec4> clearColor = std::nullopt);
 	Texture* CreateTexture3D(DXGI_FORMAT format, D3D12_RESOURCE_FLAGS resFlags, D3D12_RESOURCE_STATES initResState, int width, int height, int depth, int mipLevels);
 	Texture* CreateTextureFromFile(wstring fileName, bool nonSRGB);
 	Texture* CreateTexture2DFromResource(ComPtr<ID3D12Resource> InResource); // used only by SimpleDX12
 
+	Texture* CreateStreamingTexture(wstring fileName, bool nonSRGB, Texture* placeholder, UINT& width, UINT& height, vector<UINT64>& mipBytes);
+	GfxTextureMipData* LoadStreamingTextureMips(Texture* tex, UINT FirstMip); // thread safe
+	bool UpdateStreamingTexture(Texture* tex, GfxTextureMipData* data, UINT FirstMip);
+	bool TrimStreamingTexture(Texture* tex, UINT FirstMip);
+	void AllocStreamingSRV(Descriptor& SRV);
+	void CreateStreamingSRV(Texture* tex);
+	void SwapStreamingTexture(Texture* tex, ComPtr<ID3D12Resource> resource, const D3D12_RESOURCE_DESC& textureDesc, UINT FirstMip, ComPtr<ID3D12Resource> uploadHeap);
+	void ReleaseRetiredStreamingTextures();
+
 	Sampler* CreateSampler(D3D12_SAMPLER_DESC& InSamplerDesc);
+	TextureTable* CreateTextureTable(UINT NumDescriptors);
 	Buffer* CreateBuffer(UINT InNumElements, UINT InElementSize, D3D12_HEAP_TYPE InType, D3D12_RESOURCE_STATES initResState, D3D12_RESOURCE_FLAGS InFlags, void* SrcData = nullptr);
 	IndexBuffer* CreateIndexBuffer(DXGI_FORMAT Format, UINT Size, void* SrcData);
 	VertexBuffer* CreateVertexBuffer(UINT Size, UINT Stride, void* SrcData);
 	
 	RTAS* CreateTLAS(vector<RTAS*>& VecBottomLevelAS);
+	RTAS* CreateTLAS(vector<RTAS*>& VecBottomLevelAS, const vector<GfxRTInstance>& Instances);
 	RTAS* CreateBLAS(GfxMesh* mesh);
 
 
@@ -83,6 +83,8 @@ void DXSample::ParseCommandLineArgs(WCHAR* argv[], int argc)
 {
 	for (int i = 1; i < argc; ++i)
 	{
+		m_commandLineArgs.push_back(argv[i]);
+
 		if (_wcsnicmp(argv[i], L"-warp", wcslen(argv[i])) == 0 || 
 			_wcsnicmp(argv[i], L"/warp", wcslen(argv[i])) == 0)
 		{
@@ -54,6 +54,9 @@ protected:
 	// Adapter info.
 	bool m_useWarpDevice;
 
+	// Every command line arg after the executable, for the sample's own options.
+	std::vector<std::wstring> m_commandLineArgs;
+
 private:
 	// Root assets path.
 	std::wstring m_assetsPath;
@@ -0,0 +1,142 @@
+#include "DrawQueue.h"
+
+#include <cstring>
+#include <utility>
+
+uint64_t MakeDrawSortKey(uint32_t Pass, uint32_t PSO, uint32_t Material, float Depth)
+{
+	uint32_t DepthBits = 0;
+	if (Depth > 0.f)
+		memcpy(&DepthBits, &Depth, sizeof(DepthBits));
+
+	return (uint64_t(Pass & ((1u << kSortKeyPassBits) - 1)) << kSortKeyPassShift)
+		| (uint64_t(PSO & ((1u << kSortKeyPSOBits) - 1)) << kSortKeyPSOShift)
+		| (uint64_t(Material & ((1u << kSortKeyMaterialBits) - 1)) << kSortKeyMaterialShift)
+		| (uint64_t(DepthBits) << kSortKeyDepthShift);
+}
+
+uint32_t GetSortKeyPass(uint64_t Key)
+{
+	return uint32_t(Key >> kSortKeyPassShift) & ((1u << kSortKeyPassBits) - 1);
+}
+
+uint32_t GetSortKeyPSO(uint64_t Key)
+{
+	return uint32_t(Key >> kSortKeyPSOShift) & ((1u << kSortKeyPSOBits) - 1);
+}
+
+uint32_t GetSortKeyMaterial(uint64_t Key)
+{
+	return uint32_t(Key >> kSortKeyMaterialShift) & ((1u << kSortKeyMaterialBits) - 1);
+}
+
+void RadixSortDrawKeys(std::vector<uint64_t>& Keys, std::vector<uint32_t>& Items,
+	std::vector<uint64_t>& ScratchKeys, std::vector<uint32_t>& ScratchItems)
+{
+	const size_t Count = Keys.size();
+	if (Count < 2)
+		return;
+
+	// all 8 histograms in one read of the keys.
+	uint32_t Histograms[8][256] = {};
+	for (size_t i = 0; i < Count; i++)
+	{
+		const uint64_t Key = Keys[i];
+		for (int Byte = 0; Byte < 8; Byte++)
+			Histograms[Byte][(Key >> (Byte * 8)) & 0xff]++;
+	}
+
+	ScratchKeys.resize(Count);
+	ScratchItems.resize(Count);
+
+	uint64_t* SrcKeys = Keys.data();
+	uint32_t* SrcItems = Items.data();
+	uint64_t* DstKeys = ScratchKeys.data();
+	uint32_t* DstItems = ScratchItems.data();
+
+	for (int Byte = 0; Byte < 8; Byte++)
+	{
+		uint32_t* Histogram = Histograms[Byte];
+
+		// every key has the same byte, the order doesn't change.
+		if (Histogram[(SrcKeys[0] >> (Byte * 8)) & 0xff] == Count)
+			continue;
+
+		uint32_t Offset = 0;
+		for (int Digit = 0; Digit < 256; Digit++)
+		{
+			const uint32_t DigitCount = Histogram[Digit];
+			Histogram[Digit] = Offset;
+			Offset += DigitCount;
+		}
+
+		for (size_t i = 0; i < Count; i++)
+		{
+			const uint32_t Dst = Histogram[(SrcKeys[i] >> (Byte * 8)) & 0xff]++;
+			DstKeys[Dst] = SrcKeys[i];
+			DstItems[Dst] = SrcItems[i];
+		}
+
+		std::swap(SrcKeys, DstKeys);
+		std::swap(SrcItems, DstItems);
+	}
+
+	// odd number of passes, the result is in the scratch arrays.
+	if (SrcKeys != Keys.data())
+	{
+		Keys.swap(ScratchKeys);
+		Items.swap(ScratchItems);
+	}
+}
+
+void DrawQueue::Clear()
+{
+	Keys.clear();
+	Items.clear();
+}
+
+void DrawQueue::Add(uint64_t Key, uint32_t Item)
+{
+	Keys.push_back(Key);
+	Items.push_back(Item);
+}
+
+void DrawQueue::Sort()
+{
+	RadixSortDrawKeys(Keys, Items, ScratchKeys, ScratchItems);
+}
+
+void RedundantBindFilter::Reset()
+{
+	PSO = nullptr;
+	Material = nullptr;
+	Geometry = nullptr;
+	Stats = DrawBindStats();
+}
+
+bool RedundantBindFilter::SetPSO(const void* InPSO)
+{
+	if (InPSO == PSO)
+		return false;
+	PSO = InPSO;
+	Stats.NumPSOBinds++;
+	return true;
+}
+
+bool RedundantBindFilter::SetMaterial(const void* InMaterial)
+{
+	if (InMaterial == Material)
+		return false;
+	Material = InMaterial;
+	Stats.NumMaterialBinds++;
+	return true;
+}
+
+bool RedundantBindFilter::SetGeometry(const void* InGeometry)
+{
+	if (InGeometry == Geometry)
+		return false;
+	Geometry = InGeometry;
+	Stats.NumGeometryBinds++;
+	return true;
+}
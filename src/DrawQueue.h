@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 64 bit draw sort key, most significant field first: pass, pso, material, depth. sorting the keys
+// groups the draws by state so consecutive draws can skip the binds they share.
+const uint32_t kSortKeyDepthBits = 32;
+const uint32_t kSortKeyMaterialBits = 16;
+const uint32_t kSortKeyPSOBits = 12;
+const uint32_t kSortKeyPassBits = 4;
+
+const uint32_t kSortKeyDepthShift = 0;
+const uint32_t kSortKeyMaterialShift = kSortKeyDepthShift + kSortKeyDepthBits;
+const uint32_t kSortKeyPSOShift = kSortKeyMaterialShift + kSortKeyMaterialBits;
+const uint32_t kSortKeyPassShift = kSortKeyPSOShift + kSortKeyPSOBits;
+
+static_assert(kSortKeyPassShift + kSortKeyPassBits == 64, "sort key fields have to fill 64 bits");
+
+enum DrawPass
+{
+	DRAW_PASS_OPAQUE = 0,
+	DRAW_PASS_ALPHA_TEST = 1,	// after the opaque draws so the discarding pixel shader runs behind a filled depth buffer
+};
+
+// Depth is the view distance, negative values clamp to 0. the bits of a non-negative float sort like
+// the float, so the draws of one material go front to back. fields wider than their bits are masked.
+uint64_t MakeDrawSortKey(uint32_t Pass, uint32_t PSO, uint32_t Material, float Depth);
+
+uint32_t GetSortKeyPass(uint64_t Key);
+uint32_t GetSortKeyPSO(uint64_t Key);
+uint32_t GetSortKeyMaterial(uint64_t Key);
+
+// sorts Keys ascending and moves Items along, stable. lsd radix sort over the 8 bytes of the key,
+// a byte that is the same in every key costs only the histogram pass. Scratch* are resized as needed.
+void RadixSortDrawKeys(std::vector<uint64_t>& Keys, std::vector<uint32_t>& Items,
+	std::vector<uint64_t>& ScratchKeys, std::vector<uint32_t>& ScratchItems);
+
+// the keys and caller defined items of one frame's draws.
+class DrawQueue
+{
+public:
+	void Clear();
+	void Add(uint64_t Key, uint32_t Item);
+	void Sort();
+
+	size_t Size() const { return Keys.size(); }
+	uint64_t GetKey(size_t i) const { return Keys[i]; }
+	uint32_t GetItem(size_t i) const { return Items[i]; }
+
+private:
+	std::vector<uint64_t> Keys;
+	std::vector<uint32_t> Items;
+	std::vector<uint64_t> ScratchKeys;
+	std::vector<uint32_t> ScratchItems;
+};
+
+struct DrawBindStats
+{
+	uint32_t NumDraws = 0;
+	uint32_t NumPSOBinds = 0;
+	uint32_t NumMaterialBinds = 0;
+	uint32_t NumGeometryBinds = 0;
+};
+
+// remembers the last bound state of a draw loop. each Set returns true when the state differs from the
+// previous one and has to be bound.
+class RedundantBindFilter
+{
+public:
+	void Reset();
+
+	bool SetPSO(const void* PSO);
+	bool SetMaterial(const void* Material);
+	bool SetGeometry(const void* Geometry);
+	void CountDraw() { Stats.NumDraws++; }
+
+	const DrawBindStats& GetStats() const { return Stats; }
+
+private:
+	const void* PSO = nullptr;
+	const void* Material = nullptr;
+	const void* Geometry = nullptr;
+	DrawBindStats Stats;
+};
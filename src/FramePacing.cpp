@@ -0,0 +1,64 @@
+#include "FramePacing.h"
+
+#include <algorithm>
+
+void FramePacer::Init(uint32_t InNumFrameSlots)
+{
+	NumFrameSlots = std::max(InNumFrameSlots, 1u);
+	MaxFramesInFlight = NumFrameSlots;
+	NextFrameNumber = 0;
+	Current = FrameRecord();
+	Pending.clear();
+	InputToPresent.Clear();
+	InputToRetire.Clear();
+	WaitTimes.Clear();
+}
+
+void FramePacer::SetMaxFramesInFlight(uint32_t Num)
+{
+	MaxFramesInFlight = std::min(std::max(Num, 1u), NumFrameSlots);
+}
+
+uint64_t FramePacer::GetWaitFenceValue() const
+{
+	// the new frame plus the pending ones may not exceed the limit, wait until only
+	// MaxFramesInFlight - 1 are left.
+	if (Pending.size() < MaxFramesInFlight)
+		return 0;
+	return Pending[Pending.size() - MaxFramesInFlight].FenceValue;
+}
+
+void FramePacer::BeginFrame(uint64_t NowNs, uint64_t WaitedNs)
+{
+	Current = FrameRecord();
+	Current.FrameNumber = NextFrameNumber++;
+	Current.BeginNs = NowNs;
+	WaitTimes.Add(WaitedNs * 1e-6);
+}
+
+void FramePacer::MarkInputSampled(uint64_t NowNs)
+{
+	Current.InputNs = NowNs;
+}
+
+void FramePacer::EndFrame(uint64_t FenceValue, uint64_t NowNs)
+{
+	// a frame that didn't report its input latched it at the begin.
+	if (Current.InputNs == 0)
+		Current.InputNs = Current.BeginNs;
+
+	Current.FenceValue = FenceValue;
+	Current.PresentNs = NowNs;
+	InputToPresent.Add((NowNs - Current.InputNs) * 1e-6);
+
+	Pending.push_back(Current);
+}
+
+void FramePacer::Retire(uint64_t CompletedFenceValue, uint64_t NowNs)
+{
+	while (!Pending.empty() && Pending.front().FenceValue <= CompletedFenceValue)
+	{
+		InputToRetire.Add((NowNs - Pending.front().InputNs) * 1e-6);
+		Pending.pop_front();
+	}
+}
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+
+#include "FrameTiming.h"
+
+// frames in flight and their latency. a frame starts its cpu work once the frame MaxFramesInFlight
+// before it retired on the gpu, so the cpu records at most MaxFramesInFlight - 1 frames ahead of the
+// gpu. fewer frames in flight trade cpu / gpu overlap for input latency. the gfx layer waits for
+// GetWaitFenceValue, then reports the frame's begin, its fence value at present and completed fences,
+// the app reports when it sampled input.
+class FramePacer
+{
+public:
+	struct FrameRecord
+	{
+		uint64_t FrameNumber = 0;
+		uint64_t FenceValue = 0;
+		uint64_t BeginNs = 0;
+		uint64_t InputNs = 0;
+		uint64_t PresentNs = 0;
+	};
+
+	// NumFrameSlots is how many frames the per frame resources hold, the most frames in flight.
+	void Init(uint32_t InNumFrameSlots);
+
+	// clamped to [1, NumFrameSlots]. takes effect with the next wait.
+	void SetMaxFramesInFlight(uint32_t Num);
+	uint32_t GetMaxFramesInFlight() const { return MaxFramesInFlight; }
+	uint32_t GetNumFrameSlots() const { return NumFrameSlots; }
+
+	// the fence value to wait for before the next frame begins, 0 when it can begin right away.
+	uint64_t GetWaitFenceValue() const;
+
+	// WaitedNs is how long the cpu blocked on GetWaitFenceValue.
+	void BeginFrame(uint64_t NowNs, uint64_t WaitedNs);
+	void MarkInputSampled(uint64_t NowNs);
+	// the frame was presented, its gpu work ends with FenceValue.
+	void EndFrame(uint64_t FenceValue, uint64_t NowNs);
+	// every frame up to CompletedFenceValue finished on the gpu, at NowNs or earlier. frames that were
+	// already done before the call count with NowNs, an upper bound.
+	void Retire(uint64_t CompletedFenceValue, uint64_t NowNs);
+
+	uint64_t GetFrameNumber() const { return Current.FrameNumber; }
+	uint32_t GetNumInFlight() const { return uint32_t(Pending.size()); }
+
+	// input sampled to present call, and to the gpu finishing the frame.
+	const FrameTimeHistory& GetInputToPresent() const { return InputToPresent; }
+	const FrameTimeHistory& GetInputToRetire() const { return InputToRetire; }
+	const FrameTimeHistory& GetWaitTimes() const { return WaitTimes; }
+
+private:
+	uint32_t NumFrameSlots = 1;
+	uint32_t MaxFramesInFlight = 1;
+	uint64_t NextFrameNumber = 0;
+
+	FrameRecord Current;
+	std::deque<FrameRecord> Pending;	// presented, not retired, in present order
+
+	FrameTimeHistory InputToPresent;
+	FrameTimeHistory InputToRetire;
+	FrameTimeHistory WaitTimes;
+};
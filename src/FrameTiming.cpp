@@ -0,0 +1,158 @@
+#include "FrameTiming.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define FRAME_TIMING_X86 1
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <x86intrin.h>
+#define FRAME_TIMING_X86 1
+#else
+#define FRAME_TIMING_X86 0
+#endif
+
+uint64_t SteadyClockNs()
+{
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+uint64_t ReadCycleCounter()
+{
+#if FRAME_TIMING_X86
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+bool HasInvariantCycleCounter()
+{
+#if FRAME_TIMING_X86
+	// cpuid 0x80000007, edx bit 8.
+	uint32_t Regs[4] = {};
+#if defined(_MSC_VER)
+	int Info[4];
+	__cpuid(Info, 0x80000000);
+	if (uint32_t(Info[0]) < 0x80000007)
+		return false;
+	__cpuid(Info, 0x80000007);
+	Regs[3] = uint32_t(Info[3]);
+#else
+	if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007)
+		return false;
+	__get_cpuid(0x80000007, &Regs[0], &Regs[1], &Regs[2], &Regs[3]);
+#endif
+	return (Regs[3] >> 8) & 1;
+#else
+	return false;
+#endif
+}
+
+namespace
+{
+	// one reading of both clocks. a context switch or a slow first clock call can split the pair, keep
+	// the tightest of a few tries.
+	void ReadClockPair(uint64_t& OutCycles, uint64_t& OutNs)
+	{
+		uint64_t Window = ~0ull;
+		for (int i = 0; i < 4; i++)
+		{
+			const uint64_t Before = ReadCycleCounter();
+			const uint64_t Now = SteadyClockNs();
+			const uint64_t After = ReadCycleCounter();
+			if (After - Before < Window)
+			{
+				Window = After - Before;
+				OutCycles = Before + (After - Before) / 2;
+				OutNs = Now;
+			}
+		}
+	}
+}
+
+void CycleClock::Init(uint64_t InMinCalibrationNs)
+{
+	bAvailable = HasInvariantCycleCounter();
+	bCalibrated = false;
+	MinCalibrationNs = InMinCalibrationNs;
+	ReadClockPair(BaseCycles, BaseNs);
+	NsPerCycle = 0.0;
+}
+
+void CycleClock::Calibrate()
+{
+	if (!bAvailable)
+		return;
+
+	uint64_t Cycles = 0, Ns = 0;
+	ReadClockPair(Cycles, Ns);
+
+	if (Ns - BaseNs < MinCalibrationNs || Cycles <= BaseCycles)
+		return;
+
+	NsPerCycle = double(Ns - BaseNs) / double(Cycles - BaseCycles);
+	bCalibrated = true;
+}
+
+uint64_t CycleClock::NowNs() const
+{
+	if (!bCalibrated)
+		return SteadyClockNs();
+	return BaseNs + uint64_t(double(ReadCycleCounter() - BaseCycles) * NsPerCycle);
+}
+
+TimingStats ComputeTimingStats(std::vector<double>& Samples)
+{
+	TimingStats Stats;
+	Stats.NumSamples = uint32_t(Samples.size());
+	if (Samples.empty())
+		return Stats;
+
+	std::sort(Samples.begin(), Samples.end());
+
+	double Sum = 0.0;
+	for (double Ms : Samples)
+		Sum += Ms;
+
+	auto Percentile = [&](double P)
+	{
+		const size_t Rank = size_t(std::ceil(P * Samples.size()));
+		return Samples[std::min(std::max(Rank, size_t(1)), Samples.size()) - 1];
+	};
+
+	Stats.AvgMs = Sum / Samples.size();
+	Stats.MinMs = Samples.front();
+	Stats.P50Ms = Percentile(0.5);
+	Stats.P95Ms = Percentile(0.95);
+	Stats.P99Ms = Percentile(0.99);
+	Stats.MaxMs = Samples.back();
+	return Stats;
+}
+
+FrameTimeHistory::FrameTimeHistory(uint32_t Window)
+	: Samples(std::max(Window, 1u), 0.0)
+{
+}
+
+void FrameTimeHistory::Add(double Ms)
+{
+	Samples[Next] = Ms;
+	Next = (Next + 1) % uint32_t(Samples.size());
+	Count = std::min(Count + 1, uint32_t(Samples.size()));
+}
+
+void FrameTimeHistory::Clear()
+{
+	Next = 0;
+	Count = 0;
+}
+
+TimingStats FrameTimeHistory::GetStats() const
+{
+	Scratch.assign(Samples.begin(), Samples.begin() + Count);
+	return ComputeTimingStats(Scratch);
+}
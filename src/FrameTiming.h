@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// portable timing. SteadyClockNs is the reference clock, std::chrono::steady_clock is qpc on windows and
+// clock_gettime(CLOCK_MONOTONIC) on linux. CycleClock reads the cpu's time stamp counter, cheaper than
+// both, and maps it onto the reference clock with a calibration that refines itself over time.
+
+uint64_t SteadyClockNs();
+
+// the time stamp counter, 0 on cpus without one.
+uint64_t ReadCycleCounter();
+// the counter runs at a constant rate across power states and cores, required by CycleClock.
+bool HasInvariantCycleCounter();
+
+// not thread safe, calibrate and read on the same thread or between frames.
+class CycleClock
+{
+public:
+	// reads use the reference clock until MinCalibrationNs passed since Init, or for good when the cpu
+	// has no invariant counter.
+	void Init(uint64_t InMinCalibrationNs = 10000000);
+
+	// refines the rate with the reference time since Init, the error shrinks as that span grows. call
+	// it now and then, once a frame is plenty.
+	void Calibrate();
+
+	uint64_t NowNs() const;
+
+	bool IsCalibrated() const { return bCalibrated; }
+	double GetCyclesPerSecond() const { return bCalibrated ? 1e9 / NsPerCycle : 0.0; }
+
+private:
+	bool bAvailable = false;
+	bool bCalibrated = false;
+	uint64_t MinCalibrationNs = 0;
+	uint64_t BaseCycles = 0;
+	uint64_t BaseNs = 0;
+	double NsPerCycle = 0.0;
+};
+
+struct TimingStats
+{
+	uint32_t NumSamples = 0;
+	double AvgMs = 0.0;
+	double MinMs = 0.0;
+	double P50Ms = 0.0;
+	double P95Ms = 0.0;
+	double P99Ms = 0.0;
+	double MaxMs = 0.0;
+};
+
+// nearest rank percentiles. sorts Samples.
+TimingStats ComputeTimingStats(std::vector<double>& Samples);
+
+// the last Window frame times.
+class FrameTimeHistory
+{
+public:
+	explicit FrameTimeHistory(uint32_t Window = 240);
+
+	void Add(double Ms);
+	void Clear();
+
+	uint32_t GetNumSamples() const { return Count; }
+	double GetLastMs() const { return Count ? Samples[(Next + Samples.size() - 1) % Samples.size()] : 0.0; }
+	TimingStats GetStats() const;
+
+private:
+	std::vector<double> Samples;
+	uint32_t Next = 0;
+	uint32_t Count = 0;
+	mutable std::vector<double> Scratch;
+};
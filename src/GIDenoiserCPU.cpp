@@ -0,0 +1,619 @@
+#include "GIDenoiserCPU.h"
+
+#include <cmath>
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <emmintrin.h>
+
+#include "glm/gtc/packing.hpp"
+#include "enkiTS/TaskScheduler.h"
+
+// DOWNSAMPLE_SIZE in Common.hlsl
+static const int32_t kDownsampleSize = 3;
+// numthreads of the gpu passes, used to reproduce the dispatch coverage.
+static const uint32_t kSpatialGroupSize = 32;
+static const uint32_t kTemporalGroupSize = 15;
+
+static const float kWaveletKernel[2][2] = {
+	{ 1.0f, 0.5f },
+	{ 0.5f, 0.25f }
+};
+
+static const uint32_t kPoissonSampleNum = 16;
+static const glm::vec2 kPoissonSamples[kPoissonSampleNum] =
+{
+	glm::vec2(0.25846023600949697f, -0.07369550760351032f),
+	glm::vec2(-0.9838570552784007f, -0.05779516564478064f),
+	glm::vec2(-0.027743258156343067f, 0.9811291888930508f),
+	glm::vec2(-0.27749280859153147f, -0.9558763050496616f),
+	glm::vec2(0.7957500833563568f, 0.601381663828957f),
+	glm::vec2(0.610845296785476f, -0.7463029770721497f),
+	glm::vec2(-0.6784295880309313f, 0.660255493042322f),
+	glm::vec2(0.964729322668074f, -0.061480119938628806f),
+	glm::vec2(-0.44963058033639447f, -0.357675895070531f),
+	glm::vec2(-0.313556193156912f, 0.2145219816729168f),
+	glm::vec2(0.2859315712886788f, 0.43424956054318387f),
+	glm::vec2(-0.04534300033675266f, -0.5334074339145939f),
+	glm::vec2(-0.6541908929580176f, -0.7536055504687329f),
+	glm::vec2(0.18809498350573928f, -0.9128177827906239f),
+	glm::vec2(0.60895935404913f, 0.15435512892534362f),
+	glm::vec2(0.43638971738806215f, 0.8146738166643487f),
+};
+
+static const uint32_t kBayerSampleNum = 16;
+static const float kBayerSamples[kBayerSampleNum] =
+{
+	0, 8, 2, 10,
+	12, 4, 14, 6,
+	3, 11, 1, 9,
+	15, 7, 13, 5
+};
+
+void DenoiserImage::Init(uint32_t InWidth, uint32_t InHeight, bool bInHalf)
+{
+	Width = InWidth;
+	Height = InHeight;
+	bHalf = bInHalf;
+	Texels.assign(size_t(Width) * Height, glm::vec4(0.f));
+}
+
+void DenoiserImage::Store(uint32_t x, uint32_t y, const glm::vec4& Value)
+{
+	if (x >= Width || y >= Height)
+		return;
+	Texels[size_t(y) * Width + x] = bHalf ? glm::unpackHalf4x16(glm::packHalf4x16(Value)) : Value;
+}
+
+struct DenoiserTaskSet : enki::ITaskSet
+{
+	const std::function<void(uint32_t, uint32_t)>* Func = nullptr;
+
+	virtual void ExecuteRange(enki::TaskSetPartition range, uint32_t)
+	{
+		(*Func)(range.start, range.end);
+	}
+};
+
+void ParallelForRows(enki::TaskScheduler* TS, uint32_t NumRows, const std::function<void(uint32_t, uint32_t)>& Func)
+{
+	if (!TS || NumRows < 2)
+	{
+		Func(0, NumRows);
+		return;
+	}
+
+	DenoiserTaskSet Task;
+	Task.m_SetSize = NumRows;
+	Task.m_MinRange = 4;
+	Task.Func = &Func;
+
+	TS->AddTaskSetToPipe(&Task);
+	TS->WaitforTask(&Task);
+}
+
+static void MatchSize(DenoiserImage& Img, uint32_t Width, uint32_t Height)
+{
+	if (Img.Width != Width || Img.Height != Height)
+		Img.Init(Width, Height, Img.bHalf);
+}
+
+static inline __m128 LoadV(const glm::vec4& V)
+{
+	return _mm_loadu_ps(&V.x);
+}
+
+static inline glm::vec4 StoreV(__m128 V)
+{
+	glm::vec4 Result;
+	_mm_storeu_ps(&Result.x, V);
+	return Result;
+}
+
+static inline __m128 MaxZero(__m128 V)
+{
+	return _mm_max_ps(V, _mm_setzero_ps());
+}
+
+// hlsl pow is exp2(y * log2(x)), which is what makes pow(0, y) == 0.
+static inline float HlslPow(float x, float y)
+{
+	return std::exp2(y * std::log2(x));
+}
+
+// float to uint conversion of the shaders. negative coordinates saturate to 0 on the hardware.
+static inline int32_t ToTexelCoord(float x)
+{
+	return x <= 0.f ? 0 : int32_t(x);
+}
+
+static inline float GetLinearDepthOpenGL(float DeviceDepth, float Near, float Far)
+{
+	return Near * Far / (Far + Near - DeviceDepth * (Far - Near));
+}
+
+static inline float Dot3(const glm::vec4& A, const glm::vec4& B)
+{
+	return A.x * B.x + A.y * B.y + A.z * B.z;
+}
+
+// std::floor is a libm call without sse4.1. the same result for the texel coordinates of the passes,
+// which stay far below 2^31.
+static inline float FloorFast(float x)
+{
+	const float t = float(int32_t(x));
+	return t > x ? t - 1.f : t;
+}
+
+static inline int32_t WrapCoord(float x, uint32_t Size)
+{
+	if (x >= 0.f && x < float(Size))
+		return int32_t(x);
+
+	float s = float(Size);
+	float w = x - s * std::floor(x / s);
+	return std::min(int32_t(w), int32_t(Size) - 1);
+}
+
+// the 4 texels and weights of a bilinear wrap sample, shared by the images of one size.
+struct BilinearFootprint
+{
+	size_t Index[4];
+	__m128 AX;
+	__m128 AY;
+};
+
+static inline BilinearFootprint GetBilinearFootprintWrap(uint32_t Width, uint32_t Height, glm::vec2 UV)
+{
+	float fx = UV.x * Width - 0.5f;
+	float fy = UV.y * Height - 0.5f;
+	float x0f = FloorFast(fx);
+	float y0f = FloorFast(fy);
+
+	int32_t x0 = WrapCoord(x0f, Width);
+	int32_t x1 = WrapCoord(x0f + 1.f, Width);
+	int32_t y0 = WrapCoord(y0f, Height);
+	int32_t y1 = WrapCoord(y0f + 1.f, Height);
+
+	BilinearFootprint Footprint;
+	Footprint.Index[0] = size_t(y0) * Width + x0;
+	Footprint.Index[1] = size_t(y0) * Width + x1;
+	Footprint.Index[2] = size_t(y1) * Width + x0;
+	Footprint.Index[3] = size_t(y1) * Width + x1;
+	Footprint.AX = _mm_set1_ps(fx - x0f);
+	Footprint.AY = _mm_set1_ps(fy - y0f);
+	return Footprint;
+}
+
+static inline __m128 SampleFootprint(const DenoiserImage& Img, const BilinearFootprint& Footprint)
+{
+	__m128 T00 = LoadV(Img.Texels[Footprint.Index[0]]);
+	__m128 T10 = LoadV(Img.Texels[Footprint.Index[1]]);
+	__m128 T01 = LoadV(Img.Texels[Footprint.Index[2]]);
+	__m128 T11 = LoadV(Img.Texels[Footprint.Index[3]]);
+
+	__m128 Top = _mm_add_ps(T00, _mm_mul_ps(_mm_sub_ps(T10, T00), Footprint.AX));
+	__m128 Bottom = _mm_add_ps(T01, _mm_mul_ps(_mm_sub_ps(T11, T01), Footprint.AX));
+	return _mm_add_ps(Top, _mm_mul_ps(_mm_sub_ps(Bottom, Top), Footprint.AY));
+}
+
+glm::vec4 SampleBilinearWrap(const DenoiserImage& Img, glm::vec2 UV)
+{
+	return StoreV(SampleFootprint(Img, GetBilinearFootprintWrap(Img.Width, Img.Height, UV)));
+}
+
+// GetBilinearFootprintWrap for the uvs in the 4 lanes of U and V, the weights stay in lanes.
+struct BilinearFootprint4
+{
+	size_t Index[4][4];
+	__m128 AX;
+	__m128 AY;
+};
+
+static inline void GetBilinearFootprintsWrap(uint32_t Width, uint32_t Height, __m128 U, __m128 V, BilinearFootprint4& Out)
+{
+	const __m128 Half = _mm_set1_ps(0.5f);
+	const __m128 One = _mm_set1_ps(1.f);
+	const __m128 fx = _mm_sub_ps(_mm_mul_ps(U, _mm_set1_ps(float(Width))), Half);
+	const __m128 fy = _mm_sub_ps(_mm_mul_ps(V, _mm_set1_ps(float(Height))), Half);
+
+	// FloorFast in every lane.
+	const __m128 tx = _mm_cvtepi32_ps(_mm_cvttps_epi32(fx));
+	const __m128 ty = _mm_cvtepi32_ps(_mm_cvttps_epi32(fy));
+	const __m128 x0f = _mm_sub_ps(tx, _mm_and_ps(_mm_cmpgt_ps(tx, fx), One));
+	const __m128 y0f = _mm_sub_ps(ty, _mm_and_ps(_mm_cmpgt_ps(ty, fy), One));
+	Out.AX = _mm_sub_ps(fx, x0f);
+	Out.AY = _mm_sub_ps(fy, y0f);
+
+	float X0[4], Y0[4];
+	_mm_storeu_ps(X0, x0f);
+	_mm_storeu_ps(Y0, y0f);
+	for (int i = 0; i < 4; i++)
+	{
+		const size_t x0 = size_t(WrapCoord(X0[i], Width));
+		const size_t x1 = size_t(WrapCoord(X0[i] + 1.f, Width));
+		const size_t y0 = size_t(WrapCoord(Y0[i], Height)) * Width;
+		const size_t y1 = size_t(WrapCoord(Y0[i] + 1.f, Height)) * Width;
+		Out.Index[i][0] = y0 + x0;
+		Out.Index[i][1] = y0 + x1;
+		Out.Index[i][2] = y1 + x0;
+		Out.Index[i][3] = y1 + x1;
+	}
+}
+
+// the x of 4 bilinear samples of Img, one per lane.
+static inline __m128 SampleFootprintsX(const DenoiserImage& Img, const BilinearFootprint4& Footprints)
+{
+	const glm::vec4* T = Img.Texels.data();
+	const size_t (*I)[4] = Footprints.Index;
+	__m128 T00 = _mm_setr_ps(T[I[0][0]].x, T[I[1][0]].x, T[I[2][0]].x, T[I[3][0]].x);
+	__m128 T10 = _mm_setr_ps(T[I[0][1]].x, T[I[1][1]].x, T[I[2][1]].x, T[I[3][1]].x);
+	__m128 T01 = _mm_setr_ps(T[I[0][2]].x, T[I[1][2]].x, T[I[2][2]].x, T[I[3][2]].x);
+	__m128 T11 = _mm_setr_ps(T[I[0][3]].x, T[I[1][3]].x, T[I[2][3]].x, T[I[3][3]].x);
+
+	__m128 Top = _mm_add_ps(T00, _mm_mul_ps(_mm_sub_ps(T10, T00), Footprints.AX));
+	__m128 Bottom = _mm_add_ps(T01, _mm_mul_ps(_mm_sub_ps(T11, T01), Footprints.AX));
+	return _mm_add_ps(Top, _mm_mul_ps(_mm_sub_ps(Bottom, Top), Footprints.AY));
+}
+
+static void DeFlickerRow(const DenoiserImage& InSH, const DenoiserImage& InCoCg,
+	DenoiserImage& OutSH, DenoiserImage& OutCoCg, int32_t y, int32_t CoverX)
+{
+	const float NumPixels = 8.f;
+
+	for (int32_t x = 0; x < CoverX; x++)
+	{
+		glm::vec4 CenterSH = InSH.Load(x, y);
+		glm::vec4 CenterCoCg = InCoCg.Load(x, y);
+
+		float SumLum = 0.f;
+		for (int32_t yy = -1; yy <= 1; yy++)
+		{
+			for (int32_t xx = -1; xx <= 1; xx++)
+			{
+				if (xx == 0 && yy == 0)
+					continue;
+				SumLum += InSH.Load(ToTexelCoord(float(x + xx)), ToTexelCoord(float(y + yy))).w;
+			}
+		}
+
+		float MaxLum = SumLum * 1.0f / NumPixels;
+		if (CenterSH.w > MaxLum)
+		{
+			float Ratio = MaxLum / CenterSH.w;
+			CenterSH *= Ratio;
+			CenterCoCg *= Ratio;
+		}
+
+		OutSH.Store(x, y, CenterSH);
+		OutCoCg.Store(x, y, glm::vec4(CenterCoCg.x, CenterCoCg.y, 0, 0));
+	}
+}
+
+static void WaveletFilterRow(const SpatialFilterConstant& CB, const DenoiserImage& Depth, const DenoiserImage& GeoNormal,
+	const DenoiserImage& InSH, const DenoiserImage& InCoCg, DenoiserImage& OutSH, DenoiserImage& OutCoCg, int32_t y, int32_t CoverX)
+{
+	const float Near = CB.ProjectionParams.z;
+	const float Far = CB.ProjectionParams.w;
+	const int32_t StepSize = int32_t(1u << (CB.Iteration - 1));
+	const float InvDepthScale = 1.f / float(StepSize * kDownsampleSize);
+
+	for (int32_t x = 0; x < CoverX; x++)
+	{
+		int32_t CenterHiResX = x * kDownsampleSize + 1;
+		int32_t CenterHiResY = y * kDownsampleSize + 1;
+
+		float CenterZ = GetLinearDepthOpenGL(Depth.Load(CenterHiResX, CenterHiResY).x, Near, Far);
+		glm::vec4 CenterNormal = GeoNormal.Load(CenterHiResX, CenterHiResY);
+
+		float SumW = 1.0f;
+		__m128 SumSH = LoadV(InSH.Load(x, y));
+		__m128 SumCoCg = LoadV(InCoCg.Load(x, y));
+
+		for (int32_t yy = -1; yy <= 1; yy++)
+		{
+			for (int32_t xx = -1; xx <= 1; xx++)
+			{
+				if (xx == 0 && yy == 0)
+					continue;
+
+				int32_t SampleX = ToTexelCoord(float(x + xx * StepSize));
+				int32_t SampleY = ToTexelCoord(float(y + yy * StepSize));
+				int32_t SampleHiResX = SampleX * kDownsampleSize + 1;
+				int32_t SampleHiResY = SampleY * kDownsampleSize + 1;
+
+				float SampleZ = GetLinearDepthOpenGL(Depth.Load(SampleHiResX, SampleHiResY).x, Near, Far);
+				float DistZ = std::abs(CenterZ - SampleZ) * CB.IndirectDiffuseWeightFactorDepth;
+
+				float W = std::exp(-DistZ * InvDepthScale);
+				W *= kWaveletKernel[std::abs(xx)][std::abs(yy)];
+
+				float GNdotGN = std::max(0.f, Dot3(CenterNormal, GeoNormal.Load(SampleHiResX, SampleHiResY)));
+				W *= HlslPow(GNdotGN, CB.IndirectDiffuseWeightFactorNormal);
+
+				SumW += W;
+
+				__m128 WV = _mm_set1_ps(W);
+				SumSH = _mm_add_ps(SumSH, _mm_mul_ps(LoadV(InSH.Load(SampleX, SampleY)), WV));
+				SumCoCg = _mm_add_ps(SumCoCg, _mm_mul_ps(LoadV(InCoCg.Load(SampleX, SampleY)), WV));
+			}
+		}
+
+		__m128 InvW = _mm_set1_ps(1.f / SumW);
+		glm::vec4 ResultCoCg = StoreV(_mm_mul_ps(SumCoCg, InvW));
+
+		OutSH.Store(x, y, StoreV(_mm_mul_ps(SumSH, InvW)));
+		OutCoCg.Store(x, y, glm::vec4(ResultCoCg.x, ResultCoCg.y, 0, 0));
+	}
+}
+
+void SpatialFilterCPU(const SpatialFilterConstant& CB, const DenoiserImage& Depth, const DenoiserImage& GeoNormal,
+	const DenoiserImage& InSH, const DenoiserImage& InCoCg, DenoiserImage& OutSH, DenoiserImage& OutCoCg, enki::TaskScheduler* TS)
+{
+	MatchSize(OutSH, InSH.Width, InSH.Height);
+	MatchSize(OutCoCg, InSH.Width, InSH.Height);
+
+	// Dispatch(WidthGI / 32, HeightGI / 32 + 1) leaves the last partial group column unwritten.
+	const int32_t CoverX = int32_t(InSH.Width / kSpatialGroupSize * kSpatialGroupSize);
+
+	ParallelForRows(TS, InSH.Height, [&](uint32_t Start, uint32_t End)
+	{
+		for (uint32_t y = Start; y < End; y++)
+		{
+			if (CB.Iteration == 0)
+				DeFlickerRow(InSH, InCoCg, OutSH, OutCoCg, int32_t(y), CoverX);
+			else
+				WaveletFilterRow(CB, Depth, GeoNormal, InSH, InCoCg, OutSH, OutCoCg, int32_t(y), CoverX);
+		}
+	});
+}
+
+void SpatialDenoiseCPU(SpatialFilterConstant CB, const DenoiserImage& Depth, const DenoiserImage& GeoNormal,
+	DenoiserImage SH[2], DenoiserImage CoCg[2], enki::TaskScheduler* TS)
+{
+	uint32_t WriteIndex = 0;
+	uint32_t ReadIndex = 1;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		WriteIndex = 1 - WriteIndex;
+		ReadIndex = 1 - WriteIndex;
+
+		CB.Iteration = i;
+		SpatialFilterCPU(CB, Depth, GeoNormal, SH[ReadIndex], CoCg[ReadIndex], SH[WriteIndex], CoCg[WriteIndex], TS);
+	}
+}
+
+void TemporalFilterCPU(const TemporalFilterConstant& CB, const TemporalFilterInputs& In, TemporalFilterOutputs& Out, enki::TaskScheduler* TS)
+{
+	const uint32_t Width = In.Depth->Width;
+	const uint32_t Height = In.Depth->Height;
+
+	MatchSize(*Out.SH, Width, Height);
+	MatchSize(*Out.CoCg, Width, Height);
+	MatchSize(*Out.Specular, Width, Height);
+	MatchSize(*Out.SHDS, Width / kDownsampleSize, Height / kDownsampleSize);
+	MatchSize(*Out.CoCgDS, Width / kDownsampleSize, Height / kDownsampleSize);
+
+	// Dispatch(RenderWidth / 15, RenderHeight / 15)
+	const uint32_t CoverX = Width / kTemporalGroupSize * kTemporalGroupSize;
+	const uint32_t CoverY = Height / kTemporalGroupSize * kTemporalGroupSize;
+	const uint32_t NumLowResRows = CoverY / kDownsampleSize;
+
+	const float Near = CB.ProjectionParams.z;
+	const float Far = CB.ProjectionParams.w;
+
+	// the shader rotates by a hardcoded 0.1, not BayerRotScale.
+	const float RotAngle = kBayerSamples[CB.FrameIndex % kBayerSampleNum] * 0.1f;
+	// x and y apart, the blur loads 4 samples at a time.
+	float RotatedSamplesX[kPoissonSampleNum];
+	float RotatedSamplesY[kPoissonSampleNum];
+	for (uint32_t i = 0; i < kPoissonSampleNum; i++)
+	{
+		const glm::vec2& Offset = kPoissonSamples[i];
+		RotatedSamplesX[i] = Offset.x * std::cos(RotAngle) - Offset.y * std::sin(RotAngle);
+		RotatedSamplesY[i] = Offset.x * std::sin(RotAngle) + Offset.y * std::cos(RotAngle);
+	}
+
+	// the blur reads specular and depth at the same uvs, one footprint for both.
+	const bool bSpecularMatchesDepth = In.Specular->Width == Width && In.Specular->Height == Height;
+
+	const __m128 RTSizeX = _mm_set1_ps(CB.RTSize.x);
+	const __m128 RTSizeY = _mm_set1_ps(CB.RTSize.y);
+	const __m128 NearFar = _mm_set1_ps(Near * Far);
+	const __m128 FarPlusNear = _mm_set1_ps(Far + Near);
+	const __m128 FarMinusNear = _mm_set1_ps(Far - Near);
+
+	const glm::vec2 Off[4] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+	const float W = 0.05f;
+	const __m128 CurW = _mm_set1_ps(W);
+	const __m128 PrevW = _mm_set1_ps(1 - W);
+
+	// every low res row only reads the 3 full res rows it covers, so a row band is the cpu
+	// counterpart of the groupshared tile.
+	ParallelForRows(TS, NumLowResRows, [&](uint32_t Start, uint32_t End)
+	{
+		std::vector<glm::vec4> BandSH(size_t(kDownsampleSize) * CoverX);
+		std::vector<glm::vec4> BandCoCg(size_t(kDownsampleSize) * CoverX);
+
+		for (uint32_t LowResY = Start; LowResY < End; LowResY++)
+		{
+			for (int32_t Row = 0; Row < kDownsampleSize; Row++)
+			{
+				const int32_t y = int32_t(LowResY) * kDownsampleSize + Row;
+
+				for (int32_t x = 0; x < int32_t(CoverX); x++)
+				{
+					const glm::vec2 PixelPos = glm::vec2(float(x), float(y));
+
+					glm::vec4 CurNormal = In.Normal->Load(x, y);
+					float CurDepth = In.Depth->Load(x, y).x;
+
+					glm::vec4 Velocity = In.Velocity->Load(x, y);
+					glm::vec2 PrevPos = PixelPos - glm::vec2(Velocity.x, Velocity.y) * CB.RTSize;
+					glm::vec2 PrevUV = (PrevPos + 0.5f) / CB.RTSize;
+
+					glm::vec4 PrevSpecular = SampleBilinearWrap(*In.PrevSpecular, PrevUV);
+					__m128 CurrentSpecular = LoadV(In.Specular->Load(x, y));
+
+					float Roughness = In.RoughnessMetallic->Load(x, y).x;
+					float CZ = GetLinearDepthOpenGL(CurDepth, Near, Far);
+
+					// to reduce ghosting
+					if (PrevSpecular.w < 0.5f)
+						PrevSpecular = glm::vec4(0, 0, 0, PrevSpecular.w);
+
+					// 4 poisson samples at a time: the footprints and depths in sse lanes, the specular sum in
+					// sample order.
+					const __m128 BlurRadius = _mm_set1_ps(CB.SpecularBlurRadius * Roughness);
+					const __m128 CenterX = _mm_set1_ps(PixelPos.x + 0.5f);
+					const __m128 CenterY = _mm_set1_ps(PixelPos.y + 0.5f);
+					float SumWSpec = 1;
+					for (uint32_t i = 0; i < kPoissonSampleNum; i += 4)
+					{
+						const __m128 U = _mm_div_ps(_mm_add_ps(CenterX, _mm_mul_ps(_mm_loadu_ps(&RotatedSamplesX[i]), BlurRadius)), RTSizeX);
+						const __m128 V = _mm_div_ps(_mm_add_ps(CenterY, _mm_mul_ps(_mm_loadu_ps(&RotatedSamplesY[i]), BlurRadius)), RTSizeY);
+
+						BilinearFootprint4 Footprints;
+						GetBilinearFootprintsWrap(In.Specular->Width, In.Specular->Height, U, V, Footprints);
+						__m128 SampleZ;
+						if (bSpecularMatchesDepth)
+						{
+							SampleZ = SampleFootprintsX(*In.Depth, Footprints);
+						}
+						else
+						{
+							BilinearFootprint4 DepthFootprints;
+							GetBilinearFootprintsWrap(Width, Height, U, V, DepthFootprints);
+							SampleZ = SampleFootprintsX(*In.Depth, DepthFootprints);
+						}
+						SampleZ = _mm_div_ps(NearFar, _mm_sub_ps(FarPlusNear, _mm_mul_ps(SampleZ, FarMinusNear)));
+
+						float Z[4], AX[4], AY[4];
+						_mm_storeu_ps(Z, SampleZ);
+						_mm_storeu_ps(AX, Footprints.AX);
+						_mm_storeu_ps(AY, Footprints.AY);
+						for (int Lane = 0; Lane < 4; Lane++)
+						{
+							BilinearFootprint Footprint;
+							memcpy(Footprint.Index, Footprints.Index[Lane], sizeof(Footprint.Index));
+							Footprint.AX = _mm_set1_ps(AX[Lane]);
+							Footprint.AY = _mm_set1_ps(AY[Lane]);
+							__m128 SampleSpecular = SampleFootprint(*In.Specular, Footprint);
+							float SampleW = std::exp(-std::abs(Z[Lane] - CZ) * 0.2f);
+
+							CurrentSpecular = _mm_add_ps(CurrentSpecular, _mm_mul_ps(SampleSpecular, _mm_set1_ps(SampleW)));
+							SumWSpec += SampleW;
+						}
+					}
+					CurrentSpecular = _mm_div_ps(CurrentSpecular, _mm_set1_ps(SumWSpec));
+
+					__m128 CurrentSH = LoadV(In.SH->Load(x, y));
+					__m128 CurrentCoCg = LoadV(In.CoCg->Load(x, y));
+
+					int32_t PrevX = ToTexelCoord(PrevPos.x);
+					int32_t PrevY = ToTexelCoord(PrevPos.y);
+					__m128 PrevSH = LoadV(In.PrevSH->Load(PrevX, PrevY));
+					__m128 PrevCoCg = LoadV(In.PrevCoCg->Load(PrevX, PrevY));
+
+					// bilinear footprint of the history has to match depth and normal.
+					glm::vec2 PosLD = glm::floor(PrevPos - 0.5f);
+					glm::vec2 Subpix = glm::fract(PrevPos - 0.5f - PosLD);
+					float BilinearW[4] = {
+						(1.0f - Subpix.x) * (1.0f - Subpix.y),
+						(Subpix.x) * (1.0f - Subpix.y),
+						(1.0f - Subpix.x) * (Subpix.y),
+						(Subpix.x) * (Subpix.y)
+					};
+
+					float TemporalSumW = 0.f;
+					for (uint32_t i = 0; i < 4; i++)
+					{
+						glm::vec2 p = PosLD + Off[i];
+						if (p.x < 0 || p.x >= CB.RTSize.x || p.y < 0 || p.y >= CB.RTSize.y)
+							continue;
+
+						float PrevDepth = In.PrevDepth->Load(int32_t(p.x), int32_t(p.y)).x;
+						glm::vec4 PrevNormal = In.PrevNormal->Load(int32_t(p.x), int32_t(p.y));
+
+						float DistDepth = std::abs(CurDepth - PrevDepth);
+						float DotNormals = std::abs(Dot3(CurNormal, PrevNormal));
+						if (DistDepth < 0.001f && DotNormals > 0.5f)
+							TemporalSumW += BilinearW[i] * HlslPow(std::max(DotNormals, 0.f), CB.TemporalValidParams.x);
+					}
+
+					bool bValidHistory = TemporalSumW > 0.000001f;
+
+					glm::vec4 BlendedSH;
+					glm::vec4 BlendedCoCg;
+					glm::vec4 BlendedSpecular;
+					if (bValidHistory)
+					{
+						BlendedSH = StoreV(MaxZero(_mm_add_ps(_mm_mul_ps(CurrentSH, CurW), _mm_mul_ps(PrevSH, PrevW))));
+						BlendedCoCg = StoreV(MaxZero(_mm_add_ps(_mm_mul_ps(CurrentCoCg, CurW), _mm_mul_ps(PrevCoCg, PrevW))));
+						BlendedSpecular = StoreV(MaxZero(_mm_add_ps(_mm_mul_ps(CurrentSpecular, CurW), _mm_mul_ps(LoadV(PrevSpecular), PrevW))));
+						BlendedSpecular.w = PrevSpecular.w + 0.1f;
+					}
+					else
+					{
+						BlendedSH = StoreV(CurrentSH);
+						BlendedCoCg = StoreV(CurrentCoCg);
+						BlendedSpecular = StoreV(CurrentSpecular);
+						BlendedSpecular.w = 0;
+					}
+					BlendedCoCg.z = BlendedCoCg.w = 0;
+
+					Out.SH->Store(x, y, BlendedSH);
+					Out.CoCg->Store(x, y, BlendedCoCg);
+					Out.Specular->Store(x, y, BlendedSpecular);
+
+					// groupshared values are full precision.
+					BandSH[size_t(Row) * CoverX + x] = BlendedSH;
+					BandCoCg[size_t(Row) * CoverX + x] = BlendedCoCg;
+				}
+			}
+
+			// 3x3 downsample for the spatial filter.
+			const int32_t CenterY = int32_t(LowResY) * kDownsampleSize + 1;
+			for (uint32_t LowResX = 0; LowResX < CoverX / kDownsampleSize; LowResX++)
+			{
+				const int32_t CenterX = int32_t(LowResX) * kDownsampleSize + 1;
+
+				glm::vec4 CenterNormal = In.Normal->Load(CenterX, CenterY);
+				float CenterZ = GetLinearDepthOpenGL(In.Depth->Load(CenterX, CenterY).x, Near, Far);
+
+				float SumW = 1;
+				__m128 SumSH = LoadV(BandSH[size_t(1) * CoverX + CenterX]);
+				__m128 SumCoCg = LoadV(BandCoCg[size_t(1) * CoverX + CenterX]);
+
+				for (int32_t yy = -1; yy <= 1; yy++)
+				{
+					for (int32_t xx = -1; xx <= 1; xx++)
+					{
+						if (yy == 0 && xx == 0)
+							continue;
+
+						glm::vec4 SampleNormal = In.Normal->Load(CenterX + xx, CenterY + yy);
+						float SampleZ = GetLinearDepthOpenGL(In.Depth->Load(CenterX + xx, CenterY + yy).x, Near, Far);
+
+						float w = std::exp(-std::abs(SampleZ - CenterZ) * 0.2f);
+						w *= HlslPow(std::max(Dot3(SampleNormal, CenterNormal), 0.f), 8);
+
+						size_t BandIndex = size_t(1 + yy) * CoverX + CenterX + xx;
+						__m128 WV = _mm_set1_ps(w);
+						SumSH = _mm_add_ps(SumSH, _mm_mul_ps(LoadV(BandSH[BandIndex]), WV));
+						SumCoCg = _mm_add_ps(SumCoCg, _mm_mul_ps(LoadV(BandCoCg[BandIndex]), WV));
+						SumW += w;
+					}
+				}
+
+				__m128 InvW = _mm_set1_ps(1.f / SumW);
+				glm::vec4 ResultCoCg = StoreV(_mm_mul_ps(SumCoCg, InvW));
+
+				Out.SHDS->Store(LowResX, LowResY, StoreV(_mm_mul_ps(SumSH, InvW)));
+				// only xy is written on the gpu.
+				glm::vec4 CoCgDS = Out.CoCgDS->Load(LowResX, LowResY);
+				Out.CoCgDS->Store(LowResX, LowResY, glm::vec4(ResultCoCg.x, ResultCoCg.y, CoCgDS.z, CoCgDS.w));
+			}
+		}
+	});
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace enki
+{
+	class TaskScheduler;
+}
+
+// constant buffers of SpatialDenoising.hlsl and TemporalDenoising.hlsl.
+// shared by the gpu passes and the cpu reference below so both are driven by the same values.
+struct SpatialFilterConstant
+{
+	glm::vec4 ProjectionParams;
+	uint32_t Iteration;
+	uint32_t GIBufferScale;
+	float IndirectDiffuseWeightFactorDepth = 0.5f;
+	float IndirectDiffuseWeightFactorNormal = 1.0f;
+};
+
+struct TemporalFilterConstant
+{
+	glm::mat4x4 InvViewMatrix;
+	glm::mat4x4 InvProjMatrix;
+	glm::vec4 ProjectionParams;
+	glm::vec4 TemporalValidParams = glm::vec4(28, 0, 0, 0);
+	glm::vec2 RTSize;
+	uint32_t FrameIndex;
+	float BayerRotScale = 0.1;
+	float SpecularBlurRadius = 4;
+	float Point2PlaneDistScale = 10.0f;
+};
+
+// float4 image standing in for a texture. depth lives in x, CoCg in xy.
+// bHalf rounds every store to fp16 the way the R16G16B16A16_FLOAT targets do.
+struct DenoiserImage
+{
+	uint32_t Width = 0;
+	uint32_t Height = 0;
+	bool bHalf = false;
+	std::vector<glm::vec4> Texels;
+
+	void Init(uint32_t InWidth, uint32_t InHeight, bool bInHalf);
+
+	// out of bounds loads return 0 like a Texture2D load.
+	glm::vec4 Load(int32_t x, int32_t y) const
+	{
+		if (x < 0 || y < 0 || uint32_t(x) >= Width || uint32_t(y) >= Height)
+			return glm::vec4(0.f);
+		return Texels[size_t(y) * Width + x];
+	}
+
+	void Store(uint32_t x, uint32_t y, const glm::vec4& Value);
+};
+
+// SampleLevel with a bilinear wrap sampler.
+glm::vec4 SampleBilinearWrap(const DenoiserImage& Img, glm::vec2 UV);
+
+// runs Func(StartRow, EndRow) over [0, NumRows), split across the task scheduler when one is given.
+void ParallelForRows(enki::TaskScheduler* TS, uint32_t NumRows, const std::function<void(uint32_t, uint32_t)>& Func);
+
+struct TemporalFilterInputs
+{
+	const DenoiserImage* Depth = nullptr;
+	const DenoiserImage* Normal = nullptr;
+	const DenoiserImage* SH = nullptr;
+	const DenoiserImage* CoCg = nullptr;
+	const DenoiserImage* PrevSH = nullptr;
+	const DenoiserImage* PrevCoCg = nullptr;
+	const DenoiserImage* Velocity = nullptr;
+	const DenoiserImage* Specular = nullptr;
+	const DenoiserImage* PrevSpecular = nullptr;
+	const DenoiserImage* RoughnessMetallic = nullptr;
+	const DenoiserImage* PrevDepth = nullptr;
+	const DenoiserImage* PrevNormal = nullptr;
+};
+
+struct TemporalFilterOutputs
+{
+	DenoiserImage* SH = nullptr;
+	DenoiserImage* CoCg = nullptr;
+	// 1/3 resolution input of the spatial filter.
+	DenoiserImage* SHDS = nullptr;
+	DenoiserImage* CoCgDS = nullptr;
+	DenoiserImage* Specular = nullptr;
+};
+
+// cpu reference of the diffuse gi denoiser, for tuning the weights offline and diffing against
+// gpu captures. rows are split across the task scheduler when one is given, texels are processed
+// with sse. only the texels covered by the gpu dispatch are written, outputs keep their size if
+// it already matches and are cleared otherwise.
+// results match the shaders up to fp16 storage and the bilinear filter precision of the hardware.
+
+// one dispatch of SpatialDenoising.hlsl. Iteration 0 is the deflicker pass.
+void SpatialFilterCPU(const SpatialFilterConstant& CB, const DenoiserImage& Depth, const DenoiserImage& GeoNormal,
+	const DenoiserImage& InSH, const DenoiserImage& InCoCg, DenoiserImage& OutSH, DenoiserImage& OutCoCg, enki::TaskScheduler* TS = nullptr);
+
+// the 4 iteration ping pong of Corona::SpatialDenoisingPass. the result ends up in SH[0], CoCg[0].
+void SpatialDenoiseCPU(SpatialFilterConstant CB, const DenoiserImage& Depth, const DenoiserImage& GeoNormal,
+	DenoiserImage SH[2], DenoiserImage CoCg[2], enki::TaskScheduler* TS = nullptr);
+
+// one dispatch of TemporalDenoising.hlsl.
+void TemporalFilterCPU(const TemporalFilterConstant& CB, const TemporalFilterInputs& In, TemporalFilterOutputs& Out, enki::TaskScheduler* TS = nullptr);
@@ -0,0 +1,110 @@
+#include "GPUDrivenScene.h"
+
+void GPUDrivenSceneBuilder::AddGeometry(uint32_t InNumVertices, uint32_t InNumIndices, uint32_t& OutBaseVertex, uint32_t& OutStartIndex)
+{
+	OutBaseVertex = NumVertices;
+	OutStartIndex = NumIndices;
+	NumVertices += InNumVertices;
+	NumIndices += InNumIndices;
+}
+
+uint32_t GPUDrivenSceneBuilder::AddMaterial()
+{
+	return NumMaterials++;
+}
+
+uint32_t GPUDrivenSceneBuilder::AddDraw(const GPUDrawData& Data, const glm::vec3& WorldMin, const glm::vec3& WorldMax,
+	uint32_t IndexCount, uint32_t StartIndex, int32_t BaseVertex)
+{
+	GPUDrawRecord Record = {};
+	Record.AABBMin = WorldMin;
+	Record.AABBMax = WorldMax;
+	Record.IndexCount = IndexCount;
+	Record.StartIndex = StartIndex;
+	Record.BaseVertex = BaseVertex;
+	Record.DrawID = uint32_t(Records.size());
+
+	Records.push_back(Record);
+	DrawData.push_back(Data);
+	return Record.DrawID;
+}
+
+void GPUDrivenSceneBuilder::ClearDraws()
+{
+	Records.clear();
+	DrawData.clear();
+	NumMaterials = 0;
+}
+
+bool GPUDrivenSceneBuilder::Validate(std::string* OutError) const
+{
+	auto Fail = [&](uint32_t DrawID, const char* Reason)
+	{
+		if (OutError)
+			*OutError = "draw " + std::to_string(DrawID) + ": " + Reason;
+		return false;
+	};
+
+	if (NumMaterials > kMaxGPUDrivenMaterials)
+		return Fail(0, "more materials than the texture table holds");
+
+	for (size_t i = 0; i < Records.size(); i++)
+	{
+		const GPUDrawRecord& Record = Records[i];
+		const uint32_t DrawID = uint32_t(i);
+
+		if (Record.DrawID != DrawID)
+			return Fail(DrawID, "draw id does not match its record index");
+		if (Record.IndexCount == 0 || Record.IndexCount % 3 != 0)
+			return Fail(DrawID, "index count is not a whole number of triangles");
+		if (uint64_t(Record.StartIndex) + Record.IndexCount > NumIndices)
+			return Fail(DrawID, "index range is outside the merged index buffer");
+		if (Record.BaseVertex < 0 || uint32_t(Record.BaseVertex) >= NumVertices)
+			return Fail(DrawID, "base vertex is outside the merged vertex buffer");
+		if (glm::any(glm::greaterThan(Record.AABBMin, Record.AABBMax)))
+			return Fail(DrawID, "bounds are inverted");
+		if (DrawData[i].MaterialIndex >= NumMaterials)
+			return Fail(DrawID, "material index was not added");
+		if (DrawData[i].SceneIndex >= kMaxGPUDrivenScenes)
+			return Fail(DrawID, "scene index is outside of the scene constants");
+	}
+
+	return true;
+}
+
+uint32_t CullAndCompactDrawsCPU(const GPUDrivenCullCB& CB, const std::vector<GPUDrawRecord>& Records, std::vector<GPUDrawCommand>& OutCommands)
+{
+	OutCommands.clear();
+
+	const uint32_t NumDraws = glm::min(CB.NumDraws, uint32_t(Records.size()));
+	for (uint32_t i = 0; i < NumDraws; i++)
+	{
+		const GPUDrawRecord& Record = Records[i];
+
+		bool bVisible = true;
+		if (CB.bFrustumCulling)
+		{
+			for (const glm::vec4& Plane : CB.Planes)
+			{
+				const glm::vec3 Positive = glm::vec3(Plane.x > 0 ? Record.AABBMax.x : Record.AABBMin.x,
+					Plane.y > 0 ? Record.AABBMax.y : Record.AABBMin.y, Plane.z > 0 ? Record.AABBMax.z : Record.AABBMin.z);
+				if (glm::dot(glm::vec3(Plane), Positive) + Plane.w < 0)
+					bVisible = false;
+			}
+		}
+
+		if (!bVisible)
+			continue;
+
+		GPUDrawCommand Command;
+		Command.DrawID = Record.DrawID;
+		Command.IndexCountPerInstance = Record.IndexCount;
+		Command.InstanceCount = 1;
+		Command.StartIndexLocation = Record.StartIndex;
+		Command.BaseVertexLocation = Record.BaseVertex;
+		Command.StartInstanceLocation = 0;
+		OutCommands.push_back(Command);
+	}
+
+	return uint32_t(OutCommands.size());
+}
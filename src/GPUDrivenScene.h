@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// gpu driven gbuffer. every mesh lives in one merged vertex and index buffer, every draw is one record
+// culled and compacted on the gpu by GPUDrivenCullCS.hlsl, and the surviving draws are submitted with a
+// single ExecuteIndirect. the pixel shader reads its textures from one table, kTexturesPerMaterial
+// consecutive entries per material.
+const uint32_t kMaxMaterialTextures = 1024;
+const uint32_t kTexturesPerMaterial = 4;	// albedo, normal, roughness, metallic
+const uint32_t kMaxGPUDrivenMaterials = kMaxMaterialTextures / kTexturesPerMaterial;
+const uint32_t kMaxGPUDrivenScenes = 2;	// sponza and the shader balls
+
+// one per draw, read by the cull pass. world space bounds and the ranges in the merged buffers.
+struct GPUDrawRecord
+{
+	glm::vec3 AABBMin;
+	uint32_t IndexCount;
+	glm::vec3 AABBMax;
+	uint32_t StartIndex;
+	int32_t BaseVertex;
+	uint32_t DrawID;
+	uint32_t Pad[2];
+};
+
+// one per draw, read by GBuffer.hlsl with GPU_DRIVEN through the DrawID root constant. nothing in it
+// changes after InitGPUDrivenScene, the transform comes from the instance transform buffer and the
+// roughness sliders from GPUDrivenSceneCB.
+struct GPUDrawData
+{
+	uint32_t InstanceIndex;	// Scene::InstanceBase + instance
+	uint32_t MaterialIndex;
+	uint32_t SceneIndex;	// into GPUDrivenSceneCB
+	uint32_t Pad;
+};
+
+// one indirect command, the DrawID root constant followed by D3D12_DRAW_INDEXED_ARGUMENTS.
+struct GPUDrawCommand
+{
+	uint32_t DrawID;
+	uint32_t IndexCountPerInstance;
+	uint32_t InstanceCount;
+	uint32_t StartIndexLocation;
+	int32_t BaseVertexLocation;
+	uint32_t StartInstanceLocation;
+};
+
+static_assert(sizeof(GPUDrawRecord) == 48, "GPUDrawRecord is loaded as 3 uint4 by GPUDrivenCullCS.hlsl");
+static_assert(sizeof(GPUDrawData) == 16, "GPUDrawData is loaded as 1 uint4 by GBuffer.hlsl");
+static_assert(sizeof(GPUDrawCommand) == 24, "GPUDrawCommand is the command signature stride");
+
+// constant buffer of GPUDrivenCullCS.hlsl.
+struct GPUDrivenCullCB
+{
+	glm::vec4 Planes[6];
+	uint32_t NumDraws;
+	uint32_t bFrustumCulling;
+};
+
+// constant buffer of GBuffer.hlsl with GPU_DRIVEN, the roughness and metallic sliders per scene. x the
+// roughness multiplier, y metallic, z 1 when they replace the textures.
+struct GPUDrivenSceneCB
+{
+	glm::vec4 SceneMaterial[kMaxGPUDrivenScenes];
+};
+
+// packs the merged geometry ranges, materials and draws of the gpu driven path.
+class GPUDrivenSceneBuilder
+{
+public:
+	// reserves the range of one mesh in the merged buffers.
+	void AddGeometry(uint32_t InNumVertices, uint32_t InNumIndices, uint32_t& OutBaseVertex, uint32_t& OutStartIndex);
+
+	// returns the material index, its textures are at MaterialIndex * kTexturesPerMaterial of the table.
+	uint32_t AddMaterial();
+
+	// Data.MaterialIndex has to come from AddMaterial. returns the DrawID.
+	uint32_t AddDraw(const GPUDrawData& Data, const glm::vec3& WorldMin, const glm::vec3& WorldMax,
+		uint32_t IndexCount, uint32_t StartIndex, int32_t BaseVertex);
+
+	// drops the draws and materials, the geometry stays.
+	void ClearDraws();
+
+	// every draw inside the merged buffers, indices in whole triangles, a valid material and scene and
+	// matching ids.
+	bool Validate(std::string* OutError) const;
+
+	uint32_t GetNumVertices() const { return NumVertices; }
+	uint32_t GetNumIndices() const { return NumIndices; }
+	uint32_t GetNumMaterials() const { return NumMaterials; }
+	uint32_t GetNumDraws() const { return uint32_t(Records.size()); }
+
+	const std::vector<GPUDrawRecord>& GetRecords() const { return Records; }
+	const std::vector<GPUDrawData>& GetDrawData() const { return DrawData; }
+
+private:
+	uint32_t NumVertices = 0;
+	uint32_t NumIndices = 0;
+	uint32_t NumMaterials = 0;
+
+	std::vector<GPUDrawRecord> Records;
+	std::vector<GPUDrawData> DrawData;
+};
+
+// cpu version of GPUDrivenCullCS.hlsl. the gpu appends in any order, here commands stay in record order.
+uint32_t CullAndCompactDrawsCPU(const GPUDrivenCullCB& CB, const std::vector<GPUDrawRecord>& Records, std::vector<GPUDrawCommand>& OutCommands);
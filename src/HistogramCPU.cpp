@@ -0,0 +1,84 @@
+#include "HistogramCPU.h"
+
+#include <cmath>
+#include <algorithm>
+
+void InitExposureData(float Exposure, float MinLog, float MaxLog, float ExposureData[kExposureDataCount])
+{
+	ExposureData[0] = Exposure;
+	ExposureData[1] = 1.0f / Exposure;
+	ExposureData[2] = Exposure;
+	ExposureData[3] = 0.0f;
+	ExposureData[4] = MinLog;
+	ExposureData[5] = MaxLog;
+	ExposureData[6] = MaxLog - MinLog;
+	ExposureData[7] = 1.0f / (MaxLog - MinLog);
+}
+
+uint8_t QuantizeLogLuma(float Luma, float MinLog, float RcpLogRange)
+{
+	if (Luma == 0.0f)
+		return 0;
+
+	float LogLuma = std::min(std::max((std::log2(Luma) - MinLog) * RcpLogRange, 0.0f), 1.0f);
+	return uint8_t(LogLuma * 254.0f + 1.0f);
+}
+
+void GenerateHistogramCPU(const uint8_t* Luma, uint32_t Width, uint32_t Height, uint32_t RowPitch, uint32_t Histogram[kHistogramBinCount])
+{
+	std::fill(Histogram, Histogram + kHistogramBinCount, 0);
+
+	for (uint32_t y = 0; y < Height; y++)
+	{
+		const uint8_t* Row = Luma + size_t(y) * RowPitch;
+		for (uint32_t x = 0; x < Width; x++)
+			Histogram[Row[x]]++;
+	}
+}
+
+void AdaptExposureCPU(const AdaptExposureCB& CB, const uint32_t Histogram[kHistogramBinCount], float ExposureData[kExposureDataCount])
+{
+	// uint on the gpu as well, wraps the same way.
+	uint32_t WeightedSum = 0;
+	for (uint32_t i = 0; i < kHistogramBinCount; i++)
+		WeightedSum += i * Histogram[i];
+
+	float MinLog = ExposureData[4];
+	float MaxLog = ExposureData[5];
+	float LogRange = ExposureData[6];
+	float RcpLogRange = ExposureData[7];
+
+	float WeightedHistAvg = float(WeightedSum) / float(std::max(1u, CB.PixelCount - Histogram[0])) - 1.0f;
+	float LogAvgLuminance = std::exp2(WeightedHistAvg / 254.0f * LogRange + MinLog);
+	float TargetExposure = CB.TargetLuminance / LogAvgLuminance;
+
+	float Exposure = ExposureData[0];
+	Exposure = Exposure + (TargetExposure - Exposure) * CB.AdaptationRate;
+	Exposure = std::min(std::max(Exposure, CB.MinExposure), CB.MaxExposure);
+
+	ExposureData[0] = Exposure;
+	ExposureData[1] = 1.0f / Exposure;
+	ExposureData[2] = Exposure;
+	ExposureData[3] = WeightedHistAvg;
+
+	if (CB.ResetLogRange)
+	{
+		MinLog = CB.ResetMinLog;
+		MaxLog = CB.ResetMaxLog;
+		LogRange = CB.ResetMaxLog - CB.ResetMinLog;
+	}
+	else
+	{
+		float BiasToCenter = (std::floor(WeightedHistAvg) - 128.0f) / 255.0f;
+		if (std::abs(BiasToCenter) > 0.1f)
+		{
+			MinLog += BiasToCenter * RcpLogRange;
+			MaxLog += BiasToCenter * RcpLogRange;
+		}
+	}
+
+	ExposureData[4] = MinLog;
+	ExposureData[5] = MaxLog;
+	ExposureData[6] = LogRange;
+	ExposureData[7] = 1.0f / LogRange;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+// constant buffer of AdaptExposureCS.hlsl, shared with the cpu reference below.
+struct AdaptExposureCB
+{
+	float TargetLuminance = 0.03;
+	float AdaptationRate = 0.05;
+	float MinExposure = 1.0f / 64.0f;
+	float MaxExposure = 8;
+	uint32_t PixelCount;
+	// set for one frame to replace the (recentered) bin range with ResetMinLog/ResetMaxLog.
+	uint32_t ResetLogRange = 0;
+	float ResetMinLog;
+	float ResetMaxLog;
+};
+
+static const uint32_t kHistogramBinCount = 256;
+// layout of the exposure buffer : exposure, 1/exposure, exposure, log average bin, MinLog, MaxLog, LogRange, 1/LogRange
+static const uint32_t kExposureDataCount = 8;
+
+void InitExposureData(float Exposure, float MinLog, float MaxLog, float ExposureData[kExposureDataCount]);
+
+// cpu reference of the luma histogram and the exposure adaptation, numerically the same as the shaders
+// except for the transcendental functions.
+
+// BloomExtract quantization. 0 is reserved for black, everything else maps to [1, 255].
+uint8_t QuantizeLogLuma(float Luma, float MinLog, float RcpLogRange);
+
+// GenerateHistogram for a whole R8_UINT luma image. Histogram is cleared first.
+void GenerateHistogramCPU(const uint8_t* Luma, uint32_t Width, uint32_t Height, uint32_t RowPitch, uint32_t Histogram[kHistogramBinCount]);
+
+// AdaptExposure. ExposureData is read and updated in place like the gpu buffer.
+void AdaptExposureCPU(const AdaptExposureCB& CB, const uint32_t Histogram[kHistogramBinCount], float ExposureData[kExposureDataCount]);
@@ -0,0 +1,113 @@
+#include "InstanceStore.h"
+#include "BatchMath.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+uint32_t InstanceStore::Add(const glm::mat4x4& Transform)
+{
+	const uint32_t Instance = Count++;
+
+	for (int Row = 0; Row < 3; Row++)
+		for (int Column = 0; Column < 4; Column++)
+			M[Row][Column].push_back(0.f);
+
+	DirtyBits.resize((Count + 63) / 64, 0);
+
+	Set(Instance, Transform);
+	return Instance;
+}
+
+void InstanceStore::Set(uint32_t Instance, const glm::mat4x4& Transform)
+{
+	for (int Row = 0; Row < 3; Row++)
+		for (int Column = 0; Column < 4; Column++)
+			M[Row][Column][Instance] = Transform[Column][Row];
+
+	MarkDirty(Instance);
+}
+
+glm::mat4x4 InstanceStore::Get(uint32_t Instance) const
+{
+	glm::mat4x4 Transform = glm::mat4x4(1.f);
+	for (int Row = 0; Row < 3; Row++)
+		for (int Column = 0; Column < 4; Column++)
+			Transform[Column][Row] = M[Row][Column][Instance];
+	return Transform;
+}
+
+void InstanceStore::Clear()
+{
+	Count = 0;
+	for (int Row = 0; Row < 3; Row++)
+		for (int Column = 0; Column < 4; Column++)
+			M[Row][Column].clear();
+
+	DirtyBits.clear();
+	NumDirty = 0;
+	DirtyFirst = DirtyEnd = 0;
+}
+
+bool InstanceStore::IsDirty(uint32_t Instance) const
+{
+	return (DirtyBits[Instance / 64] >> (Instance % 64)) & 1;
+}
+
+void InstanceStore::MarkDirty(uint32_t Instance)
+{
+	uint64_t& Word = DirtyBits[Instance / 64];
+	const uint64_t Bit = uint64_t(1) << (Instance % 64);
+	if (Word & Bit)
+		return;
+
+	Word |= Bit;
+	if (NumDirty++ == 0)
+	{
+		DirtyFirst = Instance;
+		DirtyEnd = Instance + 1;
+	}
+	else
+	{
+		DirtyFirst = std::min(DirtyFirst, Instance);
+		DirtyEnd = std::max(DirtyEnd, Instance + 1);
+	}
+}
+
+void InstanceStore::MarkAllDirty()
+{
+	for (uint32_t Instance = 0; Instance < Count; Instance++)
+		MarkDirty(Instance);
+}
+
+void InstanceStore::PackDirty(uint8_t* Dst, size_t Stride, uint32_t& OutFirst, uint32_t& OutEnd)
+{
+	OutFirst = OutEnd = 0;
+	if (NumDirty == 0)
+		return;
+
+	for (uint32_t Instance = DirtyFirst; Instance < DirtyEnd; Instance++)
+	{
+		const glm::mat4x4 Transform = Get(Instance);
+		memcpy(Dst + Instance * Stride, &Transform, sizeof(Transform));
+	}
+
+	OutFirst = DirtyFirst;
+	OutEnd = DirtyEnd;
+
+	std::fill(DirtyBits.begin(), DirtyBits.end(), 0);
+	NumDirty = 0;
+	DirtyFirst = DirtyEnd = 0;
+}
+
+void InstanceStore::TransformBounds(const glm::vec3& Min, const glm::vec3& Max, glm::vec3& OutMin, glm::vec3& OutMax) const
+{
+	const float* Rows[3][4];
+	for (int Row = 0; Row < 3; Row++)
+	{
+		for (int Column = 0; Column < 4; Column++)
+			Rows[Row][Column] = M[Row][Column].data();
+	}
+	BatchTransformBoundsUnion(Rows, Count, Min, Max, OutMin, OutMax);
+}
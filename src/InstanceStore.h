@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// object to world transforms of the instances of one scene, structure of arrays. only the affine part is
+// kept, element (Row, Column) of the 3x4 matrix in its own float array, so work over every instance
+// streams through contiguous memory. changed instances stay dirty until PackDirty wrote them out.
+class InstanceStore
+{
+public:
+	uint32_t Add(const glm::mat4x4& Transform);
+	void Set(uint32_t Instance, const glm::mat4x4& Transform);
+	glm::mat4x4 Get(uint32_t Instance) const;
+
+	uint32_t Size() const { return Count; }
+	void Clear();
+
+	bool IsDirty(uint32_t Instance) const;
+	uint32_t GetNumDirty() const { return NumDirty; }
+	void MarkAllDirty();
+
+	// writes every instance in the smallest range covering the dirty ones to Dst + Instance * Stride as a
+	// glm::mat4x4, and clears the flags. the range is returned in OutFirst, OutEnd, empty when nothing
+	// was dirty. the whole range is written so it can be copied to the gpu in one piece.
+	void PackDirty(uint8_t* Dst, size_t Stride, uint32_t& OutFirst, uint32_t& OutEnd);
+
+	// union of the object space box transformed by every instance.
+	void TransformBounds(const glm::vec3& Min, const glm::vec3& Max, glm::vec3& OutMin, glm::vec3& OutMax) const;
+
+private:
+	void MarkDirty(uint32_t Instance);
+
+	uint32_t Count = 0;
+	std::vector<float> M[3][4];
+
+	std::vector<uint64_t> DirtyBits;
+	uint32_t NumDirty = 0;
+	uint32_t DirtyFirst = 0;
+	uint32_t DirtyEnd = 0;
+};
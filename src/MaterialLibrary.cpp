@@ -0,0 +1,313 @@
+#include "MaterialLibrary.h"
+
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+	struct XmlTag
+	{
+		std::string Name;
+		std::map<std::string, std::string> Attributes;
+		bool bClosing = false;		// </Name>
+		bool bSelfClosing = false;	// <Name/>
+	};
+
+	std::string GetFileNamePart(const std::string& Path)
+	{
+		const size_t Slash = Path.find_last_of("/\\");
+		return Slash == std::string::npos ? Path : Path.substr(Slash + 1);
+	}
+
+	bool ParseBool(const std::string& Value)
+	{
+		return Value == "True" || Value == "true" || Value == "1";
+	}
+
+	std::string DecodeEntities(const std::string& Value)
+	{
+		static const std::pair<const char*, char> Entities[] = {
+			{ "&amp;", '&' }, { "&lt;", '<' }, { "&gt;", '>' }, { "&quot;", '"' }, { "&apos;", '\'' },
+		};
+
+		std::string Result;
+		Result.reserve(Value.size());
+		for (size_t i = 0; i < Value.size(); i++)
+		{
+			bool bDecoded = false;
+			if (Value[i] == '&')
+			{
+				for (auto& Entity : Entities)
+				{
+					if (Value.compare(i, strlen(Entity.first), Entity.first) == 0)
+					{
+						Result += Entity.second;
+						i += strlen(Entity.first) - 1;
+						bDecoded = true;
+						break;
+					}
+				}
+			}
+			if (!bDecoded)
+				Result += Value[i];
+		}
+		return Result;
+	}
+
+	// reads the tag starting at Text[Pos] == '<', Pos ends up after its '>'.
+	bool ParseTag(const std::string& Text, size_t& Pos, XmlTag& Tag, std::string& Error)
+	{
+		auto SkipSpace = [&]()
+		{
+			while (Pos < Text.size() && isspace((unsigned char)Text[Pos]))
+				Pos++;
+		};
+		auto ReadName = [&]()
+		{
+			const size_t Start = Pos;
+			while (Pos < Text.size() && (isalnum((unsigned char)Text[Pos]) || Text[Pos] == '_' || Text[Pos] == '-' || Text[Pos] == ':'))
+				Pos++;
+			return Text.substr(Start, Pos - Start);
+		};
+
+		Pos++;
+		if (Pos < Text.size() && Text[Pos] == '/')
+		{
+			Tag.bClosing = true;
+			Pos++;
+		}
+
+		Tag.Name = ReadName();
+		if (Tag.Name.empty())
+		{
+			Error = "expected an element name at offset " + std::to_string(Pos);
+			return false;
+		}
+
+		for (;;)
+		{
+			SkipSpace();
+			if (Pos >= Text.size())
+			{
+				Error = "unterminated <" + Tag.Name + ">";
+				return false;
+			}
+
+			if (Text[Pos] == '>')
+			{
+				Pos++;
+				return true;
+			}
+
+			if (Text[Pos] == '/' && Pos + 1 < Text.size() && Text[Pos + 1] == '>')
+			{
+				Tag.bSelfClosing = true;
+				Pos += 2;
+				return true;
+			}
+
+			const std::string Attribute = ReadName();
+			SkipSpace();
+			if (Attribute.empty() || Pos >= Text.size() || Text[Pos] != '=')
+			{
+				Error = "malformed attribute in <" + Tag.Name + "> at offset " + std::to_string(Pos);
+				return false;
+			}
+			Pos++;
+			SkipSpace();
+
+			const char Quote = Pos < Text.size() ? Text[Pos] : 0;
+			if (Quote != '"' && Quote != '\'')
+			{
+				Error = "unquoted value of " + Attribute + " in <" + Tag.Name + ">";
+				return false;
+			}
+
+			const size_t End = Text.find(Quote, Pos + 1);
+			if (End == std::string::npos)
+			{
+				Error = "unterminated value of " + Attribute + " in <" + Tag.Name + ">";
+				return false;
+			}
+
+			Tag.Attributes[Attribute] = DecodeEntities(Text.substr(Pos + 1, End - Pos - 1));
+			Pos = End + 1;
+		}
+	}
+}
+
+bool MaterialLibrary::LoadFile(const std::string& Path, std::string& Error)
+{
+	std::ifstream File(Path, std::ios::binary);
+	if (!File)
+	{
+		Error = "can't open " + Path;
+		return false;
+	}
+
+	std::stringstream Stream;
+	Stream << File.rdbuf();
+
+	if (!LoadText(Stream.str(), Error))
+	{
+		Error = Path + ": " + Error;
+		return false;
+	}
+	return true;
+}
+
+bool MaterialLibrary::LoadText(const std::string& Text, std::string& Error)
+{
+	bool bInMaterial = false;
+	MaterialDesc Current;
+
+	size_t Pos = 0;
+	while ((Pos = Text.find('<', Pos)) != std::string::npos)
+	{
+		if (Text.compare(Pos, 4, "<!--") == 0)
+		{
+			const size_t End = Text.find("-->", Pos);
+			if (End == std::string::npos)
+			{
+				Error = "unterminated comment";
+				return false;
+			}
+			Pos = End + 3;
+			continue;
+		}
+
+		if (Text.compare(Pos, 2, "<?") == 0)
+		{
+			const size_t End = Text.find("?>", Pos);
+			if (End == std::string::npos)
+			{
+				Error = "unterminated declaration";
+				return false;
+			}
+			Pos = End + 2;
+			continue;
+		}
+
+		XmlTag Tag;
+		if (!ParseTag(Text, Pos, Tag, Error))
+			return false;
+
+		if (Tag.Name == "Material")
+		{
+			if (Tag.bClosing)
+			{
+				if (!bInMaterial)
+				{
+					Error = "</Material> without <Material>";
+					return false;
+				}
+				Add(std::move(Current));
+				bInMaterial = false;
+				continue;
+			}
+
+			if (bInMaterial)
+			{
+				Error = "nested <Material> in " + Current.Name;
+				return false;
+			}
+
+			auto Get = [&](const char* Name) -> std::string
+			{
+				auto it = Tag.Attributes.find(Name);
+				return it != Tag.Attributes.end() ? it->second : std::string();
+			};
+
+			Current = MaterialDesc();
+			Current.Name = Get("name");
+			Current.AlbedoMap = Get("AlbedoMap");
+			Current.NormalMap = Get("NormalMap");
+			Current.RoughnessMap = Get("RoughnessMap");
+			Current.MetallicMap = Get("MetallicMap");
+			Current.SpecularRMCMap = Get("SpecularRMCMap");
+			Current.ShaderName = Get("ShaderName");
+			Current.TechniqueName = Get("TechniqueName");
+			Current.bTwoSided = ParseBool(Get("TwoSided"));
+			Current.bAlphaTest = ParseBool(Get("AlphaTest"));
+
+			const std::string Gamma = Get("TextureGamma");
+			if (!Gamma.empty())
+				Current.TextureGamma = float(atof(Gamma.c_str()));
+
+			if (Current.Name.empty())
+			{
+				Error = "<Material> without a name";
+				return false;
+			}
+
+			if (Tag.bSelfClosing)
+				Add(std::move(Current));
+			else
+				bInMaterial = true;
+		}
+		else if (Tag.Name == "Pass" && !Tag.bClosing)
+		{
+			if (!bInMaterial)
+			{
+				Error = "<Pass> outside of <Material>";
+				return false;
+			}
+			Current.Passes.push_back(Tag.Attributes["name"]);
+		}
+	}
+
+	if (bInMaterial)
+	{
+		Error = "unterminated <Material> " + Current.Name;
+		return false;
+	}
+
+	return true;
+}
+
+void MaterialLibrary::Add(MaterialDesc&& Desc)
+{
+	const std::string Albedo = GetFileNamePart(Desc.AlbedoMap);
+
+	auto it = NameToIndex.find(Desc.Name);
+	size_t Index;
+	if (it != NameToIndex.end())
+	{
+		Index = it->second;
+		const std::string OldAlbedo = GetFileNamePart(Materials[Index].AlbedoMap);
+		if (AlbedoToIndex.count(OldAlbedo) && AlbedoToIndex[OldAlbedo] == Index)
+			AlbedoToIndex.erase(OldAlbedo);
+		Materials[Index] = std::move(Desc);
+	}
+	else
+	{
+		Index = Materials.size();
+		NameToIndex[Desc.Name] = Index;
+		Materials.push_back(std::move(Desc));
+	}
+
+	if (!Albedo.empty())
+		AlbedoToIndex[Albedo] = Index;
+}
+
+const MaterialDesc* MaterialLibrary::Find(const std::string& Name) const
+{
+	auto it = NameToIndex.find(Name);
+	return it != NameToIndex.end() ? &Materials[it->second] : nullptr;
+}
+
+const MaterialDesc* MaterialLibrary::FindByAlbedo(const std::string& FileName) const
+{
+	auto it = AlbedoToIndex.find(GetFileNamePart(FileName));
+	return it != AlbedoToIndex.end() ? &Materials[it->second] : nullptr;
+}
+
+void MaterialLibrary::Clear()
+{
+	Materials.clear();
+	NameToIndex.clear();
+	AlbedoToIndex.clear();
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Material table read from the *.material files next to the models, e.g. assets/pistol/pistol.material.
+//
+// <Materials>
+// <Material name="..." AlbedoMap="..." NormalMap="..." RoughnessMap="..." MetallicMap="..." AlphaTest="True" TwoSided="False">
+//    <Pass name="color"/>
+// </Material>
+// </Materials>
+//
+// only these elements are understood, attributes nobody reads are ignored. map paths are relative to the
+// directory of the file, an empty map keeps whatever the model or the default texture provides.
+struct MaterialDesc
+{
+	std::string Name;
+	std::string AlbedoMap;
+	std::string NormalMap;
+	std::string RoughnessMap;
+	std::string MetallicMap;
+	std::string SpecularRMCMap;
+	std::string ShaderName;
+	std::string TechniqueName;
+	std::vector<std::string> Passes;
+	bool bTwoSided = false;
+	bool bAlphaTest = false;
+	float TextureGamma = 1.f;
+};
+
+class MaterialLibrary
+{
+public:
+	// appends the materials of the file, a later material replaces an earlier one of the same name.
+	// returns false and fills Error if the file can't be read or is malformed.
+	bool LoadFile(const std::string& Path, std::string& Error);
+	bool LoadText(const std::string& Text, std::string& Error);
+
+	const MaterialDesc* Find(const std::string& Name) const;
+
+	// the fbx material names depend on the exporter, the albedo texture is the stable part.
+	const MaterialDesc* FindByAlbedo(const std::string& FileName) const;
+
+	const std::vector<MaterialDesc>& GetMaterials() const { return Materials; }
+
+	void Clear();
+
+private:
+	void Add(MaterialDesc&& Desc);
+
+	std::vector<MaterialDesc> Materials;
+	std::map<std::string, size_t> NameToIndex;
+	std::map<std::string, size_t> AlbedoToIndex;
+};
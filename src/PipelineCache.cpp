@@ -0,0 +1,183 @@
+#include "PipelineCache.h"
+
+#include <filesystem>
+#include <fstream>
+
+static const uint8_t PipelineCacheMagic[4] = { 'C', 'P', 'L', 'C' };
+static const size_t PipelineCacheHeaderSize = 4 + 4 + 8 + 8 + 8;
+
+void PipelineHasher::AddBytes(const void* Data, size_t Size)
+{
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+	for (size_t i = 0; i < Size; i++)
+	{
+		Hash ^= Bytes[i];
+		Hash *= 1099511628211ull;
+	}
+}
+
+void PipelineHasher::AddString(const char* String)
+{
+	const size_t Length = String ? strlen(String) : 0;
+	AddValue(uint64_t(Length));
+	AddBytes(String, Length);
+}
+
+void PipelineHasher::AddBlob(const void* Data, size_t Size)
+{
+	AddValue(uint64_t(Size));
+	if (Data)
+		AddBytes(Data, Size);
+}
+
+std::wstring GetPipelineKeyName(uint64_t Key)
+{
+	static const wchar_t Digits[] = L"0123456789abcdef";
+	std::wstring Name(16, L'0');
+	for (int i = 15; i >= 0; i--, Key >>= 4)
+		Name[i] = Digits[Key & 0xf];
+	return Name;
+}
+
+static void WriteLE(std::vector<uint8_t>& Out, uint64_t Value, size_t Size)
+{
+	for (size_t i = 0; i < Size; i++)
+		Out.push_back(uint8_t(Value >> (i * 8)));
+}
+
+static uint64_t ReadLE(const uint8_t* In, size_t Size)
+{
+	uint64_t Value = 0;
+	for (size_t i = 0; i < Size; i++)
+		Value |= uint64_t(In[i]) << (i * 8);
+	return Value;
+}
+
+static uint64_t HashPayload(const void* Data, size_t Size)
+{
+	PipelineHasher Hasher;
+	Hasher.AddBytes(Data, Size);
+	return Hasher.Get();
+}
+
+void SerializePipelineCache(uint64_t DeviceId, const void* Data, size_t Size, std::vector<uint8_t>& Out)
+{
+	Out.clear();
+	Out.reserve(PipelineCacheHeaderSize + Size);
+	Out.insert(Out.end(), PipelineCacheMagic, PipelineCacheMagic + 4);
+	WriteLE(Out, PipelineCacheVersion, 4);
+	WriteLE(Out, DeviceId, 8);
+	WriteLE(Out, Size, 8);
+	WriteLE(Out, HashPayload(Data, Size), 8);
+
+	const uint8_t* Bytes = static_cast<const uint8_t*>(Data);
+	Out.insert(Out.end(), Bytes, Bytes + Size);
+}
+
+bool ParsePipelineCache(const uint8_t* File, size_t FileSize, uint64_t DeviceId, std::vector<uint8_t>& OutData, std::string& Error)
+{
+	OutData.clear();
+
+	if (FileSize < PipelineCacheHeaderSize || memcmp(File, PipelineCacheMagic, 4) != 0)
+	{
+		Error = "not a pipeline cache";
+		return false;
+	}
+	if (ReadLE(File + 4, 4) != PipelineCacheVersion)
+	{
+		Error = "pipeline cache version changed";
+		return false;
+	}
+	if (ReadLE(File + 8, 8) != DeviceId)
+	{
+		Error = "pipeline cache of another device";
+		return false;
+	}
+
+	const uint64_t Size = ReadLE(File + 16, 8);
+	if (Size != FileSize - PipelineCacheHeaderSize)
+	{
+		Error = "pipeline cache truncated";
+		return false;
+	}
+
+	const uint8_t* Payload = File + PipelineCacheHeaderSize;
+	if (ReadLE(File + 24, 8) != HashPayload(Payload, size_t(Size)))
+	{
+		Error = "pipeline cache damaged";
+		return false;
+	}
+
+	OutData.assign(Payload, Payload + Size);
+	return true;
+}
+
+bool WritePipelineCacheFile(const std::string& Path, uint64_t DeviceId, const void* Data, size_t Size, std::string& Error)
+{
+	std::vector<uint8_t> File;
+	SerializePipelineCache(DeviceId, Data, Size, File);
+
+	const std::string TempPath = Path + ".tmp";
+	{
+		std::ofstream Out(TempPath, std::ios::binary | std::ios::trunc);
+		if (!Out)
+		{
+			Error = "can't open " + TempPath;
+			return false;
+		}
+		Out.write(reinterpret_cast<const char*>(File.data()), File.size());
+		if (!Out)
+		{
+			Error = "can't write " + TempPath;
+			return false;
+		}
+	}
+
+	std::error_code ErrorCode;
+	std::filesystem::rename(TempPath, Path, ErrorCode);
+	if (ErrorCode)
+	{
+		Error = "can't replace " + Path + ": " + ErrorCode.message();
+		return false;
+	}
+	return true;
+}
+
+bool ReadPipelineCacheFile(const std::string& Path, uint64_t DeviceId, std::vector<uint8_t>& OutData, std::string& Error)
+{
+	std::ifstream In(Path, std::ios::binary | std::ios::ate);
+	if (!In)
+		return false;
+
+	std::vector<uint8_t> File(size_t(In.tellg()));
+	In.seekg(0);
+	In.read(reinterpret_cast<char*>(File.data()), File.size());
+	if (!In)
+	{
+		Error = "can't read " + Path;
+		return false;
+	}
+
+	return ParsePipelineCache(File.data(), File.size(), DeviceId, OutData, Error);
+}
+
+void PipelineCacheLoader::Start(const std::string& Path, uint64_t DeviceId)
+{
+	Pending = std::async(std::launch::async, [Path, DeviceId]()
+	{
+		Result Loaded;
+		Loaded.bLoaded = ReadPipelineCacheFile(Path, DeviceId, Loaded.Data, Loaded.Error);
+		return Loaded;
+	});
+}
+
+bool PipelineCacheLoader::Get(std::vector<uint8_t>& OutData, std::string& Error)
+{
+	if (!Pending.valid())
+		return false;
+
+	Result Loaded = Pending.get();
+	OutData = std::move(Loaded.Data);
+	Error = std::move(Loaded.Error);
+	return Loaded.bLoaded;
+}
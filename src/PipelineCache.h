@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <future>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+// compiled pipelines persisted across launches. the backends key their pipelines with PipelineHasher and
+// keep the driver's blob (ID3D12PipelineLibrary or VkPipelineCache data) in a file of this format,
+//   magic "CPLC", u32 version, u64 device id, u64 payload size, u64 payload hash, payload
+// little endian. a file of another version or device, or with a damaged payload, is ignored and rebuilt.
+
+// 64 bit fnv-1a. integers are hashed as little endian bytes, the key of a description is the same on every
+// platform. structs with padding have to be added field by field.
+class PipelineHasher
+{
+public:
+	void AddBytes(const void* Data, size_t Size);
+
+	template<typename T>
+	void AddValue(T Value)
+	{
+		static_assert(std::is_integral<T>::value || std::is_enum<T>::value || std::is_floating_point<T>::value, "hash structs field by field");
+		uint8_t Bytes[sizeof(T)];
+		uint64_t Bits = 0;
+		if constexpr (std::is_floating_point<T>::value)
+		{
+			static_assert(sizeof(T) <= sizeof(Bits), "");
+			memcpy(&Bits, &Value, sizeof(T));
+		}
+		else
+			Bits = uint64_t(Value);
+		for (size_t i = 0; i < sizeof(T); i++)
+			Bytes[i] = uint8_t(Bits >> (i * 8));
+		AddBytes(Bytes, sizeof(T));
+	}
+
+	// the length first, "ab" + "c" and "a" + "bc" hash differently.
+	void AddString(const char* String);
+	// a shader or root signature blob.
+	void AddBlob(const void* Data, size_t Size);
+
+	uint64_t Get() const { return Hash; }
+
+private:
+	uint64_t Hash = 14695981039346656037ull;
+};
+
+// 16 hex digits, the name of a pipeline in the library.
+std::wstring GetPipelineKeyName(uint64_t Key);
+
+const uint32_t PipelineCacheVersion = 1;
+
+void SerializePipelineCache(uint64_t DeviceId, const void* Data, size_t Size, std::vector<uint8_t>& Out);
+bool ParsePipelineCache(const uint8_t* File, size_t FileSize, uint64_t DeviceId, std::vector<uint8_t>& OutData, std::string& Error);
+
+// writes to a temporary file and renames it, a crash while saving leaves the previous cache.
+bool WritePipelineCacheFile(const std::string& Path, uint64_t DeviceId, const void* Data, size_t Size, std::string& Error);
+bool ReadPipelineCacheFile(const std::string& Path, uint64_t DeviceId, std::vector<uint8_t>& OutData, std::string& Error);
+
+// reads and checks the file on a worker thread while the device and the shaders are set up.
+class PipelineCacheLoader
+{
+public:
+	void Start(const std::string& Path, uint64_t DeviceId);
+	// waits for the read. false with an empty Error when there was no file.
+	bool Get(std::vector<uint8_t>& OutData, std::string& Error);
+
+private:
+	struct Result
+	{
+		bool bLoaded = false;
+		std::vector<uint8_t> Data;
+		std::string Error;
+	};
+	std::future<Result> Pending;
+};
@@ -0,0 +1,358 @@
+#include "ProbePlacementCPU.h"
+
+#include <cmath>
+#include <cfloat>
+#include <algorithm>
+#include <random>
+
+#include "glm/gtc/constants.hpp"
+#include "glm/gtc/quaternion.hpp"
+#include "GIDenoiserCPU.h"
+
+// leaves are split until they hold at most this many triangles.
+static const uint32_t kMaxLeafTriangles = 4;
+static const uint32_t kMaxTraversalDepth = 64;
+// hit distance of a ray that hits nothing, the probe max ray distance of the volume.
+static const float kMissDistance = 1e27f;
+
+void ProbePlacementGeometry::AddMesh(const std::vector<glm::vec3>& InPositions, const std::vector<glm::vec3>& InNormals,
+	const std::vector<uint16_t>& Indices, const glm::mat4x4& Transform)
+{
+	const glm::mat3x3 NormalTransform = glm::transpose(glm::inverse(glm::mat3x3(Transform)));
+
+	Positions.reserve(Positions.size() + Indices.size());
+	Normals.reserve(Normals.size() + Indices.size() / 3);
+
+	for (size_t i = 0; i + 2 < Indices.size(); i += 3)
+	{
+		const glm::vec3 P0 = glm::vec3(Transform * glm::vec4(InPositions[Indices[i + 0]], 1));
+		const glm::vec3 P1 = glm::vec3(Transform * glm::vec4(InPositions[Indices[i + 1]], 1));
+		const glm::vec3 P2 = glm::vec3(Transform * glm::vec4(InPositions[Indices[i + 2]], 1));
+
+		glm::vec3 FaceNormal = glm::cross(P1 - P0, P2 - P0);
+		const float Area = glm::length(FaceNormal);
+		if (Area <= 0.f)
+			continue;
+		FaceNormal /= Area;
+
+		// winding is not reliable across assets, the vertex normals decide the side.
+		const glm::vec3 VertexNormal = NormalTransform * (InNormals[Indices[i + 0]] + InNormals[Indices[i + 1]] + InNormals[Indices[i + 2]]);
+		if (glm::dot(FaceNormal, VertexNormal) < 0.f)
+			FaceNormal = -FaceNormal;
+
+		Positions.push_back(P0);
+		Positions.push_back(P1);
+		Positions.push_back(P2);
+		Normals.push_back(FaceNormal);
+	}
+}
+
+void ProbePlacementBVH::Build(const ProbePlacementGeometry& InGeometry)
+{
+	Geometry = &InGeometry;
+
+	const uint32_t NumTriangles = InGeometry.GetNumTriangles();
+	TriangleIndices.resize(NumTriangles);
+	std::vector<glm::vec3> Centroids(NumTriangles);
+	for (uint32_t i = 0; i < NumTriangles; i++)
+	{
+		TriangleIndices[i] = i;
+		Centroids[i] = (InGeometry.Positions[i * 3 + 0] + InGeometry.Positions[i * 3 + 1] + InGeometry.Positions[i * 3 + 2]) / 3.0f;
+	}
+
+	Nodes.clear();
+	Nodes.reserve(size_t(NumTriangles / kMaxLeafTriangles + 1) * 2);
+	if (NumTriangles > 0)
+		BuildNode(0, NumTriangles, Centroids);
+}
+
+uint32_t ProbePlacementBVH::BuildNode(uint32_t First, uint32_t Count, std::vector<glm::vec3>& Centroids)
+{
+	const uint32_t NodeIndex = uint32_t(Nodes.size());
+	Nodes.push_back(Node());
+
+	glm::vec3 Min = glm::vec3(FLT_MAX);
+	glm::vec3 Max = glm::vec3(-FLT_MAX);
+	glm::vec3 CentroidMin = glm::vec3(FLT_MAX);
+	glm::vec3 CentroidMax = glm::vec3(-FLT_MAX);
+	for (uint32_t i = First; i < First + Count; i++)
+	{
+		const uint32_t Tri = TriangleIndices[i];
+		for (uint32_t v = 0; v < 3; v++)
+		{
+			Min = glm::min(Min, Geometry->Positions[Tri * 3 + v]);
+			Max = glm::max(Max, Geometry->Positions[Tri * 3 + v]);
+		}
+		CentroidMin = glm::min(CentroidMin, Centroids[Tri]);
+		CentroidMax = glm::max(CentroidMax, Centroids[Tri]);
+	}
+
+	Nodes[NodeIndex].Min = Min;
+	Nodes[NodeIndex].Max = Max;
+
+	const glm::vec3 Extent = CentroidMax - CentroidMin;
+	const int32_t Axis = Extent.x > Extent.y ? (Extent.x > Extent.z ? 0 : 2) : (Extent.y > Extent.z ? 1 : 2);
+
+	if (Count <= kMaxLeafTriangles || Extent[Axis] <= 0.f)
+	{
+		Nodes[NodeIndex].Offset = First;
+		Nodes[NodeIndex].Count = Count;
+		return NodeIndex;
+	}
+
+	// median split on the longest centroid axis. keeps the tree balanced, which matters more
+	// than node quality for the short probe rays.
+	const uint32_t Mid = First + Count / 2;
+	std::nth_element(TriangleIndices.begin() + First, TriangleIndices.begin() + Mid, TriangleIndices.begin() + First + Count,
+		[&](uint32_t a, uint32_t b) { return Centroids[a][Axis] < Centroids[b][Axis]; });
+
+	BuildNode(First, Mid - First, Centroids);
+	const uint32_t Right = BuildNode(Mid, First + Count - Mid, Centroids);
+
+	Nodes[NodeIndex].Offset = Right;
+	Nodes[NodeIndex].Count = 0;
+	return NodeIndex;
+}
+
+static inline bool IntersectAABB(const glm::vec3& Min, const glm::vec3& Max, const glm::vec3& Origin, const glm::vec3& InvDir, float MaxT)
+{
+	const glm::vec3 T0 = (Min - Origin) * InvDir;
+	const glm::vec3 T1 = (Max - Origin) * InvDir;
+	const glm::vec3 TMin = glm::min(T0, T1);
+	const glm::vec3 TMax = glm::max(T0, T1);
+	const float Enter = std::max(std::max(TMin.x, TMin.y), std::max(TMin.z, 0.f));
+	const float Exit = std::min(std::min(TMax.x, TMax.y), std::min(TMax.z, MaxT));
+	return Enter <= Exit;
+}
+
+bool ProbePlacementBVH::Intersect(const glm::vec3& Origin, const glm::vec3& Dir, float MaxT, Hit& OutHit) const
+{
+	if (Nodes.empty())
+		return false;
+
+	const glm::vec3 InvDir = 1.0f / Dir;
+	float ClosestT = MaxT;
+	int32_t ClosestTri = -1;
+
+	uint32_t Stack[kMaxTraversalDepth];
+	uint32_t StackSize = 0;
+	Stack[StackSize++] = 0;
+
+	while (StackSize > 0)
+	{
+		const Node& N = Nodes[Stack[--StackSize]];
+		if (!IntersectAABB(N.Min, N.Max, Origin, InvDir, ClosestT))
+			continue;
+
+		if (N.Count == 0)
+		{
+			// the median split keeps the depth near log2 of the leaf count.
+			if (StackSize + 2 <= kMaxTraversalDepth)
+			{
+				Stack[StackSize++] = N.Offset;
+				Stack[StackSize++] = uint32_t(&N - Nodes.data()) + 1;
+			}
+			continue;
+		}
+
+		for (uint32_t i = N.Offset; i < N.Offset + N.Count; i++)
+		{
+			const uint32_t Tri = TriangleIndices[i];
+			const glm::vec3& P0 = Geometry->Positions[Tri * 3 + 0];
+			const glm::vec3 E1 = Geometry->Positions[Tri * 3 + 1] - P0;
+			const glm::vec3 E2 = Geometry->Positions[Tri * 3 + 2] - P0;
+
+			// both sides are hit, the side only decides if it counts as a backface.
+			const glm::vec3 PVec = glm::cross(Dir, E2);
+			const float Det = glm::dot(E1, PVec);
+			if (std::abs(Det) < 1e-12f)
+				continue;
+
+			const float InvDet = 1.0f / Det;
+			const glm::vec3 TVec = Origin - P0;
+			const float U = glm::dot(TVec, PVec) * InvDet;
+			if (U < 0.f || U > 1.f)
+				continue;
+
+			const glm::vec3 QVec = glm::cross(TVec, E1);
+			const float V = glm::dot(Dir, QVec) * InvDet;
+			if (V < 0.f || U + V > 1.f)
+				continue;
+
+			const float T = glm::dot(E2, QVec) * InvDet;
+			if (T > 0.f && T < ClosestT)
+			{
+				ClosestT = T;
+				ClosestTri = int32_t(Tri);
+			}
+		}
+	}
+
+	if (ClosestTri < 0)
+		return false;
+
+	OutHit.T = ClosestT;
+	OutHit.bBackface = glm::dot(Geometry->Normals[ClosestTri], Dir) > 0.f;
+	return true;
+}
+
+glm::vec3 GetSphericalFibonacci(float Index, float NumSamples)
+{
+	const float b = (std::sqrt(5.f) * 0.5f + 0.5f) - 1.f;
+	const float Frac = Index * b - std::floor(Index * b);
+	const float Phi = 2.f * glm::pi<float>() * Frac;
+	const float CosTheta = 1.f - (2.f * Index + 1.f) * (1.f / NumSamples);
+	const float SinTheta = std::sqrt(glm::clamp(1.f - (CosTheta * CosTheta), 0.f, 1.f));
+
+	return glm::vec3(std::cos(Phi) * SinTheta, std::sin(Phi) * SinTheta, CosTheta);
+}
+
+struct ProbeRayStats
+{
+	int32_t ClosestBackfaceIndex = -1;
+	int32_t FarthestFrontfaceIndex = -1;
+	float FarthestFrontfaceDistance = 0.f;
+	float ClosestBackfaceDistance = 1e27f;
+	float ClosestFrontfaceDistance = 1e27f;
+	uint32_t BackfaceCount = 0;
+};
+
+// the loop of DDGIProbeRelocationCS over the probe's rays, with the rays traced here.
+static ProbeRayStats TraceProbeRays(const ProbePlacementBVH& BVH, const glm::vec3& Position, const std::vector<glm::vec3>& Directions, float MaxT)
+{
+	ProbeRayStats Stats;
+	for (int32_t RayIndex = 0; RayIndex < int32_t(Directions.size()); RayIndex++)
+	{
+		ProbePlacementBVH::Hit Hit;
+		float HitDistance = kMissDistance;
+		if (BVH.Intersect(Position, Directions[RayIndex], MaxT, Hit))
+		{
+			if (Hit.bBackface)
+			{
+				Stats.BackfaceCount++;
+				if (Hit.T < Stats.ClosestBackfaceDistance)
+				{
+					Stats.ClosestBackfaceDistance = Hit.T;
+					Stats.ClosestBackfaceIndex = RayIndex;
+				}
+				continue;
+			}
+			HitDistance = Hit.T;
+		}
+
+		if (HitDistance < Stats.ClosestFrontfaceDistance)
+		{
+			Stats.ClosestFrontfaceDistance = HitDistance;
+		}
+		else if (HitDistance > Stats.FarthestFrontfaceDistance)
+		{
+			Stats.FarthestFrontfaceDistance = HitDistance;
+			Stats.FarthestFrontfaceIndex = RayIndex;
+		}
+	}
+	return Stats;
+}
+
+void PlaceProbesCPU(const ProbePlacementParams& Params, const ProbeGridDesc& Grid, const ProbePlacementBVH& BVH,
+	std::vector<glm::vec4>& Offsets, std::vector<uint8_t>& States, ProbePlacementStats* OutStats, enki::TaskScheduler* TS)
+{
+	const uint32_t NumProbes = Grid.GetNumProbes();
+	const uint32_t NumIterations = std::max(Params.NumIterations, 1u);
+
+	Offsets.assign(NumProbes, glm::vec4(0.f));
+	States.assign(NumProbes, kProbeStateActive);
+
+	// geometryBounds of DDGIProbeStateClassifierCS, with relocation on.
+	const glm::vec3 GeometryBounds = Grid.Spacing * 2.0f * 1.45f;
+	const float MaxT = glm::max(GeometryBounds.x, glm::max(GeometryBounds.y, GeometryBounds.z));
+	const float MinGeometryBound = glm::min(GeometryBounds.x, glm::min(GeometryBounds.y, GeometryBounds.z));
+
+	// the gpu rotates the ray set every frame, here every iteration. fixed seed so loads are reproducible.
+	std::vector<std::vector<glm::vec3>> Directions(NumIterations);
+	std::mt19937 Rng(1337);
+	std::uniform_real_distribution<float> Uniform(0.f, 1.f);
+	for (uint32_t k = 0; k < NumIterations; k++)
+	{
+		glm::quat Rotation = glm::quat(1, 0, 0, 0);
+		if (k > 0)
+		{
+			const glm::vec3 Axis = glm::normalize(glm::vec3(Uniform(Rng), Uniform(Rng), Uniform(Rng)) * 2.0f - 1.0f + glm::vec3(1e-4f));
+			Rotation = glm::angleAxis(Uniform(Rng) * 2.0f * glm::pi<float>(), Axis);
+		}
+
+		Directions[k].resize(Params.NumRaysPerProbe);
+		for (uint32_t r = 0; r < Params.NumRaysPerProbe; r++)
+			Directions[k][r] = glm::normalize(Rotation * GetSphericalFibonacci(float(r), float(Params.NumRaysPerProbe)));
+	}
+
+	std::vector<uint32_t> NumTraces(NumProbes, 0);
+
+	ParallelForRows(TS, NumProbes, [&](uint32_t Start, uint32_t End)
+	{
+		for (uint32_t ProbeIndex = Start; ProbeIndex < End; ProbeIndex++)
+		{
+			const glm::vec3 BasePosition = GetProbeWorldPosition(ProbeIndex, Grid);
+			glm::vec3 CurrentOffset = glm::vec3(0.f);
+			ProbeRayStats Stats;
+			bool bStatsCurrent = false;
+
+			for (uint32_t k = 0; k < NumIterations; k++)
+			{
+				Stats = TraceProbeRays(BVH, BasePosition + CurrentOffset, Directions[k], MaxT);
+				NumTraces[ProbeIndex]++;
+				bStatsCurrent = true;
+
+				// ProbeDistanceScale of DDGIProbeRelocationCS, shrinking so the probe settles.
+				const float ProbeDistanceScale = 1.0f - float(k) / float(NumIterations);
+				const std::vector<glm::vec3>& Dirs = Directions[k];
+
+				glm::vec3 FullOffset = glm::vec3(1e27f);
+				if (Stats.ClosestBackfaceIndex != -1 && float(Stats.BackfaceCount) / Params.NumRaysPerProbe > Params.BackfaceThreshold)
+				{
+					// mostly backfaces, the probe is inside geometry. step through the closest one.
+					const glm::vec3 ClosestBackfaceDirection = Stats.ClosestBackfaceDistance * Dirs[Stats.ClosestBackfaceIndex];
+					FullOffset = CurrentOffset + ClosestBackfaceDirection * (ProbeDistanceScale + 1.f);
+				}
+				else if (Stats.ClosestFrontfaceDistance < Params.MinFrontfaceDistance && Stats.FarthestFrontfaceIndex != -1)
+				{
+					// too close to a surface, step towards the most open direction without passing it.
+					const glm::vec3 FarthestDirection = std::min(Stats.FarthestFrontfaceDistance, 1.f) * Dirs[Stats.FarthestFrontfaceIndex];
+					FullOffset = CurrentOffset + FarthestDirection * ProbeDistanceScale;
+				}
+
+				// a probe never leaves its cell.
+				if (!glm::all(glm::lessThan(glm::abs(FullOffset), 0.45f * Grid.Spacing)))
+					break;
+
+				CurrentOffset = FullOffset;
+				bStatsCurrent = false;
+			}
+
+			// the last step was not traced from yet.
+			if (!bStatsCurrent)
+			{
+				Stats = TraceProbeRays(BVH, BasePosition + CurrentOffset, Directions[0], MaxT);
+				NumTraces[ProbeIndex]++;
+			}
+
+			// unlike DDGIProbeStateClassifierCS, a probe still inside geometry is final here. it goes inactive.
+			const bool bInside = float(Stats.BackfaceCount) / Params.NumRaysPerProbe >= Params.BackfaceThreshold;
+			const bool bNearGeometry = Stats.ClosestFrontfaceDistance <= MinGeometryBound;
+
+			Offsets[ProbeIndex] = glm::vec4(CurrentOffset / Grid.Spacing, 0.f);
+			States[ProbeIndex] = (!bInside && bNearGeometry) ? kProbeStateActive : kProbeStateInactive;
+		}
+	});
+
+	if (OutStats)
+	{
+		*OutStats = ProbePlacementStats();
+		OutStats->NumProbes = NumProbes;
+		for (uint32_t i = 0; i < NumProbes; i++)
+		{
+			OutStats->NumMoved += glm::any(glm::notEqual(glm::vec3(Offsets[i]), glm::vec3(0.f))) ? 1 : 0;
+			OutStats->NumInactive += States[i] == kProbeStateInactive ? 1 : 0;
+			OutStats->NumRays += uint64_t(NumTraces[i]) * Params.NumRaysPerProbe;
+		}
+	}
+}
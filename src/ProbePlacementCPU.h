@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+#include "ProbeScheduler.h"
+
+namespace enki
+{
+	class TaskScheduler;
+}
+
+// world space triangles the probe placement casts rays against.
+struct ProbePlacementGeometry
+{
+	// 3 per triangle.
+	std::vector<glm::vec3> Positions;
+	// one per triangle, on the side of the vertex normals. TraceProbe.hlsl calls a hit a backface
+	// when the interpolated vertex normal faces along the ray.
+	std::vector<glm::vec3> Normals;
+
+	void AddMesh(const std::vector<glm::vec3>& InPositions, const std::vector<glm::vec3>& InNormals,
+		const std::vector<uint16_t>& Indices, const glm::mat4x4& Transform);
+
+	uint32_t GetNumTriangles() const { return uint32_t(Normals.size()); }
+};
+
+// bounding volume hierarchy over a ProbePlacementGeometry, closest hit queries only.
+class ProbePlacementBVH
+{
+public:
+	struct Hit
+	{
+		float T = 0.f;
+		bool bBackface = false;
+	};
+
+	void Build(const ProbePlacementGeometry& InGeometry);
+
+	// closest hit in (0, MaxT). Dir does not need to be normalized, T is in units of Dir.
+	bool Intersect(const glm::vec3& Origin, const glm::vec3& Dir, float MaxT, Hit& OutHit) const;
+
+	uint32_t GetNumNodes() const { return uint32_t(Nodes.size()); }
+
+private:
+	struct Node
+	{
+		glm::vec3 Min;
+		// first triangle of a leaf, right child of an inner node. the left child follows the node.
+		uint32_t Offset;
+		glm::vec3 Max;
+		// 0 for inner nodes.
+		uint32_t Count;
+	};
+
+	uint32_t BuildNode(uint32_t First, uint32_t Count, std::vector<glm::vec3>& Centroids);
+
+	const ProbePlacementGeometry* Geometry = nullptr;
+	std::vector<Node> Nodes;
+	std::vector<uint32_t> TriangleIndices;
+};
+
+struct ProbePlacementParams
+{
+	// DDGIVolumeDesc values, so the cpu result matches what the gpu passes would converge to.
+	uint32_t NumRaysPerProbe = 144;
+	float BackfaceThreshold = 0.25f;
+	float MinFrontfaceDistance = 1.0f;
+	// relocation steps, each with its own ray rotation and a shrinking distance scale.
+	uint32_t NumIterations = 4;
+};
+
+struct ProbePlacementStats
+{
+	uint32_t NumProbes = 0;
+	uint32_t NumMoved = 0;
+	// probes left inside geometry or with nothing around them.
+	uint32_t NumInactive = 0;
+	uint64_t NumRays = 0;
+};
+
+// PROBE_STATE_ACTIVE and PROBE_STATE_INACTIVE of ProbeCommon.hlsl
+const uint8_t kProbeStateActive = 0;
+const uint8_t kProbeStateInactive = 1;
+
+// cpu version of DDGIProbeRelocationCS and DDGIProbeStateClassifierCS, run before the first frame.
+// Offsets and States are in storage index order, which is also the texel order of the offsets and
+// states textures. Offsets are in units of the probe spacing like the offsets texture.
+// rays stop at the classifier search bound, so backfaces farther away than that are not counted.
+void PlaceProbesCPU(const ProbePlacementParams& Params, const ProbeGridDesc& Grid, const ProbePlacementBVH& BVH,
+	std::vector<glm::vec4>& Offsets, std::vector<uint8_t>& States, ProbePlacementStats* OutStats, enki::TaskScheduler* TS);
+
+// DDGISphericalFibonacci of ProbeCommon.hlsl
+glm::vec3 GetSphericalFibonacci(float Index, float NumSamples);
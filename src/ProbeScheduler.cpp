@@ -0,0 +1,152 @@
+#include "ProbeScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+glm::ivec3 GetProbeCoords(uint32_t ProbeIndex, const glm::ivec3& Counts)
+{
+	const int32_t Index = int32_t(ProbeIndex);
+	return glm::ivec3(Index % Counts.x, Index / (Counts.x * Counts.z), (Index / Counts.x) % Counts.z);
+}
+
+uint32_t GetProbeIndex(const glm::ivec3& ProbeCoords, const glm::ivec3& Counts)
+{
+	return uint32_t(ProbeCoords.x + Counts.x * ProbeCoords.z + Counts.x * Counts.z * ProbeCoords.y);
+}
+
+glm::ivec3 GetScrollingProbeCoords(const glm::ivec3& GridCoords, const glm::ivec3& Counts, const glm::ivec3& ScrollOffsets)
+{
+	return (GridCoords + ScrollOffsets) % Counts;
+}
+
+glm::ivec3 GetUnscrolledProbeCoords(const glm::ivec3& StorageCoords, const glm::ivec3& Counts, const glm::ivec3& ScrollOffsets)
+{
+	return (StorageCoords - ScrollOffsets + Counts) % Counts;
+}
+
+glm::vec3 GetProbeWorldPosition(uint32_t ProbeIndex, const ProbeGridDesc& Grid)
+{
+	const glm::vec3 Coords = glm::vec3(GetUnscrolledProbeCoords(GetProbeCoords(ProbeIndex, Grid.Counts), Grid.Counts, Grid.ScrollOffsets));
+	const glm::vec3 GridShift = Grid.Spacing * glm::vec3(Grid.Counts - 1) * 0.5f;
+	return Grid.Origin + Coords * Grid.Spacing - GridShift;
+}
+
+void ProbeScheduler::Init(uint32_t NumProbes)
+{
+	// every probe starts starving so the first frames cover the whole volume.
+	Age.assign(NumProbes, UINT32_MAX / 2);
+	Changed.assign(NumProbes, 1);
+	Forced.assign(NumProbes, 0);
+	NumForced = 0;
+	Priority.assign(NumProbes, 0.f);
+	Tier.assign(NumProbes, 0);
+	Order.resize(NumProbes);
+	Scheduled.clear();
+}
+
+void ProbeScheduler::InvalidateAll()
+{
+	std::fill(Changed.begin(), Changed.end(), uint8_t(1));
+}
+
+void ProbeScheduler::MarkChanged(const ProbeGridDesc& Grid, const glm::vec3& BoxMin, const glm::vec3& BoxMax)
+{
+	// probes within one cell of the box see the change.
+	const glm::vec3 Min = BoxMin - Grid.Spacing;
+	const glm::vec3 Max = BoxMax + Grid.Spacing;
+
+	for (uint32_t i = 0; i < GetNumProbes(); i++)
+	{
+		const glm::vec3 P = GetProbeWorldPosition(i, Grid);
+		if (glm::all(glm::greaterThanEqual(P, Min)) && glm::all(glm::lessThanEqual(P, Max)))
+			Changed[i] = 1;
+	}
+}
+
+void ProbeScheduler::ForceSchedule(const std::vector<uint32_t>& ProbeIndices)
+{
+	for (uint32_t i : ProbeIndices)
+	{
+		NumForced += Forced[i] ? 0 : 1;
+		Forced[i] = 1;
+	}
+}
+
+uint32_t ProbeScheduler::GetNumScheduledProbes(uint32_t NumProbes, float UpdateFraction)
+{
+	const float Fraction = std::min(std::max(UpdateFraction, 0.f), 1.f);
+	return std::min(NumProbes, std::max(1u, uint32_t(std::ceil(NumProbes * Fraction))));
+}
+
+float ProbeScheduler::GetCompensatedHysteresis(float Hysteresis, float UpdateFraction)
+{
+	const float Fraction = std::min(std::max(UpdateFraction, 0.0001f), 1.f);
+	return std::pow(Hysteresis, 1.0f / Fraction);
+}
+
+const std::vector<uint32_t>& ProbeScheduler::Schedule(const ProbeGridDesc& Grid, const ProbeScheduleParams& Params,
+	const glm::vec3& CameraPos, const glm::mat4& ViewProj)
+{
+	const uint32_t NumProbes = GetNumProbes();
+	Scheduled.clear();
+	if (NumProbes == 0)
+		return Scheduled;
+
+	// frustum test in clip space, grown by a probe spacing so probes lighting the screen edge count.
+	const float Margin = glm::length(Grid.Spacing);
+
+	for (uint32_t i = 0; i < NumProbes; i++)
+	{
+		Age[i] = std::min(Age[i] + 1, UINT32_MAX / 2);
+
+		const glm::vec3 P = GetProbeWorldPosition(i, Grid);
+
+		const float Distance = glm::length(P - CameraPos);
+		const float Near = 1.0f - std::min(Distance / std::max(Params.NearDistance, 0.0001f), 1.f);
+		float Weight = 1.0f + (Params.NearWeight - 1.0f) * Near;
+
+		const glm::vec4 Clip = ViewProj * glm::vec4(P, 1.f);
+		const float Extent = Clip.w + Margin;
+		if (Clip.w > -Margin && std::abs(Clip.x) <= Extent && std::abs(Clip.y) <= Extent)
+			Weight *= Params.VisibleWeight;
+
+		// forced probes first, then changed and starving ones, each tier ordered by its score.
+		if (Forced[i])
+			Tier[i] = 3;
+		else if (Changed[i])
+			Tier[i] = 2;
+		else if (Age[i] >= Params.MaxAge)
+			Tier[i] = 1;
+		else
+			Tier[i] = 0;
+
+		Priority[i] = float(Age[i]) * Weight;
+		Order[i] = i;
+	}
+
+	const uint32_t NumScheduled = std::max(GetNumScheduledProbes(NumProbes, Params.UpdateFraction), NumForced);
+
+	auto HigherPriority = [&](uint32_t a, uint32_t b)
+	{
+		if (Tier[a] != Tier[b])
+			return Tier[a] > Tier[b];
+		if (Priority[a] != Priority[b])
+			return Priority[a] > Priority[b];
+		return a < b;
+	};
+
+	std::nth_element(Order.begin(), Order.begin() + (NumScheduled - 1), Order.end(), HigherPriority);
+
+	Scheduled.assign(Order.begin(), Order.begin() + NumScheduled);
+	std::sort(Scheduled.begin(), Scheduled.end());
+
+	for (uint32_t i : Scheduled)
+	{
+		Age[i] = 0;
+		Changed[i] = 0;
+		Forced[i] = 0;
+	}
+	NumForced = 0;
+
+	return Scheduled;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// probe grid of a ddgi volume. probe indices follow the rtxgi left/right handed layout,
+// x fastest, then z, then y.
+struct ProbeGridDesc
+{
+	glm::vec3 Origin = glm::vec3(0.f);
+	glm::ivec3 Counts = glm::ivec3(0);
+	glm::vec3 Spacing = glm::vec3(0.f);
+	// ring offset of a scrolling volume, in [0, Counts). see DDGICascades.h.
+	glm::ivec3 ScrollOffsets = glm::ivec3(0);
+
+	uint32_t GetNumProbes() const { return uint32_t(Counts.x * Counts.y * Counts.z); }
+};
+
+// DDGIGetProbeCoords of ProbeCommon.hlsl
+glm::ivec3 GetProbeCoords(uint32_t ProbeIndex, const glm::ivec3& Counts);
+
+// DDGIGetProbeIndex of ProbeCommon.hlsl
+uint32_t GetProbeIndex(const glm::ivec3& ProbeCoords, const glm::ivec3& Counts);
+
+// DDGIGetScrollingProbeCoords of ProbeCommon.hlsl, grid coordinates to storage coordinates.
+glm::ivec3 GetScrollingProbeCoords(const glm::ivec3& GridCoords, const glm::ivec3& Counts, const glm::ivec3& ScrollOffsets);
+
+// DDGIGetUnscrolledProbeCoords of ProbeCommon.hlsl, storage coordinates to grid coordinates.
+glm::ivec3 GetUnscrolledProbeCoords(const glm::ivec3& StorageCoords, const glm::ivec3& Counts, const glm::ivec3& ScrollOffsets);
+
+// DDGIGetProbeWorldPosition of ProbeCommon.hlsl, without the relocation offset. ProbeIndex is a storage index.
+glm::vec3 GetProbeWorldPosition(uint32_t ProbeIndex, const ProbeGridDesc& Grid);
+
+struct ProbeScheduleParams
+{
+	// share of the probes traced per frame.
+	float UpdateFraction = 0.25f;
+	// probes up to NearDistance from the camera get up to NearWeight times the priority.
+	float NearDistance = 1000.0f;
+	float NearWeight = 4.0f;
+	// probes inside the view frustum, grown by one probe spacing.
+	float VisibleWeight = 2.0f;
+	// probes waiting this many frames are updated before anything else.
+	uint32_t MaxAge = 16;
+};
+
+// picks the ddgi probes traced each frame. every probe ages one frame per Schedule call and its
+// priority is its age scaled by camera distance and visibility. changed and starving probes go first.
+// ties are broken by probe index so a sequence of calls is deterministic.
+class ProbeScheduler
+{
+public:
+	void Init(uint32_t NumProbes);
+
+	// lighting changed everywhere, e.g. the sun moved.
+	void InvalidateAll();
+
+	// lighting changed inside the box, e.g. an object moved.
+	void MarkChanged(const ProbeGridDesc& Grid, const glm::vec3& BoxMin, const glm::vec3& BoxMax);
+
+	// probes with no valid history, e.g. scrolled into a volume. they are all traced on the next
+	// Schedule call even if that exceeds the update fraction.
+	void ForceSchedule(const std::vector<uint32_t>& ProbeIndices);
+
+	// probe indices to trace this frame, sorted ascending.
+	const std::vector<uint32_t>& Schedule(const ProbeGridDesc& Grid, const ProbeScheduleParams& Params,
+		const glm::vec3& CameraPos, const glm::mat4& ViewProj);
+
+	uint32_t GetNumProbes() const { return uint32_t(Age.size()); }
+
+	// frames since the probe was last traced.
+	uint32_t GetAge(uint32_t ProbeIndex) const { return Age[ProbeIndex]; }
+
+	const std::vector<uint32_t>& GetScheduledProbes() const { return Scheduled; }
+
+	// probes are blended once per 1 / UpdateFraction frames on average, so the per update hysteresis
+	// is raised to that power to keep the per frame response of Hysteresis.
+	static float GetCompensatedHysteresis(float Hysteresis, float UpdateFraction);
+
+	static uint32_t GetNumScheduledProbes(uint32_t NumProbes, float UpdateFraction);
+
+private:
+	std::vector<uint32_t> Age;
+	std::vector<uint8_t> Changed;
+	std::vector<uint8_t> Forced;
+	uint32_t NumForced = 0;
+	std::vector<float> Priority;
+	std::vector<uint8_t> Tier;
+	std::vector<uint32_t> Order;
+	std::vector<uint32_t> Scheduled;
+};
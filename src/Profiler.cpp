@@ -0,0 +1,327 @@
+#include "Profiler.h"
+#include "FrameTiming.h"
+
+#include <algorithm>
+#include <fstream>
+
+uint64_t ProfilerNowNs()
+{
+	return SteadyClockNs();
+}
+
+bool ProfilerThreadBuffer::Push(const ProfileEvent& Event)
+{
+	const uint64_t Write = WriteIndex.load(std::memory_order_relaxed);
+	if (Write - ReadIndex.load(std::memory_order_acquire) >= kCapacity)
+	{
+		NumDropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+
+	Events[Write % kCapacity] = Event;
+	WriteIndex.store(Write + 1, std::memory_order_release);
+	return true;
+}
+
+void ProfilerThreadBuffer::Drain(std::vector<ProfileEvent>& Out)
+{
+	const uint64_t Read = ReadIndex.load(std::memory_order_relaxed);
+	const uint64_t Write = WriteIndex.load(std::memory_order_acquire);
+	for (uint64_t i = Read; i < Write; i++)
+		Out.push_back(Events[i % kCapacity]);
+	ReadIndex.store(Write, std::memory_order_release);
+}
+
+CPUProfiler& CPUProfiler::Get()
+{
+	static CPUProfiler Profiler;
+	return Profiler;
+}
+
+ProfilerThreadBuffer* CPUProfiler::GetThreadBuffer()
+{
+	thread_local ProfilerThreadBuffer* Buffer = nullptr;
+	if (Buffer)
+		return Buffer;
+
+	Buffer = new ProfilerThreadBuffer;
+	Buffer->ThreadID = NextThreadID.fetch_add(1, std::memory_order_relaxed);
+	Buffer->ThreadName = "Thread " + std::to_string(Buffer->ThreadID);
+
+	// lock free push to the front of the list, Collect walks it from any thread.
+	ProfilerThreadBuffer* Head = Threads.load(std::memory_order_relaxed);
+	do
+	{
+		Buffer->Next = Head;
+	} while (!Threads.compare_exchange_weak(Head, Buffer, std::memory_order_release, std::memory_order_relaxed));
+
+	return Buffer;
+}
+
+void CPUProfiler::SetThreadName(const char* Name)
+{
+	// read by the collecting thread, set it before the thread's first zone is collected.
+	GetThreadBuffer()->ThreadName = Name;
+}
+
+void CPUProfiler::Collect(std::vector<ProfileEvent>& Out)
+{
+	ForEachThread([&](ProfilerThreadBuffer& Buffer) { Buffer.Drain(Out); });
+}
+
+ProfileCPUZone::ProfileCPUZone(const char* InName)
+{
+	CPUProfiler& Profiler = CPUProfiler::Get();
+	if (!Profiler.IsEnabled())
+	{
+		Buffer = nullptr;
+		return;
+	}
+
+	Buffer = Profiler.GetThreadBuffer();
+	Buffer->Depth++;
+	Name = InName;
+	BeginNs = ProfilerNowNs();
+}
+
+ProfileCPUZone::~ProfileCPUZone()
+{
+	if (!Buffer)
+		return;
+
+	const uint64_t EndNs = ProfilerNowNs();
+	Buffer->Depth--;
+	Buffer->Push({ Name, BeginNs, EndNs, Buffer->Depth, Buffer->ThreadID });
+}
+
+uint32_t ProfileColorFromName(const char* Name)
+{
+	// fnv-1a, then each channel kept in the upper 3/4 of its range so the text stays readable.
+	uint32_t Hash = 2166136261u;
+	for (const char* c = Name; *c; c++)
+		Hash = (Hash ^ uint8_t(*c)) * 16777619u;
+
+	const uint32_t R = 64 + (Hash & 0xff) * 3 / 4;
+	const uint32_t G = 64 + ((Hash >> 8) & 0xff) * 3 / 4;
+	const uint32_t B = 64 + ((Hash >> 16) & 0xff) * 3 / 4;
+	return 0xff000000u | (R << 16) | (G << 8) | B;
+}
+
+void GPUTimestampRing::Init(uint32_t NumFrames, uint32_t InMaxZonesPerFrame)
+{
+	Frames.assign(NumFrames, Frame());
+	MaxZonesPerFrame = InMaxZonesPerFrame;
+	CurrentFrame = 0;
+}
+
+void GPUTimestampRing::BeginFrame(uint32_t FrameIndex)
+{
+	CurrentFrame = FrameIndex;
+	Frames[CurrentFrame].Zones.clear();
+	Frames[CurrentFrame].Depth = 0;
+	Frames[CurrentFrame].bResolved = false;
+}
+
+uint32_t GPUTimestampRing::BeginZone(const char* Name)
+{
+	Frame& F = Frames[CurrentFrame];
+	if (F.Zones.size() >= MaxZonesPerFrame)
+		return InvalidZone;
+
+	F.Zones.push_back({ Name, F.Depth++, false });
+	return uint32_t(F.Zones.size() - 1);
+}
+
+void GPUTimestampRing::EndZone(uint32_t Zone)
+{
+	if (Zone == InvalidZone)
+		return;
+
+	Frame& F = Frames[CurrentFrame];
+	F.Zones[Zone].bClosed = true;
+	F.Depth--;
+}
+
+void GPUTimestampRing::Resolve(uint32_t FrameIndex, const uint64_t* Timestamps, uint64_t Frequency,
+	uint64_t GPUTicksAt, uint64_t CPUNsAt, std::vector<GPUZoneTiming>& Out) const
+{
+	const Frame& F = Frames[FrameIndex];
+	if (Frequency == 0 || !F.bResolved)
+		return;
+
+	auto ToNs = [&](uint64_t Ticks)
+	{
+		const double Seconds = (double(Ticks) - double(GPUTicksAt)) / double(Frequency);
+		return uint64_t(std::max(double(CPUNsAt) + Seconds * 1e9, 0.0));
+	};
+
+	for (size_t i = 0; i < F.Zones.size(); i++)
+	{
+		const Zone& Z = F.Zones[i];
+		if (!Z.bClosed)
+			continue;
+
+		const uint64_t Begin = Timestamps[i * 2];
+		const uint64_t End = std::max(Timestamps[i * 2 + 1], Begin);
+		Out.push_back({ Z.Name, ToNs(Begin), ToNs(End), Z.Depth });
+	}
+}
+
+void ProfilerStats::AddSample(const char* Name, uint32_t Depth, double Ms)
+{
+	for (auto& Sample : FrameSamples)
+	{
+		if (Sample.first == Name)
+		{
+			Sample.second += Ms;
+			return;
+		}
+	}
+
+	FrameSamples.push_back({ Name, Ms });
+	Zones[Name].Stats.Depth = Depth;
+}
+
+void ProfilerStats::EndFrame()
+{
+	Ordered.clear();
+	Ordered.reserve(FrameSamples.size());
+
+	for (auto& Sample : FrameSamples)
+	{
+		History& H = Zones[Sample.first];
+		H.Samples[H.Next] = float(Sample.second);
+		H.Next = (H.Next + 1) % kWindow;
+		H.NumSamples = std::min(H.NumSamples + 1, kWindow);
+
+		float Min = H.Samples[0], Max = H.Samples[0], Sum = 0.f;
+		for (uint32_t i = 0; i < H.NumSamples; i++)
+		{
+			Min = std::min(Min, H.Samples[i]);
+			Max = std::max(Max, H.Samples[i]);
+			Sum += H.Samples[i];
+		}
+
+		// nearest rank, a partial sort of the window is enough for one percentile.
+		float Sorted[kWindow];
+		std::copy(H.Samples, H.Samples + H.NumSamples, Sorted);
+		const uint32_t P95Rank = std::max((H.NumSamples * 95 + 99) / 100, 1u) - 1;
+		std::nth_element(Sorted, Sorted + P95Rank, Sorted + H.NumSamples);
+
+		H.Stats.Name = Sample.first;
+		H.Stats.LastMs = float(Sample.second);
+		H.Stats.MinMs = Min;
+		H.Stats.MaxMs = Max;
+		H.Stats.AvgMs = Sum / H.NumSamples;
+		H.Stats.P95Ms = Sorted[P95Rank];
+		Ordered.push_back(H.Stats);
+	}
+
+	FrameSamples.clear();
+}
+
+void ChromeTraceWriter::Clear()
+{
+	Events.clear();
+	TrackNames.clear();
+}
+
+void ChromeTraceWriter::SetTrackName(uint32_t TrackID, const std::string& Name)
+{
+	TrackNames[TrackID] = Name;
+}
+
+void ChromeTraceWriter::AddEvent(const char* Name, const char* Category, uint32_t TrackID, uint64_t BeginNs, uint64_t EndNs)
+{
+	Events.push_back({ Name, Category, TrackID, BeginNs, EndNs });
+}
+
+namespace
+{
+	void WriteJsonString(std::ostream& Out, const std::string& Value)
+	{
+		Out << '"';
+		for (char c : Value)
+		{
+			switch (c)
+			{
+			case '"': Out << "\\\""; break;
+			case '\\': Out << "\\\\"; break;
+			case '\n': Out << "\\n"; break;
+			case '\r': Out << "\\r"; break;
+			case '\t': Out << "\\t"; break;
+			default:
+				if (uint8_t(c) < 0x20)
+				{
+					static const char Hex[] = "0123456789abcdef";
+					Out << "\\u00" << Hex[(c >> 4) & 0xf] << Hex[c & 0xf];
+				}
+				else
+				{
+					Out << c;
+				}
+			}
+		}
+		Out << '"';
+	}
+
+	// trace timestamps are microseconds, written with the nanoseconds as decimals.
+	void WriteMicroseconds(std::ostream& Out, uint64_t Ns)
+	{
+		const uint64_t Fraction = Ns % 1000;
+		Out << Ns / 1000 << '.' << char('0' + Fraction / 100) << char('0' + Fraction / 10 % 10) << char('0' + Fraction % 10);
+	}
+}
+
+void ChromeTraceWriter::Write(std::ostream& Out) const
+{
+	// relative to the first event, keeps the numbers short.
+	uint64_t BaseNs = Events.empty() ? 0 : Events[0].BeginNs;
+	for (const Event& E : Events)
+		BaseNs = std::min(BaseNs, E.BeginNs);
+
+	Out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+	bool bFirst = true;
+	for (auto& Track : TrackNames)
+	{
+		Out << (bFirst ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << Track.first << ",\"args\":{\"name\":";
+		WriteJsonString(Out, Track.second);
+		Out << "}}";
+		bFirst = false;
+	}
+
+	for (const Event& E : Events)
+	{
+		Out << (bFirst ? "" : ",\n") << "{\"name\":";
+		WriteJsonString(Out, E.Name);
+		Out << ",\"cat\":";
+		WriteJsonString(Out, E.Category);
+		Out << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << E.TrackID << ",\"ts\":";
+		WriteMicroseconds(Out, E.BeginNs - BaseNs);
+		Out << ",\"dur\":";
+		WriteMicroseconds(Out, E.EndNs - E.BeginNs);
+		Out << '}';
+		bFirst = false;
+	}
+
+	Out << "\n]}\n";
+}
+
+bool ChromeTraceWriter::WriteFile(const std::string& Path, std::string& Error) const
+{
+	std::ofstream File(Path, std::ios::binary);
+	if (!File)
+	{
+		Error = "can't open " + Path;
+		return false;
+	}
+
+	Write(File);
+	if (!File)
+	{
+		Error = "can't write " + Path;
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,228 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// frame profiler. cpu zones are recorded per thread into lock free buffers and collected once a frame,
+// gpu zones are timestamp pairs resolved a few frames later. both feed rolling per zone stats and an
+// optional chrome trace (chrome://tracing, ui.perfetto.dev).
+
+// nanoseconds of SteadyClockNs (FrameTiming.h), the time base of every cpu zone. the gpu calibration
+// converts to it, so it stays on the reference clock rather than the cycle counter.
+uint64_t ProfilerNowNs();
+
+// a finished zone. Name has to outlive the profiler, zones are named with string literals.
+struct ProfileEvent
+{
+	const char* Name;
+	uint64_t BeginNs;
+	uint64_t EndNs;
+	uint32_t Depth;
+	uint32_t ThreadID;
+};
+
+// single producer single consumer ring of one thread's finished zones. the owning thread pushes,
+// CPUProfiler::Collect drains it from another thread, neither side takes a lock. a full ring drops
+// the zone and counts it.
+class ProfilerThreadBuffer
+{
+public:
+	static const uint32_t kCapacity = 8192;
+
+	bool Push(const ProfileEvent& Event);
+	void Drain(std::vector<ProfileEvent>& Out);
+
+	uint32_t ThreadID = 0;
+	std::string ThreadName;
+	uint32_t Depth = 0;		// open zones of the owning thread
+	std::atomic<uint32_t> NumDropped{ 0 };
+	ProfilerThreadBuffer* Next = nullptr;
+
+private:
+	std::atomic<uint64_t> WriteIndex{ 0 };
+	std::atomic<uint64_t> ReadIndex{ 0 };
+	ProfileEvent Events[kCapacity];
+};
+
+class CPUProfiler
+{
+public:
+	static CPUProfiler& Get();
+
+	// a thread's buffer is created on its first zone and lives until the process exits.
+	ProfilerThreadBuffer* GetThreadBuffer();
+	void SetThreadName(const char* Name);
+
+	bool IsEnabled() const { return bEnabled.load(std::memory_order_relaxed); }
+	void SetEnabled(bool bInEnabled) { bEnabled.store(bInEnabled, std::memory_order_relaxed); }
+
+	// appends the zones every thread finished since the last call.
+	void Collect(std::vector<ProfileEvent>& Out);
+
+	template<typename FUNC>
+	void ForEachThread(FUNC Func) const
+	{
+		for (ProfilerThreadBuffer* Buffer = Threads.load(std::memory_order_acquire); Buffer; Buffer = Buffer->Next)
+			Func(*Buffer);
+	}
+
+private:
+	std::atomic<ProfilerThreadBuffer*> Threads{ nullptr };
+	std::atomic<uint32_t> NextThreadID{ 0 };
+	std::atomic<bool> bEnabled{ true };
+};
+
+class ProfileCPUZone
+{
+public:
+	explicit ProfileCPUZone(const char* InName);
+	~ProfileCPUZone();
+
+private:
+	ProfilerThreadBuffer* Buffer;
+	const char* Name;
+	uint64_t BeginNs;
+};
+
+#define PROFILER_CONCAT_INNER(a, b) a##b
+#define PROFILER_CONCAT(a, b) PROFILER_CONCAT_INNER(a, b)
+#define ProfileCPUScope(Name) ProfileCPUZone PROFILER_CONCAT(CPUProfileZone_, __LINE__)(Name)
+
+// stable color of a zone name, so a pass keeps its color across frames and captures.
+uint32_t ProfileColorFromName(const char* Name);
+
+// gpu zone after its timestamps were read back, in the time base of ProfilerNowNs.
+struct GPUZoneTiming
+{
+	const char* Name;
+	uint64_t BeginNs;
+	uint64_t EndNs;
+	uint32_t Depth;
+};
+
+// assigns timestamp query pairs to the gpu zones of each frame in flight. frame f owns queries
+// [f * MaxZonesPerFrame * 2, (f + 1) * MaxZonesPerFrame * 2), zone z of it the pair 2z, 2z + 1. the
+// graphics api writes and resolves the queries, Resolve turns them into timings once the frame retired.
+class GPUTimestampRing
+{
+public:
+	static const uint32_t InvalidZone = 0xffffffff;
+
+	void Init(uint32_t NumFrames, uint32_t InMaxZonesPerFrame);
+
+	uint32_t GetNumQueries() const { return uint32_t(Frames.size()) * MaxZonesPerFrame * 2; }
+
+	// forgets the zones of FrameIndex, call after its previous use was resolved.
+	void BeginFrame(uint32_t FrameIndex);
+
+	// returns the zone, InvalidZone when the frame ran out of queries.
+	uint32_t BeginZone(const char* Name);
+	void EndZone(uint32_t Zone);
+	uint32_t GetBeginQuery(uint32_t Zone) const { return (CurrentFrame * MaxZonesPerFrame + Zone) * 2; }
+	uint32_t GetEndQuery(uint32_t Zone) const { return GetBeginQuery(Zone) + 1; }
+
+	// range of the current frame's written queries.
+	uint32_t GetFirstQuery() const { return CurrentFrame * MaxZonesPerFrame * 2; }
+	uint32_t GetNumFrameQueries() const { return uint32_t(Frames[CurrentFrame].Zones.size()) * 2; }
+
+	// the current frame's queries were resolved and can be read once the frame retired.
+	void MarkResolved() { Frames[CurrentFrame].bResolved = true; }
+
+	// Timestamps holds the frame's queries starting at its first one. GPUTicksAt and CPUNsAt are one
+	// calibrated pair of clock readings. a frame that wasn't resolved adds nothing.
+	void Resolve(uint32_t FrameIndex, const uint64_t* Timestamps, uint64_t Frequency,
+		uint64_t GPUTicksAt, uint64_t CPUNsAt, std::vector<GPUZoneTiming>& Out) const;
+
+private:
+	struct Zone
+	{
+		const char* Name;
+		uint32_t Depth;
+		bool bClosed;
+	};
+
+	struct Frame
+	{
+		std::vector<Zone> Zones;
+		uint32_t Depth = 0;
+		bool bResolved = false;
+	};
+
+	std::vector<Frame> Frames;
+	uint32_t MaxZonesPerFrame = 0;
+	uint32_t CurrentFrame = 0;
+};
+
+// rolling min / avg / p95 / max of each zone over the last kWindow frames it appeared in. a zone entered
+// several times in one frame counts with the sum of its durations.
+class ProfilerStats
+{
+public:
+	static const uint32_t kWindow = 120;
+
+	struct ZoneStats
+	{
+		std::string Name;
+		uint32_t Depth = 0;
+		float LastMs = 0.f;
+		float MinMs = 0.f;
+		float AvgMs = 0.f;
+		float P95Ms = 0.f;
+		float MaxMs = 0.f;
+	};
+
+	void AddSample(const char* Name, uint32_t Depth, double Ms);
+	// closes the frame and refreshes the stats of the zones it saw.
+	void EndFrame();
+
+	// zones in the order of their first appearance within the last frame, i.e. in call order.
+	const std::vector<ZoneStats>& GetStats() const { return Ordered; }
+
+private:
+	struct History
+	{
+		float Samples[kWindow] = {};
+		uint32_t NumSamples = 0;
+		uint32_t Next = 0;
+		ZoneStats Stats;
+	};
+
+	std::map<std::string, History> Zones;
+	std::vector<std::pair<std::string, double>> FrameSamples;
+	std::vector<ZoneStats> Ordered;
+};
+
+// builds a chrome trace event file, one complete ("X") event per zone.
+class ChromeTraceWriter
+{
+public:
+	// the gpu gets its own track next to the cpu threads.
+	static const uint32_t kGPUTrackID = 0xffff;
+
+	void Clear();
+	void SetTrackName(uint32_t TrackID, const std::string& Name);
+	void AddEvent(const char* Name, const char* Category, uint32_t TrackID, uint64_t BeginNs, uint64_t EndNs);
+
+	size_t GetNumEvents() const { return Events.size(); }
+
+	void Write(std::ostream& Out) const;
+	bool WriteFile(const std::string& Path, std::string& Error) const;
+
+private:
+	struct Event
+	{
+		const char* Name;
+		const char* Category;
+		uint32_t TrackID;
+		uint64_t BeginNs;
+		uint64_t EndNs;
+	};
+
+	std::vector<Event> Events;
+	std::map<uint32_t, std::string> TrackNames;
+};
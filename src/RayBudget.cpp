@@ -0,0 +1,256 @@
+#include "RayBudget.h"
+
+#include <cmath>
+#include <algorithm>
+
+// rotation of the traced pixel inside a cell. every position once per period.
+static const RayBudgetPoint kQuarterOffsets[4] = { {0, 0}, {1, 1}, {1, 0}, {0, 1} };
+static const RayBudgetPoint kNinthOffsets[9] = { {0, 0}, {2, 1}, {1, 2}, {2, 0}, {0, 2}, {1, 1}, {2, 2}, {0, 1}, {1, 0} };
+
+RayBudgetPoint GetRayBudgetCellSize(ERayBudgetMode Mode)
+{
+	switch (Mode)
+	{
+	case RAY_BUDGET_CHECKERBOARD:
+		return { 2, 1 };
+	case RAY_BUDGET_QUARTER:
+		return { 2, 2 };
+	case RAY_BUDGET_NINTH:
+		return { 3, 3 };
+	default:
+		return { 1, 1 };
+	}
+}
+
+RayBudgetPoint GetRayDispatchSize(ERayBudgetMode Mode, uint32_t Width, uint32_t Height)
+{
+	RayBudgetPoint CellSize = GetRayBudgetCellSize(Mode);
+	return { (Width + CellSize.x - 1) / CellSize.x, (Height + CellSize.y - 1) / CellSize.y };
+}
+
+RayBudgetPoint GetTracedPixel(ERayBudgetMode Mode, uint32_t CellX, uint32_t CellY, uint32_t FrameIndex)
+{
+	RayBudgetPoint CellSize = GetRayBudgetCellSize(Mode);
+	RayBudgetPoint Offset = { 0, 0 };
+
+	if (Mode == RAY_BUDGET_CHECKERBOARD)
+		Offset = { (CellY + FrameIndex) & 1, 0 };
+	else if (Mode == RAY_BUDGET_QUARTER)
+		Offset = kQuarterOffsets[FrameIndex % 4];
+	else if (Mode == RAY_BUDGET_NINTH)
+		Offset = kNinthOffsets[FrameIndex % 9];
+
+	return { CellX * CellSize.x + Offset.x, CellY * CellSize.y + Offset.y };
+}
+
+bool IsTracedPixel(ERayBudgetMode Mode, uint32_t x, uint32_t y, uint32_t FrameIndex)
+{
+	RayBudgetPoint CellSize = GetRayBudgetCellSize(Mode);
+	RayBudgetPoint Traced = GetTracedPixel(Mode, x / CellSize.x, y / CellSize.y, FrameIndex);
+	return Traced.x == x && Traced.y == y;
+}
+
+ERayBudgetMode ClassifyRayBudgetTile(const RayBudgetClassifyCB& CB, const RayBudgetTileStats& Stats)
+{
+	if (Stats.Disocclusion > CB.DisocclusionRatio || Stats.Variance > CB.HighVariance)
+		return RAY_BUDGET_FULL;
+
+	if (Stats.Variance > CB.LowVariance || Stats.History < CB.ConvergedHistory)
+		return RAY_BUDGET_CHECKERBOARD;
+
+	return Stats.Roughness > CB.RoughThreshold ? RAY_BUDGET_NINTH : RAY_BUDGET_QUARTER;
+}
+
+static inline float Luminance(const glm::vec4& Color)
+{
+	return glm::dot(glm::vec3(Color), glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+static inline float CoefficientOfVariation(float Sum, float SumSq, float Count)
+{
+	const float Mean = Sum / Count;
+	const float Variance = std::max(SumSq / Count - Mean * Mean, 0.f);
+	return std::sqrt(Variance) / (std::abs(Mean) + 0.0001f);
+}
+
+void ClassifyRayBudgetTilesCPU(const RayBudgetClassifyCB& CB, const DenoiserImage& Specular, const DenoiserImage& DiffuseSH,
+	const DenoiserImage& Velocity, const DenoiserImage& Roughness, std::vector<uint8_t>& TileModes,
+	std::vector<RayBudgetTileStats>* OutStats, enki::TaskScheduler* TS)
+{
+	const int32_t Width = int32_t(CB.RTSize.x);
+	const int32_t Height = int32_t(CB.RTSize.y);
+
+	TileModes.resize(size_t(CB.NumTilesX) * CB.NumTilesY);
+	if (OutStats)
+		OutStats->resize(TileModes.size());
+
+	ParallelForRows(TS, CB.NumTilesY, [&](uint32_t StartRow, uint32_t EndRow)
+	{
+		for (uint32_t TileY = StartRow; TileY < EndRow; TileY++)
+		{
+			for (uint32_t TileX = 0; TileX < CB.NumTilesX; TileX++)
+			{
+				float SpecSum = 0.f, SpecSumSq = 0.f, DiffSum = 0.f, DiffSumSq = 0.f;
+				float HistorySum = 0.f, Disoccluded = 0.f, RoughnessSum = 0.f, Count = 0.f;
+
+				for (uint32_t j = 0; j < kRayBudgetTileSize; j++)
+				{
+					for (uint32_t i = 0; i < kRayBudgetTileSize; i++)
+					{
+						const int32_t x = int32_t(TileX * kRayBudgetTileSize + i);
+						const int32_t y = int32_t(TileY * kRayBudgetTileSize + j);
+						if (x >= Width || y >= Height)
+							continue;
+
+						// history follows the pixel, so it is fetched at the reprojected position.
+						const glm::vec2 Vel = glm::vec2(Velocity.Load(x, y));
+						const int32_t PrevX = int32_t(std::floor(x + 0.5f - Vel.x * CB.RTSize.x));
+						const int32_t PrevY = int32_t(std::floor(y + 0.5f - Vel.y * CB.RTSize.y));
+
+						const glm::vec4 Spec = Specular.Load(PrevX, PrevY);
+						const float History = Spec.w * 10.0f;
+						const float SpecLuma = Luminance(Spec);
+						const float DiffLuma = DiffuseSH.Load(PrevX, PrevY).w;
+
+						SpecSum += SpecLuma;
+						SpecSumSq += SpecLuma * SpecLuma;
+						DiffSum += DiffLuma;
+						DiffSumSq += DiffLuma * DiffLuma;
+						HistorySum += History;
+						Disoccluded += History < 1.0f ? 1.f : 0.f;
+						RoughnessSum += Roughness.Load(x, y).x;
+						Count += 1.f;
+					}
+				}
+
+				RayBudgetTileStats Stats;
+				if (Count > 0.f)
+				{
+					Stats.Variance = std::max(CoefficientOfVariation(SpecSum, SpecSumSq, Count), CoefficientOfVariation(DiffSum, DiffSumSq, Count));
+					Stats.History = HistorySum / Count;
+					Stats.Disocclusion = Disoccluded / Count;
+					Stats.Roughness = RoughnessSum / Count;
+				}
+
+				const size_t TileIndex = size_t(TileY) * CB.NumTilesX + TileX;
+				TileModes[TileIndex] = uint8_t(ClassifyRayBudgetTile(CB, Stats));
+				if (OutStats)
+					(*OutStats)[TileIndex] = Stats;
+			}
+		}
+	});
+}
+
+uint64_t CountRayBudgetRays(const std::vector<uint8_t>& TileModes, uint32_t NumTilesX, uint32_t Width, uint32_t Height, uint32_t FrameIndex)
+{
+	uint64_t NumRays = 0;
+	for (uint32_t y = 0; y < Height; y++)
+	{
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			ERayBudgetMode Mode = ERayBudgetMode(TileModes[size_t(y / kRayBudgetTileSize) * NumTilesX + x / kRayBudgetTileSize]);
+			NumRays += IsTracedPixel(Mode, x, y, FrameIndex) ? 1 : 0;
+		}
+	}
+	return NumRays;
+}
+
+static inline float GetLinearDepth(float DeviceDepth, float Near, float Far)
+{
+	return Near * Far / (Far + Near - DeviceDepth * (Far - Near));
+}
+
+void ReconstructRayBudgetCPU(const RayReconstructCB& CB, const DenoiserImage& Depth, const DenoiserImage& Normal,
+	DenoiserImage& Image, const std::vector<uint8_t>* TileModes, enki::TaskScheduler* TS)
+{
+	if (CB.RayBudgetMode == RAY_BUDGET_FULL)
+		return;
+
+	const uint32_t NumTilesX = (CB.RTWidth + kRayBudgetTileSize - 1) / kRayBudgetTileSize;
+	auto GetMode = [&](uint32_t x, uint32_t y)
+	{
+		if (CB.RayBudgetMode == RAY_BUDGET_ADAPTIVE)
+			return ERayBudgetMode((*TileModes)[size_t(y / kRayBudgetTileSize) * NumTilesX + x / kRayBudgetTileSize]);
+		return ERayBudgetMode(CB.RayBudgetMode);
+	};
+
+	const float Near = CB.ProjectionParams.z;
+	const float Far = CB.ProjectionParams.w;
+
+	// traced texels are only read, untraced ones only written, so the image is updated in place like on the gpu.
+	ParallelForRows(TS, CB.RTHeight, [&](uint32_t StartRow, uint32_t EndRow)
+	{
+		for (uint32_t y = StartRow; y < EndRow; y++)
+		{
+			for (uint32_t x = 0; x < CB.RTWidth; x++)
+			{
+				const ERayBudgetMode Mode = GetMode(x, y);
+				if (IsTracedPixel(Mode, x, y, CB.FrameIndex))
+					continue;
+
+				const RayBudgetPoint CellSize = GetRayBudgetCellSize(Mode);
+				const RayBudgetPoint NumCells = GetRayDispatchSize(Mode, CB.RTWidth, CB.RTHeight);
+
+				const float LinearDepth = GetLinearDepth(Depth.Load(x, y).x, Near, Far);
+				const glm::vec3 N = glm::vec3(Normal.Load(x, y));
+
+				const int32_t CellX = int32_t(x / CellSize.x);
+				const int32_t CellY = int32_t(y / CellSize.y);
+
+				glm::vec4 Sum(0.f);
+				float WeightSum = 0.f;
+				glm::vec4 Nearest(0.f);
+				uint32_t NearestDist = UINT32_MAX;
+
+				for (int32_t cy = CellY - 1; cy <= CellY + 1; cy++)
+				{
+					for (int32_t cx = CellX - 1; cx <= CellX + 1; cx++)
+					{
+						if (cx < 0 || cy < 0 || uint32_t(cx) >= NumCells.x || uint32_t(cy) >= NumCells.y)
+							continue;
+
+						RayBudgetPoint Q = GetTracedPixel(Mode, cx, cy, CB.FrameIndex);
+						if (Q.x >= CB.RTWidth || Q.y >= CB.RTHeight)
+							continue;
+
+						// a neighboring adaptive tile can trace at a different rate, its cell around Q has the ray.
+						// skipping it instead leaves the pixels of a partial tile without any sample on the frames
+						// their own ray is off screen.
+						const ERayBudgetMode NeighborMode = GetMode(Q.x, Q.y);
+						if (NeighborMode != Mode)
+						{
+							const RayBudgetPoint NeighborCellSize = GetRayBudgetCellSize(NeighborMode);
+							Q = GetTracedPixel(NeighborMode, Q.x / NeighborCellSize.x, Q.y / NeighborCellSize.y, CB.FrameIndex);
+							if (Q.x >= CB.RTWidth || Q.y >= CB.RTHeight)
+								continue;
+						}
+
+						const int32_t dx = int32_t(Q.x) - int32_t(x);
+						const int32_t dy = int32_t(Q.y) - int32_t(y);
+						const uint32_t Dist2 = uint32_t(dx * dx + dy * dy);
+
+						const glm::vec4 Value = Image.Load(Q.x, Q.y);
+						if (Dist2 < NearestDist)
+						{
+							NearestDist = Dist2;
+							Nearest = Value;
+						}
+
+						const float SampleDepth = GetLinearDepth(Depth.Load(Q.x, Q.y).x, Near, Far);
+						const glm::vec3 SampleNormal = glm::vec3(Normal.Load(Q.x, Q.y));
+
+						const float SpatialWeight = 1.0f / (1.0f + float(Dist2));
+						const float DepthWeight = std::exp(-std::abs(SampleDepth - LinearDepth) / (LinearDepth * CB.DepthSigma));
+						const float NormalWeight = std::pow(std::min(std::max(glm::dot(N, SampleNormal), 0.f), 1.f), CB.NormalPower);
+
+						const float Weight = SpatialWeight * DepthWeight * NormalWeight;
+						Sum += Value * Weight;
+						WeightSum += Weight;
+					}
+				}
+
+				Image.Store(x, y, WeightSum > 0.0001f ? Sum / WeightSum : Nearest);
+			}
+		}
+	});
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GIDenoiserCPU.h"
+
+// reduced rate ray dispatch of the rt reflection and gi passes. mirrors Shaders/RayBudget.hlsl.
+// the screen is split in cells and one pixel per cell is traced. the traced pixel rotates with the
+// frame index so every pixel is traced once per cell size frames, the rest is reconstructed.
+enum ERayBudgetMode : uint32_t
+{
+	RAY_BUDGET_FULL,
+	RAY_BUDGET_CHECKERBOARD,	// 1/2, 2x1 cells with the offset flipping every row
+	RAY_BUDGET_QUARTER,			// 1/4, 2x2 cells
+	RAY_BUDGET_NINTH,			// 1/9, 3x3 cells
+	RAY_BUDGET_ADAPTIVE,		// one of the above per screen tile, picked by RayBudgetClassifyCS.hlsl
+	RAY_BUDGET_MODE_COUNT
+};
+
+// constant buffer of RayReconstructCS.hlsl.
+struct RayReconstructCB
+{
+	glm::vec4 ProjectionParams;
+	uint32_t RayBudgetMode;
+	uint32_t FrameIndex;
+	uint32_t RTWidth;
+	uint32_t RTHeight;
+	// relative linear depth difference where the depth weight falls to 1/e.
+	float DepthSigma = 0.05f;
+	float NormalPower = 32.0f;
+};
+
+struct RayBudgetPoint
+{
+	uint32_t x;
+	uint32_t y;
+};
+
+// adaptive tiles are a multiple of every cell size so cells never straddle two tiles.
+const uint32_t kRayBudgetTileSize = 12;
+
+// constant buffer of RayBudgetClassifyCS.hlsl.
+struct RayBudgetClassifyCB
+{
+	glm::vec2 RTSize;
+	uint32_t NumTilesX;
+	uint32_t NumTilesY;
+	// coefficient of variation of the accumulated luma above which a tile is traced at full and half rate.
+	float HighVariance = 0.5f;
+	float LowVariance = 0.15f;
+	// frames of temporal history below which a tile is not converged yet.
+	float ConvergedHistory = 8.0f;
+	// ratio of disoccluded pixels that forces full rate.
+	float DisocclusionRatio = 0.1f;
+	// converged tiles rougher than this drop to 1/9.
+	float RoughThreshold = 0.5f;
+};
+
+// per tile statistics gathered by the classifier.
+struct RayBudgetTileStats
+{
+	float Variance = 0.f;			// max coefficient of variation of the specular and diffuse luma
+	float History = 0.f;			// mean history length in frames
+	float Disocclusion = 0.f;		// ratio of pixels without history
+	float Roughness = 0.f;			// mean roughness
+};
+
+RayBudgetPoint GetRayBudgetCellSize(ERayBudgetMode Mode);
+
+// DispatchRay size covering the render target.
+RayBudgetPoint GetRayDispatchSize(ERayBudgetMode Mode, uint32_t Width, uint32_t Height);
+
+// pixel traced by the ray of a cell. can be outside of the render target for partial cells.
+// adaptive mode is resolved per tile before, it is not a cell pattern itself.
+RayBudgetPoint GetTracedPixel(ERayBudgetMode Mode, uint32_t CellX, uint32_t CellY, uint32_t FrameIndex);
+
+bool IsTracedPixel(ERayBudgetMode Mode, uint32_t x, uint32_t y, uint32_t FrameIndex);
+
+// ray budget of one adaptive tile. disoccluded or noisy tiles get full rate, converged ones fewer rays.
+ERayBudgetMode ClassifyRayBudgetTile(const RayBudgetClassifyCB& CB, const RayBudgetTileStats& Stats);
+
+// cpu reference of RayBudgetClassifyCS.hlsl on recorded buffers. Specular and DiffuseSH are last frame's
+// temporal denoiser outputs (history length / 10 in Specular.w), Velocity the gbuffer velocity in uv and
+// Roughness the roughness metallic buffer. TileModes is resized to NumTilesX * NumTilesY.
+void ClassifyRayBudgetTilesCPU(const RayBudgetClassifyCB& CB, const DenoiserImage& Specular, const DenoiserImage& DiffuseSH,
+	const DenoiserImage& Velocity, const DenoiserImage& Roughness, std::vector<uint8_t>& TileModes,
+	std::vector<RayBudgetTileStats>* OutStats = nullptr, enki::TaskScheduler* TS = nullptr);
+
+// rays traced per frame for a tile mode map, to compare the adaptive budget against the fixed modes.
+uint64_t CountRayBudgetRays(const std::vector<uint8_t>& TileModes, uint32_t NumTilesX, uint32_t Width, uint32_t Height, uint32_t FrameIndex);
+
+// cpu reference of RayReconstructCS.hlsl. untraced texels of Image are filled from the traced
+// pixels of the neighboring cells, weighted by distance, linear depth and normal similarity.
+// Depth holds device depth in x, Normal the world normal in xyz. TileModes is required in adaptive mode.
+void ReconstructRayBudgetCPU(const RayReconstructCB& CB, const DenoiserImage& Depth, const DenoiserImage& Normal,
+	DenoiserImage& Image, const std::vector<uint8_t>* TileModes = nullptr, enki::TaskScheduler* TS = nullptr);
@@ -0,0 +1,52 @@
+#include "RootSignatureLayout.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "PipelineCache.h"
+
+bool RootParamDesc::operator<(const RootParamDesc& Other) const
+{
+	if (Type != Other.Type)
+		return Type < Other.Type;
+	if (BaseRegister != Other.BaseRegister)
+		return BaseRegister < Other.BaseRegister;
+	return NumDescriptors < Other.NumDescriptors;
+}
+
+uint32_t RootSignatureLayout::AddParam(RootParamType Type, uint32_t BaseRegister, uint32_t NumDescriptors)
+{
+	Params.push_back({ Type, BaseRegister, NumDescriptors });
+	RootParamIndex.push_back(uint32_t(RootParamIndex.size()));
+	return uint32_t(Params.size() - 1);
+}
+
+void RootSignatureLayout::Canonicalize()
+{
+	// RootParamIndex still maps adding order to the current position.
+	std::vector<uint32_t> Order(Params.size());
+	std::iota(Order.begin(), Order.end(), 0);
+	std::stable_sort(Order.begin(), Order.end(), [this](uint32_t A, uint32_t B) { return Params[A] < Params[B]; });
+
+	std::vector<RootParamDesc> Sorted(Params.size());
+	std::vector<uint32_t> NewPosition(Params.size());
+	for (uint32_t Position = 0; Position < Order.size(); Position++)
+	{
+		Sorted[Position] = Params[Order[Position]];
+		NewPosition[Order[Position]] = Position;
+	}
+	for (uint32_t& Index : RootParamIndex)
+		Index = NewPosition[Index];
+	Params.swap(Sorted);
+
+	PipelineHasher Hasher;
+	Hasher.AddValue(Flags);
+	Hasher.AddValue(uint32_t(Params.size()));
+	for (const RootParamDesc& Param : Params)
+	{
+		Hasher.AddValue(Param.Type);
+		Hasher.AddValue(Param.BaseRegister);
+		Hasher.AddValue(Param.NumDescriptors);
+	}
+	Hash = Hasher.Get();
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// canonical root signature layouts. the binding maps of a pso are ordered by name, two psos binding the same
+// registers under other names would get different parameter orders and their own root signature. sorting the
+// parameters by type and register gives both the same layout and hash, the backend shares one root
+// signature between them.
+
+enum class RootParamType : uint8_t
+{
+	SRVTable,
+	UAVTable,
+	CBVTable,
+	SamplerTable,
+	Constants,
+};
+
+struct RootParamDesc
+{
+	RootParamType Type;
+	uint32_t BaseRegister;
+	uint32_t NumDescriptors;	// 32 bit values for constants
+
+	bool operator==(const RootParamDesc& Other) const
+	{
+		return Type == Other.Type && BaseRegister == Other.BaseRegister && NumDescriptors == Other.NumDescriptors;
+	}
+	bool operator<(const RootParamDesc& Other) const;
+};
+
+class RootSignatureLayout
+{
+public:
+	// returns the index of the parameter in adding order.
+	uint32_t AddParam(RootParamType Type, uint32_t BaseRegister, uint32_t NumDescriptors);
+	void SetFlags(uint32_t InFlags) { Flags = InFlags; }
+
+	// sorts the parameters and hashes them. the root parameter index of an added parameter is
+	// GetRootParamIndex of its adding index afterwards.
+	void Canonicalize();
+
+	uint32_t GetRootParamIndex(uint32_t AddedIndex) const { return RootParamIndex[AddedIndex]; }
+	const std::vector<RootParamDesc>& GetParams() const { return Params; }
+	uint32_t GetFlags() const { return Flags; }
+	uint64_t GetHash() const { return Hash; }
+
+	// same parameters and flags, the check behind a hash match.
+	bool operator==(const RootSignatureLayout& Other) const { return Flags == Other.Flags && Params == Other.Params; }
+
+private:
+	std::vector<RootParamDesc> Params;
+	std::vector<uint32_t> RootParamIndex;
+	uint32_t Flags = 0;
+	uint64_t Hash = 0;
+};
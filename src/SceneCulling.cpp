@@ -0,0 +1,249 @@
+#include "SceneCulling.h"
+
+#include <cfloat>
+#include <cmath>
+#include <atomic>
+#include <algorithm>
+#include <xmmintrin.h>
+
+#include "GIDenoiserCPU.h"
+#include "Profiler.h"
+
+// boxes per ParallelForRows row.
+static const uint32_t kCullingChunkSize = 256;
+
+void CullingBounds::Clear()
+{
+	MinX.clear(); MinY.clear(); MinZ.clear();
+	MaxX.clear(); MaxY.clear(); MaxZ.clear();
+	Count = 0;
+}
+
+uint32_t CullingBounds::Add(const glm::vec3& Min, const glm::vec3& Max)
+{
+	const uint32_t Index = Count++;
+	const size_t PaddedCount = (size_t(Count) + 3) & ~size_t(3);
+
+	if (MinX.size() < PaddedCount)
+	{
+		for (auto* Array : { &MinX, &MinY, &MinZ, &MaxX, &MaxY, &MaxZ })
+			Array->resize(PaddedCount, 0.f);
+	}
+
+	MinX[Index] = Min.x; MinY[Index] = Min.y; MinZ[Index] = Min.z;
+	MaxX[Index] = Max.x; MaxY[Index] = Max.y; MaxZ[Index] = Max.z;
+	return Index;
+}
+
+void TransformBounds(const glm::mat4x4& Transform, const glm::vec3& Min, const glm::vec3& Max, glm::vec3& OutMin, glm::vec3& OutMax)
+{
+	// Arvo's method, the extent along each world axis is the sum over the object axes.
+	const glm::vec3 Center = (Min + Max) * 0.5f;
+	const glm::vec3 Extent = (Max - Min) * 0.5f;
+
+	const glm::vec3 WorldCenter = glm::vec3(Transform * glm::vec4(Center, 1));
+	glm::vec3 WorldExtent = glm::vec3(0.f);
+	for (int Axis = 0; Axis < 3; Axis++)
+		WorldExtent += glm::abs(glm::vec3(Transform[Axis])) * Extent[Axis];
+
+	OutMin = WorldCenter - WorldExtent;
+	OutMax = WorldCenter + WorldExtent;
+}
+
+static inline glm::vec4 GetRow(const glm::mat4x4& M, int Row)
+{
+	return glm::vec4(M[0][Row], M[1][Row], M[2][Row], M[3][Row]);
+}
+
+void GetFrustumPlanes(const glm::mat4x4& ViewProj, glm::vec4 OutPlanes[6])
+{
+	const glm::vec4 X = GetRow(ViewProj, 0);
+	const glm::vec4 Y = GetRow(ViewProj, 1);
+	const glm::vec4 Z = GetRow(ViewProj, 2);
+	const glm::vec4 W = GetRow(ViewProj, 3);
+
+	OutPlanes[0] = W + X;
+	OutPlanes[1] = W - X;
+	OutPlanes[2] = W + Y;
+	OutPlanes[3] = W - Y;
+	OutPlanes[4] = Z;
+	OutPlanes[5] = W - Z;
+
+	for (int i = 0; i < 6; i++)
+		OutPlanes[i] /= glm::length(glm::vec3(OutPlanes[i]));
+}
+
+void HiZBuffer::Build(const float* Depth, uint32_t Width, uint32_t Height, const glm::mat4x4& InViewProj)
+{
+	ViewProj = InViewProj;
+	Mips.clear();
+
+	Mip Base;
+	Base.Width = Width;
+	Base.Height = Height;
+	Base.Depth.assign(Depth, Depth + size_t(Width) * Height);
+	Mips.push_back(std::move(Base));
+
+	while (Mips.back().Width > 1 || Mips.back().Height > 1)
+	{
+		const Mip& Src = Mips.back();
+
+		Mip Dst;
+		Dst.Width = (Src.Width + 1) / 2;
+		Dst.Height = (Src.Height + 1) / 2;
+		Dst.Depth.resize(size_t(Dst.Width) * Dst.Height);
+
+		for (uint32_t y = 0; y < Dst.Height; y++)
+		{
+			const uint32_t y0 = y * 2;
+			const uint32_t y1 = std::min(y0 + 1, Src.Height - 1);
+			for (uint32_t x = 0; x < Dst.Width; x++)
+			{
+				const uint32_t x0 = x * 2;
+				const uint32_t x1 = std::min(x0 + 1, Src.Width - 1);
+				Dst.Depth[size_t(y) * Dst.Width + x] = std::max(
+					std::max(Src.Depth[size_t(y0) * Src.Width + x0], Src.Depth[size_t(y0) * Src.Width + x1]),
+					std::max(Src.Depth[size_t(y1) * Src.Width + x0], Src.Depth[size_t(y1) * Src.Width + x1]));
+			}
+		}
+
+		Mips.push_back(std::move(Dst));
+	}
+}
+
+bool HiZBuffer::IsOccluded(const glm::vec3& Min, const glm::vec3& Max) const
+{
+	if (Mips.empty())
+		return false;
+
+	glm::vec2 RectMin = glm::vec2(FLT_MAX);
+	glm::vec2 RectMax = glm::vec2(-FLT_MAX);
+	float NearestDepth = FLT_MAX;
+
+	for (int c = 0; c < 8; c++)
+	{
+		const glm::vec3 Corner = glm::vec3((c & 1) ? Max.x : Min.x, (c & 2) ? Max.y : Min.y, (c & 4) ? Max.z : Min.z);
+		const glm::vec4 Clip = ViewProj * glm::vec4(Corner, 1);
+		if (Clip.w <= 1e-5f || Clip.z < 0.f)
+			return false;
+
+		const glm::vec3 NDC = glm::vec3(Clip) / Clip.w;
+		RectMin = glm::min(RectMin, glm::vec2(NDC));
+		RectMax = glm::max(RectMax, glm::vec2(NDC));
+		NearestDepth = std::min(NearestDepth, NDC.z);
+	}
+
+	// outside of the view the hi-z was rendered from, nothing is known about it.
+	if (RectMax.x < -1.f || RectMax.y < -1.f || RectMin.x > 1.f || RectMin.y > 1.f)
+		return false;
+
+	RectMin = glm::clamp(RectMin, glm::vec2(-1.f), glm::vec2(1.f));
+	RectMax = glm::clamp(RectMax, glm::vec2(-1.f), glm::vec2(1.f));
+
+	// ndc y points up, texel rows go down.
+	const Mip& Base = Mips[0];
+	int32_t x0 = int32_t((RectMin.x * 0.5f + 0.5f) * Base.Width);
+	int32_t x1 = int32_t((RectMax.x * 0.5f + 0.5f) * Base.Width);
+	int32_t y0 = int32_t((0.5f - RectMax.y * 0.5f) * Base.Height);
+	int32_t y1 = int32_t((0.5f - RectMin.y * 0.5f) * Base.Height);
+	x0 = std::min(std::max(x0, 0), int32_t(Base.Width) - 1);
+	x1 = std::min(std::max(x1, 0), int32_t(Base.Width) - 1);
+	y0 = std::min(std::max(y0, 0), int32_t(Base.Height) - 1);
+	y1 = std::min(std::max(y1, 0), int32_t(Base.Height) - 1);
+
+	// coarsest mip the rect still covers at most 2x2 texels of.
+	uint32_t Level = 0;
+	while ((x1 - x0 > 1 || y1 - y0 > 1) && Level + 1 < Mips.size())
+	{
+		x0 >>= 1; x1 >>= 1;
+		y0 >>= 1; y1 >>= 1;
+		Level++;
+	}
+
+	const Mip& M = Mips[Level];
+	float FarthestDepth = 0.f;
+	for (int32_t y = y0; y <= y1; y++)
+		for (int32_t x = x0; x <= x1; x++)
+			FarthestDepth = std::max(FarthestDepth, M.Depth[size_t(y) * M.Width + x]);
+
+	return NearestDepth > FarthestDepth;
+}
+
+void CullCPU(const CullingBounds& Bounds, const glm::mat4x4& ViewProj, const HiZBuffer* HiZ,
+	std::vector<uint8_t>& Visible, CullingStats& OutStats, enki::TaskScheduler* TS)
+{
+	ProfileCPUScope("CullCPU");
+
+	Visible.resize(Bounds.Count);
+
+	glm::vec4 Planes[6];
+	GetFrustumPlanes(ViewProj, Planes);
+
+	const bool bOcclusion = HiZ && HiZ->IsValid();
+
+	std::atomic<uint32_t> NumFrustumCulled(0);
+	std::atomic<uint32_t> NumOcclusionCulled(0);
+
+	const uint32_t NumChunks = (Bounds.Count + kCullingChunkSize - 1) / kCullingChunkSize;
+	ParallelForRows(TS, NumChunks, [&](uint32_t StartChunk, uint32_t EndChunk)
+	{
+		ProfileCPUScope("CullChunks");
+
+		uint32_t LocalFrustumCulled = 0;
+		uint32_t LocalOcclusionCulled = 0;
+
+		const uint32_t Start = StartChunk * kCullingChunkSize;
+		const uint32_t End = std::min(EndChunk * kCullingChunkSize, Bounds.Count);
+
+		for (uint32_t i = Start; i < End; i += 4)
+		{
+			__m128 Outside = _mm_setzero_ps();
+
+			// the corner farthest along the plane normal, outside when even that one is behind the plane.
+			for (const glm::vec4& Plane : Planes)
+			{
+				const __m128 PX = _mm_loadu_ps(Plane.x > 0.f ? &Bounds.MaxX[i] : &Bounds.MinX[i]);
+				const __m128 PY = _mm_loadu_ps(Plane.y > 0.f ? &Bounds.MaxY[i] : &Bounds.MinY[i]);
+				const __m128 PZ = _mm_loadu_ps(Plane.z > 0.f ? &Bounds.MaxZ[i] : &Bounds.MinZ[i]);
+
+				__m128 Dist = _mm_add_ps(_mm_mul_ps(PX, _mm_set1_ps(Plane.x)), _mm_set1_ps(Plane.w));
+				Dist = _mm_add_ps(Dist, _mm_mul_ps(PY, _mm_set1_ps(Plane.y)));
+				Dist = _mm_add_ps(Dist, _mm_mul_ps(PZ, _mm_set1_ps(Plane.z)));
+
+				Outside = _mm_or_ps(Outside, _mm_cmplt_ps(Dist, _mm_setzero_ps()));
+			}
+
+			const int OutsideMask = _mm_movemask_ps(Outside);
+			const uint32_t NumLanes = std::min(4u, End - i);
+
+			for (uint32_t Lane = 0; Lane < NumLanes; Lane++)
+			{
+				const uint32_t Index = i + Lane;
+				if (OutsideMask & (1 << Lane))
+				{
+					Visible[Index] = 0;
+					LocalFrustumCulled++;
+					continue;
+				}
+
+				if (bOcclusion && HiZ->IsOccluded(glm::vec3(Bounds.MinX[Index], Bounds.MinY[Index], Bounds.MinZ[Index]),
+					glm::vec3(Bounds.MaxX[Index], Bounds.MaxY[Index], Bounds.MaxZ[Index])))
+				{
+					Visible[Index] = 0;
+					LocalOcclusionCulled++;
+					continue;
+				}
+
+				Visible[Index] = 1;
+			}
+		}
+
+		NumFrustumCulled += LocalFrustumCulled;
+		NumOcclusionCulled += LocalOcclusionCulled;
+	});
+
+	OutStats.NumTested = Bounds.Count;
+	OutStats.NumFrustumCulled = NumFrustumCulled;
+	OutStats.NumOcclusionCulled = NumOcclusionCulled;
+	OutStats.NumVisible = Bounds.Count - OutStats.NumFrustumCulled - OutStats.NumOcclusionCulled;
+}
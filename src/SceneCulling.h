@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+namespace enki
+{
+	class TaskScheduler;
+}
+
+// world space boxes of everything that can be culled, structure of arrays so the frustum test
+// runs on 4 boxes at a time. the arrays are padded to a multiple of 4 with empty boxes.
+struct CullingBounds
+{
+	std::vector<float> MinX, MinY, MinZ;
+	std::vector<float> MaxX, MaxY, MaxZ;
+	uint32_t Count = 0;
+
+	void Clear();
+	// returns the index of the box, which is also its index in the visibility array.
+	uint32_t Add(const glm::vec3& Min, const glm::vec3& Max);
+};
+
+// world space box of an object space box.
+void TransformBounds(const glm::mat4x4& Transform, const glm::vec3& Min, const glm::vec3& Max, glm::vec3& OutMin, glm::vec3& OutMax);
+
+// left, right, bottom, top, near, far planes of a d3d clip space (0 <= z <= w), normalized and pointing inward.
+void GetFrustumPlanes(const glm::mat4x4& ViewProj, glm::vec4 OutPlanes[6]);
+
+// hierarchical max depth of a depth buffer, built from a low resolution copy of the previous frame's
+// depth. depth is the standard 0 near, 1 far. a box is occluded when its nearest depth is behind the
+// farthest depth of every texel its screen rect covers.
+class HiZBuffer
+{
+public:
+	// Depth is Width x Height texels rendered with ViewProj, top row first.
+	void Build(const float* Depth, uint32_t Width, uint32_t Height, const glm::mat4x4& ViewProj);
+	void Invalidate() { Mips.clear(); }
+	bool IsValid() const { return !Mips.empty(); }
+
+	// boxes crossing the near plane are never occluded.
+	bool IsOccluded(const glm::vec3& Min, const glm::vec3& Max) const;
+
+	uint32_t GetNumMips() const { return uint32_t(Mips.size()); }
+
+private:
+	struct Mip
+	{
+		uint32_t Width = 0;
+		uint32_t Height = 0;
+		std::vector<float> Depth;
+	};
+
+	std::vector<Mip> Mips;
+	glm::mat4x4 ViewProj;
+};
+
+struct CullingStats
+{
+	uint32_t NumTested = 0;
+	uint32_t NumFrustumCulled = 0;
+	uint32_t NumOcclusionCulled = 0;
+	uint32_t NumVisible = 0;
+};
+
+// Visible[i] is 1 when box i intersects the frustum of ViewProj and is not occluded in HiZ.
+// HiZ can be null or invalid, then only the frustum test runs.
+void CullCPU(const CullingBounds& Bounds, const glm::mat4x4& ViewProj, const HiZBuffer* HiZ,
+	std::vector<uint8_t>& Visible, CullingStats& OutStats, enki::TaskScheduler* TS);
+
+// resolution of the depth the gpu reduces for the occlusion test, see HiZReduceCS.hlsl.
+const uint32_t kHiZWidth = 128;
+const uint32_t kHiZHeight = 64;
+
+// constant buffer of HiZReduceCS.hlsl.
+struct HiZReduceCB
+{
+	uint32_t DepthWidth;
+	uint32_t DepthHeight;
+};
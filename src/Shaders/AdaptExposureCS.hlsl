@@ -10,10 +10,8 @@
 //
 // Author:  James Stanard 
 //
-// The group size is 16x16, but one group iterates over an entire 16-wide column of pixels (384 pixels tall)
-// Assuming the total workspace is 640x384, there will be 40 thread groups computing the histogram in parallel.
-// The histogram measures logarithmic luminance ranging from 2^-12 up to 2^4.  This should provide a nice window
-// where the exposure would range from 2^-4 up to 2^4.
+// The histogram measures logarithmic luminance between MinLog and MaxLog, 2^-12 up to 2^4 by default.
+// This should provide a nice window where the exposure would range from 2^-4 up to 2^4.
 
 ByteAddressBuffer Histogram : register(t0);
 RWStructuredBuffer<float> Exposure : register(u0);
@@ -25,23 +23,41 @@ cbuffer AdaptExposureCB : register(b0)
     float MinExposure;
     float MaxExposure;
     uint PixelCount; 
+    uint ResetLogRange;
+    float ResetMinLog;
+    float ResetMaxLog;
 }
 
-groupshared float gs_Accum[256];
+#ifndef USE_WAVE_INTRINSICS
+#define USE_WAVE_INTRINSICS 1
+#endif
+
+groupshared uint gs_WeightedSum;
 
 [numthreads( 256, 1, 1 )]
 void AdaptExposure( uint GI : SV_GroupIndex )
 {
-    float WeightedSum = (float)GI * (float)Histogram.Load(GI * 4);
+    if (GI == 0)
+        gs_WeightedSum = 0;
 
-    [unroll]
-    for (uint i = 1; i < 256; i *= 2)
-    {
-        gs_Accum[GI] = WeightedSum;                    // Write
-        GroupMemoryBarrierWithGroupSync();            // Sync
-        WeightedSum += gs_Accum[(GI + i) % 256];    // Read
-        GroupMemoryBarrierWithGroupSync();            // Sync
-    }
+    GroupMemoryBarrierWithGroupSync();
+
+    // integer sum so the result doesn't depend on the reduction order.
+    uint WeightedCount = GI * Histogram.Load(GI * 4);
+#if USE_WAVE_INTRINSICS
+    uint WaveSum = WaveActiveSum(WeightedCount);
+    if (WaveIsFirstLane())
+        InterlockedAdd(gs_WeightedSum, WaveSum);
+#else
+    InterlockedAdd(gs_WeightedSum, WeightedCount);
+#endif
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (GI != 0)
+        return;
+
+    float WeightedSum = (float)gs_WeightedSum;
 
     float MinLog = Exposure[4];
     float MaxLog = Exposure[5];
@@ -59,13 +75,20 @@ void AdaptExposure( uint GI : SV_GroupIndex )
     exposure = lerp(exposure, targetExposure, AdaptationRate);
     exposure = clamp(exposure, MinExposure, MaxExposure);
 
-    if (GI == 0)
-    {
-        Exposure[0] = exposure;
-        Exposure[1] = 1.0 / exposure;
-        Exposure[2] = exposure;
-        Exposure[3] = weightedHistAvg;
+    Exposure[0] = exposure;
+    Exposure[1] = 1.0 / exposure;
+    Exposure[2] = exposure;
+    Exposure[3] = weightedHistAvg;
 
+    if (ResetLogRange)
+    {
+        // the bin range was changed from the ui, takes effect from the next frame.
+        MinLog = ResetMinLog;
+        MaxLog = ResetMaxLog;
+        LogRange = ResetMaxLog - ResetMinLog;
+    }
+    else
+    {
         // First attempt to recenter our histogram around the log-average.
         float biasToCenter = (floor(weightedHistAvg) - 128.0) / 255.0;
         if (abs(biasToCenter) > 0.1)
@@ -73,15 +96,15 @@ void AdaptExposure( uint GI : SV_GroupIndex )
             MinLog += biasToCenter * RcpLogRange;
             MaxLog += biasToCenter * RcpLogRange;
         }
+    }
 
-        // TODO:  Increase or decrease the log range to better fit the range of values.
-        // (Idea) Look at intermediate log-weighted sums for under- or over-represented
-        // extreme bounds.  I.e. break the for loop into two pieces to compute the sum of
-        // groups of 16, check the groups on each end, then finish the recursive summation.
+    // TODO:  Increase or decrease the log range to better fit the range of values.
+    // (Idea) Look at intermediate log-weighted sums for under- or over-represented
+    // extreme bounds.  I.e. break the for loop into two pieces to compute the sum of
+    // groups of 16, check the groups on each end, then finish the recursive summation.
 
-        Exposure[4] = MinLog;
-        Exposure[5] = MaxLog;
-        Exposure[6] = LogRange;
-        Exposure[7] = 1.0 / LogRange;
-    }
+    Exposure[4] = MinLog;
+    Exposure[5] = MaxLog;
+    Exposure[6] = LogRange;
+    Exposure[7] = 1.0 / LogRange;
 }
@@ -11,22 +11,19 @@ SamplerState sampleWrap : register(s0);
 
 cbuffer BloomCB : register(b0)
 {
-    float2 BlurDirection;
     float2 RTSize;
-    uint NumSamples;
-   	float WeightScale;
-   	float NormalizationScale;
    	float BloomThreshHold;
-   	// float Exposure;
-   	// float MinLog;
-   	// float RcpLogRange;
 };
 
 
 
+// writes mip 0 of the bloom chain. the rest of the chain is built by SinglePassDownsampleCS.hlsl.
 [numthreads(32, 32, 1)]
 void BloomExtract( uint3 DTid : SV_DispatchThreadID)
 {
+    if (any(DTid.xy >= uint2(RTSize)))
+        return;
+
     float2 PixelPos = DTid.xy;
 
  	float2 uv = (DTid.xy + 0.5) / RTSize;
@@ -83,38 +80,3 @@ void BloomExtract( uint3 DTid : SV_DispatchThreadID)
         LumaResult[DTid.xy] = logLuma * 254.0 + 1.0;                    // Rescale to [1, 255]
     }
 }
-
-[numthreads(32, 32, 1)]
-void BloomBlur( uint3 DTid : SV_DispatchThreadID)
-{
-    float2 PixelPos = DTid.xy;
-    int2 bloom_extent = int2(RTSize.x, RTSize.y);
-    float2 bloom_sample_extent = float2(bloom_extent) - float2(0.5, 0.5);
-	
-	float3 Result = SrcTex[PixelPos].xyz;
-	float x;
-    for(x = 1;x < NumSamples;x += 2)
-    {
-		float w1 = exp(pow(x, 2) * WeightScale);
-		float w2 = exp(pow(x + 1.0, 2) * WeightScale);
-
-		float w12 = w1 + w2;
-		float p = w2 / w12;
-		float2 offset = BlurDirection * (x + p);
-		float2 pos1 = clamp(PixelPos + float2(0.5, 0.5) + offset, float2(0.0, 0.0), bloom_sample_extent);
-		float2 pos2 = clamp(PixelPos + float2(0.5, 0.5) - offset, float2(0.0, 0.0), bloom_sample_extent);
-
-		float2 uv1 = pos1/RTSize;
-		float2 uv2 = pos2/RTSize;
-
-		float3 Sample;
-		Sample = SrcTex.SampleLevel(sampleWrap, uv1, 0).xyz;
-		Result += Sample * w12;
-
-		Sample = SrcTex.SampleLevel(sampleWrap, uv2, 0).xyz;
-		Result += Sample * w12;
-    }
-
-    Result *= NormalizationScale;
-    DstTex[DTid.xy] = float4(Result, 1);
-}
\ No newline at end of file
@@ -0,0 +1,50 @@
+// one step of the bloom upsample chain, run from the smallest mip up to mip 0.
+// Mips[0] is the downsampled level being written in place, Mips[1] the coarser level that is already upsampled.
+// the coarser level is 3x3 tent filtered and bilinearly interpolated, then blended over this level.
+
+RWTexture2D<float4> Mips[2] : register(u0);
+
+cbuffer BloomUpsampleCB : register(b0)
+{
+	uint2 DstSize;
+	uint2 SrcSize;
+	float BloomScatter;
+};
+
+float4 LoadCoarse(int2 Pos)
+{
+	return Mips[1][clamp(Pos, 0, int2(SrcSize) - 1)];
+}
+
+[numthreads(8, 8, 1)]
+void BloomUpsample(uint3 DTid : SV_DispatchThreadID)
+{
+	if (any(DTid.xy >= DstSize))
+		return;
+
+	float2 Coord = (DTid.xy + 0.5) * float2(SrcSize) / float2(DstSize) - 0.5;
+	int2 Base = int2(floor(Coord));
+	float2 Frac = Coord - Base;
+
+	float4 Block[4][4];
+	for (int y = 0; y < 4; y++)
+		for (int x = 0; x < 4; x++)
+			Block[y][x] = LoadCoarse(Base + int2(x - 1, y - 1));
+
+	// tent filtered values of the 4 bilinear taps
+	float4 Tent[2][2];
+	for (int ty = 0; ty < 2; ty++)
+	{
+		for (int tx = 0; tx < 2; tx++)
+		{
+			float4 Row0 = Block[ty][tx] + 2 * Block[ty][tx + 1] + Block[ty][tx + 2];
+			float4 Row1 = Block[ty + 1][tx] + 2 * Block[ty + 1][tx + 1] + Block[ty + 1][tx + 2];
+			float4 Row2 = Block[ty + 2][tx] + 2 * Block[ty + 2][tx + 1] + Block[ty + 2][tx + 2];
+			Tent[ty][tx] = (Row0 + 2 * Row1 + Row2) / 16.0;
+		}
+	}
+
+	float4 Upsampled = lerp(lerp(Tent[0][0], Tent[0][1], Frac.x), lerp(Tent[1][0], Tent[1][1], Frac.x), Frac.y);
+
+	Mips[0][DTid.xy] = lerp(Mips[0][DTid.xy], Upsampled, BloomScatter);
+}
@@ -166,8 +166,11 @@ void scale_SH(inout SH sh, float scale)
 
 float2 LoadBlueNoise2(Texture3D blueNoiseTex, uint2 launchIndex, uint frameCounter, uint stride)
 {
+    uint3 dim;
+    blueNoiseTex.GetDimensions(dim.x, dim.y, dim.z);
+
     uint offset = frameCounter;
-    uint3 addr = uint3(launchIndex.x % 64, launchIndex.y % 64, (offset/2) % 64);
+    uint3 addr = uint3(launchIndex.x % dim.x, launchIndex.y % dim.y, (offset/2) % dim.z);
     float4 Noise = blueNoiseTex[addr];
 
     if(offset % 2 == 0)
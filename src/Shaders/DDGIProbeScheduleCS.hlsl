@@ -0,0 +1,44 @@
+#include "rtxgi/ddgi/ProbeCommon.hlsl"
+
+// runs before the probe trace of a volume. marks every probe as not traced, the trace then overwrites
+// the rays of the probes scheduled this frame. see ProbeScheduler.h. probes that scrolled into the
+// volume also drop the relocation offset and state left by the probe that used their storage before.
+
+RWTexture2D<float4> DDGIProbeRTRadiance : register(u0);
+RWTexture2D<float4> DDGIProbeOffsets : register(u1);
+RWTexture2D<uint> DDGIProbeStates : register(u2);
+
+cbuffer ProbeScheduleCB : register(b0)
+{
+	uint NumProbes;
+};
+
+ConstantBuffer<DDGIVolumeDescGPU> DDGIVolume : register(b1);
+
+[numthreads(64, 1, 1)]
+void DDGIProbeMarkNotTraced(uint3 DispatchThreadID : SV_DispatchThreadID)
+{
+	if (DispatchThreadID.x >= NumProbes)
+		return;
+
+	int probeIndex = DispatchThreadID.x;
+
+	DDGIProbeRTRadiance[int2(0, probeIndex)] = float4(0, 0, 0, RTXGI_DDGI_PROBE_NOT_TRACED);
+
+	if (!DDGIProbeScrolledIn(probeIndex, DDGIVolume))
+		return;
+
+#if RTXGI_DDGI_PROBE_RELOCATION
+#if RTXGI_COORDINATE_SYSTEM == RTXGI_COORDINATE_SYSTEM_LEFT || RTXGI_COORDINATE_SYSTEM == RTXGI_COORDINATE_SYSTEM_RIGHT
+	int textureWidth = (DDGIVolume.probeGridCounts.x * DDGIVolume.probeGridCounts.y);
+#elif RTXGI_COORDINATE_SYSTEM == RTXGI_COORDINATE_SYSTEM_UNREAL
+	int textureWidth = (DDGIVolume.probeGridCounts.y * DDGIVolume.probeGridCounts.z);
+#endif
+	DDGIProbeOffsets[int2(probeIndex % textureWidth, probeIndex / textureWidth)] = float4(0, 0, 0, 0);
+#endif
+
+#if RTXGI_DDGI_PROBE_STATE_CLASSIFIER
+	// traced this frame, the classifier decides again from its own rays.
+	DDGIProbeStates[DDGIGetProbeTexelPosition(probeIndex, DDGIVolume.probeGridCounts)] = PROBE_STATE_ACTIVE;
+#endif
+}
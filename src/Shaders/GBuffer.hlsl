@@ -9,10 +9,51 @@
 //
 //*********************************************************
 
+#ifndef GPU_DRIVEN
+#define GPU_DRIVEN 0
+#endif
+
+#ifndef BINDLESS
+#define BINDLESS 0
+#endif
+
+#if GPU_DRIVEN
+// GPUDrawData of GPUDrivenScene.h, indexed by the DrawID of the indirect command.
+ByteAddressBuffer DrawData : register(t0);
+ByteAddressBuffer InstanceTransforms : register(t1);
+// kTexturesPerMaterial consecutive textures per material.
+Texture2D MaterialTextures[MAX_MATERIAL_TEXTURES] : register(t2);
+
+cbuffer GPUDrivenDraw : register(b1)
+{
+    uint DrawID;
+};
+
+// GPUDrivenSceneCB, the roughness sliders of each scene.
+cbuffer GPUDrivenScene : register(b2)
+{
+    float4 SceneMaterial[MAX_GPU_DRIVEN_SCENES];
+};
+
+#define DRAW_DATA_SIZE 16
+#elif BINDLESS
+// BindlessMaterialData of BindlessMaterials.h, the table slots of the four textures of a material.
+ByteAddressBuffer Materials : register(t0);
+ByteAddressBuffer InstanceTransforms : register(t4);
+Texture2D MaterialTextures[MAX_MATERIAL_TEXTURES] : register(t5);
+
+cbuffer BindlessDraw : register(b1)
+{
+    uint MaterialIndex;
+};
+#else
 Texture2D AlbedoTex : register(t0);
 Texture2D NormalTex : register(t1);
 Texture2D RoughnessTex : register(t2);
 Texture2D MetallicTex : register(t3);
+// world matrices of the scene instances, indexed by InstanceBase + SV_InstanceID.
+ByteAddressBuffer InstanceTransforms : register(t4);
+#endif
 
 
 
@@ -22,13 +63,13 @@ cbuffer GBufferConstantBuffer : register(b0)
 {
     float4x4 ViewProjectionMatrix;
     float4x4 PrevViewProjectionMatrix;  
-    float4x4 WorldMatrix;
     float4x4 UnjitteredViewProjMat;
     float4x4 PrevUnjitteredViewProjMat;
     float4 ViewDir;
     float2 RTSize;
     float2 RougnessMetalic;
     uint bOverrideRougnessMetallic;
+    uint InstanceBase;
 };
 
 struct VSInput
@@ -47,13 +88,27 @@ struct PSInput
     float2 uv : TEXCOORD0;
     float3 normal : NORMAL;     
     float3 tangent : TANGENT;
+#if GPU_DRIVEN
+    nointerpolation uint drawID : DRAWID;
+#endif
 };
 
 
 PSInput VSMain(
-    VSInput input)
+    VSInput input, uint instanceID : SV_InstanceID)
 {
     PSInput result;
+#if GPU_DRIVEN
+    uint InstanceOffset = DrawData.Load(DrawID * DRAW_DATA_SIZE) * 64;
+    result.drawID = DrawID;
+#else
+    uint InstanceOffset = (InstanceBase + instanceID) * 64;
+#endif
+    float4x4 WorldMatrix = float4x4(
+        asfloat(InstanceTransforms.Load4(InstanceOffset)),
+        asfloat(InstanceTransforms.Load4(InstanceOffset + 16)),
+        asfloat(InstanceTransforms.Load4(InstanceOffset + 32)),
+        asfloat(InstanceTransforms.Load4(InstanceOffset + 48)));
 	float4 worldPos = mul(float4(input.position, 1.0f), WorldMatrix);
     result.position = mul(worldPos, ViewProjectionMatrix);
 
@@ -70,7 +125,7 @@ PSInput VSMain(
 
 
 
-float3 CalcPerPixelNormal(float2 vTexcoord, float3 vVertNormal, float3 vVertTangent)
+float3 CalcPerPixelNormal(float3 vBumpNormal, float3 vVertNormal, float3 vVertTangent)
 {
     vVertNormal = normalize(vVertNormal);
     vVertTangent = normalize(vVertTangent);
@@ -79,8 +134,6 @@ float3 CalcPerPixelNormal(float2 vTexcoord, float3 vVertNormal, float3 vVertTang
     float3x3 TBN = (float3x3(vVertTangent, vVertBinormal, vVertNormal));
 
 	// Compute per-pixel normal.
-    float3 vBumpNormal = (float3) NormalTex.Sample(sampleWrap, vTexcoord);
-
     vBumpNormal = 2.0f * vBumpNormal - 1.0f;
 
     return mul(vBumpNormal, TBN);
@@ -116,14 +169,36 @@ PS_OUTPUT PSMain(PSInput input) : SV_TARGET
 
     velocity.xy /= RTSize.xy;
 
+#if GPU_DRIVEN
+    uint4 Draw = DrawData.Load4(input.drawID * DRAW_DATA_SIZE);
+    uint FirstTexture = Draw.y * 4;
+    float4 Scene = SceneMaterial[Draw.z];
+    float2 RougnessMetalic = Scene.xy;
+    uint bOverrideRougnessMetallic = uint(Scene.z);
+
+    // draws of one ExecuteIndirect can share a wave.
+    float4 Albedo = MaterialTextures[NonUniformResourceIndex(FirstTexture + 0)].Sample(sampleWrap, input.uv);
+    float3 BumpNormal = MaterialTextures[NonUniformResourceIndex(FirstTexture + 1)].Sample(sampleWrap, input.uv).xyz;
+    float Roughness = MaterialTextures[NonUniformResourceIndex(FirstTexture + 2)].Sample(sampleWrap, input.uv).x;
+    float Metallic = MaterialTextures[NonUniformResourceIndex(FirstTexture + 3)].Sample(sampleWrap, input.uv).x;
+#elif BINDLESS
+    // one material per draw, the slots are uniform.
+    uint4 Slots = Materials.Load4(MaterialIndex * 16);
+    float4 Albedo = MaterialTextures[Slots.x].Sample(sampleWrap, input.uv);
+    float3 BumpNormal = MaterialTextures[Slots.y].Sample(sampleWrap, input.uv).xyz;
+    float Roughness = MaterialTextures[Slots.z].Sample(sampleWrap, input.uv).x;
+    float Metallic = MaterialTextures[Slots.w].Sample(sampleWrap, input.uv).x;
+#else
     float4 Albedo = AlbedoTex.Sample(sampleWrap, input.uv);
+    float3 BumpNormal = NormalTex.Sample(sampleWrap, input.uv).xyz;
     float Roughness = RoughnessTex.Sample(sampleWrap, input.uv).x;
     float Metallic = MetallicTex.Sample(sampleWrap, input.uv).x;
+#endif
 
     if(Albedo.w < 0.1)
         discard;
 
-    float3 WorldNormal = CalcPerPixelNormal(input.uv, input.normal, input.tangent);
+    float3 WorldNormal = CalcPerPixelNormal(BumpNormal, input.normal, input.tangent);
 	
     PS_OUTPUT output;
     output.Albedo.xyz = Albedo.xyz;
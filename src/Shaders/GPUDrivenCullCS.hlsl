@@ -0,0 +1,59 @@
+// frustum culls the draw records of the gpu driven gbuffer and appends the visible ones as indirect
+// commands. layouts are GPUDrawRecord and GPUDrawCommand of GPUDrivenScene.h.
+
+ByteAddressBuffer DrawRecords : register(t0);
+RWByteAddressBuffer DrawCommands : register(u0);
+RWByteAddressBuffer DrawCount : register(u1);
+
+cbuffer GPUDrivenCullCB : register(b0)
+{
+	float4 Planes[6];
+	uint NumDraws;
+	uint bFrustumCulling;
+};
+
+#define DRAW_RECORD_SIZE 48
+#define DRAW_COMMAND_SIZE 24
+
+[numthreads(64, 1, 1)]
+void CullDraws(uint3 DTid : SV_DispatchThreadID)
+{
+	if (DTid.x >= NumDraws)
+		return;
+
+	uint4 Record0 = DrawRecords.Load4(DTid.x * DRAW_RECORD_SIZE);
+	uint4 Record1 = DrawRecords.Load4(DTid.x * DRAW_RECORD_SIZE + 16);
+	uint4 Record2 = DrawRecords.Load4(DTid.x * DRAW_RECORD_SIZE + 32);
+
+	float3 AABBMin = asfloat(Record0.xyz);
+	float3 AABBMax = asfloat(Record1.xyz);
+	uint IndexCount = Record0.w;
+	uint StartIndex = Record1.w;
+	int BaseVertex = asint(Record2.x);
+	uint DrawID = Record2.y;
+
+	if (bFrustumCulling)
+	{
+		// the corner farthest along the plane normal, outside when even that one is behind the plane.
+		[unroll]
+		for (uint i = 0; i < 6; i++)
+		{
+			float3 Positive = Planes[i].xyz > 0 ? AABBMax : AABBMin;
+			if (dot(Planes[i].xyz, Positive) + Planes[i].w < 0)
+				return;
+		}
+	}
+
+	uint Slot;
+	DrawCount.InterlockedAdd(0, 1, Slot);
+
+	uint Offset = Slot * DRAW_COMMAND_SIZE;
+	DrawCommands.Store3(Offset, uint3(DrawID, IndexCount, 1));
+	DrawCommands.Store3(Offset + 12, uint3(StartIndex, asuint(BaseVertex), 0));
+}
+
+[numthreads(1, 1, 1)]
+void ClearDrawCount()
+{
+	DrawCount.Store(0, 0);
+}
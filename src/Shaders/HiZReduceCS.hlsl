@@ -0,0 +1,36 @@
+Texture2D<float> DepthTex : register(t0);
+RWByteAddressBuffer HiZ : register(u0);
+
+// reduces the depth buffer to the kHiZWidth x kHiZHeight max depth grid of SceneCulling.h, read back
+// for the occlusion test of the next frames.
+#define HIZ_WIDTH 128
+#define HIZ_HEIGHT 64
+
+cbuffer HiZReduceCB : register(b0)
+{
+	uint DepthWidth;
+	uint DepthHeight;
+};
+
+[numthreads(8, 8, 1)]
+void HiZReduce(uint3 DTid : SV_DispatchThreadID)
+{
+	if (DTid.x >= HIZ_WIDTH || DTid.y >= HIZ_HEIGHT)
+		return;
+
+	// texels whose center is inside the cell, at least one.
+	uint2 Start = (DTid.xy * uint2(DepthWidth, DepthHeight)) / uint2(HIZ_WIDTH, HIZ_HEIGHT);
+	uint2 End = ((DTid.xy + 1) * uint2(DepthWidth, DepthHeight)) / uint2(HIZ_WIDTH, HIZ_HEIGHT);
+	End = max(End, Start + 1);
+
+	float MaxDepth = 0;
+	for (uint y = Start.y; y < End.y; y++)
+	{
+		for (uint x = Start.x; x < End.x; x++)
+		{
+			MaxDepth = max(MaxDepth, DepthTex[uint2(x, y)]);
+		}
+	}
+
+	HiZ.Store((DTid.y * HIZ_WIDTH + DTid.x) * 4, asuint(MaxDepth));
+}
@@ -1,26 +1,64 @@
-
 Texture2D<uint> LumaTex : register( t0 );
 RWByteAddressBuffer Histogram : register( u0 );
 
+// every thread bins this many pixels of a column, so a group covers a 16 x 64 tile.
+#define ROWS_PER_THREAD 4
+
+#ifndef USE_WAVE_INTRINSICS
+#define USE_WAVE_INTRINSICS 1
+#endif
+
 groupshared uint g_TileHistogram[256];
 
+void AddToTileHistogram(uint Bin, bool bValid)
+{
+#if USE_WAVE_INTRINSICS
+    // lanes that fall in the same bin are merged, luma is coherent enough that this
+    // usually takes a couple of iterations and one shared atomic per bin per wave.
+    [loop]
+    while (bValid)
+    {
+        uint FirstBin = WaveReadLaneFirst(Bin);
+        if (Bin == FirstBin)
+        {
+            uint Count = WaveActiveCountBits(true);
+            if (WaveIsFirstLane())
+                InterlockedAdd( g_TileHistogram[Bin], Count );
+            bValid = false;
+        }
+    }
+#else
+    if (bValid)
+        InterlockedAdd( g_TileHistogram[Bin], 1 );
+#endif
+}
+
 [numthreads( 16, 16, 1 )]
-void GenerateHistogram( uint GI : SV_GroupIndex, uint3 DTid : SV_DispatchThreadID )
+void GenerateHistogram( uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 Gid : SV_GroupID )
 {
     g_TileHistogram[GI] = 0;
 
     GroupMemoryBarrierWithGroupSync();
 
-    // Loop 24 times until the entire column has been processed
-    for (uint TopY = 0; TopY < 384; TopY += 16)
+    uint2 LumaSize;
+    LumaTex.GetDimensions(LumaSize.x, LumaSize.y);
+
+    uint2 TileCorner = Gid.xy * uint2(16, 16 * ROWS_PER_THREAD);
+
+    [unroll]
+    for (uint i = 0; i < ROWS_PER_THREAD; i++)
     {
-        uint QuantizedLogLuma = LumaTex[DTid.xy + uint2(0, TopY)];
-        InterlockedAdd( g_TileHistogram[QuantizedLogLuma], 1 );
+        uint2 Pos = TileCorner + uint2(GTid.x, GTid.y + i * 16);
+        bool bValid = all(Pos < LumaSize);
+        uint QuantizedLogLuma = bValid ? LumaTex[Pos] : 0;
+        AddToTileHistogram(QuantizedLogLuma, bValid);
     }
 
     GroupMemoryBarrierWithGroupSync();
 
-    Histogram.InterlockedAdd( GI * 4, g_TileHistogram[GI] );
+    uint Count = g_TileHistogram[GI];
+    if (Count > 0)
+        Histogram.InterlockedAdd( GI * 4, Count );
 }
 
 
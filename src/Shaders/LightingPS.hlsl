@@ -33,6 +33,17 @@ Texture2D DDGIProbeDistanceSRV: register(t11);
 RWTexture2D<uint> DDGIProbeStates : register(u0);
 RWTexture2D<float4> DDGIProbeOffsets : register(u1);
 
+// coarser cascades, each one twice the spacing of the previous.
+Texture2D DDGIProbeIrradianceSRV1: register(t12);
+Texture2D DDGIProbeDistanceSRV1: register(t13);
+Texture2D DDGIProbeIrradianceSRV2: register(t14);
+Texture2D DDGIProbeDistanceSRV2: register(t15);
+
+RWTexture2D<uint> DDGIProbeStates1 : register(u2);
+RWTexture2D<float4> DDGIProbeOffsets1 : register(u3);
+RWTexture2D<uint> DDGIProbeStates2 : register(u4);
+RWTexture2D<float4> DDGIProbeOffsets2 : register(u5);
+
 
 
 
@@ -55,6 +66,50 @@ cbuffer LightingParam : register(b0)
 };
 
 ConstantBuffer<DDGIVolumeDescGPU> DDGIVolume    : register(b1);
+ConstantBuffer<DDGIVolumeDescGPU> DDGIVolume1    : register(b2);
+ConstantBuffer<DDGIVolumeDescGPU> DDGIVolume2    : register(b3);
+
+float3 GetCascadeIrradiance(float3 WorldPos, float3 WorldNormal, float3 cameraDirection, DDGIVolumeDescGPU Volume,
+    Texture2D ProbeIrradiance, Texture2D ProbeDistance, RWTexture2D<uint> ProbeStates, RWTexture2D<float4> ProbeOffsets)
+{
+    float3 surfaceBias = DDGIGetSurfaceBias(WorldNormal, cameraDirection, Volume);
+
+    DDGIVolumeResources resources;
+    resources.probeIrradianceSRV = ProbeIrradiance;
+    resources.probeDistanceSRV = ProbeDistance;
+    resources.trilinearSampler = TrilinearSampler;
+#if RTXGI_DDGI_PROBE_RELOCATION
+    resources.probeOffsets = ProbeOffsets;
+#endif
+#if RTXGI_DDGI_PROBE_STATE_CLASSIFIER
+    resources.probeStates = ProbeStates;
+#endif
+
+    return DDGIGetVolumeIrradiance(WorldPos, surfaceBias, WorldNormal, Volume, resources);
+}
+
+// the coarsest cascade covers everything, finer ones fade in over their last probe cell.
+float3 GetCascadedIrradiance(float3 WorldPos, float3 WorldNormal, float3 cameraDirection)
+{
+    float3 irradiance = GetCascadeIrradiance(WorldPos, WorldNormal, cameraDirection, DDGIVolume2,
+        DDGIProbeIrradianceSRV2, DDGIProbeDistanceSRV2, DDGIProbeStates2, DDGIProbeOffsets2);
+
+    float weight = DDGIGetVolumeBlendWeight(WorldPos, DDGIVolume1);
+    if (weight > 0)
+    {
+        irradiance = lerp(irradiance, GetCascadeIrradiance(WorldPos, WorldNormal, cameraDirection, DDGIVolume1,
+            DDGIProbeIrradianceSRV1, DDGIProbeDistanceSRV1, DDGIProbeStates1, DDGIProbeOffsets1), weight);
+    }
+
+    weight = DDGIGetVolumeBlendWeight(WorldPos, DDGIVolume);
+    if (weight > 0)
+    {
+        irradiance = lerp(irradiance, GetCascadeIrradiance(WorldPos, WorldNormal, cameraDirection, DDGIVolume,
+            DDGIProbeIrradianceSRV, DDGIProbeDistanceSRV, DDGIProbeStates, DDGIProbeOffsets), weight);
+    }
+
+    return irradiance;
+}
 
 
 struct VSInput
@@ -127,27 +182,7 @@ float4 PSMain(PSInput input) : SV_TARGET
 			float3 ViewPosition = GetViewPosition(DeviceDepth, ScreenPosition, InvProjMatrix);
 			float3 WorldPos = mul(float4(ViewPosition, 1), InvViewMatrix).xyz;
 			float3 cameraDirection = normalize(ViewPosition - CameraPosition.xyz);
-			float3 surfaceBias = DDGIGetSurfaceBias(WorldNormal, cameraDirection, DDGIVolume);
-
-			DDGIVolumeResources resources;
-			resources.probeIrradianceSRV = DDGIProbeIrradianceSRV;
-			resources.probeDistanceSRV = DDGIProbeDistanceSRV;
-			resources.trilinearSampler = TrilinearSampler;
-#if RTXGI_DDGI_PROBE_RELOCATION
-			resources.probeOffsets = DDGIProbeOffsets;
-#endif
-#if RTXGI_DDGI_PROBE_STATE_CLASSIFIER
-			resources.probeStates = DDGIProbeStates;
-#endif
-
-			float3 irradiance = 0.f;
-
-			irradiance = DDGIGetVolumeIrradiance(
-            WorldPos.xyz,
-            surfaceBias,
-            WorldNormal,
-            DDGIVolume,
-            resources);
+			float3 irradiance = GetCascadedIrradiance(WorldPos, WorldNormal, cameraDirection);
 
 			if (DeviceDepth == 1)
 				IndirectDiffuse = float4(0, 0, 0, 0);
@@ -0,0 +1,63 @@
+// reduced rate ray dispatch of the rt reflection and gi passes. mirrors RayBudget.h.
+// one pixel per cell is traced, the traced pixel rotates with the frame index.
+
+#define RAY_BUDGET_FULL 0
+#define RAY_BUDGET_CHECKERBOARD 1
+#define RAY_BUDGET_QUARTER 2
+#define RAY_BUDGET_NINTH 3
+#define RAY_BUDGET_ADAPTIVE 4
+
+// adaptive tiles are a multiple of every cell size so cells never straddle two tiles.
+#define RAY_BUDGET_TILE_SIZE 12
+
+static const uint2 QuarterOffsets[4] = { uint2(0, 0), uint2(1, 1), uint2(1, 0), uint2(0, 1) };
+static const uint2 NinthOffsets[9] = { uint2(0, 0), uint2(2, 1), uint2(1, 2), uint2(2, 0), uint2(0, 2), uint2(1, 1), uint2(2, 2), uint2(0, 1), uint2(1, 0) };
+
+uint2 GetRayBudgetCellSize(uint Mode)
+{
+	if (Mode == RAY_BUDGET_CHECKERBOARD)
+		return uint2(2, 1);
+	else if (Mode == RAY_BUDGET_QUARTER)
+		return uint2(2, 2);
+	else if (Mode == RAY_BUDGET_NINTH)
+		return uint2(3, 3);
+	return uint2(1, 1);
+}
+
+uint2 GetTracedPixel(uint Mode, uint2 Cell, uint FrameIndex)
+{
+	uint2 Offset = uint2(0, 0);
+	if (Mode == RAY_BUDGET_CHECKERBOARD)
+		Offset = uint2((Cell.y + FrameIndex) & 1, 0);
+	else if (Mode == RAY_BUDGET_QUARTER)
+		Offset = QuarterOffsets[FrameIndex % 4];
+	else if (Mode == RAY_BUDGET_NINTH)
+		Offset = NinthOffsets[FrameIndex % 9];
+
+	return Cell * GetRayBudgetCellSize(Mode) + Offset;
+}
+
+bool IsTracedPixel(uint Mode, uint2 Pixel, uint FrameIndex)
+{
+	return all(GetTracedPixel(Mode, Pixel / GetRayBudgetCellSize(Mode), FrameIndex) == Pixel);
+}
+
+// mode of the tile holding Pixel. TileRayBudgetTex is written by RayBudgetClassifyCS.hlsl.
+uint GetPixelRayBudgetMode(uint Mode, Texture2D<uint> TileRayBudgetTex, uint2 Pixel)
+{
+	return Mode == RAY_BUDGET_ADAPTIVE ? TileRayBudgetTex[Pixel / RAY_BUDGET_TILE_SIZE] : Mode;
+}
+
+// pixel traced by a ray generation thread. fixed modes dispatch one ray per cell,
+// adaptive mode dispatches one ray per pixel and skips the pixels its tile does not trace this frame.
+bool GetRayBudgetPixel(uint Mode, uint2 DispatchIndex, uint FrameIndex, Texture2D<uint> TileRayBudgetTex, out uint2 Pixel)
+{
+	if (Mode == RAY_BUDGET_ADAPTIVE)
+	{
+		Pixel = DispatchIndex;
+		return IsTracedPixel(TileRayBudgetTex[DispatchIndex / RAY_BUDGET_TILE_SIZE], Pixel, FrameIndex);
+	}
+
+	Pixel = GetTracedPixel(Mode, DispatchIndex, FrameIndex);
+	return true;
+}
@@ -0,0 +1,108 @@
+#include "RayBudget.hlsl"
+
+// picks the ray budget of every adaptive tile from last frame's temporal denoiser output.
+// one group per tile. the luma variance, history length, disocclusion and roughness of the tile
+// are reduced in groupshared memory, then mapped to a mode like ClassifyRayBudgetTile in RayBudget.cpp.
+
+Texture2D SpecularTemporalTex : register(t0);
+Texture2D DiffuseSHTemporalTex : register(t1);
+Texture2D VelocityTex : register(t2);
+Texture2D RoughnessMetalicTex : register(t3);
+
+RWTexture2D<uint> TileRayBudget : register(u0);
+
+cbuffer RayBudgetClassifyCB : register(b0)
+{
+	float2 RTSize;
+	uint NumTilesX;
+	uint NumTilesY;
+	float HighVariance;
+	float LowVariance;
+	float ConvergedHistory;
+	float DisocclusionRatio;
+	float RoughThreshold;
+};
+
+#define NUM_THREADS (RAY_BUDGET_TILE_SIZE * RAY_BUDGET_TILE_SIZE)
+
+// specular luma, its square, diffuse luma, its square
+groupshared float4 g_Luma[NUM_THREADS];
+// history, disoccluded, roughness, valid
+groupshared float4 g_Tile[NUM_THREADS];
+
+float CoefficientOfVariation(float Sum, float SumSq, float Count)
+{
+	float Mean = Sum / Count;
+	float Variance = max(SumSq / Count - Mean * Mean, 0);
+	return sqrt(Variance) / (abs(Mean) + 0.0001);
+}
+
+[numthreads(RAY_BUDGET_TILE_SIZE, RAY_BUDGET_TILE_SIZE, 1)]
+void RayBudgetClassify(uint GI : SV_GroupIndex, uint3 GTid : SV_GroupThreadID, uint3 Gid : SV_GroupID)
+{
+	int2 Pixel = int2(Gid.xy * RAY_BUDGET_TILE_SIZE + GTid.xy);
+
+	float4 Luma = 0;
+	float4 Tile = 0;
+	if (all(Pixel < int2(RTSize)))
+	{
+		// history follows the pixel, so it is fetched at the reprojected position.
+		float2 Velocity = VelocityTex[Pixel].xy;
+		int2 PrevPixel = int2(floor(Pixel + 0.5 - Velocity * RTSize));
+
+		float4 Specular = SpecularTemporalTex[PrevPixel];
+		float History = Specular.w * 10.0;
+		float SpecularLuma = dot(Specular.xyz, float3(0.2126, 0.7152, 0.0722));
+		float DiffuseLuma = DiffuseSHTemporalTex[PrevPixel].w;
+
+		Luma = float4(SpecularLuma, SpecularLuma * SpecularLuma, DiffuseLuma, DiffuseLuma * DiffuseLuma);
+		Tile = float4(History, History < 1.0 ? 1 : 0, RoughnessMetalicTex[Pixel].x, 1);
+	}
+
+	g_Luma[GI] = Luma;
+	g_Tile[GI] = Tile;
+
+	GroupMemoryBarrierWithGroupSync();
+
+	// 144 threads, fold the last 16 in before the power of two reduction.
+	if (GI < NUM_THREADS - 128)
+	{
+		g_Luma[GI] += g_Luma[GI + 128];
+		g_Tile[GI] += g_Tile[GI + 128];
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	[unroll]
+	for (uint Stride = 64; Stride > 0; Stride >>= 1)
+	{
+		if (GI < Stride)
+		{
+			g_Luma[GI] += g_Luma[GI + Stride];
+			g_Tile[GI] += g_Tile[GI + Stride];
+		}
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	if (GI == 0)
+	{
+		float4 SumLuma = g_Luma[0];
+		float4 SumTile = g_Tile[0];
+		float Count = max(SumTile.w, 1);
+
+		float Variance = max(CoefficientOfVariation(SumLuma.x, SumLuma.y, Count), CoefficientOfVariation(SumLuma.z, SumLuma.w, Count));
+		float History = SumTile.x / Count;
+		float Disocclusion = SumTile.y / Count;
+		float Roughness = SumTile.z / Count;
+
+		uint Mode;
+		if (Disocclusion > DisocclusionRatio || Variance > HighVariance)
+			Mode = RAY_BUDGET_FULL;
+		else if (Variance > LowVariance || History < ConvergedHistory)
+			Mode = RAY_BUDGET_CHECKERBOARD;
+		else
+			Mode = Roughness > RoughThreshold ? RAY_BUDGET_NINTH : RAY_BUDGET_QUARTER;
+
+		TileRayBudget[Gid.xy] = Mode;
+	}
+}
@@ -0,0 +1,117 @@
+#include "Common.hlsl"
+#include "RayBudget.hlsl"
+
+// fills the pixels skipped by a reduced rate rt dispatch, in place.
+// candidates are the traced pixels of the 3x3 neighboring cells, weighted by distance, linear depth and normal.
+// traced pixels are only read and untraced ones only written, so no copy of the targets is needed.
+// NUM_TARGETS is 2 for gi (sh, cocg) and 1 for reflection.
+
+#ifndef NUM_TARGETS
+#define NUM_TARGETS 1
+#endif
+
+RWTexture2D<float4> Target0 : register(u0);
+#if NUM_TARGETS > 1
+RWTexture2D<float4> Target1 : register(u1);
+#endif
+
+Texture2D DepthTex : register(t0);
+Texture2D WorldNormalTex : register(t1);
+Texture2D<uint> TileRayBudgetTex : register(t2);
+
+cbuffer RayReconstructCB : register(b0)
+{
+	float4 ProjectionParams;
+	uint RayBudgetMode;
+	uint FrameIndex;
+	uint RTWidth;
+	uint RTHeight;
+	float DepthSigma;
+	float NormalPower;
+};
+
+[numthreads(8, 8, 1)]
+void RayReconstruct(uint3 DTid : SV_DispatchThreadID)
+{
+	uint2 Pixel = DTid.xy;
+	if (any(Pixel >= uint2(RTWidth, RTHeight)))
+		return;
+
+	uint Mode = GetPixelRayBudgetMode(RayBudgetMode, TileRayBudgetTex, Pixel);
+	if (IsTracedPixel(Mode, Pixel, FrameIndex))
+		return;
+
+	uint2 CellSize = GetRayBudgetCellSize(Mode);
+	int2 NumCells = int2((uint2(RTWidth, RTHeight) + CellSize - 1) / CellSize);
+	int2 Cell = int2(Pixel / CellSize);
+
+	float LinearDepth = GetLinearDepthOpenGL(DepthTex[Pixel].x, ProjectionParams.z, ProjectionParams.w);
+	float3 N = WorldNormalTex[Pixel].xyz;
+
+	float4 Sum0 = 0;
+	float4 Nearest0 = 0;
+#if NUM_TARGETS > 1
+	float4 Sum1 = 0;
+	float4 Nearest1 = 0;
+#endif
+	float WeightSum = 0;
+	uint NearestDist = 0xffffffff;
+
+	for (int y = -1; y <= 1; y++)
+	{
+		for (int x = -1; x <= 1; x++)
+		{
+			int2 C = Cell + int2(x, y);
+			if (any(C < 0) || any(C >= NumCells))
+				continue;
+
+			uint2 Q = GetTracedPixel(Mode, uint2(C), FrameIndex);
+			if (any(Q >= uint2(RTWidth, RTHeight)))
+				continue;
+
+			// a neighboring adaptive tile can trace at a different rate, its cell around Q has the ray.
+			// skipping it instead leaves the pixels of a partial tile without any sample on the frames
+			// their own ray is off screen.
+			uint NeighborMode = GetPixelRayBudgetMode(RayBudgetMode, TileRayBudgetTex, Q);
+			if (NeighborMode != Mode)
+			{
+				Q = GetTracedPixel(NeighborMode, Q / GetRayBudgetCellSize(NeighborMode), FrameIndex);
+				if (any(Q >= uint2(RTWidth, RTHeight)))
+					continue;
+			}
+
+			int2 D = int2(Q) - int2(Pixel);
+			uint Dist2 = uint(dot(D, D));
+
+			float SampleDepth = GetLinearDepthOpenGL(DepthTex[Q].x, ProjectionParams.z, ProjectionParams.w);
+			float3 SampleNormal = WorldNormalTex[Q].xyz;
+
+			float SpatialWeight = 1.0 / (1.0 + Dist2);
+			float DepthWeight = exp(-abs(SampleDepth - LinearDepth) / (LinearDepth * DepthSigma));
+			float NormalWeight = pow(saturate(dot(N, SampleNormal)), NormalPower);
+			float Weight = SpatialWeight * DepthWeight * NormalWeight;
+
+			float4 Value0 = Target0[Q];
+			Sum0 += Value0 * Weight;
+#if NUM_TARGETS > 1
+			float4 Value1 = Target1[Q];
+			Sum1 += Value1 * Weight;
+#endif
+			if (Dist2 < NearestDist)
+			{
+				NearestDist = Dist2;
+				Nearest0 = Value0;
+#if NUM_TARGETS > 1
+				Nearest1 = Value1;
+#endif
+			}
+			WeightSum += Weight;
+		}
+	}
+
+	bool bValid = WeightSum > 0.0001;
+	Target0[Pixel] = bValid ? Sum0 / WeightSum : Nearest0;
+#if NUM_TARGETS > 1
+	Target1[Pixel] = bValid ? Sum1 / WeightSum : Nearest1;
+#endif
+}
@@ -1,4 +1,5 @@
 #include "Common.hlsl"
+#include "RayBudget.hlsl"
 #include "NRD.hlsl"
 
 RWTexture2D<float4> GIResultSH : register(u0);
@@ -13,6 +14,7 @@ ByteAddressBuffer indices : register(t4);
 Texture2D AlbedoTex : register(t5);
 ByteAddressBuffer InstanceProperty : register(t6);
 Texture3D BlueNoiseTex : register(t7);
+Texture2D<uint> TileRayBudgetTex : register(t8);
 
 
 cbuffer ViewParameter : register(b0)
@@ -28,6 +30,9 @@ cbuffer ViewParameter : register(b0)
     uint BlueNoiseOffsetStride;
     float ViewSpreadAngle;
 	uint bPackNRD;
+	uint RayBudgetMode;
+	uint RTWidth;
+	uint RTHeight;
 };
 
 SamplerState sampleWrap : register(s0);
@@ -108,8 +113,13 @@ float3x3 buildTBN(float3 normal) {
 void rayGen
 ()
 {
-	uint3 launchIndex = DispatchRaysIndex();
-	uint3 launchDim = DispatchRaysDimensions();
+	// launchIndex is the traced pixel from here on.
+	uint2 PixelPos;
+	bool bTrace = GetRayBudgetPixel(RayBudgetMode, DispatchRaysIndex().xy, FrameCounter, TileRayBudgetTex, PixelPos);
+	uint3 launchIndex = uint3(PixelPos, 0);
+	uint3 launchDim = uint3(RTWidth, RTHeight, 1);
+	if (!bTrace || any(launchIndex.xy >= launchDim.xy))
+		return;
 
 
 	float2 crd = float2(launchIndex.xy);
@@ -1,4 +1,5 @@
 #include "Common.hlsl"
+#include "RayBudget.hlsl"
 
 RWTexture2D<float4> ReflectionResult : register(u0);
 
@@ -12,6 +13,7 @@ Texture2D RougnessMetallicTex : register(t6);
 Texture3D BlueNoiseTex : register(t7);
 Texture2D WorldNormalTex : register(t8);
 ByteAddressBuffer InstanceProperty : register(t9);
+Texture2D<uint> TileRayBudgetTex : register(t10);
 
 cbuffer ViewParameter : register(b0)
 {
@@ -25,6 +27,9 @@ cbuffer ViewParameter : register(b0)
     uint FrameCounter;
     uint BlueNoiseOffsetStride;
     float ViewSpreadAngle;
+    uint RayBudgetMode;
+    uint RTWidth;
+    uint RTHeight;
 };
 
 SamplerState sampleWrap : register(s0);
@@ -175,8 +180,13 @@ static const float MAX_HIT_DIST = 10000;
 void rayGen
 ()
 {
-    uint3 launchIndex = DispatchRaysIndex();
-    uint3 launchDim = DispatchRaysDimensions();
+    // launchIndex is the traced pixel from here on.
+    uint2 PixelPos;
+    bool bTrace = GetRayBudgetPixel(RayBudgetMode, DispatchRaysIndex().xy, FrameCounter, TileRayBudgetTex, PixelPos);
+    uint3 launchIndex = uint3(PixelPos, 0);
+    uint3 launchDim = uint3(RTWidth, RTHeight, 1);
+    if (!bTrace || any(launchIndex.xy >= launchDim.xy))
+        return;
 
     float2 crd = float2(launchIndex.xy);
 	//crd.y *= -1;
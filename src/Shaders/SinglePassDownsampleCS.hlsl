@@ -0,0 +1,109 @@
+// single dispatch 2x2 box downsample of a whole mip chain. (after AMD FidelityFX SPD)
+// each group reduces a 64x64 tile of mip 0 down to mip 6 in groupshared memory.
+// the last group to finish, found with an atomic counter, builds the remaining mips from mip 6.
+// mip sizes are halved with floor, so the 4 sources of a texel are always inside the upper mip.
+
+#define MAX_MIPS 13
+#define TILE_SIZE 64
+#define LDS_SIZE 32
+
+globallycoherent RWTexture2D<float4> Mips[MAX_MIPS] : register(u0);
+globallycoherent RWByteAddressBuffer AtomicCounter : register(u13);
+
+cbuffer DownsampleCB : register(b0)
+{
+	uint2 SrcSize;
+	uint NumMips;
+	uint NumWorkGroups;
+};
+
+groupshared float4 Tile[LDS_SIZE * LDS_SIZE];
+groupshared uint bLastGroup;
+
+uint2 MipSize(uint Mip)
+{
+	return max(SrcSize >> Mip, 1);
+}
+
+void StoreMip(uint Mip, uint2 Pos, float4 Value)
+{
+	if (all(Pos < MipSize(Mip)))
+		Mips[Mip][Pos] = Value;
+}
+
+float4 Reduce(float4 v0, float4 v1, float4 v2, float4 v3)
+{
+	return (v0 + v1 + v2 + v3) * 0.25;
+}
+
+[numthreads(256, 1, 1)]
+void SinglePassDownsample(uint3 GroupId : SV_GroupID, uint GI : SV_GroupIndex)
+{
+	// mip 1. 32x32 per group, 2x2 texels per thread.
+	uint2 ThreadPos = uint2(GI % 16, GI / 16) * 2;
+	for (uint i = 0; i < 4; i++)
+	{
+		uint2 Local = ThreadPos + uint2(i & 1, i >> 1);
+		uint2 Pos = GroupId.xy * LDS_SIZE + Local;
+		uint2 Src = Pos * 2;
+
+		float4 Value = Reduce(Mips[0][Src], Mips[0][Src + uint2(1, 0)], Mips[0][Src + uint2(0, 1)], Mips[0][Src + uint2(1, 1)]);
+		Tile[Local.y * LDS_SIZE + Local.x] = Value;
+		StoreMip(1, Pos, Value);
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	// mips 2..6 are reduced in place. a texel of mip n is kept at the slot of its first source.
+	uint Size = LDS_SIZE / 2;
+	for (uint Mip = 2; Mip <= 6 && Mip < NumMips; Mip++)
+	{
+		if (GI < Size * Size)
+		{
+			uint2 Local = uint2(GI % Size, GI / Size);
+			uint Step = 1u << (Mip - 2);
+			uint2 Src = Local * 2 * Step;
+
+			float4 Value = Reduce(Tile[Src.y * LDS_SIZE + Src.x], Tile[Src.y * LDS_SIZE + Src.x + Step],
+				Tile[(Src.y + Step) * LDS_SIZE + Src.x], Tile[(Src.y + Step) * LDS_SIZE + Src.x + Step]);
+			Tile[Src.y * LDS_SIZE + Src.x] = Value;
+			StoreMip(Mip, GroupId.xy * Size + Local, Value);
+		}
+		Size /= 2;
+		GroupMemoryBarrierWithGroupSync();
+	}
+
+	if (NumMips <= 7)
+		return;
+
+	// make mip 6 visible to the other groups before counting this one as finished.
+	DeviceMemoryBarrier();
+
+	if (GI == 0)
+	{
+		uint Counter;
+		AtomicCounter.InterlockedAdd(0, 1, Counter);
+		bLastGroup = Counter == NumWorkGroups - 1;
+	}
+
+	GroupMemoryBarrierWithGroupSync();
+
+	if (!bLastGroup)
+		return;
+
+	for (uint Mip = 7; Mip < NumMips; Mip++)
+	{
+		uint2 DstSize = MipSize(Mip);
+		for (uint i = GI; i < DstSize.x * DstSize.y; i += 256)
+		{
+			uint2 Pos = uint2(i % DstSize.x, i / DstSize.x);
+			uint2 Src = Pos * 2;
+			Mips[Mip][Pos] = Reduce(Mips[Mip - 1][Src], Mips[Mip - 1][Src + uint2(1, 0)], Mips[Mip - 1][Src + uint2(0, 1)], Mips[Mip - 1][Src + uint2(1, 1)]);
+		}
+		DeviceMemoryBarrierWithGroupSync();
+	}
+
+	// ready for the next dispatch
+	if (GI == 0)
+		AtomicCounter.Store(0, 0);
+}
@@ -1,10 +1,30 @@
 #include "Common.hlsl"
 
+// CLAMP_MODE and FILTER_TYPE are compiled in, one pso per clamp mode. (Corona::InitTemporalAAPass)
+// TemporalAACPU.cpp mirrors this shader.
+#define RGB_CLAMP 0
+#define AABB_CLIP 1
+#define VARIANCE_CLIP 2
+
+#ifndef CLAMP_MODE
+#define CLAMP_MODE VARIANCE_CLIP
+#endif
+
+// -1 : the center sample is the current color. 0..9 : see Filter.
+#ifndef FILTER_TYPE
+#define FILTER_TYPE -1
+#endif
+
+#define GROUP_SIZE 8
+#define TILE_BORDER 1
+#define TILE_SIZE (GROUP_SIZE + 2 * TILE_BORDER)
+
 [[vk::binding(0, VULKAN_SRV_SPACE)]] Texture2D CurrentColorTex : register(t0);
 Texture2D PrevColorTex : register(t1);
 Texture2D VelocityTex : register(t2);
 Texture2D DepthTex : register(t3);
-// Texture2D BloomTex : register(t4);
+
+RWTexture2D<float4> ResolveTex : register(u0);
 
 SamplerState sampleWrap : register(s0);
 
@@ -13,34 +33,8 @@ cbuffer TemporalAAParam : register(b0)
 {
     float2 RTSize;
     float TAABlendFactor;
-    uint ClampMode;
-    // float Exposure;
-    // float BloomStrength;
 };
 
-struct VSInput
-{
-    float4 position : POSITION;
-    float2 uv : TEXCOORD;
-};
-
-struct PSInput
-{
-    float4 position : SV_POSITION;
-    float2 uv : TEXCOORD;
-};
-
-PSInput VSMain(
-    VSInput input)
-{
-    PSInput result;
-
-    result.position = input.position;
-    result.uv = input.uv;
-
-    return result;
-}
-
 static const float Pi = 3.14159265359;
 static const float CubicB = 0.33f;
 static const float CubicC = 0.33f;
@@ -107,82 +101,73 @@ float FilterSmoothstep(in float x)
     return 1.0f - smoothstep(0.0f, 1.0f, x);
 }
 
-float Filter(in float x, in int filterType, in float filterRadius, in bool rescaleCubic)
+float Filter(in float x, in float filterRadius)
 {
     // Cubic filters naturually work in a [-2, 2] domain. For the resolve case we
     // want to rescale the filter so that it works in [-1, 1] instead
-    float cubicX = rescaleCubic ? x * 2.0f : x;
-
-    if(filterType == 0)
-        return FilterBox(x);
-    else if(filterType == 1)
-        return FilterTriangle(x);
-    else if(filterType == 2)
-        return FilterGaussian(x);
-    else if(filterType == 3)
-        return FilterBlackmanHarris(x);
-    else if(filterType == 4)
-        return FilterSmoothstep(x);
-    else if(filterType == 5)
-        return FilterCubic(cubicX, 1.0, 0.0f);
-    else if(filterType == 6)
-        return FilterCubic(cubicX, 0, 0.5f);
-    else if(filterType == 7)
-        return FilterCubic(cubicX, 1 / 3.0f, 1 / 3.0f);
-    else if(filterType == 8)
-        return FilterCubic(cubicX, CubicB, CubicC);
-    else if(filterType == 9)
-        return FilterSinc(x, filterRadius);
-    else
-        return 1.0f;
+    float cubicX = x * 2.0f;
+
+#if FILTER_TYPE == 0
+    return FilterBox(x);
+#elif FILTER_TYPE == 1
+    return FilterTriangle(x);
+#elif FILTER_TYPE == 2
+    return FilterGaussian(x);
+#elif FILTER_TYPE == 3
+    return FilterBlackmanHarris(x);
+#elif FILTER_TYPE == 4
+    return FilterSmoothstep(x);
+#elif FILTER_TYPE == 5
+    return FilterCubic(cubicX, 1.0, 0.0f);
+#elif FILTER_TYPE == 6
+    return FilterCubic(cubicX, 0, 0.5f);
+#elif FILTER_TYPE == 7
+    return FilterCubic(cubicX, 1 / 3.0f, 1 / 3.0f);
+#elif FILTER_TYPE == 8
+    return FilterCubic(cubicX, CubicB, CubicC);
+#elif FILTER_TYPE == 9
+    return FilterSinc(x, filterRadius);
+#else
+    return 1.0f;
+#endif
 }
 
-float3 ClipAABB(float3 aabbMin, float3 aabbMax, float3 prevSample, float3 avg)
+float3 ClipAABB(float3 aabbMin, float3 aabbMax, float3 prevSample)
 {
-    #if 1
-        // note: only clips towards aabb center (but fast!)
-        float3 p_clip = 0.5 * (aabbMax + aabbMin);
-        float3 e_clip = 0.5 * (aabbMax - aabbMin);
-
-        float3 v_clip = prevSample - p_clip;
-        float3 v_unit = v_clip.xyz / e_clip;
-        float3 a_unit = abs(v_unit);
-        float ma_unit = max(a_unit.x, max(a_unit.y, a_unit.z));
-
-        if (ma_unit > 1.0)
-            return p_clip + v_clip / ma_unit;
-        else
-            return prevSample;// point inside aabb
-    #else
-        float3 r = prevSample - avg;
-        float3 rmax = aabbMax - avg.xyz;
-        float3 rmin = aabbMin - avg.xyz;
-
-        const float eps = 0.000001f;
-
-        if (r.x > rmax.x + eps)
-            r *= (rmax.x / r.x);
-        if (r.y > rmax.y + eps)
-            r *= (rmax.y / r.y);
-        if (r.z > rmax.z + eps)
-            r *= (rmax.z / r.z);
-
-        if (r.x < rmin.x - eps)
-            r *= (rmin.x / r.x);
-        if (r.y < rmin.y - eps)
-            r *= (rmin.y / r.y);
-        if (r.z < rmin.z - eps)
-            r *= (rmin.z / r.z);
-
-        return avg + r;
-    #endif
+    // note: only clips towards aabb center (but fast!)
+    float3 p_clip = 0.5 * (aabbMax + aabbMin);
+    float3 e_clip = 0.5 * (aabbMax - aabbMin);
+
+    float3 v_clip = prevSample - p_clip;
+    float3 v_unit = v_clip.xyz / e_clip;
+    float3 a_unit = abs(v_unit);
+    float ma_unit = max(a_unit.x, max(a_unit.y, a_unit.z));
+
+    if (ma_unit > 1.0)
+        return p_clip + v_clip / ma_unit;
+    else
+        return prevSample;// point inside aabb
 }
 
-#define VARIANCE_CLIP 0
-#define RGB_CLAMP 1
+// current color of the group and a 1 pixel border, clamped to the screen.
+groupshared float3 ColorTile[TILE_SIZE * TILE_SIZE];
 
-float4 PSMain(PSInput input) : SV_TARGET
+[numthreads(GROUP_SIZE, GROUP_SIZE, 1)]
+void TemporalAA(uint3 DTid : SV_DispatchThreadID, uint3 GroupId : SV_GroupID, uint3 GTid : SV_GroupThreadID, uint GI : SV_GroupIndex)
 {
+    int2 TileOrigin = int2(GroupId.xy * GROUP_SIZE) - TILE_BORDER;
+    for (uint i = GI; i < TILE_SIZE * TILE_SIZE; i += GROUP_SIZE * GROUP_SIZE)
+    {
+        int2 Pos = TileOrigin + int2(i % TILE_SIZE, i / TILE_SIZE);
+        Pos = clamp(Pos, 0, int2(RTSize) - 1);
+        ColorTile[i] = CurrentColorTex[Pos].xyz;
+    }
+
+    GroupMemoryBarrierWithGroupSync();
+
+    if (any(DTid.xy >= uint2(RTSize)))
+        return;
+
     float LowFreqWeight = 0.25f;
     float HiFreqWeight = 0.85f;
     float3 clrMin = 99999999.0f;
@@ -190,10 +175,10 @@ float4 PSMain(PSInput input) : SV_TARGET
     float3 m1 = 0.0f;
     float3 m2 = 0.0f;
     float mWeight = 0.0f;
+    float3 filtered = 0.0f;
+    float filteredWeight = 0.0f;
 
-    input.uv.y = 1 - input.uv.y;
-    float2 PixelPos = input.uv * RTSize;
-
+    float2 PixelPos = DTid.xy + 0.5;
 
     const int SampleRadius_ = 1;
 
@@ -202,64 +187,63 @@ float4 PSMain(PSInput input) : SV_TARGET
 	const float ResolveFilterDiameter = 2.0f;
 
 	// neighborhood clamping of Playdead Inside.
+    [unroll]
     for(int y = -SampleRadius_; y <= SampleRadius_; ++y)
     {
+        [unroll]
         for(int x = -SampleRadius_; x <= SampleRadius_; ++x)
         {
-            float2 sampleOffset = float2(x, y);
-            float2 samplePos = PixelPos + sampleOffset;
-            samplePos = clamp(samplePos, 0, RTSize - 1.0f);
+            uint2 TilePos = GTid.xy + TILE_BORDER + int2(x, y);
+            float3 sample = ColorTile[TilePos.y * TILE_SIZE + TilePos.x];
 
-            float2 sampleDist = abs(sampleOffset) / (ResolveFilterDiameter / 2.0f);
-
-            float3 sample = CurrentColorTex[samplePos].xyz ;
-          
             clrMin = min(clrMin, sample);
             clrMax = max(clrMax, sample);
 
             m1 += sample;
             m2 += sample * sample;
             mWeight += 1.0f;
+
+#if FILTER_TYPE >= 0
+            float sampleDist = length(float2(x, y)) / (ResolveFilterDiameter / 2.0f);
+            float weight = Filter(sampleDist, filterRadius);
+            filtered += sample * weight;
+            filteredWeight += weight;
+#endif
         }
     }
 
-    float2 Velocity = VelocityTex[PixelPos];
-    // float3 Bloom = BloomTex.SampleLevel( sampleWrap, input.uv, 0);
-    float3 CurrentColor =  CurrentColorTex[PixelPos];//  + Bloom * BloomStrength;
+    float2 Velocity = VelocityTex[DTid.xy].xy;
+#if FILTER_TYPE >= 0
+    float3 CurrentColor = filtered / max(filteredWeight, 0.00001f);
+#else
+    float3 CurrentColor = ColorTile[(GTid.y + TILE_BORDER) * TILE_SIZE + GTid.x + TILE_BORDER];
+#endif
     float2 PrevPixelPos = PixelPos - Velocity * RTSize;
-    // float3 PrevColor = PrevColorTex[PrevPixelPos].xyz;
-    float2 PrevUV = (PrevPixelPos + 0)/RTSize;
-    float3 PrevColor = PrevColorTex.SampleLevel( sampleWrap, PrevUV, 0);
+    float2 PrevUV = PrevPixelPos / RTSize;
+    float3 PrevColor = PrevColorTex.SampleLevel( sampleWrap, PrevUV, 0).xyz;
+
+#if CLAMP_MODE == RGB_CLAMP
+    PrevColor = clamp(PrevColor, clrMin, clrMax);
+#elif CLAMP_MODE == AABB_CLIP
+    PrevColor = ClipAABB(clrMin, clrMax, PrevColor);
+#elif CLAMP_MODE == VARIANCE_CLIP
+    const float VarianceClipGamma = 1.50f;
+
+    float3 mu = m1 / mWeight;
+    float3 sigma = sqrt(abs(m2 / mWeight - mu * mu));
+    float3 minc = mu - VarianceClipGamma * sigma;
+    float3 maxc = mu + VarianceClipGamma * sigma;
+    PrevColor = ClipAABB(minc, maxc, PrevColor);
+#endif
 
+    float3 temporalWeight = saturate(abs(clrMax - clrMin) / CurrentColor);
+    float3 weightB = saturate(lerp(LowFreqWeight, HiFreqWeight, temporalWeight));
 
-    if(ClampMode == 0)
-        PrevColor = clamp(PrevColor, clrMin, clrMax);
-    else if(ClampMode == 1)
-    	PrevColor = ClipAABB(clrMin, clrMax, PrevColor, m1 / mWeight);
-    else if(ClampMode == 2)
-    {
-        const float VarianceClipGamma = 1.50f;
-
-        float3 mu = m1 / mWeight;
-        float3 sigma = sqrt(abs(m2 / mWeight - mu * mu));
-        float3 minc = mu - VarianceClipGamma * sigma;
-        float3 maxc = mu + VarianceClipGamma * sigma;
-        PrevColor = ClipAABB(minc, maxc, PrevColor, mu);
-    }   
-
-    // float Depth = DepthTex[PixelPos];
-    // float PrevDepth = DepthTex[PrevPixelPos];
-
-    float BlendFactor = TAABlendFactor;
-
-    
-    float3 weightA = saturate(1.0f - BlendFactor);
-    float3 weightB = saturate(BlendFactor);
-
+    // no history when taa is off (NO_AA sets 1). below 1 TAABlendFactor isn't used, the weight above is.
+    if (TAABlendFactor >= 1.0f)
+        weightB = 0.0f;
 
-    float3 temporalWeight = saturate(abs(clrMax - clrMin) / CurrentColor);
-    weightB = saturate(lerp(LowFreqWeight, HiFreqWeight, temporalWeight));
-    weightA = 1.0f - weightB;
+    float3 weightA = 1.0f - weightB;
 
-    return  float4((CurrentColor * weightA + PrevColor * weightB) / (weightA + weightB), 1);
-}
\ No newline at end of file
+    ResolveTex[DTid.xy] = float4((CurrentColor * weightA + PrevColor * weightB) / (weightA + weightB), 1);
+}
@@ -13,6 +13,8 @@ Texture2D DDGIProbeDistanceSRV : register(t2);
 // Texture2D DDGIProbeStates : register(t3);
 // Texture2D DDGIProbeOffsets : register(t4);
 Texture3D BlueNoiseTex : register(t5);
+// probe indices traced this frame, one dispatch row each.
+ByteAddressBuffer ScheduledProbes : register(t6);
 
 
 ByteAddressBuffer vertices : register(t10);
@@ -95,7 +97,8 @@ void rayGen
 
     uint2 DispatchIndex = DispatchRaysIndex().xy;
     int rayIndex = DispatchIndex.x;                    // index of ray within a probe
-    int probeIndex = DispatchIndex.y;                  // index of current probe
+    int probeIndex = ScheduledProbes.Load(DispatchIndex.y * 4); // index of current probe
+    int2 probeRayIndex = int2(rayIndex, probeIndex);
 
 #if RTXGI_DDGI_PROBE_STATE_CLASSIFIER
     int2 texelPosition = DDGIGetProbeTexelPosition(probeIndex, DDGIVolume.probeGridCounts);
@@ -107,13 +110,13 @@ void rayGen
 #endif
 
  #if RTXGI_DDGI_PROBE_RELOCATION
-     float3 probeWorldPosition = DDGIGetProbeWorldPositionWithOffset(probeIndex, DDGIVolume.origin, DDGIVolume.probeGridCounts, DDGIVolume.probeGridSpacing, DDGIProbeOffsets);
+     float3 probeWorldPosition = DDGIGetProbeWorldPositionWithOffset(probeIndex, DDGIVolume.origin, DDGIVolume.probeGridCounts, DDGIVolume.probeGridSpacing, DDGIGetScrollDesc(DDGIVolume).probeScrollOffsets, DDGIProbeOffsets);
  #else
-    float3 probeWorldPosition = DDGIGetProbeWorldPosition(probeIndex, DDGIVolume.origin, DDGIVolume.probeGridCounts, DDGIVolume.probeGridSpacing);
+    float3 probeWorldPosition = DDGIGetProbeWorldPosition(probeIndex, DDGIVolume.origin, DDGIVolume.probeGridCounts, DDGIVolume.probeGridSpacing, DDGIGetScrollDesc(DDGIVolume).probeScrollOffsets);
  #endif
 
     
-    probeWorldPosition = DDGIGetProbeWorldPosition(probeIndex, DDGIVolume.origin, DDGIVolume.probeGridCounts, DDGIVolume.probeGridSpacing);
+    probeWorldPosition = DDGIGetProbeWorldPosition(probeIndex, DDGIVolume.origin, DDGIVolume.probeGridCounts, DDGIVolume.probeGridSpacing, DDGIGetScrollDesc(DDGIVolume).probeScrollOffsets);
 
 
     float3 probeRayDirection = DDGIGetProbeRayDirection(rayIndex, DDGIVolume.numRaysPerProbe, DDGIVolume.probeRayRotationTransform);
@@ -144,7 +147,7 @@ void rayGen
         Irradiance = Radiance * cosTerm;
 
         result = float4(Irradiance, 1e27f);
-        DDGIProbeRTRadiance[DispatchIndex.xy] = result;
+        DDGIProbeRTRadiance[probeRayIndex] = result;
         return;
     }
     else
@@ -210,7 +213,7 @@ void rayGen
     //
     result = float4(Irradiance + payload.color/PI * RecursiveIrradiance, payload.hitT);
 
-    DDGIProbeRTRadiance[DispatchIndex.xy] = result;
+    DDGIProbeRTRadiance[probeRayIndex] = result;
 
 }
 
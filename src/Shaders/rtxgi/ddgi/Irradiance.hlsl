@@ -100,13 +100,13 @@ float3 DDGIGetVolumeIrradiance(
 
         // Get the adjacent probe's world position
 #if RTXGI_DDGI_PROBE_RELOCATION
-        float3 adjacentProbeWorldPosition = DDGIGetProbeWorldPositionWithOffset(adjacentProbeCoords, volume.origin, volume.probeGridCounts, volume.probeGridSpacing, resources.probeOffsets);
+        float3 adjacentProbeWorldPosition = DDGIGetProbeWorldPositionWithOffset(adjacentProbeCoords, volume.origin, volume.probeGridCounts, volume.probeGridSpacing, DDGIGetScrollDesc(volume).probeScrollOffsets, resources.probeOffsets);
 #else
         float3 adjacentProbeWorldPosition = DDGIGetProbeWorldPosition(adjacentProbeCoords, volume.origin, volume.probeGridCounts, volume.probeGridSpacing);
 #endif
 
-        // Get the adjacent probe's index (used for texture lookups)
-        int adjacentProbeIndex = DDGIGetProbeIndex(adjacentProbeCoords, volume.probeGridCounts);
+        // Get the adjacent probe's index (used for texture lookups), ring addressed when the volume scrolls
+        int adjacentProbeIndex = DDGIGetProbeIndex(DDGIGetScrollingProbeCoords(adjacentProbeCoords, volume.probeGridCounts, DDGIGetScrollDesc(volume).probeScrollOffsets), volume.probeGridCounts);
 
         // Compute the distance and direction from the (biased and non-biased) shading point and the adjacent probe
         float3 worldPosToAdjProbe = normalize(adjacentProbeWorldPosition - worldPosition);
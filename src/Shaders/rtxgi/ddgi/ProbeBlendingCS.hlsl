@@ -87,6 +87,11 @@ void DDGIProbeBlendingCS(uint3 DispatchThreadID : SV_DispatchThreadID, uint Grou
     }
 #endif /* RTXGI_DDGI_PROBE_STATE_CLASSIFIER */
 
+    if (!DDGIProbeWasTraced(DDGIProbeRTRadianceUAV, probeIndex))
+    {
+        return; // Probe wasn't scheduled this frame, keep its texels as they are
+    }
+
 #if RTXGI_DDGI_BLEND_RADIANCE && RTXGI_DDGI_DEBUG_PROBE_INDEXING && RTXGI_DDGI_DEBUG_FORMAT_IRRADIANCE
     // Visualize the probe index
     DDGIProbeUAV[0][probeTexCoords] = float4(probeIndex, 0, 0, 1);
@@ -190,18 +195,20 @@ void DDGIProbeBlendingCS(uint3 DispatchThreadID : SV_DispatchThreadID, uint Grou
     result.rgb = pow(result.rgb, DDGIVolume.probeInverseIrradianceEncodingGamma);
 #endif
 
-    float  hysteresis = DDGIVolume.probeHysteresis;
+    // Probes that scrolled into the volume this frame hold another probe's data, don't blend with it
+    bool   scrolledIn = DDGIProbeScrolledIn(probeIndex, DDGIVolume);
+    float  hysteresis = scrolledIn ? 0.f : DDGIVolume.probeHysteresis;
     float3 previous = DDGIProbeUAV[PROBE_UAV_INDEX][probeTexCoords].rgb;
 
 #if RTXGI_DDGI_BLEND_RADIANCE
-    if (RTXGIMaxComponent(previous.rgb - result.rgb) > DDGIVolume.probeChangeThreshold)
+    if (!scrolledIn && RTXGIMaxComponent(previous.rgb - result.rgb) > DDGIVolume.probeChangeThreshold)
     {
         // Lower the hysteresis when a large lighting change is detected
         hysteresis = max(0.f, hysteresis - 0.15f);
     }
     
     float3 delta = (result.rgb - previous.rgb);
-    if (length(delta) > DDGIVolume.probeBrightnessThreshold)
+    if (!scrolledIn && length(delta) > DDGIVolume.probeBrightnessThreshold)
     {
         // Clamp the maximum change in irradiance when a large brightness change is detected
         result.rgb = previous.rgb + (delta * 0.25f);
@@ -254,6 +254,59 @@ int3 DDGIGetProbeCoords(int probeIndex, int3 probeGridCounts)
     return probeCoords;
 }
 
+/**
+* Ring addressing of a scrolling volume. The probe at grid coordinates probeCoords is stored at
+* the returned coordinates. probeScrollOffsets is in [0, probeGridCounts).
+*/
+int3 DDGIGetScrollingProbeCoords(int3 probeCoords, int3 probeGridCounts, int3 probeScrollOffsets)
+{
+    return (probeCoords + probeScrollOffsets) % probeGridCounts;
+}
+
+/**
+* The opposite of DDGIGetScrollingProbeCoords(), storage coordinates to grid coordinates.
+*/
+int3 DDGIGetUnscrolledProbeCoords(int3 probeCoords, int3 probeGridCounts, int3 probeScrollOffsets)
+{
+    return (probeCoords - probeScrollOffsets + probeGridCounts) % probeGridCounts;
+}
+
+/**
+* Corona: the ring addressing of a scrolling volume. The SDK's DDGIVolumeDescGPU is unchanged, the application
+* writes these into the last 48 bytes of its padding after DDGIVolume::Update (DDGIScrollDescGPU in DDGICascades.h).
+*/
+struct DDGIScrollDesc
+{
+    int3 probeScrollOffsets;
+    int3 probeScrollClearStart;
+    int3 probeScrollClearCount;
+};
+
+DDGIScrollDesc DDGIGetScrollDesc(DDGIVolumeDescGPU volume)
+{
+    DDGIScrollDesc desc;
+#if !RTXGI_DDGI_PROBE_RELOCATION && !RTXGI_DDGI_PROBE_STATE_CLASSIFIER
+    desc.probeScrollOffsets = asint(volume.padding[3].xyz);
+    desc.probeScrollClearStart = asint(volume.padding[4].xyz);
+    desc.probeScrollClearCount = asint(volume.padding[5].xyz);
+#else
+    desc.probeScrollOffsets = asint(volume.padding1[2].xyz);
+    desc.probeScrollClearStart = asint(volume.padding1[3].xyz);
+    desc.probeScrollClearCount = asint(volume.padding1[4].xyz);
+#endif
+    return desc;
+}
+
+/**
+* True if the probe at the given storage index scrolled into the volume this frame and has no valid history.
+*/
+bool DDGIProbeScrolledIn(int probeIndex, DDGIVolumeDescGPU volume)
+{
+    DDGIScrollDesc scroll = DDGIGetScrollDesc(volume);
+    int3 probeCoords = DDGIGetUnscrolledProbeCoords(DDGIGetProbeCoords(probeIndex, volume.probeGridCounts), volume.probeGridCounts, scroll.probeScrollOffsets);
+    return any((uint3)(probeCoords - scroll.probeScrollClearStart) < (uint3)scroll.probeScrollClearCount);
+}
+
 /**
 * Computes the 3D grid coordinates of the base probe (i.e. floor of xyz) of the 8-probe 
 * cube that surrounds the given world space position. The other seven probes are offset 
@@ -289,11 +342,11 @@ float3 DDGIGetProbeWorldPosition(int3 probeCoords, float3 origin, int3 probeGrid
 }
 
 /*
-* Computes the world space position of the probe at the given probe index (without the probe offsets).
+* Computes the world space position of the probe at the given probe (storage) index (without the probe offsets).
 */
-float3 DDGIGetProbeWorldPosition(int probeIndex, float3 origin, int3 probeGridCounts, float3 probeGridSpacing)
+float3 DDGIGetProbeWorldPosition(int probeIndex, float3 origin, int3 probeGridCounts, float3 probeGridSpacing, int3 probeScrollOffsets)
 {
-    float3 probeCoords = DDGIGetProbeCoords(probeIndex, probeGridCounts);
+    int3 probeCoords = DDGIGetUnscrolledProbeCoords(DDGIGetProbeCoords(probeIndex, probeGridCounts), probeGridCounts, probeScrollOffsets);
     return DDGIGetProbeWorldPosition(probeCoords, origin, probeGridCounts, probeGridSpacing);
 }
 
@@ -322,9 +375,9 @@ void DDGIEncodeProbeOffset(int2 probeOffsetTexcoord, float3 probeGridSpacing, fl
 }
 
 /*
-* Computes the world space position of a probe at the given probe index, including the probe's offset value.
+* Computes the world space position of a probe at the given probe (storage) index, including the probe's offset value.
 */
-float3 DDGIGetProbeWorldPositionWithOffset(int probeIndex, float3 origin, int3 probeGridCounts, float3 probeGridSpacing, RWTexture2D<float4> probeOffsets)
+float3 DDGIGetProbeWorldPositionWithOffset(int probeIndex, float3 origin, int3 probeGridCounts, float3 probeGridSpacing, int3 probeScrollOffsets, RWTexture2D<float4> probeOffsets)
 {
 #if RTXGI_COORDINATE_SYSTEM == RTXGI_COORDINATE_SYSTEM_LEFT || RTXGI_COORDINATE_SYSTEM == RTXGI_COORDINATE_SYSTEM_RIGHT
     int textureWidth = (probeGridCounts.x * probeGridCounts.y);
@@ -334,16 +387,16 @@ float3 DDGIGetProbeWorldPositionWithOffset(int probeIndex, float3 origin, int3 p
 
     // Find the texture coords of the probe in the offsets texture
     int2 offsetTexcoords = int2(probeIndex % textureWidth, probeIndex / textureWidth);
-    return DDGIDecodeProbeOffset(offsetTexcoords, probeGridSpacing, probeOffsets) + DDGIGetProbeWorldPosition(probeIndex, origin, probeGridCounts, probeGridSpacing);
+    return DDGIDecodeProbeOffset(offsetTexcoords, probeGridSpacing, probeOffsets) + DDGIGetProbeWorldPosition(probeIndex, origin, probeGridCounts, probeGridSpacing, probeScrollOffsets);
 }
 
 /**
 * Compute the world space position from the 3D grid coordinates, including the probe's offset value.
 */
-float3 DDGIGetProbeWorldPositionWithOffset(int3 probeCoords, float3 origin, int3 probeGridCounts, float3 probeGridSpacing, RWTexture2D<float4> probeOffsets)
+float3 DDGIGetProbeWorldPositionWithOffset(int3 probeCoords, float3 origin, int3 probeGridCounts, float3 probeGridSpacing, int3 probeScrollOffsets, RWTexture2D<float4> probeOffsets)
 {
-    int probeIndex = DDGIGetProbeIndex(probeCoords, probeGridCounts);
-    return DDGIGetProbeWorldPositionWithOffset(probeIndex, origin, probeGridCounts, probeGridSpacing, probeOffsets);
+    int probeIndex = DDGIGetProbeIndex(DDGIGetScrollingProbeCoords(probeCoords, probeGridCounts, probeScrollOffsets), probeGridCounts);
+    return DDGIGetProbeWorldPositionWithOffset(probeIndex, origin, probeGridCounts, probeGridSpacing, probeScrollOffsets, probeOffsets);
 }
 
 #endif /* RTXGI_DDGI_PROBE_RELOCATION */
@@ -359,4 +412,17 @@ float3 DDGIGetProbeWorldPositionWithOffset(int3 probeCoords, float3 origin, int3
 
 #endif /* RTXGI_DDGI_PROBE_STATE_CLASSIFIER */
 
+//------------------------------------------------------------------------
+// Probe Update Scheduling
+//------------------------------------------------------------------------
+
+// the application traces a subset of the probes each frame. probes skipped this frame keep this
+// value in the distance channel of their first ray so blending, relocation and classification leave them alone.
+#define RTXGI_DDGI_PROBE_NOT_TRACED -3.402823466e+38f
+
+bool DDGIProbeWasTraced(RWTexture2D<float4> probeRTRadiance, int probeIndex)
+{
+    return probeRTRadiance[int2(0, probeIndex)].a > RTXGI_DDGI_PROBE_NOT_TRACED;
+}
+
 #endif /* RTXGI_DDGI_PROBE_COMMON_HLSL */
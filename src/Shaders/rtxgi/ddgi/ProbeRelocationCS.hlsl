@@ -30,6 +30,12 @@ void DDGIProbeRelocationCS(uint3 DispatchThreadID : SV_DispatchThreadID, uint Gr
     // Compute the probe index for this thread
     int probeIndex = DDGIGetProbeIndex(DispatchThreadID.xy, DDGIVolume.probeGridCounts);
 
+    // Probes not scheduled this frame have no new rays to relocate from
+    if (!DDGIProbeWasTraced(DDGIProbeRTRadianceUAV, probeIndex))
+    {
+        return;
+    }
+
     // Initialize
     int   closestBackfaceIndex = -1;
     int   farthestFrontfaceIndex = -1;
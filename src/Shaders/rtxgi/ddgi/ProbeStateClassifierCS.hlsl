@@ -30,6 +30,12 @@ void DDGIProbeStateClassifierCS(uint3 DispatchThreadID : SV_DispatchThreadID, ui
     // Compute the probe index for this thread
     int probeIndex = DDGIGetProbeIndex(DispatchThreadID.xy, DDGIVolume.probeGridCounts);
 
+    // Probes not scheduled this frame keep their state
+    if (!DDGIProbeWasTraced(DDGIProbeRTRadianceUAV, probeIndex))
+    {
+        return;
+    }
+
     // Compute the bounds used to check for surrounding geometry
     float3 geometryBounds = DDGIVolume.probeGridSpacing;
 
@@ -41,6 +41,18 @@ void SimpleCamera::SetTurnSpeed(float radiansPerSecond)
 	m_turnSpeed = radiansPerSecond;
 }
 
+void SimpleCamera::SetPose(glm::vec3 position, float yaw, float pitch)
+{
+	m_position = position;
+	m_yaw = yaw;
+	m_pitch = pitch;
+
+	float r = cosf(m_pitch);
+	m_lookDirection.x = r * sinf(m_yaw);
+	m_lookDirection.y = sinf(m_pitch);
+	m_lookDirection.z = r * cosf(m_yaw);
+}
+
 void SimpleCamera::Reset()
 {
 	m_position = m_initialPosition;
@@ -32,6 +32,8 @@ public:
 	glm::mat4x4 GetProjectionMatrix(float fov, float aspectRatio, float nearPlane = 1.0f, float farPlane = 10000.0f);
 	void SetMoveSpeed(float unitsPerSecond);
 	void SetTurnSpeed(float radiansPerSecond);
+	// places the camera directly, for scripted paths.
+	void SetPose(glm::vec3 position, float yaw, float pitch);
 
 	void OnKeyDown(WPARAM key);
 	void OnKeyUp(WPARAM key);
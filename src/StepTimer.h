@@ -11,54 +11,80 @@
 
 #pragma once
 
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+
+#include "FrameTiming.h"
+
 // Helper class for animation and simulation timing.
 class StepTimer
 {
 public:
-	StepTimer() :
+	// Returns nanoseconds of a monotonic clock, SteadyClockNs by default. Tests pass a mock clock.
+	typedef std::function<uint64_t()> ClockFunc;
+
+	StepTimer(ClockFunc clock = SteadyClockNs) :
+		m_clock(clock),
 		m_elapsedTicks(0),
 		m_totalTicks(0),
 		m_leftOverTicks(0),
+		m_smoothedElapsedTicks(0),
 		m_frameCount(0),
 		m_framesPerSecond(0),
 		m_framesThisSecond(0),
-		m_qpcSecondCounter(0),
+		m_secondCounterNs(0),
 		m_isFixedTimeStep(false),
-		m_targetElapsedTicks(TicksPerSecond / 60)
+		m_targetElapsedTicks(TicksPerSecond / 60),
+		m_maxUpdatesPerTick(8),
+		m_smoothingFactor(0.1)
 	{
-		QueryPerformanceFrequency(&m_qpcFrequency);
-		QueryPerformanceCounter(&m_qpcLastTime);
+		m_lastTimeNs = m_clock();
 
 		// Initialize max delta to 1/10 of a second.
-		m_qpcMaxDelta = m_qpcFrequency.QuadPart / 10;
+		m_maxDeltaNs = NsPerSecond / 10;
 	}
 
 	// Get elapsed time since the previous Update call.
-	UINT64 GetElapsedTicks() const						{ return m_elapsedTicks; }
+	uint64_t GetElapsedTicks() const					{ return m_elapsedTicks; }
 	double GetElapsedSeconds() const					{ return TicksToSeconds(m_elapsedTicks); }
 
+	// Exponential moving average of the variable timestep deltas, steadier for animation than the raw delta.
+	double GetSmoothedElapsedSeconds() const			{ return TicksToSeconds(m_smoothedElapsedTicks); }
+
 	// Get total time since the start of the program.
-	UINT64 GetTotalTicks() const						{ return m_totalTicks; }
+	uint64_t GetTotalTicks() const						{ return m_totalTicks; }
 	double GetTotalSeconds() const						{ return TicksToSeconds(m_totalTicks); }
 
 	// Get total number of updates since start of the program.
-	UINT32 GetFrameCount() const						{ return m_frameCount; }
+	uint32_t GetFrameCount() const						{ return m_frameCount; }
 
 	// Get the current framerate.
-	UINT32 GetFramesPerSecond() const					{ return m_framesPerSecond; }
+	uint32_t GetFramesPerSecond() const					{ return m_framesPerSecond; }
+
+	// Wall time of the last Ticks, before clamping, and its percentiles.
+	const FrameTimeHistory& GetFrameTimes() const		{ return m_frameTimes; }
 
 	// Set whether to use fixed or variable timestep mode.
 	void SetFixedTimeStep(bool isFixedTimestep)			{ m_isFixedTimeStep = isFixedTimestep; }
 
 	// Set how often to call Update when in fixed timestep mode.
-	void SetTargetElapsedTicks(UINT64 targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
+	void SetTargetElapsedTicks(uint64_t targetElapsed)	{ m_targetElapsedTicks = targetElapsed; }
 	void SetTargetElapsedSeconds(double targetElapsed)	{ m_targetElapsedTicks = SecondsToTicks(targetElapsed); }
 
+	// Most fixed timestep updates one Tick runs to catch up. Whole steps over the limit are dropped, so a
+	// slow update can't make every following Tick slower still.
+	void SetMaxUpdatesPerTick(uint32_t maxUpdates)		{ m_maxUpdatesPerTick = maxUpdates; }
+
+	// Weight of the newest delta in the smoothed elapsed time, 1 disables the smoothing.
+	void SetSmoothingFactor(double factor)				{ m_smoothingFactor = factor; }
+
 	// Integer format represents time using 10,000,000 ticks per second.
-	static const UINT64 TicksPerSecond = 10000000;
+	static const uint64_t TicksPerSecond = 10000000;
+	static const uint64_t NsPerSecond = 1000000000;
 
-	static double TicksToSeconds(UINT64 ticks)			{ return static_cast<double>(ticks) / TicksPerSecond; }
-	static UINT64 SecondsToTicks(double seconds)		{ return static_cast<UINT64>(seconds * TicksPerSecond); }
+	static double TicksToSeconds(uint64_t ticks)		{ return static_cast<double>(ticks) / TicksPerSecond; }
+	static uint64_t SecondsToTicks(double seconds)		{ return static_cast<uint64_t>(seconds * TicksPerSecond); }
 
 	// After an intentional timing discontinuity (for instance a blocking IO operation)
 	// call this to avoid having the fixed timestep logic attempt a set of catch-up 
@@ -66,12 +92,12 @@ public:
 
 	void ResetElapsedTime()
 	{
-		QueryPerformanceCounter(&m_qpcLastTime);
+		m_lastTimeNs = m_clock();
 
 		m_leftOverTicks = 0;
 		m_framesPerSecond = 0;
 		m_framesThisSecond = 0;
-		m_qpcSecondCounter = 0;
+		m_secondCounterNs = 0;
 	}
 
 	typedef void(*LPUPDATEFUNC) (void);
@@ -80,26 +106,25 @@ public:
 	void Tick(LPUPDATEFUNC update)
 	{
 		// Query the current time.
-		LARGE_INTEGER currentTime;
+		uint64_t currentTime = m_clock();
 
-		QueryPerformanceCounter(&currentTime);
+		uint64_t timeDelta = currentTime - m_lastTimeNs;
 
-		UINT64 timeDelta = currentTime.QuadPart - m_qpcLastTime.QuadPart;
+		m_lastTimeNs = currentTime;
+		m_secondCounterNs += timeDelta;
 
-		m_qpcLastTime = currentTime;
-		m_qpcSecondCounter += timeDelta;
+		m_frameTimes.Add(timeDelta * 1e-6);
 
 		// Clamp excessively large time deltas (e.g. after paused in the debugger).
-		if (timeDelta > m_qpcMaxDelta)
+		if (timeDelta > m_maxDeltaNs)
 		{
-			timeDelta = m_qpcMaxDelta;
+			timeDelta = m_maxDeltaNs;
 		}
 
-		// Convert QPC units into a canonical tick format. This cannot overflow due to the previous clamp.
-		timeDelta *= TicksPerSecond;
-		timeDelta /= m_qpcFrequency.QuadPart;
+		// Convert nanoseconds into the canonical tick format.
+		timeDelta /= NsPerSecond / TicksPerSecond;
 
-		UINT32 lastFrameCount = m_frameCount;
+		uint32_t lastFrameCount = m_frameCount;
 
 		if (m_isFixedTimeStep)
 		{
@@ -112,25 +137,31 @@ public:
 			// accumulate enough tiny errors that it would drop a frame. It is better to just round 
 			// small deviations down to zero to leave things running smoothly.
 
-			if (abs(static_cast<int>(timeDelta - m_targetElapsedTicks)) < TicksPerSecond / 4000)
+			if (std::llabs(static_cast<long long>(timeDelta - m_targetElapsedTicks)) < static_cast<long long>(TicksPerSecond / 4000))
 			{
 				timeDelta = m_targetElapsedTicks;
 			}
 
 			m_leftOverTicks += timeDelta;
 
-			while (m_leftOverTicks >= m_targetElapsedTicks)
+			uint32_t updates = 0;
+			while (m_leftOverTicks >= m_targetElapsedTicks && updates < m_maxUpdatesPerTick)
 			{
 				m_elapsedTicks = m_targetElapsedTicks;
 				m_totalTicks += m_targetElapsedTicks;
 				m_leftOverTicks -= m_targetElapsedTicks;
 				m_frameCount++;
+				updates++;
 
 				if (update)
 				{
 					update();
 				}
 			}
+
+			// Out of catch-up updates, keep only the fraction of a step.
+			m_leftOverTicks %= m_targetElapsedTicks;
+			m_smoothedElapsedTicks = m_targetElapsedTicks;
 		}
 		else
 		{
@@ -140,6 +171,9 @@ public:
 			m_leftOverTicks = 0;
 			m_frameCount++;
 
+			m_smoothedElapsedTicks = m_frameCount == 1 ? timeDelta :
+				static_cast<uint64_t>(m_smoothedElapsedTicks + (static_cast<double>(timeDelta) - m_smoothedElapsedTicks) * m_smoothingFactor);
+
 			if (update)
 			{
 				update();
@@ -152,32 +186,36 @@ public:
 			m_framesThisSecond++;
 		}
 
-		if (m_qpcSecondCounter >= static_cast<UINT64>(m_qpcFrequency.QuadPart))
+		if (m_secondCounterNs >= NsPerSecond)
 		{
 			m_framesPerSecond = m_framesThisSecond;
 			m_framesThisSecond = 0;
-			m_qpcSecondCounter %= m_qpcFrequency.QuadPart;
+			m_secondCounterNs %= NsPerSecond;
 		}
 	}
 
 private:
-	// Source timing data uses QPC units.
-	LARGE_INTEGER m_qpcFrequency;
-	LARGE_INTEGER m_qpcLastTime;
-	UINT64 m_qpcMaxDelta;
+	// Source timing data uses nanoseconds of m_clock.
+	ClockFunc m_clock;
+	uint64_t m_lastTimeNs;
+	uint64_t m_maxDeltaNs;
 
 	// Derived timing data uses a canonical tick format.
-	UINT64 m_elapsedTicks;
-	UINT64 m_totalTicks;
-	UINT64 m_leftOverTicks;
+	uint64_t m_elapsedTicks;
+	uint64_t m_totalTicks;
+	uint64_t m_leftOverTicks;
+	uint64_t m_smoothedElapsedTicks;
 
 	// Members for tracking the framerate.
-	UINT32 m_frameCount;
-	UINT32 m_framesPerSecond;
-	UINT32 m_framesThisSecond;
-	UINT64 m_qpcSecondCounter;
+	uint32_t m_frameCount;
+	uint32_t m_framesPerSecond;
+	uint32_t m_framesThisSecond;
+	uint64_t m_secondCounterNs;
+	FrameTimeHistory m_frameTimes;
 
 	// Members for configuring fixed timestep mode.
 	bool m_isFixedTimeStep;
-	UINT64 m_targetElapsedTicks;
+	uint64_t m_targetElapsedTicks;
+	uint32_t m_maxUpdatesPerTick;
+	double m_smoothingFactor;
 };
@@ -0,0 +1,221 @@
+#include "TemporalAACPU.h"
+
+#include <cmath>
+#include <algorithm>
+#include <emmintrin.h>
+
+static const float kPi = 3.14159265359f;
+
+// ResolveFilterDiameter of the shader. the 3x3 taps are at distance length(offset) / (diameter / 2).
+static const float kResolveFilterDiameter = 2.0f;
+static const float kFilterRadius = 1.0f;
+
+static const float kLowFreqWeight = 0.25f;
+static const float kHiFreqWeight = 0.85f;
+static const float kVarianceClipGamma = 1.5f;
+
+static float FilterCubic(float x, float B, float C)
+{
+	float y = 0.0f;
+	float x2 = x * x;
+	float x3 = x * x * x;
+	if (x < 1)
+		y = (12 - 9 * B - 6 * C) * x3 + (-18 + 12 * B + 6 * C) * x2 + (6 - 2 * B);
+	else if (x <= 2)
+		y = (-B - 6 * C) * x3 + (6 * B + 30 * C) * x2 + (-12 * B - 48 * C) * x + (8 * B + 24 * C);
+
+	return y / 6.0f;
+}
+
+static float Saturate(float x)
+{
+	return std::min(std::max(x, 0.f), 1.f);
+}
+
+// Filter() of TemporalAA.hlsl
+static float FilterWeight(float x, int32_t FilterType)
+{
+	const float CubicX = x * 2.0f;
+
+	switch (FilterType)
+	{
+	case 0:
+		return x <= 1.0f ? 1.0f : 0.0f;
+	case 1:
+		return Saturate(1.0f - x);
+	case 2:
+	{
+		const float Sigma = 0.5f;
+		const float g = 1.0f / std::sqrt(2.0f * 3.14159f * Sigma * Sigma);
+		return g * std::exp(-(x * x) / (2 * Sigma * Sigma));
+	}
+	case 3:
+	{
+		float t = 1.0f - x;
+		return Saturate(0.35875f - 0.48829f * std::cos(kPi * t) + 0.14128f * std::cos(2 * kPi * t) - 0.01168f * std::cos(3 * kPi * t));
+	}
+	case 4:
+	{
+		float t = Saturate(x);
+		return 1.0f - t * t * (3.0f - 2.0f * t);
+	}
+	case 5:
+		return FilterCubic(CubicX, 1.0f, 0.0f);
+	case 6:
+		return FilterCubic(CubicX, 0.0f, 0.5f);
+	case 7:
+		return FilterCubic(CubicX, 1 / 3.0f, 1 / 3.0f);
+	case 8:
+		return FilterCubic(CubicX, 0.33f, 0.33f);
+	case 9:
+	{
+		float s = x * kFilterRadius * 2.0f;
+		return s < 0.001f ? 1.0f : std::sin(s * kPi) / (s * kPi);
+	}
+	default:
+		return 1.0f;
+	}
+}
+
+static inline __m128 LoadV(const glm::vec4& V)
+{
+	return _mm_loadu_ps(&V.x);
+}
+
+static inline glm::vec4 StoreV(__m128 V)
+{
+	glm::vec4 Result;
+	_mm_storeu_ps(&Result.x, V);
+	return Result;
+}
+
+// saturate maps nan to 0. _mm_max_ps returns the second operand when the first is nan.
+static inline __m128 SaturateV(__m128 V)
+{
+	return _mm_min_ps(_mm_max_ps(V, _mm_setzero_ps()), _mm_set1_ps(1.f));
+}
+
+// hlsl max returns the non nan operand.
+static inline float MaxNonNan(float a, float b)
+{
+	return std::fmax(a, b);
+}
+
+static __m128 ClipAABB(__m128 AABBMin, __m128 AABBMax, __m128 PrevSample)
+{
+	const __m128 Half = _mm_set1_ps(0.5f);
+	__m128 PClip = _mm_mul_ps(Half, _mm_add_ps(AABBMax, AABBMin));
+	__m128 EClip = _mm_mul_ps(Half, _mm_sub_ps(AABBMax, AABBMin));
+
+	__m128 VClip = _mm_sub_ps(PrevSample, PClip);
+	glm::vec4 AUnit = glm::abs(StoreV(_mm_div_ps(VClip, EClip)));
+	float MaUnit = MaxNonNan(AUnit.x, MaxNonNan(AUnit.y, AUnit.z));
+
+	if (MaUnit > 1.0f)
+		return _mm_add_ps(PClip, _mm_div_ps(VClip, _mm_set1_ps(MaUnit)));
+	return PrevSample;
+}
+
+void TemporalAACPU(const TemporalAAParam& CB, ETAAClampMode ClampMode, int32_t FilterType,
+	const DenoiserImage& CurrentColor, const DenoiserImage& PrevColor, const DenoiserImage& Velocity,
+	DenoiserImage& Out, enki::TaskScheduler* TS)
+{
+	const uint32_t Width = uint32_t(CB.RTSize.x);
+	const uint32_t Height = uint32_t(CB.RTSize.y);
+
+	if (Out.Width != Width || Out.Height != Height)
+		Out.Init(Width, Height, Out.bHalf);
+
+	if (Width == 0 || Height == 0)
+		return;
+
+	// the filter only depends on the tap offset.
+	float TapWeights[9];
+	float TapWeightSum = 0.f;
+	for (int32_t i = 0; i < 9; i++)
+	{
+		const float x = float(i % 3 - 1);
+		const float y = float(i / 3 - 1);
+		TapWeights[i] = FilterWeight(std::sqrt(x * x + y * y) / (kResolveFilterDiameter / 2.0f), FilterType);
+		TapWeightSum += TapWeights[i];
+	}
+	const __m128 RcpTapWeightSum = _mm_set1_ps(1.f / std::max(TapWeightSum, 0.00001f));
+
+	const __m128 RcpNumTaps = _mm_set1_ps(1.f / 9.f);
+	const __m128 One = _mm_set1_ps(1.f);
+	const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const bool bNoHistory = CB.TAABlendFactor >= 1.0f;
+
+	ParallelForRows(TS, Height, [&](uint32_t StartRow, uint32_t EndRow)
+	{
+		for (uint32_t y = StartRow; y < EndRow; y++)
+		{
+			int32_t Rows[3];
+			for (int32_t j = 0; j < 3; j++)
+				Rows[j] = std::min(std::max(int32_t(y) + j - 1, 0), int32_t(Height) - 1);
+
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				__m128 ClrMin = _mm_set1_ps(99999999.0f);
+				__m128 ClrMax = _mm_set1_ps(-99999999.0f);
+				__m128 M1 = _mm_setzero_ps();
+				__m128 M2 = _mm_setzero_ps();
+				__m128 Filtered = _mm_setzero_ps();
+				__m128 Center = _mm_setzero_ps();
+
+				for (int32_t j = 0; j < 3; j++)
+				{
+					const glm::vec4* Row = &CurrentColor.Texels[size_t(Rows[j]) * CurrentColor.Width];
+					for (int32_t i = 0; i < 3; i++)
+					{
+						const int32_t sx = std::min(std::max(int32_t(x) + i - 1, 0), int32_t(Width) - 1);
+						__m128 Sample = LoadV(Row[sx]);
+
+						ClrMin = _mm_min_ps(ClrMin, Sample);
+						ClrMax = _mm_max_ps(ClrMax, Sample);
+						M1 = _mm_add_ps(M1, Sample);
+						M2 = _mm_add_ps(M2, _mm_mul_ps(Sample, Sample));
+						Filtered = _mm_add_ps(Filtered, _mm_mul_ps(Sample, _mm_set1_ps(TapWeights[j * 3 + i])));
+
+						if (i == 1 && j == 1)
+							Center = Sample;
+					}
+				}
+
+				__m128 Current = FilterType >= 0 ? _mm_mul_ps(Filtered, RcpTapWeightSum) : Center;
+
+				const glm::vec2 Vel = glm::vec2(Velocity.Load(x, y));
+				const glm::vec2 PixelPos = glm::vec2(x + 0.5f, y + 0.5f);
+				const glm::vec2 PrevUV = (PixelPos - Vel * CB.RTSize) / CB.RTSize;
+				__m128 Prev = LoadV(SampleBilinearWrap(PrevColor, PrevUV));
+
+				if (ClampMode == TAA_RGB_CLAMP)
+				{
+					Prev = _mm_min_ps(_mm_max_ps(Prev, ClrMin), ClrMax);
+				}
+				else if (ClampMode == TAA_AABB_CLIP)
+				{
+					Prev = ClipAABB(ClrMin, ClrMax, Prev);
+				}
+				else
+				{
+					__m128 Mu = _mm_mul_ps(M1, RcpNumTaps);
+					__m128 Var = _mm_and_ps(_mm_sub_ps(_mm_mul_ps(M2, RcpNumTaps), _mm_mul_ps(Mu, Mu)), AbsMask);
+					__m128 Sigma = _mm_mul_ps(_mm_sqrt_ps(Var), _mm_set1_ps(kVarianceClipGamma));
+					Prev = ClipAABB(_mm_sub_ps(Mu, Sigma), _mm_add_ps(Mu, Sigma), Prev);
+				}
+
+				__m128 TemporalWeight = SaturateV(_mm_div_ps(_mm_and_ps(_mm_sub_ps(ClrMax, ClrMin), AbsMask), Current));
+				__m128 WeightB = SaturateV(_mm_add_ps(_mm_set1_ps(kLowFreqWeight), _mm_mul_ps(_mm_set1_ps(kHiFreqWeight - kLowFreqWeight), TemporalWeight)));
+				if (bNoHistory)
+					WeightB = _mm_setzero_ps();
+				__m128 WeightA = _mm_sub_ps(One, WeightB);
+
+				__m128 Result = _mm_div_ps(_mm_add_ps(_mm_mul_ps(Current, WeightA), _mm_mul_ps(Prev, WeightB)), _mm_add_ps(WeightA, WeightB));
+				glm::vec4 Value = StoreV(Result);
+				Value.w = 1.f;
+				Out.Store(x, y, Value);
+			}
+		}
+	});
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <cstdint>
+
+#include "GIDenoiserCPU.h"
+
+// constant buffer of TemporalAA.hlsl.
+// TAABlendFactor >= 1 resolves without history, Corona sets it when anti aliasing is off. below 1 the
+// value isn't used, the history weight comes from the contrast of the neighborhood.
+struct TemporalAAParam
+{
+	glm::vec2 RTSize;
+	float TAABlendFactor;
+};
+
+// CLAMP_MODE of TemporalAA.hlsl.
+enum ETAAClampMode : uint32_t
+{
+	TAA_RGB_CLAMP,
+	TAA_AABB_CLIP,
+	TAA_VARIANCE_CLIP,
+	TAA_CLAMP_MODE_COUNT
+};
+
+// FILTER_TYPE of TemporalAA.hlsl. box, triangle, gaussian, blackman harris, smoothstep,
+// b-spline, catmull-rom, mitchell, cubic, sinc. -1 uses the center sample.
+const int32_t kTAAFilterNone = -1;
+const int32_t kTAAFilterCount = 10;
+
+// cpu reference of one TemporalAA.hlsl dispatch, for golden image checks of the resolve.
+// rows are split across the task scheduler when one is given, the neighborhood is processed with sse.
+// Out is resized to RTSize.
+void TemporalAACPU(const TemporalAAParam& CB, ETAAClampMode ClampMode, int32_t FilterType,
+	const DenoiserImage& CurrentColor, const DenoiserImage& PrevColor, const DenoiserImage& Velocity,
+	DenoiserImage& Out, enki::TaskScheduler* TS = nullptr);
@@ -0,0 +1,305 @@
+#include "TextureStreaming.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+TextureStreamer::~TextureStreamer()
+{
+	Shutdown();
+}
+
+void TextureStreamer::Init(LoadFunc InLoad, ApplyFunc InApply, TrimFunc InTrim)
+{
+	Load = InLoad;
+	Apply = InApply;
+	TrimMips = InTrim;
+
+	bQuit = false;
+	IOThread = std::thread(&TextureStreamer::IOThreadMain, this);
+	bInitialized = true;
+}
+
+void TextureStreamer::Shutdown()
+{
+	if (!bInitialized)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(QueueMtx);
+		bQuit = true;
+		RequestQueue.clear();
+	}
+	QueueCV.notify_all();
+
+	if (IOThread.joinable())
+		IOThread.join();
+
+	CompletionQueue.clear();
+	Entries.clear();
+	CurrentStats = Stats();
+	bInitialized = false;
+}
+
+TextureStreamer::TextureID TextureStreamer::Register(uint32_t Width, uint32_t Height, const std::vector<uint64_t>& MipBytes, void* UserData)
+{
+	if (MipBytes.empty())
+		return InvalidID;
+
+	Entry E;
+	E.UserData = UserData;
+	E.NumMips = uint32_t(MipBytes.size());
+	E.MipBytes = MipBytes;
+
+	// first mip that fits in the tail.
+	E.TailMip = E.NumMips - 1;
+	for (uint32_t i = 0; i < E.NumMips; i++)
+	{
+		uint32_t MipDim = std::max(std::max(Width >> i, Height >> i), 1u);
+		if (MipDim <= MipTailDim)
+		{
+			E.TailMip = i;
+			break;
+		}
+	}
+
+	E.ResidentMip = E.NumMips;
+	E.DesiredMip = E.TailMip;
+	E.FrameDesiredMip = E.TailMip;
+
+	TextureID ID = TextureID(Entries.size());
+	Entries.push_back(E);
+	CurrentStats.NumTextures++;
+
+	// the tail is always resident so it bypasses the budget and the request limit.
+	IssueRequest(ID, E.TailMip);
+
+	return ID;
+}
+
+void TextureStreamer::ReportMipUsage(TextureID ID, float Mip, uint64_t Frame)
+{
+	if (ID >= Entries.size())
+		return;
+
+	Entry& E = Entries[ID];
+
+	uint32_t MipLevel = Mip <= 0.f ? 0 : uint32_t(std::floor(Mip));
+	MipLevel = std::min(MipLevel, E.TailMip);
+
+	if (E.LastUsedFrame != Frame)
+		E.FrameDesiredMip = E.TailMip;
+
+	E.FrameDesiredMip = std::min(E.FrameDesiredMip, MipLevel);
+	E.LastUsedFrame = Frame;
+}
+
+void TextureStreamer::Update(uint64_t Frame)
+{
+	CurrentStats.NumLoadedThisFrame = 0;
+	CurrentStats.NumTrimmedThisFrame = 0;
+
+	// apply finished loads. uploads are limited per frame to avoid hitches.
+	std::vector<Completion> Done;
+	{
+		std::lock_guard<std::mutex> lock(QueueMtx);
+		while (!CompletionQueue.empty() && Done.size() < MaxAppliesPerFrame)
+		{
+			Done.push_back(CompletionQueue.front());
+			CompletionQueue.pop_front();
+		}
+	}
+
+	for (auto& C : Done)
+	{
+		Entry& E = Entries[C.Req.ID];
+		uint64_t Bytes = GetBytes(E, C.Req.FirstMip, E.ResidentMip);
+
+		E.bPending = false;
+		CurrentStats.PendingBytes -= Bytes;
+		CurrentStats.NumPendingRequests--;
+
+		if (C.Data && Apply(C.Req, C.Data))
+		{
+			E.ResidentMip = C.Req.FirstMip;
+			CurrentStats.ResidentBytes += Bytes;
+			CurrentStats.NumLoadedThisFrame++;
+		}
+		else if (E.ResidentMip == E.NumMips)
+		{
+			E.TailRetryFrame = Frame + TailRetryFrames;
+		}
+	}
+
+	// nothing is resident without the tail and finer mips are only requested on top of it.
+	for (TextureID ID = 0; ID < Entries.size(); ID++)
+	{
+		const Entry& E = Entries[ID];
+		if (!E.bPending && E.ResidentMip == E.NumMips && Frame >= E.TailRetryFrame)
+			IssueRequest(ID, E.TailMip);
+	}
+
+	// latch the feedback of this frame.
+	std::vector<TextureID> Candidates;
+	for (TextureID ID = 0; ID < Entries.size(); ID++)
+	{
+		Entry& E = Entries[ID];
+		if (E.LastUsedFrame != Frame)
+			continue;
+
+		E.DesiredMip = E.FrameDesiredMip;
+		E.FrameDesiredMip = E.TailMip;
+
+		if (!E.bPending && E.ResidentMip <= E.TailMip && E.DesiredMip < E.ResidentMip)
+			Candidates.push_back(ID);
+	}
+
+	// biggest quality gap first.
+	std::sort(Candidates.begin(), Candidates.end(), [&](TextureID A, TextureID B)
+	{
+		const Entry& EA = Entries[A];
+		const Entry& EB = Entries[B];
+		return (EA.ResidentMip - EA.DesiredMip) > (EB.ResidentMip - EB.DesiredMip);
+	});
+
+	for (TextureID ID : Candidates)
+	{
+		if (CurrentStats.NumPendingRequests >= MaxPendingRequests)
+			break;
+
+		Entry& E = Entries[ID];
+
+		// try the desired mip first, then settle for one step finer than now.
+		uint32_t Targets[2] = { E.DesiredMip, E.ResidentMip - 1 };
+		for (uint32_t Target : Targets)
+		{
+			uint64_t Bytes = GetBytes(E, Target, E.ResidentMip);
+			if (MakeRoom(Bytes, Frame, ID))
+			{
+				IssueRequest(ID, Target);
+				break;
+			}
+		}
+	}
+}
+
+uint32_t TextureStreamer::GetResidentMip(TextureID ID) const
+{
+	if (ID >= Entries.size())
+		return 0;
+	return Entries[ID].ResidentMip;
+}
+
+uint32_t TextureStreamer::GetNumMips(TextureID ID) const
+{
+	if (ID >= Entries.size())
+		return 0;
+	return Entries[ID].NumMips;
+}
+
+uint64_t TextureStreamer::GetBytes(const Entry& E, uint32_t FirstMip, uint32_t EndMip) const
+{
+	uint64_t Bytes = 0;
+	for (uint32_t i = FirstMip; i < EndMip && i < E.NumMips; i++)
+		Bytes += E.MipBytes[i];
+	return Bytes;
+}
+
+bool TextureStreamer::Trim(TextureID ID, uint32_t FirstMip)
+{
+	Entry& E = Entries[ID];
+	if (E.bPending || FirstMip <= E.ResidentMip || E.ResidentMip >= E.NumMips)
+		return false;
+
+	Request Req = { ID, FirstMip, E.UserData };
+	if (!TrimMips(Req))
+		return false;
+
+	CurrentStats.ResidentBytes -= GetBytes(E, E.ResidentMip, FirstMip);
+	E.ResidentMip = FirstMip;
+	CurrentStats.NumTrimmedThisFrame++;
+	return true;
+}
+
+bool TextureStreamer::MakeRoom(uint64_t Bytes, uint64_t Frame, TextureID Requester)
+{
+	auto Fits = [&]() { return CurrentStats.ResidentBytes + CurrentStats.PendingBytes + Bytes <= BudgetBytes; };
+
+	if (Fits())
+		return true;
+
+	// least recently used first.
+	std::vector<TextureID> Victims;
+	for (TextureID ID = 0; ID < Entries.size(); ID++)
+	{
+		const Entry& E = Entries[ID];
+		if (ID != Requester && !E.bPending && E.ResidentMip < E.TailMip)
+			Victims.push_back(ID);
+	}
+
+	std::sort(Victims.begin(), Victims.end(), [&](TextureID A, TextureID B)
+	{
+		return Entries[A].LastUsedFrame < Entries[B].LastUsedFrame;
+	});
+
+	for (TextureID ID : Victims)
+	{
+		const Entry& E = Entries[ID];
+
+		// unused textures fall back to the tail, visible ones only give up mips they don't need.
+		uint32_t Target = E.DesiredMip;
+		if (Frame - E.LastUsedFrame >= MinFramesBeforeTrim)
+			Target = E.TailMip;
+
+		if (Target > E.ResidentMip)
+			Trim(ID, Target);
+
+		if (Fits())
+			return true;
+	}
+
+	return Fits();
+}
+
+void TextureStreamer::IssueRequest(TextureID ID, uint32_t FirstMip)
+{
+	Entry& E = Entries[ID];
+	E.bPending = true;
+
+	CurrentStats.PendingBytes += GetBytes(E, FirstMip, E.ResidentMip);
+	CurrentStats.NumPendingRequests++;
+
+	{
+		std::lock_guard<std::mutex> lock(QueueMtx);
+		RequestQueue.push_back({ ID, FirstMip, E.UserData });
+	}
+	QueueCV.notify_one();
+}
+
+void TextureStreamer::IOThreadMain()
+{
+	CPUProfiler::Get().SetThreadName("Texture Streaming IO");
+
+	while (true)
+	{
+		Request Req;
+		{
+			std::unique_lock<std::mutex> lock(QueueMtx);
+			QueueCV.wait(lock, [&]() { return bQuit || !RequestQueue.empty(); });
+
+			if (bQuit)
+				return;
+
+			Req = RequestQueue.front();
+			RequestQueue.pop_front();
+		}
+
+		ProfileCPUScope("LoadMips");
+		std::shared_ptr<void> Data = Load(Req);
+
+		{
+			std::lock_guard<std::mutex> lock(QueueMtx);
+			CompletionQueue.push_back({ Req, Data });
+		}
+	}
+}
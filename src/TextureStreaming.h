@@ -0,0 +1,119 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// Mip residency manager for file backed textures.
+// Every texture keeps its mip tail (mips no larger than MipTailDim) resident. Finer mips are
+// requested from per-frame usage feedback, decoded on a background io thread and swapped in on
+// the main thread. When the resident set exceeds BudgetBytes, least recently used textures are
+// trimmed back toward their tail.
+class TextureStreamer
+{
+public:
+	typedef uint32_t TextureID;
+	static const TextureID InvalidID = 0xffffffff;
+
+	struct Request
+	{
+		TextureID ID;
+		uint32_t FirstMip;
+		void* UserData;
+	};
+
+	// called on the io thread. returns the decoded mip chain starting at Request::FirstMip.
+	typedef std::function<std::shared_ptr<void>(const Request&)> LoadFunc;
+	// called on the main thread with the result of LoadFunc. should make mips [FirstMip, NumMips) resident.
+	typedef std::function<bool(const Request&, std::shared_ptr<void>)> ApplyFunc;
+	// called on the main thread. should drop every mip finer than FirstMip without touching the disk.
+	typedef std::function<bool(const Request&)> TrimFunc;
+
+	struct Stats
+	{
+		uint64_t ResidentBytes = 0;
+		uint64_t PendingBytes = 0;
+		uint32_t NumTextures = 0;
+		uint32_t NumPendingRequests = 0;
+		uint32_t NumLoadedThisFrame = 0;
+		uint32_t NumTrimmedThisFrame = 0;
+	};
+
+public:
+	uint64_t BudgetBytes = 512ull * 1024 * 1024;
+	uint32_t MipTailDim = 64;
+	uint32_t MaxAppliesPerFrame = 4;
+	uint32_t MaxPendingRequests = 8;
+	// a texture has to be unused for this many frames before it's trimmed below its desired mip.
+	uint32_t MinFramesBeforeTrim = 30;
+	// a mip tail that failed to load is requested again after this many frames.
+	uint32_t TailRetryFrames = 60;
+
+public:
+	void Init(LoadFunc InLoad, ApplyFunc InApply, TrimFunc InTrim);
+	void Shutdown();
+
+	// MipBytes[i] is the gpu size of mip i. the mip tail is requested right away.
+	TextureID Register(uint32_t Width, uint32_t Height, const std::vector<uint64_t>& MipBytes, void* UserData);
+
+	// Mip is the finest mip level sampled this frame. fractional values are rounded down.
+	void ReportMipUsage(TextureID ID, float Mip, uint64_t Frame);
+
+	// applies finished loads, trims over budget textures and issues new requests.
+	void Update(uint64_t Frame);
+
+	uint32_t GetResidentMip(TextureID ID) const;
+	uint32_t GetNumMips(TextureID ID) const;
+	const Stats& GetStats() const { return CurrentStats; }
+
+	TextureStreamer() {}
+	virtual ~TextureStreamer();
+
+private:
+	struct Entry
+	{
+		void* UserData = nullptr;
+		uint32_t NumMips = 0;
+		uint32_t TailMip = 0;
+		uint32_t ResidentMip = 0; // == NumMips when nothing is resident yet
+		uint32_t DesiredMip = 0;
+		uint32_t FrameDesiredMip = 0; // min over reports since the last Update
+		uint64_t LastUsedFrame = 0;
+		uint64_t TailRetryFrame = 0;
+		bool bPending = false;
+		std::vector<uint64_t> MipBytes;
+	};
+
+	struct Completion
+	{
+		Request Req;
+		std::shared_ptr<void> Data;
+	};
+
+	uint64_t GetBytes(const Entry& E, uint32_t FirstMip, uint32_t EndMip) const;
+	bool Trim(TextureID ID, uint32_t FirstMip);
+	bool MakeRoom(uint64_t Bytes, uint64_t Frame, TextureID Requester);
+	void IssueRequest(TextureID ID, uint32_t FirstMip);
+	void IOThreadMain();
+
+	std::vector<Entry> Entries;
+	Stats CurrentStats;
+
+	LoadFunc Load;
+	ApplyFunc Apply;
+	TrimFunc TrimMips;
+
+	std::thread IOThread;
+	std::mutex QueueMtx;
+	std::condition_variable QueueCV;
+	std::deque<Request> RequestQueue;
+	std::deque<Completion> CompletionQueue;
+	std::atomic<bool> bQuit{ false };
+	bool bInitialized = false;
+};
@@ -1,6 +1,7 @@
 
 #include "VulkanImpl.h"
 #include <assert.h>
+#include <algorithm>
 #include <sstream>
 #include <vulkan/vulkan_win32.h>
 #include <fstream>
@@ -343,6 +344,69 @@ VKUniformBuffer::~VKUniformBuffer()
     vkFreeMemory(g_vulkanImpl->Device, memory, NULL);
 }
 
+std::tuple<uint32_t, uint8_t*> VKUniformRingBuffer::AllocGPUMemory(uint32_t InSize)
+{
+    // dynamic offsets have to be multiples of minUniformBufferOffsetAlignment.
+    uint32_t AlignedSize = (InSize + Alignment - 1) & ~(Alignment - 1);
+    assert(AllocPos + AlignedSize <= TotalSize && "uniform ring overflow");
+
+    uint32_t Offset = CurrentFrame * TotalSize + AllocPos;
+    AllocPos += AlignedSize;
+
+    return std::make_tuple(Offset, MemMapped + Offset);
+}
+
+void VKUniformRingBuffer::Advance()
+{
+    CurrentFrame = (CurrentFrame + 1) % NumFrame;
+    AllocPos = 0;
+}
+
+VKUniformRingBuffer::VKUniformRingBuffer(uint32_t InSize, uint32_t InNumFrame, uint32_t InAlignment)
+{
+    NumFrame = InNumFrame;
+    Alignment = InAlignment > 0 ? InAlignment : 1;
+    TotalSize = (InSize + Alignment - 1) & ~(Alignment - 1);
+
+    VkResult res;
+    VkBufferCreateInfo buf_info = {};
+    buf_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+    buf_info.pNext = NULL;
+    buf_info.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    buf_info.size = VkDeviceSize(TotalSize) * NumFrame;
+    buf_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    buf_info.flags = 0;
+    res = vkCreateBuffer(g_vulkanImpl->Device, &buf_info, NULL, &buffer);
+    assert(res == VK_SUCCESS);
+
+    VkMemoryRequirements mem_reqs;
+    vkGetBufferMemoryRequirements(g_vulkanImpl->Device, buffer, &mem_reqs);
+
+    VkMemoryAllocateInfo alloc_info = {};
+    alloc_info.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+    alloc_info.pNext = NULL;
+    alloc_info.allocationSize = mem_reqs.size;
+
+    bool pass = memory_type_from_properties(g_vulkanImpl->memory_properties, mem_reqs.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, &alloc_info.memoryTypeIndex);
+    assert(pass && "No mappable, coherent memory");
+
+    res = vkAllocateMemory(g_vulkanImpl->Device, &alloc_info, NULL, &memory);
+    assert(res == VK_SUCCESS);
+
+    res = vkMapMemory(g_vulkanImpl->Device, memory, 0, mem_reqs.size, 0, (void**)&MemMapped);
+    assert(res == VK_SUCCESS);
+
+    res = vkBindBufferMemory(g_vulkanImpl->Device, buffer, memory, 0);
+    assert(res == VK_SUCCESS);
+}
+
+VKUniformRingBuffer::~VKUniformRingBuffer()
+{
+    vkUnmapMemory(g_vulkanImpl->Device, memory);
+    vkDestroyBuffer(g_vulkanImpl->Device, buffer, NULL);
+    vkFreeMemory(g_vulkanImpl->Device, memory, NULL);
+}
+
 
 bool VKVertexBuffer::Create(VertexBufferInfo* info)
 {
@@ -414,28 +478,43 @@ VKPipelineStateObject::~VKPipelineStateObject()
     vkDestroyPipeline(g_vulkanImpl->Device, pipeline, NULL);
 }
 
-void VKPipelineStateObject::BindUniform(std::string name, int index)
+void VKPipelineStateObject::BindUniform(std::string name, int index, int size)
 {
-    BindingData data = { name, index};
+    BindingData data = { name, uint32_t(index), uint32_t(size) };
     uniformBinding.insert(std::pair < std::string , BindingData > (data.name, data));
 }
 
 void VKPipelineStateObject::BindSampler(std::string name, int index)
 {
-    BindingData data = { name, index};
+    BindingData data = { name, uint32_t(index) };
     samplerBinding.insert(std::pair<std::string , BindingData>(data.name, data));
 }
 
 void VKPipelineStateObject::BindTexture(std::string name, int index)
 {
-    BindingData data = { name, index };
+    BindingData data = { name, uint32_t(index) };
     textureBinding.insert(std::pair<std::string, BindingData>(data.name, data));
 }
 
 
-void VKPipelineStateObject::SetUniformBuffer(std::string name, VKUniformBuffer* buffer)
+void VKPipelineStateObject::SetUniformBuffer(std::string name, VkBuffer buffer, uint32_t offset)
 {
-    uniformBinding[name].uniformBuffer = buffer;
+    BindingData& binding = uniformBinding[name];
+    binding.buffer = buffer;
+    binding.dynamicOffset = offset;
+}
+
+void VKPipelineStateObject::SetUniformValue(std::string name, void* pData)
+{
+    BindingData& binding = uniformBinding[name];
+
+    uint32_t Offset;
+    uint8_t* pMapped;
+    std::tie(Offset, pMapped) = g_vulkanImpl->uniformRing->AllocGPUMemory(binding.size);
+    memcpy(pMapped, pData, binding.size);
+
+    binding.buffer = g_vulkanImpl->uniformRing->buffer;
+    binding.dynamicOffset = Offset;
 }
 
 void VKPipelineStateObject::SetRendertargets(std::vector<VKTexture*> colorTargets, VKTexture* depthTarget)
@@ -470,63 +549,102 @@ void VKPipelineStateObject::SetRendertargets(std::vector<VKTexture*> colorTarget
         currentFBO = it->second;
     }
 
+    currentExtent = { colorTargets[0]->textureInfo.width, colorTargets[0]->textureInfo.height };
+    numColorTargets = uint32_t(colorTargets.size());
 }
 
-void VKPipelineStateObject::Apply()
+uint32_t VKPipelineStateObject::GetNumUniformSlots() const
+{
+    uint32_t NumSlots = 0;
+    for (auto& it : uniformBinding)
+        if (it.second.BindingIndex + 1 > NumSlots)
+            NumSlots = it.second.BindingIndex + 1;
+    return NumSlots;
+}
+
+void VKPipelineStateObject::Apply(VkCommandBuffer cmd)
+{
+    g_vulkanImpl->BeginRenderPass(render_pass, currentFBO, currentExtent, numColorTargets);
+    g_vulkanImpl->boundPSO = this;
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+}
+
+void VKPipelineStateObject::BindDescriptorSets(VkCommandBuffer cmd)
 {
-    // allocate required descriptorsets for each resource type and update.
     VkResult res;
 
-    std::vector< VkDescriptorBufferInfo> vecUniformBufferInfo;
-    vecUniformBufferInfo.resize(uniformBinding.size());
-    std::map<std::string, BindingData>::iterator it;
-    for (it = uniformBinding.begin(); it != uniformBinding.end(); it++)
+    // the array elements of the uniform binding and the dynamic offsets are in register order. registers
+    // nobody bound get a slice of the ring, the shader doesn't read them but every element needs a buffer.
+    const uint32_t NumSlots = GetNumUniformSlots();
+    std::vector<VkDescriptorBufferInfo> vecUniformBufferInfo(NumSlots);
+    std::vector<uint32_t> vecDynamicOffset(NumSlots, 0);
+    for (uint32_t i = 0; i < NumSlots; i++)
     {
-        int BindingIndex = it->second.BindingIndex;
-        VKUniformBuffer* buffer = it->second.uniformBuffer;
-        vecUniformBufferInfo[BindingIndex] = buffer->buffer_info;
+        vecUniformBufferInfo[i].buffer = g_vulkanImpl->uniformRing->buffer;
+        vecUniformBufferInfo[i].offset = 0;
+        vecUniformBufferInfo[i].range = g_vulkanImpl->uniformRing->GetAlignment();
+    }
+    for (auto& it : uniformBinding)
+    {
+        const BindingData& binding = it.second;
+        assert(binding.buffer != VK_NULL_HANDLE && "uniform not set");
+        vecUniformBufferInfo[binding.BindingIndex].buffer = binding.buffer;
+        vecUniformBufferInfo[binding.BindingIndex].range = binding.size;
+        vecDynamicOffset[binding.BindingIndex] = binding.dynamicOffset;
     }
 
-    // descriptor set
-    VkDescriptorSetAllocateInfo alloc_info;
-    alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-    alloc_info.pNext = NULL;
-    alloc_info.descriptorPool = g_vulkanImpl->desc_pool;
-    alloc_info.descriptorSetCount = desc_layout.size();
-    alloc_info.pSetLayouts = desc_layout.data();
+    std::vector<uint64_t> key(NumSlots * 2);
+    uint64_t Hash = 14695981039346656037ull;
+    for (uint32_t i = 0; i < NumSlots; i++)
+    {
+        key[i * 2] = uint64_t(vecUniformBufferInfo[i].buffer);
+        key[i * 2 + 1] = vecUniformBufferInfo[i].range;
+    }
+    for (uint64_t Value : key)
+    {
+        Hash ^= Value;
+        Hash *= 1099511628211ull;
+    }
 
-    desc_set.resize(desc_layout.size());
-    res = vkAllocateDescriptorSets(g_vulkanImpl->Device, &alloc_info, desc_set.data());
-    assert(res == VK_SUCCESS);
+    std::vector<DescSetCacheEntry>& bucket = descSetCache[Hash];
+    auto it = std::find_if(bucket.begin(), bucket.end(), [&key](const DescSetCacheEntry& entry) { return entry.key == key; });
+    if (it == bucket.end())
+    {
+        // descriptor set
+        VkDescriptorSetAllocateInfo alloc_info;
+        alloc_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        alloc_info.pNext = NULL;
+        alloc_info.descriptorPool = g_vulkanImpl->desc_pool;
+        alloc_info.descriptorSetCount = desc_layout.size();
+        alloc_info.pSetLayouts = desc_layout.data();
+
+        std::vector<VkDescriptorSet> vecSet(desc_layout.size());
+        res = vkAllocateDescriptorSets(g_vulkanImpl->Device, &alloc_info, vecSet.data());
+        assert(res == VK_SUCCESS);
 
+        std::vector<VkWriteDescriptorSet> writes;
+        writes.resize(1);
 
-    std::vector<VkWriteDescriptorSet> writes;
-    writes.resize(1);
-    
-    const int uniformBinding = 0;
-    writes[uniformBinding] = {};
-    writes[uniformBinding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    writes[uniformBinding].pNext = NULL;
-    writes[uniformBinding].dstSet = desc_set[0];
-    writes[uniformBinding].descriptorCount = vecUniformBufferInfo.size();
-    writes[uniformBinding].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    writes[uniformBinding].pBufferInfo = vecUniformBufferInfo.data();
-    writes[uniformBinding].dstArrayElement = 0;
-    writes[uniformBinding].dstBinding = 0;
-
-    /*const int samplerBinding = 1;
-    writes[samplerBinding] = {};
-    writes[samplerBinding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-    writes[samplerBinding].pNext = NULL;
-    writes[samplerBinding].dstSet = desc_set[0];
-    writes[samplerBinding].descriptorCount = vecUniformBufferInfo.size();
-    writes[samplerBinding].descriptorType = VK_DESCRIPTOR_TYPE_SAMPLER;
-    writes[samplerBinding].pBufferInfo = vecUniformBufferInfo.data();
-    writes[samplerBinding].dstArrayElement = 0;
-    writes[samplerBinding].dstBinding = 0;*/
-
-    vkUpdateDescriptorSets(g_vulkanImpl->Device, writes.size(), writes.data(), 0, NULL);
+        const int uniformBinding = 0;
+        writes[uniformBinding] = {};
+        writes[uniformBinding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        writes[uniformBinding].pNext = NULL;
+        writes[uniformBinding].dstSet = vecSet[0];
+        writes[uniformBinding].descriptorCount = vecUniformBufferInfo.size();
+        writes[uniformBinding].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        writes[uniformBinding].pBufferInfo = vecUniformBufferInfo.data();
+        writes[uniformBinding].dstArrayElement = 0;
+        writes[uniformBinding].dstBinding = 0;
+
+        vkUpdateDescriptorSets(g_vulkanImpl->Device, writes.size(), writes.data(), 0, NULL);
 
+        bucket.push_back({ key, vecSet });
+        it = bucket.end() - 1;
+    }
+    desc_set = it->sets;
+
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline_layout, 0, desc_set.size(), desc_set.data(), vecDynamicOffset.size(), vecDynamicOffset.data());
 }
 
 
@@ -539,8 +657,8 @@ bool VKPipelineStateObject::Create(PSOCreateInfo* info)
    
     VkDescriptorSetLayoutBinding uniform_binding_layout = {};
     uniform_binding_layout.binding = 0;
-    uniform_binding_layout.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-    uniform_binding_layout.descriptorCount = uniformBinding.size();
+    uniform_binding_layout.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    uniform_binding_layout.descriptorCount = GetNumUniformSlots();
     uniform_binding_layout.stageFlags = VK_SHADER_STAGE_ALL;
     uniform_binding_layout.pImmutableSamplers = NULL;
 
@@ -862,7 +980,7 @@ bool VKPipelineStateObject::Create(PSOCreateInfo* info)
     pipeline_info.renderPass = render_pass;
     pipeline_info.subpass = 0;
 
-    res = vkCreateGraphicsPipelines(g_vulkanImpl->Device, VK_NULL_HANDLE, 1, &pipeline_info, NULL, &pipeline);
+    res = vkCreateGraphicsPipelines(g_vulkanImpl->Device, g_vulkanImpl->pipelineCache, 1, &pipeline_info, NULL, &pipeline);
     assert(res == VK_SUCCESS);
 
 
@@ -881,6 +999,18 @@ VulkanImpl::VulkanImpl()
 
 VulkanImpl::~VulkanImpl()
 {
+    vkDeviceWaitIdle(Device);
+    for (VkFence fence : frameFences)
+        vkDestroyFence(Device, fence, NULL);
+    for (VkSemaphore semaphore : imageAcquiredSemaphores)
+        vkDestroySemaphore(Device, semaphore, NULL);
+    for (VkSemaphore semaphore : renderCompleteSemaphores)
+        vkDestroySemaphore(Device, semaphore, NULL);
+    uniformRing.reset();
+
+    SavePipelineCache();
+    vkDestroyPipelineCache(Device, pipelineCache, NULL);
+
     for (uint32_t i = 0; i < frameBuffers.size(); i++) {
         vkDestroyFramebuffer(Device, frameBuffers[i], NULL);
     }
@@ -974,6 +1104,10 @@ bool VulkanImpl::Init(HINSTANCE hInstance, HWND hWnd, UINT DisplayWidth, UINT Di
 
     vkGetPhysicalDeviceProperties(vecGPU[0], &physical_device_props);
 
+    // the pipeline cache is read while the device and the swap chain are set up. the driver checks the
+    // blob's own header against its cache uuid and ignores a stale one.
+    pipelineCacheLoader.Start("PipelineCache_Vulkan.bin", GetPipelineCacheDeviceId());
+
     uint32_t queue_family_count;
 
     vkGetPhysicalDeviceQueueFamilyProperties(vecGPU[0], &queue_family_count, NULL);
@@ -1098,6 +1232,7 @@ bool VulkanImpl::Init(HINSTANCE hInstance, HWND hWnd, UINT DisplayWidth, UINT Di
     }
 
     vkGetDeviceQueue(Device, graphics_queue_family_index, 0, &GraphicsQueue);
+    vkGetDeviceQueue(Device, present_queue_family_index, 0, &PresentQueue);
 
     // get supported frame buffer formats
     uint32_t formatCount;
@@ -1284,7 +1419,7 @@ bool VulkanImpl::Init(HINSTANCE hInstance, HWND hWnd, UINT DisplayWidth, UINT Di
     cmd_pool_info.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
     cmd_pool_info.pNext = NULL;
     cmd_pool_info.queueFamilyIndex = graphics_queue_family_index;
-    cmd_pool_info.flags = 0;
+    cmd_pool_info.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 
     res = vkCreateCommandPool(Device, &cmd_pool_info, NULL, &cmd_pool);
     assert(res == VK_SUCCESS);
@@ -1295,22 +1430,49 @@ bool VulkanImpl::Init(HINSTANCE hInstance, HWND hWnd, UINT DisplayWidth, UINT Di
     cmd_info.pNext = NULL;
     cmd_info.commandPool = cmd_pool;
     cmd_info.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    cmd_info.commandBufferCount = 1;
+    cmd_info.commandBufferCount = NumFrame;
 
-    res = vkAllocateCommandBuffers(Device, &cmd_info, &cmd);
+    frameCmds.resize(NumFrame);
+    res = vkAllocateCommandBuffers(Device, &cmd_info, frameCmds.data());
     assert(res == VK_SUCCESS);
+    cmd = frameCmds[CurrentFrameIndex];
 
-    UniformBufferCreateInfo uniformBufferInfo;
-    uniformBufferInfo.size = sizeof(MVP);
+    // signaled, the first wait of each frame returns right away.
+    VkFenceCreateInfo fence_info = {};
+    fence_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+    fence_info.pNext = NULL;
+    fence_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+
+    frameFences.resize(NumFrame);
+    for (uint32_t i = 0; i < NumFrame; i++)
+    {
+        res = vkCreateFence(Device, &fence_info, NULL, &frameFences[i]);
+        assert(res == VK_SUCCESS);
+    }
 
-    uniformBuffer = std::shared_ptr<VKUniformBuffer>(new VKUniformBuffer);
-    uniformBuffer->Create(&uniformBufferInfo);
+    // per frame in flight, the acquire of frame i is waited for by its submit, the present waits for the submit.
+    VkSemaphoreCreateInfo semaphore_info = {};
+    semaphore_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+    semaphore_info.pNext = NULL;
+    semaphore_info.flags = 0;
+
+    imageAcquiredSemaphores.resize(NumFrame);
+    renderCompleteSemaphores.resize(NumFrame);
+    for (uint32_t i = 0; i < NumFrame; i++)
+    {
+        res = vkCreateSemaphore(Device, &semaphore_info, NULL, &imageAcquiredSemaphores[i]);
+        assert(res == VK_SUCCESS);
+        res = vkCreateSemaphore(Device, &semaphore_info, NULL, &renderCompleteSemaphores[i]);
+        assert(res == VK_SUCCESS);
+    }
+
+    uniformRing = std::make_unique<VKUniformRingBuffer>(1024 * 1024 * 10, NumFrame, uint32_t(physical_device_props.limits.minUniformBufferOffsetAlignment));
 
     // descriptor pool
     std::vector<VkDescriptorPoolSize> type_count =
     {
         {
-            /*type*/VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
+            /*type*/VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
             /*descriptorCount*/10000
         },
        
@@ -1329,6 +1491,144 @@ bool VulkanImpl::Init(HINSTANCE hInstance, HWND hWnd, UINT DisplayWidth, UINT Di
 
     res = vkCreateDescriptorPool(Device, &descriptor_pool, NULL, &desc_pool);
     assert(res == VK_SUCCESS);
+
+    std::vector<uint8_t> cacheData;
+    std::string cacheError;
+    if (!pipelineCacheLoader.Get(cacheData, cacheError) && !cacheError.empty())
+        OutputDebugStringA(("pipeline cache: " + cacheError + "\n").c_str());
+
+    VkPipelineCacheCreateInfo cache_info = {};
+    cache_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    cache_info.pNext = NULL;
+    cache_info.initialDataSize = cacheData.size();
+    cache_info.pInitialData = cacheData.empty() ? NULL : cacheData.data();
+
+    res = vkCreatePipelineCache(Device, &cache_info, NULL, &pipelineCache);
+    assert(res == VK_SUCCESS);
+}
+
+uint64_t VulkanImpl::GetPipelineCacheDeviceId() const
+{
+    return (uint64_t(physical_device_props.vendorID) << 32) | physical_device_props.deviceID;
+}
+
+void VulkanImpl::SavePipelineCache()
+{
+    size_t size = 0;
+    if (vkGetPipelineCacheData(Device, pipelineCache, &size, NULL) != VK_SUCCESS)
+        return;
+
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(Device, pipelineCache, &size, data.data()) != VK_SUCCESS)
+        return;
+
+    std::string error;
+    if (!WritePipelineCacheFile("PipelineCache_Vulkan.bin", GetPipelineCacheDeviceId(), data.data(), size, error))
+        OutputDebugStringA(("pipeline cache: " + error + "\n").c_str());
+}
+
+void VulkanImpl::BeginFrame()
+{
+    VkResult res;
+
+    res = vkWaitForFences(Device, 1, &frameFences[CurrentFrameIndex], VK_TRUE, UINT64_MAX);
+    assert(res == VK_SUCCESS);
+    res = vkResetFences(Device, 1, &frameFences[CurrentFrameIndex]);
+    assert(res == VK_SUCCESS);
+
+    res = vkAcquireNextImageKHR(Device, swap_chain, UINT64_MAX, imageAcquiredSemaphores[CurrentFrameIndex], VK_NULL_HANDLE, &CurrentImageIndex);
+    assert(res == VK_SUCCESS || res == VK_SUBOPTIMAL_KHR);
+
+    cmd = frameCmds[CurrentFrameIndex];
+    vkResetCommandBuffer(cmd, 0);
+
+    VkCommandBufferBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+    begin_info.pNext = NULL;
+    begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+    res = vkBeginCommandBuffer(cmd, &begin_info);
+    assert(res == VK_SUCCESS);
+}
+
+void VulkanImpl::EndFrame()
+{
+    VkResult res;
+
+    EndRenderPass();
+    boundPSO = nullptr;
+
+    res = vkEndCommandBuffer(cmd);
+    assert(res == VK_SUCCESS);
+
+    // the first color write waits for the image to come back from the presentation engine.
+    VkPipelineStageFlags wait_stage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    VkSubmitInfo submit_info = {};
+    submit_info.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+    submit_info.pNext = NULL;
+    submit_info.waitSemaphoreCount = 1;
+    submit_info.pWaitSemaphores = &imageAcquiredSemaphores[CurrentFrameIndex];
+    submit_info.pWaitDstStageMask = &wait_stage;
+    submit_info.commandBufferCount = 1;
+    submit_info.pCommandBuffers = &cmd;
+    submit_info.signalSemaphoreCount = 1;
+    submit_info.pSignalSemaphores = &renderCompleteSemaphores[CurrentFrameIndex];
+
+    res = vkQueueSubmit(GraphicsQueue, 1, &submit_info, frameFences[CurrentFrameIndex]);
+    assert(res == VK_SUCCESS);
+
+    VkPresentInfoKHR present_info = {};
+    present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
+    present_info.pNext = NULL;
+    present_info.waitSemaphoreCount = 1;
+    present_info.pWaitSemaphores = &renderCompleteSemaphores[CurrentFrameIndex];
+    present_info.swapchainCount = 1;
+    present_info.pSwapchains = &swap_chain;
+    present_info.pImageIndices = &CurrentImageIndex;
+
+    res = vkQueuePresentKHR(PresentQueue, &present_info);
+    assert(res == VK_SUCCESS || res == VK_SUBOPTIMAL_KHR);
+
+    // the ring's slice of the next frame was last used NumFrame frames ago, BeginFrame waits for it.
+    CurrentFrameIndex = (CurrentFrameIndex + 1) % NumFrame;
+    uniformRing->Advance();
+}
+
+void VulkanImpl::BeginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent, uint32_t numColorTargets)
+{
+    if (renderPass == activeRenderPass && framebuffer == activeFramebuffer)
+        return;
+    EndRenderPass();
+
+    // matches the attachments of the pso's render pass, colors then depth.
+    std::vector<VkClearValue> clear_values(numColorTargets + 1);
+    for (uint32_t i = 0; i < numColorTargets; i++)
+        clear_values[i].color = { { 0.f, 0.f, 0.f, 1.f } };
+    clear_values[numColorTargets].depthStencil = { 1.f, 0 };
+
+    VkRenderPassBeginInfo begin_info = {};
+    begin_info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+    begin_info.pNext = NULL;
+    begin_info.renderPass = renderPass;
+    begin_info.framebuffer = framebuffer;
+    begin_info.renderArea.offset = { 0, 0 };
+    begin_info.renderArea.extent = extent;
+    begin_info.clearValueCount = uint32_t(clear_values.size());
+    begin_info.pClearValues = clear_values.data();
+
+    vkCmdBeginRenderPass(cmd, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+    activeRenderPass = renderPass;
+    activeFramebuffer = framebuffer;
+}
+
+void VulkanImpl::EndRenderPass()
+{
+    if (activeRenderPass == VK_NULL_HANDLE)
+        return;
+    vkCmdEndRenderPass(cmd);
+    activeRenderPass = VK_NULL_HANDLE;
+    activeFramebuffer = VK_NULL_HANDLE;
 }
 
 void VulkanImpl::GetFrameBuffers(std::vector<std::shared_ptr<VKTexture>>& vkFrameFuffers)
@@ -7,9 +7,12 @@
 #include <string>
 #include <optional>
 #include <map>
+#include <tuple>
+#include <unordered_map>
 #include <glm/glm.hpp>
 
 #include "AbstractGfxLayer.h"
+#include "PipelineCache.h"
 
 struct TextureCreateInfo
 {
@@ -58,13 +61,39 @@ public:
 	virtual ~VKUniformBuffer();
 };
 
+// uniform data written once per draw. one mapped buffer with a slice per frame in flight, the pso binds it as
+// a dynamic uniform buffer so a new allocation only changes the dynamic offset, not the descriptor set.
+class VKUniformRingBuffer
+{
+	uint32_t NumFrame = 0;
+	uint32_t CurrentFrame = 0;
+	uint32_t TotalSize = 0;
+	uint32_t Alignment = 256;
+
+	uint32_t AllocPos = 0;
+
+	uint8_t* MemMapped = nullptr;
+
+public:
+	VkBuffer buffer = VK_NULL_HANDLE;
+	VkDeviceMemory memory = VK_NULL_HANDLE;
+
+	// offset from the start of the buffer and the mapped memory.
+	std::tuple<uint32_t, uint8_t*> AllocGPUMemory(uint32_t InSize);
+	void Advance();
+	uint32_t GetAlignment() const { return Alignment; }
+
+	VKUniformRingBuffer(uint32_t InSize, uint32_t InNumFrame, uint32_t InAlignment);
+	virtual ~VKUniformRingBuffer();
+};
+
 struct VertexBufferInfo
 {
 	uint32_t size;
 	void* pData;
 };
 
-class VKVertexBuffer
+class VKVertexBuffer : public GfxVertexBuffer
 {
 public:
 	VkBuffer buffer;
@@ -126,7 +155,10 @@ public:
 	{
 		std::string name;
 		uint32_t BindingIndex;
-		VKUniformBuffer* uniformBuffer;
+		uint32_t size = 0;
+		// buffer and range go into the descriptor set, the offset is passed as a dynamic offset.
+		VkBuffer buffer = VK_NULL_HANDLE;
+		uint32_t dynamicOffset = 0;
 		// sampler
 		// texture
 		// rw texture
@@ -140,6 +172,16 @@ public:
 	std::vector<VkDescriptorSetLayout> desc_layout;
 	std::vector<VkDescriptorSet> desc_set;
 
+	// descriptor sets are written once per set of bound buffers. with uniforms from the ring every frame
+	// hits the same entry. the hash only picks the bucket, an entry matches on the whole key, the buffer
+	// and size of every uniform slot.
+	struct DescSetCacheEntry
+	{
+		std::vector<uint64_t> key;
+		std::vector<VkDescriptorSet> sets;
+	};
+	std::unordered_map<uint64_t, std::vector<DescSetCacheEntry>> descSetCache;
+
 	VkRenderPass render_pass;
 
 	VkVertexInputBindingDescription vi_binding;
@@ -149,6 +191,8 @@ public:
 
 	std::map<VKTexture*, VkFramebuffer> frameBuffers;
 	VkFramebuffer currentFBO;
+	VkExtent2D currentExtent = {};
+	uint32_t numColorTargets = 0;
 	// max 32 descriptor sets per pipeline.
 	// strategy 1
 	// descriptor set for resource type(uniform buffer, texture, image)
@@ -157,19 +201,32 @@ public:
 	VKPipelineStateObject(){}
 	virtual ~VKPipelineStateObject();
 
-	void BindUniform(std::string name, int index);
+	void BindUniform(std::string name, int index, int size);
 	void BindSampler(std::string name, int index);
 	void BindTexture(std::string name, int index);
 
-	void SetUniformBuffer(std::string name, VKUniformBuffer* buffer);
+	void SetUniformBuffer(std::string name, VkBuffer buffer, uint32_t offset);
+	// copies the data to the uniform ring.
+	void SetUniformValue(std::string name, void* pData);
 
 	void SetRendertargets(std::vector<VKTexture*> colorTargets, VKTexture* depthTarget);
 
-	void Apply();
+	// registers may leave gaps, the uniform array of the layout has an element for every register up to
+	// the highest one.
+	uint32_t GetNumUniformSlots() const;
+
+	// begins the render pass on the current render targets and binds the pipeline. uniforms may still
+	// change until the draw, like root cbvs on dx12.
+	void Apply(VkCommandBuffer cmd);
+	// binds the descriptor sets and dynamic offsets of the current uniforms, allocating and writing sets
+	// only for a new set of buffers. called by every draw.
+	void BindDescriptorSets(VkCommandBuffer cmd);
 
 	bool Create(PSOCreateInfo* info);
 };
 
+// groundwork of the vulkan backend, see the readme. frames in flight, the uniform ring and cached
+// descriptor sets for SimpleDrawPass, no ray tracing or other passes yet, win32 only.
 class VulkanImpl
 {
 public:
@@ -179,10 +236,26 @@ public:
 	std::vector<VkPhysicalDevice> vecGPU;
 	VkDevice Device;
 	VkQueue GraphicsQueue;
+	VkQueue PresentQueue;
 	VkSurfaceKHR Surface;
 	VkSwapchainKHR swap_chain;
 	VkCommandPool cmd_pool;
-	VkCommandBuffer cmd;
+	VkCommandBuffer cmd;	// command buffer of the current frame
+
+	static const uint32_t NumFrame = 3;
+	uint32_t CurrentFrameIndex = 0;
+	std::vector<VkCommandBuffer> frameCmds;
+	std::vector<VkFence> frameFences;
+	// per frame slot, the acquired image is ready for rendering / the frame is ready for present.
+	std::vector<VkSemaphore> imageAcquiredSemaphores;
+	std::vector<VkSemaphore> renderCompleteSemaphores;
+	// the swap chain image acquired by BeginFrame, the back buffer index of the dx12 path.
+	uint32_t CurrentImageIndex = 0;
+
+	// the pso of the last Apply and its render pass, open until EndRenderPass.
+	VKPipelineStateObject* boundPSO = nullptr;
+	VkRenderPass activeRenderPass = VK_NULL_HANDLE;
+	VkFramebuffer activeFramebuffer = VK_NULL_HANDLE;
 
 
 	VkPhysicalDeviceMemoryProperties memory_properties;
@@ -192,6 +265,11 @@ public:
 
 	// pso
 	VkDescriptorPool desc_pool;
+	std::unique_ptr<VKUniformRingBuffer> uniformRing;
+
+	// every pipeline is created through it, saved to disk when the device goes away. see PipelineCache.h.
+	VkPipelineCache pipelineCache = VK_NULL_HANDLE;
+	PipelineCacheLoader pipelineCacheLoader;
 
 
 	// validation layer
@@ -201,17 +279,10 @@ public:
 	VkDebugReportCallbackEXT debug_report_callback;
 	std::vector<VkDebugReportCallbackEXT> debug_report_callbacks;
 
-	//
-	glm::mat4 MVP;
-
 	std::shared_ptr<VKTexture> depthTexture;
 	std::vector<std::shared_ptr<VKTexture>> frameBufferTextures;
 	std::vector<VkFramebuffer> frameBuffers;
 
-	
-
-	std::shared_ptr<VKUniformBuffer> uniformBuffer;
-
 	std::shared_ptr< VKPipelineStateObject> pipeline;
 
 
@@ -223,6 +294,22 @@ public:
 
 	void GetFrameBuffers(std::vector<std::shared_ptr<VKTexture>>& vkFrameFuffers);
 
+	uint64_t GetPipelineCacheDeviceId() const;
+	void SavePipelineCache();
+
+	// waits until the frame's command buffer is free, acquires the next swap chain image and begins the
+	// command buffer.
+	void BeginFrame();
+	// submits the command buffer with the frame's fence once the image is acquired, presents it when the
+	// submit finished and moves to the next frame.
+	void EndFrame();
+
+	// a no-op when the pass is already open on the framebuffer. clears the targets, the load op of the
+	// pso's render pass.
+	void BeginRenderPass(VkRenderPass renderPass, VkFramebuffer framebuffer, VkExtent2D extent, uint32_t numColorTargets);
+	// before barriers, another render pass or the end of the command buffer.
+	void EndRenderPass();
+
 	VulkanImpl();
 	~VulkanImpl();
 };
@@ -0,0 +1,213 @@
+#include "TestFramework.h"
+#include "AsyncCompute.h"
+
+#include <cstring>
+#include <sstream>
+
+// the async compute scheduler: dependencies from read and write sets, which passes move to the compute
+// queue, where the fences go and the overlap it reports. resources are addresses of the ints below.
+namespace
+{
+	int Luma, Histogram, Exposure, Depth, Shadow, Lighting, Bloom, BackBuffer;
+
+	AsyncPassDesc MakePass(const char* Name, bool bComputeCapable, std::vector<const void*> Reads, std::vector<const void*> Writes, double Ms = 1.0)
+	{
+		AsyncPassDesc Desc;
+		Desc.Name = Name;
+		Desc.bComputeCapable = bComputeCapable;
+		Desc.Reads = Reads;
+		Desc.Writes = Writes;
+		Desc.EstimatedMs = Ms;
+		return Desc;
+	}
+
+	// the passes of Corona::OnRender around the async exposure, in submission order.
+	void AddExposureFrame(AsyncComputeScheduler& Scheduler)
+	{
+		Scheduler.AddPass(MakePass("AsyncExposureAcquire", false, {}, { &Luma, &Histogram, &Exposure }, 0.0));
+		Scheduler.AddPass(MakePass("ExposurePass", true, { &Luma }, { &Histogram, &Exposure }, 0.2));
+		Scheduler.AddPass(MakePass("GBufferPass", false, {}, { &Depth }, 2.0));
+		Scheduler.AddPass(MakePass("RaytraceShadowPass", false, { &Depth }, { &Shadow }, 1.5));
+		Scheduler.AddPass(MakePass("LightingPass", false, { &Depth, &Shadow }, { &Lighting }, 0.5));
+		Scheduler.AddPass(MakePass("AsyncExposureRelease", false, {}, { &Luma, &Histogram, &Exposure }, 0.0));
+		Scheduler.AddPass(MakePass("BloomPass", false, { &Lighting, &Exposure }, { &Bloom }, 0.3));
+		Scheduler.AddPass(MakePass("ToneMapPass", false, { &Bloom, &Exposure }, { &BackBuffer }, 0.1));
+	}
+}
+
+TEST_CASE(ExposureOverlapsTheFrame)
+{
+	AsyncComputeScheduler Scheduler;
+	AddExposureFrame(Scheduler);
+	Scheduler.Solve();
+
+	const std::vector<AsyncScheduledPass>& Schedule = Scheduler.GetSchedule();
+	CHECK_EQ(Schedule.size(), 8);
+	CHECK_EQ(Scheduler.GetAsyncPassNames().size(), 1);
+	CHECK(std::strcmp(Scheduler.GetAsyncPassNames()[0], "ExposurePass") == 0);
+
+	// exposure waits for the acquire, the release waits for exposure, nothing else needs a fence.
+	CHECK(Schedule[1].Queue == GPUQueue::Compute);
+	CHECK_EQ(Schedule[1].WaitForPass, 0);
+	CHECK(Schedule[0].bSignal && Schedule[1].bSignal);
+	CHECK(!Schedule[1].bWaitPreviousFrame);
+	CHECK_EQ(Schedule[5].WaitForPass, 1);
+	for (uint32_t Index : { 2u, 3u, 4u, 6u, 7u })
+	{
+		CHECK(Schedule[Index].Queue == GPUQueue::Graphics);
+		CHECK_EQ(Schedule[Index].WaitForPass, -1);
+		CHECK(!Schedule[Index].bSignal);
+	}
+
+	// the gbuffer, shadows and lighting run next to it, the release joins the queues in the frame.
+	CHECK_NEAR(Schedule[1].OverlapMs, 4.0, 1e-9);
+	CHECK_NEAR(Scheduler.GetTotalOverlapMs(), 4.0, 1e-9);
+	CHECK_EQ(Scheduler.GetFrameEndWaitForPass(), -1);
+}
+
+TEST_CASE(AsyncDisabledKeepsGraphics)
+{
+	AsyncComputeScheduler Scheduler;
+	Scheduler.SetAsyncEnabled(false);
+	AddExposureFrame(Scheduler);
+	Scheduler.Solve();
+
+	CHECK(Scheduler.GetAsyncPassNames().empty());
+	for (const AsyncScheduledPass& Pass : Scheduler.GetSchedule())
+	{
+		CHECK(Pass.Queue == GPUQueue::Graphics);
+		CHECK_EQ(Pass.WaitForPass, -1);
+		CHECK(!Pass.bSignal && !Pass.bWaitPreviousFrame);
+	}
+	CHECK(std::strcmp(Scheduler.GetSchedule()[1].Reason, "async disabled") == 0);
+	CHECK(std::strcmp(Scheduler.GetSchedule()[2].Reason, "graphics only") == 0);
+	CHECK_EQ(Scheduler.GetFrameEndWaitForPass(), -1);
+}
+
+TEST_CASE(DependencyKinds)
+{
+	int A, B;
+
+	// read after write, write after read and write after write each order a compute pass after the
+	// graphics pass before it. two reads don't.
+	struct Case { std::vector<const void*> GfxReads, GfxWrites, ComputeReads, ComputeWrites; bool bDependent; };
+	const Case Cases[] = {
+		{ {}, { &A }, { &A }, { &B }, true },
+		{ { &A }, {}, {}, { &A }, true },
+		{ {}, { &A }, {}, { &A }, true },
+		{ { &A }, {}, { &A }, { &B }, false },
+	};
+
+	for (const Case& C : Cases)
+	{
+		AsyncComputeScheduler Scheduler;
+		Scheduler.AddPass(MakePass("First", false, C.GfxReads, C.GfxWrites));
+		Scheduler.AddPass(MakePass("Compute", true, C.ComputeReads, C.ComputeWrites));
+		Scheduler.AddPass(MakePass("Independent", false, {}, {}, 3.0));
+		Scheduler.Solve();
+
+		const std::vector<AsyncScheduledPass>& Schedule = Scheduler.GetSchedule();
+		CHECK(Schedule[1].Queue == GPUQueue::Compute);
+		CHECK_EQ(Schedule[1].WaitForPass, C.bDependent ? 0 : -1);
+		CHECK_EQ(Schedule[0].bSignal, C.bDependent);
+
+		// nothing on graphics waits for the compute pass in the frame, the frame end does. without the
+		// dependency it runs next to the first pass as well.
+		CHECK_EQ(Scheduler.GetFrameEndWaitForPass(), 1);
+		CHECK(Schedule[1].bSignal);
+		CHECK_NEAR(Schedule[1].OverlapMs, C.bDependent ? 3.0 : 4.0, 1e-9);
+	}
+}
+
+TEST_CASE(ComputeWithoutOverlapMovesBack)
+{
+	int A, B, C;
+
+	// the very next graphics pass consumes the result, the compute queue would only add fences.
+	AsyncComputeScheduler Scheduler;
+	Scheduler.AddPass(MakePass("Producer", false, {}, { &A }));
+	Scheduler.AddPass(MakePass("Compute", true, { &A }, { &B }));
+	Scheduler.AddPass(MakePass("Consumer", false, { &B }, { &C }));
+	Scheduler.Solve();
+
+	const std::vector<AsyncScheduledPass>& Schedule = Scheduler.GetSchedule();
+	CHECK(Scheduler.GetAsyncPassNames().empty());
+	CHECK(Schedule[1].Queue == GPUQueue::Graphics);
+	CHECK(std::strcmp(Schedule[1].Reason, "no independent graphics work") == 0);
+	for (const AsyncScheduledPass& Pass : Schedule)
+		CHECK(Pass.WaitForPass == -1 && !Pass.bSignal);
+	CHECK_EQ(Scheduler.GetFrameEndWaitForPass(), -1);
+}
+
+TEST_CASE(PreviousFrameWait)
+{
+	int A, B;
+
+	// nothing in the frame comes before the compute pass, but the previous frame's consumer may still
+	// read what it overwrites.
+	AsyncComputeScheduler Scheduler;
+	Scheduler.AddPass(MakePass("Compute", true, {}, { &A }, 0.5));
+	Scheduler.AddPass(MakePass("Independent", false, {}, { &B }, 2.0));
+	Scheduler.AddPass(MakePass("Consumer", false, { &A }, {}, 1.0));
+	Scheduler.Solve();
+
+	const std::vector<AsyncScheduledPass>& Schedule = Scheduler.GetSchedule();
+	CHECK(Schedule[0].Queue == GPUQueue::Compute);
+	CHECK(Schedule[0].bWaitPreviousFrame);
+	CHECK_EQ(Schedule[0].WaitForPass, -1);
+	CHECK(Schedule[0].bSignal);
+	CHECK_EQ(Schedule[2].WaitForPass, 0);
+	CHECK_NEAR(Schedule[0].OverlapMs, 2.0, 1e-9);
+
+	// a compute pass independent of every graphics pass needs no wait at all.
+	Scheduler.Clear();
+	Scheduler.AddPass(MakePass("Compute", true, {}, { &A }));
+	Scheduler.AddPass(MakePass("Independent", false, {}, { &B }));
+	Scheduler.Solve();
+	CHECK(!Scheduler.GetSchedule()[0].bWaitPreviousFrame);
+	CHECK_EQ(Scheduler.GetFrameEndWaitForPass(), 0);
+}
+
+TEST_CASE(RedundantWaitsAreSkipped)
+{
+	int A, B, C, D, E;
+
+	// two compute passes in a row, the graphics queue joins once for both and the second consumer
+	// is covered by the first wait.
+	AsyncComputeScheduler Scheduler;
+	Scheduler.AddPass(MakePass("Producer", false, {}, { &A }));
+	Scheduler.AddPass(MakePass("ComputeB", true, { &A }, { &B }));
+	Scheduler.AddPass(MakePass("ComputeC", true, { &A }, { &C }));
+	Scheduler.AddPass(MakePass("Independent", false, {}, { &D }, 2.0));
+	Scheduler.AddPass(MakePass("ConsumerC", false, { &C }, { &E }));
+	Scheduler.AddPass(MakePass("ConsumerB", false, { &B }, { &E }));
+	Scheduler.Solve();
+
+	const std::vector<AsyncScheduledPass>& Schedule = Scheduler.GetSchedule();
+	CHECK_EQ(Scheduler.GetAsyncPassNames().size(), 2);
+
+	// the queue runs in order, the wait for the producer before ComputeB covers ComputeC.
+	CHECK_EQ(Schedule[1].WaitForPass, 0);
+	CHECK_EQ(Schedule[2].WaitForPass, -1);
+	CHECK_EQ(Schedule[4].WaitForPass, 2);
+	CHECK_EQ(Schedule[5].WaitForPass, -1);
+	CHECK(!Schedule[1].bSignal && Schedule[2].bSignal);
+	CHECK_NEAR(Scheduler.GetTotalOverlapMs(), 2.0, 1e-9);
+	CHECK_EQ(Scheduler.GetFrameEndWaitForPass(), -1);
+}
+
+TEST_CASE(ScheduleReport)
+{
+	AsyncComputeScheduler Scheduler;
+	AddExposureFrame(Scheduler);
+	Scheduler.Solve();
+
+	std::ostringstream Report;
+	Scheduler.WriteReport(Report);
+	const std::string Text = Report.str();
+	CHECK(Text.find("async compute: 1 of 8 passes, overlap 4.00 ms") == 0);
+	CHECK(Text.find("ExposurePass") != std::string::npos);
+	CHECK(Text.find("waits AsyncExposureAcquire, signals, overlaps 4.00 ms") != std::string::npos);
+	CHECK(Text.find("waits ExposurePass") != std::string::npos);
+	CHECK(Text.find("frame end waits") == std::string::npos);
+}
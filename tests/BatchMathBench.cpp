@@ -0,0 +1,93 @@
+#include "TestFramework.h"
+#include "BatchMath.h"
+
+#include <cfloat>
+#include <cstdio>
+#include <random>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// the batched matrix kernels on 100k matrices against the glm loops they replace, the sse path where the
+// compiler targets it.
+namespace
+{
+	const size_t kNumMatrices = 100000;
+
+	std::vector<glm::mat4x4> MakeTransforms(uint32_t Seed)
+	{
+		std::mt19937 Rng(Seed);
+		std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+		std::vector<glm::mat4x4> Transforms(kNumMatrices);
+		for (glm::mat4x4& M : Transforms)
+		{
+			M = glm::translate(glm::mat4x4(1.f), glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) * 1000.f);
+			M = glm::rotate(M, Unit(Rng) * 3.f, glm::normalize(glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) + 0.01f));
+			M = glm::scale(M, glm::vec3(1.f + Unit(Rng) * 0.5f));
+		}
+		return Transforms;
+	}
+
+	// keeps the compiler from dropping the glm loops.
+	float Checksum(const std::vector<glm::mat4x4>& Matrices)
+	{
+		float Sum = 0.f;
+		for (const glm::mat4x4& M : Matrices)
+			Sum += M[0][0] + M[3][2];
+		return Sum;
+	}
+}
+
+BENCHMARK(BatchMath100k)
+{
+	const std::vector<glm::mat4x4> A = MakeTransforms(1);
+	std::vector<glm::mat4x4> Out(kNumMatrices), Reference(kNumMatrices);
+
+	// the glm loops store through a volatile pointer, the compiler can't tell that every run writes the
+	// same values and keep only the last one.
+	glm::mat4x4* volatile ReferenceData = Reference.data();
+
+	const double GlmTransposeMs = MeasureMs([&]() { glm::mat4x4* Dest = ReferenceData; for (size_t i = 0; i < kNumMatrices; i++) Dest[i] = glm::transpose(A[i]); }, 20);
+	const double BatchTransposeMs = MeasureMs([&]() { BatchTranspose(A.data(), Out.data(), kNumMatrices); }, 20);
+	std::printf("  transpose: glm %.3f ms, batch %.3f ms\n", GlmTransposeMs, BatchTransposeMs);
+	CHECK(Out == Reference);
+
+	const double GlmInverseMs = MeasureMs([&]() { glm::mat4x4* Dest = ReferenceData; for (size_t i = 0; i < kNumMatrices; i++) Dest[i] = glm::inverse(A[i]); }, 20);
+	const double BatchInverseMs = MeasureMs([&]() { BatchAffineInverse(A.data(), Out.data(), kNumMatrices); }, 20);
+	std::printf("  affine inverse: glm::inverse %.3f ms, batch %.3f ms\n", GlmInverseMs, BatchInverseMs);
+	CHECK_NEAR(Checksum(Out), Checksum(Reference), 1.f);
+
+	// the structure of arrays layout of InstanceStore.
+	std::vector<float> Elements[3][4];
+	const float* Rows[3][4];
+	for (int Row = 0; Row < 3; Row++)
+		for (int Column = 0; Column < 4; Column++)
+		{
+			for (const glm::mat4x4& M : A)
+				Elements[Row][Column].push_back(M[Column][Row]);
+			Rows[Row][Column] = Elements[Row][Column].data();
+		}
+
+	const glm::vec3 Min(-0.5f), Max(0.5f);
+	glm::vec3 ScalarMin, ScalarMax, BatchMin, BatchMax;
+	const double ScalarBoundsMs = MeasureMs([&]()
+	{
+		const glm::vec3 Center = (Min + Max) * 0.5f;
+		const glm::vec3 Extent = (Max - Min) * 0.5f;
+		ScalarMin = glm::vec3(FLT_MAX);
+		ScalarMax = glm::vec3(-FLT_MAX);
+		for (const glm::mat4x4& M : A)
+		{
+			const glm::vec3 WorldCenter = glm::vec3(M * glm::vec4(Center, 1.f));
+			const glm::vec3 WorldExtent = glm::abs(glm::vec3(M[0])) * Extent.x + glm::abs(glm::vec3(M[1])) * Extent.y + glm::abs(glm::vec3(M[2])) * Extent.z;
+			ScalarMin = glm::min(ScalarMin, WorldCenter - WorldExtent);
+			ScalarMax = glm::max(ScalarMax, WorldCenter + WorldExtent);
+		}
+	}, 20);
+	const double BatchBoundsMs = MeasureMs([&]() { BatchTransformBoundsUnion(Rows, uint32_t(kNumMatrices), Min, Max, BatchMin, BatchMax); }, 20);
+	std::printf("  bounds union: scalar %.3f ms, batch %.3f ms\n", ScalarBoundsMs, BatchBoundsMs);
+	for (int Axis = 0; Axis < 3; Axis++)
+	{
+		CHECK_NEAR(BatchMin[Axis], ScalarMin[Axis], 1e-2f);
+		CHECK_NEAR(BatchMax[Axis], ScalarMax[Axis], 1e-2f);
+	}
+}
@@ -0,0 +1,140 @@
+#include "TestFramework.h"
+#include "BatchMath.h"
+
+#include <cfloat>
+#include <random>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// the batched matrix kernels against glm and a double precision reference, with the counts and aliasing
+// OnUpdate and InstanceStore use them with.
+namespace
+{
+	glm::mat4x4 MakeMatrix(std::mt19937& Rng)
+	{
+		std::uniform_real_distribution<float> Unit(-10.f, 10.f);
+		glm::mat4x4 M;
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+				M[c][r] = Unit(Rng);
+		return M;
+	}
+
+	// rotation, non uniform scale and translation, a view or object transform.
+	glm::mat4x4 MakeAffine(std::mt19937& Rng)
+	{
+		std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+		glm::mat4x4 M = glm::translate(glm::mat4x4(1.f), glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) * 1000.f);
+		M = glm::rotate(M, Unit(Rng) * 3.f, glm::normalize(glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) + 0.01f));
+		return glm::scale(M, glm::vec3(0.1f + 4.f * (Unit(Rng) + 1.f), 0.5f + Unit(Rng) * 0.4f, 2.f));
+	}
+
+	glm::dmat4x4 ToDouble(const glm::mat4x4& M)
+	{
+		return glm::dmat4x4(M);
+	}
+
+	// the largest element difference relative to the largest element of Reference.
+	double RelativeError(const glm::mat4x4& M, const glm::dmat4x4& Reference)
+	{
+		double MaxDiff = 0.0, MaxValue = 0.0;
+		for (int c = 0; c < 4; c++)
+			for (int r = 0; r < 4; r++)
+			{
+				MaxDiff = std::max(MaxDiff, std::fabs(double(M[c][r]) - Reference[c][r]));
+				MaxValue = std::max(MaxValue, std::fabs(Reference[c][r]));
+			}
+		return MaxDiff / MaxValue;
+	}
+}
+
+TEST_CASE(BatchTransposeIsExact)
+{
+	std::mt19937 Rng(2);
+	const size_t Count = 9;
+	std::vector<glm::mat4x4> In(Count), Out(Count);
+	for (glm::mat4x4& M : In)
+		M = MakeMatrix(Rng);
+
+	BatchTranspose(In.data(), Out.data(), Count);
+	for (size_t i = 0; i < Count; i++)
+		CHECK(Out[i] == glm::transpose(In[i]));
+
+	std::vector<glm::mat4x4> InPlace = In;
+	BatchTranspose(InPlace.data(), InPlace.data(), Count);
+	CHECK(InPlace == Out);
+}
+
+TEST_CASE(BatchAffineInverseAccuracy)
+{
+	std::mt19937 Rng(3);
+	const size_t Count = 1000;
+	std::vector<glm::mat4x4> In(Count), Out(Count);
+	for (glm::mat4x4& M : In)
+		M = MakeAffine(Rng);
+	In[0] = glm::mat4x4(1.f);
+	In[1] = glm::lookAtLH(glm::vec3(10.f, 5.f, -20.f), glm::vec3(0.f), glm::vec3(0.f, 1.f, 0.f));
+
+	BatchAffineInverse(In.data(), Out.data(), Count);
+
+	double MaxError = 0.0;
+	for (size_t i = 0; i < Count; i++)
+	{
+		// against the inverse in double, a few float ulps of the largest element.
+		const double Error = RelativeError(Out[i], glm::inverse(ToDouble(In[i])));
+		MaxError = std::max(MaxError, Error);
+		CHECK(Error < 1e-5);
+
+		// the last row stays exact and the product is the identity, up to the rounding of translations
+		// around 1000.
+		CHECK(Out[i][0][3] == 0.f && Out[i][1][3] == 0.f && Out[i][2][3] == 0.f && Out[i][3][3] == 1.f);
+		CHECK(RelativeError(In[i] * Out[i], glm::dmat4x4(1.0)) < 1e-3);
+	}
+	CHECK(Out[0] == glm::mat4x4(1.f));
+	std::printf("  max relative error %.2g\n", MaxError);
+
+	std::vector<glm::mat4x4> InPlace = In;
+	BatchAffineInverse(InPlace.data(), InPlace.data(), Count);
+	CHECK(InPlace == Out);
+}
+
+TEST_CASE(BatchBoundsUnionMatchesScalar)
+{
+	std::mt19937 Rng(4);
+	const glm::vec3 Min(-1.f, 0.f, -2.f), Max(1.f, 3.f, 2.f);
+
+	// counts around the sse width so the tail runs alone, after a full group and not at all.
+	for (uint32_t Count : { 0u, 1u, 3u, 4u, 5u, 8u, 1001u })
+	{
+		std::vector<float> Elements[3][4];
+		const float* Rows[3][4];
+		glm::vec3 ExpectedMin(FLT_MAX), ExpectedMax(-FLT_MAX);
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			const glm::mat4x4 M = MakeAffine(Rng);
+			for (int Row = 0; Row < 3; Row++)
+				for (int Column = 0; Column < 4; Column++)
+					Elements[Row][Column].push_back(M[Column][Row]);
+
+			// every corner of the box.
+			for (int Corner = 0; Corner < 8; Corner++)
+			{
+				const glm::vec3 P((Corner & 1) ? Max.x : Min.x, (Corner & 2) ? Max.y : Min.y, (Corner & 4) ? Max.z : Min.z);
+				const glm::vec3 World = glm::vec3(M * glm::vec4(P, 1.f));
+				ExpectedMin = glm::min(ExpectedMin, World);
+				ExpectedMax = glm::max(ExpectedMax, World);
+			}
+		}
+		for (int Row = 0; Row < 3; Row++)
+			for (int Column = 0; Column < 4; Column++)
+				Rows[Row][Column] = Elements[Row][Column].data();
+
+		glm::vec3 OutMin, OutMax;
+		BatchTransformBoundsUnion(Rows, Count, Min, Max, OutMin, OutMax);
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			CHECK_NEAR(OutMin[Axis], ExpectedMin[Axis], 1e-2f);
+			CHECK_NEAR(OutMax[Axis], ExpectedMax[Axis], 1e-2f);
+		}
+	}
+}
@@ -0,0 +1,341 @@
+#include "TestFramework.h"
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+// the camera path, the command line of the benchmark mode and the csv and json the recorder writes.
+namespace
+{
+	std::string TempPath(const char* Name)
+	{
+		return (std::filesystem::temp_directory_path() / Name).string();
+	}
+
+	CameraPathKey MakeKey(float Time, const glm::vec3& Position, float Yaw, const glm::vec3& LightDir, float Intensity)
+	{
+		CameraPathKey Key;
+		Key.Time = Time;
+		Key.Position = Position;
+		Key.Yaw = Yaw;
+		Key.Pitch = -Yaw * 0.5f;
+		Key.LightDir = glm::normalize(LightDir);
+		Key.LightIntensity = Intensity;
+		return Key;
+	}
+
+	float MaxDifference(const glm::vec3& A, const glm::vec3& B)
+	{
+		const glm::vec3 D = glm::abs(A - B);
+		return std::max(D.x, std::max(D.y, D.z));
+	}
+
+	std::vector<std::string> SplitLines(const std::string& Text)
+	{
+		std::vector<std::string> Lines;
+		std::istringstream Stream(Text);
+		for (std::string Line; std::getline(Stream, Line);)
+			Lines.push_back(Line);
+		return Lines;
+	}
+
+	std::vector<std::string> SplitFields(const std::string& Line)
+	{
+		std::vector<std::string> Fields(1);
+		for (char c : Line)
+		{
+			if (c == ',')
+				Fields.emplace_back();
+			else
+				Fields.back() += c;
+		}
+		return Fields;
+	}
+}
+
+TEST_CASE(CameraPathParse)
+{
+	CameraPath Path;
+	std::string Error;
+	CHECK(Path.Parse("# time px py pz yaw pitch lx ly lz intensity\n"
+		"\n"
+		"0 1 2 3 0.5 -0.25 0 2 0 4\r\n"
+		"   \t\n"
+		"  # indented comment\n"
+		"1.5 4 5 6 1 0 1 1 0 2", Error));
+	CHECK_EQ(Path.GetKeys().size(), 2);
+	CHECK_NEAR(Path.GetDuration(), 1.5f, 1e-6f);
+	const CameraPathKey& First = Path.GetKeys()[0];
+	CHECK(First.Position == glm::vec3(1.f, 2.f, 3.f));
+	CHECK_EQ(First.Yaw, 0.5f);
+	CHECK_EQ(First.Pitch, -0.25f);
+	CHECK_EQ(First.LightIntensity, 4.f);
+	// light directions are normalized.
+	CHECK(First.LightDir == glm::vec3(0.f, 1.f, 0.f));
+	CHECK_NEAR(glm::length(Path.GetKeys()[1].LightDir), 1.f, 1e-6f);
+
+	// equal times are kept, a zero length segment.
+	CHECK(Path.Parse("0 0 0 0 0 0 0 1 0 1\n0 1 1 1 0 0 0 1 0 1\n", Error));
+	CHECK_EQ(Path.GetKeys().size(), 2);
+
+	// every malformed file fails with the line it stopped at and leaves no keys behind.
+	const struct { const char* Text; const char* Error; } Malformed[] = {
+		{ "", "no keys" },
+		{ "# only a comment\n\n", "no keys" },
+		{ "0 0 0 0 0 0 0 1 0\n", "line 1: expected" },
+		{ "0 0 0 0 0 0 0 1 0 1 7\n", "line 1: expected" },
+		{ "0 0 0 0 0 0 0 1 0 1\n1 0 zero 0 0 0 0 1 0 1\n", "line 2: expected" },
+		{ "0 0 0 0 0 0 0 1 0 1,\n", "line 1: expected" },
+		{ "1 0 0 0 0 0 0 1 0 1\n# comment\n0.5 0 0 0 0 0 0 1 0 1\n", "line 3: time goes backwards" },
+		{ "0 0 0 0 0 0 0 0 0 1\n", "line 1: zero light direction" },
+	};
+	for (const auto& Case : Malformed)
+	{
+		Error.clear();
+		const bool bParsed = Path.Parse(Case.Text, Error);
+		if (bParsed || Error.compare(0, strlen(Case.Error), Case.Error) != 0)
+			std::printf("  \"%s\": %s\n", Case.Text, Error.c_str());
+		CHECK(!bParsed);
+		CHECK(Error.compare(0, strlen(Case.Error), Case.Error) == 0);
+		CHECK(Path.GetKeys().empty());
+	}
+
+	// loading names the file.
+	const std::string Missing = TempPath("corona_benchmark_missing.path");
+	std::remove(Missing.c_str());
+	CHECK(!Path.LoadFile(Missing, Error));
+	CHECK(Error.find(Missing) != std::string::npos);
+}
+
+TEST_CASE(CameraPathRoundTrip)
+{
+	CameraPath Path;
+	Path.AddKey(MakeKey(0.f, glm::vec3(1.f, 2.f, 3.f), 0.1f, glm::vec3(0.f, 1.f, 0.2f), 1.f));
+	Path.AddKey(MakeKey(0.75f, glm::vec3(-4.f, 2.5f, 3.f), 0.3f, glm::vec3(1.f, 1.f, 0.f), 3.5f));
+	// earlier than the last key, dropped.
+	Path.AddKey(MakeKey(0.5f, glm::vec3(0.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Path.AddKey(MakeKey(2.f / 3.f + 1.f, glm::vec3(1e-3f, 12345.678f, -0.1f), -2.f, glm::vec3(0.3f, -1.f, 0.f), 0.f));
+	CHECK_EQ(Path.GetKeys().size(), 3);
+
+	const std::string File = TempPath("corona_benchmark_roundtrip.path");
+	std::string Error;
+	CHECK(Path.WriteFile(File, Error));
+
+	CameraPath Loaded;
+	CHECK(Loaded.LoadFile(File, Error));
+	std::remove(File.c_str());
+
+	// 9 digits bring every float back exactly.
+	CHECK_EQ(Loaded.GetKeys().size(), Path.GetKeys().size());
+	for (size_t i = 0; i < std::min(Loaded.GetKeys().size(), Path.GetKeys().size()); i++)
+	{
+		const CameraPathKey& A = Path.GetKeys()[i];
+		const CameraPathKey& B = Loaded.GetKeys()[i];
+		CHECK(A.Time == B.Time && A.Position == B.Position && A.Yaw == B.Yaw && A.Pitch == B.Pitch && A.LightIntensity == B.LightIntensity);
+		CHECK(MaxDifference(A.LightDir, B.LightDir) < 1e-6f);
+	}
+}
+
+TEST_CASE(CameraPathSample)
+{
+	CameraPath Path;
+	CHECK(Path.Sample(1.f).Position == glm::vec3(0.f));
+
+	// evenly spaced keys on a line, the spline is the line between the outer keys.
+	for (int i = 0; i < 5; i++)
+		Path.AddKey(MakeKey(float(i), glm::vec3(2.f * i, 1.f, -float(i)), 0.5f * i, glm::vec3(1.f - 0.25f * i, 1.f, 0.f), 1.f + i));
+
+	// at every key, exactly the key.
+	for (const CameraPathKey& Key : Path.GetKeys())
+	{
+		const CameraPathKey Sample = Path.Sample(Key.Time);
+		CHECK(Sample.Position == Key.Position);
+		CHECK_EQ(Sample.Yaw, Key.Yaw);
+		CHECK_EQ(Sample.Pitch, Key.Pitch);
+		CHECK_EQ(Sample.LightIntensity, Key.LightIntensity);
+		CHECK(MaxDifference(Sample.LightDir, Key.LightDir) < 1e-6f);
+	}
+
+	// clamped outside of the path.
+	CHECK(Path.Sample(-3.f).Position == Path.GetKeys().front().Position);
+	CHECK(Path.Sample(99.f).Position == Path.GetKeys().back().Position);
+	CHECK_EQ(Path.Sample(99.f).Yaw, 2.f);
+
+	// between keys of the inner segments.
+	for (float Time : { 1.25f, 1.5f, 2.9f })
+	{
+		const CameraPathKey Sample = Path.Sample(Time);
+		CHECK_EQ(Sample.Time, Time);
+		CHECK(MaxDifference(Sample.Position, glm::vec3(2.f * Time, 1.f, -Time)) < 1e-5f);
+		CHECK_NEAR(Sample.Yaw, 0.5f * Time, 1e-6f);
+		CHECK_NEAR(Sample.Pitch, -0.25f * Time, 1e-6f);
+		CHECK_NEAR(Sample.LightIntensity, 1.f + Time, 1e-5f);
+		CHECK_NEAR(glm::length(Sample.LightDir), 1.f, 1e-6f);
+	}
+
+	// the light direction is the normalized lerp of its keys.
+	const glm::vec3 HalfLight = glm::normalize(glm::mix(Path.GetKeys()[1].LightDir, Path.GetKeys()[2].LightDir, 0.5f));
+	CHECK(MaxDifference(Path.Sample(1.5f).LightDir, HalfLight) < 1e-6f);
+
+	// a curve through a corner passes the keys and stays close to them in between.
+	CameraPath Corner;
+	Corner.AddKey(MakeKey(0.f, glm::vec3(0.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Corner.AddKey(MakeKey(1.f, glm::vec3(10.f, 0.f, 0.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Corner.AddKey(MakeKey(2.f, glm::vec3(10.f, 0.f, 10.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	const glm::vec3 Mid = Corner.Sample(1.5f).Position;
+	CHECK(Mid.x > 10.f && Mid.x < 12.f);
+	CHECK_NEAR(Mid.z, 5.f, 1e-5f);
+	CHECK_NEAR(Corner.Sample(0.5f).Position.x, 5.f, 1e-5f);
+	CHECK(Corner.Sample(0.5f).Position.z < 0.f);
+
+	// opposite light directions meet in the middle, it falls back to the later key.
+	CameraPath Flip;
+	Flip.AddKey(MakeKey(0.f, glm::vec3(0.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Flip.AddKey(MakeKey(1.f, glm::vec3(0.f), 0.f, glm::vec3(0.f, -1.f, 0.f), 1.f));
+	CHECK(Flip.Sample(0.5f).LightDir == glm::vec3(0.f, -1.f, 0.f));
+
+	// a zero length segment jumps to its second key.
+	CameraPath Cut;
+	Cut.AddKey(MakeKey(0.f, glm::vec3(0.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Cut.AddKey(MakeKey(1.f, glm::vec3(1.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Cut.AddKey(MakeKey(1.f, glm::vec3(5.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	Cut.AddKey(MakeKey(2.f, glm::vec3(6.f), 0.f, glm::vec3(0.f, 1.f, 0.f), 1.f));
+	CHECK(Cut.Sample(1.f).Position == glm::vec3(5.f));
+}
+
+TEST_CASE(BenchmarkArgs)
+{
+	BenchmarkSettings Settings;
+	std::string Error;
+	CHECK(ParseBenchmarkArgs({ "Corona.exe", "-fullscreen", "-benchmark", "Sponza.path", "-benchmark_frames", "500",
+		"-benchmark_warmup", "0", "-benchmark_dt", "0.02", "-benchmark_out", "Results/Run1" }, Settings, Error));
+	CHECK(Settings.bEnabled);
+	CHECK(Settings.PathFile == "Sponza.path");
+	CHECK_EQ(Settings.NumFrames, 500);
+	CHECK_EQ(Settings.NumWarmupFrames, 0);
+	CHECK_EQ(Settings.TimeStep, 0.02);
+	CHECK(Settings.OutputPrefix == "Results/Run1");
+
+	// nothing for the benchmark, the defaults stay.
+	BenchmarkSettings Defaults;
+	CHECK(ParseBenchmarkArgs({ "Corona.exe", "-vsync", "1" }, Defaults, Error));
+	CHECK(!Defaults.bEnabled);
+	CHECK_EQ(Defaults.NumFrames, 1000);
+	CHECK_EQ(Defaults.NumWarmupFrames, 60);
+
+	const struct { std::vector<std::string> Args; const char* Error; } Malformed[] = {
+		{ { "-benchmark" }, "-benchmark needs a value" },
+		{ { "-benchmark", "a.path", "-benchmark_frames" }, "-benchmark_frames needs a value" },
+		{ { "-benchmark_frames", "0" }, "bad value 0" },
+		{ { "-benchmark_frames", "-5" }, "bad value -5" },
+		{ { "-benchmark_frames", "12x" }, "bad value 12x" },
+		{ { "-benchmark_frames", "" }, "bad value" },
+		{ { "-benchmark_frames", "4294967297" }, "bad value 4294967297" },
+		{ { "-benchmark_warmup", "many" }, "bad value many" },
+		{ { "-benchmark_dt", "0" }, "bad value 0" },
+		{ { "-benchmark_dt", "-0.01" }, "bad value -0.01" },
+		{ { "-benchmark_dt", "1/60" }, "bad value 1/60" },
+		{ { "-benchmark_dt", "inf" }, "bad value inf" },
+		{ { "-benchmark_dt", "nan" }, "bad value nan" },
+		{ { "-benchmark_fps", "60" }, "unknown option -benchmark_fps" },
+	};
+	for (const auto& Case : Malformed)
+	{
+		BenchmarkSettings Out;
+		Error.clear();
+		const bool bParsed = ParseBenchmarkArgs(Case.Args, Out, Error);
+		if (bParsed || Error.compare(0, strlen(Case.Error), Case.Error) != 0)
+			std::printf("  %s: %s\n", Case.Args.back().c_str(), Error.c_str());
+		CHECK(!bParsed);
+		CHECK(Error.compare(0, strlen(Case.Error), Case.Error) == 0);
+	}
+}
+
+TEST_CASE(RecorderColumns)
+{
+	BenchmarkRecorder Recorder;
+	for (uint32_t i = 0; i < 4; i++)
+	{
+		BenchmarkFrame Frame;
+		Frame.Frame = 10 + i;
+		Frame.FrameMs = 16.0 + i;
+		Frame.CPUMs = 5.0 + i;
+		Frame.GPUMs = 12.0 + i;
+		Frame.LatencyMs = 30.0 + 2.0 * i;
+		Frame.ProcessBytes = uint64_t(512) << 20;
+		Frame.GPUBytes = uint64_t(3) << 19;
+		Frame.StreamingBytes = 0;
+		Frame.Zones.push_back({ "GBuffer", true, 2.0 });
+		// the same name on the cpu is another column.
+		Frame.Zones.push_back({ "GBuffer", false, 0.5 });
+		// only on odd frames, entered twice.
+		if (i & 1)
+		{
+			Frame.Zones.push_back({ "Upload \"big\"", false, 1.0 });
+			Frame.Zones.push_back({ "Upload \"big\"", false, 0.25 });
+		}
+		Recorder.AddFrame(Frame);
+	}
+	CHECK_EQ(Recorder.GetNumFrames(), 4);
+
+	std::ostringstream CSV;
+	Recorder.WriteCSV(CSV);
+	const std::vector<std::string> Lines = SplitLines(CSV.str());
+	CHECK_EQ(Lines.size(), 5);
+	if (Lines.size() == 5)
+	{
+		CHECK(Lines[0] == "frame,frame_ms,cpu_ms,gpu_ms,latency_ms,process_mb,gpu_mb,streaming_mb,gpu/GBuffer,cpu/GBuffer,cpu/Upload \"big\"");
+		CHECK(Lines[1] == "10,16.000,5.000,12.000,30.000,512.000,1.500,0.000,2.000,0.500,");
+		CHECK(Lines[2] == "11,17.000,6.000,13.000,32.000,512.000,1.500,0.000,2.000,0.500,1.250");
+		for (const std::string& Line : Lines)
+			CHECK_EQ(SplitFields(Line).size(), 11);
+	}
+
+	const std::vector<BenchmarkRecorder::Stat> Summary = Recorder.GetSummary();
+	CHECK_EQ(Summary.size(), 7);
+	if (Summary.size() == 7)
+	{
+		CHECK(Summary[3].Name == "latency");
+		CHECK_EQ(Summary[3].NumSamples, 4);
+		CHECK_EQ(Summary[3].MinMs, 30.0);
+		CHECK_EQ(Summary[3].MaxMs, 36.0);
+		CHECK_EQ(Summary[3].AvgMs, 33.0);
+		CHECK(Summary[6].Name == "cpu/Upload \"big\"");
+		CHECK_EQ(Summary[6].NumSamples, 2);
+		CHECK_EQ(Summary[6].AvgMs, 1.25);
+	}
+
+	std::ostringstream JSON;
+	Recorder.WriteJSON(JSON);
+	const std::string Text = JSON.str();
+	CHECK(Text.find("{\"name\":\"latency\",\"samples\":4,\"avg_ms\":33.000,\"min_ms\":30.000,") != std::string::npos);
+	CHECK(Text.find("{\"frame\":11,\"frame_ms\":17.000,\"cpu_ms\":6.000,\"gpu_ms\":13.000,\"latency_ms\":32.000,\"process_mb\":512.000,"
+		"\"gpu_mb\":1.500,\"streaming_mb\":0.000,\"zones\":{\"gpu/GBuffer\":2.000,\"cpu/GBuffer\":0.500,\"cpu/Upload \\\"big\\\"\":1.250}}") != std::string::npos);
+	// missing zones are left out of the frame.
+	CHECK(Text.find("\"zones\":{\"gpu/GBuffer\":2.000,\"cpu/GBuffer\":0.500}}") != std::string::npos);
+	CHECK(Text.compare(0, 13, "{\n\"summary\":[") == 0);
+	CHECK(Text.size() >= 5 && Text.compare(Text.size() - 5, 5, "\n]\n}\n") == 0);
+
+	// the files are the two streams.
+	const std::string Prefix = TempPath("corona_benchmark_recorder");
+	std::string Error;
+	CHECK(Recorder.WriteFiles(Prefix, Error));
+	for (const char* Extension : { ".csv", ".json" })
+	{
+		std::ifstream File(Prefix + Extension, std::ios::binary);
+		std::stringstream Contents;
+		Contents << File.rdbuf();
+		CHECK(Contents.str() == (Extension[1] == 'c' ? CSV.str() : Text));
+		File.close();
+		std::remove((Prefix + Extension).c_str());
+	}
+
+	Recorder.Clear();
+	std::ostringstream Empty;
+	Recorder.WriteCSV(Empty);
+	CHECK(Empty.str() == "frame,frame_ms,cpu_ms,gpu_ms,latency_ms,process_mb,gpu_mb,streaming_mb\n");
+}
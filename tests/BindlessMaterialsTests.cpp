@@ -0,0 +1,189 @@
+#include "TestFramework.h"
+#include "BindlessMaterials.h"
+
+#include <map>
+#include <random>
+
+// the slot allocator, texture registry and material table of the bindless gbuffer. textures are addresses
+// of the ints below, the registry never looks at them.
+namespace
+{
+	int Tex[8];
+}
+
+TEST_CASE(SlotsAreReusedAfterTheFramesInFlight)
+{
+	BindlessSlotAllocator Slots;
+	Slots.Init(4, 3);
+	for (uint32_t i = 0; i < 4; i++)
+		CHECK_EQ(Slots.Allocate(), i);
+	CHECK_EQ(Slots.Allocate(), kInvalidBindlessIndex);
+
+	// released slots wait for 3 frames, the frames in flight may still read them.
+	Slots.Release(2);
+	Slots.Release(0);
+	CHECK_EQ(Slots.GetNumAllocated(), 2);
+	CHECK_EQ(Slots.GetNumRetiring(), 2);
+	CHECK_EQ(Slots.Allocate(), kInvalidBindlessIndex);
+
+	std::vector<uint32_t> Recycled;
+	Slots.NewFrame(&Recycled);
+	Slots.NewFrame(&Recycled);
+	CHECK(Recycled.empty());
+	CHECK_EQ(Slots.Allocate(), kInvalidBindlessIndex);
+	Slots.NewFrame(&Recycled);
+	CHECK_EQ(Recycled.size(), 2);
+	CHECK_EQ(Slots.GetNumRetiring(), 0);
+
+	// lowest first, whatever order they were released in.
+	CHECK_EQ(Slots.Allocate(), 0);
+	CHECK_EQ(Slots.Allocate(), 2);
+	CHECK_EQ(Slots.Allocate(), kInvalidBindlessIndex);
+	CHECK_EQ(Slots.GetNumAllocated(), 4);
+	Slots.NewFrame();
+}
+
+TEST_CASE(TexturesShareASlot)
+{
+	BindlessTextureRegistry Textures;
+	Textures.Init(8, 2);
+	CHECK_EQ(Textures.Register(&Tex[0]), 0);
+	CHECK_EQ(Textures.Register(&Tex[1]), 1);
+	CHECK_EQ(Textures.Register(&Tex[0]), 0);
+	CHECK_EQ(Textures.Register(nullptr), kInvalidBindlessIndex);
+	CHECK_EQ(Textures.GetNumTextures(), 2);
+
+	std::vector<uint32_t> Dirty;
+	Textures.TakeDirtySlots(Dirty);
+	CHECK_EQ(Dirty.size(), 2);
+	Textures.TakeDirtySlots(Dirty);
+	CHECK(Dirty.empty());
+
+	// the texture stays in its slot until the last reference is gone and the frames in flight are done.
+	Textures.Release(0);
+	CHECK(Textures.GetTexture(0) == &Tex[0]);
+	CHECK_EQ(Textures.GetNumTextures(), 2);
+	Textures.Release(0);
+	CHECK(Textures.GetTexture(0) == &Tex[0]);
+	CHECK_EQ(Textures.GetNumTextures(), 1);
+	CHECK_EQ(Textures.Register(&Tex[2]), 2);
+	CHECK_EQ(Textures.Register(&Tex[0]), 3);
+
+	Textures.NewFrame();
+	Textures.TakeDirtySlots(Dirty);
+	CHECK_EQ(Dirty.size(), 2);
+
+	// recycled, the table entry is cleared and the slot is handed out again.
+	Textures.NewFrame();
+	Textures.TakeDirtySlots(Dirty);
+	CHECK_EQ(Dirty.size(), 1);
+	CHECK(!Dirty.empty() && Dirty[0] == 0);
+	CHECK(Textures.GetTexture(0) == nullptr);
+	CHECK_EQ(Textures.Register(&Tex[3]), 0);
+	CHECK(Textures.GetTexture(kMaxBindlessTextures) == nullptr);
+}
+
+TEST_CASE(MaterialTableAddRemove)
+{
+	BindlessMaterialTable Materials;
+	Materials.Init(3, 5, 2);
+	void* const First[4] = { &Tex[0], &Tex[1], &Tex[2], &Tex[3] };
+	void* const Second[4] = { &Tex[0], &Tex[4], &Tex[2], &Tex[3] };
+
+	const uint64_t Version = Materials.GetVersion();
+	CHECK_EQ(Materials.AddMaterial(First), 0);
+	CHECK(Materials.GetVersion() != Version);
+	CHECK_EQ(Materials.AddMaterial(Second), 1);
+	CHECK_EQ(Materials.GetTextures().GetNumTextures(), 5);
+
+	const std::vector<BindlessMaterialData>& Data = Materials.GetMaterialData();
+	CHECK_EQ(Data.size(), 2);
+	CHECK_EQ(Data[1].Albedo, 0);
+	CHECK_EQ(Data[1].Normal, 4);
+	CHECK_EQ(Data[1].Roughness, 2);
+	CHECK_EQ(Data[1].Metallic, 3);
+
+	// the texture table is full, nothing of the material stays registered.
+	void* const Third[4] = { &Tex[5], &Tex[0], &Tex[1], &Tex[2] };
+	const uint64_t FullVersion = Materials.GetVersion();
+	CHECK_EQ(Materials.AddMaterial(Third), kInvalidBindlessIndex);
+	CHECK_EQ(Materials.GetNumMaterials(), 2);
+	CHECK_EQ(Materials.GetTextures().GetNumTextures(), 5);
+	CHECK_EQ(Materials.GetVersion(), FullVersion);
+
+	// removing releases the textures only the material used.
+	Materials.RemoveMaterial(0);
+	CHECK_EQ(Materials.GetTextures().GetNumTextures(), 4);
+	CHECK_EQ(Materials.GetMaterialData()[0].Albedo, kInvalidBindlessIndex);
+	Materials.RemoveMaterial(1);
+	CHECK_EQ(Materials.GetTextures().GetNumTextures(), 0);
+	CHECK(Materials.GetVersion() != FullVersion);
+
+	Materials.NewFrame();
+	Materials.NewFrame();
+	CHECK_EQ(Materials.AddMaterial(Third), 0);
+	CHECK_EQ(Materials.GetMaterialData()[0].Albedo, 0);
+	CHECK(Materials.GetTextures().GetTexture(Materials.GetMaterialData()[0].Metallic) == &Tex[2]);
+}
+
+TEST_CASE(MaterialChurn)
+{
+	// random adds and removes over many frames, what streaming materials in and out does.
+	const uint32_t NumFramesInFlight = 3;
+	BindlessMaterialTable Materials;
+	Materials.Init(kMaxBindlessMaterials, kMaxBindlessTextures, NumFramesInFlight);
+
+	std::vector<int> Textures(400);
+	std::vector<uint32_t> Live;
+	std::map<uint32_t, int> RemovedFrame;
+	std::mt19937 Rng(1);
+	int Frame = 0;
+	int NumFailures = 0;
+	for (int i = 0; i < 100000; i++)
+	{
+		if (Live.size() < 300 && (Rng() % 3 || Live.empty()))
+		{
+			void* Material[4];
+			for (void*& Texture : Material)
+				Texture = &Textures[Rng() % Textures.size()];
+			const uint32_t Index = Materials.AddMaterial(Material);
+			if (Index == kInvalidBindlessIndex)
+			{
+				NumFailures++;
+				continue;
+			}
+
+			// a removed material's index comes back only after the frames that may read it are done.
+			if (RemovedFrame.count(Index) && Frame - RemovedFrame[Index] < int(NumFramesInFlight))
+				NumFailures++;
+
+			const BindlessMaterialData& Data = Materials.GetMaterialData()[Index];
+			const uint32_t Slots[4] = { Data.Albedo, Data.Normal, Data.Roughness, Data.Metallic };
+			for (int k = 0; k < 4; k++)
+				if (Materials.GetTextures().GetTexture(Slots[k]) != Material[k])
+					NumFailures++;
+			Live.push_back(Index);
+		}
+		else
+		{
+			const size_t k = Rng() % Live.size();
+			Materials.RemoveMaterial(Live[k]);
+			RemovedFrame[Live[k]] = Frame;
+			Live[k] = Live.back();
+			Live.pop_back();
+		}
+
+		if (i % 50 == 0)
+		{
+			Materials.NewFrame();
+			Frame++;
+		}
+		if (Materials.GetNumMaterials() != Live.size())
+			NumFailures++;
+	}
+	CHECK_EQ(NumFailures, 0);
+
+	// lowest first keeps the buffer close to the live count.
+	CHECK(Materials.GetMaterialData().size() <= 400);
+	CHECK(Materials.GetTextures().GetNumTextures() <= Textures.size());
+}
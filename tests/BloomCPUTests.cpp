@@ -0,0 +1,200 @@
+#include "TestFramework.h"
+#include "BloomCPU.h"
+
+#include "glm/gtc/packing.hpp"
+
+#include <algorithm>
+#include <random>
+
+// the cpu reference of the bloom chain: mip counts around the groupshared and the 13 mip limits of the
+// single pass downsample, odd and non power of two sizes, and a constant image through both passes.
+namespace
+{
+	std::vector<DenoiserImage> MakeChain(uint32_t Width, uint32_t Height, bool bHalf, uint32_t Seed)
+	{
+		std::vector<DenoiserImage> Mips(1);
+		Mips[0].Init(Width, Height, bHalf);
+		std::mt19937 Rng(Seed);
+		std::uniform_real_distribution<float> Unit(0.f, 4.f);
+		for (uint32_t y = 0; y < Height; y++)
+			for (uint32_t x = 0; x < Width; x++)
+				Mips[0].Store(x, y, glm::vec4(Unit(Rng), Unit(Rng), Unit(Rng), 1.f));
+		return Mips;
+	}
+
+	glm::vec4 Box(const DenoiserImage& Upper, uint32_t x, uint32_t y)
+	{
+		return (Upper.Load(x * 2, y * 2) + Upper.Load(x * 2 + 1, y * 2) + Upper.Load(x * 2, y * 2 + 1) + Upper.Load(x * 2 + 1, y * 2 + 1)) * 0.25f;
+	}
+
+	float MaxDifference(const glm::vec4& A, const glm::vec4& B)
+	{
+		const glm::vec4 D = glm::abs(A - B);
+		return std::max(std::max(D.x, D.y), std::max(D.z, D.w));
+	}
+}
+
+TEST_CASE(BloomMipCounts)
+{
+	const struct { uint32_t Width, Height, MaxMips, Expected; } Cases[] = {
+		// down to a 1 texel smaller side.
+		{ 1, 1, 16, 1 }, { 0, 0, 16, 1 }, { 2, 2, 16, 2 }, { 3, 5, 16, 2 }, { 1920, 1, 16, 1 },
+		// mip 6 is the last one a group builds in groupshared memory, mip 7 the first of the last group.
+		{ 63, 63, 16, 6 }, { 64, 64, 16, 7 }, { 127, 500, 16, 7 }, { 128, 128, 16, 8 },
+		// the bloom buffers of 1080p and 4K with Corona::BloomMaxMips.
+		{ 640, 384, 8, 8 }, { 1280, 768, 8, 8 }, { 100, 100, 8, 7 },
+		// mip 12 is the last of the 13 the shader binds.
+		{ 2048, 2048, 16, 12 }, { 4095, 4095, 16, 12 }, { 4096, 4096, 16, 13 }, { 8192, 8192, 16, 13 }, { 65535, 65535, 99, 13 },
+		{ 4096, 4096, 12, 12 },
+	};
+	for (const auto& Case : Cases)
+	{
+		const uint32_t NumMips = GetBloomMipCount(Case.Width, Case.Height, Case.MaxMips);
+		if (NumMips != Case.Expected)
+			std::printf("  %ux%u max %u: %u mips\n", Case.Width, Case.Height, Case.MaxMips, NumMips);
+		CHECK_EQ(NumMips, Case.Expected);
+		// the smallest mip still has a texel on both sides.
+		CHECK(std::min(Case.Width, Case.Height) >> (NumMips - 1) >= 1 || Case.Width == 0);
+	}
+}
+
+TEST_CASE(DownsampleOddSizes)
+{
+	// full precision, every mip is the box average of its upper mip, the last row and column of an odd
+	// mip are dropped.
+	for (const glm::uvec2 Size : { glm::uvec2(37, 23), glm::uvec2(129, 65), glm::uvec2(300, 171), glm::uvec2(100, 7), glm::uvec2(1, 9) })
+	{
+		std::vector<DenoiserImage> Mips = MakeChain(Size.x, Size.y, false, Size.x);
+		const uint32_t NumMips = GetBloomMipCount(Size.x, Size.y, kSPDMaxMips);
+		SinglePassDownsampleCPU(Mips, 99);
+		CHECK_EQ(Mips.size(), NumMips);
+
+		float MaxError = 0.f;
+		for (uint32_t Mip = 1; Mip < Mips.size(); Mip++)
+		{
+			CHECK_EQ(Mips[Mip].Width, Size.x >> Mip);
+			CHECK_EQ(Mips[Mip].Height, Size.y >> Mip);
+			for (uint32_t y = 0; y < Mips[Mip].Height; y++)
+				for (uint32_t x = 0; x < Mips[Mip].Width; x++)
+					MaxError = std::max(MaxError, MaxDifference(Mips[Mip].Load(x, y), Box(Mips[Mip - 1], x, y)));
+		}
+		CHECK(MaxError == 0.f);
+
+		// the last texel of mip 2 of 37x23 averages the 4x4 block ending at (35, 19), column 36 and rows
+		// 20..22 never count.
+		if (Size.x == 37)
+		{
+			glm::vec4 Sum(0.f);
+			for (uint32_t y = 16; y < 20; y++)
+				for (uint32_t x = 32; x < 36; x++)
+					Sum += Mips[0].Load(x, y);
+			CHECK(MaxDifference(Mips[2].Load(8, 4), Sum / 16.f) < 1e-5f);
+		}
+	}
+
+	// fp16 stores: mips 1..6 come from the full precision values of groupshared memory, mip 7 on from
+	// the rounded mip 6. bright enough that fp16 keeps no fraction and the two differ.
+	std::vector<DenoiserImage> Mips = MakeChain(300, 171, true, 7);
+	for (glm::vec4& Texel : Mips[0].Texels)
+		Texel = glm::unpackHalf4x16(glm::packHalf4x16(Texel * 500.f));
+	SinglePassDownsampleCPU(Mips, kSPDMaxMips);
+	CHECK_EQ(Mips.size(), 8);
+
+	std::vector<DenoiserImage> Full(1);
+	Full[0] = Mips[0];
+	Full[0].bHalf = false;
+	SinglePassDownsampleCPU(Full, kSPDMaxMips);
+
+	int NumMismatches = 0;
+	for (uint32_t Mip = 1; Mip < 7; Mip++)
+		for (size_t i = 0; i < Mips[Mip].Texels.size(); i++)
+			NumMismatches += Mips[Mip].Texels[i] != glm::unpackHalf4x16(glm::packHalf4x16(Full[Mip].Texels[i]));
+	for (uint32_t y = 0; y < Mips[7].Height; y++)
+		for (uint32_t x = 0; x < Mips[7].Width; x++)
+			NumMismatches += Mips[7].Load(x, y) != glm::unpackHalf4x16(glm::packHalf4x16(Box(Mips[6], x, y)));
+	CHECK_EQ(NumMismatches, 0);
+
+	// fewer mips on request.
+	std::vector<DenoiserImage> Three = MakeChain(300, 171, false, 7);
+	SinglePassDownsampleCPU(Three, 3);
+	CHECK_EQ(Three.size(), 3);
+}
+
+TEST_CASE(ConstantImageStaysConstant)
+{
+	const glm::vec4 Constant(0.75f, 1.5f, 3.25f, 1.f);
+	for (const glm::uvec2 Size : { glm::uvec2(640, 384), glm::uvec2(333, 129), glm::uvec2(100, 7), glm::uvec2(1, 1) })
+	{
+		for (bool bHalf : { false, true })
+		{
+			std::vector<DenoiserImage> Mips(1);
+			Mips[0].Init(Size.x, Size.y, bHalf);
+			for (glm::vec4& Texel : Mips[0].Texels)
+				Texel = Constant;
+
+			SinglePassDownsampleCPU(Mips, kSPDMaxMips);
+			int NumChanged = 0;
+			for (const DenoiserImage& Mip : Mips)
+				for (const glm::vec4& Texel : Mip.Texels)
+					NumChanged += Texel != Constant;
+			CHECK_EQ(NumChanged, 0);
+
+			// the tent weights sum to one and the blend is a lerp, at the clamped edges as well.
+			BloomUpsampleCPU(Mips, 0.7f);
+			float MaxError = 0.f;
+			for (const DenoiserImage& Mip : Mips)
+				for (const glm::vec4& Texel : Mip.Texels)
+					MaxError = std::max(MaxError, MaxDifference(Texel, Constant));
+			CHECK(MaxError <= 1e-6f);
+			CHECK_EQ(Mips[0].Width, Size.x);
+			CHECK_EQ(Mips[0].Height, Size.y);
+		}
+	}
+}
+
+TEST_CASE(UpsampleOddSizes)
+{
+	for (const glm::uvec2 Size : { glm::uvec2(37, 23), glm::uvec2(300, 171), glm::uvec2(100, 7) })
+	{
+		std::vector<DenoiserImage> Mips = MakeChain(Size.x, Size.y, false, 3);
+		SinglePassDownsampleCPU(Mips, kSPDMaxMips);
+		const std::vector<DenoiserImage> Source = Mips;
+
+		// a scatter of 0 keeps every mip.
+		BloomUpsampleCPU(Mips, 0.f);
+		for (size_t Mip = 0; Mip < Mips.size(); Mip++)
+			CHECK(Mips[Mip].Texels == Source[Mip].Texels);
+
+		// every texel is a convex blend of the chain, inside its range.
+		Mips = Source;
+		BloomUpsampleCPU(Mips, 0.7f);
+		float Min = 1e30f, Max = -1e30f;
+		for (const glm::vec4& Texel : Source[0].Texels)
+		{
+			Min = std::min(Min, std::min(Texel.x, std::min(Texel.y, Texel.z)));
+			Max = std::max(Max, std::max(Texel.x, std::max(Texel.y, Texel.z)));
+		}
+		int NumOutside = 0;
+		for (const glm::vec4& Texel : Mips[0].Texels)
+			for (int c = 0; c < 3; c++)
+				NumOutside += Texel[c] < Min - 1e-5f || Texel[c] > Max + 1e-5f;
+		CHECK_EQ(NumOutside, 0);
+
+		// the smallest mip is the source of the chain and isn't blended.
+		CHECK(Mips.back().Texels == Source.back().Texels);
+
+		// blurred: the spread of mip 0 shrinks.
+		auto Variance = [](const DenoiserImage& Img)
+		{
+			double Sum = 0.0, SumSq = 0.0;
+			for (const glm::vec4& Texel : Img.Texels)
+			{
+				Sum += Texel.x;
+				SumSq += double(Texel.x) * Texel.x;
+			}
+			const double Mean = Sum / Img.Texels.size();
+			return SumSq / Img.Texels.size() - Mean * Mean;
+		};
+		CHECK(Variance(Mips[0]) < Variance(Source[0]));
+	}
+}
@@ -0,0 +1,46 @@
+#include "TestFramework.h"
+#include "BlueNoise.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+// load time of a 64^3 RGBA set, the size of the shipped HDR_RGBA.raw, into both formats.
+BENCHMARK(BlueNoiseLoad64)
+{
+	const uint32_t Dim = 64;
+	const uint32_t NumTexels = Dim * Dim * Dim;
+
+	std::vector<uint32_t> Raw = { 1, 4, 3, Dim, Dim, Dim };
+	std::vector<uint32_t> Channel(NumTexels);
+	std::iota(Channel.begin(), Channel.end(), 0u);
+	std::mt19937 Rng(1);
+	std::vector<uint32_t> Data(size_t(NumTexels) * 4);
+	for (uint32_t c = 0; c < 4; c++)
+	{
+		std::shuffle(Channel.begin(), Channel.end(), Rng);
+		for (uint32_t i = 0; i < NumTexels; i++)
+			Data[i * 4 + c] = Channel[i];
+	}
+	Raw.insert(Raw.end(), Data.begin(), Data.end());
+
+	const std::string Path = (std::filesystem::temp_directory_path() / "corona_bluenoise_bench.raw").string();
+	{
+		std::ofstream File(Path, std::ios::binary);
+		File.write(reinterpret_cast<const char*>(Raw.data()), Raw.size() * sizeof(uint32_t));
+	}
+
+	for (BlueNoiseFormat Format : { BlueNoiseFormat::RGBA8_UNORM, BlueNoiseFormat::RGBA16_UNORM })
+	{
+		BlueNoiseVolume Volume;
+		std::string Error;
+		const double Ms = MeasureMs([&]() { LoadBlueNoiseRaw(Path, Format, Volume, Error); });
+		std::printf("  %s: %.2f ms, %zu bytes, max quantization error %g\n", Format == BlueNoiseFormat::RGBA8_UNORM ? "RGBA8" : "RGBA16",
+			Ms, Volume.Data.size(), Volume.MaxQuantizationError);
+	}
+
+	std::remove(Path.c_str());
+}
@@ -0,0 +1,204 @@
+#include "TestFramework.h"
+#include "BlueNoise.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <random>
+
+// LoadBlueNoiseRaw on files written in the *.raw layout of assets/bluenoise/RAWFileFormat.txt, every
+// channel a permutation of the texel indices like the released sets.
+namespace
+{
+	std::string TempPath(const char* Name)
+	{
+		return (std::filesystem::temp_directory_path() / Name).string();
+	}
+
+	std::vector<uint32_t> MakeRaw(const std::vector<uint32_t>& Shape, uint32_t NumChannels, uint32_t Seed = 1)
+	{
+		uint32_t NumTexels = 1;
+		for (uint32_t Dim : Shape)
+			NumTexels *= Dim;
+
+		std::vector<uint32_t> Raw = { 1, NumChannels, uint32_t(Shape.size()) };
+		Raw.insert(Raw.end(), Shape.begin(), Shape.end());
+
+		std::mt19937 Rng(Seed);
+		std::vector<std::vector<uint32_t>> Channels(NumChannels, std::vector<uint32_t>(NumTexels));
+		for (auto& Channel : Channels)
+		{
+			std::iota(Channel.begin(), Channel.end(), 0u);
+			std::shuffle(Channel.begin(), Channel.end(), Rng);
+		}
+
+		for (uint32_t i = 0; i < NumTexels; i++)
+			for (uint32_t c = 0; c < NumChannels; c++)
+				Raw.push_back(Channels[c][i]);
+		return Raw;
+	}
+
+	std::string WriteRaw(const char* Name, const std::vector<uint32_t>& Raw, size_t NumWords = ~size_t(0))
+	{
+		const std::string Path = TempPath(Name);
+		std::ofstream File(Path, std::ios::binary);
+		File.write(reinterpret_cast<const char*>(Raw.data()), std::min(NumWords, Raw.size()) * sizeof(uint32_t));
+		return Path;
+	}
+
+	// largest |texel - exact| over the volume, in normalized units.
+	double MeasureError(const BlueNoiseVolume& Volume, const std::vector<uint32_t>& Raw, uint32_t NumDims)
+	{
+		const uint32_t NumTexels = Volume.Width * Volume.Height * Volume.Depth;
+		const uint32_t NumChannels = Raw[1];
+		const uint32_t* Data = Raw.data() + 3 + NumDims;
+		const double UnormMax = Volume.Format == BlueNoiseFormat::RGBA16_UNORM ? 65535.0 : 255.0;
+
+		double MaxError = 0;
+		for (uint32_t i = 0; i < NumTexels; i++)
+		{
+			for (uint32_t c = 0; c < NumChannels; c++)
+			{
+				const double Texel = Volume.Format == BlueNoiseFormat::RGBA16_UNORM
+					? reinterpret_cast<const uint16_t*>(Volume.Data.data())[i * 4 + c] / UnormMax
+					: Volume.Data[i * 4 + c] / UnormMax;
+				MaxError = std::max(MaxError, std::fabs(Texel - Data[i * NumChannels + c] / double(NumTexels - 1)));
+			}
+		}
+		return MaxError;
+	}
+}
+
+TEST_CASE(QuantizesToHalfAStep)
+{
+	const std::vector<uint32_t> Raw = MakeRaw({ 16, 16, 16 }, 4);
+	const std::string Path = WriteRaw("corona_bluenoise_16.raw", Raw);
+
+	for (BlueNoiseFormat Format : { BlueNoiseFormat::RGBA8_UNORM, BlueNoiseFormat::RGBA16_UNORM })
+	{
+		BlueNoiseVolume Volume;
+		std::string Error;
+		CHECK(LoadBlueNoiseRaw(Path, Format, Volume, Error));
+		CHECK_EQ(Volume.Width, 16u);
+		CHECK_EQ(Volume.Height, 16u);
+		CHECK_EQ(Volume.Depth, 16u);
+		CHECK_EQ(Volume.NumSourceChannels, 4u);
+		CHECK_EQ(Volume.RowPitch, 16 * GetBlueNoiseTexelSize(Format));
+		CHECK_EQ(Volume.Data.size(), size_t(Volume.SlicePitch) * 16);
+
+		const double Step = Format == BlueNoiseFormat::RGBA16_UNORM ? 1.0 / 65535 : 1.0 / 255;
+		const double MaxError = MeasureError(Volume, Raw, 3);
+		CHECK(MaxError <= Step * 0.5 + 1e-9);
+		CHECK_NEAR(Volume.MaxQuantizationError, MaxError, 1e-6);
+	}
+
+	std::remove(Path.c_str());
+}
+
+TEST_CASE(KeepsTheOrderOfValues)
+{
+	// 4096 texels fit 16 bits without collisions, the permutation survives.
+	const std::vector<uint32_t> Raw = MakeRaw({ 64, 64 }, 1);
+	const std::string Path = WriteRaw("corona_bluenoise_64x64.raw", Raw);
+
+	BlueNoiseVolume Volume;
+	std::string Error;
+	CHECK(LoadBlueNoiseRaw(Path, BlueNoiseFormat::RGBA16_UNORM, Volume, Error));
+	CHECK_EQ(Volume.Depth, 1u);
+
+	const uint16_t* Texels = reinterpret_cast<const uint16_t*>(Volume.Data.data());
+	std::vector<uint16_t> Values;
+	for (uint32_t i = 0; i < 64 * 64; i++)
+	{
+		Values.push_back(Texels[i * 4]);
+		// missing channels are zero.
+		CHECK(Texels[i * 4 + 1] == 0 && Texels[i * 4 + 2] == 0 && Texels[i * 4 + 3] == 0);
+	}
+	std::sort(Values.begin(), Values.end());
+	CHECK(std::adjacent_find(Values.begin(), Values.end()) == Values.end());
+	CHECK_EQ(Values.front(), 0);
+	CHECK_EQ(Values.back(), 65535);
+
+	std::remove(Path.c_str());
+}
+
+TEST_CASE(RejectsMalformedFiles)
+{
+	const std::vector<uint32_t> Good = MakeRaw({ 8, 8, 8 }, 2);
+	BlueNoiseVolume Volume;
+	std::string Error;
+
+	CHECK(!LoadBlueNoiseRaw(TempPath("corona_bluenoise_missing.raw"), BlueNoiseFormat::RGBA8_UNORM, Volume, Error));
+
+	auto Rejects = [&](const std::vector<uint32_t>& Raw, size_t NumWords = ~size_t(0))
+	{
+		const std::string Path = WriteRaw("corona_bluenoise_bad.raw", Raw, NumWords);
+		Error.clear();
+		const bool bLoaded = LoadBlueNoiseRaw(Path, BlueNoiseFormat::RGBA8_UNORM, Volume, Error);
+		std::remove(Path.c_str());
+		return !bLoaded && !Error.empty();
+	};
+
+	std::vector<uint32_t> Raw = Good;
+	Raw[0] = 2;
+	CHECK(Rejects(Raw));
+
+	Raw = Good;
+	Raw[1] = 5;
+	CHECK(Rejects(Raw));
+
+	Raw = Good;
+	Raw[2] = 4;
+	CHECK(Rejects(Raw));
+
+	Raw = Good;
+	Raw[3] = 0;
+	CHECK(Rejects(Raw));
+
+	CHECK(Rejects(Good, Good.size() - 1));
+	CHECK(Rejects(Good, 2));
+
+	Raw = Good;
+	Raw.back() = 8 * 8 * 8;
+	CHECK(Rejects(Raw));
+}
+
+TEST_CASE(Loads64CubeQuickly)
+{
+	// the size of the shipped HDR_RGBA set. the bound is loose, CoronaBenchmarks reports the actual time.
+	const std::vector<uint32_t> Raw = MakeRaw({ 64, 64, 64 }, 4);
+	const std::string Path = WriteRaw("corona_bluenoise_64.raw", Raw);
+
+	BlueNoiseVolume Volume;
+	std::string Error;
+	const auto Begin = std::chrono::steady_clock::now();
+	CHECK(LoadBlueNoiseRaw(Path, BlueNoiseFormat::RGBA16_UNORM, Volume, Error));
+	const double Ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - Begin).count();
+
+	CHECK(Ms < 1000.0);
+	CHECK_EQ(Volume.Data.size(), size_t(64 * 64 * 64 * 8));
+	CHECK(Volume.MaxQuantizationError <= 0.5f / 65535 + 1e-7f);
+
+	std::remove(Path.c_str());
+}
+
+TEST_CASE(WhiteNoiseFallback)
+{
+	BlueNoiseVolume Volume;
+	MakeWhiteNoiseVolume(32, BlueNoiseFormat::RGBA8_UNORM, Volume);
+	CHECK_EQ(Volume.Data.size(), size_t(32 * 32 * 32 * 4));
+
+	double Sum = 0;
+	uint32_t Histogram[4] = {};
+	for (uint8_t Value : Volume.Data)
+	{
+		Sum += Value / 255.0;
+		Histogram[Value >> 6]++;
+	}
+	CHECK_NEAR(Sum / Volume.Data.size(), 0.5, 0.01);
+	for (uint32_t Count : Histogram)
+		CHECK_NEAR(Count / double(Volume.Data.size()), 0.25, 0.01);
+}
@@ -0,0 +1,201 @@
+#include "TestFramework.h"
+#include "DDGICascades.h"
+
+#include <algorithm>
+
+// the ring addressing of the scrolling ddgi cascades, the part the shaders can't check on their own.
+namespace
+{
+	DDGICascadeDesc MakeDesc()
+	{
+		DDGICascadeDesc Desc;
+		Desc.Counts = glm::ivec3(32, 16, 32);
+		Desc.BaseSpacing = glm::vec3(100.f);
+		Desc.NumCascades = 3;
+		Desc.ScrollDeadzone = 1;
+		return Desc;
+	}
+
+	// storage index of the probe at world grid coordinate WorldCoords.
+	uint32_t GetStorageIndex(const DDGICascade& Cascade, const glm::ivec3& WorldCoords)
+	{
+		const glm::ivec3 GridCoords = WorldCoords - Cascade.GridMin;
+		return GetProbeIndex(GetScrollingProbeCoords(GridCoords, Cascade.Grid.Counts, Cascade.Grid.ScrollOffsets), Cascade.Grid.Counts);
+	}
+
+	// camera at the center of probe cell Cell of the first cascade.
+	glm::vec3 CellCenter(const glm::ivec3& Cell)
+	{
+		return (glm::vec3(Cell) + 0.5f) * MakeDesc().BaseSpacing;
+	}
+}
+
+TEST_CASE(ScrollOffsetsWrapNegativeGridMin)
+{
+	const glm::ivec3 Counts(32, 16, 32);
+	CHECK(DDGICascadeSet::GetScrollOffsets(glm::ivec3(0), Counts) == glm::ivec3(0));
+	CHECK(DDGICascadeSet::GetScrollOffsets(glm::ivec3(-1, -33, 65), Counts) == glm::ivec3(31, 15, 1));
+	CHECK(DDGICascadeSet::GetScrollOffsets(glm::ivec3(-32, 16, -64), Counts) == glm::ivec3(0));
+	CHECK(DDGICascadeSet::GetScrollOffsets(glm::ivec3(-1000001, 7, 31), Counts) == glm::ivec3(31, 7, 31));
+
+	// always in [0, Counts) and the same as GridMin mod Counts.
+	for (int32_t x = -100; x <= 100; x += 7)
+	{
+		const glm::ivec3 Offsets = DDGICascadeSet::GetScrollOffsets(glm::ivec3(x, x, x), Counts);
+		CHECK(glm::all(glm::greaterThanEqual(Offsets, glm::ivec3(0))) && glm::all(glm::lessThan(Offsets, Counts)));
+		CHECK_EQ((Offsets.y - x) % 16, 0);
+	}
+}
+
+TEST_CASE(ScrollingIsABijection)
+{
+	const glm::ivec3 Counts(32, 16, 32);
+	const uint32_t NumProbes = uint32_t(Counts.x * Counts.y * Counts.z);
+
+	for (const glm::ivec3 GridMin : { glm::ivec3(0), glm::ivec3(-1, -33, 65), glm::ivec3(17, 3, -5) })
+	{
+		const glm::ivec3 Offsets = DDGICascadeSet::GetScrollOffsets(GridMin, Counts);
+
+		std::vector<int> Used(NumProbes, 0);
+		for (uint32_t i = 0; i < NumProbes; i++)
+		{
+			const glm::ivec3 GridCoords = GetProbeCoords(i, Counts);
+			const glm::ivec3 Storage = GetScrollingProbeCoords(GridCoords, Counts, Offsets);
+			CHECK(GetUnscrolledProbeCoords(Storage, Counts, Offsets) == GridCoords);
+			Used[GetProbeIndex(Storage, Counts)]++;
+		}
+		CHECK(std::all_of(Used.begin(), Used.end(), [](int n) { return n == 1; }));
+	}
+}
+
+TEST_CASE(ProbesKeepTheirSlotWhileScrolling)
+{
+	DDGICascadeSet Set;
+	Set.Init(MakeDesc());
+	Set.Update(CellCenter(glm::ivec3(0)));
+
+	const DDGICascade& Cascade = Set.GetCascade(0);
+	const glm::ivec3 Probe = Cascade.GridMin + glm::ivec3(20, 8, 20);
+	const uint32_t Slot = GetStorageIndex(Cascade, Probe);
+	const glm::vec3 Position = GetProbeWorldPosition(Slot, Cascade.Grid);
+	CHECK_NEAR(glm::length(Position - glm::vec3(Probe) * Cascade.Grid.Spacing), 0.f, 1e-3f);
+
+	// walk the camera across negative coordinates, the probe is still inside the volume.
+	for (int32_t Step = 1; Step <= 6; Step++)
+	{
+		CHECK(Set.Update(CellCenter(glm::ivec3(-Step * 2, Step, -Step))));
+		CHECK_EQ(GetStorageIndex(Cascade, Probe), Slot);
+		CHECK(!Cascade.IsScrolledIn(Probe - Cascade.GridMin));
+		CHECK_NEAR(glm::length(GetProbeWorldPosition(Slot, Cascade.Grid) - Position), 0.f, 1e-3f);
+	}
+}
+
+TEST_CASE(ScrolledInPlanesAreCleared)
+{
+	const DDGICascadeDesc Desc = MakeDesc();
+	DDGICascadeSet Set;
+	Set.Init(Desc);
+
+	std::vector<uint32_t> Probes;
+	CHECK(Set.Update(CellCenter(glm::ivec3(0))));
+	Set.GetScrolledInProbes(0, Probes);
+	CHECK_EQ(Probes.size(), Set.GetCascade(0).Grid.GetNumProbes());
+
+	// the camera leaves the dead zone by k probes along x, k planes of Ny * Nz probes scroll in.
+	for (int32_t k = 1; k <= 3; k++)
+	{
+		Set.Init(Desc);
+		Set.Update(CellCenter(glm::ivec3(0)));
+		const glm::ivec3 OldMin = Set.GetCascade(0).GridMin;
+
+		CHECK(Set.Update(CellCenter(glm::ivec3(Desc.ScrollDeadzone + k, 0, 0))));
+		const DDGICascade& Cascade = Set.GetCascade(0);
+		CHECK(Cascade.GridMin == OldMin + glm::ivec3(k, 0, 0));
+
+		Set.GetScrolledInProbes(0, Probes);
+		CHECK_EQ(Probes.size(), uint32_t(k * Desc.Counts.y * Desc.Counts.z));
+
+		// the new planes are on the +x side of the volume.
+		for (uint32_t i : Probes)
+		{
+			const glm::ivec3 GridCoords = GetUnscrolledProbeCoords(GetProbeCoords(i, Cascade.Grid.Counts), Cascade.Grid.Counts, Cascade.Grid.ScrollOffsets);
+			CHECK(GridCoords.x >= Desc.Counts.x - k);
+		}
+	}
+
+	// the volume is centered on cell 3 now, leaving the dead zone on the -x side scrolls in one plane there.
+	Set.Update(CellCenter(glm::ivec3(3 - Desc.ScrollDeadzone - 1, 0, 0)));
+	CHECK(Set.GetCascade(0).ClearStart.x == 0 && Set.GetCascade(0).ClearCount.x == 1);
+}
+
+TEST_CASE(LargeJumpInvalidatesEverything)
+{
+	DDGICascadeSet Set;
+	Set.Init(MakeDesc());
+	Set.Update(CellCenter(glm::ivec3(0)));
+
+	CHECK(Set.Update(CellCenter(glm::ivec3(-500, 40, 1000))));
+	std::vector<uint32_t> Probes;
+	for (uint32_t c = 0; c < Set.GetNumCascades(); c++)
+	{
+		Set.GetScrolledInProbes(c, Probes);
+		CHECK_EQ(Probes.size(), Set.GetCascade(c).Grid.GetNumProbes());
+	}
+
+	// Invalidate does the same without moving.
+	Set.Invalidate();
+	CHECK(Set.Update(CellCenter(glm::ivec3(-500, 40, 1000))));
+	Set.GetScrolledInProbes(2, Probes);
+	CHECK_EQ(Probes.size(), Set.GetCascade(2).Grid.GetNumProbes());
+}
+
+TEST_CASE(DeadzoneStopsJitter)
+{
+	DDGICascadeSet Set;
+	Set.Init(MakeDesc());
+	Set.Update(CellCenter(glm::ivec3(0)));
+	const glm::ivec3 GridMin = Set.GetCascade(0).GridMin;
+
+	// a camera sitting on a cell boundary.
+	for (int i = 0; i < 10; i++)
+	{
+		CHECK(!Set.Update(glm::vec3(i % 2 ? 0.01f : -0.01f, 50.f, 50.f)));
+		CHECK(Set.GetCascade(0).GridMin == GridMin);
+	}
+}
+
+TEST_CASE(ScrollDescMatchesTheCascade)
+{
+	DDGICascadeSet Set;
+	Set.Init(MakeDesc());
+	Set.Update(CellCenter(glm::ivec3(0)));
+	Set.Update(CellCenter(glm::ivec3(-5, 3, 4)));
+
+	for (uint32_t c = 0; c < Set.GetNumCascades(); c++)
+	{
+		const DDGICascade& Cascade = Set.GetCascade(c);
+		const DDGIScrollDescGPU Desc = Set.GetScrollDescGPU(c);
+		CHECK(Desc.ScrollOffsets == Cascade.Grid.ScrollOffsets);
+		CHECK(Desc.ClearStart == Cascade.ClearStart);
+		CHECK(Desc.ClearCount == Cascade.ClearCount);
+		CHECK(Desc.ScrollOffsets == DDGICascadeSet::GetScrollOffsets(Cascade.GridMin, Cascade.Grid.Counts));
+	}
+}
+
+TEST_CASE(CascadesNest)
+{
+	DDGICascadeSet Set;
+	Set.Init(MakeDesc());
+	const glm::vec3 Camera = CellCenter(glm::ivec3(-7, 2, 11));
+	Set.Update(Camera);
+
+	for (uint32_t c = 1; c < Set.GetNumCascades(); c++)
+		CHECK(Set.GetCascade(c).Grid.Spacing == Set.GetCascade(c - 1).Grid.Spacing * 2.f);
+
+	// the camera is inside the finest cascade, far points fall to the coarser ones.
+	CHECK_EQ(Set.SelectCascade(Camera), 0);
+	CHECK_NEAR(Set.GetBlendWeight(0, Camera), 1.f, 1e-6f);
+	CHECK_EQ(Set.SelectCascade(Camera + glm::vec3(2500.f, 0.f, 0.f)), 1);
+	CHECK_EQ(Set.SelectCascade(Camera + glm::vec3(100000.f, 0.f, 0.f)), Set.GetNumCascades() - 1);
+	CHECK_NEAR(Set.GetBlendWeight(0, Camera + glm::vec3(100000.f, 0.f, 0.f)), 0.f, 1e-6f);
+}
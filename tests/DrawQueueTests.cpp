@@ -0,0 +1,165 @@
+#include "TestFramework.h"
+#include "DrawQueue.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+// the sort keys and the radix sort of the gbuffer draw queue, against std::stable_sort.
+namespace
+{
+	std::vector<uint64_t> MakeSceneKeys(uint32_t NumDraws, uint32_t Seed)
+	{
+		std::mt19937 Rng(Seed);
+		std::uniform_int_distribution<uint32_t> Pass(0, 1);
+		std::uniform_int_distribution<uint32_t> PSO(0, 3);
+		std::uniform_int_distribution<uint32_t> Material(0, 40);
+		std::uniform_real_distribution<float> Depth(0.f, 5000.f);
+
+		std::vector<uint64_t> Keys(NumDraws);
+		for (uint64_t& Key : Keys)
+			Key = MakeDrawSortKey(Pass(Rng), PSO(Rng), Material(Rng), Depth(Rng));
+		return Keys;
+	}
+}
+
+TEST_CASE(SortKeyFields)
+{
+	const uint64_t Key = MakeDrawSortKey(DRAW_PASS_ALPHA_TEST, 37, 1234, 10.f);
+	CHECK_EQ(GetSortKeyPass(Key), DRAW_PASS_ALPHA_TEST);
+	CHECK_EQ(GetSortKeyPSO(Key), 37);
+	CHECK_EQ(GetSortKeyMaterial(Key), 1234);
+
+	// fields wider than their bits are masked instead of spilling into the next one.
+	const uint64_t Wide = MakeDrawSortKey(0, (1u << kSortKeyPSOBits) + 5, (1u << kSortKeyMaterialBits) + 7, 1.f);
+	CHECK_EQ(GetSortKeyPass(Wide), 0);
+	CHECK_EQ(GetSortKeyPSO(Wide), 5);
+	CHECK_EQ(GetSortKeyMaterial(Wide), 7);
+}
+
+TEST_CASE(SortKeyOrder)
+{
+	// pass before pso before material before depth.
+	CHECK(MakeDrawSortKey(DRAW_PASS_OPAQUE, 9, 9, 9000.f) < MakeDrawSortKey(DRAW_PASS_ALPHA_TEST, 0, 0, 0.f));
+	CHECK(MakeDrawSortKey(0, 1, 9, 9000.f) < MakeDrawSortKey(0, 2, 0, 0.f));
+	CHECK(MakeDrawSortKey(0, 1, 1, 9000.f) < MakeDrawSortKey(0, 1, 2, 0.f));
+
+	// front to back within a material, negative depth clamps to the front.
+	CHECK(MakeDrawSortKey(0, 1, 1, 0.5f) < MakeDrawSortKey(0, 1, 1, 1.f));
+	CHECK(MakeDrawSortKey(0, 1, 1, 1.f) < MakeDrawSortKey(0, 1, 1, 1000.f));
+	CHECK_EQ(MakeDrawSortKey(0, 1, 1, -3.f), MakeDrawSortKey(0, 1, 1, 0.f));
+}
+
+TEST_CASE(RadixSortMatchesStableSort)
+{
+	std::vector<uint64_t> Keys, ScratchKeys;
+	std::vector<uint32_t> Items, ScratchItems;
+
+	for (uint32_t NumDraws : { 0u, 1u, 2u, 3u, 100u, 5000u })
+	{
+		Keys = MakeSceneKeys(NumDraws, NumDraws + 1);
+		// duplicates, the items have to keep their order.
+		for (size_t i = 1; i < Keys.size(); i += 3)
+			Keys[i] = Keys[i - 1];
+
+		Items.resize(NumDraws);
+		std::iota(Items.begin(), Items.end(), 0u);
+
+		std::vector<uint32_t> Expected = Items;
+		const std::vector<uint64_t> Unsorted = Keys;
+		std::stable_sort(Expected.begin(), Expected.end(), [&](uint32_t a, uint32_t b) { return Unsorted[a] < Unsorted[b]; });
+
+		RadixSortDrawKeys(Keys, Items, ScratchKeys, ScratchItems);
+		CHECK(Items == Expected);
+		CHECK(std::is_sorted(Keys.begin(), Keys.end()));
+		for (size_t i = 0; i < Keys.size(); i++)
+			CHECK_EQ(Keys[i], Unsorted[Items[i]]);
+	}
+}
+
+TEST_CASE(RadixSortSkipsConstantBytes)
+{
+	// keys differing in 1, 2 or 3 bytes, the other passes are skipped so the result ends in either array.
+	for (uint32_t NumVaryingBytes : { 1u, 2u, 3u })
+	{
+		std::vector<uint64_t> Keys, ScratchKeys;
+		std::vector<uint32_t> Items, ScratchItems;
+		for (uint32_t i = 0; i < 64; i++)
+		{
+			uint64_t Key = 0;
+			for (uint32_t Byte = 0; Byte < NumVaryingBytes; Byte++)
+				Key |= uint64_t((i * 37 + Byte * 11) & 0xff) << (Byte * 16);
+			Keys.push_back(Key);
+			Items.push_back(i);
+		}
+
+		const std::vector<uint64_t> Unsorted = Keys;
+		RadixSortDrawKeys(Keys, Items, ScratchKeys, ScratchItems);
+		CHECK(std::is_sorted(Keys.begin(), Keys.end()));
+		for (size_t i = 0; i < Keys.size(); i++)
+			CHECK_EQ(Keys[i], Unsorted[Items[i]]);
+	}
+}
+
+TEST_CASE(DrawQueueGroupsState)
+{
+	const std::vector<uint64_t> Keys = MakeSceneKeys(2000, 7);
+
+	DrawQueue Queue;
+	for (uint32_t i = 0; i < Keys.size(); i++)
+		Queue.Add(Keys[i], i);
+	Queue.Sort();
+	CHECK_EQ(Queue.Size(), Keys.size());
+
+	// the bind loop of Corona::DrawScene, pso and material are the fields of the key.
+	auto CountBinds = [&](bool bSorted)
+	{
+		RedundantBindFilter Filter;
+		Filter.Reset();
+		for (size_t i = 0; i < Keys.size(); i++)
+		{
+			const uint64_t Key = bSorted ? Queue.GetKey(i) : Keys[i];
+			Filter.SetPSO(reinterpret_cast<const void*>(uintptr_t(GetSortKeyPass(Key) * 16 + GetSortKeyPSO(Key) + 1)));
+			Filter.SetMaterial(reinterpret_cast<const void*>(uintptr_t(GetSortKeyMaterial(Key) + 1)));
+			Filter.CountDraw();
+		}
+		return Filter.GetStats();
+	};
+
+	const DrawBindStats Unsorted = CountBinds(false);
+	const DrawBindStats Sorted = CountBinds(true);
+	CHECK_EQ(Sorted.NumDraws, 2000);
+
+	// one pso bind per pass and pso, at most one material bind per pso and material.
+	CHECK(Sorted.NumPSOBinds <= 2 * 4);
+	CHECK(Sorted.NumMaterialBinds <= 2 * 4 * 41);
+	CHECK(Sorted.NumMaterialBinds < Unsorted.NumMaterialBinds / 2);
+
+	for (size_t i = 0; i < Queue.Size(); i++)
+		CHECK_EQ(Queue.GetKey(i), Keys[Queue.GetItem(i)]);
+
+	Queue.Clear();
+	CHECK_EQ(Queue.Size(), 0);
+}
+
+TEST_CASE(RedundantBindsAreSkipped)
+{
+	int A, B;
+	RedundantBindFilter Filter;
+	Filter.Reset();
+
+	CHECK(Filter.SetPSO(&A));
+	CHECK(!Filter.SetPSO(&A));
+	CHECK(Filter.SetPSO(&B));
+	CHECK(Filter.SetGeometry(&A));
+	CHECK(!Filter.SetGeometry(&A));
+	CHECK(Filter.SetMaterial(&B));
+	CHECK_EQ(Filter.GetStats().NumPSOBinds, 2);
+	CHECK_EQ(Filter.GetStats().NumGeometryBinds, 1);
+	CHECK_EQ(Filter.GetStats().NumMaterialBinds, 1);
+
+	// after a reset nothing is bound.
+	Filter.Reset();
+	CHECK(Filter.SetPSO(&B));
+	CHECK_EQ(Filter.GetStats().NumPSOBinds, 1);
+}
@@ -0,0 +1,168 @@
+#include "TestFramework.h"
+#include "FramePacing.h"
+
+#include <algorithm>
+#include <vector>
+
+// FramePacer against a simulated gpu queue that runs the submitted frames one after another, the
+// fences it waits for, the cpu / gpu overlap and the latency it reports for each frames in flight limit.
+namespace
+{
+	const uint64_t kMs = 1000000;
+
+	struct SimResult
+	{
+		double FrameMs = 0.0;
+		double InputToPresentMs = 0.0;
+		double InputToRetireMs = 0.0;
+		uint32_t MaxInFlight = 0;
+	};
+
+	// CpuMs of recording after input is sampled, InputMs of simulation before it. the present call
+	// returns right away, the gpu takes GpuMs per frame.
+	SimResult Simulate(uint32_t MaxFramesInFlight, double InputMs, double CpuMs, double GpuMs, uint32_t NumFrames = 200)
+	{
+		FramePacer Pacer;
+		Pacer.Init(3);
+		Pacer.SetMaxFramesInFlight(MaxFramesInFlight);
+
+		std::vector<uint64_t> GpuDoneNs(1, 0);	// by fence value
+		auto CompletedFence = [&](uint64_t Ns)
+		{
+			uint64_t Fence = 0;
+			while (Fence + 1 < GpuDoneNs.size() && GpuDoneNs[Fence + 1] <= Ns)
+				Fence++;
+			return Fence;
+		};
+
+		SimResult Result;
+		uint64_t Now = 0;
+		std::vector<uint64_t> BeginNs;
+		for (uint32_t Frame = 0; Frame < NumFrames; Frame++)
+		{
+			const uint64_t WaitBeginNs = Now;
+			const uint64_t WaitFence = Pacer.GetWaitFenceValue();
+			if (WaitFence)
+				Now = std::max(Now, GpuDoneNs[WaitFence]);
+			Pacer.Retire(CompletedFence(Now), Now);
+
+			BeginNs.push_back(Now);
+			Pacer.BeginFrame(Now, Now - WaitBeginNs);
+			Now += uint64_t(InputMs * kMs);
+			Pacer.MarkInputSampled(Now);
+			Now += uint64_t(CpuMs * kMs);
+
+			GpuDoneNs.push_back(std::max(Now, GpuDoneNs.back()) + uint64_t(GpuMs * kMs));
+			Pacer.EndFrame(GpuDoneNs.size() - 1, Now);
+			Result.MaxInFlight = std::max(Result.MaxInFlight, Pacer.GetNumInFlight());
+		}
+
+		// the steady state, the first frames fill the pipeline.
+		const uint32_t First = NumFrames / 2;
+		Result.FrameMs = double(BeginNs.back() - BeginNs[First]) / kMs / (NumFrames - 1 - First);
+		Result.InputToPresentMs = Pacer.GetInputToPresent().GetStats().P50Ms;
+		Result.InputToRetireMs = Pacer.GetInputToRetire().GetStats().P50Ms;
+		return Result;
+	}
+}
+
+TEST_CASE(WaitFenceValues)
+{
+	FramePacer Pacer;
+	Pacer.Init(3);
+	CHECK_EQ(Pacer.GetMaxFramesInFlight(), 3);
+
+	Pacer.SetMaxFramesInFlight(0);
+	CHECK_EQ(Pacer.GetMaxFramesInFlight(), 1);
+	Pacer.SetMaxFramesInFlight(8);
+	CHECK_EQ(Pacer.GetMaxFramesInFlight(), 3);
+	Pacer.SetMaxFramesInFlight(2);
+
+	// two frames may be in flight, the third waits for the first.
+	for (uint64_t Fence = 1; Fence <= 2; Fence++)
+	{
+		CHECK_EQ(Pacer.GetWaitFenceValue(), 0);
+		Pacer.BeginFrame(Fence * kMs, 0);
+		Pacer.EndFrame(Fence * 10, Fence * kMs);
+	}
+	CHECK_EQ(Pacer.GetFrameNumber(), 1);
+	CHECK_EQ(Pacer.GetNumInFlight(), 2);
+	CHECK_EQ(Pacer.GetWaitFenceValue(), 10);
+
+	// retiring the first frame frees its slot, a smaller limit takes effect with the next wait.
+	Pacer.Retire(10, 3 * kMs);
+	CHECK_EQ(Pacer.GetNumInFlight(), 1);
+	CHECK_EQ(Pacer.GetWaitFenceValue(), 0);
+	Pacer.SetMaxFramesInFlight(1);
+	CHECK_EQ(Pacer.GetWaitFenceValue(), 20);
+
+	// a completed value past several frames retires all of them.
+	Pacer.BeginFrame(4 * kMs, 0);
+	Pacer.EndFrame(30, 4 * kMs);
+	Pacer.Retire(35, 5 * kMs);
+	CHECK_EQ(Pacer.GetNumInFlight(), 0);
+	CHECK_EQ(Pacer.GetInputToRetire().GetNumSamples(), 3);
+}
+
+TEST_CASE(InputLatencyIsMeasuredFromTheSample)
+{
+	FramePacer Pacer;
+	Pacer.Init(2);
+
+	// sampled 3 ms into the frame, presented at 10 ms, done on the gpu at 25 ms.
+	Pacer.BeginFrame(0, 0);
+	Pacer.MarkInputSampled(3 * kMs);
+	Pacer.EndFrame(1, 10 * kMs);
+	Pacer.Retire(1, 25 * kMs);
+	CHECK_NEAR(Pacer.GetInputToPresent().GetLastMs(), 7.0, 1e-9);
+	CHECK_NEAR(Pacer.GetInputToRetire().GetLastMs(), 22.0, 1e-9);
+
+	// a frame that never reports its input latched it at the begin.
+	Pacer.BeginFrame(30 * kMs, 2 * kMs);
+	Pacer.EndFrame(2, 40 * kMs);
+	CHECK_NEAR(Pacer.GetInputToPresent().GetLastMs(), 10.0, 1e-9);
+	CHECK_NEAR(Pacer.GetWaitTimes().GetLastMs(), 2.0, 1e-9);
+
+	// retiring an older fence again changes nothing.
+	Pacer.Retire(1, 50 * kMs);
+	CHECK_EQ(Pacer.GetNumInFlight(), 1);
+}
+
+TEST_CASE(GpuBoundOverlap)
+{
+	// 6 ms of cpu, 10 ms of gpu.
+	const SimResult One = Simulate(1, 1.0, 5.0, 10.0);
+	const SimResult Two = Simulate(2, 1.0, 5.0, 10.0);
+	const SimResult Three = Simulate(3, 1.0, 5.0, 10.0);
+
+	// one frame in flight serializes cpu and gpu, two overlap them and run at the gpu's rate.
+	CHECK_NEAR(One.FrameMs, 16.0, 0.01);
+	CHECK_NEAR(Two.FrameMs, 10.0, 0.01);
+	CHECK_NEAR(Three.FrameMs, 10.0, 0.01);
+	CHECK_EQ(One.MaxInFlight, 1);
+	CHECK_EQ(Three.MaxInFlight, 3);
+
+	// a third frame buys nothing on a gpu bound frame but queues another gpu frame of latency.
+	CHECK_NEAR(One.InputToRetireMs, 15.0, 0.01);
+	CHECK_NEAR(Two.InputToRetireMs, 19.0, 0.01);
+	CHECK_NEAR(Three.InputToRetireMs, 29.0, 0.01);
+	CHECK_NEAR(Three.InputToPresentMs, 5.0, 0.01);
+}
+
+TEST_CASE(CpuBoundOverlap)
+{
+	// 12 ms of cpu, 8 ms of gpu, the gpu finishes each frame before the next one is recorded.
+	const SimResult One = Simulate(1, 2.0, 10.0, 8.0);
+	const SimResult Two = Simulate(2, 2.0, 10.0, 8.0);
+	const SimResult Three = Simulate(3, 2.0, 10.0, 8.0);
+
+	CHECK_NEAR(One.FrameMs, 20.0, 0.01);
+	CHECK_NEAR(Two.FrameMs, 12.0, 0.01);
+	CHECK_NEAR(Three.FrameMs, 12.0, 0.01);
+
+	// the gpu never falls behind, a frame is retired by the next begin after it. a third frame in flight
+	// is never used and adds no latency.
+	CHECK_EQ(Three.MaxInFlight, 2);
+	CHECK_NEAR(Two.InputToRetireMs, Three.InputToRetireMs, 0.01);
+	CHECK(Two.InputToRetireMs >= 18.0 && Two.InputToRetireMs <= 22.0);
+}
@@ -0,0 +1,176 @@
+#include "TestFramework.h"
+#include "StepTimer.h"
+
+#include <numeric>
+
+// StepTimer under a mock clock, fixed step catch-up, clamping and smoothing, the percentile stats of
+// FrameTiming and the calibration of CycleClock against the reference clock.
+namespace
+{
+	const uint64_t kMs = 1000000;
+
+	uint64_t MockNowNs = 0;
+	uint64_t MockClock() { return MockNowNs; }
+
+	int NumUpdates = 0;
+	void CountUpdate() { NumUpdates++; }
+
+	// advances the mock clock and ticks, returns the updates the tick ran.
+	int TickAfter(StepTimer& Timer, uint64_t Ns)
+	{
+		MockNowNs += Ns;
+		NumUpdates = 0;
+		Timer.Tick(CountUpdate);
+		return NumUpdates;
+	}
+}
+
+TEST_CASE(VariableStepClampsStalls)
+{
+	MockNowNs = 5 * StepTimer::NsPerSecond;
+	StepTimer Timer(MockClock);
+
+	CHECK_EQ(TickAfter(Timer, 10 * kMs), 1);
+	CHECK_NEAR(Timer.GetElapsedSeconds(), 0.01, 1e-9);
+
+	// a stall in the debugger counts as 100 ms, the frame time history keeps the real one.
+	CHECK_EQ(TickAfter(Timer, 1000 * kMs), 1);
+	CHECK_NEAR(Timer.GetElapsedSeconds(), 0.1, 1e-9);
+	CHECK_NEAR(Timer.GetTotalSeconds(), 0.11, 1e-9);
+	CHECK_NEAR(Timer.GetFrameTimes().GetLastMs(), 1000.0, 1e-9);
+
+	// a second of 10 ms frames.
+	Timer.ResetElapsedTime();
+	for (int i = 0; i < 100; i++)
+		TickAfter(Timer, 10 * kMs);
+	CHECK_EQ(Timer.GetFramesPerSecond(), 100);
+	CHECK_EQ(Timer.GetFrameCount(), 102);
+}
+
+TEST_CASE(SmoothedElapsedTime)
+{
+	MockNowNs = 0;
+	StepTimer Timer(MockClock);
+	Timer.SetSmoothingFactor(0.5);
+
+	TickAfter(Timer, 10 * kMs);
+	CHECK_NEAR(Timer.GetSmoothedElapsedSeconds(), 0.010, 1e-9);
+	TickAfter(Timer, 20 * kMs);
+	CHECK_NEAR(Timer.GetSmoothedElapsedSeconds(), 0.015, 1e-9);
+	TickAfter(Timer, 20 * kMs);
+	CHECK_NEAR(Timer.GetSmoothedElapsedSeconds(), 0.0175, 1e-9);
+	CHECK_NEAR(Timer.GetElapsedSeconds(), 0.020, 1e-9);
+
+	// without smoothing it follows the raw delta.
+	Timer.SetSmoothingFactor(1.0);
+	TickAfter(Timer, 5 * kMs);
+	CHECK_NEAR(Timer.GetSmoothedElapsedSeconds(), 0.005, 1e-9);
+}
+
+TEST_CASE(FixedStepCatchUp)
+{
+	MockNowNs = 0;
+	StepTimer Timer(MockClock);
+	Timer.SetFixedTimeStep(true);
+	Timer.SetTargetElapsedSeconds(1.0 / 60.0);
+
+	// within a quarter millisecond of the step snaps to it, no drift on a 59.94 hz display.
+	for (int i = 0; i < 1000; i++)
+		CHECK_EQ(TickAfter(Timer, 16683333), 1);
+	CHECK_EQ(Timer.GetFrameCount(), 1000);
+	CHECK_EQ(Timer.GetElapsedTicks(), StepTimer::TicksPerSecond / 60);
+
+	// too early for a step.
+	CHECK_EQ(TickAfter(Timer, 8 * kMs), 0);
+	CHECK_EQ(TickAfter(Timer, 9 * kMs), 1);
+
+	// a 100 ms hitch runs the missed steps.
+	Timer.ResetElapsedTime();
+	CHECK_EQ(TickAfter(Timer, 100 * kMs), 6);
+	CHECK_NEAR(Timer.GetSmoothedElapsedSeconds(), 1.0 / 60.0, 1e-6);
+}
+
+TEST_CASE(FixedStepUpdateLimit)
+{
+	MockNowNs = 0;
+	StepTimer Timer(MockClock);
+	Timer.SetFixedTimeStep(true);
+	Timer.SetTargetElapsedSeconds(1.0 / 60.0);
+	Timer.SetMaxUpdatesPerTick(2);
+
+	// 5 steps and a bit are due, 2 run, the whole steps past the limit are dropped.
+	CHECK_EQ(TickAfter(Timer, 90 * kMs), 2);
+	CHECK_EQ(TickAfter(Timer, 16666666), 1);
+	CHECK_EQ(TickAfter(Timer, 16666666), 1);
+
+	// the fraction of a step is kept: 10 ms left over plus 10 ms makes one more step.
+	Timer.ResetElapsedTime();
+	CHECK_EQ(TickAfter(Timer, 10 * kMs), 0);
+	CHECK_EQ(TickAfter(Timer, 10 * kMs), 1);
+	CHECK_EQ(TickAfter(Timer, 10 * kMs), 0);
+}
+
+TEST_CASE(TimingPercentiles)
+{
+	std::vector<double> Samples(100);
+	std::iota(Samples.begin(), Samples.end(), 1.0);
+	std::swap(Samples[3], Samples[70]);
+
+	const TimingStats Stats = ComputeTimingStats(Samples);
+	CHECK_EQ(Stats.NumSamples, 100);
+	CHECK_NEAR(Stats.AvgMs, 50.5, 1e-9);
+	CHECK_NEAR(Stats.MinMs, 1.0, 0.0);
+	CHECK_NEAR(Stats.P50Ms, 50.0, 0.0);
+	CHECK_NEAR(Stats.P95Ms, 95.0, 0.0);
+	CHECK_NEAR(Stats.P99Ms, 99.0, 0.0);
+	CHECK_NEAR(Stats.MaxMs, 100.0, 0.0);
+
+	std::vector<double> One = { 4.0 };
+	CHECK_NEAR(ComputeTimingStats(One).P99Ms, 4.0, 0.0);
+	std::vector<double> None;
+	CHECK_EQ(ComputeTimingStats(None).NumSamples, 0);
+
+	// the history keeps the last Window frames.
+	FrameTimeHistory History(10);
+	for (int i = 1; i <= 25; i++)
+		History.Add(double(i));
+	CHECK_EQ(History.GetNumSamples(), 10);
+	CHECK_NEAR(History.GetLastMs(), 25.0, 0.0);
+	CHECK_NEAR(History.GetStats().MinMs, 16.0, 0.0);
+	CHECK_NEAR(History.GetStats().P50Ms, 20.0, 0.0);
+	History.Clear();
+	CHECK_EQ(History.GetStats().NumSamples, 0);
+}
+
+TEST_CASE(CycleClockFollowsSteadyClock)
+{
+	CycleClock Clock;
+	Clock.Init(20 * kMs);
+
+	// not calibrated yet, it reads the reference clock.
+	Clock.Calibrate();
+	CHECK(!Clock.IsCalibrated());
+	const uint64_t Before = SteadyClockNs();
+	const uint64_t Now = Clock.NowNs();
+	CHECK(Now >= Before && Now - Before < 10 * kMs);
+
+	if (!HasInvariantCycleCounter())
+	{
+		std::printf("  no invariant cycle counter, skipped\n");
+		return;
+	}
+
+	while (SteadyClockNs() - Before < 30 * kMs)
+		;
+	Clock.Calibrate();
+	CHECK(Clock.IsCalibrated());
+	CHECK(Clock.GetCyclesPerSecond() > 1e8);
+
+	// 50 ms later the two clocks still agree within a few microseconds, a millisecond leaves room for
+	// a busy machine.
+	while (SteadyClockNs() - Before < 80 * kMs)
+		;
+	const uint64_t Reference = SteadyClockNs();
+	const uint64_t Cycles = Clock.NowNs();
+	CHECK_NEAR(double(Cycles), double(Reference), double(kMs));
+}
@@ -0,0 +1,145 @@
+#include "TestFramework.h"
+#include "GIDenoiserCPU.h"
+
+#include "enkiTS/TaskScheduler.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <cstdio>
+#include <random>
+
+// SpatialDenoiseCPU and TemporalFilterCPU at 1080p and 4K, single threaded and on every core. the gi
+// buffers are at 1/3 of the render resolution like Corona::GIBufferScale.
+namespace
+{
+	const uint32_t kGIBufferScale = 3;
+	const float kNear = 0.1f;
+	const float kFar = 1000.f;
+
+	// a tilted plane with noisy sh on it.
+	void MakeInputs(uint32_t Width, uint32_t Height, DenoiserImage& Depth, DenoiserImage& Normal, DenoiserImage& SH, DenoiserImage& CoCg)
+	{
+		Depth.Init(Width, Height, false);
+		Normal.Init(Width, Height, true);
+		SH.Init(Width / kGIBufferScale, Height / kGIBufferScale, true);
+		CoCg.Init(Width / kGIBufferScale, Height / kGIBufferScale, true);
+
+		std::mt19937 Rng(1);
+		std::uniform_real_distribution<float> Noise(0.f, 1.f);
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				const float v = float(y) / Height;
+				Depth.Store(x, y, glm::vec4(0.9f + 0.09f * v, 0, 0, 0));
+				Normal.Store(x, y, glm::vec4(glm::normalize(glm::vec3(0.1f * x / Width, 1.f, 0.2f)), 0));
+			}
+		}
+		for (uint32_t y = 0; y < SH.Height; y++)
+		{
+			for (uint32_t x = 0; x < SH.Width; x++)
+			{
+				SH.Store(x, y, glm::vec4(Noise(Rng), Noise(Rng), Noise(Rng), Noise(Rng)));
+				CoCg.Store(x, y, glm::vec4(Noise(Rng) - 0.5f, Noise(Rng) - 0.5f, 0, 0));
+			}
+		}
+	}
+
+	void RunSpatial(const char* Label, uint32_t Width, uint32_t Height, enki::TaskScheduler* TS)
+	{
+		DenoiserImage Depth, Normal, SH[2], CoCg[2];
+		MakeInputs(Width, Height, Depth, Normal, SH[0], CoCg[0]);
+		const DenoiserImage SourceSH = SH[0];
+		const DenoiserImage SourceCoCg = CoCg[0];
+
+		SpatialFilterConstant CB = {};
+		CB.ProjectionParams = glm::vec4(0, 0, kNear, kFar);
+		CB.GIBufferScale = kGIBufferScale;
+
+		const double Ms = MeasureMs([&]()
+		{
+			SH[0] = SourceSH;
+			CoCg[0] = SourceCoCg;
+			SpatialDenoiseCPU(CB, Depth, Normal, SH, CoCg, TS);
+		}, 3, 3);
+		std::printf("  spatial %s %ux%u (gi %ux%u), %s: %.2f ms\n", Label, Width, Height, SourceSH.Width, SourceSH.Height,
+			TS ? "all threads" : "1 thread", Ms);
+	}
+
+	void RunTemporal(const char* Label, uint32_t Width, uint32_t Height, enki::TaskScheduler* TS)
+	{
+		DenoiserImage Depth, Normal, SHLow, CoCgLow;
+		MakeInputs(Width, Height, Depth, Normal, SHLow, CoCgLow);
+
+		// the temporal pass runs at render resolution.
+		DenoiserImage SH, CoCg, Velocity, Specular, RoughnessMetallic;
+		SH.Init(Width, Height, true);
+		CoCg.Init(Width, Height, true);
+		Velocity.Init(Width, Height, true);
+		Specular.Init(Width, Height, true);
+		RoughnessMetallic.Init(Width, Height, true);
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				SH.Store(x, y, SHLow.Load(x / kGIBufferScale, y / kGIBufferScale));
+				CoCg.Store(x, y, CoCgLow.Load(x / kGIBufferScale, y / kGIBufferScale));
+				Specular.Store(x, y, glm::vec4(0.5f, 0.4f, 0.3f, 1.f));
+				RoughnessMetallic.Store(x, y, glm::vec4(0.5f, 0.f, 0, 0));
+				Velocity.Store(x, y, glm::vec4(0.001f, 0.f, 0, 0));
+			}
+		}
+
+		TemporalFilterInputs In;
+		In.Depth = &Depth;
+		In.Normal = &Normal;
+		In.SH = &SH;
+		In.CoCg = &CoCg;
+		In.PrevSH = &SH;
+		In.PrevCoCg = &CoCg;
+		In.Velocity = &Velocity;
+		In.Specular = &Specular;
+		In.PrevSpecular = &Specular;
+		In.RoughnessMetallic = &RoughnessMetallic;
+		In.PrevDepth = &Depth;
+		In.PrevNormal = &Normal;
+
+		DenoiserImage OutSH, OutCoCg, OutSHDS, OutCoCgDS, OutSpecular;
+		TemporalFilterOutputs Out;
+		Out.SH = &OutSH;
+		Out.CoCg = &OutCoCg;
+		Out.SHDS = &OutSHDS;
+		Out.CoCgDS = &OutCoCgDS;
+		Out.Specular = &OutSpecular;
+
+		const glm::mat4x4 Proj = glm::perspective(glm::radians(60.f), float(Width) / Height, kNear, kFar);
+
+		TemporalFilterConstant CB = {};
+		CB.InvViewMatrix = glm::mat4x4(1.f);
+		CB.InvProjMatrix = glm::inverse(Proj);
+		CB.ProjectionParams = glm::vec4(0, 0, kNear, kFar);
+		CB.RTSize = glm::vec2(Width, Height);
+		CB.FrameIndex = 1;
+
+		const double Ms = MeasureMs([&]() { TemporalFilterCPU(CB, In, Out, TS); }, 1, 2);
+		std::printf("  temporal %s %ux%u, %s: %.2f ms\n", Label, Width, Height, TS ? "all threads" : "1 thread", Ms);
+	}
+}
+
+BENCHMARK(GIDenoiser1080p4K)
+{
+	enki::TaskScheduler TS;
+	TS.Initialize();
+
+	const struct { const char* Label; uint32_t Width; uint32_t Height; } Resolutions[] = {
+		{ "1080p", 1920, 1080 },
+		{ "4K", 3840, 2160 },
+	};
+
+	for (const auto& Res : Resolutions)
+	{
+		RunSpatial(Res.Label, Res.Width, Res.Height, nullptr);
+		RunSpatial(Res.Label, Res.Width, Res.Height, &TS);
+		RunTemporal(Res.Label, Res.Width, Res.Height, nullptr);
+		RunTemporal(Res.Label, Res.Width, Res.Height, &TS);
+	}
+}
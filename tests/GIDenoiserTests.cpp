@@ -0,0 +1,299 @@
+#include "TestFramework.h"
+#include "GIDenoiserCPU.h"
+
+#include "enkiTS/TaskScheduler.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// SpatialDenoiseCPU and TemporalFilterCPU: constant inputs come out unchanged, threads don't change a bit,
+// and a small scene with a depth and a normal edge matches golden images in tests/golden. the goldens are
+// 8 bit ppm of the gi color, luma SH.w and chroma CoCg + 0.5, or the specular color. a texel may be off
+// by one step. CORONA_UPDATE_GOLDEN=1 rewrites them.
+namespace
+{
+	// render resolution, the gi buffers are a third of it like Corona::GIBufferScale. the spatial pass
+	// only covers the first 32 of the 40 gi columns, the temporal pass the first 60 of the 72 rows.
+	const uint32_t kWidth = 120;
+	const uint32_t kHeight = 72;
+	const uint32_t kGIBufferScale = 3;
+	const uint32_t kGIWidth = kWidth / kGIBufferScale;
+	const uint32_t kGIHeight = kHeight / kGIBufferScale;
+	const float kNear = 0.1f;
+	const float kFar = 1000.f;
+
+	// the same noise on every compiler, the std distributions aren't.
+	float Noise(uint32_t x, uint32_t y, uint32_t Channel)
+	{
+		uint32_t h = x * 73856093u ^ y * 19349663u ^ (Channel + 1) * 83492791u;
+		h ^= h >> 13;
+		h *= 0x5bd1e995u;
+		h ^= h >> 15;
+		return float(h & 0xffff) / 65535.f;
+	}
+
+	struct Scene
+	{
+		DenoiserImage Depth, PrevDepth, Normal, Velocity, RoughnessMetallic;
+		DenoiserImage SH, CoCg, Specular;
+		DenoiserImage PrevSH, PrevCoCg, PrevSpecular;
+		// the gi buffers of the spatial pass.
+		DenoiserImage GISH, GICoCg;
+
+		// a near and a far plane meeting at x = 70, facing up above y = 40 and the camera below. noisy gi
+		// over a darker history, moving half a texel to the left, with no history around the edge.
+		Scene(bool bConstant)
+		{
+			for (DenoiserImage* Img : { &Depth, &Normal, &Velocity, &RoughnessMetallic, &SH, &CoCg, &Specular, &PrevSH, &PrevCoCg, &PrevSpecular })
+				Img->Init(kWidth, kHeight, true);
+			Depth.bHalf = false;
+			PrevDepth.Init(kWidth, kHeight, false);
+			GISH.Init(kGIWidth, kGIHeight, true);
+			GICoCg.Init(kGIWidth, kGIHeight, true);
+
+			for (uint32_t y = 0; y < kHeight; y++)
+			{
+				for (uint32_t x = 0; x < kWidth; x++)
+				{
+					if (bConstant)
+					{
+						Depth.Store(x, y, glm::vec4(0.95f, 0, 0, 0));
+						Normal.Store(x, y, glm::vec4(0, 1, 0, 0));
+						SH.Store(x, y, glm::vec4(0.25f, 0.125f, 0.5f, 0.75f));
+						CoCg.Store(x, y, glm::vec4(0.125f, 0.25f, 0, 0));
+						Specular.Store(x, y, glm::vec4(0.5f, 0.375f, 0.25f, 1.f));
+						RoughnessMetallic.Store(x, y, glm::vec4(0.5f, 0, 0, 0));
+						continue;
+					}
+
+					Depth.Store(x, y, glm::vec4(x < 70 ? 0.95f : 0.99f, 0, 0, 0));
+					PrevDepth.Store(x, y, glm::vec4(x >= 60 && x < 80 ? 0.5f : Depth.Load(x, y).x, 0, 0, 0));
+					Normal.Store(x, y, y < 40 ? glm::vec4(0, 1, 0, 0) : glm::vec4(0, 0, -1, 0));
+					Velocity.Store(x, y, glm::vec4(0.5f / kWidth, 0, 0, 0));
+					RoughnessMetallic.Store(x, y, glm::vec4(float(x) / kWidth, 0, 0, 0));
+					SH.Store(x, y, glm::vec4(Noise(x, y, 0) - 0.5f, Noise(x, y, 1) - 0.5f, Noise(x, y, 2) - 0.5f, Noise(x, y, 3)));
+					CoCg.Store(x, y, glm::vec4(Noise(x, y, 4) * 0.5f - 0.25f, Noise(x, y, 5) * 0.5f - 0.25f, 0, 0));
+					// brighter on the far plane, what the blur leaks over the edge shows.
+					const float SpecularBase = x < 70 ? 0.f : 0.5f;
+					Specular.Store(x, y, glm::vec4(SpecularBase + 0.5f * glm::vec3(Noise(x, y, 6), Noise(x, y, 7), Noise(x, y, 8)), 1.f));
+					PrevSH.Store(x, y, glm::vec4(0, 0, 0, 0.3f));
+					PrevCoCg.Store(x, y, glm::vec4(0.1f, -0.1f, 0, 0));
+					// a short history on the right, the blur ignores it.
+					PrevSpecular.Store(x, y, glm::vec4(0.2f, 0.2f, 0.2f, x < 90 ? 0.7f : 0.2f));
+				}
+			}
+			if (bConstant)
+			{
+				PrevDepth = Depth;
+				PrevSH = SH;
+				PrevCoCg = CoCg;
+				PrevSpecular = Specular;
+			}
+
+			for (uint32_t y = 0; y < kGIHeight; y++)
+			{
+				for (uint32_t x = 0; x < kGIWidth; x++)
+				{
+					GISH.Store(x, y, SH.Load(x * kGIBufferScale + 1, y * kGIBufferScale + 1));
+					GICoCg.Store(x, y, CoCg.Load(x * kGIBufferScale + 1, y * kGIBufferScale + 1));
+				}
+			}
+		}
+	};
+
+	struct TemporalResult
+	{
+		DenoiserImage SH, CoCg, SHDS, CoCgDS, Specular;
+	};
+
+	TemporalResult RunTemporal(const Scene& S, enki::TaskScheduler* TS = nullptr)
+	{
+		TemporalFilterInputs In;
+		In.Depth = &S.Depth;
+		In.Normal = &S.Normal;
+		In.SH = &S.SH;
+		In.CoCg = &S.CoCg;
+		In.PrevSH = &S.PrevSH;
+		In.PrevCoCg = &S.PrevCoCg;
+		In.Velocity = &S.Velocity;
+		In.Specular = &S.Specular;
+		In.PrevSpecular = &S.PrevSpecular;
+		In.RoughnessMetallic = &S.RoughnessMetallic;
+		In.PrevDepth = &S.PrevDepth;
+		In.PrevNormal = &S.Normal;
+
+		TemporalResult Result;
+		for (DenoiserImage* Img : { &Result.SH, &Result.CoCg, &Result.SHDS, &Result.CoCgDS, &Result.Specular })
+			Img->bHalf = true;
+		TemporalFilterOutputs Out;
+		Out.SH = &Result.SH;
+		Out.CoCg = &Result.CoCg;
+		Out.SHDS = &Result.SHDS;
+		Out.CoCgDS = &Result.CoCgDS;
+		Out.Specular = &Result.Specular;
+
+		TemporalFilterConstant CB = {};
+		CB.InvViewMatrix = glm::mat4x4(1.f);
+		CB.InvProjMatrix = glm::inverse(glm::perspective(glm::radians(60.f), float(kWidth) / kHeight, kNear, kFar));
+		CB.ProjectionParams = glm::vec4(0, 0, kNear, kFar);
+		CB.RTSize = glm::vec2(kWidth, kHeight);
+		CB.FrameIndex = 5;
+		TemporalFilterCPU(CB, In, Out, TS);
+		return Result;
+	}
+
+	// the result ends up in SH[0], CoCg[0].
+	void RunSpatial(const Scene& S, DenoiserImage SH[2], DenoiserImage CoCg[2], enki::TaskScheduler* TS = nullptr)
+	{
+		SH[0] = S.GISH;
+		CoCg[0] = S.GICoCg;
+		SH[1].bHalf = CoCg[1].bHalf = true;
+
+		SpatialFilterConstant CB = {};
+		CB.ProjectionParams = glm::vec4(0, 0, kNear, kFar);
+		CB.GIBufferScale = kGIBufferScale;
+		SpatialDenoiseCPU(CB, S.Depth, S.Normal, SH, CoCg, TS);
+	}
+
+	// texels in [x0, x1) x [y0, y1) further than Eps from Expected.
+	int CountDifferent(const DenoiserImage& Img, const glm::vec4& Expected, uint32_t x0, uint32_t x1, uint32_t y0, uint32_t y1, float Eps = 1e-3f)
+	{
+		int Num = 0;
+		for (uint32_t y = y0; y < y1; y++)
+			for (uint32_t x = x0; x < x1; x++)
+			{
+				const glm::vec4 Diff = glm::abs(Img.Load(int32_t(x), int32_t(y)) - Expected);
+				if (std::max(std::max(Diff.x, Diff.y), std::max(Diff.z, Diff.w)) > Eps)
+					Num++;
+			}
+		return Num;
+	}
+
+	uint8_t Encode(float Value)
+	{
+		return uint8_t(glm::clamp(Value, 0.f, 1.f) * 255.f + 0.5f);
+	}
+
+	// luma and chroma of the gi.
+	std::vector<uint8_t> EncodeGI(const DenoiserImage& SH, const DenoiserImage& CoCg)
+	{
+		std::vector<uint8_t> Encoded;
+		for (size_t i = 0; i < SH.Texels.size(); i++)
+		{
+			Encoded.push_back(Encode(SH.Texels[i].w));
+			Encoded.push_back(Encode(CoCg.Texels[i].x + 0.5f));
+			Encoded.push_back(Encode(CoCg.Texels[i].y + 0.5f));
+		}
+		return Encoded;
+	}
+
+	std::vector<uint8_t> EncodeColor(const DenoiserImage& Img)
+	{
+		std::vector<uint8_t> Encoded;
+		for (const glm::vec4& Texel : Img.Texels)
+			for (int c = 0; c < 3; c++)
+				Encoded.push_back(Encode(Texel[c]));
+		return Encoded;
+	}
+
+	// the largest difference in 8 bit steps, -1 when the golden can't be read.
+	int CompareToGolden(const std::vector<uint8_t>& Encoded, uint32_t Width, uint32_t Height, const char* Name)
+	{
+		const std::string Path = std::string(CORONA_TEST_GOLDEN_DIR) + "/" + Name + ".ppm";
+		const std::string Header = "P6\n" + std::to_string(Width) + " " + std::to_string(Height) + "\n255\n";
+
+		const char* Update = std::getenv("CORONA_UPDATE_GOLDEN");
+		if (Update && Update[0] == '1')
+		{
+			std::ofstream File(Path, std::ios::binary);
+			File << Header;
+			File.write(reinterpret_cast<const char*>(Encoded.data()), Encoded.size());
+		}
+
+		std::ifstream File(Path, std::ios::binary);
+		std::string FileHeader(Header.size(), '\0');
+		std::vector<uint8_t> Golden(Encoded.size());
+		File.read(&FileHeader[0], FileHeader.size());
+		File.read(reinterpret_cast<char*>(Golden.data()), Golden.size());
+		if (!File || FileHeader != Header)
+			return -1;
+
+		int MaxDiff = 0;
+		for (size_t i = 0; i < Golden.size(); i++)
+			MaxDiff = std::max(MaxDiff, std::abs(int(Golden[i]) - int(Encoded[i])));
+		if (MaxDiff != 0)
+			std::printf("  %s: %d steps off\n", Path.c_str(), MaxDiff);
+		return MaxDiff;
+	}
+}
+
+TEST_CASE(ConstantInputStaysConstant)
+{
+	const Scene S(true);
+
+	// the history equals the current frame, every blend and blur gives it back. positive, the blend
+	// clamps at 0.
+	const TemporalResult T = RunTemporal(S);
+	const uint32_t CoverX = 120, CoverY = 60;
+	CHECK_EQ(CountDifferent(T.SH, S.SH.Texels[0], 0, CoverX, 0, CoverY), 0);
+	CHECK_EQ(CountDifferent(T.CoCg, S.CoCg.Texels[0], 0, CoverX, 0, CoverY), 0);
+	CHECK_EQ(CountDifferent(T.SHDS, S.SH.Texels[0], 0, CoverX / 3, 0, CoverY / 3), 0);
+	CHECK_EQ(CountDifferent(T.CoCgDS, S.CoCg.Texels[0], 0, CoverX / 3, 0, CoverY / 3), 0);
+	// the specular history grows by 0.1 a frame.
+	CHECK_EQ(CountDifferent(T.Specular, glm::vec4(0.5f, 0.375f, 0.25f, 1.1f), 0, CoverX, 0, CoverY), 0);
+	// rows past the last full group aren't written.
+	CHECK_EQ(CountDifferent(T.SH, glm::vec4(0.f), 0, kWidth, CoverY, kHeight), 0);
+
+	// the texels whose 4 wavelet steps stay inside the written texels, outside loads return 0 like on
+	// the gpu and the ping pong buffer is only written where the dispatch covers it.
+	DenoiserImage SH[2], CoCg[2];
+	RunSpatial(S, SH, CoCg);
+	const uint32_t Margin = 8, SpatialCoverX = 32;
+	CHECK_EQ(CountDifferent(SH[0], S.GISH.Texels[0], Margin, SpatialCoverX - Margin, Margin, kGIHeight - Margin), 0);
+	CHECK_EQ(CountDifferent(CoCg[0], S.GICoCg.Texels[0], Margin, SpatialCoverX - Margin, Margin, kGIHeight - Margin), 0);
+	// the columns past the last full group keep the input.
+	CHECK(SH[0].Load(SpatialCoverX, 3) == S.GISH.Load(SpatialCoverX, 3));
+	CHECK(SH[0].Load(kGIWidth - 1, kGIHeight - 1) == S.GISH.Load(kGIWidth - 1, kGIHeight - 1));
+}
+
+TEST_CASE(ThreadsDontChangeTheResult)
+{
+	enki::TaskScheduler TS;
+	TS.Initialize(4);
+	const Scene S(false);
+
+	const TemporalResult Serial = RunTemporal(S);
+	const TemporalResult Parallel = RunTemporal(S, &TS);
+	CHECK(Serial.SH.Texels == Parallel.SH.Texels);
+	CHECK(Serial.CoCg.Texels == Parallel.CoCg.Texels);
+	CHECK(Serial.SHDS.Texels == Parallel.SHDS.Texels);
+	CHECK(Serial.CoCgDS.Texels == Parallel.CoCgDS.Texels);
+	CHECK(Serial.Specular.Texels == Parallel.Specular.Texels);
+
+	DenoiserImage SerialSH[2], SerialCoCg[2], ParallelSH[2], ParallelCoCg[2];
+	RunSpatial(S, SerialSH, SerialCoCg);
+	RunSpatial(S, ParallelSH, ParallelCoCg, &TS);
+	CHECK(SerialSH[0].Texels == ParallelSH[0].Texels);
+	CHECK(SerialCoCg[0].Texels == ParallelCoCg[0].Texels);
+}
+
+TEST_CASE(MatchesGoldenImages)
+{
+	const Scene S(false);
+
+	const TemporalResult T = RunTemporal(S);
+	const int TemporalDiff = CompareToGolden(EncodeGI(T.SH, T.CoCg), kWidth, kHeight, "GIDenoiser_Temporal");
+	CHECK(TemporalDiff >= 0 && TemporalDiff <= 1);
+	const int SpecularDiff = CompareToGolden(EncodeColor(T.Specular), kWidth, kHeight, "GIDenoiser_TemporalSpecular");
+	CHECK(SpecularDiff >= 0 && SpecularDiff <= 1);
+	const int DownsampleDiff = CompareToGolden(EncodeGI(T.SHDS, T.CoCgDS), kGIWidth, kGIHeight, "GIDenoiser_TemporalDownsample");
+	CHECK(DownsampleDiff >= 0 && DownsampleDiff <= 1);
+
+	DenoiserImage SH[2], CoCg[2];
+	RunSpatial(S, SH, CoCg);
+	const int SpatialDiff = CompareToGolden(EncodeGI(SH[0], CoCg[0]), kGIWidth, kGIHeight, "GIDenoiser_Spatial");
+	CHECK(SpatialDiff >= 0 && SpatialDiff <= 1);
+}
@@ -0,0 +1,195 @@
+#include "TestFramework.h"
+#include "GPUDrivenScene.h"
+
+#include <cstdio>
+
+// the draw checks of GPUDrivenSceneBuilder::Validate and the cpu version of the cull and compaction pass.
+namespace
+{
+	const uint32_t kNumVertices = 100;
+	const uint32_t kNumIndices = 300;
+
+	// one mesh of kNumVertices vertices and kNumIndices indices and two materials.
+	void MakeScene(GPUDrivenSceneBuilder& Builder)
+	{
+		uint32_t BaseVertex, StartIndex;
+		Builder.AddGeometry(kNumVertices, kNumIndices, BaseVertex, StartIndex);
+		Builder.AddMaterial();
+		Builder.AddMaterial();
+	}
+
+	GPUDrawData MakeDrawData(uint32_t MaterialIndex, uint32_t SceneIndex)
+	{
+		GPUDrawData Data = {};
+		Data.InstanceIndex = 0;
+		Data.MaterialIndex = MaterialIndex;
+		Data.SceneIndex = SceneIndex;
+		return Data;
+	}
+
+	// a valid draw, then the one under test as draw 1.
+	std::string ValidateDraw(const GPUDrawData& Data, const glm::vec3& Min, const glm::vec3& Max, uint32_t IndexCount, uint32_t StartIndex, int32_t BaseVertex)
+	{
+		GPUDrivenSceneBuilder Builder;
+		MakeScene(Builder);
+		Builder.AddDraw(MakeDrawData(0, 0), glm::vec3(-1.f), glm::vec3(1.f), 3, 0, 0);
+		Builder.AddDraw(Data, Min, Max, IndexCount, StartIndex, BaseVertex);
+
+		std::string Error;
+		if (Builder.Validate(&Error))
+			return "";
+		return Error;
+	}
+
+	bool IsError(const std::string& Error, const char* Expected)
+	{
+		if (Error != Expected)
+			std::printf("  got \"%s\", expected \"%s\"\n", Error.c_str(), Expected);
+		return Error == Expected;
+	}
+
+	// the six planes of the box from -1 to 1, pointing inwards.
+	GPUDrivenCullCB MakeUnitBoxCB(uint32_t NumDraws)
+	{
+		GPUDrivenCullCB CB = {};
+		CB.Planes[0] = glm::vec4(1.f, 0.f, 0.f, 1.f);
+		CB.Planes[1] = glm::vec4(-1.f, 0.f, 0.f, 1.f);
+		CB.Planes[2] = glm::vec4(0.f, 1.f, 0.f, 1.f);
+		CB.Planes[3] = glm::vec4(0.f, -1.f, 0.f, 1.f);
+		CB.Planes[4] = glm::vec4(0.f, 0.f, 1.f, 1.f);
+		CB.Planes[5] = glm::vec4(0.f, 0.f, -1.f, 1.f);
+		CB.NumDraws = NumDraws;
+		CB.bFrustumCulling = 1;
+		return CB;
+	}
+}
+
+TEST_CASE(ValidScene)
+{
+	GPUDrivenSceneBuilder Builder;
+	MakeScene(Builder);
+
+	uint32_t BaseVertex, StartIndex;
+	Builder.AddGeometry(50, 30, BaseVertex, StartIndex);
+	CHECK_EQ(BaseVertex, kNumVertices);
+	CHECK_EQ(StartIndex, kNumIndices);
+	CHECK_EQ(Builder.GetNumVertices(), kNumVertices + 50);
+	CHECK_EQ(Builder.GetNumIndices(), kNumIndices + 30);
+
+	CHECK_EQ(Builder.AddDraw(MakeDrawData(0, 0), glm::vec3(-1.f), glm::vec3(1.f), kNumIndices, 0, 0), 0);
+	CHECK_EQ(Builder.AddDraw(MakeDrawData(1, kMaxGPUDrivenScenes - 1), glm::vec3(2.f), glm::vec3(2.f), 30, StartIndex, int32_t(BaseVertex)), 1);
+	CHECK_EQ(Builder.GetNumDraws(), 2);
+	CHECK_EQ(Builder.GetRecords()[1].DrawID, 1);
+	CHECK_EQ(Builder.GetRecords()[1].StartIndex, kNumIndices);
+	CHECK_EQ(Builder.GetDrawData()[1].MaterialIndex, 1);
+
+	std::string Error;
+	CHECK(Builder.Validate(&Error));
+	CHECK(Error.empty());
+	CHECK(Builder.Validate(nullptr));
+
+	// the geometry stays, the draws and materials go.
+	Builder.ClearDraws();
+	CHECK_EQ(Builder.GetNumDraws(), 0);
+	CHECK_EQ(Builder.GetNumMaterials(), 0);
+	CHECK_EQ(Builder.GetNumIndices(), kNumIndices + 30);
+	CHECK_EQ(Builder.AddMaterial(), 0);
+}
+
+TEST_CASE(ValidateFailures)
+{
+	const glm::vec3 Min(-1.f), Max(1.f);
+	const GPUDrawData Data = MakeDrawData(1, 1);
+
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 3, kNumIndices - 3, kNumVertices - 1), ""));
+
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 0, 0, 0), "draw 1: index count is not a whole number of triangles"));
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 4, 0, 0), "draw 1: index count is not a whole number of triangles"));
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 6, kNumIndices - 3, 0), "draw 1: index range is outside the merged index buffer"));
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 3, 0xFFFFFFFFu, 0), "draw 1: index range is outside the merged index buffer"));
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 3, 0, -1), "draw 1: base vertex is outside the merged vertex buffer"));
+	CHECK(IsError(ValidateDraw(Data, Min, Max, 3, 0, kNumVertices), "draw 1: base vertex is outside the merged vertex buffer"));
+	CHECK(IsError(ValidateDraw(Data, glm::vec3(-1.f, 2.f, -1.f), Max, 3, 0, 0), "draw 1: bounds are inverted"));
+	CHECK(IsError(ValidateDraw(MakeDrawData(2, 0), Min, Max, 3, 0, 0), "draw 1: material index was not added"));
+	CHECK(IsError(ValidateDraw(MakeDrawData(0, kMaxGPUDrivenScenes), Min, Max, 3, 0, 0), "draw 1: scene index is outside of the scene constants"));
+
+	// a flat box is fine.
+	CHECK(IsError(ValidateDraw(Data, glm::vec3(-1.f, 0.f, -1.f), glm::vec3(1.f, 0.f, 1.f), 3, 0, 0), ""));
+
+	// the texture table holds kMaxGPUDrivenMaterials.
+	GPUDrivenSceneBuilder Builder;
+	MakeScene(Builder);
+	while (Builder.GetNumMaterials() < kMaxGPUDrivenMaterials)
+		Builder.AddMaterial();
+	CHECK(Builder.Validate(nullptr));
+	Builder.AddMaterial();
+	std::string Error;
+	CHECK(!Builder.Validate(&Error));
+	CHECK(IsError(Error, "draw 0: more materials than the texture table holds"));
+}
+
+TEST_CASE(CullAndCompact)
+{
+	GPUDrivenSceneBuilder Builder;
+	MakeScene(Builder);
+
+	// inside, beyond +x, across +y, beyond -z, around the box, touching the +x plane.
+	const struct { glm::vec3 Min, Max; bool bVisible; } Boxes[] = {
+		{ glm::vec3(-0.5f), glm::vec3(0.5f), true },
+		{ glm::vec3(1.5f, -0.5f, -0.5f), glm::vec3(2.f, 0.5f, 0.5f), false },
+		{ glm::vec3(-0.5f, 0.5f, -0.5f), glm::vec3(0.5f, 3.f, 0.5f), true },
+		{ glm::vec3(-0.5f, -0.5f, -3.f), glm::vec3(0.5f, 0.5f, -1.01f), false },
+		{ glm::vec3(-5.f), glm::vec3(5.f), true },
+		{ glm::vec3(1.f, -0.5f, -0.5f), glm::vec3(2.f, 0.5f, 0.5f), true },
+	};
+	uint32_t NumExpected = 0;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		Builder.AddDraw(MakeDrawData(i % 2, 0), Boxes[i].Min, Boxes[i].Max, 3 * (i + 1), 3 * i, int32_t(i));
+		NumExpected += Boxes[i].bVisible;
+	}
+	CHECK(Builder.Validate(nullptr));
+	const std::vector<GPUDrawRecord>& Records = Builder.GetRecords();
+
+	std::vector<GPUDrawCommand> Commands;
+	GPUDrivenCullCB CB = MakeUnitBoxCB(Builder.GetNumDraws());
+	const uint32_t NumVisible = CullAndCompactDrawsCPU(CB, Records, Commands);
+	CHECK_EQ(NumVisible, NumExpected);
+	CHECK_EQ(Commands.size(), size_t(NumVisible));
+
+	// compacted in record order, the command copies the ranges of its record.
+	uint32_t Next = 0;
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		if (!Boxes[i].bVisible)
+			continue;
+		if (Next >= Commands.size())
+			break;
+		const GPUDrawCommand& Command = Commands[Next++];
+		if (Command.DrawID != i)
+			std::printf("  command %u is draw %u, expected %u\n", Next - 1, Command.DrawID, i);
+		CHECK_EQ(Command.DrawID, i);
+		CHECK_EQ(Command.IndexCountPerInstance, 3 * (i + 1));
+		CHECK_EQ(Command.InstanceCount, 1);
+		CHECK_EQ(Command.StartIndexLocation, 3 * i);
+		CHECK_EQ(Command.BaseVertexLocation, int32_t(i));
+		CHECK_EQ(Command.StartInstanceLocation, 0);
+	}
+
+	// without frustum culling every draw survives.
+	CB.bFrustumCulling = 0;
+	CHECK_EQ(CullAndCompactDrawsCPU(CB, Records, Commands), 6);
+	for (uint32_t i = 0; i < Commands.size(); i++)
+		CHECK_EQ(Commands[i].DrawID, i);
+
+	// only the first NumDraws records are tested, more than there are is clamped.
+	CB.bFrustumCulling = 1;
+	CB.NumDraws = 2;
+	CHECK_EQ(CullAndCompactDrawsCPU(CB, Records, Commands), 1);
+	CHECK_EQ(Commands[0].DrawID, 0);
+	CB.NumDraws = 1000;
+	CHECK_EQ(CullAndCompactDrawsCPU(CB, Records, Commands), NumExpected);
+	CB.NumDraws = 0;
+	CHECK_EQ(CullAndCompactDrawsCPU(CB, Records, Commands), 0);
+	CHECK(Commands.empty());
+}
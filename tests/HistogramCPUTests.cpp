@@ -0,0 +1,238 @@
+#include "TestFramework.h"
+#include "HistogramCPU.h"
+
+#include <cmath>
+#include <numeric>
+
+// the cpu reference of the luma histogram and the exposure adaptation: quantization at the ends of the bin
+// range, histograms of images that don't fill the last 16x64 tile, and exposure converging to the target
+// over a frame sequence.
+namespace
+{
+	// Corona::kInitialMinLog and kInitialMaxLog.
+	const float kMinLog = -12.f;
+	const float kMaxLog = 4.f;
+
+	// GenerateHistogram in Histogram.hlsl, one 16x16 group per 16x64 tile over the dispatch of
+	// Corona::GenerateHistogram.
+	void GenerateHistogramTiles(const uint8_t* Luma, uint32_t Width, uint32_t Height, uint32_t RowPitch, uint32_t Histogram[kHistogramBinCount])
+	{
+		std::fill(Histogram, Histogram + kHistogramBinCount, 0);
+		const uint32_t GroupsX = (Width + 15) / 16;
+		const uint32_t GroupsY = (Height + 63) / 64;
+		for (uint32_t GroupY = 0; GroupY < GroupsY; GroupY++)
+			for (uint32_t GroupX = 0; GroupX < GroupsX; GroupX++)
+				for (uint32_t ThreadY = 0; ThreadY < 16; ThreadY++)
+					for (uint32_t ThreadX = 0; ThreadX < 16; ThreadX++)
+						for (uint32_t i = 0; i < 4; i++)
+						{
+							const uint32_t x = GroupX * 16 + ThreadX;
+							const uint32_t y = GroupY * 64 + ThreadY + i * 16;
+							if (x < Width && y < Height)
+								Histogram[Luma[size_t(y) * RowPitch + x]]++;
+						}
+	}
+
+	// the quantized luma of a frame.
+	struct Frame
+	{
+		uint32_t Width, Height;
+		std::vector<uint8_t> Luma;
+
+		Frame(uint32_t InWidth, uint32_t InHeight) : Width(InWidth), Height(InHeight), Luma(size_t(InWidth) * InHeight) {}
+
+		// BloomExtract with the current bin range of ExposureData, Lit(x, y) gives the luma of a texel.
+		template<typename L>
+		void Extract(const float ExposureData[kExposureDataCount], L&& Lit)
+		{
+			for (uint32_t y = 0; y < Height; y++)
+				for (uint32_t x = 0; x < Width; x++)
+					Luma[size_t(y) * Width + x] = QuantizeLogLuma(Lit(x, y), ExposureData[4], ExposureData[7]);
+		}
+	};
+
+	AdaptExposureCB MakeCB(uint32_t PixelCount)
+	{
+		AdaptExposureCB CB;
+		CB.PixelCount = PixelCount;
+		CB.ResetMinLog = kMinLog;
+		CB.ResetMaxLog = kMaxLog;
+		return CB;
+	}
+
+	// runs NumFrames of histogram and adaptation over the frame Lit describes.
+	template<typename L>
+	void RunFrames(int NumFrames, const AdaptExposureCB& CB, Frame& F, float ExposureData[kExposureDataCount], L&& Lit)
+	{
+		uint32_t Histogram[kHistogramBinCount];
+		for (int i = 0; i < NumFrames; i++)
+		{
+			F.Extract(ExposureData, Lit);
+			GenerateHistogramCPU(F.Luma.data(), F.Width, F.Height, F.Width, Histogram);
+			AdaptExposureCPU(CB, Histogram, ExposureData);
+		}
+	}
+}
+
+TEST_CASE(QuantizeLogLumaRangeEnds)
+{
+	const float RcpLogRange = 1.f / (kMaxLog - kMinLog);
+
+	// black has a bin of its own, everything else lands in [1, 255].
+	CHECK_EQ(QuantizeLogLuma(0.f, kMinLog, RcpLogRange), 0);
+	CHECK_EQ(QuantizeLogLuma(std::exp2(kMinLog), kMinLog, RcpLogRange), 1);
+	CHECK_EQ(QuantizeLogLuma(std::exp2(kMinLog - 10.f), kMinLog, RcpLogRange), 1);
+	CHECK_EQ(QuantizeLogLuma(1e-30f, kMinLog, RcpLogRange), 1);
+	CHECK_EQ(QuantizeLogLuma(std::exp2(kMaxLog), kMinLog, RcpLogRange), 255);
+	CHECK_EQ(QuantizeLogLuma(std::exp2(kMaxLog + 10.f), kMinLog, RcpLogRange), 255);
+	CHECK_EQ(QuantizeLogLuma(1e30f, kMinLog, RcpLogRange), 255);
+
+	// the middle of the range, and one bin is LogRange / 254 wide.
+	CHECK_EQ(QuantizeLogLuma(std::exp2(0.5f * (kMinLog + kMaxLog)), kMinLog, RcpLogRange), 128);
+	const float BinLog = (kMaxLog - kMinLog) / 254.f;
+	CHECK_EQ(QuantizeLogLuma(std::exp2(kMinLog + 10.5f * BinLog), kMinLog, RcpLogRange), 11);
+
+	// bins never go down as luma goes up.
+	int NumOutOfOrder = 0;
+	uint8_t Last = 0;
+	for (float Log = kMinLog - 1.f; Log < kMaxLog + 1.f; Log += 0.01f)
+	{
+		const uint8_t Bin = QuantizeLogLuma(std::exp2(Log), kMinLog, RcpLogRange);
+		NumOutOfOrder += Bin < Last;
+		Last = Bin;
+	}
+	CHECK_EQ(NumOutOfOrder, 0);
+}
+
+TEST_CASE(HistogramAtAnyResolution)
+{
+	// sizes around the 16x64 tile and the bloom buffers of 720p and 1080p, rows padded to 256 bytes
+	// like a readback of the luma texture.
+	const struct { uint32_t Width, Height; } Sizes[] = {
+		{ 1, 1 }, { 15, 63 }, { 16, 64 }, { 17, 65 }, { 33, 130 }, { 100, 7 }, { 427, 240 }, { 640, 384 },
+	};
+	for (const auto& Size : Sizes)
+	{
+		const uint32_t RowPitch = (Size.Width + 255) / 256 * 256;
+		// the padding would land in bin 200 if it was read.
+		std::vector<uint8_t> Luma(size_t(RowPitch) * Size.Height, 200);
+		for (uint32_t y = 0; y < Size.Height; y++)
+			for (uint32_t x = 0; x < Size.Width; x++)
+				Luma[size_t(y) * RowPitch + x] = uint8_t((x * 7 + y * 13) % 199);
+
+		uint32_t Histogram[kHistogramBinCount], Tiles[kHistogramBinCount];
+		GenerateHistogramCPU(Luma.data(), Size.Width, Size.Height, RowPitch, Histogram);
+		GenerateHistogramTiles(Luma.data(), Size.Width, Size.Height, RowPitch, Tiles);
+
+		CHECK_EQ(std::accumulate(Histogram, Histogram + kHistogramBinCount, 0ull), uint64_t(Size.Width) * Size.Height);
+		CHECK(std::equal(Histogram, Histogram + kHistogramBinCount, Tiles));
+		CHECK_EQ(Histogram[200], 0);
+	}
+
+	// cleared before counting.
+	uint32_t Histogram[kHistogramBinCount];
+	std::fill(Histogram, Histogram + kHistogramBinCount, 7u);
+	const uint8_t One[1] = { 42 };
+	GenerateHistogramCPU(One, 1, 1, 1, Histogram);
+	CHECK_EQ(Histogram[42], 1);
+	CHECK_EQ(std::accumulate(Histogram, Histogram + kHistogramBinCount, 0u), 1);
+}
+
+TEST_CASE(ExposureConvergesToTheTarget)
+{
+	// a tenth of the frame is black and doesn't count, the rest is luma L.
+	const uint32_t Width = 160, Height = 90;
+	const AdaptExposureCB CB = MakeCB(Width * Height);
+	for (float L : { 0.01f, 0.18f, 2.f })
+	{
+		float ExposureData[kExposureDataCount];
+		InitExposureData(1.f, kMinLog, kMaxLog, ExposureData);
+		Frame F(Width, Height);
+		RunFrames(300, CB, F, ExposureData, [&](uint32_t x, uint32_t) { return x < Width / 10 ? 0.f : L; });
+
+		// within the quantization of one bin of the target.
+		const float BinLog = (kMaxLog - kMinLog) / 254.f;
+		CHECK(std::fabs(std::log2(ExposureData[0] * L / CB.TargetLuminance)) <= BinLog);
+		CHECK_EQ(ExposureData[1], 1.f / ExposureData[0]);
+		CHECK_EQ(ExposureData[2], ExposureData[0]);
+	}
+
+	// half at L1, half at L2: the log average.
+	{
+		const float L1 = 0.02f, L2 = 0.5f;
+		float ExposureData[kExposureDataCount];
+		InitExposureData(1.f, kMinLog, kMaxLog, ExposureData);
+		Frame F(Width, Height);
+		RunFrames(300, CB, F, ExposureData, [&](uint32_t x, uint32_t) { return x < Width / 2 ? L1 : L2; });
+		CHECK(std::fabs(std::log2(ExposureData[0] * std::sqrt(L1 * L2) / CB.TargetLuminance)) <= (kMaxLog - kMinLog) / 254.f);
+	}
+
+	// every frame moves AdaptationRate of the way, a dark scene stops at MaxExposure.
+	{
+		float ExposureData[kExposureDataCount];
+		InitExposureData(1.f, kMinLog, kMaxLog, ExposureData);
+		Frame F(Width, Height);
+		RunFrames(1, CB, F, ExposureData, [](uint32_t, uint32_t) { return 0.3f; });
+		const float TargetExposure = CB.TargetLuminance / 0.3f;
+		CHECK_NEAR(ExposureData[0], 1.f + (TargetExposure - 1.f) * CB.AdaptationRate, 1e-3f);
+
+		RunFrames(300, CB, F, ExposureData, [](uint32_t, uint32_t) { return 1e-5f; });
+		CHECK_EQ(ExposureData[0], CB.MaxExposure);
+		RunFrames(300, CB, F, ExposureData, [](uint32_t, uint32_t) { return 1e4f; });
+		CHECK_EQ(ExposureData[0], CB.MinExposure);
+	}
+
+	// an all black frame keeps the exposure finite.
+	{
+		float ExposureData[kExposureDataCount];
+		InitExposureData(1.f, kMinLog, kMaxLog, ExposureData);
+		Frame F(Width, Height);
+		RunFrames(10, CB, F, ExposureData, [](uint32_t, uint32_t) { return 0.f; });
+		CHECK(std::isfinite(ExposureData[0]) && ExposureData[0] >= CB.MinExposure && ExposureData[0] <= CB.MaxExposure);
+	}
+}
+
+TEST_CASE(InitAndResetLogRange)
+{
+	float ExposureData[kExposureDataCount];
+	InitExposureData(2.f, kMinLog, kMaxLog, ExposureData);
+	const float Expected[kExposureDataCount] = { 2.f, 0.5f, 2.f, 0.f, kMinLog, kMaxLog, 16.f, 1.f / 16.f };
+	CHECK(std::equal(ExposureData, ExposureData + kExposureDataCount, Expected));
+
+	uint32_t Histogram[kHistogramBinCount] = {};
+	AdaptExposureCB CB = MakeCB(100);
+
+	// an average near the center bin keeps the range.
+	Histogram[129] = 100;
+	AdaptExposureCPU(CB, Histogram, ExposureData);
+	CHECK_EQ(ExposureData[3], 128.f);
+	CHECK_EQ(ExposureData[4], kMinLog);
+	CHECK_EQ(ExposureData[5], kMaxLog);
+
+	// a bright frame recenters, the range keeps its size.
+	Histogram[129] = 0;
+	Histogram[250] = 100;
+	AdaptExposureCPU(CB, Histogram, ExposureData);
+	CHECK(ExposureData[4] > kMinLog);
+	CHECK_NEAR(ExposureData[5] - ExposureData[4], 16.f, 1e-5f);
+	CHECK_EQ(ExposureData[6], 16.f);
+	const float RecenteredMinLog = ExposureData[4];
+
+	// a range from the ui replaces the recentered one for the next frame, whatever the frame looked like.
+	CB.ResetLogRange = 1;
+	CB.ResetMinLog = -8.f;
+	CB.ResetMaxLog = 2.f;
+	AdaptExposureCPU(CB, Histogram, ExposureData);
+	CHECK_EQ(ExposureData[4], -8.f);
+	CHECK_EQ(ExposureData[5], 2.f);
+	CHECK_EQ(ExposureData[6], 10.f);
+	CHECK_EQ(ExposureData[7], 0.1f);
+	CHECK(ExposureData[4] != RecenteredMinLog);
+
+	// the exposure still adapted on the reset frame, and the next frame recenters in the new range.
+	CHECK(ExposureData[0] < 2.f);
+	CB.ResetLogRange = 0;
+	AdaptExposureCPU(CB, Histogram, ExposureData);
+	CHECK(ExposureData[4] > -8.f);
+	CHECK_NEAR(ExposureData[5] - ExposureData[4], 10.f, 1e-5f);
+}
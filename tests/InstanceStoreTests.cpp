@@ -0,0 +1,131 @@
+#include "TestFramework.h"
+#include "InstanceStore.h"
+#include "SceneCulling.h"
+
+#include <cfloat>
+#include <cstring>
+#include <random>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// the instance transforms of the instanced shader balls, dirty tracking and the packed upload range.
+namespace
+{
+	glm::mat4 MakeTransform(std::mt19937& Rng)
+	{
+		std::uniform_real_distribution<float> Unit(-1.f, 1.f);
+		glm::mat4 Transform = glm::translate(glm::mat4(1.f), glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) * 500.f);
+		Transform = glm::rotate(Transform, Unit(Rng) * 3.f, glm::normalize(glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) + 0.01f));
+		return glm::scale(Transform, glm::vec3(1.5f + Unit(Rng), 2.f, 1.f));
+	}
+}
+
+TEST_CASE(InstanceRoundTrip)
+{
+	std::mt19937 Rng(1);
+	InstanceStore Store;
+	std::vector<glm::mat4> Transforms;
+	for (uint32_t i = 0; i < 100; i++)
+	{
+		Transforms.push_back(MakeTransform(Rng));
+		CHECK_EQ(Store.Add(Transforms.back()), i);
+	}
+	CHECK_EQ(Store.Size(), 100);
+
+	// the affine part is stored as is, the last row comes back as 0 0 0 1.
+	for (uint32_t i = 0; i < Store.Size(); i++)
+		CHECK(Store.Get(i) == Transforms[i]);
+
+	Store.Set(42, glm::mat4(1.f));
+	CHECK(Store.Get(42) == glm::mat4(1.f));
+	CHECK(Store.Get(41) == Transforms[41]);
+
+	Store.Clear();
+	CHECK_EQ(Store.Size(), 0);
+	CHECK_EQ(Store.GetNumDirty(), 0);
+}
+
+TEST_CASE(PackDirtyRange)
+{
+	std::mt19937 Rng(2);
+	InstanceStore Store;
+	for (uint32_t i = 0; i < 200; i++)
+		Store.Add(MakeTransform(Rng));
+	CHECK_EQ(Store.GetNumDirty(), 200);
+
+	// a gpu buffer with a larger stride than the matrix, like a per instance constant buffer.
+	const size_t Stride = 256;
+	std::vector<uint8_t> Buffer(Store.Size() * Stride, 0xcd);
+	uint32_t First, End;
+	Store.PackDirty(Buffer.data(), Stride, First, End);
+	CHECK_EQ(First, 0);
+	CHECK_EQ(End, 200);
+	CHECK_EQ(Store.GetNumDirty(), 0);
+	for (uint32_t i = 0; i < Store.Size(); i++)
+	{
+		glm::mat4 Packed;
+		memcpy(&Packed, &Buffer[i * Stride], sizeof(Packed));
+		CHECK(Packed == Store.Get(i));
+		CHECK_EQ(Buffer[i * Stride + sizeof(glm::mat4)], 0xcd);
+	}
+
+	// nothing changed, nothing to upload.
+	Store.PackDirty(Buffer.data(), Stride, First, End);
+	CHECK_EQ(First, End);
+
+	// two instances across word boundaries of the dirty bits, the range covers both.
+	Store.Set(70, glm::mat4(2.f));
+	Store.Set(130, glm::mat4(3.f));
+	Store.Set(70, glm::mat4(4.f));
+	CHECK_EQ(Store.GetNumDirty(), 2);
+	CHECK(Store.IsDirty(70) && Store.IsDirty(130) && !Store.IsDirty(71));
+
+	std::fill(Buffer.begin(), Buffer.end(), 0xcd);
+	Store.PackDirty(Buffer.data(), Stride, First, End);
+	CHECK_EQ(First, 70);
+	CHECK_EQ(End, 131);
+	CHECK_EQ(Buffer[69 * Stride], 0xcd);
+	CHECK_EQ(Buffer[131 * Stride], 0xcd);
+
+	glm::mat4 Packed;
+	memcpy(&Packed, &Buffer[70 * Stride], sizeof(Packed));
+	CHECK_NEAR(Packed[0][0], 4.f, 0.f);
+	CHECK_NEAR(Packed[3][3], 1.f, 0.f);
+	memcpy(&Packed, &Buffer[100 * Stride], sizeof(Packed));
+	CHECK(Packed == Store.Get(100));
+
+	Store.MarkAllDirty();
+	CHECK_EQ(Store.GetNumDirty(), Store.Size());
+}
+
+TEST_CASE(InstanceBoundsUnion)
+{
+	std::mt19937 Rng(3);
+	const glm::vec3 Min(-10.f, 0.f, -5.f);
+	const glm::vec3 Max(10.f, 30.f, 5.f);
+
+	// counts around the sse width so the scalar tail runs too.
+	for (uint32_t Count : { 1u, 3u, 4u, 7u, 64u, 1001u })
+	{
+		InstanceStore Store;
+		glm::vec3 ExpectedMin(FLT_MAX), ExpectedMax(-FLT_MAX);
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			const glm::mat4 Transform = MakeTransform(Rng);
+			Store.Add(Transform);
+
+			glm::vec3 BoxMin, BoxMax;
+			::TransformBounds(Transform, Min, Max, BoxMin, BoxMax);
+			ExpectedMin = glm::min(ExpectedMin, BoxMin);
+			ExpectedMax = glm::max(ExpectedMax, BoxMax);
+		}
+
+		glm::vec3 OutMin, OutMax;
+		Store.TransformBounds(Min, Max, OutMin, OutMax);
+		for (int Axis = 0; Axis < 3; Axis++)
+		{
+			CHECK_NEAR(OutMin[Axis], ExpectedMin[Axis], 1e-3f);
+			CHECK_NEAR(OutMax[Axis], ExpectedMax[Axis], 1e-3f);
+		}
+	}
+}
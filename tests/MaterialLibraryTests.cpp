@@ -0,0 +1,120 @@
+#include "TestFramework.h"
+#include "MaterialLibrary.h"
+
+#include <string>
+
+// the *.material parser on the shipped tables and on malformed input.
+TEST_CASE(LoadsShippedMaterials)
+{
+	const char* Files[] = { "Sponza/Sponza.material", "pistol/pistol.material", "sphere/sphere.material", "sphere/iblsphere.material" };
+	for (const char* File : Files)
+	{
+		MaterialLibrary Library;
+		std::string Error;
+		const bool bLoaded = Library.LoadFile(std::string(CORONA_TEST_DATA_DIR) + "/assets/" + File, Error);
+		if (!bLoaded)
+			std::printf("  %s\n", Error.c_str());
+		CHECK(bLoaded);
+		CHECK(!Library.GetMaterials().empty());
+	}
+}
+
+TEST_CASE(SponzaMaterials)
+{
+	MaterialLibrary Library;
+	std::string Error;
+	CHECK(Library.LoadFile(std::string(CORONA_TEST_DATA_DIR) + "/assets/Sponza/Sponza.material", Error));
+	CHECK_EQ(Library.GetMaterials().size(), 24);
+
+	const MaterialDesc* Chain = Library.Find("ChainTexture_Albedo");
+	CHECK(Chain && Chain->bAlphaTest && Chain->RoughnessMap == "ChainTexture_Roughness.png");
+
+	const MaterialDesc* Lion = Library.Find("Lion_Albedo");
+	CHECK(Lion && !Lion->bAlphaTest && !Lion->bTwoSided);
+
+	// the fbx refers to the albedo by a path of the exporter's machine.
+	CHECK(Library.FindByAlbedo("C:\\exports\\textures\\Lion_Albedo.png") == Lion);
+	CHECK(Library.FindByAlbedo("textures/Lion_Albedo.png") == Lion);
+	CHECK(Library.FindByAlbedo("Missing.png") == nullptr);
+
+	int NumAlphaTest = 0;
+	for (const MaterialDesc& Desc : Library.GetMaterials())
+		NumAlphaTest += Desc.bAlphaTest ? 1 : 0;
+	CHECK_EQ(NumAlphaTest, 3);
+}
+
+TEST_CASE(MaterialAttributes)
+{
+	const char* Text =
+		"<?xml version=\"1.0\"?>\n"
+		"<!-- a comment with <Material name=\"ignored\"/> in it -->\n"
+		"<Materials>\n"
+		"<Material name=\"metal &amp; wood\" AlbedoMap='a.dds' NormalMap=\"n.dds\" SpecularRMCMap=\"rmc.dds\"\n"
+		"  ShaderName=\"PBR\" TechniqueName=\"Default\" TwoSided=\"true\" AlphaTest=\"1\" TextureGamma=\"1.8\" Unknown=\"x\">\n"
+		"   <Pass name=\"color\"/>\n"
+		"   <Pass name=\"shadow\"/>\n"
+		"</Material>\n"
+		"</Materials>\n";
+
+	MaterialLibrary Library;
+	std::string Error;
+	CHECK(Library.LoadText(Text, Error));
+	CHECK_EQ(Library.GetMaterials().size(), 1);
+
+	const MaterialDesc* Desc = Library.Find("metal & wood");
+	CHECK(Desc != nullptr);
+	if (!Desc)
+		return;
+	CHECK(Desc->AlbedoMap == "a.dds" && Desc->NormalMap == "n.dds" && Desc->SpecularRMCMap == "rmc.dds");
+	CHECK(Desc->ShaderName == "PBR" && Desc->TechniqueName == "Default");
+	CHECK(Desc->bTwoSided && Desc->bAlphaTest);
+	CHECK_NEAR(Desc->TextureGamma, 1.8f, 1e-6f);
+	CHECK(Desc->Passes.size() == 2 && Desc->Passes[0] == "color" && Desc->Passes[1] == "shadow");
+	CHECK(Library.Find("ignored") == nullptr);
+}
+
+TEST_CASE(LaterMaterialReplaces)
+{
+	MaterialLibrary Library;
+	std::string Error;
+	CHECK(Library.LoadText("<Material name=\"a\" AlbedoMap=\"old.png\"/><Material name=\"b\" AlbedoMap=\"b.png\"/>", Error));
+	CHECK(Library.LoadText("<Material name=\"a\" AlbedoMap=\"new.png\" AlphaTest=\"True\"/>", Error));
+
+	CHECK_EQ(Library.GetMaterials().size(), 2);
+	CHECK(Library.Find("a")->bAlphaTest);
+	CHECK(Library.FindByAlbedo("new.png") == Library.Find("a"));
+	CHECK(Library.FindByAlbedo("old.png") == nullptr);
+	CHECK(Library.FindByAlbedo("b.png") == Library.Find("b"));
+
+	Library.Clear();
+	CHECK(Library.GetMaterials().empty());
+	CHECK(Library.Find("a") == nullptr);
+}
+
+TEST_CASE(MalformedMaterials)
+{
+	const char* Cases[] = {
+		"<Material name=\"a\">",
+		"</Material>",
+		"<Material name=\"a\"><Material name=\"b\"/></Material>",
+		"<Material AlbedoMap=\"a.png\"/>",
+		"<Pass name=\"color\"/>",
+		"<Material name=a/>",
+		"<Material name=\"a/>",
+		"<!-- unterminated",
+		"<Material name=\"a\"",
+	};
+
+	for (const char* Text : Cases)
+	{
+		MaterialLibrary Library;
+		std::string Error;
+		CHECK(!Library.LoadText(Text, Error));
+		CHECK(!Error.empty());
+	}
+
+	MaterialLibrary Library;
+	std::string Error;
+	CHECK(!Library.LoadFile(std::string(CORONA_TEST_DATA_DIR) + "/assets/missing.material", Error));
+	CHECK(Error.find("missing.material") != std::string::npos);
+}
@@ -0,0 +1,251 @@
+#include "TestFramework.h"
+#include "PipelineCache.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <map>
+
+// pipeline keys and the cache file across launches: a description seen before hits, a changed one or a
+// file of another device or version misses and the pipeline is built again.
+namespace
+{
+	std::string TempPath(const char* Name)
+	{
+		return (std::filesystem::temp_directory_path() / Name).string();
+	}
+
+	// the fields a backend hashes, the shader stands in for the bytecode blob.
+	struct FakePipelineDesc
+	{
+		const char* Shader;
+		uint32_t CullMode;
+		uint32_t NumRenderTargets;
+		float DepthBias;
+	};
+
+	uint64_t MakeKey(const FakePipelineDesc& Desc)
+	{
+		PipelineHasher Hasher;
+		Hasher.AddBlob(Desc.Shader, strlen(Desc.Shader));
+		Hasher.AddValue(Desc.CullMode);
+		Hasher.AddValue(Desc.NumRenderTargets);
+		Hasher.AddValue(Desc.DepthBias);
+		return Hasher.Get();
+	}
+
+	// what ID3D12PipelineLibrary does with the payload: compiled pipelines by key, a miss compiles and
+	// stores. serialized as u64 key, u64 size, bytes.
+	struct FakePipelineLibrary
+	{
+		std::map<uint64_t, std::vector<uint8_t>> Pipelines;
+		int NumHits = 0;
+		int NumMisses = 0;
+
+		void Load(const FakePipelineDesc& Desc)
+		{
+			const uint64_t Key = MakeKey(Desc);
+			if (Pipelines.count(Key))
+			{
+				NumHits++;
+				return;
+			}
+			NumMisses++;
+			Pipelines[Key] = std::vector<uint8_t>(Desc.Shader, Desc.Shader + strlen(Desc.Shader));
+		}
+
+		std::vector<uint8_t> Serialize() const
+		{
+			std::vector<uint8_t> Out;
+			for (auto& It : Pipelines)
+			{
+				const uint64_t Header[2] = { It.first, It.second.size() };
+				Out.insert(Out.end(), reinterpret_cast<const uint8_t*>(Header), reinterpret_cast<const uint8_t*>(Header + 2));
+				Out.insert(Out.end(), It.second.begin(), It.second.end());
+			}
+			return Out;
+		}
+
+		void Deserialize(const std::vector<uint8_t>& Data)
+		{
+			for (size_t Pos = 0; Pos + 16 <= Data.size();)
+			{
+				uint64_t Header[2];
+				memcpy(Header, &Data[Pos], sizeof(Header));
+				Pos += sizeof(Header);
+				Pipelines[Header[0]] = std::vector<uint8_t>(Data.begin() + Pos, Data.begin() + Pos + size_t(Header[1]));
+				Pos += size_t(Header[1]);
+			}
+		}
+	};
+
+	const FakePipelineDesc SceneDescs[] = {
+		{ "GBuffer", 2, 4, 0.f },
+		{ "Shadow", 1, 0, 1.5f },
+		{ "ToneMap", 0, 1, 0.f },
+	};
+
+	// one launch: read the cache, load every pipeline, save when something was built.
+	FakePipelineLibrary Launch(const std::string& Path, uint64_t DeviceId, const FakePipelineDesc* Descs, size_t NumDescs, std::string& Error)
+	{
+		FakePipelineLibrary Library;
+		std::vector<uint8_t> Data;
+		Error.clear();
+		if (ReadPipelineCacheFile(Path, DeviceId, Data, Error))
+			Library.Deserialize(Data);
+
+		for (size_t i = 0; i < NumDescs; i++)
+			Library.Load(Descs[i]);
+
+		if (Library.NumMisses)
+		{
+			const std::vector<uint8_t> Payload = Library.Serialize();
+			std::string WriteError;
+			CHECK(WritePipelineCacheFile(Path, DeviceId, Payload.data(), Payload.size(), WriteError));
+		}
+		return Library;
+	}
+}
+
+TEST_CASE(PipelineKeys)
+{
+	// fnv-1a 64 of nothing and of "a".
+	CHECK_EQ(PipelineHasher().Get(), 14695981039346656037ull);
+	PipelineHasher A;
+	A.AddBytes("a", 1);
+	CHECK_EQ(A.Get(), 0xaf63dc4c8601ec8cull);
+
+	// integers and floats as little endian bytes.
+	PipelineHasher Value, Bytes;
+	Value.AddValue(uint32_t(0x04030201));
+	const uint8_t LittleEndian[4] = { 1, 2, 3, 4 };
+	Bytes.AddBytes(LittleEndian, 4);
+	CHECK_EQ(Value.Get(), Bytes.Get());
+
+	PipelineHasher Float, FloatBytes;
+	Float.AddValue(1.0f);
+	const uint8_t One[4] = { 0x00, 0x00, 0x80, 0x3f };
+	FloatBytes.AddBytes(One, 4);
+	CHECK_EQ(Float.Get(), FloatBytes.Get());
+
+	// strings carry their length.
+	PipelineHasher AB_C, A_BC;
+	AB_C.AddString("ab");
+	AB_C.AddString("c");
+	A_BC.AddString("a");
+	A_BC.AddString("bc");
+	CHECK(AB_C.Get() != A_BC.Get());
+
+	// every field is part of the key.
+	const FakePipelineDesc Desc = SceneDescs[1];
+	CHECK_EQ(MakeKey(Desc), MakeKey(SceneDescs[1]));
+	FakePipelineDesc Changed = Desc;
+	Changed.CullMode = 2;
+	CHECK(MakeKey(Changed) != MakeKey(Desc));
+	Changed = Desc;
+	Changed.DepthBias = 1.25f;
+	CHECK(MakeKey(Changed) != MakeKey(Desc));
+	Changed = Desc;
+	Changed.Shader = "Shadox";
+	CHECK(MakeKey(Changed) != MakeKey(Desc));
+
+	CHECK(GetPipelineKeyName(0x0123456789abcdefull) == L"0123456789abcdef");
+	CHECK(GetPipelineKeyName(0xff) == L"00000000000000ff");
+}
+
+TEST_CASE(CacheHitsAcrossLaunches)
+{
+	const std::string Path = TempPath("corona_pipeline_cache_hits.bin");
+	std::remove(Path.c_str());
+	std::string Error;
+
+	// the first launch builds everything, the second finds everything.
+	FakePipelineLibrary First = Launch(Path, 7, SceneDescs, 3, Error);
+	CHECK_EQ(First.NumMisses, 3);
+	CHECK_EQ(First.NumHits, 0);
+	CHECK(Error.empty());
+
+	FakePipelineLibrary Second = Launch(Path, 7, SceneDescs, 3, Error);
+	CHECK_EQ(Second.NumMisses, 0);
+	CHECK_EQ(Second.NumHits, 3);
+	CHECK(Second.Pipelines == First.Pipelines);
+
+	// an edited shader misses alone and is added to the cache.
+	FakePipelineDesc Edited[3] = { SceneDescs[0], SceneDescs[1], { "ToneMap2", 0, 1, 0.f } };
+	FakePipelineLibrary Third = Launch(Path, 7, Edited, 3, Error);
+	CHECK_EQ(Third.NumMisses, 1);
+	CHECK_EQ(Third.NumHits, 2);
+	CHECK_EQ(Launch(Path, 7, Edited, 3, Error).NumHits, 3);
+	CHECK_EQ(Launch(Path, 7, SceneDescs, 3, Error).NumHits, 3);
+
+	// another gpu or driver ignores the file and builds everything again.
+	FakePipelineLibrary OtherDevice = Launch(Path, 8, SceneDescs, 3, Error);
+	CHECK_EQ(OtherDevice.NumMisses, 3);
+	CHECK(Error == "pipeline cache of another device");
+
+	std::remove(Path.c_str());
+}
+
+TEST_CASE(RejectedCacheFiles)
+{
+	const uint8_t Payload[] = { 1, 2, 3, 4, 5, 6, 7, 8, 9 };
+	std::vector<uint8_t> File, Data;
+	std::string Error;
+	SerializePipelineCache(42, Payload, sizeof(Payload), File);
+	CHECK_EQ(File.size(), 32 + sizeof(Payload));
+	CHECK(ParsePipelineCache(File.data(), File.size(), 42, Data, Error));
+	CHECK(Data == std::vector<uint8_t>(Payload, Payload + sizeof(Payload)));
+
+	// each damage is reported and leaves no data behind.
+	struct Case { size_t Offset; uint8_t Xor; size_t Size; const char* Error; };
+	const Case Cases[] = {
+		{ 0, 0x01, File.size(), "not a pipeline cache" },
+		{ 4, 0x01, File.size(), "pipeline cache version changed" },
+		{ 8, 0x01, File.size(), "pipeline cache of another device" },
+		{ 0, 0x00, File.size() - 1, "pipeline cache truncated" },
+		{ 0, 0x00, 31, "not a pipeline cache" },
+		{ 35, 0x80, File.size(), "pipeline cache damaged" },
+	};
+	for (const Case& C : Cases)
+	{
+		std::vector<uint8_t> Damaged(File.begin(), File.begin() + C.Size);
+		Damaged[C.Offset] ^= C.Xor;
+		Data.assign(3, 0);
+		CHECK(!ParsePipelineCache(Damaged.data(), Damaged.size(), 42, Data, Error));
+		CHECK(Error == C.Error);
+		CHECK(Data.empty());
+	}
+
+	// an empty payload is a valid cache.
+	SerializePipelineCache(42, nullptr, 0, File);
+	CHECK(ParsePipelineCache(File.data(), File.size(), 42, Data, Error));
+	CHECK(Data.empty());
+}
+
+TEST_CASE(BackgroundLoad)
+{
+	const std::string Path = TempPath("corona_pipeline_cache_loader.bin");
+	std::remove(Path.c_str());
+	std::vector<uint8_t> Data;
+	std::string Error;
+
+	// never started, or no file yet: a miss without an error.
+	PipelineCacheLoader Idle;
+	CHECK(!Idle.Get(Data, Error));
+
+	PipelineCacheLoader Missing;
+	Missing.Start(Path, 1);
+	CHECK(!Missing.Get(Data, Error));
+	CHECK(Error.empty());
+
+	const uint8_t Payload[] = { 'p', 's', 'o' };
+	CHECK(WritePipelineCacheFile(Path, 1, Payload, sizeof(Payload), Error));
+	CHECK(!std::filesystem::exists(Path + ".tmp"));
+
+	PipelineCacheLoader Loader;
+	Loader.Start(Path, 1);
+	CHECK(Loader.Get(Data, Error));
+	CHECK(Data == std::vector<uint8_t>(Payload, Payload + sizeof(Payload)));
+
+	std::remove(Path.c_str());
+}
@@ -0,0 +1,241 @@
+#include "TestFramework.h"
+#include "TestScenes.h"
+#include "ProbePlacementCPU.h"
+
+#include <algorithm>
+#include <string>
+
+#include "enkiTS/TaskScheduler.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+// PlaceProbesCPU on the bundled scenes. sphere.obj is a closed sphere of radius 42.1 around the origin,
+// shaderBall.fbx is placed the way Corona::LoadAssets places the first shader ball. Sponza.fbx is not
+// in the repository, so the scene the renderer opens with is not covered.
+namespace
+{
+	const float kSphereRadius = 42.1f;
+
+	bool LoadGeometry(const std::vector<TestMesh>& Meshes, const glm::mat4& Transform, ProbePlacementGeometry& Geometry)
+	{
+		for (const TestMesh& Mesh : Meshes)
+			Geometry.AddMesh(Mesh.Positions, Mesh.Normals, Mesh.Indices, Transform);
+		return Geometry.GetNumTriangles() > 0;
+	}
+
+	bool LoadSphere(ProbePlacementGeometry& Geometry)
+	{
+		std::vector<TestMesh> Meshes;
+		std::string Error;
+		if (!LoadTestOBJ(GetTestAssetPath("sphere/sphere.obj"), Meshes, Error))
+		{
+			std::printf("  %s\n", Error.c_str());
+			return false;
+		}
+		return LoadGeometry(Meshes, glm::mat4(1.f), Geometry);
+	}
+
+	bool LoadShaderBall(ProbePlacementGeometry& Geometry)
+	{
+		std::vector<TestMesh> Meshes;
+		std::string Error;
+		if (!LoadTestFBX(GetTestAssetPath("shaderBall/shaderBall.fbx"), Meshes, Error))
+		{
+			std::printf("  %s\n", Error.c_str());
+			return false;
+		}
+		return LoadGeometry(Meshes, glm::scale(glm::mat4(1.f), glm::vec3(2.5f)) * glm::translate(glm::mat4(1.f), glm::vec3(-150.f, 20.f, 0.f)), Geometry);
+	}
+
+	glm::vec3 GetPlacedPosition(uint32_t ProbeIndex, const ProbeGridDesc& Grid, const std::vector<glm::vec4>& Offsets)
+	{
+		return GetProbeWorldPosition(ProbeIndex, Grid) + glm::vec3(Offsets[ProbeIndex]) * Grid.Spacing;
+	}
+
+	// share of rays from Position that see a backface first, traced independently of the placement's ray sets.
+	float GetBackfaceFraction(const ProbePlacementBVH& BVH, const glm::vec3& Position, float MaxT)
+	{
+		const uint32_t NumRays = 512;
+		uint32_t NumBackfaces = 0;
+		for (uint32_t r = 0; r < NumRays; r++)
+		{
+			ProbePlacementBVH::Hit Hit;
+			if (BVH.Intersect(Position, GetSphericalFibonacci(float(r), float(NumRays)), MaxT, Hit) && Hit.bBackface)
+				NumBackfaces++;
+		}
+		return float(NumBackfaces) / NumRays;
+	}
+}
+
+TEST_CASE(SphereLoads)
+{
+	ProbePlacementGeometry Geometry;
+	CHECK(LoadSphere(Geometry));
+	CHECK_EQ(Geometry.GetNumTriangles(), 3072);
+
+	// every face normal points out of the sphere.
+	for (uint32_t i = 0; i < Geometry.GetNumTriangles(); i++)
+	{
+		CHECK_NEAR(glm::length(Geometry.Positions[i * 3]), kSphereRadius, 0.01f);
+		CHECK(glm::dot(Geometry.Normals[i], Geometry.Positions[i * 3]) > 0.f);
+	}
+}
+
+TEST_CASE(SphereProbeStates)
+{
+	ProbePlacementGeometry Geometry;
+	CHECK(LoadSphere(Geometry));
+	ProbePlacementBVH BVH;
+	BVH.Build(Geometry);
+
+	ProbeGridDesc Grid;
+	Grid.Counts = glm::ivec3(8);
+	Grid.Spacing = glm::vec3(20.f);
+
+	const ProbePlacementParams Params;
+	std::vector<glm::vec4> Offsets;
+	std::vector<uint8_t> States;
+	ProbePlacementStats Stats;
+	PlaceProbesCPU(Params, Grid, BVH, Offsets, States, &Stats, nullptr);
+	CHECK_EQ(Stats.NumProbes, Grid.GetNumProbes());
+
+	const float MaxCellOffset = 0.45f * glm::length(Grid.Spacing);
+	const float SearchBound = Grid.Spacing.x * 2.0f * 1.45f;
+
+	uint32_t NumActive = 0;
+	uint32_t NumInactive = 0;
+	for (uint32_t i = 0; i < Grid.GetNumProbes(); i++)
+	{
+		const float BaseDistance = glm::length(GetProbeWorldPosition(i, Grid));
+		const float PlacedDistance = glm::length(GetPlacedPosition(i, Grid, Offsets));
+
+		CHECK(glm::all(glm::lessThan(glm::abs(glm::vec3(Offsets[i])), glm::vec3(0.45f))));
+
+		// no active probe is left inside, deep inside probes can't leave their cell and nothing is around far ones.
+		if (States[i] == kProbeStateActive)
+			CHECK(PlacedDistance > kSphereRadius);
+		if (BaseDistance < kSphereRadius - MaxCellOffset || BaseDistance > kSphereRadius + SearchBound + MaxCellOffset)
+			CHECK_EQ(States[i], kProbeStateInactive);
+
+		NumActive += States[i] == kProbeStateActive ? 1 : 0;
+		NumInactive += States[i] == kProbeStateInactive ? 1 : 0;
+	}
+
+	CHECK(NumActive > 0);
+	CHECK_EQ(NumInactive, Stats.NumInactive);
+}
+
+TEST_CASE(SphereProbesLeaveTheSurface)
+{
+	ProbePlacementGeometry Geometry;
+	CHECK(LoadSphere(Geometry));
+	ProbePlacementBVH BVH;
+	BVH.Build(Geometry);
+
+	ProbePlacementParams Params;
+	Params.MinFrontfaceDistance = 5.0f;
+
+	// single probe grids, 2 units outside and 2 units inside the surface.
+	ProbeGridDesc Grid;
+	Grid.Counts = glm::ivec3(1);
+	Grid.Spacing = glm::vec3(20.f);
+
+	std::vector<glm::vec4> Offsets;
+	std::vector<uint8_t> States;
+
+	Grid.Origin = glm::vec3(kSphereRadius + 2.f, 0.f, 0.f);
+	PlaceProbesCPU(Params, Grid, BVH, Offsets, States, nullptr, nullptr);
+	CHECK_EQ(States[0], kProbeStateActive);
+	CHECK(glm::length(GetPlacedPosition(0, Grid, Offsets)) > kSphereRadius + 2.f);
+
+	Grid.Origin = glm::vec3(0.f, kSphereRadius - 2.f, 0.f);
+	PlaceProbesCPU(Params, Grid, BVH, Offsets, States, nullptr, nullptr);
+	CHECK_EQ(States[0], kProbeStateActive);
+	CHECK(glm::length(GetPlacedPosition(0, Grid, Offsets)) > kSphereRadius);
+}
+
+TEST_CASE(ShaderBallPlacement)
+{
+	ProbePlacementGeometry Geometry;
+	if (!LoadShaderBall(Geometry))
+	{
+		// without zlib the compressed arrays of the fbx can't be read.
+#if CORONA_TEST_ZLIB
+		CHECK(false);
+#endif
+		return;
+	}
+
+	glm::vec3 Min = Geometry.Positions[0];
+	glm::vec3 Max = Geometry.Positions[0];
+	for (const glm::vec3& P : Geometry.Positions)
+	{
+		Min = glm::min(Min, P);
+		Max = glm::max(Max, P);
+	}
+	// the ball sits on its base, about 170 units across once scaled.
+	CHECK(glm::all(glm::greaterThan(Max - Min, glm::vec3(100.f))) && glm::all(glm::lessThan(Max - Min, glm::vec3(1000.f))));
+
+	ProbePlacementBVH BVH;
+	BVH.Build(Geometry);
+
+	// a grid over the ball and one cell around it.
+	ProbeGridDesc Grid;
+	Grid.Spacing = glm::vec3(25.f);
+	Grid.Counts = glm::ivec3(glm::ceil((Max - Min) / Grid.Spacing)) + 3;
+	Grid.Origin = (Min + Max) * 0.5f;
+
+	const ProbePlacementParams Params;
+	std::vector<glm::vec4> Offsets;
+	std::vector<uint8_t> States;
+	ProbePlacementStats Stats;
+	PlaceProbesCPU(Params, Grid, BVH, Offsets, States, &Stats, nullptr);
+
+	const float SearchBound = Grid.Spacing.x * 2.0f * 1.45f;
+	uint32_t NumActive = 0;
+	uint32_t NumInsideBefore = 0;
+	for (uint32_t i = 0; i < Grid.GetNumProbes(); i++)
+	{
+		CHECK(glm::all(glm::lessThan(glm::abs(glm::vec3(Offsets[i])), glm::vec3(0.45f))));
+
+		NumInsideBefore += GetBackfaceFraction(BVH, GetProbeWorldPosition(i, Grid), SearchBound) >= Params.BackfaceThreshold ? 1 : 0;
+		if (States[i] != kProbeStateActive)
+			continue;
+
+		// the classifier's own rays said outside, a denser independent ray set agrees within a few rays.
+		NumActive++;
+		CHECK(GetBackfaceFraction(BVH, GetPlacedPosition(i, Grid, Offsets), SearchBound) < Params.BackfaceThreshold + 0.05f);
+	}
+
+	// the ball is hollow in places and the grid cuts through it, relocation has work to do.
+	CHECK(NumInsideBefore > 0);
+	CHECK(Stats.NumMoved > 0);
+	CHECK(NumActive > 0);
+	CHECK(Stats.NumInactive > 0);
+	CHECK_EQ(NumActive + Stats.NumInactive, Grid.GetNumProbes());
+}
+
+TEST_CASE(PlacementIsDeterministic)
+{
+	ProbePlacementGeometry Geometry;
+	CHECK(LoadSphere(Geometry));
+	ProbePlacementBVH BVH;
+	BVH.Build(Geometry);
+
+	ProbeGridDesc Grid;
+	Grid.Counts = glm::ivec3(8);
+	Grid.Spacing = glm::vec3(15.f);
+	Grid.ScrollOffsets = glm::ivec3(3, 5, 1);
+
+	enki::TaskScheduler TS;
+	TS.Initialize();
+
+	const ProbePlacementParams Params;
+	std::vector<glm::vec4> SerialOffsets, ThreadedOffsets, RepeatedOffsets;
+	std::vector<uint8_t> SerialStates, ThreadedStates, RepeatedStates;
+	PlaceProbesCPU(Params, Grid, BVH, SerialOffsets, SerialStates, nullptr, nullptr);
+	PlaceProbesCPU(Params, Grid, BVH, ThreadedOffsets, ThreadedStates, nullptr, &TS);
+	PlaceProbesCPU(Params, Grid, BVH, RepeatedOffsets, RepeatedStates, nullptr, &TS);
+
+	CHECK(SerialOffsets == ThreadedOffsets && SerialStates == ThreadedStates);
+	CHECK(ThreadedOffsets == RepeatedOffsets && ThreadedStates == RepeatedStates);
+}
@@ -0,0 +1,220 @@
+#include "TestFramework.h"
+#include "ProbeScheduler.h"
+
+#include <algorithm>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+// ProbeScheduler on a 16x8x16 grid with a camera looking down -z from the grid center, what the
+// renderer does each frame without the gpu.
+namespace
+{
+	ProbeGridDesc MakeGrid()
+	{
+		ProbeGridDesc Grid;
+		Grid.Origin = glm::vec3(0.f);
+		Grid.Counts = glm::ivec3(16, 8, 16);
+		Grid.Spacing = glm::vec3(100.f);
+		return Grid;
+	}
+
+	glm::mat4 MakeViewProj()
+	{
+		const glm::mat4 View = glm::lookAt(glm::vec3(0.f), glm::vec3(0.f, 0.f, -1.f), glm::vec3(0.f, 1.f, 0.f));
+		return glm::perspective(glm::radians(60.f), 16.f / 9.f, 1.f, 10000.f) * View;
+	}
+
+	// runs Frames Schedule calls on a fresh scheduler and returns every frame's probes.
+	std::vector<std::vector<uint32_t>> RunFrames(const ProbeScheduleParams& Params, int Frames)
+	{
+		const ProbeGridDesc Grid = MakeGrid();
+		ProbeScheduler Scheduler;
+		Scheduler.Init(Grid.GetNumProbes());
+
+		std::vector<std::vector<uint32_t>> Result;
+		for (int f = 0; f < Frames; f++)
+			Result.push_back(Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj()));
+		return Result;
+	}
+}
+
+TEST_CASE(ProbeIndexRoundTrip)
+{
+	const glm::ivec3 Counts(16, 8, 16);
+	for (uint32_t i = 0; i < 16 * 8 * 16; i++)
+		CHECK_EQ(GetProbeIndex(GetProbeCoords(i, Counts), Counts), i);
+
+	// x fastest, then z, then y like the rtxgi layout.
+	CHECK_EQ(GetProbeIndex(glm::ivec3(1, 0, 0), Counts), 1);
+	CHECK_EQ(GetProbeIndex(glm::ivec3(0, 0, 1), Counts), 16);
+	CHECK_EQ(GetProbeIndex(glm::ivec3(0, 1, 0), Counts), 16 * 16);
+}
+
+TEST_CASE(ScheduleIsDeterministic)
+{
+	const ProbeScheduleParams Params;
+	const auto A = RunFrames(Params, 32);
+	const auto B = RunFrames(Params, 32);
+	CHECK(A == B);
+
+	for (const auto& Frame : A)
+		CHECK(std::is_sorted(Frame.begin(), Frame.end()));
+}
+
+TEST_CASE(ScheduleTracesTheUpdateFraction)
+{
+	const ProbeGridDesc Grid = MakeGrid();
+	const uint32_t NumProbes = Grid.GetNumProbes();
+
+	CHECK_EQ(ProbeScheduler::GetNumScheduledProbes(NumProbes, 0.25f), NumProbes / 4);
+	CHECK_EQ(ProbeScheduler::GetNumScheduledProbes(NumProbes, 0.f), 1);
+	CHECK_EQ(ProbeScheduler::GetNumScheduledProbes(NumProbes, 2.f), NumProbes);
+	CHECK_EQ(ProbeScheduler::GetNumScheduledProbes(10, 0.15f), 2);
+
+	ProbeScheduleParams Params;
+	Params.UpdateFraction = 0.25f;
+	const auto Frames = RunFrames(Params, 16);
+
+	// nothing changed after the first frames, every frame traces exactly the fraction.
+	for (const auto& Frame : Frames)
+		CHECK_EQ(Frame.size(), NumProbes / 4);
+
+	// all probes start invalid, the first 1 / UpdateFraction frames cover the volume once.
+	std::vector<int> Traced(NumProbes, 0);
+	for (int f = 0; f < 4; f++)
+		for (uint32_t i : Frames[f])
+			Traced[i]++;
+	CHECK(std::all_of(Traced.begin(), Traced.end(), [](int n) { return n == 1; }));
+}
+
+TEST_CASE(NoProbeStarves)
+{
+	const ProbeGridDesc Grid = MakeGrid();
+	ProbeScheduleParams Params;
+	Params.UpdateFraction = 0.1f;
+	Params.MaxAge = 16;
+	// strong weights so far probes would wait far longer than MaxAge on priority alone.
+	Params.NearWeight = 50.f;
+	Params.VisibleWeight = 10.f;
+
+	ProbeScheduler Scheduler;
+	Scheduler.Init(Grid.GetNumProbes());
+
+	// far probes behind the camera have the lowest priority, the age bound still gets them traced.
+	uint32_t MaxAge = 0;
+	for (int f = 0; f < 200; f++)
+	{
+		Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj());
+		if (f < 20)
+			continue;
+		for (uint32_t i = 0; i < Grid.GetNumProbes(); i++)
+			MaxAge = std::max(MaxAge, Scheduler.GetAge(i));
+	}
+
+	// a probe reaching MaxAge waits at most for the starving probes ahead of it.
+	const uint32_t NumPerFrame = ProbeScheduler::GetNumScheduledProbes(Grid.GetNumProbes(), Params.UpdateFraction);
+	CHECK(MaxAge <= Params.MaxAge + Grid.GetNumProbes() / NumPerFrame);
+}
+
+TEST_CASE(NearVisibleProbesUpdateMoreOften)
+{
+	const ProbeGridDesc Grid = MakeGrid();
+	ProbeScheduleParams Params;
+	Params.UpdateFraction = 0.1f;
+	Params.MaxAge = 1000;
+
+	const auto Frames = RunFrames(Params, 200);
+
+	std::vector<int> Traced(Grid.GetNumProbes(), 0);
+	for (size_t f = 20; f < Frames.size(); f++)
+		for (uint32_t i : Frames[f])
+			Traced[i]++;
+
+	// probe in front of the camera and the one mirrored behind it.
+	const glm::ivec3 Front(8, 4, 6);
+	const glm::ivec3 Back(8, 4, 12);
+	CHECK(glm::length(GetProbeWorldPosition(GetProbeIndex(Front, Grid.Counts), Grid)) <
+		glm::length(GetProbeWorldPosition(GetProbeIndex(Back, Grid.Counts), Grid)) + 1.f);
+	CHECK(Traced[GetProbeIndex(Front, Grid.Counts)] > Traced[GetProbeIndex(Back, Grid.Counts)]);
+}
+
+TEST_CASE(ForcedProbesAreAllTraced)
+{
+	const ProbeGridDesc Grid = MakeGrid();
+	ProbeScheduleParams Params;
+	Params.UpdateFraction = 0.05f;
+
+	ProbeScheduler Scheduler;
+	Scheduler.Init(Grid.GetNumProbes());
+	for (int f = 0; f < 40; f++)
+		Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj());
+
+	// a slab scrolled in, more probes than the update fraction.
+	std::vector<uint32_t> Slab;
+	for (int y = 0; y < Grid.Counts.y; y++)
+		for (int z = 0; z < Grid.Counts.z; z++)
+			Slab.push_back(GetProbeIndex(glm::ivec3(0, y, z), Grid.Counts));
+	Scheduler.ForceSchedule(Slab);
+	Scheduler.ForceSchedule(Slab);
+
+	const auto& Scheduled = Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj());
+	CHECK_EQ(Scheduled.size(), std::max<size_t>(Slab.size(), ProbeScheduler::GetNumScheduledProbes(Grid.GetNumProbes(), Params.UpdateFraction)));
+	for (uint32_t i : Slab)
+		CHECK(std::binary_search(Scheduled.begin(), Scheduled.end(), i));
+
+	// forcing is one shot.
+	CHECK_EQ(Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj()).size(),
+		ProbeScheduler::GetNumScheduledProbes(Grid.GetNumProbes(), Params.UpdateFraction));
+}
+
+TEST_CASE(ChangedProbesGoFirst)
+{
+	const ProbeGridDesc Grid = MakeGrid();
+	ProbeScheduleParams Params;
+	Params.UpdateFraction = 0.1f;
+
+	ProbeScheduler Scheduler;
+	Scheduler.Init(Grid.GetNumProbes());
+	for (int f = 0; f < 40; f++)
+		Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj());
+
+	// a box around one probe behind the camera touches its neighbours within a spacing.
+	const uint32_t Probe = GetProbeIndex(glm::ivec3(3, 2, 14), Grid.Counts);
+	const glm::vec3 P = GetProbeWorldPosition(Probe, Grid);
+	Scheduler.MarkChanged(Grid, P - 1.f, P + 1.f);
+
+	const auto& Scheduled = Scheduler.Schedule(Grid, Params, glm::vec3(0.f), MakeViewProj());
+	for (int dz = -1; dz <= 1; dz++)
+		for (int dy = -1; dy <= 1; dy++)
+			for (int dx = -1; dx <= 1; dx++)
+			{
+				const uint32_t i = GetProbeIndex(glm::ivec3(3 + dx, 2 + dy, 14 + dz), Grid.Counts);
+				CHECK(std::binary_search(Scheduled.begin(), Scheduled.end(), i));
+			}
+}
+
+TEST_CASE(ScrolledGridKeepsWorldPositions)
+{
+	ProbeGridDesc Grid = MakeGrid();
+	const glm::ivec3 GridCoords(5, 3, 11);
+	const glm::vec3 Unscrolled = GetProbeWorldPosition(GetProbeIndex(GridCoords, Grid.Counts), Grid);
+
+	// the probe moves to another storage slot, its world position stays.
+	Grid.ScrollOffsets = glm::ivec3(13, 2, 7);
+	const glm::ivec3 Storage = GetScrollingProbeCoords(GridCoords, Grid.Counts, Grid.ScrollOffsets);
+	CHECK(Storage == glm::ivec3(2, 5, 2));
+	CHECK(GetUnscrolledProbeCoords(Storage, Grid.Counts, Grid.ScrollOffsets) == GridCoords);
+	CHECK(GetProbeWorldPosition(GetProbeIndex(Storage, Grid.Counts), Grid) == Unscrolled);
+}
+
+TEST_CASE(CompensatedHysteresis)
+{
+	CHECK_NEAR(ProbeScheduler::GetCompensatedHysteresis(0.97f, 1.f), 0.97f, 1e-6f);
+	CHECK_NEAR(ProbeScheduler::GetCompensatedHysteresis(0.97f, 0.25f), std::pow(0.97f, 4.f), 1e-6f);
+	CHECK_NEAR(ProbeScheduler::GetCompensatedHysteresis(0.9f, 0.5f), 0.81f, 1e-6f);
+
+	// the response after one second of frames matches an update every frame.
+	const float PerFrame = std::pow(0.97f, 60.f);
+	const float Compensated = std::pow(ProbeScheduler::GetCompensatedHysteresis(0.97f, 0.25f), 60.f * 0.25f);
+	CHECK_NEAR(Compensated, PerFrame, 1e-4f);
+}
@@ -0,0 +1,275 @@
+#include "TestFramework.h"
+#include "Profiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <thread>
+
+// cpu zones, the gpu timestamp ring, the rolling stats and the chrome trace output of the frame profiler.
+namespace
+{
+	// the profiler is a process wide singleton, other cases may have left zones behind.
+	std::vector<ProfileEvent> CollectZones()
+	{
+		std::vector<ProfileEvent> Events;
+		CPUProfiler::Get().Collect(Events);
+		return Events;
+	}
+
+	const ProfileEvent* FindZone(const std::vector<ProfileEvent>& Events, const char* Name)
+	{
+		for (const ProfileEvent& Event : Events)
+			if (std::strcmp(Event.Name, Name) == 0)
+				return &Event;
+		return nullptr;
+	}
+}
+
+TEST_CASE(NestedCPUZones)
+{
+	CollectZones();
+	{
+		ProfileCPUScope("Frame");
+		{
+			ProfileCPUScope("GBuffer");
+			ProfileCPUScope("Draws");
+		}
+		ProfileCPUScope("Lighting");
+	}
+
+	const std::vector<ProfileEvent> Events = CollectZones();
+	CHECK_EQ(Events.size(), 4);
+
+	const ProfileEvent* Frame = FindZone(Events, "Frame");
+	const ProfileEvent* GBuffer = FindZone(Events, "GBuffer");
+	const ProfileEvent* Draws = FindZone(Events, "Draws");
+	const ProfileEvent* Lighting = FindZone(Events, "Lighting");
+	CHECK(Frame && GBuffer && Draws && Lighting);
+	if (!Frame || !GBuffer || !Draws || !Lighting)
+		return;
+
+	CHECK_EQ(Frame->Depth, 0);
+	CHECK_EQ(GBuffer->Depth, 1);
+	CHECK_EQ(Draws->Depth, 2);
+	CHECK_EQ(Lighting->Depth, 1);
+
+	// children lie inside their parent, siblings follow each other.
+	CHECK(Frame->BeginNs <= GBuffer->BeginNs && GBuffer->EndNs <= Frame->EndNs);
+	CHECK(GBuffer->BeginNs <= Draws->BeginNs && Draws->EndNs <= GBuffer->EndNs);
+	CHECK(GBuffer->EndNs <= Lighting->BeginNs && Lighting->EndNs <= Frame->EndNs);
+
+	// zones are finished inner first.
+	CHECK(std::strcmp(Events[0].Name, "Draws") == 0);
+	CHECK(std::strcmp(Events[3].Name, "Frame") == 0);
+
+	CHECK(CollectZones().empty());
+}
+
+TEST_CASE(DisabledProfilerRecordsNothing)
+{
+	CollectZones();
+	CPUProfiler::Get().SetEnabled(false);
+	{
+		ProfileCPUScope("Hidden");
+	}
+	CPUProfiler::Get().SetEnabled(true);
+	CHECK(CollectZones().empty());
+}
+
+TEST_CASE(ThreadsGetTheirOwnBuffers)
+{
+	CollectZones();
+
+	const int NumThreads = 4;
+	const int NumZones = 1000;
+	std::vector<std::thread> Threads;
+	for (int t = 0; t < NumThreads; t++)
+	{
+		Threads.emplace_back([]()
+		{
+			CPUProfiler::Get().SetThreadName("Worker");
+			for (int i = 0; i < NumZones; i++)
+				ProfileCPUScope("Work");
+		});
+	}
+
+	// collecting while the workers push, nothing is lost or seen twice.
+	std::vector<ProfileEvent> Events;
+	while (Events.size() < size_t(NumThreads * NumZones))
+	{
+		CPUProfiler::Get().Collect(Events);
+		std::this_thread::yield();
+	}
+	for (std::thread& Thread : Threads)
+		Thread.join();
+	CPUProfiler::Get().Collect(Events);
+	CHECK_EQ(Events.size(), NumThreads * NumZones);
+
+	std::vector<uint32_t> ThreadIDs;
+	for (const ProfileEvent& Event : Events)
+		ThreadIDs.push_back(Event.ThreadID);
+	std::sort(ThreadIDs.begin(), ThreadIDs.end());
+	ThreadIDs.erase(std::unique(ThreadIDs.begin(), ThreadIDs.end()), ThreadIDs.end());
+	CHECK_EQ(ThreadIDs.size(), NumThreads);
+
+	int NumNamed = 0;
+	CPUProfiler::Get().ForEachThread([&](const ProfilerThreadBuffer& Buffer) { NumNamed += Buffer.ThreadName == "Worker" ? 1 : 0; });
+	CHECK(NumNamed >= NumThreads);
+}
+
+TEST_CASE(FullBufferDropsZones)
+{
+	ProfilerThreadBuffer* Buffer = new ProfilerThreadBuffer;
+	const ProfileEvent Event = { "Zone", 1, 2, 0, 0 };
+	for (uint32_t i = 0; i < ProfilerThreadBuffer::kCapacity; i++)
+		CHECK(Buffer->Push(Event));
+	CHECK(!Buffer->Push(Event));
+	CHECK(!Buffer->Push(Event));
+	CHECK_EQ(Buffer->NumDropped.load(), 2);
+
+	std::vector<ProfileEvent> Events;
+	Buffer->Drain(Events);
+	CHECK_EQ(Events.size(), ProfilerThreadBuffer::kCapacity);
+
+	// drained, there is room again and the ring wraps.
+	CHECK(Buffer->Push(Event));
+	Events.clear();
+	Buffer->Drain(Events);
+	CHECK_EQ(Events.size(), 1);
+	delete Buffer;
+}
+
+TEST_CASE(GPUTimestampQueries)
+{
+	GPUTimestampRing Ring;
+	Ring.Init(3, 4);
+	CHECK_EQ(Ring.GetNumQueries(), 3 * 4 * 2);
+
+	Ring.BeginFrame(1);
+	const uint32_t Frame = Ring.BeginZone("Frame");
+	const uint32_t GBuffer = Ring.BeginZone("GBuffer");
+	Ring.EndZone(GBuffer);
+	const uint32_t Lighting = Ring.BeginZone("Lighting");
+	Ring.EndZone(Lighting);
+	const uint32_t Post = Ring.BeginZone("Post");
+	CHECK_EQ(Ring.BeginZone("Overflow"), GPUTimestampRing::InvalidZone);
+	Ring.EndZone(GPUTimestampRing::InvalidZone);
+	Ring.EndZone(Frame);
+
+	// frame 1 owns queries [8, 16), zone z the pair 2z, 2z + 1.
+	CHECK_EQ(Ring.GetFirstQuery(), 8);
+	CHECK_EQ(Ring.GetNumFrameQueries(), 8);
+	CHECK_EQ(Ring.GetBeginQuery(GBuffer), 10);
+	CHECK_EQ(Ring.GetEndQuery(GBuffer), 11);
+
+	// 1 MHz ticks, tick 1000 was read at cpu time 5 ms.
+	const uint64_t Timestamps[8] = { 1000, 1100, 1010, 1040, 1040, 1090, 1090, 1095 };
+	std::vector<GPUZoneTiming> Timings;
+	Ring.Resolve(1, Timestamps, 1000000, 1000, 5000000, Timings);
+	CHECK(Timings.empty());
+
+	Ring.MarkResolved();
+	Ring.Resolve(1, Timestamps, 1000000, 1000, 5000000, Timings);
+
+	// Post was never closed.
+	(void)Post;
+	CHECK_EQ(Timings.size(), 3);
+	if (Timings.size() != 3)
+		return;
+	CHECK(std::strcmp(Timings[0].Name, "Frame") == 0 && Timings[0].Depth == 0);
+	CHECK_EQ(Timings[0].BeginNs, 5000000);
+	CHECK_EQ(Timings[0].EndNs, 5100000);
+	CHECK(std::strcmp(Timings[1].Name, "GBuffer") == 0 && Timings[1].Depth == 1);
+	CHECK_EQ(Timings[1].BeginNs, 5010000);
+	CHECK_EQ(Timings[1].EndNs, 5040000);
+	CHECK_EQ(Timings[2].Depth, 1);
+
+	// reusing the frame slot forgets its zones.
+	Ring.BeginFrame(1);
+	Timings.clear();
+	Ring.Resolve(1, Timestamps, 1000000, 1000, 5000000, Timings);
+	CHECK(Timings.empty());
+}
+
+TEST_CASE(RollingZoneStats)
+{
+	ProfilerStats Stats;
+
+	// a zone entered twice in a frame counts once with the sum.
+	Stats.AddSample("Frame", 0, 10.0);
+	Stats.AddSample("Pass", 1, 1.0);
+	Stats.AddSample("Pass", 1, 2.0);
+	Stats.EndFrame();
+
+	CHECK_EQ(Stats.GetStats().size(), 2);
+	CHECK(Stats.GetStats()[0].Name == "Frame");
+	CHECK(Stats.GetStats()[1].Name == "Pass");
+	CHECK_EQ(Stats.GetStats()[1].Depth, 1);
+	CHECK_NEAR(Stats.GetStats()[1].LastMs, 3.0, 1e-6);
+
+	// 1..100 ms over the next frames.
+	for (int i = 1; i <= 100; i++)
+	{
+		Stats.AddSample("Pass", 1, double(i));
+		Stats.EndFrame();
+	}
+
+	const ProfilerStats::ZoneStats& Pass = Stats.GetStats()[0];
+	CHECK_EQ(Stats.GetStats().size(), 1);
+	CHECK_NEAR(Pass.LastMs, 100.0, 1e-6);
+	CHECK_NEAR(Pass.MinMs, 1.0, 1e-6);
+	CHECK_NEAR(Pass.MaxMs, 100.0, 1e-6);
+	CHECK_NEAR(Pass.AvgMs, (3.0 + 5050.0) / 101.0, 1e-4);
+	CHECK_NEAR(Pass.P95Ms, 95.0, 1e-6);
+
+	// the window forgets the oldest frames.
+	for (uint32_t i = 0; i < ProfilerStats::kWindow; i++)
+	{
+		Stats.AddSample("Pass", 1, 7.0);
+		Stats.EndFrame();
+	}
+	CHECK_NEAR(Stats.GetStats()[0].MinMs, 7.0, 1e-6);
+	CHECK_NEAR(Stats.GetStats()[0].MaxMs, 7.0, 1e-6);
+}
+
+TEST_CASE(ChromeTraceOutput)
+{
+	ChromeTraceWriter Writer;
+	Writer.SetTrackName(0, "Main \"render\" thread");
+	Writer.SetTrackName(ChromeTraceWriter::kGPUTrackID, "GPU");
+	Writer.AddEvent("GBuffer", "cpu", 0, 2001234, 2501000);
+	Writer.AddEvent("Shadow\\Pass", "gpu", ChromeTraceWriter::kGPUTrackID, 2000000, 2000005);
+	CHECK_EQ(Writer.GetNumEvents(), 2);
+
+	std::ostringstream Stream;
+	Writer.Write(Stream);
+	const std::string Json = Stream.str();
+
+	CHECK(Json.find("\"displayTimeUnit\":\"ms\"") != std::string::npos);
+	CHECK(Json.find("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Main \\\"render\\\" thread\"}}") != std::string::npos);
+	CHECK(Json.find("\"tid\":65535,\"args\":{\"name\":\"GPU\"}") != std::string::npos);
+
+	// microseconds relative to the earliest event, nanoseconds as 3 decimals.
+	CHECK(Json.find("{\"name\":\"GBuffer\",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":0,\"ts\":1.234,\"dur\":499.766}") != std::string::npos);
+	CHECK(Json.find("{\"name\":\"Shadow\\\\Pass\",\"cat\":\"gpu\",\"ph\":\"X\",\"pid\":1,\"tid\":65535,\"ts\":0.000,\"dur\":0.005}") != std::string::npos);
+	CHECK(std::count(Json.begin(), Json.end(), '{') == std::count(Json.begin(), Json.end(), '}'));
+
+	Writer.Clear();
+	CHECK_EQ(Writer.GetNumEvents(), 0);
+}
+
+TEST_CASE(ZoneColors)
+{
+	CHECK_EQ(ProfileColorFromName("GBuffer"), ProfileColorFromName("GBuffer"));
+	CHECK(ProfileColorFromName("GBuffer") != ProfileColorFromName("Lighting"));
+
+	// opaque, every channel at least 64 so the text stays readable.
+	for (const char* Name : { "", "a", "GBuffer", "RTXGI Probe Update" })
+	{
+		const uint32_t Color = ProfileColorFromName(Name);
+		CHECK_EQ(Color >> 24, 0xff);
+		for (int Shift : { 0, 8, 16 })
+			CHECK(((Color >> Shift) & 0xff) >= 64);
+	}
+}
@@ -0,0 +1,357 @@
+#include "TestFramework.h"
+#include "RayBudget.h"
+
+#include "enkiTS/TaskScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+// the reduced rate ray patterns of RayBudget.hlsl and the cpu reference of RayReconstructCS.hlsl. sizes
+// are not multiples of the cells, the last column and row of cells are partial.
+namespace
+{
+	const ERayBudgetMode kCellModes[] = { RAY_BUDGET_FULL, RAY_BUDGET_CHECKERBOARD, RAY_BUDGET_QUARTER, RAY_BUDGET_NINTH };
+
+	uint32_t GetPeriod(ERayBudgetMode Mode)
+	{
+		const RayBudgetPoint CellSize = GetRayBudgetCellSize(Mode);
+		return CellSize.x * CellSize.y;
+	}
+
+	RayReconstructCB MakeReconstructCB(ERayBudgetMode Mode, uint32_t Width, uint32_t Height, uint32_t FrameIndex)
+	{
+		RayReconstructCB CB;
+		CB.ProjectionParams = glm::vec4(0.f, 0.f, 0.1f, 100.f);
+		CB.RayBudgetMode = Mode;
+		CB.FrameIndex = FrameIndex;
+		CB.RTWidth = Width;
+		CB.RTHeight = Height;
+		return CB;
+	}
+
+	// Image with Traced at the traced pixels of the frame and garbage everywhere else.
+	template <typename T>
+	void FillTraced(ERayBudgetMode Mode, uint32_t FrameIndex, DenoiserImage& Image, T Traced)
+	{
+		for (uint32_t y = 0; y < Image.Height; y++)
+			for (uint32_t x = 0; x < Image.Width; x++)
+				Image.Store(x, y, IsTracedPixel(Mode, x, y, FrameIndex) ? Traced(x, y) : glm::vec4(-1000.f));
+	}
+
+	float MaxDifference(const glm::vec4& A, const glm::vec4& B)
+	{
+		const glm::vec4 D = glm::abs(A - B);
+		return std::max(std::max(D.x, D.y), std::max(D.z, D.w));
+	}
+}
+
+TEST_CASE(EveryPixelOncePerPeriod)
+{
+	for (const RayBudgetPoint Size : { RayBudgetPoint{ 37, 23 }, RayBudgetPoint{ 36, 24 }, RayBudgetPoint{ 1, 1 }, RayBudgetPoint{ 5, 2 } })
+	{
+		for (ERayBudgetMode Mode : kCellModes)
+		{
+			const RayBudgetPoint CellSize = GetRayBudgetCellSize(Mode);
+			const RayBudgetPoint NumCells = GetRayDispatchSize(Mode, Size.x, Size.y);
+			const uint32_t Period = GetPeriod(Mode);
+
+			// the dispatch covers the target, the last cells may be partial but never empty.
+			CHECK(NumCells.x * CellSize.x >= Size.x && (NumCells.x - 1) * CellSize.x < Size.x);
+			CHECK(NumCells.y * CellSize.y >= Size.y && (NumCells.y - 1) * CellSize.y < Size.y);
+
+			// any period long window, not only the one starting at frame 0.
+			for (uint32_t FirstFrame : { 0u, 5u, 1000u })
+			{
+				std::vector<uint32_t> NumTraced(size_t(Size.x) * Size.y, 0);
+				int NumBadRays = 0;
+				for (uint32_t Frame = FirstFrame; Frame < FirstFrame + Period; Frame++)
+				{
+					// one ray per cell, inside its cell, and IsTracedPixel agrees with it.
+					for (uint32_t CellY = 0; CellY < NumCells.y; CellY++)
+					{
+						for (uint32_t CellX = 0; CellX < NumCells.x; CellX++)
+						{
+							const RayBudgetPoint Q = GetTracedPixel(Mode, CellX, CellY, Frame);
+							NumBadRays += Q.x / CellSize.x != CellX || Q.y / CellSize.y != CellY;
+							if (Q.x < Size.x && Q.y < Size.y)
+								NumBadRays += !IsTracedPixel(Mode, Q.x, Q.y, Frame);
+						}
+					}
+
+					for (uint32_t y = 0; y < Size.y; y++)
+						for (uint32_t x = 0; x < Size.x; x++)
+							NumTraced[size_t(y) * Size.x + x] += IsTracedPixel(Mode, x, y, Frame);
+				}
+				CHECK_EQ(NumBadRays, 0);
+
+				const auto Range = std::minmax_element(NumTraced.begin(), NumTraced.end());
+				if (*Range.first != 1 || *Range.second != 1)
+					std::printf("  mode %u %ux%u from frame %u: traced %u to %u times\n", Mode, Size.x, Size.y, FirstFrame, *Range.first, *Range.second);
+				CHECK_EQ(*Range.first, 1);
+				CHECK_EQ(*Range.second, 1);
+			}
+		}
+	}
+
+	// the checkerboard flips every row, vertical neighbors are never traced in the same frame.
+	int NumSameColumn = 0;
+	for (uint32_t Frame = 0; Frame < 2; Frame++)
+		for (uint32_t y = 0; y + 1 < 8; y++)
+			for (uint32_t x = 0; x < 8; x++)
+				NumSameColumn += IsTracedPixel(RAY_BUDGET_CHECKERBOARD, x, y, Frame) && IsTracedPixel(RAY_BUDGET_CHECKERBOARD, x, y + 1, Frame);
+	CHECK_EQ(NumSameColumn, 0);
+}
+
+TEST_CASE(PartialEdgeCells)
+{
+	// 37x23 in 3x3 cells: the last column of cells is 1 pixel wide, the last row 2 pixels high. their ray
+	// lands outside of the target on the frames it would trace a missing pixel.
+	const uint32_t Width = 37, Height = 23;
+	const RayBudgetPoint NumCells = GetRayDispatchSize(RAY_BUDGET_NINTH, Width, Height);
+	CHECK_EQ(NumCells.x, 13);
+	CHECK_EQ(NumCells.y, 8);
+
+	uint32_t NumInside = 0, NumCornerInside = 0;
+	for (uint32_t Frame = 0; Frame < 9; Frame++)
+	{
+		const RayBudgetPoint Edge = GetTracedPixel(RAY_BUDGET_NINTH, NumCells.x - 1, 0, Frame);
+		NumInside += Edge.x < Width;
+		const RayBudgetPoint Corner = GetTracedPixel(RAY_BUDGET_NINTH, NumCells.x - 1, NumCells.y - 1, Frame);
+		NumCornerInside += Corner.x < Width && Corner.y < Height;
+	}
+	CHECK_EQ(NumInside, 3);
+	CHECK_EQ(NumCornerInside, 2);
+
+	// the pixels of partial cells are reconstructed from the neighbors on the frames their ray is lost.
+	for (uint32_t Frame = 0; Frame < 9; Frame++)
+	{
+		DenoiserImage Depth, Normal, Image;
+		Depth.Init(Width, Height, false);
+		Normal.Init(Width, Height, false);
+		Image.Init(Width, Height, false);
+		std::fill(Depth.Texels.begin(), Depth.Texels.end(), glm::vec4(0.5f));
+		std::fill(Normal.Texels.begin(), Normal.Texels.end(), glm::vec4(0.f, 0.f, 1.f, 0.f));
+		FillTraced(RAY_BUDGET_NINTH, Frame, Image, [](uint32_t x, uint32_t y) { return glm::vec4(float(x), float(y), 1.f, 1.f); });
+
+		ReconstructRayBudgetCPU(MakeReconstructCB(RAY_BUDGET_NINTH, Width, Height, Frame), Depth, Normal, Image);
+		int NumOutside = 0;
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				// a weighted mean of traced pixels at most one cell and a bit away.
+				const glm::vec4 Value = Image.Load(x, y);
+				NumOutside += std::abs(Value.x - float(x)) > 5.f || std::abs(Value.y - float(y)) > 5.f || std::abs(Value.z - 1.f) > 1e-6f;
+			}
+		}
+		CHECK_EQ(NumOutside, 0);
+	}
+}
+
+TEST_CASE(FlatConstantReconstructsExactly)
+{
+	const glm::vec4 Constant(0.25f, 1.5f, 3.f, 0.75f);
+	for (const RayBudgetPoint Size : { RayBudgetPoint{ 37, 23 }, RayBudgetPoint{ 64, 36 }, RayBudgetPoint{ 5, 4 } })
+	{
+		for (ERayBudgetMode Mode : kCellModes)
+		{
+			for (uint32_t Frame = 0; Frame < GetPeriod(Mode); Frame++)
+			{
+				DenoiserImage Depth, Normal, Image;
+				Depth.Init(Size.x, Size.y, false);
+				Normal.Init(Size.x, Size.y, false);
+				Image.Init(Size.x, Size.y, false);
+				std::fill(Depth.Texels.begin(), Depth.Texels.end(), glm::vec4(0.7f));
+				std::fill(Normal.Texels.begin(), Normal.Texels.end(), glm::vec4(0.f, 1.f, 0.f, 0.f));
+				FillTraced(Mode, Frame, Image, [&](uint32_t, uint32_t) { return Constant; });
+
+				ReconstructRayBudgetCPU(MakeReconstructCB(Mode, Size.x, Size.y, Frame), Depth, Normal, Image);
+
+				// normalized weights of equal values, only the rounding of the division is left.
+				float MaxError = 0.f;
+				for (const glm::vec4& Texel : Image.Texels)
+					MaxError = std::max(MaxError, MaxDifference(Texel, Constant));
+				if (MaxError > 1e-6f)
+					std::printf("  mode %u %ux%u frame %u: error %g\n", Mode, Size.x, Size.y, Frame, MaxError);
+				CHECK(MaxError <= 1e-6f);
+			}
+		}
+	}
+}
+
+TEST_CASE(NoLeakAcrossEdges)
+{
+	// a depth edge at x = 18 and a normal edge at y = 12, both on cell borders of every mode so each pixel
+	// has the ray of its own cell on its side. every quadrant traces a different value.
+	const uint32_t Width = 37, Height = 23;
+	auto Quadrant = [](uint32_t x, uint32_t y) { return (x < 18 ? 0 : 1) + (y < 12 ? 0 : 2); };
+	const glm::vec4 Values[4] = { glm::vec4(1.f), glm::vec4(10.f), glm::vec4(100.f), glm::vec4(1000.f) };
+
+	for (ERayBudgetMode Mode : kCellModes)
+	{
+		for (uint32_t Frame = 0; Frame < GetPeriod(Mode); Frame++)
+		{
+			DenoiserImage Depth, Normal, Image;
+			Depth.Init(Width, Height, false);
+			Normal.Init(Width, Height, false);
+			Image.Init(Width, Height, false);
+			for (uint32_t y = 0; y < Height; y++)
+			{
+				for (uint32_t x = 0; x < Width; x++)
+				{
+					Depth.Store(x, y, glm::vec4(x < 18 ? 0.2f : 0.9f));
+					Normal.Store(x, y, y < 12 ? glm::vec4(0.f, 0.f, 1.f, 0.f) : glm::vec4(0.f, 0.96f, 0.28f, 0.f));
+				}
+			}
+			FillTraced(Mode, Frame, Image, [&](uint32_t x, uint32_t y) { return Values[Quadrant(x, y)]; });
+
+			ReconstructRayBudgetCPU(MakeReconstructCB(Mode, Width, Height, Frame), Depth, Normal, Image);
+
+			// 0.28^32 of the normal weight and the depth weight of the edge are below 1e-7.
+			float MaxError = 0.f;
+			for (uint32_t y = 0; y < Height; y++)
+			{
+				for (uint32_t x = 0; x < Width; x++)
+				{
+					const glm::vec4 Expected = Values[Quadrant(x, y)];
+					MaxError = std::max(MaxError, MaxDifference(Image.Load(x, y), Expected) / Expected.x);
+				}
+			}
+			if (MaxError > 1e-5f)
+				std::printf("  mode %u frame %u: relative error %g\n", Mode, Frame, MaxError);
+			CHECK(MaxError <= 1e-5f);
+		}
+	}
+}
+
+TEST_CASE(AdaptiveTilesAndRayCount)
+{
+	// 50x40 is 5x4 tiles, the last column 2 pixels wide and the last row 4 high. every tile gets last
+	// frame's denoiser outputs of one kind, gray so the luma is the value.
+	enum ETileKind { Disoccluded, MovedIntoHole, Noisy, DiffuseNoisy, Medium, Young, Smooth, Rough };
+	const uint32_t Width = 50, Height = 40, NumTilesX = 5, NumTilesY = 4;
+	const ETileKind Kinds[NumTilesY][NumTilesX] = {
+		{ Disoccluded, MovedIntoHole, Noisy, DiffuseNoisy, Medium },
+		{ Young, Smooth, Rough, Smooth, Rough },
+		{ Rough, Rough, Smooth, Medium, Disoccluded },
+		{ Smooth, Rough, Young, Rough, Smooth },
+	};
+	const ERayBudgetMode ExpectedModes[] = { RAY_BUDGET_FULL, RAY_BUDGET_FULL, RAY_BUDGET_FULL, RAY_BUDGET_FULL,
+		RAY_BUDGET_CHECKERBOARD, RAY_BUDGET_CHECKERBOARD, RAY_BUDGET_QUARTER, RAY_BUDGET_NINTH };
+
+	DenoiserImage Specular, DiffuseSH, Velocity, Roughness;
+	Specular.Init(Width, Height, false);
+	DiffuseSH.Init(Width, Height, false);
+	Velocity.Init(Width, Height, false);
+	Roughness.Init(Width, Height, false);
+	for (uint32_t y = 0; y < Height; y++)
+	{
+		for (uint32_t x = 0; x < Width; x++)
+		{
+			const ETileKind Kind = Kinds[y / kRayBudgetTileSize][x / kRayBudgetTileSize];
+			const bool bOdd = (x + y) & 1;
+			// coefficients of variation of 0.8 and 0.3 against the 0.5 and 0.15 thresholds.
+			float Spec = 1.f, Diff = 1.f, History = 20.f;
+			if (Kind == Disoccluded)
+				History = 0.f;
+			else if (Kind == Noisy)
+				Spec = bOdd ? 1.8f : 0.2f;
+			else if (Kind == DiffuseNoisy)
+				Diff = bOdd ? 1.8f : 0.2f;
+			else if (Kind == Medium)
+				Spec = bOdd ? 1.3f : 0.7f;
+			else if (Kind == Young)
+				History = 4.f;
+
+			Specular.Store(x, y, glm::vec4(glm::vec3(Spec), History / 10.f));
+			DiffuseSH.Store(x, y, glm::vec4(0.f, 0.f, 0.f, Diff));
+			Roughness.Store(x, y, glm::vec4(Kind == Rough ? 0.8f : 0.2f, 0.f, 0.f, 0.f));
+			// converged itself, but it moved in from the disoccluded tile on its left.
+			if (Kind == MovedIntoHole)
+				Velocity.Store(x, y, glm::vec4(float(kRayBudgetTileSize) / Width, 0.f, 0.f, 0.f));
+		}
+	}
+
+	RayBudgetClassifyCB CB;
+	CB.RTSize = glm::vec2(float(Width), float(Height));
+	CB.NumTilesX = NumTilesX;
+	CB.NumTilesY = NumTilesY;
+
+	std::vector<uint8_t> TileModes;
+	std::vector<RayBudgetTileStats> Stats;
+	ClassifyRayBudgetTilesCPU(CB, Specular, DiffuseSH, Velocity, Roughness, TileModes, &Stats);
+	CHECK_EQ(TileModes.size(), NumTilesX * NumTilesY);
+	for (uint32_t TileY = 0; TileY < NumTilesY; TileY++)
+	{
+		for (uint32_t TileX = 0; TileX < NumTilesX; TileX++)
+		{
+			const uint32_t Expected = ExpectedModes[Kinds[TileY][TileX]];
+			const uint32_t Mode = TileModes[TileY * NumTilesX + TileX];
+			if (Mode != Expected)
+				std::printf("  tile %u, %u: mode %u, expected %u\n", TileX, TileY, Mode, Expected);
+			CHECK_EQ(Mode, Expected);
+		}
+	}
+
+	CHECK_NEAR(Stats[0].Disocclusion, 1.f, 1e-6f);
+	CHECK_NEAR(Stats[1].Disocclusion, 1.f, 1e-6f);
+	CHECK_NEAR(Stats[2].Variance, 0.8f, 1e-3f);
+	CHECK_NEAR(Stats[3].Variance, 0.8f, 1e-3f);
+	CHECK_NEAR(Stats[4].Variance, 0.3f, 1e-3f);
+	CHECK_NEAR(Stats[5].History, 4.f, 1e-5f);
+	CHECK_NEAR(Stats[7].Roughness, 0.8f, 1e-5f);
+	CHECK_NEAR(Stats[NumTilesX * NumTilesY - 1].Roughness, 0.2f, 1e-5f);
+
+	enki::TaskScheduler TS;
+	TS.Initialize(4);
+	std::vector<uint8_t> ThreadedModes;
+	ClassifyRayBudgetTilesCPU(CB, Specular, DiffuseSH, Velocity, Roughness, ThreadedModes, nullptr, &TS);
+	CHECK(ThreadedModes == TileModes);
+
+	// over 36 frames, a multiple of every period, each pixel of a tile is traced 36 / period times.
+	uint64_t ExpectedRays = 0;
+	for (uint32_t y = 0; y < Height; y++)
+		for (uint32_t x = 0; x < Width; x++)
+			ExpectedRays += 36 / GetPeriod(ExpectedModes[Kinds[y / kRayBudgetTileSize][x / kRayBudgetTileSize]]);
+
+	uint64_t NumRays = 0;
+	for (uint32_t Frame = 0; Frame < 36; Frame++)
+		NumRays += CountRayBudgetRays(TileModes, NumTilesX, Width, Height, Frame);
+	CHECK_EQ(NumRays, ExpectedRays);
+	CHECK(NumRays < 36ull * Width * Height * 2 / 3);
+
+	// the fixed modes against the same count.
+	for (ERayBudgetMode Mode : kCellModes)
+	{
+		const std::vector<uint8_t> Uniform(TileModes.size(), uint8_t(Mode));
+		uint64_t UniformRays = 0;
+		for (uint32_t Frame = 0; Frame < 36; Frame++)
+			UniformRays += CountRayBudgetRays(Uniform, NumTilesX, Width, Height, Frame);
+		CHECK_EQ(UniformRays, 36ull * Width * Height / GetPeriod(Mode));
+	}
+
+	// a constant image stays constant through the reconstruction of the mixed rates.
+	DenoiserImage Depth, Normal, Image;
+	Depth.Init(Width, Height, false);
+	Normal.Init(Width, Height, false);
+	Image.Init(Width, Height, false);
+	std::fill(Depth.Texels.begin(), Depth.Texels.end(), glm::vec4(0.7f));
+	std::fill(Normal.Texels.begin(), Normal.Texels.end(), glm::vec4(0.f, 1.f, 0.f, 0.f));
+	for (uint32_t Frame = 0; Frame < 36; Frame++)
+	{
+		for (uint32_t y = 0; y < Height; y++)
+		{
+			for (uint32_t x = 0; x < Width; x++)
+			{
+				const ERayBudgetMode Mode = ERayBudgetMode(TileModes[(y / kRayBudgetTileSize) * NumTilesX + x / kRayBudgetTileSize]);
+				Image.Store(x, y, IsTracedPixel(Mode, x, y, Frame) ? glm::vec4(2.f) : glm::vec4(-1000.f));
+			}
+		}
+		ReconstructRayBudgetCPU(MakeReconstructCB(RAY_BUDGET_ADAPTIVE, Width, Height, Frame), Depth, Normal, Image, &TileModes);
+
+		float MaxError = 0.f;
+		for (const glm::vec4& Texel : Image.Texels)
+			MaxError = std::max(MaxError, MaxDifference(Texel, glm::vec4(2.f)));
+		CHECK(MaxError <= 1e-6f);
+	}
+}
@@ -0,0 +1,187 @@
+#include "TestFramework.h"
+#include "RootSignatureLayout.h"
+
+#include <map>
+#include <string>
+#include <unordered_map>
+
+// canonical root signature layouts: psos binding the same registers under other names get the same
+// parameter order and hash, any other register, count, type or flag gets its own.
+namespace
+{
+	struct NamedBinding
+	{
+		std::string Name;
+		RootParamType Type;
+		uint32_t BaseRegister;
+		uint32_t NumDescriptors;
+	};
+
+	// what PipelineStateObject::Init does: bindings in name order, the root parameter index of each name.
+	RootSignatureLayout MakeLayout(const std::vector<NamedBinding>& Bindings, std::map<std::string, uint32_t>* OutRootParamIndex = nullptr)
+	{
+		std::map<std::string, const NamedBinding*> ByName;
+		for (const NamedBinding& Binding : Bindings)
+			ByName[Binding.Name] = &Binding;
+
+		RootSignatureLayout Layout;
+		Layout.SetFlags(1);
+		std::vector<std::string> Names;
+		for (auto& It : ByName)
+		{
+			Layout.AddParam(It.second->Type, It.second->BaseRegister, It.second->NumDescriptors);
+			Names.push_back(It.first);
+		}
+		Layout.Canonicalize();
+
+		if (OutRootParamIndex)
+			for (uint32_t i = 0; i < Names.size(); i++)
+				(*OutRootParamIndex)[Names[i]] = Layout.GetRootParamIndex(i);
+		return Layout;
+	}
+
+	// RootSignatureCache::FindOrCreate without the device, the number of root signatures created.
+	struct FakeRootSignatureCache
+	{
+		std::unordered_map<uint64_t, std::vector<RootSignatureLayout>> Entries;
+		uint32_t NumRootSignatures = 0;
+
+		void FindOrCreate(const RootSignatureLayout& Layout)
+		{
+			std::vector<RootSignatureLayout>& Bucket = Entries[Layout.GetHash()];
+			for (const RootSignatureLayout& Cached : Bucket)
+				if (Cached == Layout)
+					return;
+			Bucket.push_back(Layout);
+			NumRootSignatures++;
+		}
+	};
+
+	const std::vector<NamedBinding> ToneMapBindings = {
+		{ "SrcTex", RootParamType::SRVTable, 0, 1 },
+		{ "Exposure", RootParamType::SRVTable, 1, 1 },
+		{ "samplerWrap", RootParamType::SamplerTable, 0, 1 },
+		{ "ScaleOffsetParams", RootParamType::CBVTable, 0, 1 },
+	};
+}
+
+TEST_CASE(SameRegistersShareALayout)
+{
+	// the same registers under other names, so the name order differs.
+	const std::vector<NamedBinding> Renamed = {
+		{ "ZInput", RootParamType::SRVTable, 0, 1 },
+		{ "AExposure", RootParamType::SRVTable, 1, 1 },
+		{ "Linear", RootParamType::SamplerTable, 0, 1 },
+		{ "BParams", RootParamType::CBVTable, 0, 1 },
+	};
+
+	std::map<std::string, uint32_t> ToneMapIndex, RenamedIndex;
+	const RootSignatureLayout ToneMap = MakeLayout(ToneMapBindings, &ToneMapIndex);
+	const RootSignatureLayout Other = MakeLayout(Renamed, &RenamedIndex);
+	CHECK(ToneMap == Other);
+	CHECK_EQ(ToneMap.GetHash(), Other.GetHash());
+	CHECK(ToneMap.GetHash() != 0);
+
+	// every name ends up at the parameter of its register in both psos.
+	CHECK_EQ(ToneMapIndex["SrcTex"], RenamedIndex["ZInput"]);
+	CHECK_EQ(ToneMapIndex["Exposure"], RenamedIndex["AExposure"]);
+	CHECK_EQ(ToneMapIndex["samplerWrap"], RenamedIndex["Linear"]);
+	CHECK_EQ(ToneMapIndex["ScaleOffsetParams"], RenamedIndex["BParams"]);
+	for (const NamedBinding& Binding : ToneMapBindings)
+	{
+		const RootParamDesc& Param = ToneMap.GetParams()[ToneMapIndex[Binding.Name]];
+		CHECK(Param.Type == Binding.Type);
+		CHECK_EQ(Param.BaseRegister, Binding.BaseRegister);
+	}
+
+	// one root signature for both.
+	FakeRootSignatureCache Cache;
+	Cache.FindOrCreate(ToneMap);
+	Cache.FindOrCreate(Other);
+	CHECK_EQ(Cache.NumRootSignatures, 1);
+}
+
+TEST_CASE(CanonicalParameterOrder)
+{
+	RootSignatureLayout Layout;
+	const uint32_t Uav = Layout.AddParam(RootParamType::UAVTable, 0, 1);
+	const uint32_t Cbv = Layout.AddParam(RootParamType::CBVTable, 0, 1);
+	const uint32_t Srv3 = Layout.AddParam(RootParamType::SRVTable, 3, 1);
+	const uint32_t Srv0Two = Layout.AddParam(RootParamType::SRVTable, 0, 2);
+	const uint32_t Srv0 = Layout.AddParam(RootParamType::SRVTable, 0, 1);
+	const uint32_t Constants = Layout.AddParam(RootParamType::Constants, 1, 4);
+	const uint32_t Sampler = Layout.AddParam(RootParamType::SamplerTable, 0, 1);
+	CHECK_EQ(Uav, 0);
+	CHECK_EQ(Sampler, 6);
+	Layout.Canonicalize();
+
+	// by type, then register, then count.
+	CHECK_EQ(Layout.GetRootParamIndex(Srv0), 0);
+	CHECK_EQ(Layout.GetRootParamIndex(Srv0Two), 1);
+	CHECK_EQ(Layout.GetRootParamIndex(Srv3), 2);
+	CHECK_EQ(Layout.GetRootParamIndex(Uav), 3);
+	CHECK_EQ(Layout.GetRootParamIndex(Cbv), 4);
+	CHECK_EQ(Layout.GetRootParamIndex(Sampler), 5);
+	CHECK_EQ(Layout.GetRootParamIndex(Constants), 6);
+	CHECK_EQ(Layout.GetParams()[1].NumDescriptors, 2);
+
+	// sorting again keeps the order, the indices and the hash.
+	const uint64_t Hash = Layout.GetHash();
+	Layout.Canonicalize();
+	CHECK_EQ(Layout.GetHash(), Hash);
+	CHECK_EQ(Layout.GetRootParamIndex(Srv0), 0);
+	CHECK_EQ(Layout.GetRootParamIndex(Constants), 6);
+}
+
+TEST_CASE(DifferentLayoutsHashApart)
+{
+	const RootSignatureLayout ToneMap = MakeLayout(ToneMapBindings);
+	FakeRootSignatureCache Cache;
+	Cache.FindOrCreate(ToneMap);
+
+	// one change at a time, each is a new root signature.
+	std::vector<std::vector<NamedBinding>> Variants(4, ToneMapBindings);
+	Variants[0][1].BaseRegister = 2;
+	Variants[1][1].NumDescriptors = 2;
+	Variants[2][3].Type = RootParamType::Constants;
+	Variants[3].pop_back();
+	for (const std::vector<NamedBinding>& Variant : Variants)
+	{
+		const RootSignatureLayout Layout = MakeLayout(Variant);
+		CHECK(!(Layout == ToneMap));
+		CHECK(Layout.GetHash() != ToneMap.GetHash());
+		Cache.FindOrCreate(Layout);
+	}
+
+	RootSignatureLayout Flags = MakeLayout(ToneMapBindings);
+	Flags.SetFlags(0);
+	Flags.Canonicalize();
+	CHECK(!(Flags == ToneMap));
+	CHECK(Flags.GetHash() != ToneMap.GetHash());
+	Cache.FindOrCreate(Flags);
+
+	CHECK_EQ(Cache.NumRootSignatures, 6);
+
+	// the empty layout of a pso without bindings still has a hash of its own.
+	RootSignatureLayout Empty;
+	Empty.Canonicalize();
+	CHECK(Empty.GetParams().empty());
+	CHECK(Empty.GetHash() != ToneMap.GetHash());
+}
+
+TEST_CASE(HashCollisionsCompareTheLayout)
+{
+	// two layouts forced into one bucket, the cache still tells them apart by the parameters.
+	const RootSignatureLayout A = MakeLayout(ToneMapBindings);
+	std::vector<NamedBinding> Bindings = ToneMapBindings;
+	Bindings[0].BaseRegister = 5;
+	const RootSignatureLayout B = MakeLayout(Bindings);
+
+	FakeRootSignatureCache Cache;
+	Cache.Entries[A.GetHash()].push_back(B);
+	Cache.FindOrCreate(A);
+	CHECK_EQ(Cache.NumRootSignatures, 1);
+	CHECK_EQ(Cache.Entries[A.GetHash()].size(), 2);
+	Cache.FindOrCreate(A);
+	CHECK_EQ(Cache.NumRootSignatures, 1);
+}
@@ -0,0 +1,110 @@
+#include "TestFramework.h"
+#include "SceneCulling.h"
+
+#include "enkiTS/TaskScheduler.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <cstdio>
+#include <random>
+
+// CullCPU on 100k instances scattered around the camera, against a plain scalar loop. the hi-z is a wall
+// across the lower half of the screen, what a floor or a building in front of the camera gives. the
+// results are checked in SceneCullingTests.cpp.
+namespace
+{
+	const uint32_t kNumInstances = 100000;
+	const float kFieldSize = 4000.f;
+	const float kWallDistance = 300.f;
+
+	glm::mat4 MakeViewProj()
+	{
+		const glm::mat4 View = glm::lookAtLH(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 1.f, 0.f));
+		return glm::perspectiveLH_ZO(glm::radians(60.f), 16.f / 9.f, 1.f, 10000.f) * View;
+	}
+
+	// unit boxes of up to 20 units under random rotations, like the shader ball rows of the scene.
+	void MakeBounds(CullingBounds& Bounds)
+	{
+		std::mt19937 Rng(1);
+		std::uniform_real_distribution<float> Position(-kFieldSize * 0.5f, kFieldSize * 0.5f);
+		std::uniform_real_distribution<float> Unit(0.f, 1.f);
+
+		Bounds.Clear();
+		for (uint32_t i = 0; i < kNumInstances; i++)
+		{
+			glm::mat4 Transform = glm::translate(glm::mat4(1.f), glm::vec3(Position(Rng), Position(Rng), Position(Rng)));
+			Transform = glm::rotate(Transform, Unit(Rng) * 6.28f, glm::normalize(glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) + 0.01f));
+			Transform = glm::scale(Transform, glm::vec3(1.f + 19.f * Unit(Rng)));
+
+			glm::vec3 Min, Max;
+			TransformBounds(Transform, glm::vec3(-0.5f), glm::vec3(0.5f), Min, Max);
+			Bounds.Add(Min, Max);
+		}
+	}
+
+	// the frustum test of CullCPU one box at a time.
+	uint32_t CullScalar(const CullingBounds& Bounds, const glm::mat4& ViewProj, std::vector<uint8_t>& Visible)
+	{
+		glm::vec4 Planes[6];
+		GetFrustumPlanes(ViewProj, Planes);
+
+		Visible.resize(Bounds.Count);
+		uint32_t NumVisible = 0;
+		for (uint32_t i = 0; i < Bounds.Count; i++)
+		{
+			bool bVisible = true;
+			for (const glm::vec4& P : Planes)
+			{
+				const float X = P.x > 0.f ? Bounds.MaxX[i] : Bounds.MinX[i];
+				const float Y = P.y > 0.f ? Bounds.MaxY[i] : Bounds.MinY[i];
+				const float Z = P.z > 0.f ? Bounds.MaxZ[i] : Bounds.MinZ[i];
+				bVisible &= X * P.x + Y * P.y + Z * P.z + P.w >= 0.f;
+			}
+			Visible[i] = bVisible ? 1 : 0;
+			NumVisible += Visible[i];
+		}
+		return NumVisible;
+	}
+
+	void MakeHiZ(const glm::mat4& ViewProj, HiZBuffer& HiZ)
+	{
+		const glm::vec4 Clip = ViewProj * glm::vec4(0.f, 0.f, kWallDistance, 1.f);
+		const float WallDepth = Clip.z / Clip.w;
+
+		std::vector<float> Depth(size_t(kHiZWidth) * kHiZHeight, 1.f);
+		for (uint32_t y = kHiZHeight / 2; y < kHiZHeight; y++)
+			for (uint32_t x = 0; x < kHiZWidth; x++)
+				Depth[size_t(y) * kHiZWidth + x] = WallDepth;
+		HiZ.Build(Depth.data(), kHiZWidth, kHiZHeight, ViewProj);
+	}
+}
+
+BENCHMARK(SceneCulling100k)
+{
+	enki::TaskScheduler TS;
+	TS.Initialize();
+
+	CullingBounds Bounds;
+	const double BuildMs = MeasureMs([&]() { MakeBounds(Bounds); }, 1, 3);
+	std::printf("  %u instances, bounds %.2f ms\n", Bounds.Count, BuildMs);
+
+	const glm::mat4 ViewProj = MakeViewProj();
+	std::vector<uint8_t> Visible, ScalarVisible;
+	CullingStats Stats;
+
+	uint32_t NumScalarVisible = 0;
+	const double ScalarMs = MeasureMs([&]() { NumScalarVisible = CullScalar(Bounds, ViewProj, ScalarVisible); }, 20);
+	std::printf("  frustum scalar: %.3f ms, %u visible\n", ScalarMs, NumScalarVisible);
+
+	const double SerialMs = MeasureMs([&]() { CullCPU(Bounds, ViewProj, nullptr, Visible, Stats, nullptr); }, 20);
+	std::printf("  frustum sse, 1 thread: %.3f ms, %u visible\n", SerialMs, Stats.NumVisible);
+
+	const double ThreadedMs = MeasureMs([&]() { CullCPU(Bounds, ViewProj, nullptr, Visible, Stats, &TS); }, 20);
+	std::printf("  frustum sse, %u threads: %.3f ms\n", TS.GetNumTaskThreads(), ThreadedMs);
+
+	HiZBuffer HiZ;
+	MakeHiZ(ViewProj, HiZ);
+	const double OcclusionMs = MeasureMs([&]() { CullCPU(Bounds, ViewProj, &HiZ, Visible, Stats, &TS); }, 20);
+	std::printf("  frustum + hi-z, %u threads: %.3f ms, %u visible, %u occluded\n", TS.GetNumTaskThreads(), OcclusionMs,
+		Stats.NumVisible, Stats.NumOcclusionCulled);
+}
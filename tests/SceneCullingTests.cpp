@@ -0,0 +1,196 @@
+#include "TestFramework.h"
+#include "SceneCulling.h"
+
+#include "enkiTS/TaskScheduler.h"
+#include "glm/gtc/matrix_transform.hpp"
+
+#include <random>
+
+// the sse frustum test of CullCPU against a plain scalar loop, and the hi-z occlusion test against a wall
+// across the lower half of the screen. the timings are in SceneCullingBench.cpp.
+namespace
+{
+	const float kWallDistance = 300.f;
+
+	glm::mat4 MakeViewProj()
+	{
+		const glm::mat4 View = glm::lookAtLH(glm::vec3(0.f), glm::vec3(0.f, 0.f, 1.f), glm::vec3(0.f, 1.f, 0.f));
+		return glm::perspectiveLH_ZO(glm::radians(60.f), 16.f / 9.f, 1.f, 10000.f) * View;
+	}
+
+	// unit boxes of up to 20 units under random rotations, like the shader ball rows of the scene.
+	void MakeBounds(CullingBounds& Bounds, uint32_t NumInstances)
+	{
+		std::mt19937 Rng(1);
+		std::uniform_real_distribution<float> Position(-2000.f, 2000.f);
+		std::uniform_real_distribution<float> Unit(0.f, 1.f);
+
+		Bounds.Clear();
+		for (uint32_t i = 0; i < NumInstances; i++)
+		{
+			glm::mat4 Transform = glm::translate(glm::mat4(1.f), glm::vec3(Position(Rng), Position(Rng), Position(Rng)));
+			Transform = glm::rotate(Transform, Unit(Rng) * 6.28f, glm::normalize(glm::vec3(Unit(Rng), Unit(Rng), Unit(Rng)) + 0.01f));
+			Transform = glm::scale(Transform, glm::vec3(1.f + 19.f * Unit(Rng)));
+
+			glm::vec3 Min, Max;
+			TransformBounds(Transform, glm::vec3(-0.5f), glm::vec3(0.5f), Min, Max);
+			Bounds.Add(Min, Max);
+		}
+	}
+
+	// the frustum test of CullCPU one box at a time.
+	uint32_t CullScalar(const CullingBounds& Bounds, const glm::mat4& ViewProj, std::vector<uint8_t>& Visible)
+	{
+		glm::vec4 Planes[6];
+		GetFrustumPlanes(ViewProj, Planes);
+
+		Visible.resize(Bounds.Count);
+		uint32_t NumVisible = 0;
+		for (uint32_t i = 0; i < Bounds.Count; i++)
+		{
+			bool bVisible = true;
+			for (const glm::vec4& P : Planes)
+			{
+				const float X = P.x > 0.f ? Bounds.MaxX[i] : Bounds.MinX[i];
+				const float Y = P.y > 0.f ? Bounds.MaxY[i] : Bounds.MinY[i];
+				const float Z = P.z > 0.f ? Bounds.MaxZ[i] : Bounds.MinZ[i];
+				bVisible &= X * P.x + Y * P.y + Z * P.z + P.w >= 0.f;
+			}
+			Visible[i] = bVisible ? 1 : 0;
+			NumVisible += Visible[i];
+		}
+		return NumVisible;
+	}
+
+	void MakeHiZ(const glm::mat4& ViewProj, HiZBuffer& HiZ)
+	{
+		const glm::vec4 Clip = ViewProj * glm::vec4(0.f, 0.f, kWallDistance, 1.f);
+		const float WallDepth = Clip.z / Clip.w;
+
+		std::vector<float> Depth(size_t(kHiZWidth) * kHiZHeight, 1.f);
+		for (uint32_t y = kHiZHeight / 2; y < kHiZHeight; y++)
+			for (uint32_t x = 0; x < kHiZWidth; x++)
+				Depth[size_t(y) * kHiZWidth + x] = WallDepth;
+		HiZ.Build(Depth.data(), kHiZWidth, kHiZHeight, ViewProj);
+	}
+}
+
+TEST_CASE(FrustumMatchesScalar)
+{
+	enki::TaskScheduler TS;
+	TS.Initialize(4);
+
+	const glm::mat4 ViewProj = MakeViewProj();
+	// counts that aren't a multiple of 4 pad the last group of boxes.
+	for (uint32_t NumInstances : { 1u, 3u, 4u, 10001u, 100000u })
+	{
+		CullingBounds Bounds;
+		MakeBounds(Bounds, NumInstances);
+		CHECK_EQ(Bounds.Count, NumInstances);
+		CHECK_EQ(Bounds.MinX.size() % 4, 0);
+
+		std::vector<uint8_t> ScalarVisible;
+		const uint32_t NumScalarVisible = CullScalar(Bounds, ViewProj, ScalarVisible);
+
+		std::vector<uint8_t> Visible;
+		CullingStats Stats;
+		CullCPU(Bounds, ViewProj, nullptr, Visible, Stats, nullptr);
+		CHECK(Visible == ScalarVisible);
+		CHECK_EQ(Stats.NumTested, NumInstances);
+		CHECK_EQ(Stats.NumVisible, NumScalarVisible);
+		CHECK_EQ(Stats.NumFrustumCulled, NumInstances - NumScalarVisible);
+		CHECK_EQ(Stats.NumOcclusionCulled, 0);
+
+		CullCPU(Bounds, ViewProj, nullptr, Visible, Stats, &TS);
+		CHECK(Visible == ScalarVisible);
+		CHECK_EQ(Stats.NumVisible, NumScalarVisible);
+	}
+}
+
+TEST_CASE(FrustumPlanes)
+{
+	const glm::mat4 ViewProj = MakeViewProj();
+	const struct { glm::vec3 Min, Max; uint8_t bVisible; } Boxes[] = {
+		{ glm::vec3(-1.f, -1.f, 10.f), glm::vec3(1.f, 1.f, 12.f), 1 },			// in front
+		{ glm::vec3(-1.f, -1.f, -12.f), glm::vec3(1.f, 1.f, -10.f), 0 },		// behind the camera
+		{ glm::vec3(-1.f, -1.f, 10010.f), glm::vec3(1.f, 1.f, 10020.f), 0 },	// beyond the far plane
+		{ glm::vec3(-1.f, -1.f, 9990.f), glm::vec3(1.f, 1.f, 10020.f), 1 },		// across the far plane
+		{ glm::vec3(-200.f, -1.f, 10.f), glm::vec3(-100.f, 1.f, 12.f), 0 },		// left of the view
+		{ glm::vec3(-200.f, -1.f, 10.f), glm::vec3(0.f, 1.f, 12.f), 1 },		// across the left plane
+		{ glm::vec3(-1.f, 50.f, 10.f), glm::vec3(1.f, 60.f, 12.f), 0 },			// above
+		{ glm::vec3(-1.f, -1.f, -1.f), glm::vec3(1.f, 1.f, 1.f), 1 },			// around the camera
+	};
+
+	CullingBounds Bounds;
+	std::vector<uint8_t> Expected;
+	for (const auto& Box : Boxes)
+	{
+		Bounds.Add(Box.Min, Box.Max);
+		Expected.push_back(Box.bVisible);
+	}
+
+	std::vector<uint8_t> Visible;
+	CullingStats Stats;
+	CullCPU(Bounds, ViewProj, nullptr, Visible, Stats, nullptr);
+	CHECK(Visible == Expected);
+}
+
+TEST_CASE(HiZOcclusion)
+{
+	const glm::mat4 ViewProj = MakeViewProj();
+	HiZBuffer HiZ;
+	MakeHiZ(ViewProj, HiZ);
+	CHECK(HiZ.IsValid());
+	CHECK(HiZ.GetNumMips() > 1);
+
+	// the wall covers ndc y < 0 at 300 units.
+	CHECK(HiZ.IsOccluded(glm::vec3(-5.f, -40.f, 400.f), glm::vec3(5.f, -30.f, 410.f)));
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5.f, -40.f, 200.f), glm::vec3(5.f, -30.f, 210.f)));
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5.f, 30.f, 400.f), glm::vec3(5.f, 40.f, 410.f)));
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5.f, -40.f, 290.f), glm::vec3(5.f, -30.f, 410.f)));
+	// peeking over the top of the wall.
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5.f, -10.f, 400.f), glm::vec3(5.f, 10.f, 410.f)));
+	// across the near plane or outside of the view, never occluded.
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5.f, -40.f, 0.5f), glm::vec3(5.f, -30.f, 410.f)));
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5.f, -40.f, -10.f), glm::vec3(5.f, -30.f, 410.f)));
+	CHECK(!HiZ.IsOccluded(glm::vec3(-5000.f, -40.f, 400.f), glm::vec3(-4000.f, -30.f, 410.f)));
+
+	enki::TaskScheduler TS;
+	TS.Initialize(4);
+
+	CullingBounds Bounds;
+	MakeBounds(Bounds, 100000);
+	std::vector<uint8_t> ScalarVisible;
+	const uint32_t NumScalarVisible = CullScalar(Bounds, ViewProj, ScalarVisible);
+
+	std::vector<uint8_t> Visible;
+	CullingStats Stats;
+	CullCPU(Bounds, ViewProj, &HiZ, Visible, Stats, &TS);
+	CHECK(Stats.NumOcclusionCulled > 0);
+	CHECK_EQ(Stats.NumVisible + Stats.NumOcclusionCulled, NumScalarVisible);
+
+	// only boxes the frustum keeps are occluded, and only those entirely behind the wall and below the
+	// horizon.
+	int NumWrong = 0;
+	uint32_t NumOccluded = 0;
+	for (uint32_t i = 0; i < Bounds.Count; i++)
+	{
+		if (Visible[i] || !ScalarVisible[i])
+			continue;
+		NumOccluded++;
+		NumWrong += Bounds.MinZ[i] <= kWallDistance || Bounds.MaxY[i] > 0.f;
+	}
+	CHECK_EQ(NumWrong, 0);
+	CHECK_EQ(NumOccluded, Stats.NumOcclusionCulled);
+
+	// serial gives the same.
+	std::vector<uint8_t> SerialVisible;
+	CullCPU(Bounds, ViewProj, &HiZ, SerialVisible, Stats, nullptr);
+	CHECK(SerialVisible == Visible);
+
+	// without a valid hi-z only the frustum test runs.
+	HiZ.Invalidate();
+	CullCPU(Bounds, ViewProj, &HiZ, Visible, Stats, &TS);
+	CHECK(Visible == ScalarVisible);
+	CHECK_EQ(Stats.NumOcclusionCulled, 0);
+}
@@ -0,0 +1,353 @@
+#include "TestFramework.h"
+#include "TemporalAACPU.h"
+
+#include "enkiTS/TaskScheduler.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// TemporalAACPU against a plain scalar port of TemporalAA.hlsl for every filter and clamp mode, and
+// against golden images in tests/golden for the filters the renderer uses. the goldens are 8 bit ppm
+// of x / (1 + x), a texel may be off by one step. CORONA_UPDATE_GOLDEN=1 rewrites them.
+namespace
+{
+	const uint32_t kWidth = 60;
+	const uint32_t kHeight = 44;
+	const glm::vec2 kShift = glm::vec2(1.5f, -0.75f);
+
+	// edges, a gradient and a few highlights, all positive like lit color.
+	glm::vec4 Pattern(float x, float y)
+	{
+		const bool bChecker = (int(std::floor(x / 6.f)) + int(std::floor(y / 5.f))) & 1;
+		glm::vec3 Color = bChecker ? glm::vec3(0.8f, 0.6f, 0.3f) : glm::vec3(0.1f, 0.2f, 0.35f);
+		Color += glm::vec3(x / kWidth, y / kHeight, 0.5f * std::sin(x * 0.7f) * std::sin(y * 0.9f) + 0.5f) * 0.2f;
+		if ((int(x) * 7 + int(y) * 13) % 37 == 0)
+			Color += glm::vec3(6.f, 5.f, 4.f);
+		return glm::vec4(Color, 1.f);
+	}
+
+	struct Inputs
+	{
+		DenoiserImage Current;
+		DenoiserImage Prev;
+		DenoiserImage Velocity;
+
+		Inputs()
+		{
+			Current.Init(kWidth, kHeight, true);
+			Prev.Init(kWidth, kHeight, true);
+			Velocity.Init(kWidth, kHeight, true);
+			for (uint32_t y = 0; y < kHeight; y++)
+			{
+				for (uint32_t x = 0; x < kWidth; x++)
+				{
+					Current.Store(x, y, Pattern(float(x), float(y)));
+					// last frame moved by kShift, with a disocclusion the velocity doesn't explain.
+					Prev.Store(x, y, x > 40 && y < 12 ? glm::vec4(3.f, 0.f, 3.f, 1.f) : Pattern(x + kShift.x, y + kShift.y));
+					Velocity.Store(x, y, glm::vec4(-kShift.x / kWidth, -kShift.y / kHeight, 0, 0));
+				}
+			}
+		}
+	};
+
+	const float kPi = 3.14159265359f;
+
+	float CubicRef(float x, float B, float C)
+	{
+		if (x < 1)
+			return ((12 - 9 * B - 6 * C) * x * x * x + (-18 + 12 * B + 6 * C) * x * x + (6 - 2 * B)) / 6.f;
+		if (x <= 2)
+			return ((-B - 6 * C) * x * x * x + (6 * B + 30 * C) * x * x + (-12 * B - 48 * C) * x + (8 * B + 24 * C)) / 6.f;
+		return 0.f;
+	}
+
+	float FilterRef(float x, int32_t FilterType)
+	{
+		switch (FilterType)
+		{
+		case 0: return x <= 1.f ? 1.f : 0.f;
+		case 1: return glm::clamp(1.f - x, 0.f, 1.f);
+		case 2: return 1.f / std::sqrt(2.f * 3.14159f * 0.25f) * std::exp(-(x * x) / 0.5f);
+		case 3: { const float t = 1.f - x; return glm::clamp(0.35875f - 0.48829f * std::cos(kPi * t) + 0.14128f * std::cos(2 * kPi * t) - 0.01168f * std::cos(3 * kPi * t), 0.f, 1.f); }
+		case 4: return 1.f - glm::smoothstep(0.f, 1.f, x);
+		case 5: return CubicRef(x * 2.f, 1.f, 0.f);
+		case 6: return CubicRef(x * 2.f, 0.f, 0.5f);
+		case 7: return CubicRef(x * 2.f, 1 / 3.f, 1 / 3.f);
+		case 8: return CubicRef(x * 2.f, 0.33f, 0.33f);
+		case 9: { const float s = x * 2.f; return s < 0.001f ? 1.f : std::sin(s * kPi) / (s * kPi); }
+		default: return 1.f;
+		}
+	}
+
+	glm::vec3 ClipAABBRef(glm::vec3 Min, glm::vec3 Max, glm::vec3 Prev)
+	{
+		const glm::vec3 P = 0.5f * (Max + Min);
+		const glm::vec3 E = 0.5f * (Max - Min);
+		const glm::vec3 V = Prev - P;
+		const glm::vec3 A = glm::abs(V / E);
+		const float M = std::fmax(A.x, std::fmax(A.y, A.z));
+		return M > 1.f ? P + V / M : Prev;
+	}
+
+	glm::vec3 BilinearWrapRef(const DenoiserImage& Img, glm::vec2 UV)
+	{
+		const glm::vec2 F = UV * glm::vec2(Img.Width, Img.Height) - 0.5f;
+		const glm::vec2 F0 = glm::floor(F);
+		const glm::vec2 A = F - F0;
+		auto Fetch = [&](float x, float y)
+		{
+			const int32_t ix = ((int32_t(x) % int32_t(Img.Width)) + Img.Width) % Img.Width;
+			const int32_t iy = ((int32_t(y) % int32_t(Img.Height)) + Img.Height) % Img.Height;
+			return glm::vec3(Img.Texels[size_t(iy) * Img.Width + ix]);
+		};
+		const glm::vec3 Top = glm::mix(Fetch(F0.x, F0.y), Fetch(F0.x + 1, F0.y), A.x);
+		const glm::vec3 Bottom = glm::mix(Fetch(F0.x, F0.y + 1), Fetch(F0.x + 1, F0.y + 1), A.x);
+		return glm::mix(Top, Bottom, A.y);
+	}
+
+	// TemporalAA.hlsl one texel at a time.
+	glm::vec3 ResolveRef(const TemporalAAParam& CB, ETAAClampMode ClampMode, int32_t FilterType, const Inputs& In, int32_t x, int32_t y)
+	{
+		glm::vec3 Min(99999999.f), Max(-99999999.f), M1(0.f), M2(0.f), Filtered(0.f);
+		float FilteredWeight = 0.f;
+		for (int32_t j = -1; j <= 1; j++)
+		{
+			for (int32_t i = -1; i <= 1; i++)
+			{
+				const int32_t sx = glm::clamp(x + i, 0, int32_t(kWidth) - 1);
+				const int32_t sy = glm::clamp(y + j, 0, int32_t(kHeight) - 1);
+				const glm::vec3 Sample = glm::vec3(In.Current.Texels[size_t(sy) * kWidth + sx]);
+				Min = glm::min(Min, Sample);
+				Max = glm::max(Max, Sample);
+				M1 += Sample;
+				M2 += Sample * Sample;
+				const float Weight = FilterRef(std::sqrt(float(i * i + j * j)), FilterType);
+				Filtered += Sample * Weight;
+				FilteredWeight += Weight;
+			}
+		}
+
+		const glm::vec3 Current = FilterType >= 0 ? Filtered / std::max(FilteredWeight, 0.00001f) : glm::vec3(In.Current.Texels[size_t(y) * kWidth + x]);
+		const glm::vec2 Velocity = glm::vec2(In.Velocity.Texels[size_t(y) * kWidth + x]);
+		glm::vec3 Prev = BilinearWrapRef(In.Prev, (glm::vec2(x + 0.5f, y + 0.5f) - Velocity * CB.RTSize) / CB.RTSize);
+
+		if (ClampMode == TAA_RGB_CLAMP)
+		{
+			Prev = glm::clamp(Prev, Min, Max);
+		}
+		else if (ClampMode == TAA_AABB_CLIP)
+		{
+			Prev = ClipAABBRef(Min, Max, Prev);
+		}
+		else
+		{
+			const glm::vec3 Mu = M1 / 9.f;
+			const glm::vec3 Sigma = glm::sqrt(glm::abs(M2 / 9.f - Mu * Mu));
+			Prev = ClipAABBRef(Mu - 1.5f * Sigma, Mu + 1.5f * Sigma, Prev);
+		}
+
+		const glm::vec3 TemporalWeight = glm::clamp(glm::abs(Max - Min) / Current, 0.f, 1.f);
+		glm::vec3 WeightB = glm::clamp(glm::mix(glm::vec3(0.25f), glm::vec3(0.85f), TemporalWeight), 0.f, 1.f);
+		if (CB.TAABlendFactor >= 1.f)
+			WeightB = glm::vec3(0.f);
+		const glm::vec3 WeightA = 1.f - WeightB;
+		return (Current * WeightA + Prev * WeightB) / (WeightA + WeightB);
+	}
+
+	// largest difference relative to max(1, |reference|).
+	float CompareToRef(const TemporalAAParam& CB, ETAAClampMode ClampMode, int32_t FilterType, const Inputs& In, const DenoiserImage& Out)
+	{
+		float MaxError = 0.f;
+		for (uint32_t y = 0; y < kHeight; y++)
+		{
+			for (uint32_t x = 0; x < kWidth; x++)
+			{
+				const glm::vec3 Ref = ResolveRef(CB, ClampMode, FilterType, In, int32_t(x), int32_t(y));
+				const glm::vec3 Diff = glm::abs(glm::vec3(Out.Texels[size_t(y) * kWidth + x]) - Ref) / glm::max(glm::abs(Ref), glm::vec3(1.f));
+				MaxError = std::max(MaxError, std::max(Diff.x, std::max(Diff.y, Diff.z)));
+			}
+		}
+		return MaxError;
+	}
+
+	TemporalAAParam MakeParam(float BlendFactor)
+	{
+		TemporalAAParam CB;
+		CB.RTSize = glm::vec2(kWidth, kHeight);
+		CB.TAABlendFactor = BlendFactor;
+		return CB;
+	}
+
+	uint8_t Encode(float Value)
+	{
+		Value = std::max(Value, 0.f);
+		return uint8_t(std::min(Value / (1.f + Value), 1.f) * 255.f + 0.5f);
+	}
+
+	std::string GoldenPath(ETAAClampMode ClampMode, int32_t FilterType)
+	{
+		const char* ClampNames[] = { "RGBClamp", "AABBClip", "VarianceClip" };
+		return std::string(CORONA_TEST_GOLDEN_DIR) + "/TemporalAA_" + ClampNames[ClampMode] + "_Filter" + std::to_string(FilterType) + ".ppm";
+	}
+
+	// the largest difference in 8 bit steps, -1 when the golden can't be read.
+	int CompareToGolden(const DenoiserImage& Out, const std::string& Path)
+	{
+		std::vector<uint8_t> Encoded;
+		for (const glm::vec4& Texel : Out.Texels)
+			for (int c = 0; c < 3; c++)
+				Encoded.push_back(Encode(Texel[c]));
+
+		const std::string Header = "P6\n" + std::to_string(Out.Width) + " " + std::to_string(Out.Height) + "\n255\n";
+
+		const char* Update = std::getenv("CORONA_UPDATE_GOLDEN");
+		if (Update && Update[0] == '1')
+		{
+			std::ofstream File(Path, std::ios::binary);
+			File << Header;
+			File.write(reinterpret_cast<const char*>(Encoded.data()), Encoded.size());
+		}
+
+		std::ifstream File(Path, std::ios::binary);
+		std::string FileHeader(Header.size(), '\0');
+		std::vector<uint8_t> Golden(Encoded.size());
+		File.read(&FileHeader[0], FileHeader.size());
+		File.read(reinterpret_cast<char*>(Golden.data()), Golden.size());
+		if (!File || FileHeader != Header)
+			return -1;
+
+		int MaxDiff = 0;
+		for (size_t i = 0; i < Golden.size(); i++)
+			MaxDiff = std::max(MaxDiff, std::abs(int(Golden[i]) - int(Encoded[i])));
+		return MaxDiff;
+	}
+}
+
+TEST_CASE(MatchesShaderForEveryFilterAndClampMode)
+{
+	const Inputs In;
+	const TemporalAAParam CB = MakeParam(0.1f);
+
+	for (uint32_t ClampMode = 0; ClampMode < TAA_CLAMP_MODE_COUNT; ClampMode++)
+	{
+		for (int32_t FilterType = kTAAFilterNone; FilterType < kTAAFilterCount; FilterType++)
+		{
+			DenoiserImage Out;
+			TemporalAACPU(CB, ETAAClampMode(ClampMode), FilterType, In.Current, In.Prev, In.Velocity, Out);
+			CHECK_EQ(Out.Width, kWidth);
+			CHECK_EQ(Out.Height, kHeight);
+
+			const float Error = CompareToRef(CB, ETAAClampMode(ClampMode), FilterType, In, Out);
+			if (Error > 1e-4f)
+				std::printf("  clamp mode %u filter %d: error %g\n", ClampMode, FilterType, Error);
+			CHECK(Error <= 1e-4f);
+		}
+	}
+}
+
+TEST_CASE(MatchesGoldenImages)
+{
+	const Inputs In;
+	const TemporalAAParam CB = MakeParam(0.1f);
+
+	// the center sample and catmull-rom.
+	for (uint32_t ClampMode = 0; ClampMode < TAA_CLAMP_MODE_COUNT; ClampMode++)
+	{
+		for (int32_t FilterType : { kTAAFilterNone, 6 })
+		{
+			DenoiserImage Out;
+			TemporalAACPU(CB, ETAAClampMode(ClampMode), FilterType, In.Current, In.Prev, In.Velocity, Out);
+
+			const std::string Path = GoldenPath(ETAAClampMode(ClampMode), FilterType);
+			const int Diff = CompareToGolden(Out, Path);
+			if (Diff != 0)
+				std::printf("  %s: %d steps off\n", Path.c_str(), Diff);
+			CHECK(Diff >= 0 && Diff <= 1);
+		}
+	}
+}
+
+TEST_CASE(ThreadsDontChangeTheResult)
+{
+	enki::TaskScheduler TS;
+	TS.Initialize(4);
+
+	const Inputs In;
+	const TemporalAAParam CB = MakeParam(0.1f);
+
+	DenoiserImage Serial, Parallel;
+	TemporalAACPU(CB, TAA_VARIANCE_CLIP, 6, In.Current, In.Prev, In.Velocity, Serial);
+	TemporalAACPU(CB, TAA_VARIANCE_CLIP, 6, In.Current, In.Prev, In.Velocity, Parallel, &TS);
+	CHECK(Serial.Texels == Parallel.Texels);
+}
+
+TEST_CASE(BlendFactorOneSkipsHistory)
+{
+	Inputs In;
+	for (glm::vec4& Texel : In.Prev.Texels)
+		Texel = glm::vec4(100.f, 0.f, 100.f, 1.f);
+
+	for (int32_t FilterType : { kTAAFilterNone, 6 })
+	{
+		DenoiserImage Out;
+		TemporalAACPU(MakeParam(1.f), TAA_RGB_CLAMP, FilterType, In.Current, In.Prev, In.Velocity, Out);
+
+		float MaxError = 0.f;
+		for (uint32_t y = 0; y < kHeight; y++)
+		{
+			for (uint32_t x = 0; x < kWidth; x++)
+			{
+				glm::vec3 Expected = glm::vec3(In.Current.Texels[size_t(y) * kWidth + x]);
+				if (FilterType >= 0)
+				{
+					glm::vec3 Sum(0.f);
+					float WeightSum = 0.f;
+					for (int32_t j = -1; j <= 1; j++)
+						for (int32_t i = -1; i <= 1; i++)
+						{
+							const float Weight = FilterRef(std::sqrt(float(i * i + j * j)), FilterType);
+							Sum += Weight * glm::vec3(In.Current.Load(glm::clamp(int32_t(x) + i, 0, int32_t(kWidth) - 1), glm::clamp(int32_t(y) + j, 0, int32_t(kHeight) - 1)));
+							WeightSum += Weight;
+						}
+					Expected = Sum / WeightSum;
+				}
+				const glm::vec3 Diff = glm::abs(glm::vec3(Out.Texels[size_t(y) * kWidth + x]) - Expected);
+				MaxError = std::max(MaxError, std::max(Diff.x, std::max(Diff.y, Diff.z)));
+			}
+		}
+		CHECK(MaxError <= 1e-3f);
+	}
+}
+
+TEST_CASE(HistoryStaysInsideTheNeighborhood)
+{
+	Inputs In;
+	for (glm::vec4& Texel : In.Prev.Texels)
+		Texel = glm::vec4(100.f, 0.f, 100.f, 1.f);
+
+	DenoiserImage Out;
+	TemporalAACPU(MakeParam(0.1f), TAA_RGB_CLAMP, kTAAFilterNone, In.Current, In.Prev, In.Velocity, Out);
+
+	// the clamped history and the current color are both inside the 3x3 bounds, so is their blend.
+	int NumOutside = 0;
+	for (int32_t y = 0; y < int32_t(kHeight); y++)
+	{
+		for (int32_t x = 0; x < int32_t(kWidth); x++)
+		{
+			glm::vec3 Min(1e30f), Max(-1e30f);
+			for (int32_t j = -1; j <= 1; j++)
+				for (int32_t i = -1; i <= 1; i++)
+				{
+					const glm::vec3 Sample = glm::vec3(In.Current.Load(glm::clamp(x + i, 0, int32_t(kWidth) - 1), glm::clamp(y + j, 0, int32_t(kHeight) - 1)));
+					Min = glm::min(Min, Sample);
+					Max = glm::max(Max, Sample);
+				}
+			const glm::vec3 Value = glm::vec3(Out.Texels[size_t(y) * kWidth + x]);
+			if (glm::any(glm::lessThan(Value, Min - 1e-2f)) || glm::any(glm::greaterThan(Value, Max + 1e-2f)))
+				NumOutside++;
+		}
+	}
+	CHECK_EQ(NumOutside, 0);
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <vector>
+
+// a few macros for the tests of the platform independent modules, no dependency beyond the standard
+// library so it builds with premake on windows and cmake anywhere else. a case registers itself with
+// the file it's in, TestMain runs the cases whose file or name contains its argument.
+struct TestCase
+{
+	const char* Name;
+	const char* File;
+	void (*Func)();
+};
+
+std::vector<TestCase>& GetTestCases();
+
+// failed checks of the running case.
+extern int NumTestFailures;
+
+struct TestRegistrar
+{
+	TestRegistrar(const char* Name, const char* File, void (*Func)()) { GetTestCases().push_back({ Name, File, Func }); }
+};
+
+#define TEST_CASE(Name) \
+	static void Name(); \
+	static TestRegistrar Name##Registrar(#Name, __FILE__, Name); \
+	static void Name()
+
+// benchmarks register the same way, they only live in the CoronaBenchmarks target.
+#define BENCHMARK(Name) TEST_CASE(Name)
+
+#define CHECK(Cond) \
+	do { if (!(Cond)) { NumTestFailures++; std::printf("  %s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #Cond); } } while (0)
+
+#define CHECK_EQ(A, B) \
+	do { if (!((A) == (B))) { NumTestFailures++; std::printf("  %s:%d: CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #A, #B, (long long)(A), (long long)(B)); } } while (0)
+
+#define CHECK_NEAR(A, B, Eps) \
+	do { const double a_ = double(A), b_ = double(B); if (!(std::fabs(a_ - b_) <= double(Eps))) { NumTestFailures++; std::printf("  %s:%d: CHECK_NEAR(%s, %s, %s) failed: %g != %g\n", __FILE__, __LINE__, #A, #B, #Eps, a_, b_); } } while (0)
+
+// the files the tests read from src/, bundled assets and shaders.
+#ifndef CORONA_TEST_DATA_DIR
+#define CORONA_TEST_DATA_DIR "../src"
+#endif
+
+// reference images of the tests.
+#ifndef CORONA_TEST_GOLDEN_DIR
+#define CORONA_TEST_GOLDEN_DIR "../tests/golden"
+#endif
+
+// milliseconds per call of Func, the best of Repeats runs of Iterations calls.
+template<typename F>
+double MeasureMs(F&& Func, int Iterations = 10, int Repeats = 3)
+{
+	double Best = 1e30;
+	for (int r = 0; r < Repeats; r++)
+	{
+		const auto Begin = std::chrono::steady_clock::now();
+		for (int i = 0; i < Iterations; i++)
+			Func();
+		const auto End = std::chrono::steady_clock::now();
+		const double Ms = std::chrono::duration<double, std::milli>(End - Begin).count() / Iterations;
+		Best = Ms < Best ? Ms : Best;
+	}
+	return Best;
+}
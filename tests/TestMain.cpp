@@ -0,0 +1,37 @@
+#include "TestFramework.h"
+
+#include <cstring>
+
+int NumTestFailures = 0;
+
+std::vector<TestCase>& GetTestCases()
+{
+	static std::vector<TestCase> Cases;
+	return Cases;
+}
+
+int main(int argc, char** argv)
+{
+	const char* Filter = argc > 1 ? argv[1] : nullptr;
+
+	int NumRun = 0;
+	int NumFailed = 0;
+	for (const TestCase& Case : GetTestCases())
+	{
+		if (Filter && !std::strstr(Case.File, Filter) && !std::strstr(Case.Name, Filter))
+			continue;
+
+		NumTestFailures = 0;
+		std::printf("%s\n", Case.Name);
+		Case.Func();
+		NumRun++;
+		if (NumTestFailures > 0)
+		{
+			NumFailed++;
+			std::printf("  FAILED\n");
+		}
+	}
+
+	std::printf("%d run, %d failed\n", NumRun, NumFailed);
+	return (NumFailed > 0 || NumRun == 0) ? 1 : 0;
+}
@@ -0,0 +1,488 @@
+#include "TestScenes.h"
+#include "TestFramework.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+
+#include "glm/gtc/matrix_transform.hpp"
+
+#if CORONA_TEST_ZLIB
+#include <zlib.h>
+#endif
+
+namespace
+{
+	// appends triangles, starting a new mesh before the 16 bit indices run out.
+	class MeshBuilder
+	{
+	public:
+		explicit MeshBuilder(std::vector<TestMesh>& InMeshes) : Meshes(InMeshes) {}
+
+		void AddTriangle(const glm::vec3 P[3], const glm::vec3 N[3])
+		{
+			if (Meshes.empty() || Meshes.back().Positions.size() + 3 > 65535)
+				Meshes.emplace_back();
+
+			// aiProcess_MakeLeftHanded mirrors z. the winding is left alone, the normals say which side is front.
+			TestMesh& Mesh = Meshes.back();
+			for (int i = 0; i < 3; i++)
+			{
+				Mesh.Indices.push_back(uint16_t(Mesh.Positions.size()));
+				Mesh.Positions.push_back(glm::vec3(P[i].x, P[i].y, -P[i].z));
+				Mesh.Normals.push_back(glm::vec3(N[i].x, N[i].y, -N[i].z));
+			}
+		}
+
+	private:
+		std::vector<TestMesh>& Meshes;
+	};
+
+	// obj indices are 1 based, negative ones count back from the end.
+	int ResolveOBJIndex(int Index, size_t Count)
+	{
+		return Index < 0 ? int(Count) + Index : Index - 1;
+	}
+
+	struct FBXProperty
+	{
+		char Type = 0;
+		int64_t Int = 0;
+		double Float = 0.0;
+		std::string String;
+		std::vector<double> Floats;
+		std::vector<int64_t> Ints;
+	};
+
+	struct FBXNode
+	{
+		std::string Name;
+		std::vector<FBXProperty> Props;
+		std::vector<FBXNode> Children;
+
+		const FBXNode* Find(const char* ChildName) const
+		{
+			for (const FBXNode& Child : Children)
+				if (Child.Name == ChildName)
+					return &Child;
+			return nullptr;
+		}
+	};
+
+	class FBXReader
+	{
+	public:
+		FBXReader(const std::vector<uint8_t>& InData, uint32_t InVersion) : Data(InData), Version(InVersion) {}
+
+		// false at the null record that ends a node list.
+		bool ReadNode(size_t& Offset, FBXNode& Node)
+		{
+			uint64_t End, NumProps;
+			if (Version >= 7500)
+			{
+				End = Read<uint64_t>(Offset);
+				NumProps = Read<uint64_t>(Offset);
+				Read<uint64_t>(Offset);
+			}
+			else
+			{
+				End = Read<uint32_t>(Offset);
+				NumProps = Read<uint32_t>(Offset);
+				Read<uint32_t>(Offset);
+			}
+			const uint8_t NameLength = Read<uint8_t>(Offset);
+			if (End == 0)
+				return false;
+
+			Node.Name.assign(reinterpret_cast<const char*>(&Data[Offset]), NameLength);
+			Offset += NameLength;
+
+			Node.Props.resize(size_t(NumProps));
+			for (FBXProperty& Prop : Node.Props)
+				ReadProperty(Offset, Prop);
+
+			while (Offset < End)
+			{
+				FBXNode Child;
+				if (!ReadNode(Offset, Child))
+					break;
+				Node.Children.push_back(std::move(Child));
+			}
+			Offset = size_t(End);
+			return true;
+		}
+
+	private:
+		template<typename T>
+		T Read(size_t& Offset)
+		{
+			T Value;
+			if (Offset + sizeof(T) > Data.size())
+				throw std::runtime_error("truncated fbx");
+			std::memcpy(&Value, &Data[Offset], sizeof(T));
+			Offset += sizeof(T);
+			return Value;
+		}
+
+		template<typename T, typename U>
+		void ReadArray(const uint8_t* Src, uint32_t Count, std::vector<U>& Out)
+		{
+			Out.resize(Count);
+			for (uint32_t i = 0; i < Count; i++)
+			{
+				T Value;
+				std::memcpy(&Value, Src + i * sizeof(T), sizeof(T));
+				Out[i] = U(Value);
+			}
+		}
+
+		void ReadProperty(size_t& Offset, FBXProperty& Prop)
+		{
+			Prop.Type = char(Read<uint8_t>(Offset));
+			switch (Prop.Type)
+			{
+			case 'C': Prop.Int = Read<uint8_t>(Offset); break;
+			case 'Y': Prop.Int = Read<int16_t>(Offset); break;
+			case 'I': Prop.Int = Read<int32_t>(Offset); break;
+			case 'L': Prop.Int = Read<int64_t>(Offset); break;
+			case 'F': Prop.Float = Read<float>(Offset); break;
+			case 'D': Prop.Float = Read<double>(Offset); break;
+			case 'S':
+			case 'R':
+			{
+				const uint32_t Length = Read<uint32_t>(Offset);
+				if (Offset + Length > Data.size())
+					throw std::runtime_error("truncated fbx");
+				Prop.String.assign(reinterpret_cast<const char*>(&Data[Offset]), Length);
+				Offset += Length;
+				break;
+			}
+			case 'f':
+			case 'd':
+			case 'i':
+			case 'l':
+			case 'b':
+			{
+				const uint32_t Count = Read<uint32_t>(Offset);
+				const uint32_t Encoding = Read<uint32_t>(Offset);
+				const uint32_t Length = Read<uint32_t>(Offset);
+				if (Offset + Length > Data.size())
+					throw std::runtime_error("truncated fbx");
+
+				const size_t ElementSize = Prop.Type == 'b' ? 1 : (Prop.Type == 'd' || Prop.Type == 'l') ? 8 : 4;
+				std::vector<uint8_t> Raw(&Data[Offset], &Data[Offset] + Length);
+				Offset += Length;
+
+				if (Encoding == 1)
+				{
+#if CORONA_TEST_ZLIB
+					std::vector<uint8_t> Inflated(Count * ElementSize);
+					uLongf InflatedSize = uLongf(Inflated.size());
+					if (uncompress(Inflated.data(), &InflatedSize, Raw.data(), uLong(Raw.size())) != Z_OK || InflatedSize != Inflated.size())
+						throw std::runtime_error("corrupt compressed fbx array");
+					Raw.swap(Inflated);
+#else
+					throw std::runtime_error("compressed fbx arrays need zlib, build with CORONA_TEST_ZLIB");
+#endif
+				}
+				if (Raw.size() < Count * ElementSize)
+					throw std::runtime_error("truncated fbx array");
+
+				switch (Prop.Type)
+				{
+				case 'f': ReadArray<float>(Raw.data(), Count, Prop.Floats); break;
+				case 'd': ReadArray<double>(Raw.data(), Count, Prop.Floats); break;
+				case 'i': ReadArray<int32_t>(Raw.data(), Count, Prop.Ints); break;
+				case 'l': ReadArray<int64_t>(Raw.data(), Count, Prop.Ints); break;
+				case 'b': ReadArray<uint8_t>(Raw.data(), Count, Prop.Ints); break;
+				}
+				break;
+			}
+			default:
+				throw std::runtime_error(std::string("unknown fbx property type ") + Prop.Type);
+			}
+		}
+
+		const std::vector<uint8_t>& Data;
+		uint32_t Version;
+	};
+
+	struct FBXModel
+	{
+		int64_t Parent = 0;
+		glm::vec3 Translation = glm::vec3(0.f);
+		glm::vec3 Rotation = glm::vec3(0.f);
+		glm::vec3 Scaling = glm::vec3(1.f);
+	};
+
+	glm::vec3 GetPropertyVec3(const FBXNode& P)
+	{
+		return glm::vec3(float(P.Props[4].Float), float(P.Props[5].Float), float(P.Props[6].Float));
+	}
+
+	glm::mat4 GetModelTransform(const std::map<int64_t, FBXModel>& Models, int64_t Id)
+	{
+		glm::mat4 Transform = glm::mat4(1.f);
+		for (auto it = Models.find(Id); it != Models.end(); it = Models.find(it->second.Parent))
+		{
+			const FBXModel& Model = it->second;
+			// euler xyz, x applied first.
+			const glm::vec3 R = glm::radians(Model.Rotation);
+			glm::mat4 Local = glm::translate(glm::mat4(1.f), Model.Translation);
+			Local = glm::rotate(Local, R.z, glm::vec3(0, 0, 1));
+			Local = glm::rotate(Local, R.y, glm::vec3(0, 1, 0));
+			Local = glm::rotate(Local, R.x, glm::vec3(1, 0, 0));
+			Local = glm::scale(Local, Model.Scaling);
+			Transform = Local * Transform;
+		}
+		return Transform;
+	}
+
+	void AddFBXGeometry(const FBXNode& Geometry, const glm::mat4& Transform, MeshBuilder& Builder)
+	{
+		const FBXNode* VerticesNode = Geometry.Find("Vertices");
+		const FBXNode* PolygonsNode = Geometry.Find("PolygonVertexIndex");
+		if (!VerticesNode || !PolygonsNode)
+			return;
+
+		const std::vector<double>& Vertices = VerticesNode->Props[0].Floats;
+		const std::vector<int64_t>& Polygons = PolygonsNode->Props[0].Ints;
+
+		const std::vector<double>* Normals = nullptr;
+		const std::vector<int64_t>* NormalIndices = nullptr;
+		bool bNormalsByPolygonVertex = false;
+		if (const FBXNode* Layer = Geometry.Find("LayerElementNormal"))
+		{
+			Normals = &Layer->Find("Normals")->Props[0].Floats;
+			bNormalsByPolygonVertex = Layer->Find("MappingInformationType")->Props[0].String == "ByPolygonVertex";
+			if (Layer->Find("ReferenceInformationType")->Props[0].String == "IndexToDirect")
+				NormalIndices = &Layer->Find("NormalsIndex")->Props[0].Ints;
+		}
+
+		const glm::mat3 NormalTransform = glm::transpose(glm::inverse(glm::mat3(Transform)));
+
+		auto GetVertex = [&](size_t PolygonVertex, glm::vec3& P, glm::vec3& N)
+		{
+			const int64_t Encoded = Polygons[PolygonVertex];
+			const size_t ControlPoint = size_t(Encoded < 0 ? ~Encoded : Encoded);
+			P = glm::vec3(Transform * glm::vec4(Vertices[ControlPoint * 3 + 0], Vertices[ControlPoint * 3 + 1], Vertices[ControlPoint * 3 + 2], 1.0));
+
+			N = glm::vec3(0.f);
+			if (Normals)
+			{
+				size_t Index = bNormalsByPolygonVertex ? PolygonVertex : ControlPoint;
+				if (NormalIndices)
+					Index = size_t((*NormalIndices)[Index]);
+				N = NormalTransform * glm::vec3((*Normals)[Index * 3 + 0], (*Normals)[Index * 3 + 1], (*Normals)[Index * 3 + 2]);
+			}
+		};
+
+		// polygons end at a negative index, triangulated as fans like aiProcess_Triangulate does for convex ones.
+		size_t First = 0;
+		for (size_t i = 0; i < Polygons.size(); i++)
+		{
+			if (Polygons[i] >= 0)
+				continue;
+
+			glm::vec3 P[3], N[3];
+			GetVertex(First, P[0], N[0]);
+			for (size_t k = First + 1; k + 1 <= i; k++)
+			{
+				GetVertex(k, P[1], N[1]);
+				GetVertex(k + 1, P[2], N[2]);
+				Builder.AddTriangle(P, N);
+			}
+			First = i + 1;
+		}
+	}
+}
+
+bool LoadTestOBJ(const std::string& Path, std::vector<TestMesh>& OutMeshes, std::string& OutError)
+{
+	OutMeshes.clear();
+
+	std::ifstream File(Path);
+	if (!File)
+	{
+		OutError = "can't open " + Path;
+		return false;
+	}
+
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	MeshBuilder Builder(OutMeshes);
+
+	std::string Line;
+	while (std::getline(File, Line))
+	{
+		std::istringstream Stream(Line);
+		std::string Keyword;
+		Stream >> Keyword;
+
+		if (Keyword == "v")
+		{
+			glm::vec3 P;
+			Stream >> P.x >> P.y >> P.z;
+			Positions.push_back(P);
+		}
+		else if (Keyword == "vn")
+		{
+			glm::vec3 N;
+			Stream >> N.x >> N.y >> N.z;
+			Normals.push_back(N);
+		}
+		else if (Keyword == "f")
+		{
+			// v, v/vt, v//vn or v/vt/vn.
+			std::vector<glm::vec3> FaceP, FaceN;
+			std::string Vertex;
+			while (Stream >> Vertex)
+			{
+				int V = 0, VT = 0, VN = 0;
+				if (std::sscanf(Vertex.c_str(), "%d/%d/%d", &V, &VT, &VN) != 3 && std::sscanf(Vertex.c_str(), "%d//%d", &V, &VN) != 2)
+					VN = 0;
+
+				const int PositionIndex = ResolveOBJIndex(V, Positions.size());
+				const int NormalIndex = VN != 0 ? ResolveOBJIndex(VN, Normals.size()) : -1;
+				if (PositionIndex < 0 || PositionIndex >= int(Positions.size()) || NormalIndex >= int(Normals.size()))
+				{
+					OutError = Path + ": bad face " + Line;
+					return false;
+				}
+				FaceP.push_back(Positions[PositionIndex]);
+				FaceN.push_back(NormalIndex >= 0 ? Normals[NormalIndex] : glm::vec3(0.f));
+			}
+
+			for (size_t k = 1; k + 1 < FaceP.size(); k++)
+			{
+				const glm::vec3 P[3] = { FaceP[0], FaceP[k], FaceP[k + 1] };
+				const glm::vec3 N[3] = { FaceN[0], FaceN[k], FaceN[k + 1] };
+				Builder.AddTriangle(P, N);
+			}
+		}
+	}
+
+	if (OutMeshes.empty())
+	{
+		OutError = Path + " has no faces";
+		return false;
+	}
+	return true;
+}
+
+bool LoadTestFBX(const std::string& Path, std::vector<TestMesh>& OutMeshes, std::string& OutError)
+{
+	OutMeshes.clear();
+
+	std::ifstream File(Path, std::ios::binary);
+	if (!File)
+	{
+		OutError = "can't open " + Path;
+		return false;
+	}
+	const std::vector<uint8_t> Data((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+
+	static const char kMagic[] = "Kaydara FBX Binary  ";
+	if (Data.size() < 27 || std::memcmp(Data.data(), kMagic, sizeof(kMagic) - 1) != 0)
+	{
+		OutError = Path + " is not a binary fbx";
+		return false;
+	}
+
+	uint32_t Version;
+	std::memcpy(&Version, &Data[23], sizeof(Version));
+
+	std::vector<FBXNode> Root;
+	try
+	{
+		FBXReader Reader(Data, Version);
+		size_t Offset = 27;
+		while (Offset < Data.size())
+		{
+			FBXNode Node;
+			if (!Reader.ReadNode(Offset, Node))
+				break;
+			Root.push_back(std::move(Node));
+		}
+	}
+	catch (const std::exception& e)
+	{
+		OutError = Path + ": " + e.what();
+		return false;
+	}
+
+	const FBXNode* Objects = nullptr;
+	const FBXNode* Connections = nullptr;
+	for (const FBXNode& Node : Root)
+	{
+		Objects = Node.Name == "Objects" ? &Node : Objects;
+		Connections = Node.Name == "Connections" ? &Node : Connections;
+	}
+	if (!Objects || !Connections)
+	{
+		OutError = Path + " has no objects";
+		return false;
+	}
+
+	std::map<int64_t, FBXModel> Models;
+	std::map<int64_t, const FBXNode*> Geometries;
+	for (const FBXNode& Object : Objects->Children)
+	{
+		const int64_t Id = Object.Props[0].Int;
+		if (Object.Name == "Geometry" && Object.Props.size() > 2 && Object.Props[2].String == "Mesh")
+		{
+			Geometries[Id] = &Object;
+		}
+		else if (Object.Name == "Model")
+		{
+			FBXModel& Model = Models[Id];
+			if (const FBXNode* Properties = Object.Find("Properties70"))
+			{
+				for (const FBXNode& P : Properties->Children)
+				{
+					const std::string& Name = P.Props[0].String;
+					if (Name == "Lcl Translation")
+						Model.Translation = GetPropertyVec3(P);
+					else if (Name == "Lcl Rotation")
+						Model.Rotation = GetPropertyVec3(P);
+					else if (Name == "Lcl Scaling")
+						Model.Scaling = GetPropertyVec3(P);
+				}
+			}
+		}
+	}
+
+	// object to object connections, child first. a geometry is instanced by every model it connects to.
+	std::vector<std::pair<int64_t, int64_t>> GeometryModels;
+	for (const FBXNode& C : Connections->Children)
+	{
+		if (C.Props.size() < 3 || C.Props[0].String != "OO")
+			continue;
+
+		const int64_t Child = C.Props[1].Int;
+		const int64_t Parent = C.Props[2].Int;
+		if (Geometries.count(Child) && Models.count(Parent))
+			GeometryModels.push_back({ Child, Parent });
+		else if (Models.count(Child) && Models.count(Parent))
+			Models[Child].Parent = Parent;
+	}
+
+	MeshBuilder Builder(OutMeshes);
+	for (const auto& GeometryModel : GeometryModels)
+		AddFBXGeometry(*Geometries[GeometryModel.first], GetModelTransform(Models, GeometryModel.second), Builder);
+
+	if (OutMeshes.empty())
+	{
+		OutError = Path + " has no meshes";
+		return false;
+	}
+	return true;
+}
+
+std::string GetTestAssetPath(const char* Path)
+{
+	return std::string(CORONA_TEST_DATA_DIR) + "/assets/" + Path;
+}
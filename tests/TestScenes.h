@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+// the bundled scenes for the tests. the renderer loads them with assimp, which only ships as a windows
+// library here, so this reads the two formats of src/assets directly: wavefront obj and binary fbx.
+// like the renderer's import the node transforms are applied and z is flipped to left handed.
+// triangles are not shared, every mesh holds at most 65535 vertices for 16 bit indices.
+struct TestMesh
+{
+	std::vector<glm::vec3> Positions;
+	std::vector<glm::vec3> Normals;
+	std::vector<uint16_t> Indices;
+};
+
+bool LoadTestOBJ(const std::string& Path, std::vector<TestMesh>& OutMeshes, std::string& OutError);
+
+// compressed fbx arrays need zlib, without CORONA_TEST_ZLIB this fails with a message.
+bool LoadTestFBX(const std::string& Path, std::vector<TestMesh>& OutMeshes, std::string& OutError);
+
+// path of a file in src/assets.
+std::string GetTestAssetPath(const char* Path);
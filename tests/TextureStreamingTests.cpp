@@ -0,0 +1,236 @@
+#include "TestFramework.h"
+#include "TextureStreaming.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+// the streamer against a simulated scene. textures sit along a corridor, a recorded camera path flies
+// through it and every frame reports the mip a texture's distance asks for, like the gbuffer feedback.
+// the simulation keeps its own resident mips from the apply and trim callbacks.
+namespace
+{
+	const uint32_t TextureDim = 1024;
+	const uint32_t NumTextures = 48;
+	const float TextureSpacing = 10.f;
+	const float ViewDistance = 60.f;
+
+	struct SimTexture
+	{
+		uint32_t ResidentMip = 0;
+		std::atomic<int> NumFailedLoads{ 0 };
+		std::atomic<int> NumLoads{ 0 };
+		std::atomic<uint32_t> LastRequestedMip{ 0 };
+	};
+
+	struct SimScene
+	{
+		TextureStreamer Streamer;
+		std::vector<uint64_t> MipBytes;
+		SimTexture Textures[NumTextures];
+		TextureStreamer::TextureID IDs[NumTextures];
+		uint64_t Frame = 0;
+
+		SimScene(uint64_t Budget, int FailingTailLoads = 0)
+		{
+			for (uint32_t Dim = TextureDim; ; Dim >>= 1)
+			{
+				MipBytes.push_back(uint64_t(Dim) * Dim * 4);
+				if (Dim == 1)
+					break;
+			}
+
+			for (SimTexture& T : Textures)
+			{
+				T.ResidentMip = uint32_t(MipBytes.size());
+				T.NumFailedLoads = FailingTailLoads;
+			}
+
+			Streamer.BudgetBytes = Budget;
+			Streamer.Init(
+				[this](const TextureStreamer::Request& Req) -> std::shared_ptr<void>
+				{
+					SimTexture& T = Textures[size_t(Req.UserData)];
+					T.NumLoads++;
+					T.LastRequestedMip = Req.FirstMip;
+					if (T.NumFailedLoads > 0)
+					{
+						T.NumFailedLoads--;
+						return nullptr;
+					}
+					return std::make_shared<uint32_t>(Req.FirstMip);
+				},
+				[this](const TextureStreamer::Request& Req, std::shared_ptr<void> Data)
+				{
+					if (*static_cast<uint32_t*>(Data.get()) != Req.FirstMip)
+						return false;
+					Textures[size_t(Req.UserData)].ResidentMip = Req.FirstMip;
+					return true;
+				},
+				[this](const TextureStreamer::Request& Req)
+				{
+					Textures[size_t(Req.UserData)].ResidentMip = Req.FirstMip;
+					return true;
+				});
+
+			for (uint32_t i = 0; i < NumTextures; i++)
+				IDs[i] = Streamer.Register(TextureDim, TextureDim, MipBytes, (void*)size_t(i));
+		}
+
+		uint64_t TailBytes() const
+		{
+			const uint32_t TailMip = uint32_t(std::log2(TextureDim / Streamer.MipTailDim));
+			uint64_t Bytes = 0;
+			for (size_t i = TailMip; i < MipBytes.size(); i++)
+				Bytes += MipBytes[i];
+			return Bytes;
+		}
+
+		uint64_t SimResidentBytes() const
+		{
+			uint64_t Bytes = 0;
+			for (const SimTexture& T : Textures)
+				for (size_t i = T.ResidentMip; i < MipBytes.size(); i++)
+					Bytes += MipBytes[i];
+			return Bytes;
+		}
+
+		static float DesiredMip(float Distance)
+		{
+			return std::max(std::log2(Distance / 4.f), 0.f);
+		}
+
+		// one frame at CameraX. the io thread gets a moment to run, like the rest of a real frame.
+		void Step(float CameraX)
+		{
+			Frame++;
+			for (uint32_t i = 0; i < NumTextures; i++)
+			{
+				const float Distance = std::fabs(i * TextureSpacing - CameraX);
+				if (Distance < ViewDistance)
+					Streamer.ReportMipUsage(IDs[i], DesiredMip(Distance), Frame);
+			}
+			Streamer.Update(Frame);
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+
+		// steps until Done or the frame limit.
+		template<typename F>
+		bool StepUntil(float CameraX, F Done, int MaxFrames = 5000)
+		{
+			for (int i = 0; i < MaxFrames; i++)
+			{
+				Step(CameraX);
+				if (Done())
+					return true;
+			}
+			return false;
+		}
+
+		bool AllTailsResident() const
+		{
+			for (uint32_t i = 0; i < NumTextures; i++)
+				if (Streamer.GetResidentMip(IDs[i]) > Streamer.GetNumMips(IDs[i]) - 1)
+					return false;
+			return true;
+		}
+	};
+
+	// the camera path recorded from a fly through, x along the corridor. played back at one key per 40 frames.
+	const float CameraPath[] = { 0.f, 20.f, 60.f, 95.f, 140.f, 150.f, 210.f, 280.f, 300.f, 390.f, 470.f, 470.f, 300.f, 120.f };
+	const int FramesPerKey = 40;
+}
+
+TEST_CASE(MipTailLoadsFirst)
+{
+	SimScene Scene(64ull << 20);
+	const uint32_t TailMip = uint32_t(std::log2(TextureDim / Scene.Streamer.MipTailDim));
+
+	CHECK(Scene.StepUntil(-1000.f, [&]() { return Scene.Streamer.GetStats().NumPendingRequests == 0; }));
+
+	for (uint32_t i = 0; i < NumTextures; i++)
+	{
+		CHECK_EQ(Scene.Streamer.GetResidentMip(Scene.IDs[i]), TailMip);
+		CHECK_EQ(Scene.Textures[i].ResidentMip, TailMip);
+		CHECK_EQ(Scene.Textures[i].LastRequestedMip.load(), TailMip);
+		CHECK_EQ(Scene.Textures[i].NumLoads.load(), 1);
+	}
+	CHECK_EQ(Scene.Streamer.GetStats().ResidentBytes, Scene.TailBytes() * NumTextures);
+}
+
+TEST_CASE(CameraPathStaysInBudget)
+{
+	const uint64_t Budget = 48ull << 20;
+	SimScene Scene(Budget);
+	CHECK(Budget >= Scene.TailBytes() * NumTextures);
+
+	int NumOverBudget = 0;
+	int NumMismatches = 0;
+	uint32_t NumLoaded = 0;
+	uint32_t NumTrimmed = 0;
+	for (size_t Key = 0; Key + 1 < std::size(CameraPath); Key++)
+	{
+		for (int f = 0; f < FramesPerKey; f++)
+		{
+			const float t = float(f) / FramesPerKey;
+			Scene.Step(CameraPath[Key] * (1.f - t) + CameraPath[Key + 1] * t);
+
+			const TextureStreamer::Stats& Stats = Scene.Streamer.GetStats();
+			if (Stats.ResidentBytes + Stats.PendingBytes > Budget)
+				NumOverBudget++;
+			if (Stats.ResidentBytes != Scene.SimResidentBytes())
+				NumMismatches++;
+			NumLoaded += Stats.NumLoadedThisFrame;
+			NumTrimmed += Stats.NumTrimmedThisFrame;
+		}
+	}
+
+	CHECK_EQ(NumOverBudget, 0);
+	CHECK_EQ(NumMismatches, 0);
+	CHECK(NumLoaded > NumTextures);
+	// the path covers more than the budget holds, what was left behind made room.
+	CHECK(NumTrimmed > 0);
+
+	// parked at the end of the path, what's in view converges to the mips it asks for.
+	const float CameraX = CameraPath[std::size(CameraPath) - 1];
+	auto Converged = [&]()
+	{
+		for (uint32_t i = 0; i < NumTextures; i++)
+		{
+			const float Distance = std::fabs(i * TextureSpacing - CameraX);
+			if (Distance < ViewDistance && Scene.Streamer.GetResidentMip(Scene.IDs[i]) > uint32_t(SimScene::DesiredMip(Distance)))
+				return false;
+		}
+		return true;
+	};
+	CHECK(Scene.StepUntil(CameraX, Converged));
+	CHECK(Scene.Streamer.GetStats().ResidentBytes <= Budget);
+}
+
+TEST_CASE(UnusedTexturesFallBackToTail)
+{
+	// room for what one spot in the corridor asks for, not two.
+	const uint64_t Budget = 10ull << 20;
+	SimScene Scene(Budget);
+	const uint32_t TailMip = uint32_t(std::log2(TextureDim / Scene.Streamer.MipTailDim));
+
+	// right in front of texture 0, then far away in front of texture 40.
+	CHECK(Scene.StepUntil(0.f, [&]() { return Scene.Streamer.GetResidentMip(Scene.IDs[0]) == 0; }));
+	CHECK(Scene.StepUntil(400.f, [&]() { return Scene.Streamer.GetResidentMip(Scene.IDs[40]) == 0; }));
+
+	CHECK_EQ(Scene.Streamer.GetResidentMip(Scene.IDs[0]), TailMip);
+	CHECK_EQ(Scene.Textures[0].ResidentMip, TailMip);
+	CHECK(Scene.Streamer.GetStats().ResidentBytes <= Budget);
+}
+
+TEST_CASE(FailedTailIsRequestedAgain)
+{
+	SimScene Scene(64ull << 20, 2);
+	Scene.Streamer.TailRetryFrames = 5;
+
+	CHECK(Scene.StepUntil(-1000.f, [&]() { return Scene.AllTailsResident(); }, 1000));
+	for (uint32_t i = 0; i < NumTextures; i++)
+		CHECK_EQ(Scene.Textures[i].NumLoads.load(), 3);
+	CHECK_EQ(Scene.Streamer.GetStats().ResidentBytes, Scene.SimResidentBytes());
+}